@@ -282,6 +282,14 @@ const mico_logic_partition_t mico_partitions[] =
     .partition_length          = 0x90000, //576k bytes
     .partition_options         = PAR_OPT_READ_EN | PAR_OPT_WRITE_EN,
   },
+  [MICO_PARTITION_SYSTEM_SNAPSHOT] =
+  {
+    .partition_owner           = MICO_FLASH_SPI,
+    .partition_description     = "SNAPSHOT",
+    .partition_start_addr      = 0x000E8000,
+    .partition_length          = 0x1000, //4k bytes
+    .partition_options         = PAR_OPT_READ_EN | PAR_OPT_WRITE_EN,
+  },
 };
 
 
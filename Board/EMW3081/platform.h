@@ -143,6 +143,11 @@ typedef enum
   MICO_PARTITION_USER_MAX
 } mico_user_partition_t;
 
+/* Hang snapshot written by the system monitor before the watchdog reset, the
+   partition ID follows every existing one so their numbering is unchanged */
+#define MICO_USE_SYSTEM_SNAPSHOT_PARTITION
+#define MICO_SYSTEM_MONITOR_SNAPSHOT_PARTITION  MICO_PARTITION_SYSTEM_SNAPSHOT
+
 
 #ifdef BOOTLOADER
 #define STDIO_UART          MICO_UART_1
@@ -21,6 +21,30 @@ typedef struct
     
 }AC_OptList;
 
+#define AC_OPT_INDEX_NUM    (ZC_OPT_SSESSION + 1)
+
+/*Writes one message in place: head, options, then payload, crc as it goes*/
+typedef struct 
+{
+    u8 *pu8Frame;           /*starts with ZC_MessageHead*/
+    u16 u16MaxLen;          /*frame buffer size*/
+    u16 u16Len;             /*bytes written, head included*/
+    u16 u16CrcLen;          /*bytes already folded into u16Crc*/
+    u16 u16Crc;
+    u8 u8Payload;           /*payload started, no more options*/
+    u8 u8Error;             /*frame buffer overflow or option after payload*/
+}AC_MsgBuilder;
+
+/*One pass view of a received message, points into the message itself*/
+typedef struct 
+{
+    u8 *pu8Opt[AC_OPT_INDEX_NUM];       /*option body by code, NULL if absent*/
+    u16 u16OptLen[AC_OPT_INDEX_NUM];
+    u16 u16OptTotalLen;                 /*all option heads and bodies*/
+    u8 *pu8Payload;
+    u16 u16PayloadLen;
+}AC_OptIndex;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,6 +67,12 @@ void AC_RecvMessage(ZC_MessageHead *pstruMsg);
 void AC_ParseOption(ZC_MessageHead *pstruMsg, AC_OptList *pstruOptList, u16 *pu16OptLen);
 void AC_SendDeviceRegsiterWithMac(u8 *pu8EqVersion, u8 *pu8ModuleKey, u8 *pu8Domain);
 void AC_SendDeviceStart(void);
+void AC_MsgInit(AC_MsgBuilder *pstruBuilder, u8 u8MsgCode, u8 u8MsgId, u8 *pu8Frame, u16 u16MaxLen);
+u32 AC_MsgAddOption(AC_MsgBuilder *pstruBuilder, u16 u16OptCode, u8 *pu8Opt, u16 u16OptLen);
+u32 AC_MsgAppend(AC_MsgBuilder *pstruBuilder, u8 *pu8Data, u16 u16DataLen);
+u8 *AC_MsgReserve(AC_MsgBuilder *pstruBuilder, u16 u16DataLen);
+u16 AC_MsgEnd(AC_MsgBuilder *pstruBuilder);
+u32 AC_IndexMessage(ZC_MessageHead *pstruMsg, AC_OptIndex *pstruIndex);
 u32 AC_CheckSum(u8 * Buffer,u32 len); 
 u8 AC_CalcSum(u8 *pu8Src, u8 u8Len);
 #ifdef __cplusplus
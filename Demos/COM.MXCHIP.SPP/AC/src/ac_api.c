@@ -13,6 +13,25 @@
 #include <zc_protocol_controller.h>
 #include <ac_hal.h>
 #include <zc_module_interface.h>
+/*************************************************
+* Function: AC_WriteOption
+* Description: option head in network order, then the body
+* Author: cxy 
+* Returns: bytes written
+* Parameter: 
+* History:
+*************************************************/
+static u16 AC_WriteOption(u8 *pu8Dst, u16 u16OptCode, u8 *pu8Opt, u16 u16OptLen)
+{
+    pu8Dst[0] = (u8)(u16OptCode >> 8);
+    pu8Dst[1] = (u8)u16OptCode;
+    pu8Dst[2] = (u8)(u16OptLen >> 8);
+    pu8Dst[3] = (u8)u16OptLen;
+    memcpy(pu8Dst + sizeof(ZC_MessageOptHead), pu8Opt, u16OptLen);
+
+    return (u16)sizeof(ZC_MessageOptHead) + u16OptLen;
+}
+
 /*************************************************
 * Function: AC_BuildOption
 * Description: 
@@ -24,50 +43,207 @@
 void AC_BuildOption(AC_OptList *pstruOptList, u8 *pu8OptNum, u8 *pu8Buffer, u16 *pu16Len)
 {
     //ѡֶ
-    ZC_MessageOptHead *pstruOpt;
     u8 u8OptNum = 0;
-    u8 u16OptLen = 0;
+    u16 u16OptLen = 0;
+    
+    if (NULL != pstruOptList)
+    {
+        /*add opt, if it exist*/
+        if (NULL != pstruOptList->pstruTransportInfo)
+        {
+            u16OptLen += AC_WriteOption(pu8Buffer + u16OptLen, ZC_OPT_TRANSPORT, 
+                (u8 *)pstruOptList->pstruTransportInfo, sizeof(ZC_TransportInfo));
+            u8OptNum++;
+        }
+
+        if (NULL != pstruOptList->pstruSsession)
+        {
+            u16OptLen += AC_WriteOption(pu8Buffer + u16OptLen, ZC_OPT_SSESSION, 
+                (u8 *)pstruOptList->pstruSsession, sizeof(ZC_SsessionInfo));
+            u8OptNum++;
+        }
+    }
     
     *pu16Len = u16OptLen;
     *pu8OptNum = u8OptNum;
-    
-    
-    if (NULL == pstruOptList)
+    return;
+}
+
+/*************************************************
+* Function: AC_MsgInit
+* Description: start a message in pu8Frame, head now, options and payload 
+              appended in place, crc and length filled by AC_MsgEnd
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+void AC_MsgInit(AC_MsgBuilder *pstruBuilder, u8 u8MsgCode, u8 u8MsgId, u8 *pu8Frame, u16 u16MaxLen)
+{
+    ZC_MessageHead *pstruMsg = (ZC_MessageHead *)pu8Frame;
+
+    pstruBuilder->pu8Frame = pu8Frame;
+    pstruBuilder->u16MaxLen = u16MaxLen;
+    pstruBuilder->u16Len = sizeof(ZC_MessageHead);
+    pstruBuilder->u16CrcLen = sizeof(ZC_MessageHead);
+    pstruBuilder->u16Crc = 0;
+    pstruBuilder->u8Payload = 0;
+    pstruBuilder->u8Error = 0;
+
+    if (u16MaxLen < sizeof(ZC_MessageHead))
     {
+        pstruBuilder->u8Error = 1;
         return;
     }
-    
-    pstruOpt = (ZC_MessageOptHead *)pu8Buffer;
 
-    /*add opt, if it exist*/
-    if (NULL != pstruOptList->pstruTransportInfo)
+    pstruMsg->Version = 0;
+    pstruMsg->MsgId = u8MsgId;
+    pstruMsg->MsgCode = u8MsgCode;
+    pstruMsg->OptNum = 0;
+}
+
+/*************************************************
+* Function: AC_MsgCheckRoom
+* Description: fold bytes written through AC_MsgReserve into the crc, and
+              check u32Len more bytes fit
+* Author: cxy 
+* Returns: ZC_RET_OK/ZC_RET_ERROR
+* Parameter: 
+* History:
+*************************************************/
+static u32 AC_MsgCheckRoom(AC_MsgBuilder *pstruBuilder, u32 u32Len)
+{
+    if (pstruBuilder->u8Error)
+    {
+        return ZC_RET_ERROR;
+    }
+
+    if (pstruBuilder->u16CrcLen < pstruBuilder->u16Len)
     {
-        pstruOpt->OptCode = ZC_HTONS(ZC_OPT_TRANSPORT);
-        pstruOpt->OptLen = ZC_HTONS(sizeof(ZC_TransportInfo));
-        memcpy((u8*)(pstruOpt + 1), (u8*)pstruOptList->pstruTransportInfo, sizeof(ZC_TransportInfo));
+        pstruBuilder->u16Crc = crc16_ccitt_update(pstruBuilder->u16Crc, 
+            pstruBuilder->pu8Frame + pstruBuilder->u16CrcLen, 
+            pstruBuilder->u16Len - pstruBuilder->u16CrcLen);
+        pstruBuilder->u16CrcLen = pstruBuilder->u16Len;
+    }
 
-        u8OptNum++;
-        u16OptLen += sizeof(ZC_MessageOptHead) + sizeof(ZC_TransportInfo);
-        pstruOpt = (ZC_MessageOptHead *)(pu8Buffer + u16OptLen);        
+    if ((u32)pstruBuilder->u16Len + u32Len > pstruBuilder->u16MaxLen)
+    {
+        pstruBuilder->u8Error = 1;
+        return ZC_RET_ERROR;
     }
-    
 
-    if (NULL != pstruOptList->pstruSsession)
+    return ZC_RET_OK;
+}
+
+/*************************************************
+* Function: AC_MsgAddOption
+* Description: append one option, all options go before the payload
+* Author: cxy 
+* Returns: ZC_RET_OK/ZC_RET_ERROR
+* Parameter: 
+* History:
+*************************************************/
+u32 AC_MsgAddOption(AC_MsgBuilder *pstruBuilder, u16 u16OptCode, u8 *pu8Opt, u16 u16OptLen)
+{
+    u8 *pu8Dst;
+
+    if (pstruBuilder->u8Payload)
     {
-        pstruOpt = (ZC_MessageOptHead *)pu8Buffer;
-        pstruOpt->OptCode = ZC_HTONS(ZC_OPT_SSESSION);
-        pstruOpt->OptLen = ZC_HTONS(sizeof(ZC_SsessionInfo));
-        memcpy((u8*)(pstruOpt + 1), (u8*)pstruOptList->pstruSsession, sizeof(ZC_SsessionInfo));
+        pstruBuilder->u8Error = 1;
+    }
 
-        u8OptNum++;
-        u16OptLen += sizeof(ZC_MessageOptHead) + sizeof(ZC_SsessionInfo);
-        pstruOpt = (ZC_MessageOptHead *)(pu8Buffer + u16OptLen);        
-    }    
+    if (ZC_RET_OK != AC_MsgCheckRoom(pstruBuilder, sizeof(ZC_MessageOptHead) + (u32)u16OptLen))
+    {
+        return ZC_RET_ERROR;
+    }
 
-    
-    *pu16Len = u16OptLen;
-    *pu8OptNum = u8OptNum;
-    return;
+    pu8Dst = pstruBuilder->pu8Frame + pstruBuilder->u16Len;
+    pu8Dst[0] = (u8)(u16OptCode >> 8);
+    pu8Dst[1] = (u8)u16OptCode;
+    pu8Dst[2] = (u8)(u16OptLen >> 8);
+    pu8Dst[3] = (u8)u16OptLen;
+    pstruBuilder->u16Crc = crc16_ccitt_update(pstruBuilder->u16Crc, pu8Dst, sizeof(ZC_MessageOptHead));
+    pstruBuilder->u16Crc = crc16_ccitt_copy(pstruBuilder->u16Crc, 
+        pu8Dst + sizeof(ZC_MessageOptHead), pu8Opt, u16OptLen);
+
+    pstruBuilder->u16Len += sizeof(ZC_MessageOptHead) + u16OptLen;
+    pstruBuilder->u16CrcLen = pstruBuilder->u16Len;
+    ((ZC_MessageHead *)pstruBuilder->pu8Frame)->OptNum++;
+
+    return ZC_RET_OK;
+}
+
+/*************************************************
+* Function: AC_MsgAppend
+* Description: copy payload bytes into the frame, crc in the same pass
+* Author: cxy 
+* Returns: ZC_RET_OK/ZC_RET_ERROR
+* Parameter: 
+* History:
+*************************************************/
+u32 AC_MsgAppend(AC_MsgBuilder *pstruBuilder, u8 *pu8Data, u16 u16DataLen)
+{
+    pstruBuilder->u8Payload = 1;
+    if (ZC_RET_OK != AC_MsgCheckRoom(pstruBuilder, u16DataLen))
+    {
+        return ZC_RET_ERROR;
+    }
+
+    pstruBuilder->u16Crc = crc16_ccitt_copy(pstruBuilder->u16Crc, 
+        pstruBuilder->pu8Frame + pstruBuilder->u16Len, pu8Data, u16DataLen);
+    pstruBuilder->u16Len += u16DataLen;
+    pstruBuilder->u16CrcLen = pstruBuilder->u16Len;
+
+    return ZC_RET_OK;
+}
+
+/*************************************************
+* Function: AC_MsgReserve
+* Description: hand out u16DataLen payload bytes of the frame for the caller
+              to fill, they are added to the crc on the next append or end
+* Author: cxy 
+* Returns: write pointer, NULL if it does not fit
+* Parameter: 
+* History:
+*************************************************/
+u8 *AC_MsgReserve(AC_MsgBuilder *pstruBuilder, u16 u16DataLen)
+{
+    u8 *pu8Dst;
+
+    pstruBuilder->u8Payload = 1;
+    if (ZC_RET_OK != AC_MsgCheckRoom(pstruBuilder, u16DataLen))
+    {
+        return NULL;
+    }
+
+    pu8Dst = pstruBuilder->pu8Frame + pstruBuilder->u16Len;
+    pstruBuilder->u16Len += u16DataLen;
+
+    return pu8Dst;
+}
+
+/*************************************************
+* Function: AC_MsgEnd
+* Description: fill payload length and crc in the head
+* Author: cxy 
+* Returns: message length, 0 if the frame overflowed
+* Parameter: 
+* History:
+*************************************************/
+u16 AC_MsgEnd(AC_MsgBuilder *pstruBuilder)
+{
+    ZC_MessageHead *pstruMsg = (ZC_MessageHead *)pstruBuilder->pu8Frame;
+
+    if (ZC_RET_OK != AC_MsgCheckRoom(pstruBuilder, 0))
+    {
+        return 0;
+    }
+
+    pstruMsg->Payloadlen = ZC_HTONS(pstruBuilder->u16Len - sizeof(ZC_MessageHead));
+    pstruMsg->TotalMsgCrc[0] = (pstruBuilder->u16Crc & 0xff00) >> 8;
+    pstruMsg->TotalMsgCrc[1] = (pstruBuilder->u16Crc & 0xff);
+
+    return pstruBuilder->u16Len;
 }
 
 /*************************************************
@@ -84,29 +260,28 @@ void AC_BuildMessage(u8 u8MsgCode, u8 u8MsgId,
     u8 *pu8Msg, u16 *pu16Len)
 {
     //Э
-    ZC_MessageHead *pstruMsg = NULL;
-    u16 u16OptLen = 0;
-    u16 crc = 0;
-    
-    pstruMsg = (ZC_MessageHead *)pu8Msg;
-    pstruMsg->MsgCode = u8MsgCode;
-    pstruMsg->MsgId = u8MsgId;  
-
-    pstruMsg->Version = 0;
-
-    AC_BuildOption(pstruOptList, &pstruMsg->OptNum, (pu8Msg + sizeof(ZC_MessageHead)), &u16OptLen);
-    memcpy((pu8Msg + sizeof(ZC_MessageHead) + u16OptLen), pu8Payload, u16PayloadLen);
+    AC_MsgBuilder struBuilder;
 
-    /*updata len*/
-    pstruMsg->Payloadlen = ZC_HTONS(u16PayloadLen + u16OptLen);
+    /*caller buffer size is not passed in, frames built by hand bound it*/
+    AC_MsgInit(&struBuilder, u8MsgCode, u8MsgId, pu8Msg, 0xffff);
 
-    /*calc crc*/
-    crc = crc16_ccitt((pu8Msg + sizeof(ZC_MessageHead)), (u16PayloadLen + u16OptLen));
-    pstruMsg->TotalMsgCrc[0]=(crc&0xff00)>>8;
-    pstruMsg->TotalMsgCrc[1]=(crc&0xff);
+    if (NULL != pstruOptList)
+    {
+        if (NULL != pstruOptList->pstruTransportInfo)
+        {
+            AC_MsgAddOption(&struBuilder, ZC_OPT_TRANSPORT, 
+                (u8 *)pstruOptList->pstruTransportInfo, sizeof(ZC_TransportInfo));
+        }
+        if (NULL != pstruOptList->pstruSsession)
+        {
+            AC_MsgAddOption(&struBuilder, ZC_OPT_SSESSION, 
+                (u8 *)pstruOptList->pstruSsession, sizeof(ZC_SsessionInfo));
+        }
+    }
 
+    AC_MsgAppend(&struBuilder, pu8Payload, u16PayloadLen);
 
-    *pu16Len = (u16)sizeof(ZC_MessageHead) + u16PayloadLen + u16OptLen;
+    *pu16Len = AC_MsgEnd(&struBuilder);
 }
 
 /*************************************************
@@ -122,34 +297,40 @@ void AC_BuildEasyMessage(u8 u8MsgCode, u8 u8MsgId,
                          AC_OptList *pstruOptList,
                          u8 *pu8Msg, u16 *pu16Len)
 {
-    if(NULL!=pstruOptList->pstruSsession) 
+    u8 *pu8Dst = pu8Msg + 6;
+    u8 u8Sum;
+    u16 u16i;
+
+    /*pu8Msg may be the received message itself, every copy runs front to back*/
+    *pu16Len = 0x8+u16PayloadLen;
+    if (NULL != pstruOptList->pstruSsession)
+    {
+        *pu16Len += sizeof(ZC_SsessionInfo);
+    }
+    pu8Msg[0] = 0x5a;
+    pu8Msg[1] = 0;
+    pu8Msg[2] = *pu16Len;
+    pu8Msg[3] = u8MsgId;   
+    pu8Msg[4] = (NULL != pstruOptList->pstruSsession) ? 0x01 : 0x00;  
+    pu8Msg[5] = u8MsgCode;
+    u8Sum = AC_CalcSum(pu8Msg + 1, 5);
+
+    if (NULL != pstruOptList->pstruSsession)
     {
-        *pu16Len = 0xc+u16PayloadLen;
-        pu8Msg[0] = 0x5a;
-        pu8Msg[1] = 0;
-        pu8Msg[2] = *pu16Len;
-        pu8Msg[3] = u8MsgId;   
-        pu8Msg[4] = 0x01;  
-        pu8Msg[5] = u8MsgCode;
-        memcpy(pu8Msg + 6,pstruOptList->pstruSsession,4); 
-        memcpy(pu8Msg+10,pu8Payload,u16PayloadLen);
-        pu8Msg[*pu16Len -2]=AC_CalcSum(pu8Msg+1,*pu16Len-3);
-        pu8Msg[*pu16Len -1]=0x5b;
-        
+        for (u16i = 0; u16i < sizeof(ZC_SsessionInfo); u16i++)
+        {
+            *pu8Dst = ((u8 *)pstruOptList->pstruSsession)[u16i];
+            u8Sum += *pu8Dst++;
+        }
     }
-    else
+    for (u16i = 0; u16i < u16PayloadLen; u16i++)
     {
-        *pu16Len = 0x8+u16PayloadLen;
-        pu8Msg[0] = 0x5a;
-        pu8Msg[1] = 0;
-        pu8Msg[2] = *pu16Len;
-        pu8Msg[3] = u8MsgId;   
-        pu8Msg[4] = 0x00;  
-        pu8Msg[5] = u8MsgCode;
-        memcpy(pu8Msg+6,pu8Payload,u16PayloadLen);
-        pu8Msg[*pu16Len -2]=AC_CalcSum(pu8Msg+1,*pu16Len-3);
-        pu8Msg[*pu16Len -1]=0x5b;
+        *pu8Dst = pu8Payload[u16i];
+        u8Sum += *pu8Dst++;
     }
+
+    pu8Dst[0] = u8Sum;
+    pu8Dst[1] = 0x5b;
 }
 
 /*************************************************
@@ -231,39 +412,96 @@ void AC_SendUbindMsg()
 }
 
 /*************************************************
-* Function: AC_ParseOption
-* Description: 
+* Function: AC_IndexMessage
+* Description: walk the options once, bounded by Payloadlen, and record
+              where each option body and the payload are
 * Author: cxy 
-* Returns: 
+* Returns: ZC_RET_OK/ZC_RET_ERROR if an option runs past the message
 * Parameter: 
 * History:
 *************************************************/
-void AC_ParseOption(ZC_MessageHead *pstruMsg, AC_OptList *pstruOptList, u16 *pu16OptLen)
+u32 AC_IndexMessage(ZC_MessageHead *pstruMsg, AC_OptIndex *pstruIndex)
 {
-    //Option
+    u8 *pu8Opt = (u8 *)(pstruMsg + 1);
+    u16 u16Left = ZC_HTONS(pstruMsg->Payloadlen);
+    u16 u16OptCode;
+    u16 u16OptLen;
     u8 u8OptNum;
-    ZC_MessageOptHead *pstruOptHead;
-    u16 u16Offset;
 
-    u16Offset = sizeof(ZC_MessageHead);
-    pstruOptHead = (ZC_MessageOptHead *)((u8*)pstruMsg + u16Offset);
-    *pu16OptLen = 0;
+    memset(pstruIndex, 0, sizeof(AC_OptIndex));
 
     for (u8OptNum = 0; u8OptNum < pstruMsg->OptNum; u8OptNum++)
     {
-        switch (ZC_HTONS(pstruOptHead->OptCode))
+        if (u16Left < sizeof(ZC_MessageOptHead))
+        {
+            return ZC_RET_ERROR;
+        }
+        u16OptCode = ((u16)pu8Opt[0] << 8) | pu8Opt[1];
+        u16OptLen = ((u16)pu8Opt[2] << 8) | pu8Opt[3];
+        u16Left -= sizeof(ZC_MessageOptHead);
+        if (u16Left < u16OptLen)
+        {
+            return ZC_RET_ERROR;
+        }
+
+        /*unknown options are skipped, a repeated one keeps the last*/
+        if (u16OptCode < AC_OPT_INDEX_NUM)
         {
-            case ZC_OPT_TRANSPORT:
-                pstruOptList->pstruTransportInfo = (ZC_TransportInfo *)(pstruOptHead + 1);
-                break;
-            case ZC_OPT_SSESSION:
-                pstruOptList->pstruSsession = (ZC_SsessionInfo *)(pstruOptHead + 1);            
-                break;
+            pstruIndex->pu8Opt[u16OptCode] = pu8Opt + sizeof(ZC_MessageOptHead);
+            pstruIndex->u16OptLen[u16OptCode] = u16OptLen;
         }
-        *pu16OptLen += sizeof(ZC_MessageOptHead) + ZC_HTONS(pstruOptHead->OptLen);
-        pstruOptHead = (ZC_MessageOptHead *)((u8*)pstruOptHead + sizeof(ZC_MessageOptHead) + ZC_HTONS(pstruOptHead->OptLen));
+        pu8Opt += sizeof(ZC_MessageOptHead) + u16OptLen;
+        u16Left -= u16OptLen;
+    }
+
+    pstruIndex->u16OptTotalLen = ZC_HTONS(pstruMsg->Payloadlen) - u16Left;
+    pstruIndex->pu8Payload = pu8Opt;
+    pstruIndex->u16PayloadLen = u16Left;
+
+    return ZC_RET_OK;
+}
+
+/*************************************************
+* Function: AC_IndexToOptList
+* Description: 
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+static void AC_IndexToOptList(AC_OptIndex *pstruIndex, AC_OptList *pstruOptList)
+{
+    if (NULL != pstruIndex->pu8Opt[ZC_OPT_TRANSPORT])
+    {
+        pstruOptList->pstruTransportInfo = (ZC_TransportInfo *)pstruIndex->pu8Opt[ZC_OPT_TRANSPORT];
+    }
+    if (NULL != pstruIndex->pu8Opt[ZC_OPT_SSESSION])
+    {
+        pstruOptList->pstruSsession = (ZC_SsessionInfo *)pstruIndex->pu8Opt[ZC_OPT_SSESSION];
+    }
+}
+
+/*************************************************
+* Function: AC_ParseOption
+* Description: 
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+void AC_ParseOption(ZC_MessageHead *pstruMsg, AC_OptList *pstruOptList, u16 *pu16OptLen)
+{
+    //Option
+    AC_OptIndex struIndex;
 
+    *pu16OptLen = 0;
+    if (ZC_RET_OK != AC_IndexMessage(pstruMsg, &struIndex))
+    {
+        return;
     }
+
+    AC_IndexToOptList(&struIndex, pstruOptList);
+    *pu16OptLen = struIndex.u16OptTotalLen;
 }
 
 /*************************************************
@@ -305,15 +543,20 @@ void AC_RecvMessage(ZC_MessageHead *pstruMsg)
 {
     //յϢҪøýӿڴϢ
     AC_OptList struOptList;
-    u16 u16OptLen = 0;
+    AC_OptIndex struIndex;
     u8 *pu8Playload = NULL;
 
     struOptList.pstruSsession = NULL;
     struOptList.pstruTransportInfo = NULL;
     
     /*Parser Option*/
-    AC_ParseOption(pstruMsg, &struOptList, &u16OptLen);
-    pu8Playload = (u8*)pstruMsg + u16OptLen + sizeof(ZC_MessageHead);
+    if (ZC_RET_OK != AC_IndexMessage(pstruMsg, &struIndex))
+    {
+        AC_Printf("bad option, code = %d\n", pstruMsg->MsgCode);
+        return;
+    }
+    AC_IndexToOptList(&struIndex, &struOptList);
+    pu8Playload = struIndex.pu8Payload;
     switch(pstruMsg->MsgCode)
     {
         //¼֪ͨϢ
@@ -368,7 +611,7 @@ u8 AC_CalcSum(u8 *pu8Src, u8 u8Len)
 u32 AC_CheckSum(u8 * Buffer,u32 len) 
 { 
     u8 u8Sum =AC_CalcSum(Buffer+1,len-3);
-    if (Buffer[len-2]==AC_CalcSum(Buffer+1,len-3)) 
+    if (Buffer[len-2]==u8Sum) 
     {
         return(ZC_RET_OK);//Уȷ 
     }
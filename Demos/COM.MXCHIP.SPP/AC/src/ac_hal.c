@@ -93,26 +93,26 @@ void AC_UartProcess(u8* inBuf, u32 datalen)
         }
         default:
         {
+            AC_MsgBuilder struBuilder;
             u16 u16DataLen = 0;
-            if(0==inBuf[4])
+            u32 u32Head = (0==inBuf[4]) ? 6 : 10;
+
+            if (datalen < u32Head + 2)
             {
-                AC_BuildMessage(inBuf[5],inBuf[3],
-                                inBuf+6, datalen-8,
-                                NULL, 
-                                g_u8DevMsgBuildBuffer, &u16DataLen);
-                AC_SendMessage(g_u8DevMsgBuildBuffer, u16DataLen);
+                break;
             }
-            else
+            /*uart frame straight into the cloud frame, no staging copy*/
+            AC_MsgInit(&struBuilder, inBuf[5], inBuf[3], 
+                       g_u8DevMsgBuildBuffer, sizeof(g_u8DevMsgBuildBuffer));
+            if(0!=inBuf[4])
+            {
+                AC_MsgAddOption(&struBuilder, ZC_OPT_SSESSION, inBuf+6, sizeof(ZC_SsessionInfo));
+            }
+            AC_MsgAppend(&struBuilder, inBuf+u32Head, datalen-u32Head-2);
+            u16DataLen = AC_MsgEnd(&struBuilder);
+            if (0 != u16DataLen)
             {
-                AC_OptList struOptList;
-                struOptList.pstruTransportInfo=NULL;
-                struOptList.pstruSsession = (ZC_SsessionInfo *)(inBuf+6);
-                AC_BuildMessage(inBuf[5],inBuf[3],
-                                inBuf+10, datalen-12,
-                                &struOptList, 
-                                g_u8DevMsgBuildBuffer, &u16DataLen);
                 AC_SendMessage(g_u8DevMsgBuildBuffer, u16DataLen);
-                
             }
             break;
         }
@@ -199,14 +199,20 @@ void AC_UartRecv(u8 *pu8Data, u32 u32DataLen)
 *************************************************/
 void AC_SendLedStatus2Server()
 {
-    STRU_LED_ONOFF struRsp;
+    AC_MsgBuilder struBuilder;
+    STRU_LED_ONOFF *pstruRsp;
     u16 u16DataLen;
-    //struRsp.u8LedOnOff = GPIOPinRead(GPIO_PORTF_BASE, GPIO_PIN_2);
-    struRsp.u8LedOnOff = struRsp.u8LedOnOff>>2;
-    AC_BuildMessage(MSG_SERVER_CLIENT_GET_LED_STATUS_RSP,0,
-                    (u8*)&struRsp, sizeof(STRU_LED_ONOFF),
-                    NULL, 
-                    g_u8DevMsgBuildBuffer, &u16DataLen);
+
+    AC_MsgInit(&struBuilder, MSG_SERVER_CLIENT_GET_LED_STATUS_RSP, 0, 
+               g_u8DevMsgBuildBuffer, sizeof(g_u8DevMsgBuildBuffer));
+    pstruRsp = (STRU_LED_ONOFF *)AC_MsgReserve(&struBuilder, sizeof(STRU_LED_ONOFF));
+    if (NULL == pstruRsp)
+    {
+        return;
+    }
+    memset(pstruRsp, 0, sizeof(STRU_LED_ONOFF));
+    //pstruRsp->u8LedOnOff = GPIOPinRead(GPIO_PORTF_BASE, GPIO_PIN_2)>>2;
+    u16DataLen = AC_MsgEnd(&struBuilder);
     AC_SendMessage(g_u8DevMsgBuildBuffer, u16DataLen);
 }
 
@@ -13,6 +13,7 @@
 #include <ac_api.h>
 #include <stdarg.h>
 #include "CheckSumUtils.h"
+#include "MICOTimerService.h"
 #include <errno.h> 
 #define update_log(M, ...) custom_log("UPDATE", M, ##__VA_ARGS__)
 //extern vu32 MS_TIMER;
@@ -23,17 +24,15 @@ extern mico_Context_t *context;
 extern void PlatformEasyLinkButtonClickedCallback(void);
 //extern mico_semaphore_t      app_sem;
 MX_Timer g_struMxTimer[ZC_TIMER_MAX_NUM];
-u16 g_struMxTimerCount[ZC_TIMER_MAX_NUM];
 u8 g_u8TimerIndex;
-mico_timer_t g_struMicoTimer;
+mico_service_timer_t g_struMxServiceTimer[ZC_TIMER_MAX_NUM];
+mico_mutex_t g_struMxMsgMutex;
 extern PTC_ProtocolCon  g_struProtocolController;
 PTC_ModuleAdapter g_struAdapter;
 
-MSG_Buffer g_struRecvBuffer;
 
-MSG_Queue  g_struRecvQueue;
-MSG_Buffer g_struSendBuffer[MSG_BUFFER_SEND_MAX_NUM];
-MSG_Queue  g_struSendQueue;
+MSG_LaneQueue g_struRecvQueue;
+MSG_LaneQueue g_struSendQueue;
 
 u8 g_u8MsgBuildBuffer[MSG_BULID_BUFFER_MAXLEN];
 
@@ -447,6 +446,7 @@ u32 MX_SendDataToMoudle(u8 *pu8Data, u16 u16DataLen)
 void MX_StopTimer(u8 u8TimerIndex)
 {
     g_struMxTimer[u8TimerIndex].u8ValidFlag = 0;
+    MICOStopServiceTimer(&g_struMxServiceTimer[u8TimerIndex]);
 }
 
 /*************************************************
@@ -459,20 +459,12 @@ void MX_StopTimer(u8 u8TimerIndex)
 *************************************************/
 void MX_timer_callback(void* arg) 
 {
-	  u8 i =0;
-    (void )arg;
-    
-    for(i=0;i<ZC_TIMER_MAX_NUM;i++)
+    u8 i = (u8)(u32)arg;
+
+    if(g_struMxTimer[i].u8ValidFlag)
     {
-        if(g_struMxTimer[i].u8ValidFlag)
-        {
-            if(g_struMxTimer[i].u32Interval<=g_struMxTimerCount[i]++)
-            {
-                g_struMxTimerCount[i]=0;
-                TIMER_TimeoutAction(i);
-				TIMER_StopTimer(i);
-            }
-        }
+        TIMER_TimeoutAction(i);
+        TIMER_StopTimer(i);
     }
 }
 
@@ -494,9 +486,9 @@ u32 MX_SetTimer(u8 u8Type, u32 u32Interval, u8 *pu8TimeIndex)
     if (ZC_RET_OK == u32Retval)
     {
         TIMER_AllocateTimer(u8Type, u8TimerIndex, (u8*)&g_struMxTimer[u8TimerIndex]);
-        g_struMxTimer[u8TimerIndex].u32Interval = u32Interval/100;
+        g_struMxTimer[u8TimerIndex].u32Interval = u32Interval;
         g_struMxTimer[u8TimerIndex].u8ValidFlag = 1;
-        g_struMxTimerCount[u8TimerIndex]=0;
+        MICOStartServiceTimer(&g_struMxServiceTimer[u8TimerIndex], u32Interval, 0);
 		*pu8TimeIndex = u8TimerIndex;
     }
     return u32Retval;
@@ -701,13 +693,39 @@ void MX_TimerInit()
 {
     u8 i = 0;
 
+    MICOStartTimerService();
     for(i=0;i<ZC_TIMER_MAX_NUM;i++)
     {
         g_struMxTimer[i].u8ValidFlag = 0;
+        MICOInitServiceTimer(&g_struMxServiceTimer[i], MX_timer_callback, (void *)(u32)i);
     }
-	  mico_init_timer(&g_struMicoTimer,100,MX_timer_callback,NULL);	
-	  mico_start_timer(&g_struMicoTimer);
 }
+/*************************************************
+* Function: MX_Lock
+* Description: message pool and lanes of the zc queue
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+void MX_Lock()
+{
+    mico_rtos_lock_mutex(&g_struMxMsgMutex);
+}
+
+/*************************************************
+* Function: MX_Unlock
+* Description: 
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+void MX_Unlock()
+{
+    mico_rtos_unlock_mutex(&g_struMxMsgMutex);
+}
+
 /*************************************************
 * Function: MX_Init
 * Description: 
@@ -737,6 +755,11 @@ void MX_Init()
     g_struAdapter.pfunPrintf = (pFunPrintf)printf;
     g_struAdapter.pfunMalloc = malloc;
     g_struAdapter.pfunFree = free;
+    g_struAdapter.pfunGetTime = mico_get_time;
+    g_struAdapter.pfunLock = MX_Lock;
+    g_struAdapter.pfunUnlock = MX_Unlock;
+
+    mico_rtos_init_mutex(&g_struMxMsgMutex);
 
     g_u16TcpMss = 1000;
     PCT_Init(&g_struAdapter);
@@ -21,14 +21,13 @@ MX_Timer g_struMxTimer[ZC_TIMER_MAX_NUM];
 u16 g_struMxTimerCount[ZC_TIMER_MAX_NUM];
 u8 g_u8TimerIndex;
 mico_timer_t g_struMicoTimer;
+mico_mutex_t g_struMxMsgMutex;
 extern PTC_ProtocolCon  g_struProtocolController;
 PTC_ModuleAdapter g_struAdapter;
 
-MSG_Buffer g_struRecvBuffer;
 
-MSG_Queue  g_struRecvQueue;
-MSG_Buffer g_struSendBuffer[MSG_BUFFER_SEND_MAX_NUM];
-MSG_Queue  g_struSendQueue;
+MSG_LaneQueue g_struRecvQueue;
+MSG_LaneQueue g_struSendQueue;
 
 u8 g_u8MsgBuildBuffer[MSG_BULID_BUFFER_MAXLEN];
 
@@ -674,6 +673,32 @@ void MX_TimerInit()
 	  mico_start_timer(&g_struMicoTimer);
 }
 
+/*************************************************
+* Function: MX_Lock
+* Description: message pool and lanes of the zc queue
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+void MX_Lock()
+{
+    mico_rtos_lock_mutex(&g_struMxMsgMutex);
+}
+
+/*************************************************
+* Function: MX_Unlock
+* Description: 
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+void MX_Unlock()
+{
+    mico_rtos_unlock_mutex(&g_struMxMsgMutex);
+}
+
 /*************************************************
 * Function: MX_Init
 * Description: 
@@ -702,6 +727,11 @@ void MX_Init()
     g_struAdapter.pfunPrintf = (pFunPrintf)printf;
     g_struAdapter.pfunMalloc = malloc;
     g_struAdapter.pfunFree = free;
+    g_struAdapter.pfunGetTime = mico_get_time;
+    g_struAdapter.pfunLock = MX_Lock;
+    g_struAdapter.pfunUnlock = MX_Unlock;
+
+    mico_rtos_init_mutex(&g_struMxMsgMutex);
 
     g_u16TcpMss = 1000;
     PCT_Init(&g_struAdapter);
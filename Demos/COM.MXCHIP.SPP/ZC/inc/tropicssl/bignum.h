@@ -365,6 +365,16 @@ extern "C" {
 	 */
 	int mpi_mod_int(t_int * r, const mpi * A, int b);
 
+	/**
+	 * \brief          Precompute the Montgomery constant R*R mod N once
+	 *                 per modulus, for use as the _RR of mpi_exp_mod
+	 *
+	 * \return         0 if successful,
+	 *                 1 if memory allocation failed,
+	 *                 TROPICSSL_ERR_MPI_BAD_INPUT_DATA if N is negative or even
+	 */
+	int mpi_montg_precompute(mpi * RR, const mpi * N);
+
 	/**
 	 * \brief          Sliding-window exponentiation: X = A^E mod N
 	 *
@@ -44,7 +44,13 @@
  *         . PowerPC, 64-bit      . TriCore
  *         . SPARC v8             . ARM v3+
  *         . Alpha                . MIPS32
- *         . C, longlong          . C, generic
+ *         . ARMv7E-M (UMAAL)     . C, longlong
+ *         . C, generic
+ *
+ *      MULADDC2 is the Montgomery product step, d += s * b + n * u in a
+ *      single pass. It is only defined where a limb product with two
+ *      limbs added fits the double limb (C, longlong and ARMv7E-M), the
+ *      other targets run MULADDC twice.
  */
 #ifndef TROPICSSL_BN_MUL_H
 #define TROPICSSL_BN_MUL_H
@@ -489,7 +495,44 @@
 
 #endif /* TriCore */
 
-#if defined(__arm__)
+#if defined(__arm__) && defined(__thumb2__) && defined(__ARM_FEATURE_DSP)
+
+/*
+ * UMAAL adds both the limb and the carry to the 32x32 product
+ */
+#define MULADDC_INIT                            \
+{                                               \
+    t_int r0;
+
+#define MULADDC_CORE                            \
+    r0 = *d;                                    \
+    asm( "umaal  %0, %1, %2, %3 "               \
+         : "+r" (r0), "+r" (c)                  \
+         : "r" (*(s++)), "r" (b) );             \
+    *(d++) = r0;
+
+#define MULADDC_STOP                            \
+}
+
+#define MULADDC2_INIT                           \
+{                                               \
+    t_int r0;
+
+#define MULADDC2_CORE                           \
+    r0 = *d;                                    \
+    asm( "umaal  %0, %1, %3, %4 \n\t"           \
+         "umaal  %0, %2, %5, %6 "               \
+         : "+r" (r0), "+r" (c), "+r" (c2)       \
+         : "r" (*(s++)), "r" (b),               \
+           "r" (*(n++)), "r" (u) );             \
+    *(d++) = r0;
+
+#define MULADDC2_STOP                           \
+}
+
+#endif /* ARMv7E-M */
+
+#if defined(__arm__) && !defined(MULADDC_CORE)
 #if defined(__thumb__) && !defined(__thumb2__)
 
 #define MULADDC_INIT                                    \
@@ -784,4 +827,23 @@
 #endif /* C (generic)  */
 #endif /* C (longlong) */
 
+#if !defined(MULADDC2_CORE) && defined(TROPICSSL_HAVE_LONGLONG)
+
+#define MULADDC2_INIT                   \
+{                                       \
+    t_dbl r;
+
+#define MULADDC2_CORE                   \
+    r   = *(s++) * (t_dbl) b + *d + c;  \
+    c   = (t_int) (r >> biL);           \
+    r   = *(n++) * (t_dbl) u +          \
+          (t_int) r + c2;               \
+    c2  = (t_int) (r >> biL);           \
+    *(d++) = (t_int) r;
+
+#define MULADDC2_STOP                   \
+}
+
+#endif /* C (longlong), Montgomery */
+
 #endif /* bn_mul.h */
@@ -164,6 +164,19 @@ extern "C" {
 	 */
 	int rsa_check_privkey(const rsa_context * ctx);
 
+	/**
+	 * \brief          Precompute the Montgomery constants of a loaded key
+	 *
+	 * \param ctx      RSA context with N, and P and Q for a private key
+	 *
+	 * \return         0 if successful, or an TROPICSSL_ERR_RSA_XXX error code
+	 *
+	 * \note           RN, RP and RQ are otherwise computed by the first
+	 *                 operation. A context kept for the lifetime of the key
+	 *                 then never computes them again.
+	 */
+	int rsa_precompute(rsa_context * ctx);
+
 	/**
 	 * \brief          Do an RSA public key operation
 	 *
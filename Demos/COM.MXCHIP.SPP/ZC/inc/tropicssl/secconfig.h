@@ -59,9 +59,8 @@
 
 /*
  * Uncomment if the compiler supports long long.
- *
-#define TROPICSSL_HAVE_LONGLONG
  */
+#define TROPICSSL_HAVE_LONGLONG
 
 /*
  * Uncomment to enable the use of assembly code.
@@ -68,6 +68,8 @@ extern "C" {
 
 void ZC_TraceData(u8* pData, u32 Len);
 unsigned short crc16_ccitt(const unsigned char *buf, unsigned int len);	
+unsigned short crc16_ccitt_update(unsigned short crc, const unsigned char *buf, unsigned int len);
+unsigned short crc16_ccitt_copy(unsigned short crc, unsigned char *dst, const unsigned char *src, unsigned int len);
 int rand(void);
 void ZC_ConfigPara(u8 *pu8Data);
 void ZC_Rand(u8 *pu8Rand);
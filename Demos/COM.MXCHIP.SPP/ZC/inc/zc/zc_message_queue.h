@@ -12,6 +12,7 @@
 #define  __ZC_MESSAGE_QUEUE_H__
 
 #include <zc_common.h>
+#include <zc_protocol_interface.h>
 
 #define  MSG_QUEUE_MAXLEN               (3)
 #define  MSG_BUFFER_MAXLEN              (600)
@@ -24,6 +25,30 @@
 #define  MSG_BUFFER_SEND_MAX_NUM        (MSG_QUEUE_MAXLEN)
 #define  MSG_BULID_BUFFER_MAXLEN        (600)
 
+/*Cloud message pool, a message takes a run of blocks sized to fit it*/
+#ifndef  MSG_POOL_BLOCK_LEN
+#define  MSG_POOL_BLOCK_LEN             (64)
+#endif
+#ifndef  MSG_POOL_BLOCK_NUM
+#define  MSG_POOL_BLOCK_NUM             (48)
+#endif
+/*blocks a received data message may not take, left for control messages*/
+#ifndef  MSG_POOL_CONTROL_RESERVE
+#define  MSG_POOL_CONTROL_RESERVE       (4)
+#endif
+
+/*Cloud queue lanes, control is always served first*/
+#define  MSG_LANE_CONTROL               (0)
+#define  MSG_LANE_DATA                  (1)
+#define  MSG_LANE_NUM                   (2)
+
+#ifndef  MSG_LANE_CONTROL_MAXLEN
+#define  MSG_LANE_CONTROL_MAXLEN        (8)
+#endif
+#ifndef  MSG_LANE_DATA_MAXLEN
+#define  MSG_LANE_DATA_MAXLEN           (8)
+#endif
+
 typedef struct struMSG_QueNode{
     struct struMSG_QueNode* pstruNext;
     u8 *pu8Msg;
@@ -45,6 +70,48 @@ typedef struct
     u8  u8MsgBuffer[MSG_BUFFER_MAXLEN];
 }MSG_Buffer;
 
+/*Pool Buffer, head of a run of u16Blocks pool blocks, message right behind*/
+typedef struct struMSG_PoolBuf{
+    struct struMSG_PoolBuf *pstruNext;
+    u8  *pu8MsgBuffer;
+    u32 u32Len;  
+    u32 u32QueueTime;       /*ms, when it was pushed*/
+    u16 u16Blocks;
+    u8  u8Lane;
+    u8  u8Pad;
+}MSG_PoolBuf;
+
+/*Lane counters, delays in ms*/
+typedef struct
+{
+    u32 u32Pushed;
+    u32 u32Popped;
+    u32 u32Dropped;         /*lane full, flushed or pushed out by control*/
+    u32 u32DelaySum;
+    u32 u32DelayMax;
+}MSG_LaneStats;
+
+/*Lane Queue*/
+typedef struct
+{
+    MSG_PoolBuf *pstruHead[MSG_LANE_NUM];
+    MSG_PoolBuf *pstruTail[MSG_LANE_NUM];
+    u16 u16Depth[MSG_LANE_NUM];
+    MSG_LaneStats struStats[MSG_LANE_NUM];
+    u32 u32NoBuffer;        /*pool exhausted*/
+    u32 u32BadMsg;          /*too short or failed to decrypt*/
+}MSG_LaneQueue;
+
+/*Cloud stream reassembly, a message split over recv calls*/
+typedef struct
+{
+    ZC_SecHead struSecHead;
+    u16 u16HeadLen;         /*bytes of struSecHead received*/
+    u16 u16Pad;
+    MSG_PoolBuf *pstruCiper;
+    u32 u32SkipLen;         /*rest of a message with no buffer*/
+}MSG_Reassembly;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,6 +124,14 @@ u32 MSG_RecvData(MSG_Buffer *pstruRecvBuffer, u8 *pu8Data, u32 u32DataLen);
 void MSG_Init(void);
 void MSG_RecvDataFromCloud(u8 *pu8Data, u32 u32DataLen);
 void MSG_SendDataToCloud(u8 *pu8Connection);
+MSG_PoolBuf *MSG_AllocBuffer(u32 u32Len);
+void MSG_FreeBuffer(MSG_PoolBuf *pstruBuf);
+u32 MSG_PoolFreeBlocks(void);
+void MSG_InitLaneQueue(MSG_LaneQueue *pstruQueue);
+u8 MSG_GetLane(u8 *pu8Msg, u32 u32Len);
+u32 MSG_PushLane(MSG_LaneQueue *pstruQueue, MSG_PoolBuf *pstruBuf, u8 u8Lane);
+MSG_PoolBuf *MSG_PopLane(MSG_LaneQueue *pstruQueue);
+u32 MSG_DropOldest(MSG_LaneQueue *pstruQueue, u8 u8Lane);
 
 #ifdef __cplusplus
 }
@@ -105,6 +105,8 @@ typedef void (*pFunReboot)();
 typedef void (*pFunPrintf)(const char *pu8format, ...);
 typedef void *(*pFunMalloc)(u32 size);
 typedef void (*pFunFree)(void *ptr);
+typedef u32 (*pFunGetTime)(void);
+typedef void (*pFunLock)(void);
 
 
 typedef struct
@@ -129,6 +131,9 @@ typedef struct
     pFunPrintf                  pfunPrintf;
     pFunMalloc                  pfunMalloc;
     pFunFree                    pfunFree;
+    pFunGetTime                 pfunGetTime;    /*ms, for queue delays, may be NULL*/
+    pFunLock                    pfunLock;       /*message pool and lanes, may be NULL with one thread*/
+    pFunLock                    pfunUnlock;
 }PTC_ModuleAdapter;
 
 typedef struct
@@ -171,12 +176,10 @@ typedef struct
 
 
 extern PTC_ProtocolCon  g_struProtocolController;
-extern MSG_Buffer g_struRecvBuffer;
 extern MSG_Buffer g_struClientBuffer;
 
-extern MSG_Queue  g_struRecvQueue;
-extern MSG_Buffer g_struSendBuffer[MSG_BUFFER_SEND_MAX_NUM];
-extern MSG_Queue  g_struSendQueue;
+extern MSG_LaneQueue g_struRecvQueue;
+extern MSG_LaneQueue g_struSendQueue;
 
 extern u8 g_u8MsgBuildBuffer[MSG_BULID_BUFFER_MAXLEN];
 
@@ -210,12 +213,12 @@ void PCT_SendAckToCloud(u8 u8MsgId);
 void PCT_ModuleOtaFileBeginMsg(PTC_ProtocolCon *pstruContoller, u8 *pu8Msg);
 void PCT_ModuleOtaFileChunkMsg(PTC_ProtocolCon *pstruContoller, ZC_MessageHead *pstruMsg, u8 *pu8Msg);
 void PCT_ModuleOtaFileEndMsg(PTC_ProtocolCon *pstruContoller, u8 *pu8Msg);
-void PCT_HandleOtaBeginMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer);
-void PCT_HandleOtaFileBeginMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer);
-void PCT_HandleOtaFileChunkMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer);
-void PCT_HandleOtaFileEndMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer);
-void PCT_HandleOtaEndMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer);
-void PCT_HandleMoudleMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer);
+void PCT_HandleOtaBeginMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer);
+void PCT_HandleOtaFileBeginMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer);
+void PCT_HandleOtaFileChunkMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer);
+void PCT_HandleOtaFileEndMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer);
+void PCT_HandleOtaEndMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer);
+void PCT_HandleMoudleMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer);
 void PCT_SendUnbindMsg(void);
 
 #ifdef __cplusplus
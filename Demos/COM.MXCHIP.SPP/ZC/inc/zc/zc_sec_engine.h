@@ -16,6 +16,8 @@
 #include <bignum.h>
 
 #define  ZC_SEC_RSA_KEY_LEN        (256) /*bit len*/
+#define  ZC_SEC_RSA_PUBLIC_KEY_LEN  ((ZC_SEC_RSA_KEY_LEN >> 3) + 3)                            /*N, E*/
+#define  ZC_SEC_RSA_PRIVATE_KEY_LEN ((ZC_SEC_RSA_KEY_LEN >> 3) + 5 * (ZC_SEC_RSA_KEY_LEN >> 4))  /*N, P, Q, DP, DQ, QP*/
 #define  ZC_SEC_AES_BLOCK_SIZE     (16)
 
 
@@ -129,8 +129,40 @@ unsigned int crc_cal_by_halfbyte(const unsigned char* ptr, unsigned int len)
     return crc;
 }
 
+/*crc16_ccitt_update: continue a CRC-CCITT over len more bytes, table driven.
+  Same result as crc_cal_by_bit over the concatenated data, so a message can
+  be checked piece by piece as it is written, starting from crc = 0.
+*/
+unsigned short crc16_ccitt_update(unsigned short crc, const unsigned char *buf, unsigned int len)
+{
+    while(len-- != 0)
+    {
+        crc = (unsigned short)((crc << 8) ^ crc_ta_8[(crc >> 8) ^ *buf++]);
+    }
+
+    return crc;
+}
+
+/*crc16_ccitt_copy: copy len bytes from src to dst and fold them into crc in
+  the same pass. Bytes are moved front to back, so dst may overlap src when it
+  lies below it.
+*/
+unsigned short crc16_ccitt_copy(unsigned short crc, unsigned char *dst, const unsigned char *src, unsigned int len)
+{
+    unsigned char c;
+
+    while(len-- != 0)
+    {
+        c = *src++;
+        *dst++ = c;
+        crc = (unsigned short)((crc << 8) ^ crc_ta_8[(crc >> 8) ^ c]);
+    }
+
+    return crc;
+}
+
 unsigned short crc16_ccitt(const unsigned char *buf, unsigned int len)
 {
-	return crc_cal_by_bit(buf,len);
+	return crc16_ccitt_update(0, buf, len);
 
 }
@@ -1144,6 +1144,37 @@ static void mpi_montg_init(t_int * mm, const mpi * N)
 	*mm = ~x + 1;
 }
 
+#if defined(MULADDC2_CORE)
+/*
+ * Helper for Montgomery multiplication: d += s * b + n * u
+ */
+static void mpi_montmul_hlp(int i, const t_int * s, const t_int * n,
+			    t_int * d, t_int b, t_int u)
+{
+	t_int c = 0, c2 = 0;
+
+	for (; i >= 4; i -= 4) {
+	MULADDC2_INIT
+		    MULADDC2_CORE MULADDC2_CORE
+		    MULADDC2_CORE MULADDC2_CORE MULADDC2_STOP}
+
+	for (; i > 0; i--) {
+	MULADDC2_INIT MULADDC2_CORE MULADDC2_STOP}
+
+	c += c2;
+	c2 = (c < c2);
+	*d += c;
+	c2 += (*d < c);
+	d++;
+
+	while (c2 != 0) {
+		*d += c2;
+		c2 = (*d < c2);
+		d++;
+	}
+}
+#endif
+
 /*
  * Montgomery multiplication: A = A * B * R^-1 mod N  (HAC 14.36)
  */
@@ -1165,8 +1196,15 @@ static void mpi_montmul(mpi * A, const mpi * B, const mpi * N, t_int mm, mpi * T
 		u0 = A->p[i];
 		u1 = (d[0] + u0 * B->p[0]) * mm;
 
-		mpi_mul_hlp(m, (t_int *)B->p, d, u0);
-		mpi_mul_hlp(n, (t_int *)N->p, d, u1);
+#if defined(MULADDC2_CORE)
+		if (m == n)
+			mpi_montmul_hlp(n, B->p, N->p, d, u0, u1);
+		else
+#endif
+		{
+			mpi_mul_hlp(m, (t_int *)B->p, d, u0);
+			mpi_mul_hlp(n, (t_int *)N->p, d, u1);
+		}
 
 		*d++ = u0;
 		d[n + 1] = 0;
@@ -1196,6 +1234,25 @@ static void mpi_montred(mpi * A, const mpi * N, t_int mm, mpi * T)
 	mpi_montmul(A, &U, N, mm, T);
 }
 
+/*
+ * Montgomery constant: RR = R^2 mod N, R = 2^(biL * N->n)
+ */
+int mpi_montg_precompute(mpi * RR, const mpi * N)
+{
+	int ret;
+
+	if (mpi_cmp_int(N, 0) < 0 || (N->p[0] & 1) == 0)
+		return (TROPICSSL_ERR_MPI_BAD_INPUT_DATA);
+
+	MPI_CHK(mpi_lset(RR, 1));
+	MPI_CHK(mpi_shift_l(RR, N->n * 2 * biL));
+	MPI_CHK(mpi_mod_mpi(RR, RR, N));
+
+cleanup:
+
+	return (ret);
+}
+
 /*
  * Sliding-window exponentiation: X = A^E mod N	 (HAC 14.85)
  */
@@ -1215,12 +1272,16 @@ int mpi_exp_mod(mpi * X, const mpi * A, const mpi * E, const mpi * N, mpi * _RR)
 	 */
 	mpi_montg_init(&mm, N);
 	mpi_init(&O_RR); mpi_init(&O_T);
-	memset(O_W, 0, sizeof(O_W));
 
 	i = mpi_msb(E);
 
 	wsize = (i > 671) ? 6 : (i > 239) ? 5 : (i > 79) ? 4 : (i > 23) ? 3 : 1;
 
+	/*
+	 * only W[1] and W[2^(wsize-1)] .. W[2^wsize - 1] are used
+	 */
+	memset(O_W, 0, (1 << wsize) * sizeof(mpi));
+
 	j = N->n + 1;
 	MPI_CHK(mpi_grow(X, j));
 	
@@ -1232,9 +1293,7 @@ int mpi_exp_mod(mpi * X, const mpi * A, const mpi * E, const mpi * N, mpi * _RR)
 	 * If 1st call, pre-compute R^2 mod N
 	 */
 	if (_RR == NULL || _RR->n == 0/*_RR->p == NULL*/) {
-		MPI_CHK(mpi_lset(&O_RR, 1));
-		MPI_CHK(mpi_shift_l(&O_RR, N->n * 2 * biL));
-		MPI_CHK(mpi_mod_mpi(&O_RR, &O_RR, N));
+		MPI_CHK(mpi_montg_precompute(&O_RR, N));
 
 		if (_RR != NULL)
 		{
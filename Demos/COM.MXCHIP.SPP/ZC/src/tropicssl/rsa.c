@@ -132,6 +132,28 @@ cleanup:
 
 #endif
 
+/*
+* Precompute R^2 mod N, and mod P and Q for the CRT
+*/
+int rsa_precompute(rsa_context * ctx)
+{
+    int ret;
+
+    MPI_CHK(mpi_montg_precompute(&ctx->RN, &ctx->N));
+
+    if (mpi_cmp_int(&ctx->P, 0) != 0) {
+        MPI_CHK(mpi_montg_precompute(&ctx->RP, &ctx->P));
+        MPI_CHK(mpi_montg_precompute(&ctx->RQ, &ctx->Q));
+    }
+
+cleanup:
+
+    if (ret != 0)
+        return (TROPICSSL_ERR_RSA_BAD_INPUT_DATA | ret);
+
+    return (0);
+}
+
 /*
 * Do an RSA public key operation
 */
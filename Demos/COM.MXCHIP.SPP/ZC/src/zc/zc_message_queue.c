@@ -11,8 +11,10 @@
 #include <zc_message_queue.h>
 #include <zc_protocol_controller.h>
 
-
-
+/*pool blocks, u32 so that every block and message is word aligned*/
+static u32 g_u32MsgPool[MSG_POOL_BLOCK_NUM][MSG_POOL_BLOCK_LEN / sizeof(u32)];
+static u8 g_u8MsgPoolUsed[MSG_POOL_BLOCK_NUM];
+static MSG_Reassembly g_struCloudReassembly;
 
 /*************************************************
 * Function: MSG_Init()
@@ -24,22 +26,402 @@
 *************************************************/
 void MSG_Init()
 {
+    /*queued messages are lost, counters carry on. A buffer a handler
+      popped stays its own until it frees it*/
+    MSG_InitLaneQueue(&g_struRecvQueue);
+    MSG_InitLaneQueue(&g_struSendQueue);
+
+    MSG_FreeBuffer(g_struCloudReassembly.pstruCiper);
+    memset(&g_struCloudReassembly, 0, sizeof(g_struCloudReassembly));
+    
+    g_struClientBuffer.u32Len = 0;    
+    g_struClientBuffer.u8Status = MSG_BUFFER_IDLE;    
+}
+
+/*************************************************
+* Function: MSG_GetTime
+* Description: 
+* Author: cxy 
+* Returns: ms, 0 if the module gives no clock
+* Parameter: 
+* History:
+*************************************************/
+static u32 MSG_GetTime(void)
+{
+    if ((NULL == g_struProtocolController.pstruMoudleFun) 
+        || (NULL == g_struProtocolController.pstruMoudleFun->pfunGetTime))
+    {
+        return 0;
+    }
+
+    return g_struProtocolController.pstruMoudleFun->pfunGetTime();
+}
+
+/*************************************************
+* Function: MSG_Lock
+* Description: the pool and the lanes are shared by the module uart,
+              the cloud and the timer threads
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+static void MSG_Lock(void)
+{
+    if ((NULL != g_struProtocolController.pstruMoudleFun) 
+        && (NULL != g_struProtocolController.pstruMoudleFun->pfunLock))
+    {
+        g_struProtocolController.pstruMoudleFun->pfunLock();
+    }
+}
+
+/*************************************************
+* Function: MSG_Unlock
+* Description: 
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+static void MSG_Unlock(void)
+{
+    if ((NULL != g_struProtocolController.pstruMoudleFun) 
+        && (NULL != g_struProtocolController.pstruMoudleFun->pfunUnlock))
+    {
+        g_struProtocolController.pstruMoudleFun->pfunUnlock();
+    }
+}
+
+/*************************************************
+* Function: MSG_AllocBuffer
+* Description: first fit run of pool blocks for a u32Len byte message
+* Author: cxy 
+* Returns: buffer, NULL if the pool has no run that long
+* Parameter: 
+* History:
+*************************************************/
+MSG_PoolBuf *MSG_AllocBuffer(u32 u32Len)
+{
+    MSG_PoolBuf *pstruBuf;
+    u32 u32Blocks;
+    u32 u32Run = 0;
     u32 u32Index;
-    MSG_InitQueue(&g_struRecvQueue);
-    MSG_InitQueue(&g_struSendQueue);
 
+    u32Blocks = (sizeof(MSG_PoolBuf) + u32Len + MSG_POOL_BLOCK_LEN - 1) / MSG_POOL_BLOCK_LEN;
+    if (u32Blocks > MSG_POOL_BLOCK_NUM)
+    {
+        return NULL;
+    }
+
+    MSG_Lock();
+    for (u32Index = 0; u32Index < MSG_POOL_BLOCK_NUM; u32Index++)
+    {
+        if (g_u8MsgPoolUsed[u32Index])
+        {
+            u32Run = 0;
+            continue;
+        }
+        
+        u32Run++;
+        if (u32Run == u32Blocks)
+        {
+            u32Index = u32Index + 1 - u32Blocks;
+            memset(g_u8MsgPoolUsed + u32Index, 1, u32Blocks);
+            MSG_Unlock();
+
+            pstruBuf = (MSG_PoolBuf *)g_u32MsgPool[u32Index];
+            pstruBuf->pstruNext = NULL;
+            pstruBuf->pu8MsgBuffer = (u8 *)(pstruBuf + 1);
+            pstruBuf->u32Len = u32Len;
+            pstruBuf->u32QueueTime = 0;
+            pstruBuf->u16Blocks = (u16)u32Blocks;
+            pstruBuf->u8Lane = MSG_LANE_DATA;
+            return pstruBuf;
+        }
+    }
+    MSG_Unlock();
+
+    return NULL;
+}
+
+/*************************************************
+* Function: MSG_PoolIndex
+* Description: 
+* Author: cxy 
+* Returns: first pool block of pstruBuf
+* Parameter: 
+* History:
+*************************************************/
+static u32 MSG_PoolIndex(MSG_PoolBuf *pstruBuf)
+{
+    return (u32)(((u8 *)pstruBuf - (u8 *)g_u32MsgPool) / MSG_POOL_BLOCK_LEN);
+}
+
+/*************************************************
+* Function: MSG_ShrinkBuffer
+* Description: give back the blocks past u32Len
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+static void MSG_ShrinkBuffer(MSG_PoolBuf *pstruBuf, u32 u32Len)
+{
+    u32 u32Blocks;
+
+    u32Blocks = (sizeof(MSG_PoolBuf) + u32Len + MSG_POOL_BLOCK_LEN - 1) / MSG_POOL_BLOCK_LEN;
+    if (u32Blocks < pstruBuf->u16Blocks)
+    {
+        MSG_Lock();
+        memset(g_u8MsgPoolUsed + MSG_PoolIndex(pstruBuf) + u32Blocks, 0, pstruBuf->u16Blocks - u32Blocks);
+        MSG_Unlock();
+        pstruBuf->u16Blocks = (u16)u32Blocks;
+    }
+    pstruBuf->u32Len = u32Len;
+}
 
-    g_struRecvBuffer.u32Len = 0;
-    g_struRecvBuffer.u8Status = MSG_BUFFER_IDLE;    
+/*************************************************
+* Function: MSG_ReleaseBuffer
+* Description: MSG_FreeBuffer with the lock held
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+static void MSG_ReleaseBuffer(MSG_PoolBuf *pstruBuf)
+{
+    memset(g_u8MsgPoolUsed + MSG_PoolIndex(pstruBuf), 0, pstruBuf->u16Blocks);
+}
 
-    for (u32Index = 0; u32Index < MSG_BUFFER_SEND_MAX_NUM; u32Index++)
+/*************************************************
+* Function: MSG_FreeBuffer
+* Description: 
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+void MSG_FreeBuffer(MSG_PoolBuf *pstruBuf)
+{
+    if (NULL == pstruBuf)
     {
-        g_struSendBuffer[u32Index].u32Len = 0;
-        g_struSendBuffer[u32Index].u8Status = MSG_BUFFER_IDLE;
+        return;
     }
     
-    g_struClientBuffer.u32Len = 0;    
-    g_struClientBuffer.u8Status = MSG_BUFFER_IDLE;    
+    MSG_Lock();
+    MSG_ReleaseBuffer(pstruBuf);
+    MSG_Unlock();
+}
+
+/*************************************************
+* Function: MSG_PoolFreeBlocks
+* Description: 
+* Author: cxy 
+* Returns: free pool blocks
+* Parameter: 
+* History:
+*************************************************/
+u32 MSG_PoolFreeBlocks()
+{
+    u32 u32Index;
+    u32 u32Free = 0;
+
+    MSG_Lock();
+    for (u32Index = 0; u32Index < MSG_POOL_BLOCK_NUM; u32Index++)
+    {
+        if (0 == g_u8MsgPoolUsed[u32Index])
+        {
+            u32Free++;
+        }
+    }
+    MSG_Unlock();
+    
+    return u32Free;
+}
+
+/*************************************************
+* Function: MSG_InitLaneQueue
+* Description: empty the lanes, what was queued is freed and counts as dropped
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+void MSG_InitLaneQueue(MSG_LaneQueue *pstruQueue)
+{
+    u8 u8Lane;
+
+    for (u8Lane = 0; u8Lane < MSG_LANE_NUM; u8Lane++)
+    {
+        while (ZC_RET_OK == MSG_DropOldest(pstruQueue, u8Lane))
+        {
+        }
+    }
+}
+
+/*************************************************
+* Function: MSG_GetLane
+* Description: session set up, keepalive, acks and commands on the
+              connection go in the control lane, events and OTA data in the data lane
+* Author: cxy 
+* Returns: MSG_LANE_CONTROL/MSG_LANE_DATA
+* Parameter: 
+* History:
+*************************************************/
+u8 MSG_GetLane(u8 *pu8Msg, u32 u32Len)
+{
+    ZC_MessageHead *pstruMsg = (ZC_MessageHead *)pu8Msg;
+
+    if (u32Len < sizeof(ZC_MessageHead))
+    {
+        return MSG_LANE_DATA;
+    }
+    
+    switch (pstruMsg->MsgCode)
+    {
+        case ZC_CODE_OTA_CONFIRM:
+        case ZC_CODE_TOKEN_SET:
+        case ZC_CODE_ACCESS_POINT_RSP:
+        case ZC_CODE_RESET_NETWORK:
+        case ZC_CODE_UNBIND:
+            return MSG_LANE_CONTROL;
+        default:
+            return (pstruMsg->MsgCode < ZC_CODE_OTA_BEGIN) ? MSG_LANE_CONTROL : MSG_LANE_DATA;
+    }
+}
+
+/*************************************************
+* Function: MSG_PushLane
+* Description: queue pstruBuf at the tail of its lane, the queue owns it
+              from here and frees it if the lane is full
+* Author: cxy 
+* Returns: ZC_RET_OK/ZC_RET_ERROR
+* Parameter: 
+* History:
+*************************************************/
+u32 MSG_PushLane(MSG_LaneQueue *pstruQueue, MSG_PoolBuf *pstruBuf, u8 u8Lane)
+{
+    u16 u16MaxLen = (MSG_LANE_CONTROL == u8Lane) ? MSG_LANE_CONTROL_MAXLEN : MSG_LANE_DATA_MAXLEN;
+    
+    MSG_Lock();
+    if (pstruQueue->u16Depth[u8Lane] >= u16MaxLen)
+    {
+        pstruQueue->struStats[u8Lane].u32Dropped++;
+        MSG_ReleaseBuffer(pstruBuf);
+        MSG_Unlock();
+        return ZC_RET_ERROR;
+    }
+
+    pstruBuf->pstruNext = NULL;
+    pstruBuf->u8Lane = u8Lane;
+    pstruBuf->u32QueueTime = MSG_GetTime();
+    if (NULL == pstruQueue->pstruTail[u8Lane])
+    {
+        pstruQueue->pstruHead[u8Lane] = pstruBuf;
+    }
+    else
+    {
+        pstruQueue->pstruTail[u8Lane]->pstruNext = pstruBuf;
+    }
+    pstruQueue->pstruTail[u8Lane] = pstruBuf;
+    pstruQueue->u16Depth[u8Lane]++;
+    pstruQueue->struStats[u8Lane].u32Pushed++;
+    MSG_Unlock();
+    
+    return ZC_RET_OK;
+}
+
+/*************************************************
+* Function: MSG_Unlink
+* Description: with the lock held
+* Author: cxy 
+* Returns: head of u8Lane, NULL if it is empty
+* Parameter: 
+* History:
+*************************************************/
+static MSG_PoolBuf *MSG_Unlink(MSG_LaneQueue *pstruQueue, u8 u8Lane)
+{
+    MSG_PoolBuf *pstruBuf = pstruQueue->pstruHead[u8Lane];
+
+    if (NULL == pstruBuf)
+    {
+        return NULL;
+    }
+    
+    pstruQueue->pstruHead[u8Lane] = pstruBuf->pstruNext;
+    if (NULL == pstruBuf->pstruNext)
+    {
+        pstruQueue->pstruTail[u8Lane] = NULL;
+    }
+    pstruQueue->u16Depth[u8Lane]--;
+    pstruBuf->pstruNext = NULL;
+    
+    return pstruBuf;
+}
+
+/*************************************************
+* Function: MSG_PopLane
+* Description: oldest control message, else oldest data message; the caller
+              frees it with MSG_FreeBuffer
+* Author: cxy 
+* Returns: buffer, NULL if both lanes are empty
+* Parameter: 
+* History:
+*************************************************/
+MSG_PoolBuf *MSG_PopLane(MSG_LaneQueue *pstruQueue)
+{
+    MSG_LaneStats *pstruStats;
+    MSG_PoolBuf *pstruBuf;
+    u32 u32Delay;
+    u8 u8Lane;
+
+    MSG_Lock();
+    for (u8Lane = 0; u8Lane < MSG_LANE_NUM; u8Lane++)
+    {
+        pstruBuf = MSG_Unlink(pstruQueue, u8Lane);
+        if (NULL != pstruBuf)
+        {
+            pstruStats = &pstruQueue->struStats[u8Lane];
+            u32Delay = MSG_GetTime() - pstruBuf->u32QueueTime;
+            pstruStats->u32Popped++;
+            pstruStats->u32DelaySum += u32Delay;
+            if (u32Delay > pstruStats->u32DelayMax)
+            {
+                pstruStats->u32DelayMax = u32Delay;
+            }
+            MSG_Unlock();
+            return pstruBuf;
+        }
+    }
+    MSG_Unlock();
+    
+    return NULL;
+}
+
+/*************************************************
+* Function: MSG_DropOldest
+* Description: 
+* Author: cxy 
+* Returns: ZC_RET_OK if a message was dropped
+* Parameter: 
+* History:
+*************************************************/
+u32 MSG_DropOldest(MSG_LaneQueue *pstruQueue, u8 u8Lane)
+{
+    MSG_PoolBuf *pstruBuf;
+
+    MSG_Lock();
+    pstruBuf = MSG_Unlink(pstruQueue, u8Lane);
+    if (NULL == pstruBuf)
+    {
+        MSG_Unlock();
+        return ZC_RET_ERROR;
+    }
+
+    pstruQueue->struStats[u8Lane].u32Dropped++;
+    MSG_ReleaseBuffer(pstruBuf);
+    MSG_Unlock();
+    return ZC_RET_OK;
 }
 
 /*************************************************
@@ -250,9 +632,56 @@ u32 MSG_RecvData(MSG_Buffer *pstruRecvBuffer, u8 *pu8Data, u32 u32DataLen)
     
 
 }
+/*************************************************
+* Function: MSG_DeliverCloudMsg
+* Description: decrypt a whole cloud message into a pool buffer and queue it
+* Author: cxy 
+* Returns: 
+* Parameter: 
+* History:
+*************************************************/
+static void MSG_DeliverCloudMsg(ZC_SecHead *pstruSecHead, u8 *pu8Ciper)
+{
+    MSG_PoolBuf *pstruBuf;
+    u32 u32RetVal;
+    u16 u16PlainLen = 0;
+    u8 u8Lane;
+
+    /*plain text is never longer than the ciper text*/
+    pstruBuf = MSG_AllocBuffer(ZC_HTONS(pstruSecHead->u16TotalMsg));
+    if (NULL == pstruBuf)
+    {
+        g_struRecvQueue.u32NoBuffer++;
+        return;
+    }
+
+    u32RetVal = SEC_Decrypt(pstruSecHead, pu8Ciper, pstruBuf->pu8MsgBuffer, &u16PlainLen);
+    if ((ZC_RET_OK != u32RetVal) || (u16PlainLen < sizeof(ZC_MessageHead)))
+    {
+        g_struRecvQueue.u32BadMsg++;
+        MSG_FreeBuffer(pstruBuf);
+        return;
+    }
+
+    MSG_ShrinkBuffer(pstruBuf, u16PlainLen);
+    u8Lane = MSG_GetLane(pstruBuf->pu8MsgBuffer, u16PlainLen);
+
+    /*the lane is only known once decrypted, so data keeps off the control reserve here*/
+    if ((MSG_LANE_DATA == u8Lane) && (MSG_PoolFreeBlocks() < MSG_POOL_CONTROL_RESERVE))
+    {
+        g_struRecvQueue.struStats[u8Lane].u32Dropped++;
+        MSG_FreeBuffer(pstruBuf);
+        return;
+    }
+    
+    (void)MSG_PushLane(&g_struRecvQueue, pstruBuf, u8Lane);
+}
+
 /*************************************************
 * Function: MSG_RecvDataFromCloud
-* Description: 
+* Description: split the tcp stream into cloud messages. A message
+              wholly inside pu8Data is decrypted where it lies, one split
+              over several recv calls is gathered into a pool buffer.
 * Author: cxy 
 * Returns: 
 * Parameter: 
@@ -260,25 +689,74 @@ u32 MSG_RecvData(MSG_Buffer *pstruRecvBuffer, u8 *pu8Data, u32 u32DataLen)
 *************************************************/
 void MSG_RecvDataFromCloud(u8 *pu8Data, u32 u32DataLen)
 {
-    u32 u32RetVal;
-    u16 u16PlainLen;
-    u32RetVal = MSG_RecvData(&g_struRecvBuffer, pu8Data, u32DataLen);
+    MSG_Reassembly *pstruAsm = &g_struCloudReassembly;
+    ZC_SecHead struSecHead;
+    u32 u32MsgLen;
+    u32 u32CopyLen;
 
-    if (ZC_RET_OK == u32RetVal)
+    while (u32DataLen > 0)
     {
-        if (MSG_BUFFER_FULL == g_struRecvBuffer.u8Status)
+        /*rest of a message there was no buffer for*/
+        if (pstruAsm->u32SkipLen > 0)
         {
-            u32RetVal = SEC_Decrypt((ZC_SecHead*)g_struRecvBuffer.u8MsgBuffer, 
-                g_struRecvBuffer.u8MsgBuffer + sizeof(ZC_SecHead), g_u8MsgBuildBuffer, &u16PlainLen);
+            u32CopyLen = (u32DataLen < pstruAsm->u32SkipLen) ? u32DataLen : pstruAsm->u32SkipLen;
+            pstruAsm->u32SkipLen -= u32CopyLen;
+            pu8Data += u32CopyLen;
+            u32DataLen -= u32CopyLen;
+            continue;
+        }
 
-            /*copy data*/
-            memcpy(g_struRecvBuffer.u8MsgBuffer, g_u8MsgBuildBuffer, u16PlainLen);
+        if (pstruAsm->u16HeadLen < sizeof(ZC_SecHead))
+        {
+            if ((0 == pstruAsm->u16HeadLen) && (u32DataLen >= sizeof(ZC_SecHead)))
+            {
+                memcpy(&struSecHead, pu8Data, sizeof(ZC_SecHead));
+                u32MsgLen = ZC_HTONS(struSecHead.u16TotalMsg) + sizeof(ZC_SecHead);
+                if (u32MsgLen <= u32DataLen)
+                {
+                    MSG_DeliverCloudMsg(&struSecHead, pu8Data + sizeof(ZC_SecHead));
+                    pu8Data += u32MsgLen;
+                    u32DataLen -= u32MsgLen;
+                    continue;
+                }
+            }
 
-            g_struRecvBuffer.u32Len = u16PlainLen;
-            if (ZC_RET_OK == u32RetVal)
+            u32CopyLen = sizeof(ZC_SecHead) - pstruAsm->u16HeadLen;
+            u32CopyLen = (u32DataLen < u32CopyLen) ? u32DataLen : u32CopyLen;
+            memcpy((u8 *)&pstruAsm->struSecHead + pstruAsm->u16HeadLen, pu8Data, u32CopyLen);
+            pstruAsm->u16HeadLen += u32CopyLen;
+            pu8Data += u32CopyLen;
+            u32DataLen -= u32CopyLen;
+            if (pstruAsm->u16HeadLen < sizeof(ZC_SecHead))
             {
-                u32RetVal = MSG_PushMsg(&g_struRecvQueue, (u8*)&g_struRecvBuffer);
+                return;
             }
+
+            pstruAsm->pstruCiper = MSG_AllocBuffer(ZC_HTONS(pstruAsm->struSecHead.u16TotalMsg));
+            if (NULL == pstruAsm->pstruCiper)
+            {
+                g_struRecvQueue.u32NoBuffer++;
+                pstruAsm->u32SkipLen = ZC_HTONS(pstruAsm->struSecHead.u16TotalMsg);
+                pstruAsm->u16HeadLen = 0;
+                continue;
+            }
+            pstruAsm->pstruCiper->u32Len = 0;
+        }
+
+        /*segment straight into its place in the message*/
+        u32CopyLen = ZC_HTONS(pstruAsm->struSecHead.u16TotalMsg) - pstruAsm->pstruCiper->u32Len;
+        u32CopyLen = (u32DataLen < u32CopyLen) ? u32DataLen : u32CopyLen;
+        memcpy(pstruAsm->pstruCiper->pu8MsgBuffer + pstruAsm->pstruCiper->u32Len, pu8Data, u32CopyLen);
+        pstruAsm->pstruCiper->u32Len += u32CopyLen;
+        pu8Data += u32CopyLen;
+        u32DataLen -= u32CopyLen;
+
+        if (pstruAsm->pstruCiper->u32Len == ZC_HTONS(pstruAsm->struSecHead.u16TotalMsg))
+        {
+            MSG_DeliverCloudMsg(&pstruAsm->struSecHead, pstruAsm->pstruCiper->pu8MsgBuffer);
+            MSG_FreeBuffer(pstruAsm->pstruCiper);
+            pstruAsm->pstruCiper = NULL;
+            pstruAsm->u16HeadLen = 0;
         }
     }
     
@@ -296,11 +774,11 @@ void MSG_RecvDataFromCloud(u8 *pu8Data, u32 u32DataLen)
 void MSG_SendDataToCloud(u8 *pu8Connection)
 {
     PTC_Connection *pstruConnection = (PTC_Connection *)pu8Connection;
-    MSG_Buffer *pstruBuf = NULL;
+    MSG_PoolBuf *pstruBuf = NULL;
     ZC_SendParam struParam;
 
     u16 u16DataLen; 
-    pstruBuf = (MSG_Buffer *)MSG_PopMsg(&g_struSendQueue); 
+    pstruBuf = MSG_PopLane(&g_struSendQueue); 
     
     if (NULL == pstruBuf)
     {
@@ -309,11 +787,10 @@ void MSG_SendDataToCloud(u8 *pu8Connection)
     
     u16DataLen = pstruBuf->u32Len; 
     struParam.u8NeedPoll = 0;
-    g_struProtocolController.pstruMoudleFun->pfunSendTcpData(pstruConnection->u32Socket, pstruBuf->u8MsgBuffer, u16DataLen, &struParam);
+    g_struProtocolController.pstruMoudleFun->pfunSendTcpData(pstruConnection->u32Socket, pstruBuf->pu8MsgBuffer, u16DataLen, &struParam);
  
     ZC_Printf("send data len = %d\n", u16DataLen);
-    pstruBuf->u8Status = MSG_BUFFER_IDLE;
-    pstruBuf->u32Len = 0;
+    MSG_FreeBuffer(pstruBuf);
     return;
 }
 
@@ -413,19 +413,19 @@ void PCT_HandleMoudleEvent(u8 *pu8Msg, u16 u16DataLen)
 *************************************************/
 void PCT_RecvAccessMsg2(PTC_ProtocolCon *pstruContoller)
 {
-    MSG_Buffer *pstruBuffer;
+    MSG_PoolBuf *pstruBuffer;
     ZC_MessageHead *pstruMsg;
     ZC_HandShakeMsg2 *pstruMsg2;
     ZC_AccessPoint *pstruAccessPoint;
     u32 u32Addr;
     u16 u16Port;
-    pstruBuffer = (MSG_Buffer *)MSG_PopMsg(&g_struRecvQueue);
+    pstruBuffer = MSG_PopLane(&g_struRecvQueue);
     if (NULL == pstruBuffer)
     {
         return;
     }
 
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
     pstruMsg2 = (ZC_HandShakeMsg2*)(pstruMsg + 1);
 
     if ((ZC_CODE_HANDSHAKE_2 == pstruMsg->MsgCode)||(ZC_CODE_ACCESS_POINT_RSP == pstruMsg->MsgCode))
@@ -468,8 +468,7 @@ void PCT_RecvAccessMsg2(PTC_ProtocolCon *pstruContoller)
         }
     }
     
-    pstruBuffer->u32Len = 0;
-    pstruBuffer->u8Status = MSG_BUFFER_IDLE;
+    MSG_FreeBuffer(pstruBuffer);
 }
 
 /*************************************************
@@ -482,16 +481,16 @@ void PCT_RecvAccessMsg2(PTC_ProtocolCon *pstruContoller)
 *************************************************/
 void PCT_RecvAccessMsg4(PTC_ProtocolCon *pstruContoller)
 {
-    MSG_Buffer *pstruBuffer;
+    MSG_PoolBuf *pstruBuffer;
     ZC_MessageHead *pstruMsg;
     ZC_HandShakeMsg4 *pstruMsg4;
-    pstruBuffer = (MSG_Buffer *)MSG_PopMsg(&g_struRecvQueue);
+    pstruBuffer = MSG_PopLane(&g_struRecvQueue);
     if (NULL == pstruBuffer)
     {
         return;
     }
     
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
     pstruMsg4 = (ZC_HandShakeMsg4 *)(pstruMsg + 1);
     
     if (ZC_CODE_HANDSHAKE_4 == pstruMsg->MsgCode)
@@ -517,8 +516,7 @@ void PCT_RecvAccessMsg4(PTC_ProtocolCon *pstruContoller)
             }
         }
     }
-    pstruBuffer->u32Len = 0;
-    pstruBuffer->u8Status = MSG_BUFFER_IDLE;
+    MSG_FreeBuffer(pstruBuffer);
 
     if (PCT_TIMER_INVAILD != pstruContoller->u8HeartTimer)
     {
@@ -538,15 +536,15 @@ void PCT_RecvAccessMsg4(PTC_ProtocolCon *pstruContoller)
 *************************************************/
 void PCT_HandleUnbindMsg(PTC_ProtocolCon *pstruContoller)
 {
-    MSG_Buffer *pstruBuffer;
+    MSG_PoolBuf *pstruBuffer;
     ZC_MessageHead *pstruMsg;
-    pstruBuffer = (MSG_Buffer *)MSG_PopMsg(&g_struRecvQueue);
+    pstruBuffer = MSG_PopLane(&g_struRecvQueue);
     if (NULL == pstruBuffer)
     {
         return;
     }
     
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
     
     if (ZC_CODE_UNBIND == pstruMsg->MsgCode)
     {
@@ -559,8 +557,7 @@ void PCT_HandleUnbindMsg(PTC_ProtocolCon *pstruContoller)
         ZC_ConfigUnBind(0xFFFFFFFF);
         ZC_Printf("recv unbind resp ok\n");
     }
-    pstruBuffer->u32Len = 0;
-    pstruBuffer->u8Status = MSG_BUFFER_IDLE;
+    MSG_FreeBuffer(pstruBuffer);
 
     pstruContoller->pstruMoudleFun->pfunSetTimer(PCT_TIMER_SENDHEART, 
         PCT_TIMER_INTERVAL_HEART, &pstruContoller->u8HeartTimer);
@@ -626,11 +623,11 @@ void PCT_SendAckToCloud(u8 u8MsgId)
 * Parameter: 
 * History:
 *************************************************/
-void PCT_HandleOtaBeginMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer)
+void PCT_HandleOtaBeginMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer)
 {
     ZC_MessageHead *pstruMsg;
     ZC_Printf("Ota Begin\n");
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
     PCT_SendAckToCloud(pstruMsg->MsgId);    
     
     PCT_SendNotifyMsg(ZC_CODE_ZOTA_BEGIN);
@@ -751,14 +748,14 @@ void PCT_ModuleOtaFileEndMsg(PTC_ProtocolCon *pstruContoller, u8 *pu8Msg)
 * Parameter: 
 * History:
 *************************************************/
-void PCT_HandleOtaFileBeginMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer)
+void PCT_HandleOtaFileBeginMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer)
 {
     ZC_MessageHead *pstruMsg;
     ZC_OtaFileBeginReq *pstruOta;
     ZC_Printf("Ota File Begin\n");
     
 
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
     pstruOta = (ZC_OtaFileBeginReq *)(pstruMsg + 1);
     
     pstruContoller->struOtaInfo.u32RecvOffset = 0;
@@ -778,7 +775,7 @@ void PCT_HandleOtaFileBeginMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstr
 * Parameter: 
 * History:
 *************************************************/
-void PCT_HandleOtaFileChunkMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer)
+void PCT_HandleOtaFileChunkMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer)
 {
     ZC_MessageHead *pstruMsg;
     ZC_OtaFileChunkReq *pstruOta;
@@ -789,7 +786,7 @@ void PCT_HandleOtaFileChunkMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstr
     ZC_Printf("Ota File Chunk\n");
 
     
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
     pstruOta = (ZC_OtaFileChunkReq *)(pstruMsg + 1);
     u32FileLen = ZC_HTONS(pstruMsg->Payloadlen) - sizeof(ZC_OtaFileChunkReq);
     u32RecvOffset = ZC_HTONL(pstruOta->u32Offset);
@@ -830,12 +827,12 @@ void PCT_HandleOtaFileChunkMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstr
 * Parameter: 
 * History:
 *************************************************/
-void PCT_HandleOtaFileEndMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer)
+void PCT_HandleOtaFileEndMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer)
 {
     ZC_MessageHead *pstruMsg;
     ZC_Printf("Ota File End\n");
 
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
     PCT_SendAckToCloud(pstruMsg->MsgId);
 
 }
@@ -847,13 +844,13 @@ void PCT_HandleOtaFileEndMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruB
 * Parameter: 
 * History:
 *************************************************/
-void PCT_HandleOtaEndMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer)
+void PCT_HandleOtaEndMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer)
 {
     ZC_MessageHead *pstruMsg;
     u32 u32RetVal;
     ZC_Printf("Ota End\n");
 
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
     u32RetVal = pstruContoller->pstruMoudleFun->pfunUpdateFinish(pstruContoller->struOtaInfo.u32TotalLen);
     if (ZC_RET_ERROR == u32RetVal)
     {
@@ -876,10 +873,10 @@ void PCT_HandleOtaEndMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffe
 * Parameter: 
 * History:
 *************************************************/
-void PCT_HandleMoudleMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer)
+void PCT_HandleMoudleMsg(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer)
 {
     ZC_MessageHead *pstruMsg;
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
 
     if((pstruMsg->MsgCode < ZC_CODE_OTA_BEGIN)||(pstruMsg->MsgCode > ZC_CODE_OTA_END))
     {
@@ -909,12 +906,12 @@ void PCT_HandleMoudleMsg(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffe
 * Parameter: 
 * History:
 *************************************************/
-void PCT_SetTokenKey(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer)
+void PCT_SetTokenKey(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer)
 {
     ZC_MessageHead *pstruMsg;
     ZC_TokenSetReq *pstruSetKey;
 
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
     pstruSetKey = (ZC_TokenSetReq *)(pstruMsg + 1);
 
     ZC_StoreTokenKey(pstruSetKey->TokenKey);
@@ -933,11 +930,11 @@ void PCT_SetTokenKey(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer)
 * Parameter: 
 * History:
 *************************************************/
-void PCT_ResetNetWork(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer)
+void PCT_ResetNetWork(PTC_ProtocolCon *pstruContoller, MSG_PoolBuf *pstruBuffer)
 {
     ZC_MessageHead *pstruMsg;
 
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
 
     ZC_ConfigInitPara();
     PCT_DisConnectCloud(pstruContoller);
@@ -958,7 +955,7 @@ void PCT_ResetNetWork(PTC_ProtocolCon *pstruContoller, MSG_Buffer *pstruBuffer)
 *************************************************/
 void PCT_HandleEvent(PTC_ProtocolCon *pstruContoller)
 {
-    MSG_Buffer *pstruBuffer;
+    MSG_PoolBuf *pstruBuffer;
     ZC_MessageHead *pstruMsg;
     
 	if (ZC_MAGIC_FLAG == g_struZcConfigDb.struDeviceInfo.u32UnBindFlag)
@@ -971,13 +968,13 @@ void PCT_HandleEvent(PTC_ProtocolCon *pstruContoller)
         PCT_SendUnbindMsg();
         return;
     }
-    pstruBuffer = (MSG_Buffer *)MSG_PopMsg(&g_struRecvQueue);
+    pstruBuffer = MSG_PopLane(&g_struRecvQueue);
     if (NULL == pstruBuffer)
     {
         return;
     }
     
-    pstruMsg = (ZC_MessageHead*)pstruBuffer->u8MsgBuffer;
+    pstruMsg = (ZC_MessageHead*)pstruBuffer->pu8MsgBuffer;
     ZC_Printf("event %d recv len =%d\n", pstruMsg->MsgId, ZC_HTONS(pstruMsg->Payloadlen) + sizeof(ZC_MessageHead));
     ZC_TraceData((u8*)pstruMsg, ZC_HTONS(pstruMsg->Payloadlen) + sizeof(ZC_MessageHead));
     if (ZC_RET_ERROR == PCT_CheckCrc(pstruMsg->TotalMsgCrc, (u8*)(pstruMsg + 1), ZC_HTONS(pstruMsg->Payloadlen)))
@@ -985,8 +982,7 @@ void PCT_HandleEvent(PTC_ProtocolCon *pstruContoller)
         PCT_SendEmptyMsg(pstruMsg->MsgId, ZC_SEC_ALG_AES);
         PCT_SendErrorMsg(pstruMsg->MsgId, NULL, 0);
 
-        pstruBuffer->u32Len = 0;
-        pstruBuffer->u8Status = MSG_BUFFER_IDLE;
+        MSG_FreeBuffer(pstruBuffer);
         
         return;
     }
@@ -1030,8 +1026,7 @@ void PCT_HandleEvent(PTC_ProtocolCon *pstruContoller)
             break;                                    
     }
 
-    pstruBuffer->u32Len = 0;
-    pstruBuffer->u8Status = MSG_BUFFER_IDLE;
+    MSG_FreeBuffer(pstruBuffer);
 
     
     return;
@@ -1140,52 +1135,59 @@ void PCT_Sleep()
 *************************************************/
 u32 PCT_SendMsgToCloud(ZC_SecHead *pstruSecHead, u8 *pu8PlainData)
 {
-    u32 u32Index;
+    MSG_PoolBuf *pstruBuf;
     u32 u32RetVal;
+    u32 u32CiperLen;
+    u16 u16PlainLen;
     u16 u16Len;
     u16 u16PaddingLen;
+    u8 u8Lane;
     
-    u32RetVal = SEC_PaddingCheck(pstruSecHead->u8SecType, ZC_HTONS(pstruSecHead->u16TotalMsg), &u16PaddingLen);
+    u16PlainLen = ZC_HTONS(pstruSecHead->u16TotalMsg);
+    u32RetVal = SEC_PaddingCheck(pstruSecHead->u8SecType, u16PlainLen, &u16PaddingLen);
     
     if (ZC_RET_ERROR == u32RetVal)
     {
         return ZC_RET_ERROR;
     }
 
-    u16Len = ZC_HTONS(pstruSecHead->u16TotalMsg) + sizeof(ZC_SecHead) + u16PaddingLen;    
-    
-    if (u16Len > MSG_BUFFER_MAXLEN)
+    /*rsa puts at most keylen - 11 plain bytes in each keylen block*/
+    u32CiperLen = u16PlainLen + u16PaddingLen;
+    if (ZC_SEC_ALG_RSA == pstruSecHead->u8SecType)
     {
-        return ZC_RET_ERROR;
+        u32CiperLen = (u16PlainLen / ((ZC_SEC_RSA_KEY_LEN >> 3) - 11) + 1) * (ZC_SEC_RSA_KEY_LEN >> 3);
     }
 
-    for (u32Index = 0; u32Index < MSG_BUFFER_SEND_MAX_NUM; u32Index++)
+    /*control goes out even if queued data has to make room for it*/
+    u8Lane = MSG_GetLane(pu8PlainData, u16PlainLen);
+    pstruBuf = MSG_AllocBuffer(u32CiperLen + sizeof(ZC_SecHead));
+    while ((NULL == pstruBuf) && (MSG_LANE_CONTROL == u8Lane)
+        && (ZC_RET_OK == MSG_DropOldest(&g_struSendQueue, MSG_LANE_DATA)))
     {
-        if (MSG_BUFFER_IDLE == g_struSendBuffer[u32Index].u8Status)
-        {
-            u16Len = ZC_HTONS(pstruSecHead->u16TotalMsg) + u16PaddingLen;
-
-            /*first check padding,then Encrypt, final copy sechead*/
-            u32RetVal = SEC_Encrypt(pstruSecHead, g_struSendBuffer[u32Index].u8MsgBuffer + sizeof(ZC_SecHead), pu8PlainData, &u16Len);
-            
-            if (ZC_RET_ERROR == u32RetVal)
-            {
-                return ZC_RET_ERROR;
-            }
-            
-            pstruSecHead->u16TotalMsg = ZC_HTONS(u16Len);
-            /*copy sechead*/
-            memcpy(g_struSendBuffer[u32Index].u8MsgBuffer, (u8*)pstruSecHead, sizeof(ZC_SecHead));
-        
-            g_struSendBuffer[u32Index].u32Len = u16Len + sizeof(ZC_SecHead);
-            g_struSendBuffer[u32Index].u8Status = MSG_BUFFER_FULL;
-            MSG_PushMsg(&g_struSendQueue, (u8*)&g_struSendBuffer[u32Index]);
+        pstruBuf = MSG_AllocBuffer(u32CiperLen + sizeof(ZC_SecHead));
+    }
+    if (NULL == pstruBuf)
+    {
+        g_struSendQueue.u32NoBuffer++;
+        return ZC_RET_ERROR;
+    }
 
-            return ZC_RET_OK;
-        }
+    /*first check padding,then Encrypt, final copy sechead*/
+    u16Len = u16PlainLen + u16PaddingLen;
+    u32RetVal = SEC_Encrypt(pstruSecHead, pstruBuf->pu8MsgBuffer + sizeof(ZC_SecHead), pu8PlainData, &u16Len);
+    
+    if (ZC_RET_ERROR == u32RetVal)
+    {
+        MSG_FreeBuffer(pstruBuf);
+        return ZC_RET_ERROR;
     }
+    
+    pstruSecHead->u16TotalMsg = ZC_HTONS(u16Len);
+    /*copy sechead*/
+    memcpy(pstruBuf->pu8MsgBuffer, (u8*)pstruSecHead, sizeof(ZC_SecHead));
 
-    return ZC_RET_ERROR;
+    pstruBuf->u32Len = u16Len + sizeof(ZC_SecHead);
+    return MSG_PushLane(&g_struSendQueue, pstruBuf, u8Lane);
 }
 
 /******************************* FILE END ***********************************/
@@ -10,6 +10,72 @@
 #include <zc_sec_engine.h>
 #include <zc_protocol_controller.h>
 
+typedef struct
+{
+    rsa_context struRsa;
+    u8 u8Valid;
+    u8 u8Key[ZC_SEC_RSA_PRIVATE_KEY_LEN];    /*key the context was built from*/
+}SEC_RsaCache;
+
+SEC_RsaCache g_struSecCloudRsa;
+SEC_RsaCache g_struSecDeviceRsa;
+
+/*************************************************
+* Function: SEC_GetRsaContext
+* Description: Returns the context of the cloud public key or of the
+*              device private key, parsed and precomputed once per key.
+*              The key store is compared on each call, so a new key
+*              replaces the cached context.
+* Author: cxy
+* Returns: NULL if the key cannot be used
+* Parameter: ZC_GET_TYPE_CLOUDKEY or ZC_GET_TYPE_PRIVATEKEY
+* History:
+*************************************************/
+static rsa_context *SEC_GetRsaContext(u8 u8Type)
+{
+    SEC_RsaCache *pstruCache;
+    u8 *pu8Key;
+    u16 u16KeyLen;
+
+    if (ZC_GET_TYPE_PRIVATEKEY == u8Type)
+    {
+        pstruCache = &g_struSecDeviceRsa;
+        u16KeyLen = ZC_SEC_RSA_PRIVATE_KEY_LEN;
+    }
+    else
+    {
+        pstruCache = &g_struSecCloudRsa;
+        u16KeyLen = ZC_SEC_RSA_PUBLIC_KEY_LEN;
+    }
+
+    ZC_GetStoreInfor(u8Type, &pu8Key);
+    if (pstruCache->u8Valid && 0 == memcmp(pstruCache->u8Key, pu8Key, u16KeyLen))
+    {
+        return &pstruCache->struRsa;
+    }
+
+    pstruCache->u8Valid = 0;
+    rsa_free(&pstruCache->struRsa);
+    if (ZC_GET_TYPE_PRIVATEKEY == u8Type)
+    {
+        SEC_InitRsaContextWithPrivateKey(&pstruCache->struRsa, pu8Key);
+    }
+    else
+    {
+        SEC_InitRsaContextWithPublicKey(&pstruCache->struRsa, pu8Key);
+    }
+
+    if (rsa_precompute(&pstruCache->struRsa))
+    {
+        rsa_free(&pstruCache->struRsa);
+        return NULL;
+    }
+
+    memcpy(pstruCache->u8Key, pu8Key, u16KeyLen);
+    pstruCache->u8Valid = 1;
+    return &pstruCache->struRsa;
+}
+
 /*************************************************
 * Function: SEC_EncryptTextByRsa
 * Description:
@@ -22,15 +88,15 @@ u32 SEC_EncryptTextByRsa(u8* pu8CiperBuf, u8 *pu8Plainbuf, u16 u16Len, u16 *pu16
 {
 #if 1
     s32 s32Ret;
-    u8 *pu8PublicKey;
     u16 u16ReadLen;
     rsa_context *rsa;
 
-
-    rsa = (rsa_context *)ZC_malloc(sizeof(rsa_context));
-    ZC_GetStoreInfor(ZC_GET_TYPE_CLOUDKEY, &pu8PublicKey);
-
-    SEC_InitRsaContextWithPublicKey(rsa, pu8PublicKey);
+    rsa = SEC_GetRsaContext(ZC_GET_TYPE_CLOUDKEY);
+    if (NULL == rsa)
+    {
+        *pu16CiperLen = 0;
+        return ZC_RET_ERROR;
+    }
 
     if (u16Len + 11 > rsa->len)
     {
@@ -60,9 +126,6 @@ u32 SEC_EncryptTextByRsa(u8* pu8CiperBuf, u8 *pu8Plainbuf, u16 u16Len, u16 *pu16
         s32Ret = rsa_pkcs1_encrypt(rsa, RSA_PUBLIC, u16Len, pu8Plainbuf, pu8CiperBuf);
         *pu16CiperLen = rsa->len;
     }
-   
-    rsa_free(rsa);
-    ZC_free(rsa);
 
     if (s32Ret)
     {
@@ -90,14 +153,13 @@ u32 SEC_DecryptTextByRsa(u8* pu8CiperBuf, u8 *pu8Plainbuf, u16 u16Len, u16 *pu16
     s32 s32len;
     s32 s32Ret;
     u16 u16ReadLen;
-    u8 *pu8PrivateKey;
-    
-    pstruRsa = (rsa_context *)ZC_malloc(sizeof(rsa_context));
-
-    ZC_GetStoreInfor(ZC_GET_TYPE_PRIVATEKEY, &pu8PrivateKey);
-
 
-    SEC_InitRsaContextWithPrivateKey(pstruRsa, pu8PrivateKey);
+    pstruRsa = SEC_GetRsaContext(ZC_GET_TYPE_PRIVATEKEY);
+    if (NULL == pstruRsa)
+    {
+        *pu16PlainLen = 0;
+        return ZC_RET_ERROR;
+    }
 
     if (u16Len > pstruRsa->len)
     {
@@ -132,9 +194,6 @@ u32 SEC_DecryptTextByRsa(u8* pu8CiperBuf, u8 *pu8Plainbuf, u16 u16Len, u16 *pu16
     }
     
     ZC_Printf("rsa_pkcs1_decrypt = %d, u32RetVal = %d\n", s32len, s32Ret);
-    rsa_free(pstruRsa);
-    
-    ZC_free(pstruRsa);
 
     if (s32Ret)
     {
@@ -0,0 +1,279 @@
+
+/*
+ * ChaCha20-Poly1305 AEAD, original construction (64-bit nonce) as in
+ * libsodium's crypto_aead_chacha20poly1305:
+ *
+ *   poly1305 key = first 32 bytes of the ChaCha20 block 0
+ *   c            = m ^ ChaCha20 keystream from block 1
+ *   mac          = Poly1305(ad || LE64(adlen) || c || LE64(clen))
+ *
+ * The length of each part comes right after it, so the MAC can be computed
+ * while the data streams through: init, update_ad* then encrypt_update* (or
+ * decrypt_update*), final.
+ */
+
+#include <string.h>
+
+#include "chacha20.h"
+#include "poly1305.h"
+#include "MICOCrypto/crypto_aead_chacha20poly1305.h"
+
+typedef struct aead_state {
+    chacha20_ctx       chacha;
+    poly1305_state     poly;
+    unsigned long long adlen;
+    unsigned long long mlen;
+    int                phase;
+} aead_state;
+
+enum {
+    AEAD_PHASE_AD = 0,
+    AEAD_PHASE_MESSAGE,
+    AEAD_PHASE_DONE
+};
+
+/* crypto_aead_chacha20poly1305_state must be able to hold an aead_state */
+typedef char aead_state_fits[(sizeof(aead_state) <= sizeof(crypto_aead_chacha20poly1305_state)) ? 1 : -1];
+
+#define STORE64_LE(p, v)                                                    \
+    do {                                                                    \
+        int i_;                                                             \
+        for (i_ = 0; i_ < 8; i_++) {                                        \
+            (p)[i_] = (unsigned char) ((v) >> (8 * i_));                    \
+        }                                                                   \
+    } while (0)
+
+size_t
+crypto_aead_chacha20poly1305_keybytes(void)
+{
+    return crypto_aead_chacha20poly1305_KEYBYTES;
+}
+
+size_t
+crypto_aead_chacha20poly1305_nsecbytes(void)
+{
+    return crypto_aead_chacha20poly1305_NSECBYTES;
+}
+
+size_t
+crypto_aead_chacha20poly1305_npubbytes(void)
+{
+    return crypto_aead_chacha20poly1305_NPUBBYTES;
+}
+
+size_t
+crypto_aead_chacha20poly1305_abytes(void)
+{
+    return crypto_aead_chacha20poly1305_ABYTES;
+}
+
+size_t
+crypto_aead_chacha20poly1305_statebytes(void)
+{
+    return sizeof(crypto_aead_chacha20poly1305_state);
+}
+
+int
+crypto_aead_chacha20poly1305_init(crypto_aead_chacha20poly1305_state *state_,
+                                  const unsigned char *npub,
+                                  const unsigned char *k)
+{
+    aead_state   *state = (aead_state *) (void *) state_;
+    unsigned char block0[CHACHA20_BLOCKBYTES];
+
+    chacha20_init(&state->chacha, k, npub, 0U);
+    chacha20_xor(&state->chacha, block0, NULL, sizeof block0);
+    poly1305_init(&state->poly, block0);
+    memset(block0, 0, sizeof block0);
+
+    state->adlen = 0U;
+    state->mlen = 0U;
+    state->phase = AEAD_PHASE_AD;
+
+    return 0;
+}
+
+int
+crypto_aead_chacha20poly1305_update_ad(crypto_aead_chacha20poly1305_state *state_,
+                                       const unsigned char *ad,
+                                       unsigned long long adlen)
+{
+    aead_state *state = (aead_state *) (void *) state_;
+
+    if (state->phase != AEAD_PHASE_AD) {
+        return -1;
+    }
+    if (adlen > 0U) {
+        poly1305_update(&state->poly, ad, adlen);
+        state->adlen += adlen;
+    }
+    return 0;
+}
+
+/* Closes the associated data the first time message bytes arrive. */
+static int
+aead_begin_message(aead_state *state)
+{
+    unsigned char slen[8];
+
+    if (state->phase == AEAD_PHASE_AD) {
+        STORE64_LE(slen, state->adlen);
+        poly1305_update(&state->poly, slen, sizeof slen);
+        state->phase = AEAD_PHASE_MESSAGE;
+    }
+    return (state->phase == AEAD_PHASE_MESSAGE) ? 0 : -1;
+}
+
+int
+crypto_aead_chacha20poly1305_encrypt_update(crypto_aead_chacha20poly1305_state *state_,
+                                            unsigned char *c,
+                                            const unsigned char *m,
+                                            unsigned long long mlen)
+{
+    aead_state *state = (aead_state *) (void *) state_;
+
+    if (aead_begin_message(state) != 0) {
+        return -1;
+    }
+    if (mlen > 0U) {
+        chacha20_xor(&state->chacha, c, m, mlen);
+        poly1305_update(&state->poly, c, mlen);
+        state->mlen += mlen;
+    }
+    return 0;
+}
+
+int
+crypto_aead_chacha20poly1305_decrypt_update(crypto_aead_chacha20poly1305_state *state_,
+                                            unsigned char *m,
+                                            const unsigned char *c,
+                                            unsigned long long clen)
+{
+    aead_state *state = (aead_state *) (void *) state_;
+
+    if (aead_begin_message(state) != 0) {
+        return -1;
+    }
+    if (clen > 0U) {
+        /* MAC first, m may be the same buffer as c */
+        poly1305_update(&state->poly, c, clen);
+        chacha20_xor(&state->chacha, m, c, clen);
+        state->mlen += clen;
+    }
+    return 0;
+}
+
+int
+crypto_aead_chacha20poly1305_encrypt_final(crypto_aead_chacha20poly1305_state *state_,
+                                           unsigned char *mac)
+{
+    aead_state   *state = (aead_state *) (void *) state_;
+    unsigned char slen[8];
+
+    if (aead_begin_message(state) != 0) {
+        return -1;
+    }
+    STORE64_LE(slen, state->mlen);
+    poly1305_update(&state->poly, slen, sizeof slen);
+    poly1305_final(&state->poly, mac);
+    memset(&state->chacha, 0, sizeof state->chacha);
+    state->phase = AEAD_PHASE_DONE;
+
+    return 0;
+}
+
+int
+crypto_aead_chacha20poly1305_decrypt_final(crypto_aead_chacha20poly1305_state *state_,
+                                           const unsigned char *mac)
+{
+    unsigned char computed[crypto_aead_chacha20poly1305_ABYTES];
+    unsigned int  diff = 0U;
+    unsigned int  i;
+
+    if (crypto_aead_chacha20poly1305_encrypt_final(state_, computed) != 0) {
+        return -1;
+    }
+    for (i = 0U; i < sizeof computed; i++) {
+        diff |= computed[i] ^ mac[i];
+    }
+    memset(computed, 0, sizeof computed);
+
+    return (int) ((1U & ((diff - 1U) >> 8)) - 1U);
+}
+
+int
+crypto_aead_chacha20poly1305_encrypt(unsigned char *c,
+                                     unsigned long long *clen,
+                                     const unsigned char *m,
+                                     unsigned long long mlen,
+                                     const unsigned char *ad,
+                                     unsigned long long adlen,
+                                     const unsigned char *nsec,
+                                     const unsigned char *npub,
+                                     const unsigned char *k)
+{
+    crypto_aead_chacha20poly1305_state state;
+
+    (void) nsec;
+    crypto_aead_chacha20poly1305_init(&state, npub, k);
+    crypto_aead_chacha20poly1305_update_ad(&state, ad, adlen);
+    crypto_aead_chacha20poly1305_encrypt_update(&state, c, m, mlen);
+    crypto_aead_chacha20poly1305_encrypt_final(&state, c + mlen);
+    if (clen != NULL) {
+        *clen = mlen + crypto_aead_chacha20poly1305_ABYTES;
+    }
+    return 0;
+}
+
+int
+crypto_aead_chacha20poly1305_decrypt(unsigned char *m,
+                                     unsigned long long *mlen,
+                                     unsigned char *nsec,
+                                     const unsigned char *c,
+                                     unsigned long long clen,
+                                     const unsigned char *ad,
+                                     unsigned long long adlen,
+                                     const unsigned char *npub,
+                                     const unsigned char *k)
+{
+    crypto_aead_chacha20poly1305_state state;
+    aead_state        *st = (aead_state *) (void *) &state;
+    unsigned char      slen[8];
+    unsigned char      computed[crypto_aead_chacha20poly1305_ABYTES];
+    unsigned long long body;
+    unsigned int       diff = 0U;
+    unsigned int       i;
+
+    (void) nsec;
+    if (mlen != NULL) {
+        *mlen = 0U;
+    }
+    if (clen < crypto_aead_chacha20poly1305_ABYTES) {
+        return -1;
+    }
+    body = clen - crypto_aead_chacha20poly1305_ABYTES;
+
+    /* verify before anything is written to m */
+    crypto_aead_chacha20poly1305_init(&state, npub, k);
+    crypto_aead_chacha20poly1305_update_ad(&state, ad, adlen);
+    aead_begin_message(st);
+    poly1305_update(&st->poly, c, body);
+    STORE64_LE(slen, body);
+    poly1305_update(&st->poly, slen, sizeof slen);
+    poly1305_final(&st->poly, computed);
+    for (i = 0U; i < sizeof computed; i++) {
+        diff |= computed[i] ^ c[body + i];
+    }
+    memset(computed, 0, sizeof computed);
+    if (diff != 0U) {
+        memset(&state, 0, sizeof state);
+        return -1;
+    }
+
+    chacha20_xor(&st->chacha, m, c, body);
+    memset(&state, 0, sizeof state);
+    if (mlen != NULL) {
+        *mlen = body;
+    }
+    return 0;
+}
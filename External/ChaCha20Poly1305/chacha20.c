@@ -0,0 +1,239 @@
+
+/*
+ * ChaCha20 stream cipher (D. J. Bernstein), 64-bit counter and nonce variant
+ * behind crypto_stream_chacha20_*.
+ */
+
+#include <string.h>
+
+#include "chacha20.h"
+#include "MICOCrypto/crypto_stream_chacha20.h"
+
+#define LOAD32_LE(p)                                                        \
+    (((uint32_t) (p)[0]) | ((uint32_t) (p)[1] << 8) |                       \
+     ((uint32_t) (p)[2] << 16) | ((uint32_t) (p)[3] << 24))
+
+#define STORE32_LE(p, v)                                                    \
+    do {                                                                    \
+        (p)[0] = (unsigned char) (v);                                       \
+        (p)[1] = (unsigned char) ((v) >> 8);                                \
+        (p)[2] = (unsigned char) ((v) >> 16);                               \
+        (p)[3] = (unsigned char) ((v) >> 24);                               \
+    } while (0)
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTERROUND(a, b, c, d)                                            \
+    a += b; d = ROTL32(d ^ a, 16);                                          \
+    c += d; b = ROTL32(b ^ c, 12);                                          \
+    a += b; d = ROTL32(d ^ a, 8);                                           \
+    c += d; b = ROTL32(b ^ c, 7)
+
+#define DOUBLEROUND(x)                                                      \
+    do {                                                                    \
+        QUARTERROUND(x[0], x[4], x[8],  x[12]);                             \
+        QUARTERROUND(x[1], x[5], x[9],  x[13]);                             \
+        QUARTERROUND(x[2], x[6], x[10], x[14]);                             \
+        QUARTERROUND(x[3], x[7], x[11], x[15]);                             \
+        QUARTERROUND(x[0], x[5], x[10], x[15]);                             \
+        QUARTERROUND(x[1], x[6], x[11], x[12]);                             \
+        QUARTERROUND(x[2], x[7], x[8],  x[13]);                             \
+        QUARTERROUND(x[3], x[4], x[9],  x[14]);                             \
+    } while (0)
+
+static void
+chacha20_counter_add(uint32_t input[16], uint32_t blocks)
+{
+    input[12] += blocks;
+    if (input[12] < blocks) {
+        input[13]++;
+    }
+}
+
+/* One block at input's counter, xored into c (or stored when m is NULL). */
+static void
+chacha20_block(uint32_t input[16], unsigned char *c, const unsigned char *m)
+{
+    uint32_t x[16];
+    uint32_t i;
+
+    memcpy(x, input, sizeof x);
+    for (i = 0; i < 10; i++) {
+        DOUBLEROUND(x);
+    }
+    for (i = 0; i < 16; i++) {
+        x[i] += input[i];
+        if (m != NULL) {
+            x[i] ^= LOAD32_LE(m + 4 * i);
+        }
+        STORE32_LE(c + 4 * i, x[i]);
+    }
+    chacha20_counter_add(input, 1);
+}
+
+#if CHACHA20_LANES > 1
+
+typedef uint32_t chacha20_vec __attribute__((vector_size(4 * CHACHA20_LANES)));
+
+/* CHACHA20_LANES consecutive blocks: lane j of x[i] is word i of block j. */
+static void
+chacha20_lanes(uint32_t input[16], unsigned char *c, const unsigned char *m)
+{
+    chacha20_vec x[16], orig[16];
+    uint32_t     words[16][CHACHA20_LANES];
+    uint32_t     i, j, w;
+
+    for (i = 0; i < 16; i++) {
+        x[i] = (chacha20_vec) { 0 } + input[i];
+    }
+    orig[12] = x[12];
+    for (j = 0; j < CHACHA20_LANES; j++) {
+        x[12][j] += j;
+    }
+    /* lanes whose low counter word wrapped carry into the high word */
+    x[13] -= (chacha20_vec) (x[12] < orig[12]);
+    memcpy(orig, x, sizeof x);
+
+    for (i = 0; i < 10; i++) {
+        DOUBLEROUND(x);
+    }
+    for (i = 0; i < 16; i++) {
+        x[i] += orig[i];
+    }
+    memcpy(words, x, sizeof words);
+
+    for (j = 0; j < CHACHA20_LANES; j++) {
+        for (i = 0; i < 16; i++) {
+            w = words[i][j];
+            if (m != NULL) {
+                w ^= LOAD32_LE(m + 64 * j + 4 * i);
+            }
+            STORE32_LE(c + 64 * j + 4 * i, w);
+        }
+    }
+    chacha20_counter_add(input, CHACHA20_LANES);
+}
+
+#endif
+
+void
+chacha20_init(chacha20_ctx *ctx, const unsigned char *k,
+              const unsigned char *n, uint64_t ic)
+{
+    uint32_t i;
+
+    ctx->input[0] = 0x61707865;
+    ctx->input[1] = 0x3320646e;
+    ctx->input[2] = 0x79622d32;
+    ctx->input[3] = 0x6b206574;
+    for (i = 0; i < 8; i++) {
+        ctx->input[4 + i] = LOAD32_LE(k + 4 * i);
+    }
+    ctx->input[12] = (uint32_t) ic;
+    ctx->input[13] = (uint32_t) (ic >> 32);
+    ctx->input[14] = LOAD32_LE(n);
+    ctx->input[15] = LOAD32_LE(n + 4);
+    ctx->keystream_left = 0;
+}
+
+void
+chacha20_xor(chacha20_ctx *ctx, unsigned char *c, const unsigned char *m,
+             unsigned long long mlen)
+{
+    unsigned char *ks;
+    size_t         i, todo;
+
+    if (ctx->keystream_left > 0) {
+        ks = ctx->keystream + CHACHA20_BLOCKBYTES - ctx->keystream_left;
+        todo = (mlen < ctx->keystream_left) ? (size_t) mlen : ctx->keystream_left;
+        for (i = 0; i < todo; i++) {
+            c[i] = (m != NULL) ? (unsigned char) (m[i] ^ ks[i]) : ks[i];
+        }
+        ctx->keystream_left -= todo;
+        c += todo;
+        if (m != NULL) {
+            m += todo;
+        }
+        mlen -= todo;
+    }
+#if CHACHA20_LANES > 1
+    while (mlen >= CHACHA20_LANES * CHACHA20_BLOCKBYTES) {
+        chacha20_lanes(ctx->input, c, m);
+        c += CHACHA20_LANES * CHACHA20_BLOCKBYTES;
+        if (m != NULL) {
+            m += CHACHA20_LANES * CHACHA20_BLOCKBYTES;
+        }
+        mlen -= CHACHA20_LANES * CHACHA20_BLOCKBYTES;
+    }
+#endif
+    while (mlen >= CHACHA20_BLOCKBYTES) {
+        chacha20_block(ctx->input, c, m);
+        c += CHACHA20_BLOCKBYTES;
+        if (m != NULL) {
+            m += CHACHA20_BLOCKBYTES;
+        }
+        mlen -= CHACHA20_BLOCKBYTES;
+    }
+    if (mlen > 0) {
+        chacha20_block(ctx->input, ctx->keystream, NULL);
+        for (i = 0; i < (size_t) mlen; i++) {
+            c[i] = (m != NULL) ? (unsigned char) (m[i] ^ ctx->keystream[i])
+                               : ctx->keystream[i];
+        }
+        ctx->keystream_left = CHACHA20_BLOCKBYTES - (size_t) mlen;
+    }
+}
+
+size_t
+crypto_stream_chacha20_keybytes(void)
+{
+    return crypto_stream_chacha20_KEYBYTES;
+}
+
+size_t
+crypto_stream_chacha20_noncebytes(void)
+{
+    return crypto_stream_chacha20_NONCEBYTES;
+}
+
+int
+crypto_stream_chacha20(unsigned char *c, unsigned long long clen,
+                       const unsigned char *n, const unsigned char *k)
+{
+    chacha20_ctx ctx;
+
+    if (!clen) {
+        return 0;
+    }
+    chacha20_init(&ctx, k, n, 0U);
+    chacha20_xor(&ctx, c, NULL, clen);
+    memset(&ctx, 0, sizeof ctx);
+
+    return 0;
+}
+
+int
+crypto_stream_chacha20_xor_ic(unsigned char *c, const unsigned char *m,
+                              unsigned long long mlen,
+                              const unsigned char *n, uint64_t ic,
+                              const unsigned char *k)
+{
+    chacha20_ctx ctx;
+
+    if (!mlen) {
+        return 0;
+    }
+    chacha20_init(&ctx, k, n, ic);
+    chacha20_xor(&ctx, c, m, mlen);
+    memset(&ctx, 0, sizeof ctx);
+
+    return 0;
+}
+
+int
+crypto_stream_chacha20_xor(unsigned char *c, const unsigned char *m,
+                           unsigned long long mlen, const unsigned char *n,
+                           const unsigned char *k)
+{
+    return crypto_stream_chacha20_xor_ic(c, m, mlen, n, 0U, k);
+}
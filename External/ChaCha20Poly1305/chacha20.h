@@ -0,0 +1,53 @@
+
+#ifndef chacha20_H
+#define chacha20_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * ChaCha20 as used by crypto_stream_chacha20 and crypto_aead_chacha20poly1305:
+ * 256-bit key, 64-bit block counter (words 12-13), 64-bit nonce (words 14-15).
+ *
+ * The block function has a scalar version and a version computing
+ * CHACHA20_LANES blocks at once, one block per vector lane, written with the
+ * GCC vector extensions so the same code becomes SSE2 (4 lanes), AVX2
+ * (8 lanes) or NEON (4 lanes) depending on the target flags. Targets without
+ * any of them (Cortex-M) use the scalar code only. Build with
+ * -DCHACHA20_SIMD=0 to force the scalar code, e.g. to compare both.
+ */
+
+#if !defined(CHACHA20_SIMD)
+# if defined(__GNUC__) && (defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__))
+#  define CHACHA20_SIMD 1
+# else
+#  define CHACHA20_SIMD 0
+# endif
+#endif
+
+#if CHACHA20_SIMD && defined(__AVX2__)
+# define CHACHA20_LANES 8
+#elif CHACHA20_SIMD
+# define CHACHA20_LANES 4
+#else
+# define CHACHA20_LANES 1
+#endif
+
+#define CHACHA20_BLOCKBYTES 64U
+
+typedef struct chacha20_ctx {
+    uint32_t      input[16];
+    unsigned char keystream[CHACHA20_BLOCKBYTES];
+    size_t        keystream_left; /* unused bytes at the end of keystream */
+} chacha20_ctx;
+
+void chacha20_init(chacha20_ctx *ctx, const unsigned char *k,
+                   const unsigned char *n, uint64_t ic);
+
+/* c = m ^ keystream, m == NULL gives the keystream. Can be called with any
+ * length, the keystream continues where the previous call stopped. c and m
+ * may be the same buffer. */
+void chacha20_xor(chacha20_ctx *ctx, unsigned char *c, const unsigned char *m,
+                  unsigned long long mlen);
+
+#endif
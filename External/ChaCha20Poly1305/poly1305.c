@@ -0,0 +1,423 @@
+
+/*
+ * Poly1305 (D. J. Bernstein), after poly1305-donna (Andrew Moon), public domain.
+ */
+
+#include <string.h>
+
+#include "poly1305.h"
+
+#define LOAD32_LE(p)                                                        \
+    (((uint32_t) (p)[0]) | ((uint32_t) (p)[1] << 8) |                       \
+     ((uint32_t) (p)[2] << 16) | ((uint32_t) (p)[3] << 24))
+
+#define STORE32_LE(p, v)                                                    \
+    do {                                                                    \
+        (p)[0] = (unsigned char) (v);                                       \
+        (p)[1] = (unsigned char) ((v) >> 8);                                \
+        (p)[2] = (unsigned char) ((v) >> 16);                               \
+        (p)[3] = (unsigned char) ((v) >> 24);                               \
+    } while (0)
+
+#if POLY1305_64BIT
+
+/* 130-bit numbers as 44 + 44 + 42 bit limbs */
+
+typedef unsigned __int128 uint128_t;
+
+#define MASK44 ((uint64_t) 0xfffffffffff)
+#define MASK42 ((uint64_t) 0x3ffffffffff)
+
+#define POLY1305_HIBIT ((uint64_t) 1 << 40)
+
+#define LOAD64_LE(p) ((uint64_t) LOAD32_LE(p) | ((uint64_t) LOAD32_LE((p) + 4) << 32))
+
+#define STORE64_LE(p, v)                                                    \
+    do {                                                                    \
+        STORE32_LE(p, (uint32_t) (v));                                      \
+        STORE32_LE((p) + 4, (uint32_t) ((v) >> 32));                        \
+    } while (0)
+
+/* Limbs of one block, hibit is 2^128 for full blocks and 0 for the padded
+ * last one. */
+#define POLY1305_LIMBS(m, m0, m1, m2, hibit)                                \
+    do {                                                                    \
+        uint64_t t0_ = LOAD64_LE(m), t1_ = LOAD64_LE((m) + 8);              \
+        m0 = t0_ & MASK44;                                                  \
+        m1 = ((t0_ >> 44) | (t1_ << 20)) & MASK44;                          \
+        m2 = ((t1_ >> 24) & MASK42) | (hibit);                              \
+    } while (0)
+
+/* h = d mod 2^130 - 5, partially reduced: h0, h2 fit their limbs and h1 may
+ * exceed 2^44 by a few bits. */
+#define POLY1305_CARRY(h, d0, d1, d2)                                       \
+    do {                                                                    \
+        uint64_t c_;                                                        \
+        c_ = (uint64_t) (d0 >> 44); h[0] = (uint64_t) d0 & MASK44; d1 += c_;\
+        c_ = (uint64_t) (d1 >> 44); h[1] = (uint64_t) d1 & MASK44; d2 += c_;\
+        c_ = (uint64_t) (d2 >> 42); h[2] = (uint64_t) d2 & MASK42;          \
+        h[0] += c_ * 5; c_ = h[0] >> 44; h[0] &= MASK44;                    \
+        h[1] += c_;                                                         \
+    } while (0)
+
+static void
+poly1305_square(uint64_t out[3], const uint64_t r[3])
+{
+    const uint64_t s1 = r[1] * (5 << 2), s2 = r[2] * (5 << 2);
+    uint128_t      d0, d1, d2;
+
+    d0 = (uint128_t) r[0] * r[0] + (uint128_t) r[1] * s2 + (uint128_t) r[2] * s1;
+    d1 = (uint128_t) r[0] * r[1] + (uint128_t) r[1] * r[0] + (uint128_t) r[2] * s2;
+    d2 = (uint128_t) r[0] * r[2] + (uint128_t) r[1] * r[1] + (uint128_t) r[2] * r[0];
+    POLY1305_CARRY(out, d0, d1, d2);
+}
+
+void
+poly1305_init(poly1305_state *st, const unsigned char key[POLY1305_KEYBYTES])
+{
+    const uint64_t t0 = LOAD64_LE(key), t1 = LOAD64_LE(key + 8);
+
+    /* r &= 0xffffffc0ffffffc0ffffffc0fffffff */
+    st->r[0] = t0 & 0xffc0fffffff;
+    st->r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffff;
+    st->r[2] = (t1 >> 24) & 0x00ffffffc0f;
+    poly1305_square(st->rr, st->r);
+
+    st->h[0] = st->h[1] = st->h[2] = 0;
+    st->pad[0] = LOAD64_LE(key + 16);
+    st->pad[1] = LOAD64_LE(key + 24);
+    st->leftover = 0;
+}
+
+static void
+poly1305_blocks(poly1305_state *st, const unsigned char *m, size_t bytes,
+                uint64_t hibit)
+{
+    const uint64_t r0 = st->r[0], r1 = st->r[1], r2 = st->r[2];
+    const uint64_t s1 = r1 * (5 << 2), s2 = r2 * (5 << 2);
+    const uint64_t rr0 = st->rr[0], rr1 = st->rr[1], rr2 = st->rr[2];
+    const uint64_t ss1 = rr1 * (5 << 2), ss2 = rr2 * (5 << 2);
+    uint64_t       h0 = st->h[0], h1 = st->h[1], h2 = st->h[2];
+    uint64_t       a0, a1, a2, b0, b1, b2;
+    uint128_t      d0, d1, d2;
+    uint64_t       h[3];
+
+    /* h = (h + m0) r^2 + m1 r */
+    while (bytes >= 2 * POLY1305_BLOCKBYTES) {
+        POLY1305_LIMBS(m, a0, a1, a2, hibit);
+        POLY1305_LIMBS(m + POLY1305_BLOCKBYTES, b0, b1, b2, hibit);
+        a0 += h0;
+        a1 += h1;
+        a2 += h2;
+
+        d0 = (uint128_t) a0 * rr0 + (uint128_t) a1 * ss2 + (uint128_t) a2 * ss1 +
+             (uint128_t) b0 * r0  + (uint128_t) b1 * s2  + (uint128_t) b2 * s1;
+        d1 = (uint128_t) a0 * rr1 + (uint128_t) a1 * rr0 + (uint128_t) a2 * ss2 +
+             (uint128_t) b0 * r1  + (uint128_t) b1 * r0  + (uint128_t) b2 * s2;
+        d2 = (uint128_t) a0 * rr2 + (uint128_t) a1 * rr1 + (uint128_t) a2 * rr0 +
+             (uint128_t) b0 * r2  + (uint128_t) b1 * r1  + (uint128_t) b2 * r0;
+        POLY1305_CARRY(h, d0, d1, d2);
+        h0 = h[0];
+        h1 = h[1];
+        h2 = h[2];
+
+        m += 2 * POLY1305_BLOCKBYTES;
+        bytes -= 2 * POLY1305_BLOCKBYTES;
+    }
+    /* h = (h + m) r */
+    while (bytes >= POLY1305_BLOCKBYTES) {
+        POLY1305_LIMBS(m, a0, a1, a2, hibit);
+        h0 += a0;
+        h1 += a1;
+        h2 += a2;
+
+        d0 = (uint128_t) h0 * r0 + (uint128_t) h1 * s2 + (uint128_t) h2 * s1;
+        d1 = (uint128_t) h0 * r1 + (uint128_t) h1 * r0 + (uint128_t) h2 * s2;
+        d2 = (uint128_t) h0 * r2 + (uint128_t) h1 * r1 + (uint128_t) h2 * r0;
+        POLY1305_CARRY(h, d0, d1, d2);
+        h0 = h[0];
+        h1 = h[1];
+        h2 = h[2];
+
+        m += POLY1305_BLOCKBYTES;
+        bytes -= POLY1305_BLOCKBYTES;
+    }
+
+    st->h[0] = h0;
+    st->h[1] = h1;
+    st->h[2] = h2;
+}
+
+static void
+poly1305_finish(poly1305_state *st, unsigned char mac[POLY1305_BYTES])
+{
+    uint64_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2];
+    uint64_t g0, g1, g2, c, mask, t0, t1;
+
+    /* fully carry h */
+    c = h1 >> 44; h1 &= MASK44;
+    h2 += c;      c = h2 >> 42; h2 &= MASK42;
+    h0 += c * 5;  c = h0 >> 44; h0 &= MASK44;
+    h1 += c;      c = h1 >> 44; h1 &= MASK44;
+    h2 += c;      c = h2 >> 42; h2 &= MASK42;
+    h0 += c * 5;  c = h0 >> 44; h0 &= MASK44;
+    h1 += c;
+
+    /* g = h + -p, select h if h < p else g */
+    g0 = h0 + 5;  c = g0 >> 44; g0 &= MASK44;
+    g1 = h1 + c;  c = g1 >> 44; g1 &= MASK44;
+    g2 = h2 + c - ((uint64_t) 1 << 42);
+    mask = (g2 >> 63) - 1;
+    g0 &= mask;
+    g1 &= mask;
+    g2 &= mask;
+    mask = ~mask;
+    h0 = (h0 & mask) | g0;
+    h1 = (h1 & mask) | g1;
+    h2 = (h2 & mask) | g2;
+
+    /* h = (h + pad) mod 2^128 */
+    t0 = st->pad[0];
+    t1 = st->pad[1];
+    h0 += t0 & MASK44;                                 c = h0 >> 44; h0 &= MASK44;
+    h1 += (((t0 >> 44) | (t1 << 20)) & MASK44) + c;    c = h1 >> 44; h1 &= MASK44;
+    h2 += ((t1 >> 24) & MASK42) + c;                  h2 &= MASK42;
+
+    h0 = h0 | (h1 << 44);
+    h1 = (h1 >> 20) | (h2 << 24);
+    STORE64_LE(mac, h0);
+    STORE64_LE(mac + 8, h1);
+}
+
+#else
+
+/* 130-bit numbers as five 26-bit limbs */
+
+#define MASK26 ((uint32_t) 0x3ffffff)
+
+#define POLY1305_HIBIT ((uint32_t) 1 << 24)
+
+#define POLY1305_LIMBS(m, m0, m1, m2, m3, m4, hibit)                        \
+    do {                                                                    \
+        m0 = LOAD32_LE(m) & MASK26;                                         \
+        m1 = (LOAD32_LE((m) + 3) >> 2) & MASK26;                            \
+        m2 = (LOAD32_LE((m) + 6) >> 4) & MASK26;                            \
+        m3 = (LOAD32_LE((m) + 9) >> 6) & MASK26;                            \
+        m4 = (LOAD32_LE((m) + 12) >> 8) | (hibit);                          \
+    } while (0)
+
+#define POLY1305_CARRY(h, d0, d1, d2, d3, d4)                               \
+    do {                                                                    \
+        uint32_t c_;                                                        \
+        c_ = (uint32_t) (d0 >> 26); h[0] = (uint32_t) d0 & MASK26; d1 += c_;\
+        c_ = (uint32_t) (d1 >> 26); h[1] = (uint32_t) d1 & MASK26; d2 += c_;\
+        c_ = (uint32_t) (d2 >> 26); h[2] = (uint32_t) d2 & MASK26; d3 += c_;\
+        c_ = (uint32_t) (d3 >> 26); h[3] = (uint32_t) d3 & MASK26; d4 += c_;\
+        c_ = (uint32_t) (d4 >> 26); h[4] = (uint32_t) d4 & MASK26;          \
+        h[0] += c_ * 5; c_ = h[0] >> 26; h[0] &= MASK26;                    \
+        h[1] += c_;                                                         \
+    } while (0)
+
+#define MUL(a, b) ((uint64_t) (a) * (b))
+
+static void
+poly1305_square(uint32_t out[5], const uint32_t r[5])
+{
+    const uint32_t s1 = r[1] * 5, s2 = r[2] * 5, s3 = r[3] * 5, s4 = r[4] * 5;
+    uint64_t       d0, d1, d2, d3, d4;
+
+    d0 = MUL(r[0], r[0]) + MUL(r[1], s4) + MUL(r[2], s3) + MUL(r[3], s2) + MUL(r[4], s1);
+    d1 = MUL(r[0], r[1]) + MUL(r[1], r[0]) + MUL(r[2], s4) + MUL(r[3], s3) + MUL(r[4], s2);
+    d2 = MUL(r[0], r[2]) + MUL(r[1], r[1]) + MUL(r[2], r[0]) + MUL(r[3], s4) + MUL(r[4], s3);
+    d3 = MUL(r[0], r[3]) + MUL(r[1], r[2]) + MUL(r[2], r[1]) + MUL(r[3], r[0]) + MUL(r[4], s4);
+    d4 = MUL(r[0], r[4]) + MUL(r[1], r[3]) + MUL(r[2], r[2]) + MUL(r[3], r[1]) + MUL(r[4], r[0]);
+    POLY1305_CARRY(out, d0, d1, d2, d3, d4);
+}
+
+void
+poly1305_init(poly1305_state *st, const unsigned char key[POLY1305_KEYBYTES])
+{
+    /* r &= 0xffffffc0ffffffc0ffffffc0fffffff */
+    st->r[0] = (LOAD32_LE(key)) & 0x3ffffff;
+    st->r[1] = (LOAD32_LE(key + 3) >> 2) & 0x3ffff03;
+    st->r[2] = (LOAD32_LE(key + 6) >> 4) & 0x3ffc0ff;
+    st->r[3] = (LOAD32_LE(key + 9) >> 6) & 0x3f03fff;
+    st->r[4] = (LOAD32_LE(key + 12) >> 8) & 0x00fffff;
+    poly1305_square(st->rr, st->r);
+
+    st->h[0] = st->h[1] = st->h[2] = st->h[3] = st->h[4] = 0;
+    st->pad[0] = LOAD32_LE(key + 16);
+    st->pad[1] = LOAD32_LE(key + 20);
+    st->pad[2] = LOAD32_LE(key + 24);
+    st->pad[3] = LOAD32_LE(key + 28);
+    st->leftover = 0;
+}
+
+static void
+poly1305_blocks(poly1305_state *st, const unsigned char *m, size_t bytes,
+                uint32_t hibit)
+{
+    const uint32_t r0 = st->r[0], r1 = st->r[1], r2 = st->r[2], r3 = st->r[3], r4 = st->r[4];
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    const uint32_t rr0 = st->rr[0], rr1 = st->rr[1], rr2 = st->rr[2], rr3 = st->rr[3], rr4 = st->rr[4];
+    const uint32_t ss1 = rr1 * 5, ss2 = rr2 * 5, ss3 = rr3 * 5, ss4 = rr4 * 5;
+    uint32_t       a0, a1, a2, a3, a4, b0, b1, b2, b3, b4;
+    uint64_t       d0, d1, d2, d3, d4;
+    uint32_t       h[5];
+
+    memcpy(h, st->h, sizeof h);
+
+    /* h = (h + m0) r^2 + m1 r */
+    while (bytes >= 2 * POLY1305_BLOCKBYTES) {
+        POLY1305_LIMBS(m, a0, a1, a2, a3, a4, hibit);
+        POLY1305_LIMBS(m + POLY1305_BLOCKBYTES, b0, b1, b2, b3, b4, hibit);
+        a0 += h[0];
+        a1 += h[1];
+        a2 += h[2];
+        a3 += h[3];
+        a4 += h[4];
+
+        d0 = MUL(a0, rr0) + MUL(a1, ss4) + MUL(a2, ss3) + MUL(a3, ss2) + MUL(a4, ss1) +
+             MUL(b0, r0)  + MUL(b1, s4)  + MUL(b2, s3)  + MUL(b3, s2)  + MUL(b4, s1);
+        d1 = MUL(a0, rr1) + MUL(a1, rr0) + MUL(a2, ss4) + MUL(a3, ss3) + MUL(a4, ss2) +
+             MUL(b0, r1)  + MUL(b1, r0)  + MUL(b2, s4)  + MUL(b3, s3)  + MUL(b4, s2);
+        d2 = MUL(a0, rr2) + MUL(a1, rr1) + MUL(a2, rr0) + MUL(a3, ss4) + MUL(a4, ss3) +
+             MUL(b0, r2)  + MUL(b1, r1)  + MUL(b2, r0)  + MUL(b3, s4)  + MUL(b4, s3);
+        d3 = MUL(a0, rr3) + MUL(a1, rr2) + MUL(a2, rr1) + MUL(a3, rr0) + MUL(a4, ss4) +
+             MUL(b0, r3)  + MUL(b1, r2)  + MUL(b2, r1)  + MUL(b3, r0)  + MUL(b4, s4);
+        d4 = MUL(a0, rr4) + MUL(a1, rr3) + MUL(a2, rr2) + MUL(a3, rr1) + MUL(a4, rr0) +
+             MUL(b0, r4)  + MUL(b1, r3)  + MUL(b2, r2)  + MUL(b3, r1)  + MUL(b4, r0);
+        POLY1305_CARRY(h, d0, d1, d2, d3, d4);
+
+        m += 2 * POLY1305_BLOCKBYTES;
+        bytes -= 2 * POLY1305_BLOCKBYTES;
+    }
+    /* h = (h + m) r */
+    while (bytes >= POLY1305_BLOCKBYTES) {
+        POLY1305_LIMBS(m, a0, a1, a2, a3, a4, hibit);
+        a0 += h[0];
+        a1 += h[1];
+        a2 += h[2];
+        a3 += h[3];
+        a4 += h[4];
+
+        d0 = MUL(a0, r0) + MUL(a1, s4) + MUL(a2, s3) + MUL(a3, s2) + MUL(a4, s1);
+        d1 = MUL(a0, r1) + MUL(a1, r0) + MUL(a2, s4) + MUL(a3, s3) + MUL(a4, s2);
+        d2 = MUL(a0, r2) + MUL(a1, r1) + MUL(a2, r0) + MUL(a3, s4) + MUL(a4, s3);
+        d3 = MUL(a0, r3) + MUL(a1, r2) + MUL(a2, r1) + MUL(a3, r0) + MUL(a4, s4);
+        d4 = MUL(a0, r4) + MUL(a1, r3) + MUL(a2, r2) + MUL(a3, r1) + MUL(a4, r0);
+        POLY1305_CARRY(h, d0, d1, d2, d3, d4);
+
+        m += POLY1305_BLOCKBYTES;
+        bytes -= POLY1305_BLOCKBYTES;
+    }
+
+    memcpy(st->h, h, sizeof h);
+}
+
+static void
+poly1305_finish(poly1305_state *st, unsigned char mac[POLY1305_BYTES])
+{
+    uint32_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2], h3 = st->h[3], h4 = st->h[4];
+    uint32_t g0, g1, g2, g3, g4, c, mask;
+    uint64_t f;
+
+    /* fully carry h */
+    c = h1 >> 26; h1 &= MASK26;
+    h2 += c;      c = h2 >> 26; h2 &= MASK26;
+    h3 += c;      c = h3 >> 26; h3 &= MASK26;
+    h4 += c;      c = h4 >> 26; h4 &= MASK26;
+    h0 += c * 5;  c = h0 >> 26; h0 &= MASK26;
+    h1 += c;
+
+    /* g = h + -p, select h if h < p else g */
+    g0 = h0 + 5;  c = g0 >> 26; g0 &= MASK26;
+    g1 = h1 + c;  c = g1 >> 26; g1 &= MASK26;
+    g2 = h2 + c;  c = g2 >> 26; g2 &= MASK26;
+    g3 = h3 + c;  c = g3 >> 26; g3 &= MASK26;
+    g4 = h4 + c - ((uint32_t) 1 << 26);
+    mask = (g4 >> 31) - 1;
+    g0 &= mask;
+    g1 &= mask;
+    g2 &= mask;
+    g3 &= mask;
+    g4 &= mask;
+    mask = ~mask;
+    h0 = (h0 & mask) | g0;
+    h1 = (h1 & mask) | g1;
+    h2 = (h2 & mask) | g2;
+    h3 = (h3 & mask) | g3;
+    h4 = (h4 & mask) | g4;
+
+    /* h = h % 2^128, then (h + pad) mod 2^128 */
+    h0 = h0 | (h1 << 26);
+    h1 = (h1 >> 6) | (h2 << 20);
+    h2 = (h2 >> 12) | (h3 << 14);
+    h3 = (h3 >> 18) | (h4 << 8);
+
+    f = (uint64_t) h0 + st->pad[0];             h0 = (uint32_t) f;
+    f = (uint64_t) h1 + st->pad[1] + (f >> 32); h1 = (uint32_t) f;
+    f = (uint64_t) h2 + st->pad[2] + (f >> 32); h2 = (uint32_t) f;
+    f = (uint64_t) h3 + st->pad[3] + (f >> 32); h3 = (uint32_t) f;
+
+    STORE32_LE(mac, h0);
+    STORE32_LE(mac + 4, h1);
+    STORE32_LE(mac + 8, h2);
+    STORE32_LE(mac + 12, h3);
+}
+
+#endif
+
+void
+poly1305_update(poly1305_state *st, const unsigned char *m,
+                unsigned long long bytes)
+{
+    size_t i, want;
+
+    if (st->leftover) {
+        want = POLY1305_BLOCKBYTES - st->leftover;
+        if (want > bytes) {
+            want = (size_t) bytes;
+        }
+        for (i = 0; i < want; i++) {
+            st->buffer[st->leftover + i] = m[i];
+        }
+        bytes -= want;
+        m += want;
+        st->leftover += want;
+        if (st->leftover < POLY1305_BLOCKBYTES) {
+            return;
+        }
+        poly1305_blocks(st, st->buffer, POLY1305_BLOCKBYTES, POLY1305_HIBIT);
+        st->leftover = 0;
+    }
+    if (bytes >= POLY1305_BLOCKBYTES) {
+        want = (size_t) (bytes & ~(unsigned long long) (POLY1305_BLOCKBYTES - 1));
+        poly1305_blocks(st, m, want, POLY1305_HIBIT);
+        m += want;
+        bytes -= want;
+    }
+    if (bytes) {
+        for (i = 0; i < (size_t) bytes; i++) {
+            st->buffer[st->leftover + i] = m[i];
+        }
+        st->leftover += (size_t) bytes;
+    }
+}
+
+void
+poly1305_final(poly1305_state *st, unsigned char mac[POLY1305_BYTES])
+{
+    size_t i;
+
+    if (st->leftover) {
+        i = st->leftover;
+        st->buffer[i++] = 1;
+        for (; i < POLY1305_BLOCKBYTES; i++) {
+            st->buffer[i] = 0;
+        }
+        poly1305_blocks(st, st->buffer, POLY1305_BLOCKBYTES, 0);
+    }
+    poly1305_finish(st, mac);
+    memset(st, 0, sizeof *st);
+}
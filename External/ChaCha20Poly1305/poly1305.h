@@ -0,0 +1,50 @@
+
+#ifndef poly1305_H
+#define poly1305_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Poly1305 one-time authenticator.
+ *
+ * Hosts with a native 128-bit integer use three 44/44/42-bit limbs, the rest
+ * (Cortex-M) five 26-bit limbs with 32x32->64 products. Both precompute r^2
+ * and absorb two blocks per step, h = (h + m0) r^2 + m1 r, which needs one
+ * carry chain instead of two.
+ */
+
+#if !defined(POLY1305_64BIT)
+# if defined(__SIZEOF_INT128__)
+#  define POLY1305_64BIT 1
+# else
+#  define POLY1305_64BIT 0
+# endif
+#endif
+
+#define POLY1305_BLOCKBYTES 16U
+#define POLY1305_KEYBYTES   32U
+#define POLY1305_BYTES      16U
+
+typedef struct poly1305_state {
+#if POLY1305_64BIT
+    uint64_t      r[3];
+    uint64_t      rr[3];  /* r^2 */
+    uint64_t      h[3];
+    uint64_t      pad[2];
+#else
+    uint32_t      r[5];
+    uint32_t      rr[5];  /* r^2 */
+    uint32_t      h[5];
+    uint32_t      pad[4];
+#endif
+    size_t        leftover;
+    unsigned char buffer[POLY1305_BLOCKBYTES];
+} poly1305_state;
+
+void poly1305_init(poly1305_state *st, const unsigned char key[POLY1305_KEYBYTES]);
+void poly1305_update(poly1305_state *st, const unsigned char *m,
+                     unsigned long long bytes);
+void poly1305_final(poly1305_state *st, unsigned char mac[POLY1305_BYTES]);
+
+#endif
@@ -431,24 +431,48 @@ crecip(felem out, const felem z) {
   /* 2^255 - 21 */ fmul(out, t0, a);
 }
 
-static const unsigned char		kCurve25519BasePoint[ 32 ] = { 9 };
-
-void
-curve25519_donna(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
-  limb bp[5], x[5], z[5], zmone[5];
-  uint8_t e[32];
-  int i;
-
-  if (basepoint == NULL) basepoint = kCurve25519BasePoint;
-
-  for (i = 0;i < 32;++i) e[i] = secret[i];
-  e[0] &= 248;
-  e[31] &= 127;
-  e[31] |= 64;
-
-  fexpand(bp, basepoint);
-  cmult(x, z, e, bp);
-  crecip(zmone, z);
-  fmul(z, x, zmone);
-  fcontract(mypublic, z);
+/* Field element interface used by curve25519-donna-base.c. Sums and
+ * differences are carried straight away so that limbs stay below 2^52 and
+ * any result can be the subtrahend of fdifference_backwards again.
+ */
+#define FE_LIMBS 5
+typedef limb fe[FE_LIMBS];
+
+static void force_inline
+fe_carry(felem output) {
+  limb c;
+  c = output[0] >> 51; output[0] &= 0x7ffffffffffff; output[1] += c;
+  c = output[1] >> 51; output[1] &= 0x7ffffffffffff; output[2] += c;
+  c = output[2] >> 51; output[2] &= 0x7ffffffffffff; output[3] += c;
+  c = output[3] >> 51; output[3] &= 0x7ffffffffffff; output[4] += c;
+  c = output[4] >> 51; output[4] &= 0x7ffffffffffff; output[0] += c * 19;
 }
+
+static void
+fe_add(felem output, const felem a, const felem b) {
+  output[0] = a[0] + b[0];
+  output[1] = a[1] + b[1];
+  output[2] = a[2] + b[2];
+  output[3] = a[3] + b[3];
+  output[4] = a[4] + b[4];
+  fe_carry(output);
+}
+
+static void
+fe_sub(felem output, const felem a, const felem b) {
+  felem t;
+  memcpy(t, b, sizeof(felem));
+  fdifference_backwards(t, a);
+  fe_carry(t);
+  memcpy(output, t, sizeof(felem));
+}
+
+static void
+fe_sq(felem output, const felem in) {
+  fsquare_times(output, in, 1);
+}
+
+#define fe_mul fmul
+#define fe_frombytes fexpand
+#define fe_tobytes fcontract
+#define fe_invert crecip
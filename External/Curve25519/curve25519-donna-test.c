@@ -61,6 +61,10 @@
 
 OSStatus	curve25519_test( int print );
 int			curve25519_djb_test( int print );
+static OSStatus	curve25519_rfc7748_test( int print );
+static OSStatus	curve25519_consistency_test( int print );
+static OSStatus	curve25519_benchmark( void );
+static OSStatus	curve25519_hex_to_key( const char *inHex, uint8_t outKey[ 32 ] );
 
 //===========================================================================================================================
 //	Test Vectors
@@ -154,6 +158,35 @@ static const curve25519_test_vector		kCurve25519TestVectors[] =
 	{ "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", "96186d56afdbfeda62f0d07168fa8b142b3d8530e9705fd818cfd33591ea927f" }, 
 };
 
+// RFC 7748 section 5.2 (scalar, u-coordinate, output) and section 6.1 (private key, 9, public key; private key, peer
+// public key, shared secret).
+
+static const curve25519_test_vector		kCurve25519RFC7748Vectors[] =
+{
+	{ "a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4", "e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c", "c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552" }, 
+	{ "4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d", "e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493", "95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957" }, 
+	{ "77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a", "0900000000000000000000000000000000000000000000000000000000000000", "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a" }, 
+	{ "5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb", "0900000000000000000000000000000000000000000000000000000000000000", "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f" }, 
+	{ "77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a", "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f", "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742" }, 
+	{ "5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb", "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a", "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742" }, 
+};
+
+// RFC 7748 section 5.2 iterated test: k = u = 9, then k, u = X25519( k, u ), k. Expected k after 1 and 1000 iterations.
+
+static const char * const		kCurve25519RFC7748Iteration1	= "422c8e7a6227d7bca1350b3e2bb7279f7897b87bb6854b783c60e80311ae3079";
+static const char * const		kCurve25519RFC7748Iteration1000	= "684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f2eb94d99532c51";
+
+// Base point 9 with the (ignored) top bit set. Decodes to 9 but does not match the fixed-base shortcut, so it forces the
+// Montgomery ladder for comparisons against the table path.
+
+static const uint8_t		kCurve25519LadderBasePoint[ 32 ] =
+{
+	0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80
+};
+
+#define kCurve25519BenchmarkCount		100
+
 //===========================================================================================================================
 //	curve25519_test
 //===========================================================================================================================
@@ -193,16 +226,227 @@ OSStatus	curve25519_test( int print )
 		}
 	}
 	
+	err = curve25519_rfc7748_test( print );
+	require_noerr( err, exit );
+	
+	err = curve25519_consistency_test( print );
+	require_noerr( err, exit );
+	
 	t = CFAbsoluteTimeGetCurrent();
 	err = curve25519_djb_test( print );
 	require_noerr( err, exit );
 	t = CFAbsoluteTimeGetCurrent() - t;
 	
+	err = curve25519_benchmark();
+	require_noerr( err, exit );
+	
 exit:
 	FPrintF( stdout, "%###s: %s (%f seconds)\n", __ROUTINE__, !err ? "PASSED" : "FAILED", t );
 	return( err );
 }
 
+//===========================================================================================================================
+//	curve25519_hex_to_key
+//===========================================================================================================================
+
+static OSStatus	curve25519_hex_to_key( const char *inHex, uint8_t outKey[ 32 ] )
+{
+	OSStatus		err;
+	size_t			len;
+	
+	err = HexToData( inHex, kSizeCString, kHexToData_NoFlags, outKey, 32, &len, NULL, NULL );
+	require_noerr( err, exit );
+	require_action( len == 32, exit, err = kSizeErr );
+	
+exit:
+	return( err );
+}
+
+//===========================================================================================================================
+//	curve25519_rfc7748_test
+//===========================================================================================================================
+
+static OSStatus	curve25519_rfc7748_test( int print )
+{
+	OSStatus		err;
+	uint8_t			e[ 32 ], k[ 32 ], ek[ 32 ], ek2[ 32 ], u[ 32 ];
+	size_t			i;
+	
+	for( i = 0; i < countof( kCurve25519RFC7748Vectors ); ++i )
+	{
+		const curve25519_test_vector * const 	tv = &kCurve25519RFC7748Vectors[ i ];
+		
+		err = curve25519_hex_to_key( tv->e, e );
+		require_noerr( err, exit );
+		err = curve25519_hex_to_key( tv->k, k );
+		require_noerr( err, exit );
+		err = curve25519_hex_to_key( tv->ek, ek );
+		require_noerr( err, exit );
+		
+		memset( ek2, 0, sizeof( ek2 ) );
+		curve25519_donna( ek2, e, k );
+		require_action( memcmp( ek, ek2, 32 ) == 0, exit, err = kMismatchErr );
+	}
+	
+	// Iterated test. Alternates between the fixed-base path (first step, u = 9) and the ladder.
+	
+	memset( e, 0, sizeof( e ) );
+	e[ 0 ] = 9;
+	memcpy( u, e, sizeof( u ) );
+	for( i = 1; i <= 1000; ++i )
+	{
+		curve25519_donna( ek2, e, u );
+		memcpy( u, e, sizeof( u ) );
+		memcpy( e, ek2, sizeof( e ) );
+		if( ( i == 1 ) || ( i == 1000 ) )
+		{
+			err = curve25519_hex_to_key( ( i == 1 ) ? kCurve25519RFC7748Iteration1 : kCurve25519RFC7748Iteration1000, ek );
+			require_noerr( err, exit );
+			require_action( memcmp( ek, e, 32 ) == 0, exit, err = kMismatchErr );
+		}
+	}
+	if( print ) FPrintF( stdout, "RFC 7748: %zu vectors, 1000 iterations OK\n", countof( kCurve25519RFC7748Vectors ) );
+	
+exit:
+	return( err );
+}
+
+//===========================================================================================================================
+//	curve25519_consistency_test
+//
+//	Fixed-base table vs. ladder, batch vs. one at a time (including a batch that does not fill a whole chunk, and the
+//	all-zero results of low order points from the edge cases).
+//===========================================================================================================================
+
+static OSStatus	curve25519_consistency_test( int print )
+{
+	OSStatus		err;
+	size_t			n, i;
+	uint8_t *		secrets	= NULL;
+	uint8_t *		points	= NULL;
+	uint8_t *		keys	= NULL;
+	uint8_t			ek[ 32 ], ek2[ 32 ];
+	
+	n = countof( kCurve25519TestVectors );
+	secrets = (uint8_t *) malloc( 32 * n );
+	points  = (uint8_t *) malloc( 32 * n );
+	keys    = (uint8_t *) malloc( 32 * n );
+	require_action( secrets && points && keys, exit, err = kNoMemoryErr );
+	
+	for( i = 0; i < n; ++i )
+	{
+		err = curve25519_hex_to_key( kCurve25519TestVectors[ i ].e, &secrets[ 32 * i ] );
+		require_noerr( err, exit );
+		err = curve25519_hex_to_key( kCurve25519TestVectors[ i ].k, &points[ 32 * i ] );
+		require_noerr( err, exit );
+		
+		// Public key: table vs. ladder.
+		
+		curve25519_donna_base( ek, &secrets[ 32 * i ] );
+		curve25519_donna( ek2, &secrets[ 32 * i ], kCurve25519LadderBasePoint );
+		require_action( memcmp( ek, ek2, 32 ) == 0, exit, err = kMismatchErr );
+	}
+	
+	// Key agreement batch.
+	
+	memset( keys, 0, 32 * n );
+	curve25519_donna_batch( keys, secrets, points, n );
+	for( i = 0; i < n; ++i )
+	{
+		err = curve25519_hex_to_key( kCurve25519TestVectors[ i ].ek, ek );
+		require_noerr( err, exit );
+		require_action( memcmp( ek, &keys[ 32 * i ], 32 ) == 0, exit, err = kMismatchErr );
+	}
+	
+	// Public key batch, odd count.
+	
+	memset( keys, 0, 32 * n );
+	curve25519_donna_batch( keys, secrets, NULL, n - 1 );
+	for( i = 0; i < n - 1; ++i )
+	{
+		curve25519_donna( ek, &secrets[ 32 * i ], NULL );
+		require_action( memcmp( ek, &keys[ 32 * i ], 32 ) == 0, exit, err = kMismatchErr );
+	}
+	if( print ) FPrintF( stdout, "Consistency: %zu keys, table == ladder, batch == single\n", n );
+	err = kNoErr;
+	
+exit:
+	if( secrets )	free( secrets );
+	if( points )	free( points );
+	if( keys )		free( keys );
+	return( err );
+}
+
+//===========================================================================================================================
+//	curve25519_benchmark
+//===========================================================================================================================
+
+static OSStatus	curve25519_benchmark( void )
+{
+	OSStatus			err;
+	uint8_t *			secrets	= NULL;
+	uint8_t *			keys	= NULL;
+	uint8_t *			shared	= NULL;
+	uint8_t *			peers	= NULL;
+	size_t				i, j;
+	CFAbsoluteTime		tLadder, tBase, tBatchBase, tAgree, tBatchAgree;
+	
+	secrets = (uint8_t *) malloc( 32 * kCurve25519BenchmarkCount );
+	keys    = (uint8_t *) malloc( 32 * kCurve25519BenchmarkCount );
+	shared  = (uint8_t *) malloc( 32 * kCurve25519BenchmarkCount );
+	peers   = (uint8_t *) malloc( 32 * kCurve25519BenchmarkCount );
+	require_action( secrets && keys && shared && peers, exit, err = kNoMemoryErr );
+	
+	for( i = 0; i < 32 * kCurve25519BenchmarkCount; ++i ) secrets[ i ] = (uint8_t)( ( i * 167 ) + ( i >> 5 ) );
+	
+	tLadder = CFAbsoluteTimeGetCurrent();
+	for( i = 0; i < kCurve25519BenchmarkCount; ++i ) curve25519_donna( &keys[ 32 * i ], &secrets[ 32 * i ], kCurve25519LadderBasePoint );
+	tLadder = CFAbsoluteTimeGetCurrent() - tLadder;
+	
+	tBase = CFAbsoluteTimeGetCurrent();
+	for( i = 0; i < kCurve25519BenchmarkCount; ++i ) curve25519_donna_base( &shared[ 32 * i ], &secrets[ 32 * i ] );
+	tBase = CFAbsoluteTimeGetCurrent() - tBase;
+	require_action( memcmp( keys, shared, 32 * kCurve25519BenchmarkCount ) == 0, exit, err = kMismatchErr );
+	
+	tBatchBase = CFAbsoluteTimeGetCurrent();
+	curve25519_donna_batch( shared, secrets, NULL, kCurve25519BenchmarkCount );
+	tBatchBase = CFAbsoluteTimeGetCurrent() - tBatchBase;
+	require_action( memcmp( keys, shared, 32 * kCurve25519BenchmarkCount ) == 0, exit, err = kMismatchErr );
+	
+	// Agreement of every secret with the next public key.
+	
+	tAgree = CFAbsoluteTimeGetCurrent();
+	for( i = 0; i < kCurve25519BenchmarkCount; ++i )
+	{
+		j = ( i + 1 ) % kCurve25519BenchmarkCount;
+		curve25519_donna( &shared[ 32 * i ], &secrets[ 32 * i ], &keys[ 32 * j ] );
+	}
+	tAgree = CFAbsoluteTimeGetCurrent() - tAgree;
+	
+	memcpy( peers, &keys[ 32 ], 32 * ( kCurve25519BenchmarkCount - 1 ) );
+	memcpy( &peers[ 32 * ( kCurve25519BenchmarkCount - 1 ) ], keys, 32 );
+	tBatchAgree = CFAbsoluteTimeGetCurrent();
+	curve25519_donna_batch( keys, secrets, peers, kCurve25519BenchmarkCount );
+	tBatchAgree = CFAbsoluteTimeGetCurrent() - tBatchAgree;
+	require_action( memcmp( keys, shared, 32 * kCurve25519BenchmarkCount ) == 0, exit, err = kMismatchErr );
+	
+	{
+		FPrintF( stdout, "Public key, ladder:    %8.1f us\n", ( tLadder     * 1e6 ) / kCurve25519BenchmarkCount );
+		FPrintF( stdout, "Public key, table:     %8.1f us\n", ( tBase       * 1e6 ) / kCurve25519BenchmarkCount );
+		FPrintF( stdout, "Public key, batch:     %8.1f us\n", ( tBatchBase  * 1e6 ) / kCurve25519BenchmarkCount );
+		FPrintF( stdout, "Key agreement:         %8.1f us\n", ( tAgree      * 1e6 ) / kCurve25519BenchmarkCount );
+		FPrintF( stdout, "Key agreement, batch:  %8.1f us\n", ( tBatchAgree * 1e6 ) / kCurve25519BenchmarkCount );
+	}
+	err = kNoErr;
+	
+exit:
+	if( secrets )	free( secrets );
+	if( keys )		free( keys );
+	if( shared )	free( shared );
+	if( peers )		free( peers );
+	return( err );
+}
+
 //===========================================================================================================================
 //	curve25519_djb_test
 //
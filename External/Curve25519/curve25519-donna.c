@@ -70,9 +70,13 @@
 #endif
 
 // CURVE25519_64_BIT
+//
+// The radix 2^51 code needs 128-bit products. Besides the LP64 style targets, pick it on any compiler that advertises a
+// native 128-bit integer (__SIZEOF_INT128__), e.g. 64-bit ILP32 ABIs. 32-bit MCUs keep the radix 2^25.5 code below.
 
 #if( !defined( CURVE25519_64_BIT ) )
-	#if( ( __LP64__ || defined( _WIN64 ) || defined( EFI64 ) || defined( EFIX64 ) || TARGET_CPU_X86_64 ) && \
+	#if( ( __LP64__ || defined( _WIN64 ) || defined( EFI64 ) || defined( EFIX64 ) || TARGET_CPU_X86_64 || \
+		   defined( __SIZEOF_INT128__ ) ) && \
 		 !TARGET_CPU_PPC64 && !defined( _MSC_VER ) )
 		#define	CURVE25519_64_BIT		1
 	#else
@@ -548,6 +552,14 @@ fcontract(u8 *output, limb *input) {
 #undef F
 }
 
+/* Limbs of scratch space needed by one fmonty step: origx[10],
+ * origxprime[10], zzz[19], xx[19], zz[19], xxprime[19], zzprime[19],
+ * zzzprime[19], xxxprime[19]. These used to live on the stack, which is too
+ * big for small thread stacks; cmult now hands the same heap block to every
+ * step instead of allocating it 255 times.
+ */
+#define FMONTY_SCRATCH_LIMBS (2 * 10 + 7 * 19)
+
 /* Input: Q, Q', Q-Q'
  * Output: 2Q, Q+Q'
  *
@@ -556,26 +568,23 @@ fcontract(u8 *output, limb *input) {
  *   x z: short form, destroyed
  *   xprime zprime: short form, destroyed
  *   qmqp: short form, preserved
+ *   scratch: FMONTY_SCRATCH_LIMBS limbs, zeroed by the caller once
  */
 static void fmonty(limb *x2, limb *z2,  /* output 2Q */
                    limb *x3, limb *z3,  /* output Q + Q' */
                    limb *x, limb *z,    /* input Q */
                    limb *xprime, limb *zprime,  /* input Q' */
-                   const limb *qmqp /* input Q - Q' */) {
-
-   limb *origx = calloc(10, sizeof(limb));
-   limb *origxprime = calloc(10, sizeof(limb));
-   limb *zzz = calloc(19, sizeof(limb));
-   limb *xx = calloc(19, sizeof(limb));
-   limb *zz = calloc(19, sizeof(limb));
-   limb *xxprime = calloc(19, sizeof(limb));
-   limb *zzprime = calloc(19, sizeof(limb));
-   limb *zzzprime = calloc(19, sizeof(limb));
-   limb *xxxprime = calloc(19, sizeof(limb));
-
-
-  // limb origx[10], origxprime[10], zzz[19], xx[19], zz[19], xxprime[19],
-  //       zzprime[19], zzzprime[19], xxxprime[19];
+                   const limb *qmqp, /* input Q - Q' */
+                   limb *scratch) {
+  limb *origx = scratch;
+  limb *origxprime = origx + 10;
+  limb *zzz = origxprime + 10;
+  limb *xx = zzz + 19;
+  limb *zz = xx + 19;
+  limb *xxprime = zz + 19;
+  limb *zzprime = xxprime + 19;
+  limb *zzzprime = zzprime + 19;
+  limb *xxxprime = zzzprime + 19;
 
   memcpy(origx, x, 10 * sizeof(limb));
   fsum(x, z);
@@ -616,16 +625,6 @@ static void fmonty(limb *x2, limb *z2,  /* output 2Q */
   fproduct(z2, zz, zzz);
   freduce_degree(z2);
   freduce_coefficients(z2);
-
-  free(origx);
-  free(origxprime);
-  free(zzz);
-  free(xx);
-  free(zz);
-  free(xxprime);
-  free(zzprime);
-  free(zzzprime);
-  free(xxxprime);
 }
 
 /* Conditionally swap two reduced-form limb arrays if 'iswap' is 1, but leave
@@ -655,34 +654,33 @@ swap_conditional(limb a[19], limb b[19], limb iswap) {
  *   resultx/resultz: the x coordinate of the resulting curve point (short form)
  *   n: a little endian, 32-byte number
  *   q: a point of the curve (short form)
+ *
+ * All working storage comes from a single allocation. If it fails the result
+ * is 0/0, which curve25519_donna turns into an all-zero output, the same value
+ * it returns for a low order input point.
  */
 static void
 cmult(limb *resultx, limb *resultz, const u8 *n, const limb *q) {
-  limb *a = calloc(19, sizeof(limb));
-
-
-  limb *b = calloc(19, sizeof(limb));
-  b[0]=1;
+  limb *block = calloc(8 * 19 + FMONTY_SCRATCH_LIMBS, sizeof(limb));
+  limb *a, *b, *c, *d, *e, *f, *g, *h;
 
-  limb *c = calloc(19, sizeof(limb));
-  c[0]=1;
-
-  limb *d = calloc(19, sizeof(limb));
-
-  limb *e = calloc(19, sizeof(limb));
-
-  limb *f = calloc(19, sizeof(limb));
-  f[0]=1;
-
-  limb *g = calloc(19, sizeof(limb));
-
-  limb *h = calloc(19, sizeof(limb));
-  h[0]=1;
+  if (block == NULL) {
+    memset(resultx, 0, sizeof(limb) * 10);
+    memset(resultz, 0, sizeof(limb) * 10);
+    return;
+  }
 
+  /* a = 0, b = 1, c = 1, d = 0, e = 0, f = 1, g = 0, h = 1 */
+  a = block;
+  b = a + 19; b[0] = 1;
+  c = b + 19; c[0] = 1;
+  d = c + 19;
+  e = d + 19;
+  f = e + 19; f[0] = 1;
+  g = f + 19;
+  h = g + 19; h[0] = 1;
 
- // limb a[19] = {0}, b[19] = {1}, c[19] = {1}, d[19] = {0};
   limb *nqpqx = a, *nqpqz = b, *nqx = c, *nqz = d, *t;
- // limb e[19] = {0}, f[19] = {1}, g[19] = {0}, h[19] = {1};
   limb *nqpqx2 = e, *nqpqz2 = f, *nqx2 = g, *nqz2 = h;
 
   unsigned i, j;
@@ -700,7 +698,7 @@ cmult(limb *resultx, limb *resultz, const u8 *n, const limb *q) {
              nqpqx2, nqpqz2,
              nqx, nqz,
              nqpqx, nqpqz,
-             q);
+             q, h + 19);
       swap_conditional(nqx2, nqpqx2, bit);
       swap_conditional(nqz2, nqpqz2, bit);
 
@@ -724,14 +722,7 @@ cmult(limb *resultx, limb *resultz, const u8 *n, const limb *q) {
   memcpy(resultx, nqx, sizeof(limb) * 10);
   memcpy(resultz, nqz, sizeof(limb) * 10);
 
-  free(a);
-  free(b);
-  free(c);
-  free(d);
-  free(e);
-  free(f);
-  free(g);
-  free(h);
+  free(block);
 }
 
 // -----------------------------------------------------------------------------
@@ -804,29 +795,65 @@ crecip(limb *out, const limb *z) {
   /* 2^255 - 21 */ fmul(out,t1,z11);
 }
 
-static const unsigned char		kCurve25519BasePoint[ 32 ] = { 9 };
+/* Field element interface used by curve25519-donna-base.c. Sums and
+ * differences are reduced straight away so every element stays in reduced
+ * coefficient form and can go into fmul/fsquare (which truncate to s32).
+ */
+#define FE_LIMBS 10
+typedef limb fe[FE_LIMBS];
 
-void
-curve25519_donna(u8 *mypublic, const u8 *secret, const u8 *basepoint) {
-  limb bp[10], x[10], z[11], zmone[10];
-  uint8_t e[32];
-  int i;
+static void
+fe_add(limb *output, const limb *a, const limb *b) {
+  limb t[11];
+  unsigned i;
+  for (i = 0; i < 10; ++i) t[i] = a[i] + b[i];
+  freduce_coefficients(t);
+  memcpy(output, t, sizeof(limb) * 10);
+}
 
-  if (basepoint == NULL) basepoint = kCurve25519BasePoint;
+static void
+fe_sub(limb *output, const limb *a, const limb *b) {
+  limb t[11];
+  unsigned i;
+  for (i = 0; i < 10; ++i) t[i] = a[i] - b[i];
+  freduce_coefficients(t);
+  memcpy(output, t, sizeof(limb) * 10);
+}
+
+/* fcontract only makes the limbs non-negative, values in [p, 2^255) are left
+ * as they are. Finish with a constant time subtraction of p so that equal
+ * elements always give the same bytes.
+ */
+static void
+fe_tobytes(u8 *output, const limb *in) {
+  limb t[11];
+  u8 s[32];
+  unsigned i, c;
+  u8 mask;
 
-  for (i = 0; i < 32; ++i) e[i] = secret[i];
-  e[0] &= 248;
-  e[31] &= 127;
-  e[31] |= 64;
+  memcpy(t, in, sizeof(limb) * 10);
+  freduce_coefficients(t);
+  fcontract(output, t);
 
-  fexpand(bp, basepoint);
-  cmult(x, z, e, bp);
-  crecip(zmone, z);
-  fmul(z, x, zmone);
-  freduce_coefficients(z);
-  fcontract(mypublic, z);
+  /* output >= p  <=>  output + 19 >= 2^255 */
+  c = 19;
+  for (i = 0; i < 32; ++i) {
+    c += output[i];
+    s[i] = (u8)c;
+    c >>= 8;
+  }
+  mask = (u8)-(s[31] >> 7);
+  s[31] &= 127;
+  for (i = 0; i < 32; ++i) output[i] ^= mask & (output[i] ^ s[i]);
 }
 
+#define fe_mul fmul
+#define fe_sq fsquare
+#define fe_frombytes fexpand
+#define fe_invert crecip
+
 #endif // !CURVE25519_64_BIT
 
+// Fixed-base, batched and dispatching entry points shared by both field implementations.
 
+#include "curve25519-donna-base.c"
@@ -53,12 +53,27 @@
 #ifndef	__curve25519_donnaDotH__
 #define	__curve25519_donnaDotH__
 
+#include <stddef.h>
+
 #ifdef	__cplusplus
 	extern "C" {
 #endif
 
+// Computes outKey = inSecret * inBasePoint. A NULL inBasePoint (or the encoding of 9) selects the precomputed
+// fixed-base path, so public key generation does not need a separate call.
+
 void curve25519_donna( unsigned char *outKey, const unsigned char *inSecret, const unsigned char *inBasePoint );
 
+// Public key generation: same as curve25519_donna( outKey, inSecret, NULL ).
+
+void curve25519_donna_base( unsigned char *outKey, const unsigned char *inSecret );
+
+// Runs inCount independent curve25519_donna operations and shares the final field inversion between them.
+// outKeys, inSecrets and inBasePoints are arrays of inCount 32-byte values; a NULL inBasePoints generates public keys.
+// Results are identical to calling curve25519_donna for each entry.
+
+void curve25519_donna_batch( unsigned char *outKeys, const unsigned char *inSecrets, const unsigned char *inBasePoints, size_t inCount );
+
 #ifdef	__cplusplus
 	}
 #endif
@@ -322,6 +322,7 @@ OSStatus _connectFTCServer( mico_Context_t * const inContext, int *fd)
   struct      sockaddr_t addr;
   json_object *easylink_report = NULL;
   const char  *json_str;
+  SocketIOVec_t iov[2];
   char host[16] = {0};
   
   size_t      httpResponseLen = 0;
@@ -343,14 +344,17 @@ OSStatus _connectFTCServer( mico_Context_t * const inContext, int *fd)
   inet_ntoa( host, inContext->flashContentInRam.micoSystemConfig.easylinkServerIP);
   easylink_log("Send config object=%s", json_str);
   //err =  CreateHTTPMessage( "POST", kEasyLinkURLAuth, kMIMEType_JSON, (uint8_t *)json_str, strlen(json_str), &httpResponse, &httpResponseLen );
-  err =  CreateHTTPMessageWithHost( "POST", kEasyLinkURLAuth, host, addr.s_port, kMIMEType_JSON, (uint8_t *)json_str, strlen(json_str), &httpResponse, &httpResponseLen );
+  err =  CreateHTTPMessageWithHost( "POST", kEasyLinkURLAuth, host, addr.s_port, kMIMEType_JSON, NULL, strlen(json_str), &httpResponse, &httpResponseLen );
   require_noerr( err, exit );
   require( httpResponse, exit );
 
-  json_object_put(easylink_report);
-
-  err = SocketSend( *fd, httpResponse, httpResponseLen );
+  iov[0].buf = httpResponse;
+  iov[0].len = httpResponseLen;
+  iov[1].buf = json_str;
+  iov[1].len = strlen(json_str);
+  err = SocketSendv( *fd, iov, 2, NULL );
   free(httpResponse);
+  json_object_put(easylink_report);
   require_noerr( err, exit );
   easylink_log("Current configuration sent");
 
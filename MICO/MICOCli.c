@@ -1,6 +1,8 @@
 #include "MICO.h"
 #include "MICODefine.h"
 #include "MICOCli.h"
+#include "MICONotificationCenter.h"
+#include "MICOSystemMonitor.h"
 #include "stdarg.h"
 #include "platform_config.h"
 #include "tftp/tftp.h"
@@ -15,9 +17,20 @@
 #define PROMPT			"\r\n# "
 #define EXIT_MSG		"exit"
 #define NUM_BUFFERS		1
-#define MAX_COMMANDS	50
 #define INBUF_SIZE      80
 #define OUTBUF_SIZE     1280
+#define MAX_ARGS        16
+#define CMD_SEPARATOR   ';'
+
+/* Radix trie node, one edge of the command names. Labels point into the
+* registered names, so the table itself never copies a name. */
+struct cli_node {
+  const char *label;
+  unsigned char len;
+  struct cli_node *child;       /* children sorted by first label char */
+  struct cli_node *next;
+  const struct cli_command *command;  /* a command name ends here */
+};
 
 #ifdef CONFIG_PLATFORM_8195A
 #define LOG_SERVICE_BUFLEN 100
@@ -30,7 +43,7 @@ char log_buf[LOG_SERVICE_BUFLEN];
 
 struct cli_st {
   int initialized;
-  const struct cli_command *commands[MAX_COMMANDS];
+  struct cli_node root;
   unsigned int num_commands;
   int echo_disabled;
   char outbuf[OUTBUF_SIZE];
@@ -46,7 +59,7 @@ struct cli_st {
   unsigned int bp;	/* buffer pointer */
   char inbuf[INBUF_SIZE];
   char outbuf[OUTBUF_SIZE];
-  const struct cli_command *commands[MAX_COMMANDS];
+  struct cli_node root;
   unsigned int num_commands;
   int echo_disabled;
   
@@ -66,39 +79,173 @@ static const mico_uart_config_t cli_uart_config =
 };
 #endif
 
+static void print_bad_command(char *cmd_string);
+static void print_commands(struct cli_node *node, int with_help);
+static void cli_trie_free(struct cli_node *node);
+
+/* Follow the trie along str, node and off (chars of node->label matched)
+* keep the position between calls.
+* Returns: 1 if the whole string matched, 0 otherwise.
+*/
+static int cli_trie_walk(struct cli_node **node, int *off, const char *str, int len)
+{
+  struct cli_node *child;
+  
+  while (len-- > 0) {
+    if (*off < (*node)->len) {
+      if ((*node)->label[(*off)++] != *str++)
+        return 0;
+      continue;
+    }
+    for (child = (*node)->child; child != NULL && child->label[0] < *str; child = child->next);
+    if (child == NULL || child->label[0] != *str++)
+      return 0;
+    *node = child;
+    *off = 1;
+  }
+  return 1;
+}
+
+/* Any command below node, every leaf of the trie holds one */
+static const struct cli_command *cli_trie_any(struct cli_node *node)
+{
+  while (node->command == NULL)
+    node = node->child;
+  return node->command;
+}
+
 /* Find the command 'name' in the cli commands table.
-* If len is 0 then full match will be performed else upto len bytes.
 * Returns: a pointer to the corresponding cli_command struct or NULL.
 */
-static const struct cli_command *lookup_command(char *name, int len)
+static const struct cli_command *lookup_command(const char *name, int len)
 {
-  int i = 0;
-  int n = 0;
+  struct cli_node *node = &pCli->root;
+  int off = 0;
   
-  while (i < MAX_COMMANDS && n < pCli->num_commands) {
-    if (pCli->commands[i]->name == NULL) {
-      i++;
-      continue;
+  if (!cli_trie_walk(&node, &off, name, len) || off != node->len)
+    return NULL;
+  return node->command;
+}
+
+/* Find the longest command matching the leading arguments: command groups
+* are registered with a space in their names, like "wifi scan".
+* Returns: the command and the number of arguments its name spans, or NULL.
+*/
+static const struct cli_command *lookup_argv(int argc, char **argv, int *used)
+{
+  const struct cli_command *command = NULL;
+  struct cli_node *node = &pCli->root;
+  int i, off = 0;
+  const char *p;
+  
+  for (i = 0; i < argc; i++) {
+    if ((i > 0 && !cli_trie_walk(&node, &off, " ", 1)) ||
+        !cli_trie_walk(&node, &off, argv[i], strlen(argv[i])))
+      break;
+    if (off == node->len && node->command != NULL) {
+      command = node->command;
+      *used = i + 1;
     }
-    /* See if partial or full match is expected */
-    if (len != 0) {
-      if (!strncmp(pCli->commands[i]->name, name, len))
-        return pCli->commands[i];
-    } else {
-      if (!strcmp(pCli->commands[i]->name, name))
-        return pCli->commands[i];
+  }
+  
+  /*
+  * Some comamands can allow extensions like foo.a, foo.b and hence
+  * compare commands before first dot.
+  */
+  if (command == NULL && (p = strchr(argv[0], '.')) != NULL) {
+    command = lookup_command(argv[0], p - argv[0]);
+    *used = 1;
+  }
+  return command;
+}
+
+/* Split the first command of line into arguments. Arguments are returned as
+* spans of line, nothing is copied: quotes are outside the span, escaped
+* characters (\\, \", \; and "\ ") keep their backslash and set escaped.
+* Several commands on one line are separated by ';'. Re-entrant.
+*
+* Returns: the number of arguments, or -1 on invalid syntax. *next is the
+*          command following a separator, NULL at the end of the line.
+*/
+int cli_tokenize(char *line, struct cli_token *tokens, int max_tokens, char **next)
+{
+  int num = 0, quote;
+  char *p = line;
+  
+  *next = NULL;
+  while (1) {
+    while (*p == ' ' || *p == '\t')
+      p++;
+    if (*p == '\0')
+      return num;
+    if (*p == CMD_SEPARATOR) {
+      *next = p + 1;
+      return num;
     }
+    if (num == max_tokens)
+      return -1;
     
-    i++;
-    n++;
+    quote = (*p == '"');
+    if (quote)
+      p++;
+    tokens[num].start = p;
+    tokens[num].escaped = 0;
+    while (*p != '\0') {
+      if (*p == '\\' && (p[1] == '\\' || p[1] == '"' || p[1] == ' ' || p[1] == CMD_SEPARATOR)) {
+        tokens[num].escaped = 1;
+        p += 2;
+        continue;
+      }
+      if (quote ? *p == '"' : (*p == ' ' || *p == '\t' || *p == CMD_SEPARATOR))
+        break;
+      p++;
+    }
+    if (quote && *p != '"')
+      return -1;
+    tokens[num].len = p - tokens[num].start;
+    num++;
+    if (quote)
+      p++;
+  }
+}
+
+/* Make a token a C string in place, removing its escape backslashes */
+static char *cli_token_str(struct cli_token *token)
+{
+  char *src = token->start, *dst = token->start, *end = token->start + token->len;
+  
+  if (token->escaped) {
+    while (src < end) {
+      if (*src == '\\' && src + 1 < end)
+        src++;
+      *dst++ = *src++;
+    }
+    end = dst;
   }
+  *end = '\0';
+  return token->start;
+}
+
+/* Print the commands of a group, when argv[0] is only a group name */
+static int show_group(const char *name)
+{
+  struct cli_node *node = &pCli->root, *child;
+  int off = 0;
   
-  return NULL;
+  if (!cli_trie_walk(&node, &off, name, strlen(name)) || off != node->len)
+    return 0;
+  for (child = node->child; child != NULL && child->label[0] != ' '; child = child->next);
+  if (child == NULL)
+    return 0;
+  cli_printf("\r\n%s commands:", name);
+  print_commands(child, 0);
+  return 1;
 }
 
 /* Parse input line and locate arguments (if any), keeping count of the number
 * of arguments and their locations.  Look up and call the corresponding cli
-* function if one is found and pass it the argv array.
+* function if one is found and pass it the argv array. A line may hold several
+* commands separated by ';', they run in order.
 *
 * Returns: 0 on success: the input line contained at least a function name and
 *          that function exists and was called.
@@ -108,139 +255,87 @@ static const struct cli_command *lookup_command(char *name, int len)
 */
 static int handle_input(char *inbuf)
 {
-  struct {
-    unsigned inArg:1;
-    unsigned inQuote:1;
-    unsigned done:1;
-  } stat;
-  static char *argv[16];
-  int argc = 0;
-  int i = 0;
-  const struct cli_command *command = NULL;
-  const char *p;
-  
-  
-  memset((void *)&argv, 0, sizeof(argv));
-  memset(&stat, 0, sizeof(stat));
-  
-  do {
-    switch (inbuf[i]) {
-    case '\0':
-      if (stat.inQuote)
-        return 2;
-      stat.done = 1;
-      break;
-      
-    case '"':
-      if (i > 0 && inbuf[i - 1] == '\\' && stat.inArg) {
-        memcpy(&inbuf[i - 1], &inbuf[i],
-               strlen(&inbuf[i]) + 1);
-        --i;
-        break;
-      }
-      if (!stat.inQuote && stat.inArg)
-        break;
-      if (stat.inQuote && !stat.inArg)
-        return 2;
-      
-      if (!stat.inQuote && !stat.inArg) {
-        stat.inArg = 1;
-        stat.inQuote = 1;
-        argc++;
-        argv[argc - 1] = &inbuf[i + 1];
-      } else if (stat.inQuote && stat.inArg) {
-        stat.inArg = 0;
-        stat.inQuote = 0;
-        inbuf[i] = '\0';
-      }
-      break;
-      
-    case ' ':
-      if (i > 0 && inbuf[i - 1] == '\\' && stat.inArg) {
-        memcpy(&inbuf[i - 1], &inbuf[i],
-               strlen(&inbuf[i]) + 1);
-        --i;
-        break;
-      }
-      if (!stat.inQuote && stat.inArg) {
-        stat.inArg = 0;
-        inbuf[i] = '\0';
-      }
-      break;
-      
-    default:
-      if (!stat.inArg) {
-        stat.inArg = 1;
-        argc++;
-        argv[argc - 1] = &inbuf[i];
+  struct cli_token tokens[MAX_ARGS];
+  char *argv[MAX_ARGS];
+  const struct cli_command *command;
+  char *next;
+  int argc, used, i, ret = 0;
+  
+  for (; inbuf != NULL; inbuf = next) {
+    argc = cli_tokenize(inbuf, tokens, MAX_ARGS, &next);
+    if (argc < 0) {
+      cli_printf("syntax error\r\n");
+      return 2;
+    }
+    if (argc == 0)
+      continue;
+    for (i = 0; i < argc; i++)
+      argv[i] = cli_token_str(&tokens[i]);
+    
+    if (!pCli->echo_disabled)
+      cli_printf("\r\n");
+    
+    command = lookup_argv(argc, argv, &used);
+    if (command == NULL) {
+      if (!show_group(argv[0])) {
+        print_bad_command(argv[0]);
+        ret = 1;
       }
-      break;
+      continue;
     }
-  } while (!stat.done && ++i < INBUF_SIZE);
-  
-  if (stat.inQuote)
-    return 2;
-  
-  if (argc < 1)
-    return 0;
-  
-  if (!pCli->echo_disabled)
-    cli_printf("\r\n");
-  
-  /*
-  * Some comamands can allow extensions like foo.a, foo.b and hence
-  * compare commands before first dot.
-  */
-  i = ((p = strchr(argv[0], '.')) == NULL) ? 0 :
-    (p - argv[0]);
-    command = lookup_command(argv[0], i);
-    if (command == NULL)
-      return 1;
     
     memset(pCli->outbuf, 0, OUTBUF_SIZE);
-	cli_putstr("\r\n");
-    command->function(pCli->outbuf, OUTBUF_SIZE, argc, argv);
+    cli_putstr("\r\n");
+    command->function(pCli->outbuf, OUTBUF_SIZE, argc - used + 1, argv + used - 1);
     cli_putstr(pCli->outbuf);
-    return 0;
+  }
+  return ret;
+}
+
+/* Print the names of all commands below node, in alphabetical order */
+static void print_commands(struct cli_node *node, int with_help)
+{
+  for (; node != NULL; node = node->next) {
+    if (node->command != NULL) {
+      if (with_help)
+        cli_printf("%s: %s\r\n", node->command->name,
+                   node->command->help ? node->command->help : "");
+      else
+        cli_printf("%s ", node->command->name);
+    }
+    print_commands(node->child, with_help);
+  }
 }
 
 #ifndef CONFIG_PLATFORM_8195A
-/* Perform basic tab-completion on the input buffer by string-matching the
-* current input line against the cli functions table.  The current input line
-* is assumed to be NULL-terminated. */
+/* Perform basic tab-completion on the input buffer by walking the current
+* input line down the command trie.  The current input line is assumed to be
+* NULL-terminated. */
 static void tab_complete(char *inbuf, unsigned int *bp)
 {
-  int i, n, m;
-  const char *fm = NULL;
+  struct cli_node *node = &pCli->root;
+  int off = 0, n;
   
   cli_printf("\r\n");
   
-  /* show matching commands */
-  for (i = 0, n = 0, m = 0; i < MAX_COMMANDS && n < pCli->num_commands;
-  i++) {
-    if (pCli->commands[i]->name != NULL) {
-      if (!strncmp(inbuf, pCli->commands[i]->name, *bp)) {
-        m++;
-        if (m == 1)
-          fm = pCli->commands[i]->name;
-        else if (m == 2)
-          cli_printf("%s %s ", fm,
-                     pCli->commands[i]->name);
-        else
-          cli_printf("%s ",
-                     pCli->commands[i]->name);
-      }
-      n++;
+  if (!cli_trie_walk(&node, &off, inbuf, *bp)) {
+    /* nothing matches */
+  } else if (node == &pCli->root) {
+    print_commands(node->child, 0);
+  } else {
+    /* several matches: show them, all of them share the rest of this edge */
+    if (node->child != NULL) {
+      if (node->command != NULL)
+        cli_printf("%s ", node->command->name);
+      print_commands(node->child, 0);
     }
-  }
-  
-  /* there's only one match, so complete the line */
-  if (m == 1 && fm) {
-    n = strlen(fm) - *bp;
-    if (*bp + n < INBUF_SIZE) {
-      memcpy(inbuf + *bp, fm + *bp, n);
+    n = node->len - off;
+    if (*bp + n + 1 < INBUF_SIZE) {
+      memcpy(inbuf + *bp, node->label + off, n);
       *bp += n;
-      inbuf[(*bp)++] = ' ';
+      /* there's only one match, so complete the line */
+      if (node->child == NULL)
+        inbuf[(*bp)++] = ' ';
       inbuf[*bp] = '\0';
     }
   }
@@ -332,7 +427,6 @@ static void print_bad_command(char *cmd_string)
 static void cli_main(void *data)
 {
   while (1) {
-    int ret;
     char *msg = NULL;
 	
 #ifndef CONFIG_PLATFORM_8195A
@@ -347,16 +441,14 @@ static void cli_main(void *data)
     if (msg != NULL) {
       if (strcmp(msg, EXIT_MSG) == 0)
         break;
-      ret = handle_input(msg);
-      if (ret == 1)
-        print_bad_command(msg);
-      else if (ret == 2)
-        cli_printf("syntax error\r\n");
+      /* unknown commands and syntax errors are reported by handle_input */
+      handle_input(msg);
       cli_printf(PROMPT);
     }
   }
   
   cli_printf("CLI exited\r\n");
+  cli_trie_free(pCli->root.child);
   free(pCli);
   pCli = NULL;
   mico_rtos_delete_thread(NULL);
@@ -417,8 +509,10 @@ static void partShow_Command(char *pcWriteBuffer, int xWriteBufferLen,int argc,
     mico_partition_t i;
     mico_logic_partition_t *partition;
 
-    for( i = MICO_PARTITION_BOOTLOADER; i <= MICO_PARTITION_PARAMETER_2; i++ ){
+    for( i = MICO_PARTITION_BOOTLOADER; i < MICO_PARTITION_MAX; i++ ){
         partition = MicoFlashGetInfo( i );
+        if( partition->partition_description == NULL )
+            continue;
         cmd_printf( "%4d | %11s |  Dev:%d  | 0x%08x | 0x%08x |\r\n", i,
             partition->partition_description, partition->partition_owner, 
             partition->partition_start_addr, partition->partition_length);
@@ -431,6 +525,16 @@ static void uptime_Command(char *pcWriteBuffer, int xWriteBufferLen,int argc, ch
     cmd_printf("UP time %dms\r\n", mico_get_time());
 }
 
+static void notify_Command(char *pcWriteBuffer, int xWriteBufferLen,int argc, char **argv)
+{
+    MICONotificationShowStats(pcWriteBuffer, xWriteBufferLen, (argc > 1 && !strcasecmp(argv[1], "reset")) ? true : false);
+}
+
+static void monitor_Command(char *pcWriteBuffer, int xWriteBufferLen,int argc, char **argv)
+{
+    MICOSystemMonitorShowStats(pcWriteBuffer, xWriteBufferLen, (argc > 1 && !strcasecmp(argv[1], "reset")) ? true : false);
+}
+
 static void ota_Command(char *pcWriteBuffer, int xWriteBufferLen,int argc, char **argv)
 {
 extern void mico_force_ota(void);
@@ -445,17 +549,8 @@ extern void mico_force_ota(void);
 * text string, if any. */
 static void help_command(char *pcWriteBuffer, int xWriteBufferLen,int argc, char **argv)
 {
-  int i, n;
-  
-  cmd_printf("\r\n");
-  for (i = 0, n = 0; i < MAX_COMMANDS && n < pCli->num_commands; i++) {
-    if (pCli->commands[i]->name) {
-      cmd_printf("%s: %s\r\n", pCli->commands[i]->name,
-                 pCli->commands[i]->help ?
-                   pCli->commands[i]->help : "");
-      n++;
-    }
-  }
+  cli_printf("\r\n");
+  print_commands(pCli->root.child, 1);
 }
 
 static void get_version(char *pcWriteBuffer, int xWriteBufferLen,int argc, char **argv)
@@ -564,53 +659,144 @@ static const struct cli_command built_ins[] = {
   {"tftp",     "tftp",                        tftp_Command},
   {"time",     "system time",                 uptime_Command},
   {"ota",      "system ota",                  ota_Command},
+  {"notify",   "notify [reset], show notification stats", notify_Command},
+  {"monitor",  "monitor [reset], show system monitors", monitor_Command},
 #endif
   {"flash",    "Flash memory map",            partShow_Command},
   {"ps",      "ps on/off",   ps_Command}
 };
 
+static struct cli_node *cli_node_new(const char *label, int len, const struct cli_command *command)
+{
+  struct cli_node *node = (struct cli_node *)malloc(sizeof(struct cli_node));
+  
+  if (node != NULL) {
+    memset(node, 0, sizeof(struct cli_node));
+    node->label = label;
+    node->len = len;
+    node->command = command;
+  }
+  return node;
+}
+
+static void cli_trie_free(struct cli_node *node)
+{
+  struct cli_node *next;
+  
+  for (; node != NULL; node = next) {
+    next = node->next;
+    cli_trie_free(node->child);
+    free(node);
+  }
+}
+
 int cli_register_command(const struct cli_command *command)
 {
-  int i;
-  if (!command->name || !command->function)
+  struct cli_node *node = &pCli->root, **link, *child, *split;
+  const char *name = command->name;
+  int depth = 0, i;
+  
+  if (!command->name || !command->function || strlen(command->name) > 255)
     return 1;
   
-  if (pCli->num_commands < MAX_COMMANDS) {
-    /* Check if the command has already been registered.
-    * Return 0, if it has been registered.
-    */
-    for (i = 0; i < pCli->num_commands; i++) {
-      if (pCli->commands[i] == command)
-        return 0;
+  while (name[depth] != '\0') {
+    for (link = &node->child; *link != NULL && (*link)->label[0] < name[depth]; link = &(*link)->next);
+    child = *link;
+    if (child == NULL || child->label[0] != name[depth]) {
+      /* new leaf for the rest of the name */
+      if ((child = cli_node_new(&name[depth], strlen(&name[depth]), command)) == NULL)
+        return 1;
+      child->next = *link;
+      *link = child;
+      pCli->num_commands++;
+      return 0;
     }
-    pCli->commands[pCli->num_commands++] = command;
-    return 0;
+    for (i = 1; i < child->len && child->label[i] == name[depth + i]; i++);
+    if (i < child->len) {
+      /* the name leaves this edge half way, split it */
+      if ((split = cli_node_new(child->label, i, NULL)) == NULL)
+        return 1;
+      split->child = child;
+      split->next = child->next;
+      child->label += i;
+      child->len -= i;
+      child->next = NULL;
+      *link = split;
+      child = split;
+    }
+    node = child;
+    depth += i;
   }
   
-  return 1;
+  /* Check if the command has already been registered.
+  * Return 0, if it has been registered. A different command under the same
+  * name is skipped, the first one registered keeps the name as it used to.
+  */
+  if (node->command != NULL)
+    return 0;
+  node->command = command;
+  pCli->num_commands++;
+  return 0;
 }
 
 int cli_unregister_command(const struct cli_command *command)
 {
-  int i;
+  struct cli_node *node = &pCli->root, *parent = NULL, *child;
+  struct cli_node **link = NULL, **parent_link = NULL, **pos;
+  const char *name = command->name;
+  int depth = 0, parent_depth = 0, len;
+  
   if (!command->name || !command->function)
     return 1;
   
-  for (i = 0; i < pCli->num_commands; i++) {
-    if (pCli->commands[i] == command) {
-      pCli->num_commands--;
-      int remaining_cmds = pCli->num_commands - i;
-      if (remaining_cmds > 0) {
-        memmove(&pCli->commands[i], &pCli->commands[i + 1],
-                (remaining_cmds *
-                 sizeof(struct cli_command *)));
-      }
-      pCli->commands[pCli->num_commands] = NULL;
-      return 0;
-    }
+  len = strlen(name);
+  while (depth < len) {
+    for (pos = &node->child; *pos != NULL && (*pos)->label[0] != name[depth]; pos = &(*pos)->next);
+    if (*pos == NULL || (*pos)->len > len - depth || memcmp((*pos)->label, &name[depth], (*pos)->len))
+      return 1;
+    parent = node;
+    parent_link = link;
+    parent_depth = depth;
+    link = pos;
+    node = *pos;
+    depth += node->len;
   }
+  if (node->command != command)
+    return 1;
   
-  return 1;
+  node->command = NULL;
+  pCli->num_commands--;
+  if (node->child == NULL) {
+    /* drop the leaf, its parent may be left with a single child */
+    *link = node->next;
+    free(node);
+    node = parent;
+    link = parent_link;
+    depth = parent_depth;
+  }
+  if (node != &pCli->root && node->command == NULL && node->child != NULL && node->child->next == NULL) {
+    /* merge the node into its only child */
+    child = node->child;
+    child->label = cli_trie_any(child)->name + depth - node->len;
+    child->len += node->len;
+    child->next = node->next;
+    *link = child;
+    free(node);
+  }
+  
+  /* labels may point into the name going away, move them to a name still registered */
+  node = &pCli->root;
+  depth = 0;
+  while (depth < len) {
+    for (child = node->child; child != NULL && child->label[0] != name[depth]; child = child->next);
+    if (child == NULL)
+      break;
+    if (child->label >= name && child->label < name + len)
+      child->label = cli_trie_any(child)->name + depth;
+    node = child;
+    depth += node->len;
+  }
+  return 0;
 }
 
 int cli_register_commands(const struct cli_command *commands, int num_commands)
@@ -696,6 +882,7 @@ int MicoCliInit(void)
   if (cli_register_commands(&built_ins[0],
                             sizeof(built_ins) /
                               sizeof(struct cli_command))) {
+                                cli_trie_free(pCli->root.child);
                                 free(pCli);
                                 pCli = NULL;
                                 return kGeneralErr;
@@ -711,6 +898,7 @@ int MicoCliInit(void)
   if (ret != kNoErr) {
     printf("Error: Failed to create cli thread: %d\r\n",
                ret);
+    cli_trie_free(pCli->root.child);
     free(pCli);
     pCli = NULL;
     return kGeneralErr;
@@ -745,6 +933,7 @@ int MicoCliInit(void)
   if (cli_register_commands(&built_ins[0],
                             sizeof(built_ins) /
                               sizeof(struct cli_command))) {
+                                cli_trie_free(pCli->root.child);
                                 free(pCli);
                                 pCli = NULL;
                                 return kGeneralErr;
@@ -758,6 +947,7 @@ int MicoCliInit(void)
   if (ret != kNoErr) {
     cli_printf("Error: Failed to create cli thread: %d\r\n",
                ret);
+    cli_trie_free(pCli->root.child);
     free(pCli);
     pCli = NULL;
     return kGeneralErr;
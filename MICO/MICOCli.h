@@ -2,7 +2,8 @@
 #define __MICO_CLI_H__
 /** Structure for registering CLI commands */
 struct cli_command {
-	/** The name of the CLI command */
+	/** The name of the CLI command. Commands of a group are named
+	 * "group command", they get argv[0] set to "command". */
 	const char *name;
 	/** The help text associated with the command */
 	const char *help;
@@ -25,6 +26,27 @@ struct cli_command {
 
 #define CLI_ARGS char *pcWriteBuffer, int xWriteBufferLen, int argc, char **argv
 
+/** One argument of an input line, a span of the line itself */
+struct cli_token {
+	char *start;
+	unsigned short len;
+	unsigned short escaped;	/**< holds backslash escapes */
+};
+
+/** Split the first command of a line into arguments
+ *
+ * Quoted arguments and backslash escapes are supported, commands on one line
+ * are separated by ';'. Nothing is copied and no state is kept.
+ *
+ * \param[in] line The input line
+ * \param[out] tokens Arguments found
+ * \param[in] max_tokens Size of tokens
+ * \param[out] next The next command on the line, NULL if none
+ * \return the number of arguments
+ * \return -1 on syntax error
+ */
+int cli_tokenize(char *line, struct cli_token *tokens, int max_tokens, char **next);
+
 /** Register a CLI command
  *
  * This function registers a command with the command-line interface.
@@ -49,6 +49,23 @@
 
 #define kMIMEType_MXCHIP_OTA    "application/ota-stream"
 
+typedef enum {
+  eConfigRoute_Read,
+  eConfigRoute_Write,
+  eConfigRoute_WriteByUAP,
+  eConfigRoute_OTA,
+  eConfigRoute_Max
+} configRoute_t;
+
+/* Request paths are looked up once through the router, not compared against every URL in turn. */
+static const URLRoute configRoutes[eConfigRoute_Max] = {
+  [eConfigRoute_Read]       = { kCONFIGURLRead,       0, NULL },
+  [eConfigRoute_Write]      = { kCONFIGURLWrite,      0, NULL },
+  [eConfigRoute_WriteByUAP] = { kCONFIGURLWriteByUAP, 0, NULL },
+  [eConfigRoute_OTA]        = { kCONFIGURLOTA,        0, NULL },
+};
+static URLRouter configRouter;
+
 typedef struct _configContext_t{
   uint32_t offset;
   bool     isFlashLocked;
@@ -69,7 +86,16 @@ static void onClearHTTPHeader(struct _HTTPHeader_t * httpHeader, void * userCont
 
 OSStatus MICOStartConfigServer ( mico_Context_t * const inContext )
 {
-  return mico_rtos_create_thread(NULL, MICO_APPLICATION_PRIORITY, "Config Server", localConfiglistener_thread, STACK_SIZE_LOCAL_CONFIG_SERVER_THREAD, (void*)inContext );
+  OSStatus err = kNoErr;
+
+  if( configRouter.nodes == NULL ){
+    err = URLRouterInit( &configRouter, configRoutes, eConfigRoute_Max );
+    require_noerr( err, exit );
+  }
+  err = mico_rtos_create_thread(NULL, MICO_APPLICATION_PRIORITY, "Config Server", localConfiglistener_thread, STACK_SIZE_LOCAL_CONFIG_SERVER_THREAD, (void*)inContext );
+
+exit:
+  return err;
 }
 
 void localConfiglistener_thread(void *inContext)
@@ -283,13 +309,17 @@ OSStatus _LocalConfigRespondInComingMessage(int fd, HTTPHeader_t* inHeader, mico
   uint8_t *httpResponse = NULL;
   size_t httpResponseLen = 0;
   json_object* report = NULL;
+  SocketIOVec_t iov[2];
   uint16_t crc;
   configContext_t *http_context = (configContext_t *)inHeader->userContext;
   mico_logic_partition_t* ota_partition = MicoFlashGetInfo( MICO_PARTITION_OTA_TEMP );
+  const URLRoute *route;
 
   config_log_trace();
 
-  if(HTTPHeaderMatchURL( inHeader, kCONFIGURLRead ) == kNoErr){    
+  route = HTTPHeaderRouteURL( inHeader, &configRouter, NULL, NULL );
+
+  if(route == &configRoutes[eConfigRoute_Read]){    
     report = ConfigCreateReportJsonMessage( inContext );
     require( report, exit );
     json_str = json_object_to_json_string(report);
@@ -298,14 +328,16 @@ OSStatus _LocalConfigRespondInComingMessage(int fd, HTTPHeader_t* inHeader, mico
     err =  CreateSimpleHTTPMessageNoCopy( kMIMEType_JSON, strlen(json_str), &httpResponse, &httpResponseLen );
     require_noerr( err, exit );
     require( httpResponse, exit );
-    err = SocketSend( fd, httpResponse, httpResponseLen );
-    require_noerr( err, exit );
-    err = SocketSend( fd, (uint8_t *)json_str, strlen(json_str) );
+    iov[0].buf = httpResponse;
+    iov[0].len = httpResponseLen;
+    iov[1].buf = json_str;
+    iov[1].len = strlen(json_str);
+    err = SocketSendv( fd, iov, 2, NULL );
     require_noerr( err, exit );
     config_log("Current configuration sent");
     goto exit;
   }
-  else if(HTTPHeaderMatchURL( inHeader, kCONFIGURLWrite ) == kNoErr){
+  else if(route == &configRoutes[eConfigRoute_Write]){
     if(inHeader->contentLength > 0){
       config_log("Recv new configuration, apply and reset");
       err = ConfigIncommingJsonMessage( inHeader->extraDataPtr, inContext);
@@ -325,7 +357,7 @@ OSStatus _LocalConfigRespondInComingMessage(int fd, HTTPHeader_t* inHeader, mico
     }
     goto exit;
   }
-else if(HTTPHeaderMatchURL( inHeader, kCONFIGURLWriteByUAP ) == kNoErr){
+else if(route == &configRoutes[eConfigRoute_WriteByUAP]){
     if(inHeader->contentLength > 0){
       config_log("Recv new configuration from uAP, apply and connect to AP");
       err = ConfigIncommingJsonMessageUAP( inHeader->extraDataPtr, inContext);
@@ -347,7 +379,7 @@ else if(HTTPHeaderMatchURL( inHeader, kCONFIGURLWriteByUAP ) == kNoErr){
     }
     goto exit;
   }
-  else if(HTTPHeaderMatchURL( inHeader, kCONFIGURLOTA ) == kNoErr && ota_partition->partition_owner != MICO_FLASH_NONE){
+  else if(route == &configRoutes[eConfigRoute_OTA] && ota_partition->partition_owner != MICO_FLASH_NONE){
     if(inHeader->contentLength > 0){
       config_log("Receive OTA data!");
       CRC16_Final( &http_context->crc16_contex, &crc);
@@ -64,7 +64,7 @@
   #define STACK_SIZE_LOCAL_CONFIG_SERVER_THREAD   0x180
   #define STACK_SIZE_LOCAL_CONFIG_CLIENT_THREAD   0x3C0
   #define STACK_SIZE_NTP_CLIENT_THREAD            0x3A0
-  #define STACK_SIZE_MICO_SYSTEM_MONITOR_THREAD   0x120
+  #define STACK_SIZE_MICO_SYSTEM_MONITOR_THREAD   0x200
 #endif
 
 #define CONFIG_SERVICE_PORT     8000
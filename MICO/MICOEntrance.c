@@ -37,6 +37,7 @@
 
 #include "MICONotificationCenter.h"
 #include "MICOSystemMonitor.h"
+#include "MICOTimerService.h"
 #include "MicoCli.h"
 #include "EasyLink/EasyLink.h"
 #include "SoftAP/EasyLinkSoftAP.h"
@@ -384,6 +385,9 @@ int application_start(void)
   MICOReadConfiguration( context );
   
   err = MICOInitNotificationCenter  ( context );
+
+  err = MICOStartTimerService( );
+  require_noerr( err, exit );
   
   err = MICOAddNotification( mico_notify_WIFI_CONNECT_FAILED, (void *)micoNotify_ConnectFailedHandler );
   require_noerr( err, exit ); 
@@ -414,7 +418,7 @@ int application_start(void)
   err = MICOStartSystemMonitor(context);
   require_noerr_action( err, exit, mico_log("ERROR: Unable to start the system monitor.") );
   
-  err = MICORegisterSystemMonitor(&mico_monitor, APPLICATION_WATCHDOG_TIMEOUT_SECONDS*1000);
+  err = MICORegisterNamedSystemMonitor(&mico_monitor, "mico", APPLICATION_WATCHDOG_TIMEOUT_SECONDS*1000);
   require_noerr( err, exit );
   mico_init_timer(&_watchdog_reload_timer,APPLICATION_WATCHDOG_TIMEOUT_SECONDS*1000/2, _watchdog_reload_timer_handler, NULL);
   mico_start_timer(&_watchdog_reload_timer);
@@ -4,7 +4,8 @@
 * @author  William Xu
 * @version V1.0.0
 * @date    05-May-2014
-* @brief   Create a NTP client thread, and synchronize RTC with NTP server.
+* @brief   Create a NTP client thread, keep UTC time and RTC synchronized with
+*          several NTP servers.
 ******************************************************************************
 *
 *  The MIT License
@@ -33,6 +34,7 @@
 #include "MICODefine.h"
 #include "SocketUtils.h"
 #include "MICONotificationCenter.h"
+#include "MICONTPClient.h"
 #include "time.h"
 #include "MicoPlatform.h"
 
@@ -40,9 +42,15 @@
 #define ntp_log_trace() custom_log_trace("NTP client")
 
 
-#define UNIX_OFFSET 		         2208960000U
-#define NTP_Server               "time.asia.apple.com"
+#define UNIX_OFFSET              2208988800U     /* Seconds from 1900 to 1970 */
+#define RTC_TIMEZONE_OFFSET      28800           /* RTC keeps UTC+8 */
+#ifndef MICO_NTP_SERVERS
+#define MICO_NTP_SERVERS         "time.asia.apple.com", "cn.pool.ntp.org", "time.windows.com"
+#endif
+#ifndef NTP_Port
 #define NTP_Port                 123
+#endif
+#define NTP_Local_Port           45000
 #define NTP_Flags                0xdb 
 #define NTP_Stratum              0x0
 #define NTP_Poll                 0x0a
@@ -50,6 +58,25 @@
 #define NTP_Root_Delay           0x8000
 #define NTP_Root_Dispersion      0xa00b0000
 
+/* All times below in ms, offsets and delays in us */
+#ifndef NTP_QUERY_TIMEOUT
+#define NTP_QUERY_TIMEOUT        (3000)          /* Wait for the answers of one round */
+#endif
+#ifndef NTP_RETRY_MIN
+#define NTP_RETRY_MIN            (4000)          /* First retry after a failed round, doubled up to NTP_POLL_MIN */
+#endif
+#ifndef NTP_POLL_MIN
+#define NTP_POLL_MIN             (64*1000)
+#endif
+#ifndef NTP_POLL_MAX
+#define NTP_POLL_MAX             (1024*1000)
+#endif
+#define NTP_POLL_STABLE          (20000)         /* Corrections below this double the poll interval */
+#define NTP_STEP_THRESHOLD       (1000000)       /* Corrections above this are stepped, not slewed */
+#define NTP_OUTLIER_THRESHOLD    (50000)         /* Distance from the median, plus half the sample delay */
+#define NTP_SLEW_RATE            (500)           /* ppm */
+#define NTP_UNREACH_RESOLVE      (4)             /* Rounds without answer before resolving the name again */
+
 static volatile bool _wifiConnected = false;
 static mico_semaphore_t  _wifiConnected_sem = NULL;
 
@@ -62,7 +89,7 @@ struct NtpPacket
 	uint8_t precision;
 	uint32_t root_delay;
 	uint32_t root_dispersion;
-	uint8_t referenceID;
+	uint32_t referenceID;
 	uint32_t ref_ts_sec;
 	uint32_t ref_ts_frac;
 	uint32_t origin_ts_sec;
@@ -73,6 +100,36 @@ struct NtpPacket
 	uint32_t trans_ts_frac;
 };
 
+typedef struct
+{
+  const char* name;
+  uint32_t    ip;                 /* 0 until resolved */
+  uint32_t    xmt_sec;            /* Transmit timestamp of the query, echoed back as origin */
+  uint32_t    xmt_frac;
+  uint64_t    sent;
+  bool        waiting;
+  uint8_t     unreach;            /* Rounds in a row without a usable answer */
+} ntp_server_t;
+
+typedef struct
+{
+  int64_t offset;                 /* UTC minus monotonic time */
+  int64_t delay;                  /* Round trip without the server processing time */
+} ntp_sample_t;
+
+static const char* const _ntp_server_names[] = { MICO_NTP_SERVERS };
+#define NTP_SERVER_NUM           ((int)(sizeof(_ntp_server_names)/sizeof(_ntp_server_names[0])))
+static ntp_server_t _ntp_servers[NTP_SERVER_NUM];
+
+/* UTC = monotonic time + offset, offset moves from _slew_from to _slew_to at NTP_SLEW_RATE */
+static mico_mutex_t _ntp_mutex = NULL;
+static bool _ntp_valid = false;
+static uint32_t _mono_last = 0;
+static uint64_t _mono_high = 0;
+static uint64_t _slew_start = 0;
+static int64_t _slew_from = 0;
+static int64_t _slew_to = 0;
+
 void ntpNotify_WifiStatusHandler(int event, mico_Context_t * const inContext)
 {
   ntp_log_trace();
@@ -111,6 +168,276 @@ char* mxchipasctime(const struct tm *timeptr)
   return time_str;
 }
 
+/* mico_get_time() wraps after 49 days, called with _ntp_mutex locked */
+static uint64_t _ntp_monotonic( void )
+{
+  uint32_t now = mico_get_time();
+
+  if( now < _mono_last )
+    _mono_high += 0x100000000ULL;
+  _mono_last = now;
+  return _mono_high | now;
+}
+
+static uint64_t _ntp_now( void )
+{
+  uint64_t now;
+
+  mico_rtos_lock_mutex( &_ntp_mutex );
+  now = _ntp_monotonic( );
+  mico_rtos_unlock_mutex( &_ntp_mutex );
+  return now;
+}
+
+static int64_t _ntp_offset_at( uint64_t mono )
+{
+  int64_t slewed = (int64_t)(mono - _slew_start) * NTP_SLEW_RATE / 1000;
+
+  if( _slew_to - _slew_from > slewed )
+    return _slew_from + slewed;
+  if( _slew_from - _slew_to > slewed )
+    return _slew_from - slewed;
+  return _slew_to;
+}
+
+OSStatus MICOGetUtcTime( uint64_t *utc_ms )
+{
+  uint64_t mono;
+
+  if( _ntp_mutex == NULL || _ntp_valid == false )
+    return kNotInitializedErr;
+
+  mico_rtos_lock_mutex( &_ntp_mutex );
+  mono = _ntp_monotonic( );
+  *utc_ms = (uint64_t)((int64_t)mono * 1000 + _ntp_offset_at( mono )) / 1000;
+  mico_rtos_unlock_mutex( &_ntp_mutex );
+  return kNoErr;
+}
+
+bool MICONTPTimeIsValid( void )
+{
+  return _ntp_valid;
+}
+
+/* NTP seconds wrap in 2036, timestamps below 2^31 belong to the next era */
+static int64_t _ntp_to_unix_us( uint32_t sec, uint32_t frac )
+{
+  int64_t s = sec;
+
+  if( sec < 0x80000000U )
+    s += 0x100000000LL;
+  return ( s - UNIX_OFFSET ) * 1000000 + (int64_t)( ( (uint64_t)frac * 1000000 ) >> 32 );
+}
+
+static bool _ntp_sample( ntp_server_t *server, struct NtpPacket *packet, int len, uint64_t recv, ntp_sample_t *sample )
+{
+  int64_t t1 = (int64_t)server->sent * 1000, t4 = (int64_t)recv * 1000;
+  int64_t t2, t3;
+
+  if( len < (int)sizeof(struct NtpPacket) )
+    return false;
+  /* Server mode, no alarm, not a kiss-o'-death */
+  if( ( packet->flags & 0x07 ) != 4 || ( packet->flags >> 6 ) == 3 || packet->stratum == 0 || packet->stratum > 15 )
+    return false;
+  if( ntohl( packet->origin_ts_sec ) != server->xmt_sec || ntohl( packet->origin_ts_frac ) != server->xmt_frac )
+    return false;
+  if( packet->trans_ts_sec == 0 )
+    return false;
+
+  t2 = _ntp_to_unix_us( ntohl( packet->recv_ts_sec ), ntohl( packet->recv_ts_frac ) );
+  t3 = _ntp_to_unix_us( ntohl( packet->trans_ts_sec ), ntohl( packet->trans_ts_frac ) );
+  sample->offset = ( ( t2 - t1 ) + ( t3 - t4 ) ) / 2;
+  sample->delay = ( t4 - t1 ) - ( t3 - t2 );
+  /* Local clock only counts ms */
+  if( sample->delay < 0 )
+    sample->delay = 0;
+  return true;
+}
+
+/* Query all servers at once, returns the number of usable samples */
+static int _ntp_query_round( int fd, ntp_sample_t *samples )
+{
+  ntp_server_t *server;
+  struct NtpPacket packet;
+  struct sockaddr_t addr;
+  socklen_t addrLen;
+  struct timeval_t t;
+  fd_set readfds;
+  char ipstr[16];
+  uint64_t now, deadline;
+  int i, len, num = 0, pending = 0;
+
+  for( i = 0; i < NTP_SERVER_NUM; i++ ){
+    server = &_ntp_servers[i];
+    server->waiting = false;
+    if( server->ip == 0 || server->unreach >= NTP_UNREACH_RESOLVE ){
+      if( gethostbyname( server->name, (uint8_t *)ipstr, 16 ) != kNoErr ){
+        server->unreach++;
+        continue;
+      }
+      server->ip = inet_addr( ipstr );
+      server->unreach = 0;
+      ntp_log("NTP server %s address: %s", server->name, ipstr);
+    }
+
+    memset( &packet, 0x0, sizeof(packet) );
+    packet.flags = NTP_Flags;
+    packet.stratum = NTP_Stratum;
+    packet.poll = NTP_Poll;
+    packet.precision = NTP_Precision;
+    packet.root_delay = NTP_Root_Delay;
+    packet.root_dispersion = NTP_Root_Dispersion;
+    /* Random transmit timestamp, answers must echo it */
+    MicoRandomNumberRead( &server->xmt_frac, sizeof(server->xmt_frac) );
+    server->sent = _ntp_now( );
+    server->xmt_sec = (uint32_t)( server->sent / 1000 ) ^ server->xmt_frac;
+    packet.trans_ts_sec = htonl( server->xmt_sec );
+    packet.trans_ts_frac = htonl( server->xmt_frac );
+
+    addr.s_ip = server->ip;
+    addr.s_port = NTP_Port;
+    if( sendto( fd, &packet, sizeof(packet), 0, &addr, sizeof(addr) ) != sizeof(packet) ){
+      server->unreach++;
+      continue;
+    }
+    server->waiting = true;
+    pending++;
+  }
+
+  deadline = _ntp_now( ) + NTP_QUERY_TIMEOUT;
+  while( pending > 0 ){
+    now = _ntp_now( );
+    if( now >= deadline )
+      break;
+    t.tv_sec = ( deadline - now ) / 1000;
+    t.tv_usec = ( ( deadline - now ) % 1000 ) * 1000;
+    FD_ZERO( &readfds );
+    FD_SET( fd, &readfds );
+    if( select( fd + 1, &readfds, NULL, NULL, &t ) <= 0 || !FD_ISSET( fd, &readfds ) )
+      continue;
+
+    addrLen = sizeof(addr);
+    len = recvfrom( fd, &packet, sizeof(packet), 0, &addr, &addrLen );
+    now = _ntp_now( );
+    if( len <= 0 )
+      continue;
+    for( i = 0; i < NTP_SERVER_NUM; i++ ){
+      server = &_ntp_servers[i];
+      if( server->waiting == false || server->ip != addr.s_ip )
+        continue;
+      if( _ntp_sample( server, &packet, len, now, &samples[num] ) ){
+        server->waiting = false;
+        server->unreach = 0;
+        pending--;
+        num++;
+      }
+      break;
+    }
+  }
+
+  for( i = 0; i < NTP_SERVER_NUM; i++ ){
+    if( _ntp_servers[i].waiting == true ){
+      _ntp_servers[i].waiting = false;
+      _ntp_servers[i].unreach++;
+    }
+  }
+  return num;
+}
+
+static int64_t _ntp_abs( int64_t value )
+{
+  return value < 0 ? -value : value;
+}
+
+/* Drop samples far from the others, combine the rest weighted by their delay.
+   Returns the number of samples used */
+static int _ntp_select( ntp_sample_t *samples, int num, int64_t *offset )
+{
+  int64_t current = 0;
+  bool valid;
+  ntp_sample_t tmp, *ref;
+  int64_t sum = 0, weight, weights = 0;
+  int i, j, used = 0;
+
+  /* Sort by offset */
+  for( i = 1; i < num; i++ ){
+    tmp = samples[i];
+    for( j = i; j > 0 && samples[j - 1].offset > tmp.offset; j-- )
+      samples[j] = samples[j - 1];
+    samples[j] = tmp;
+  }
+
+  /* The median needs three servers, otherwise keep closest to the current clock,
+     or trust the shortest round trip before the first sync */
+  ref = &samples[num / 2];
+  if( num < 3 ){
+    mico_rtos_lock_mutex( &_ntp_mutex );
+    valid = _ntp_valid;
+    if( valid )
+      current = _ntp_offset_at( _ntp_monotonic( ) );
+    mico_rtos_unlock_mutex( &_ntp_mutex );
+    for( i = 0; i < num; i++ ){
+      if( valid ? _ntp_abs( samples[i].offset - current ) < _ntp_abs( ref->offset - current )
+                : samples[i].delay < ref->delay )
+        ref = &samples[i];
+    }
+  }
+
+  for( i = 0; i < num; i++ ){
+    if( _ntp_abs( samples[i].offset - ref->offset ) > NTP_OUTLIER_THRESHOLD + samples[i].delay / 2 )
+      continue;
+    weight = 1000000 / ( samples[i].delay / 1000 + 1 );
+    sum += ( samples[i].offset - ref->offset ) * weight;
+    weights += weight;
+    used++;
+  }
+
+  *offset = ref->offset + sum / weights;
+  return used;
+}
+
+/* Returns the correction made in us */
+static int64_t _ntp_apply( int64_t offset, bool *step )
+{
+  uint64_t mono;
+  int64_t current, correction;
+
+  mico_rtos_lock_mutex( &_ntp_mutex );
+  mono = _ntp_monotonic( );
+  current = _ntp_offset_at( mono );
+  correction = offset - current;
+  *step = ( _ntp_valid == false || _ntp_abs( correction ) > NTP_STEP_THRESHOLD );
+  _slew_from = *step ? offset : current;
+  _slew_to = offset;
+  _slew_start = mono;
+  _ntp_valid = true;
+  mico_rtos_unlock_mutex( &_ntp_mutex );
+  return correction;
+}
+
+static void _ntp_set_rtc( void )
+{
+  uint64_t utc_ms;
+  time_t current;
+  struct tm *currentTime;
+  mico_rtc_time_t time;
+
+  if( MICOGetUtcTime( &utc_ms ) != kNoErr )
+    return;
+  current = (time_t)( utc_ms / 1000 + RTC_TIMEZONE_OFFSET );
+  currentTime = localtime(&current);
+  time.sec = currentTime->tm_sec;
+  time.min = currentTime->tm_min ;
+  time.hr = currentTime->tm_hour;
+
+  time.date = currentTime->tm_mday;
+  time.weekday = currentTime->tm_wday;
+  time.month = currentTime->tm_mon + 1;
+  time.year = (currentTime->tm_year + 1900)%100;
+
+  MicoRtcSetTime( &time );
+}
+
 void NTPClient_thread(void *inContext)
 {
   ntp_log_trace();
@@ -118,21 +445,21 @@ void NTPClient_thread(void *inContext)
   (void)inContext;
   
   int  Ntp_fd = -1;
-  fd_set readfds;
-  struct timeval_t t ;
   struct sockaddr_t addr;
-  socklen_t addrLen;	
-  char ipstr[16];
-  unsigned int trans_sec, current;
-  struct NtpPacket packet;
-  struct tm *currentTime;
-  mico_rtc_time_t time;
+  ntp_sample_t samples[NTP_SERVER_NUM];
+  int i, num, used;
+  int64_t offset, correction;
+  bool step;
+  uint32_t poll = NTP_POLL_MIN, retry = 0, wait;
   
   /* Regisist notifications */
   err = MICOAddNotification( mico_notify_WIFI_STATUS_CHANGED, (void *)ntpNotify_WifiStatusHandler );
   require_noerr( err, exit ); 
  
-
+  for( i = 0; i < NTP_SERVER_NUM; i++ ){
+    memset( &_ntp_servers[i], 0x0, sizeof(ntp_server_t) );
+    _ntp_servers[i].name = _ntp_server_names[i];
+  }
 
   if(_wifiConnected == false)
     mico_rtos_get_semaphore(&_wifiConnected_sem, MICO_WAIT_FOREVER);
@@ -140,66 +467,34 @@ void NTPClient_thread(void *inContext)
   Ntp_fd = socket(AF_INET, SOCK_DGRM, IPPROTO_UDP);
   require_action(IsValidSocket( Ntp_fd ), exit, err = kNoResourcesErr );
   addr.s_ip = INADDR_ANY; 
-  addr.s_port = 45000;
+  addr.s_port = NTP_Local_Port;
   err = bind(Ntp_fd, &addr, sizeof(addr));
   err = kNoErr;
   require_noerr(err, exit);
 
-   while(1) {
-     err = gethostbyname(NTP_Server, (uint8_t *)ipstr, 16);
-     require_noerr(err, ReConnWithDelay);
-     ntp_log("NTP server address: %s",ipstr);
-     break;
-
-   ReConnWithDelay:
-     mico_thread_sleep(5);
-   }
-
-  addr.s_ip = inet_addr(ipstr);
-  addr.s_port = NTP_Port;
-
-  t.tv_sec = 5;
-  t.tv_usec = 0;
-  
   while(1) {
-  	memset(&packet,0x0,sizeof(packet));
-
-    packet.flags = NTP_Flags;
-    packet.stratum = NTP_Stratum;
-    packet.poll = NTP_Poll;
-    packet.precision = NTP_Precision;
-    packet.root_delay = NTP_Root_Delay;
-    packet.root_dispersion = NTP_Root_Dispersion;
-    require_action(sendto(Ntp_fd, &packet,sizeof(packet), 0, &addr, sizeof(addr)), exit, err = kNotWritableErr);
-
-    FD_ZERO(&readfds);
-    FD_SET(Ntp_fd, &readfds);
-
-    select(1, &readfds, NULL, NULL, &t);
-    
-    if(FD_ISSET(Ntp_fd, &readfds))
-    {
-      require_action(recvfrom(Ntp_fd, &packet, sizeof(struct NtpPacket), 0, &addr, &addrLen)>=0, exit, err = kNotReadableErr);
-
-      trans_sec = packet.trans_ts_sec;
-      trans_sec = ntohl(trans_sec);
-      current = trans_sec - UNIX_OFFSET;
-      ntp_log("Time Synchronoused, %s",asctime(localtime(&current)));
-
-      currentTime = localtime(&current);
-      time.sec = currentTime->tm_sec;
-      time.min = currentTime->tm_min ;
-      time.hr = currentTime->tm_hour;
-
-      time.date = currentTime->tm_mday;
-      time.weekday = currentTime->tm_wday;
-      time.month = currentTime->tm_mon + 1;
-      time.year = (currentTime->tm_year + 1900)%100;
-
-      MicoRtcSetTime( &time );
-      goto exit;
+    num = _ntp_query_round( Ntp_fd, samples );
+    if( num > 0 && ( used = _ntp_select( samples, num, &offset ) ) > 0 ){
+      correction = _ntp_apply( offset, &step );
+      _ntp_set_rtc( );
+      /* Stable clock polls less often, a large correction starts over */
+      if( _ntp_abs( correction ) < NTP_POLL_STABLE )
+        poll = Min( poll * 2, NTP_POLL_MAX );
+      else
+        poll = NTP_POLL_MIN;
+      retry = 0;
+      wait = poll;
+      ntp_log("Time %s by %dms from %d/%d servers, next poll %ds", step ? "stepped" : "slewed",
+              (int)( correction / 1000 ), used, num, poll / 1000);
+    } else {
+      retry = retry ? Min( retry * 2, NTP_POLL_MIN ) : NTP_RETRY_MIN;
+      wait = retry;
     }
+
+    /* Reconnecting to the AP polls at once */
+    mico_rtos_get_semaphore(&_wifiConnected_sem, wait);
   }
+
 exit:
     if( err!=kNoErr )ntp_log("Exit: NTP client exit with err = %d", err);
     MICORemoveNotification( mico_notify_WIFI_STATUS_CHANGED, (void *)ntpNotify_WifiStatusHandler );
@@ -211,7 +506,14 @@ exit:
 
 OSStatus MICOStartNTPClient ( mico_Context_t * const inContext )
 {
+  OSStatus err;
+
+  if( _ntp_mutex == NULL ){
+    err = mico_rtos_init_mutex( &_ntp_mutex );
+    require_noerr( err, exit );
+  }
   mico_rtos_init_semaphore(&_wifiConnected_sem, 1);
-  return mico_rtos_create_thread(NULL, MICO_APPLICATION_PRIORITY, "NTP Client", NTPClient_thread, 0x600, (void*)inContext );
+  err = mico_rtos_create_thread(NULL, MICO_APPLICATION_PRIORITY, "NTP Client", NTPClient_thread, 0x800, (void*)inContext );
+exit:
+  return err;
 }
-
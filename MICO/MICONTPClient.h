@@ -0,0 +1,45 @@
+/**
+******************************************************************************
+* @file    MICONTPClient.h 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   SNTP client, keeps UTC as the monotonic system time plus an offset
+*          measured from several NTP servers.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#ifndef __MICONTPCLIENT_H__
+#define __MICONTPCLIENT_H__
+
+#include "Common.h"
+
+/* UTC in milliseconds since 1970, the monotonic system time plus an offset.
+   Corrections up to 1s are slewed at 500ppm so the time never goes back, larger
+   ones are stepped. Returns kNotInitializedErr until the first sync */
+OSStatus MICOGetUtcTime( uint64_t *utc_ms );
+
+/* True once at least one sync succeeded */
+bool MICONTPTimeIsValid( void );
+
+#endif
@@ -34,16 +34,87 @@
 #include "MICONotificationCenter.h"
 #include "Common.h"
 #include "Mico.h"
+#include "MICOCli.h"
+
+/* Notifications are copied into a bounded queue and fanned out by a dispatcher
+ * thread, so a slow subscriber no longer blocks the wlan driver context that
+ * raised the event. Before the dispatcher runs, and for events the caller must
+ * see handled before it goes on (power off, fatal errors), subscribers are
+ * still called synchronously. Once the dispatcher runs, an event that finds the
+ * queue full or cannot copy its payload is dropped and counted, delivering it
+ * on the caller thread would overtake the queued ones.
+ *
+ * Subscriber lists are changed and walked under notify_mutex, which is not held
+ * while a subscriber runs. A node removed while it is being called is only
+ * marked, the last caller to leave it unlinks and frees it. */
+#ifndef MICO_NOTIFY_DISPATCH_THREAD
+#define MICO_NOTIFY_DISPATCH_THREAD     1
+#endif
+
+#ifndef MICO_NOTIFY_QUEUE_LEN
+#define MICO_NOTIFY_QUEUE_LEN           16
+#endif
+
+#ifndef MICO_NOTIFY_STACK_SIZE
+#define MICO_NOTIFY_STACK_SIZE          0x1000
+#endif
+
+#define MICO_NOTIFY_TYPE_MAX            20
+
+typedef struct {
+  uint32_t calls;
+  uint32_t total_time;          /* ms spent in the subscriber */
+  uint32_t max_time;
+  uint32_t max_delay;           /* ms from post to call */
+} _Notify_stats_t;
 
 typedef struct _Notify_list{
   void  *function;
   struct _Notify_list *next;
   void  *contex;
+  uint8_t priority;
+  uint8_t users;                /* dispatchers inside the subscriber */
+  bool removed;
+  _Notify_stats_t stats;
 } _Notify_list_t;
 
+typedef struct {
+  mico_notify_types_t type;
+  uint32_t post_time;
+  void *copy;                   /* payload owned by the event in async mode */
+  union {
+    WiFiEvent status;
+    OSStatus err;
+    int fd;
+    ScanResult *scan;
+    ScanResult_adv *scan_adv;
+    struct { apinfo_adv_t *ap_info; char *key; int key_len; } para;
+    IPStatusTypedef *net;
+    network_InitTypeDef_st *nwkpara;
+    struct { int datalen; char *data; } extra;
+    struct { uint8_t *hostname; uint32_t ip; } dns;
+    char *taskname;
+  } arg;
+} _Notify_event_t;
+
+typedef struct {
+  uint32_t posted;
+  uint32_t coalesced;
+  uint32_t overflow;            /* queue full or out of memory, dropped */
+  uint32_t max_depth;
+  uint32_t max_post_time;       /* ms the notifier spent in post */
+} _Notify_queue_stats_t;
+
 static void * _Context;
 
-_Notify_list_t* Notify_list[20] = {NULL};
+_Notify_list_t* Notify_list[MICO_NOTIFY_TYPE_MAX] = {NULL};
+
+static _Notify_event_t notify_queue[MICO_NOTIFY_QUEUE_LEN];
+static uint32_t notify_head = 0, notify_count = 0;
+static _Notify_queue_stats_t notify_stats;
+static mico_mutex_t notify_mutex = NULL;
+static mico_semaphore_t notify_sem = NULL;
+static bool notify_dispatcher_running = false;
 
 /* MICO system defined notifications */
 typedef void (*mico_notify_WIFI_SCAN_COMPLETE_function)           ( ScanResult *pApList, void * inContext );
@@ -61,175 +132,384 @@ typedef void (*mico_notify_WIFI_CONNECT_FAILED_function)          ( OSStatus err
 typedef void (*mico_notify_WIFI_FATAL_ERROR_function)             ( void * inContext );
 typedef void (*mico_notify_STACK_OVERFLOW_ERROR_function)         ( char *taskname, void * const inContext );
 
-/* User defined notifications */
+static void _notify_call(_Notify_list_t *temp, _Notify_event_t *event)
+{
+  switch(event->type){
+    case mico_notify_WIFI_SCAN_COMPLETED:
+      ((mico_notify_WIFI_SCAN_COMPLETE_function)(temp->function))(event->arg.scan, _Context);
+      break;
+    case mico_notify_WIFI_SCAN_ADV_COMPLETED:
+      ((mico_notify_WIFI_SCAN_ADV_COMPLETE_function)(temp->function))(event->arg.scan_adv, _Context);
+      break;
+    case mico_notify_WIFI_STATUS_CHANGED:
+      ((mico_notify_WIFI_STATUS_CHANGED_function)(temp->function))(event->arg.status, _Context);
+      break;
+    case mico_notify_WiFI_PARA_CHANGED:
+      ((mico_notify_WiFI_PARA_CHANGED_function)(temp->function))(event->arg.para.ap_info, event->arg.para.key, event->arg.para.key_len, _Context);
+      break;
+    case mico_notify_DHCP_COMPLETED:
+      ((mico_notify_DHCP_COMPLETE_function)(temp->function))(event->arg.net, _Context);
+      break;
+    case mico_notify_EASYLINK_WPS_COMPLETED:
+      ((mico_notify_EASYLINK_COMPLETE_function)(temp->function))(event->arg.nwkpara, _Context);
+      break;
+    case mico_notify_EASYLINK_GET_EXTRA_DATA:
+      ((mico_notify_EASYLINK_GET_EXTRA_DATA_function)(temp->function))(event->arg.extra.datalen, event->arg.extra.data, _Context);
+      break;
+    case mico_notify_TCP_CLIENT_CONNECTED:
+      ((mico_notify_TCP_CLIENT_CONNECTED_function)(temp->function))(event->arg.fd, _Context);
+      break;
+    case mico_notify_DNS_RESOLVE_COMPLETED:
+      ((mico_notify_DNS_RESOLVE_COMPLETED_function)(temp->function))(event->arg.dns.hostname, event->arg.dns.ip, _Context);
+      break;
+    case mico_notify_SYS_WILL_POWER_OFF:
+      ((mico_notify_SYS_WILL_POWER_OFF_function)(temp->function))(_Context);
+      break;
+    case mico_notify_WIFI_CONNECT_FAILED:
+      ((mico_notify_WIFI_CONNECT_FAILED_function)(temp->function))(event->arg.err, _Context);
+      break;
+    case mico_notify_WIFI_Fatal_ERROR:
+      ((mico_notify_WIFI_FATAL_ERROR_function)(temp->function))(_Context);
+      break;
+    case mico_notify_Stack_Overflow_ERROR:
+      ((mico_notify_STACK_OVERFLOW_ERROR_function)(temp->function))(event->arg.taskname, _Context);
+      break;
+    default:
+      break;
+  }
+}
 
-void ApListCallback(ScanResult *pApList)
+/* The list lock only exists once the notification center is initialised,
+ * before that everything runs on the startup thread */
+static void _notify_lock(void)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_WIFI_SCAN_COMPLETED];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_WIFI_SCAN_COMPLETE_function)(temp->function))(pApList, _Context);
+  if(notify_mutex != NULL)
+    mico_rtos_lock_mutex(&notify_mutex);
+}
+
+static void _notify_unlock(void)
+{
+  if(notify_mutex != NULL)
+    mico_rtos_unlock_mutex(&notify_mutex);
+}
+
+/* Unlink and free a subscriber. Called with notify_mutex locked. */
+static void _notify_unlink(mico_notify_types_t type, _Notify_list_t *notify)
+{
+  _Notify_list_t **link = &Notify_list[type];
+
+  while(*link != NULL && *link != notify)
+    link = &(*link)->next;
+  if(*link != NULL)
+    *link = notify->next;
+  free(notify);
+}
+
+/* Call every subscriber of the event, highest priority first */
+static void _notify_dispatch(_Notify_event_t *event)
+{
+  _Notify_list_t *temp, *next;
+  uint32_t start, elapsed;
+
+  _notify_lock();
+  temp = Notify_list[event->type];
+  while(temp != NULL){
+    if(temp->removed == true){
       temp = temp->next;
-    }while(temp!=NULL);
+      continue;
+    }
+    temp->users++;
+    _notify_unlock();
+
+    start = mico_get_time();
+    _notify_call(temp, event);
+    elapsed = mico_get_time() - start;
+
+    _notify_lock();
+    if(start - event->post_time > temp->stats.max_delay)
+      temp->stats.max_delay = start - event->post_time;
+    temp->stats.calls++;
+    temp->stats.total_time += elapsed;
+    if(elapsed > temp->stats.max_time)
+      temp->stats.max_time = elapsed;
+    next = temp->next;
+    temp->users--;
+    if(temp->removed == true && temp->users == 0)
+      _notify_unlink(event->type, temp);
+    temp = next;
   }
+  _notify_unlock();
 }
 
-void ApListAdvCallback(ScanResult_adv *pApAdvList)
+/* Copy the payload the caller owns, it is gone once the notifier returns */
+static OSStatus _notify_copy_payload(_Notify_event_t *event)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_WIFI_SCAN_ADV_COMPLETED];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_WIFI_SCAN_ADV_COMPLETE_function)(temp->function))(pApAdvList, _Context);
-      temp = temp->next;
-    }while(temp!=NULL);
+  OSStatus err = kNoErr;
+  uint32_t size;
+
+  switch(event->type){
+    case mico_notify_WIFI_SCAN_COMPLETED:
+      size = event->arg.scan->ApNum * sizeof(*event->arg.scan->ApList);
+      event->copy = malloc(sizeof(ScanResult) + size);
+      require_action(event->copy, exit, err = kNoMemoryErr);
+      memcpy(event->copy, event->arg.scan, sizeof(ScanResult));
+      event->arg.scan = (ScanResult *)event->copy;
+      memcpy(event->arg.scan + 1, event->arg.scan->ApList, size);
+      event->arg.scan->ApList = (void *)(event->arg.scan + 1);
+      break;
+    case mico_notify_WIFI_SCAN_ADV_COMPLETED:
+      size = event->arg.scan_adv->ApNum * sizeof(*event->arg.scan_adv->ApList);
+      event->copy = malloc(sizeof(ScanResult_adv) + size);
+      require_action(event->copy, exit, err = kNoMemoryErr);
+      memcpy(event->copy, event->arg.scan_adv, sizeof(ScanResult_adv));
+      event->arg.scan_adv = (ScanResult_adv *)event->copy;
+      memcpy(event->arg.scan_adv + 1, event->arg.scan_adv->ApList, size);
+      event->arg.scan_adv->ApList = (void *)(event->arg.scan_adv + 1);
+      break;
+    case mico_notify_WiFI_PARA_CHANGED:
+      event->copy = malloc(sizeof(apinfo_adv_t) + event->arg.para.key_len + 1);
+      require_action(event->copy, exit, err = kNoMemoryErr);
+      memcpy(event->copy, event->arg.para.ap_info, sizeof(apinfo_adv_t));
+      event->arg.para.ap_info = (apinfo_adv_t *)event->copy;
+      memcpy(event->arg.para.ap_info + 1, event->arg.para.key, event->arg.para.key_len);
+      event->arg.para.key = (char *)(event->arg.para.ap_info + 1);
+      event->arg.para.key[event->arg.para.key_len] = 0x0;
+      break;
+    case mico_notify_DHCP_COMPLETED:
+      event->copy = malloc(sizeof(IPStatusTypedef));
+      require_action(event->copy, exit, err = kNoMemoryErr);
+      memcpy(event->copy, event->arg.net, sizeof(IPStatusTypedef));
+      event->arg.net = (IPStatusTypedef *)event->copy;
+      break;
+    case mico_notify_EASYLINK_WPS_COMPLETED:
+      if(event->arg.nwkpara == NULL)
+        break;
+      event->copy = malloc(sizeof(network_InitTypeDef_st));
+      require_action(event->copy, exit, err = kNoMemoryErr);
+      memcpy(event->copy, event->arg.nwkpara, sizeof(network_InitTypeDef_st));
+      event->arg.nwkpara = (network_InitTypeDef_st *)event->copy;
+      break;
+    case mico_notify_EASYLINK_GET_EXTRA_DATA:
+      event->copy = malloc(event->arg.extra.datalen + 1);
+      require_action(event->copy, exit, err = kNoMemoryErr);
+      memcpy(event->copy, event->arg.extra.data, event->arg.extra.datalen);
+      event->arg.extra.data = (char *)event->copy;
+      event->arg.extra.data[event->arg.extra.datalen] = 0x0;
+      break;
+    case mico_notify_DNS_RESOLVE_COMPLETED:
+      size = strlen((char *)event->arg.dns.hostname) + 1;
+      event->copy = malloc(size);
+      require_action(event->copy, exit, err = kNoMemoryErr);
+      memcpy(event->copy, event->arg.dns.hostname, size);
+      event->arg.dns.hostname = (uint8_t *)event->copy;
+      break;
+    default:
+      break;
   }
+exit:
+  return err;
 }
 
-void WifiStatusHandler(WiFiEvent status)
+/* A newer status replaces an undelivered one of the same kind. Returns true if
+ * the event was merged into the queue. Called with notify_mutex locked. */
+static bool _notify_coalesce(_Notify_event_t *event)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_WIFI_STATUS_CHANGED];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_WIFI_STATUS_CHANGED_function)(temp->function))(status, _Context);
-      temp = temp->next;
-    }while(temp!=NULL);
+  _Notify_event_t *queued;
+  uint32_t i;
+
+  for(i = notify_count; i > 0; i--){
+    queued = &notify_queue[(notify_head + i - 1) % MICO_NOTIFY_QUEUE_LEN];
+    if(queued->type != event->type)
+      continue;
+    switch(event->type){
+      case mico_notify_WIFI_STATUS_CHANGED:
+        return (queued->arg.status == event->arg.status);
+      case mico_notify_WIFI_CONNECT_FAILED:
+        return (queued->arg.err == event->arg.err);
+      case mico_notify_DHCP_COMPLETED:
+        memcpy(queued->arg.net, event->arg.net, sizeof(IPStatusTypedef));
+        return true;
+      default:
+        return false;
+    }
   }
+  return false;
 }
 
-void connected_ap_info(apinfo_adv_t *ap_info, char *key, int key_len)
+static void _notify_post(_Notify_event_t *event)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_WiFI_PARA_CHANGED];
-  if(temp == NULL)
+  uint32_t elapsed;
+
+  if(Notify_list[event->type] == NULL)
+    return;
+
+  event->post_time = mico_get_time();
+  event->copy = NULL;
+
+  if(notify_dispatcher_running == false){
+    _notify_dispatch(event);
+    return;
+  }
+
+  mico_rtos_lock_mutex(&notify_mutex);
+  notify_stats.posted++;
+  if(_notify_coalesce(event) == true){
+    notify_stats.coalesced++;
+    mico_rtos_unlock_mutex(&notify_mutex);
+    return;
+  }
+  if(notify_count == MICO_NOTIFY_QUEUE_LEN || _notify_copy_payload(event) != kNoErr){
+    notify_stats.overflow++;
+    mico_rtos_unlock_mutex(&notify_mutex);
+    free(event->copy);
     return;
-  else{
-    do{
-      ((mico_notify_WiFI_PARA_CHANGED_function)(temp->function))(ap_info, key, key_len, _Context);
-      temp = temp->next;
-    }while(temp!=NULL);
   }
+  memcpy(&notify_queue[(notify_head + notify_count) % MICO_NOTIFY_QUEUE_LEN], event, sizeof(_Notify_event_t));
+  notify_count++;
+  if(notify_count > notify_stats.max_depth)
+    notify_stats.max_depth = notify_count;
+  elapsed = mico_get_time() - event->post_time;
+  if(elapsed > notify_stats.max_post_time)
+    notify_stats.max_post_time = elapsed;
+  mico_rtos_unlock_mutex(&notify_mutex);
+
+  mico_rtos_set_semaphore(&notify_sem);
 }
 
-void NetCallback(IPStatusTypedef *pnet)
+static void _notify_dispatch_thread(void *arg)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_DHCP_COMPLETED];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_DHCP_COMPLETE_function)(temp->function))(pnet, _Context);
-      temp = temp->next;
-    }while(temp!=NULL);
+  _Notify_event_t event;
+  UNUSED_PARAMETER(arg);
+
+  while(1){
+    mico_rtos_get_semaphore(&notify_sem, MICO_WAIT_FOREVER);
+    mico_rtos_lock_mutex(&notify_mutex);
+    if(notify_count == 0){
+      mico_rtos_unlock_mutex(&notify_mutex);
+      continue;
+    }
+    memcpy(&event, &notify_queue[notify_head], sizeof(_Notify_event_t));
+    notify_head = (notify_head + 1) % MICO_NOTIFY_QUEUE_LEN;
+    notify_count--;
+    mico_rtos_unlock_mutex(&notify_mutex);
+
+    _notify_dispatch(&event);
+    if(event.copy)
+      free(event.copy);
   }
 }
+
+/* User defined notifications */
+
+void ApListCallback(ScanResult *pApList)
+{
+  _Notify_event_t event;
+  event.type = mico_notify_WIFI_SCAN_COMPLETED;
+  event.arg.scan = pApList;
+  _notify_post(&event);
+}
+
+void ApListAdvCallback(ScanResult_adv *pApAdvList)
+{
+  _Notify_event_t event;
+  event.type = mico_notify_WIFI_SCAN_ADV_COMPLETED;
+  event.arg.scan_adv = pApAdvList;
+  _notify_post(&event);
+}
+
+void WifiStatusHandler(WiFiEvent status)
+{
+  _Notify_event_t event;
+  event.type = mico_notify_WIFI_STATUS_CHANGED;
+  event.arg.status = status;
+  _notify_post(&event);
+}
+
+void connected_ap_info(apinfo_adv_t *ap_info, char *key, int key_len)
+{
+  _Notify_event_t event;
+  event.type = mico_notify_WiFI_PARA_CHANGED;
+  event.arg.para.ap_info = ap_info;
+  event.arg.para.key = key;
+  event.arg.para.key_len = key_len;
+  _notify_post(&event);
+}
+
+void NetCallback(IPStatusTypedef *pnet)
+{
+  _Notify_event_t event;
+  event.type = mico_notify_DHCP_COMPLETED;
+  event.arg.net = pnet;
+  _notify_post(&event);
+}
 #if 0
 void RptConfigmodeRslt(network_InitTypeDef_st *nwkpara)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_EASYLINK_WPS_COMPLETED];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_EASYLINK_COMPLETE_function)(temp->function))(nwkpara, _Context);
-      temp = temp->next;
-    }while(temp!=NULL);
-  }
+  _Notify_event_t event;
+  event.type = mico_notify_EASYLINK_WPS_COMPLETED;
+  event.arg.nwkpara = nwkpara;
+  _notify_post(&event);
 }
 #endif
 void easylink_user_data_result(int datalen, char*data)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_EASYLINK_GET_EXTRA_DATA];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_EASYLINK_GET_EXTRA_DATA_function)(temp->function))(datalen, data, _Context);
-      temp = temp->next;
-    }while(temp!=NULL);
-  }  
+  _Notify_event_t event;
+  event.type = mico_notify_EASYLINK_GET_EXTRA_DATA;
+  event.arg.extra.datalen = datalen;
+  event.arg.extra.data = data;
+  _notify_post(&event);
 }
 #if 0
 void socket_connected(int fd)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_TCP_CLIENT_CONNECTED];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_TCP_CLIENT_CONNECTED_function)(temp->function))(fd, _Context);
-      temp = temp->next;
-    }while(temp!=NULL);
-  }    
+  _Notify_event_t event;
+  event.type = mico_notify_TCP_CLIENT_CONNECTED;
+  event.arg.fd = fd;
+  _notify_post(&event);
 }
 
 void dns_ip_set(uint8_t *hostname, uint32_t ip)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_DNS_RESOLVE_COMPLETED];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_DNS_RESOLVE_COMPLETED_function)(temp->function))(hostname, ip, _Context);
-      temp = temp->next;
-    }while(temp!=NULL);
-  }    
+  _Notify_event_t event;
+  event.type = mico_notify_DNS_RESOLVE_COMPLETED;
+  event.arg.dns.hostname = hostname;
+  event.arg.dns.ip = ip;
+  _notify_post(&event);
 }
 #endif
+/* The events below are always delivered on the caller thread: the system is
+   about to power off or is already broken, nothing may be deferred */
 void sendNotifySYSWillPowerOff(void)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_SYS_WILL_POWER_OFF];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_SYS_WILL_POWER_OFF_function)(temp->function))(_Context);
-      temp = temp->next;
-    }while(temp!=NULL);
-  }    
+  _Notify_event_t event;
+  event.type = mico_notify_SYS_WILL_POWER_OFF;
+  event.post_time = mico_get_time();
+  _notify_dispatch(&event);
 }
 
 void join_fail(OSStatus err)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_WIFI_CONNECT_FAILED];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_WIFI_CONNECT_FAILED_function)(temp->function))(err, _Context);
-      temp = temp->next;
-    }while(temp!=NULL);
-  }    
+  _Notify_event_t event;
+  event.type = mico_notify_WIFI_CONNECT_FAILED;
+  event.arg.err = err;
+  _notify_post(&event);
 }
 
 void wifi_reboot_event(void)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_WIFI_Fatal_ERROR];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_WIFI_FATAL_ERROR_function)(temp->function))(_Context);
-      temp = temp->next;
-    }while(temp!=NULL);
-  }    
+  _Notify_event_t event;
+  event.type = mico_notify_WIFI_Fatal_ERROR;
+  event.post_time = mico_get_time();
+  _notify_dispatch(&event);
 }
 
 void mico_rtos_stack_overflow(char *taskname)
 {
-  _Notify_list_t *temp =  Notify_list[mico_notify_Stack_Overflow_ERROR];
-  if(temp == NULL)
-    return;
-  else{
-    do{
-      ((mico_notify_STACK_OVERFLOW_ERROR_function)(temp->function))(taskname, _Context);
-      temp = temp->next;
-    }while(temp!=NULL);
-  }    
+  _Notify_event_t event;
+  event.type = mico_notify_Stack_Overflow_ERROR;
+  event.arg.taskname = taskname;
+  event.post_time = mico_get_time();
+  _notify_dispatch(&event);
 }
 
 
@@ -238,74 +518,129 @@ OSStatus MICOInitNotificationCenter  ( void * const inContext )
   OSStatus err = kNoErr;
   require_action(inContext, exit, err = kParamErr);
   _Context = inContext;
+
+  if(notify_mutex == NULL){
+    err = mico_rtos_init_mutex(&notify_mutex);
+    require_noerr(err, exit);
+  }
+
+#if MICO_NOTIFY_DISPATCH_THREAD
+  if(notify_dispatcher_running == true)
+    goto exit;
+  err = mico_rtos_init_semaphore(&notify_sem, MICO_NOTIFY_QUEUE_LEN);
+  require_noerr(err, exit);
+  err = mico_rtos_create_thread(NULL, MICO_APPLICATION_PRIORITY, "Notify", _notify_dispatch_thread, MICO_NOTIFY_STACK_SIZE, NULL);
+  require_noerr(err, exit);
+  notify_dispatcher_running = true;
+#endif
 exit:
   return err;
 }
 
 OSStatus MICOAddNotification( mico_notify_types_t notify_type, void *functionAddress )
+{
+  return MICOAddNotificationWithPriority( notify_type, functionAddress, MICO_NOTIFY_PRIORITY_DEFAULT );
+}
+
+OSStatus MICOAddNotificationWithPriority( mico_notify_types_t notify_type, void *functionAddress, uint8_t priority )
 {
   OSStatus err = kNoErr;
-  _Notify_list_t *temp =  Notify_list[notify_type];
-  _Notify_list_t *notify = (_Notify_list_t *)malloc(sizeof(_Notify_list_t));
-  require_action(notify, exit, err = kNoMemoryErr);
-  notify->function = functionAddress;
-  notify->next = NULL;
-  if(Notify_list[notify_type] == NULL){
-    Notify_list[notify_type] = notify;
-    notify->next = NULL;
-  }else{
-    if(temp->function == functionAddress)
-        return kNoErr;   //Nodify already exist
-    while(temp->next!=NULL){
-      temp = temp->next;
-      if(temp->function == functionAddress)
-        return kNoErr;   //Nodify already exist
+  _Notify_list_t *temp;
+  _Notify_list_t **insert = &Notify_list[notify_type];
+  _Notify_list_t *notify;
+
+  _notify_lock();
+  for(temp = Notify_list[notify_type]; temp != NULL; temp = temp->next){
+    if(temp->function == functionAddress){
+      temp->removed = false;   //Nodify already exist
+      goto exit;
     }
-    temp->next = notify;
   }
+
+  notify = (_Notify_list_t *)malloc(sizeof(_Notify_list_t));
+  require_action(notify, exit, err = kNoMemoryErr);
+  memset(notify, 0x0, sizeof(_Notify_list_t));
+  notify->function = functionAddress;
+  notify->priority = priority;
+
+  /* Higher priority first, same priority in the order of registration */
+  while(*insert != NULL && (*insert)->priority >= priority)
+    insert = &(*insert)->next;
+  notify->next = *insert;
+  *insert = notify;
 exit:
+  _notify_unlock();
   return err;
 }
 
 OSStatus MICORemoveNotification( mico_notify_types_t notify_type, void *functionAddress )
 {
   OSStatus err = kNoErr;
-  _Notify_list_t *temp2;
-  _Notify_list_t *temp = Notify_list[notify_type];
+  _Notify_list_t *temp;
+
+  _notify_lock();
   require_action(Notify_list[notify_type], exit, err = kDeletedErr);
-  do{
-    if(temp->function == functionAddress){
-      if(temp == Notify_list[notify_type]){  //first element
-        Notify_list[notify_type] = Notify_list[notify_type]->next;
-        free(temp);
-      }else{
-        temp2->next = temp->next;
-        free(temp);
-      }
-       break;
-    }
-    require_action(temp->next!=NULL, exit, err = kNotFoundErr);
-    temp2 = temp;
-    temp = temp->next;
-  }while(temp != NULL);
+  for(temp = Notify_list[notify_type]; temp != NULL; temp = temp->next){
+    if(temp->function == functionAddress && temp->removed == false)
+      break;
+  }
+  require_action(temp != NULL, exit, err = kNotFoundErr);
+
+  /* A dispatcher inside the subscriber frees it when it returns */
+  if(temp->users)
+    temp->removed = true;
+  else
+    _notify_unlink(notify_type, temp);
 
 exit:
+  _notify_unlock();
   return err;
 }
 
 OSStatus MICORemoveAllNotification( mico_notify_types_t notify_type)
 {
-    _Notify_list_t *temp = Notify_list[notify_type];;
-
-    while(temp) {
-        Notify_list[notify_type] = Notify_list[notify_type]->next;
-        free(temp);
-        temp = Notify_list[notify_type];
+    _Notify_list_t *temp, *next;
+
+    _notify_lock();
+    for(temp = Notify_list[notify_type]; temp != NULL; temp = next) {
+        next = temp->next;
+        if(temp->users)
+            temp->removed = true;
+        else
+            _notify_unlink(notify_type, temp);
     }
+    _notify_unlock();
 
     return kNoErr;
 }
 
+void MICONotificationShowStats( char *pcWriteBuffer, int xWriteBufferLen, bool reset )
+{
+  _Notify_list_t *temp;
+  int type;
+
+  cmd_printf("Notify queue: %s, posted %d, coalesced %d, overflow %d, max depth %d/%d, max post %dms\r\n",
+             notify_dispatcher_running ? "async" : "sync",
+             notify_stats.posted, notify_stats.coalesced, notify_stats.overflow,
+             notify_stats.max_depth, MICO_NOTIFY_QUEUE_LEN, notify_stats.max_post_time);
+  cmd_printf("type | pri | handler    |  calls | avg ms | max ms | max delay\r\n");
+  _notify_lock();
+  for(type = 0; type < MICO_NOTIFY_TYPE_MAX; type++){
+    for(temp = Notify_list[type]; temp != NULL; temp = temp->next){
+      if(temp->removed == true)
+        continue;
+      cmd_printf("%4d | %3d | 0x%08x | %6d | %6d | %6d | %6d\r\n", type, temp->priority, (uint32_t)temp->function,
+                 temp->stats.calls, temp->stats.calls ? temp->stats.total_time / temp->stats.calls : 0,
+                 temp->stats.max_time, temp->stats.max_delay);
+      if(reset == true)
+        memset(&temp->stats, 0x0, sizeof(_Notify_stats_t));
+    }
+  }
+  _notify_unlock();
+  if(reset == true)
+    memset(&notify_stats, 0x0, sizeof(_Notify_queue_stats_t));
+}
+
 
 // void WatchDog(void)
 // {
@@ -65,14 +65,22 @@ typedef enum{
 
 } mico_notify_types_t;
 
+#define MICO_NOTIFY_PRIORITY_DEFAULT  (0)
+
 OSStatus MICOInitNotificationCenter   ( void * const inContext );
 
 OSStatus MICOAddNotification          ( mico_notify_types_t notify_type, void *functionAddress );
 
+/* Subscribers with higher priority are called first, MICOAddNotification uses MICO_NOTIFY_PRIORITY_DEFAULT */
+OSStatus MICOAddNotificationWithPriority ( mico_notify_types_t notify_type, void *functionAddress, uint8_t priority );
+
 OSStatus MICORemoveNotification       ( mico_notify_types_t notify_type, void *functionAddress );
 
 OSStatus MICORemoveAllNotification    ( mico_notify_types_t notify_type);
 
+/* Print dispatch queue and per-subscriber latency statistics into a CLI buffer */
+void MICONotificationShowStats        ( char *pcWriteBuffer, int xWriteBufferLen, bool reset );
+
 
 void sendNotifySYSWillPowerOff(void);
 void system_version(char *str, int len);
@@ -33,24 +33,207 @@
 #include "MICO.h"
 #include "MicoSystemMonitor.h"
 #include "MicoPlatform.h"
+#include "MICOCli.h"
+#include "CheckSumUtils.h"
 
+#if MICO_SYSTEM_MONITOR_THREAD_DUMP
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
 
+#define monitor_log(M, ...) custom_log("SYS MONITOR", M, ##__VA_ARGS__)
 
 #define DEFAULT_SYSTEM_MONITOR_PERIOD   (2000)
 
-#ifndef MAXIMUM_NUMBER_OF_SYSTEM_MONITORS
-#define MAXIMUM_NUMBER_OF_SYSTEM_MONITORS    (5)
+/* Snapshot kept in MICO_SYSTEM_MONITOR_SNAPSHOT_PARTITION when a monitor expires,
+   the board defines it to persist the snapshot across the watchdog reset */
+#define SYSTEM_MONITOR_SNAPSHOT_MAGIC     (0x474E4148)  /* "HANG" */
+#define SYSTEM_MONITOR_SNAPSHOT_MONITORS  (8)
+#define SYSTEM_MONITOR_SNAPSHOT_THREADS   (512)
+
+#ifndef MICO_SYSTEM_MONITOR_THREAD_DUMP
+#define MICO_SYSTEM_MONITOR_THREAD_DUMP   (0)
 #endif
 
-static mico_system_monitor_t* system_monitors[MAXIMUM_NUMBER_OF_SYSTEM_MONITORS];
+#define MICO_SYSTEM_MONITOR_DUMP_THREADS  (24)
+
+typedef struct
+{
+  char     name[MICO_SYSTEM_MONITOR_NAME_LEN];
+  uint32_t since_update;
+  uint32_t permitted;
+  uint32_t max_latency;
+} system_monitor_record_t;
+
+typedef struct
+{
+  uint32_t magic;
+  uint16_t length;                      /* Bytes after this header */
+  uint16_t crc;                         /* CRC16 of the bytes after this header */
+  uint32_t uptime;
+  uint32_t monitor_num;                 /* Registered, records[0] is the expired one */
+  system_monitor_record_t records[SYSTEM_MONITOR_SNAPSHOT_MONITORS];
+  char     threads[SYSTEM_MONITOR_SNAPSHOT_THREADS];
+} system_monitor_snapshot_t;
+
+#define SNAPSHOT_HEADER_SIZE    (8)
+
+static mico_system_monitor_t* system_monitors = NULL;
+static mico_mutex_t system_monitor_mutex = NULL;
+static system_monitor_snapshot_t system_monitor_snapshot;
+static system_monitor_record_t last_hang;
+static uint32_t last_hang_uptime = 0;
+
 void mico_system_monitor_thread_main( void* arg );
 
+static uint16_t system_monitor_snapshot_crc( system_monitor_snapshot_t *snapshot )
+{
+  CRC16_Context crc_context;
+  uint16_t crc_result;
+
+  CRC16_Init( &crc_context );
+  CRC16_Update( &crc_context, (uint8_t *)snapshot + SNAPSHOT_HEADER_SIZE, snapshot->length );
+  CRC16_Final( &crc_context, &crc_result );
+  return crc_result;
+}
+
+static bool system_monitor_snapshot_blank( system_monitor_snapshot_t *snapshot )
+{
+  uint8_t *p = (uint8_t *)snapshot;
+  uint32_t i;
+
+  for( i = 0; i < sizeof(system_monitor_snapshot_t); i++ )
+    if( p[i] != 0xFF )
+      return false;
+  return true;
+}
+
+/* Report the snapshot left by a hang before the last reset and leave the partition
+   erased, so that a later hang only has to program it */
+static void system_monitor_read_snapshot( void )
+{
+#ifdef MICO_SYSTEM_MONITOR_SNAPSHOT_PARTITION
+  system_monitor_snapshot_t *snapshot = &system_monitor_snapshot;
+  uint32_t offset = 0;
+  uint32_t i;
+
+  if( MicoFlashRead( MICO_SYSTEM_MONITOR_SNAPSHOT_PARTITION, &offset, (uint8_t *)snapshot, sizeof(system_monitor_snapshot_t) ) != kNoErr )
+    return;
+  if( system_monitor_snapshot_blank( snapshot ) == true )
+    return;
+  if( snapshot->magic != SYSTEM_MONITOR_SNAPSHOT_MAGIC || snapshot->length != sizeof(system_monitor_snapshot_t) - SNAPSHOT_HEADER_SIZE
+     || snapshot->crc != system_monitor_snapshot_crc( snapshot ) )
+    goto erase;
+
+  snapshot->threads[SYSTEM_MONITOR_SNAPSHOT_THREADS - 1] = 0;
+  for( i = 0; i < SYSTEM_MONITOR_SNAPSHOT_MONITORS; i++ )
+    snapshot->records[i].name[MICO_SYSTEM_MONITOR_NAME_LEN - 1] = 0;
+
+  memcpy( &last_hang, &snapshot->records[0], sizeof(system_monitor_record_t) );
+  last_hang_uptime = snapshot->uptime;
+
+  monitor_log( "Reset by monitor \"%s\" at %dms: no checkin for %dms, permitted %dms",
+               last_hang.name, snapshot->uptime, last_hang.since_update, last_hang.permitted );
+  for( i = 1; i < snapshot->monitor_num && i < SYSTEM_MONITOR_SNAPSHOT_MONITORS; i++ )
+    monitor_log( "  %s: last checkin %dms ago, permitted %dms, max %dms", snapshot->records[i].name,
+                 snapshot->records[i].since_update, snapshot->records[i].permitted, snapshot->records[i].max_latency );
+  if( snapshot->threads[0] )
+    monitor_log( "Threads:\r\n%s", snapshot->threads );
+
+erase:
+  MicoFlashErase( MICO_SYSTEM_MONITOR_SNAPSHOT_PARTITION, 0x0, sizeof(system_monitor_snapshot_t) );
+#endif
+}
+
+static void system_monitor_fill_record( system_monitor_record_t *record, mico_system_monitor_t *monitor, uint32_t current_time )
+{
+  strncpy( record->name, monitor->name ? monitor->name : "unnamed", MICO_SYSTEM_MONITOR_NAME_LEN - 1 );
+  record->name[MICO_SYSTEM_MONITOR_NAME_LEN - 1] = 0;
+  record->since_update = current_time - monitor->last_update;
+  record->permitted = monitor->longest_permitted_delay;
+  record->max_latency = monitor->max_latency;
+}
+
+/* Called with system_monitor_mutex locked, never returns: the watchdog resets the system */
+static void system_monitor_hang( mico_system_monitor_t *expired, uint32_t current_time )
+{
+  system_monitor_snapshot_t *snapshot = &system_monitor_snapshot;
+  mico_system_monitor_t *monitor;
+  uint32_t num = 1;
+#ifdef MICO_SYSTEM_MONITOR_SNAPSHOT_PARTITION
+  uint32_t offset = 0;
+#endif
+
+  /* A whole watchdog period for writing the snapshot */
+  MicoWdgReload();
+
+  memset( snapshot, 0x0, sizeof(system_monitor_snapshot_t) );
+  snapshot->magic = SYSTEM_MONITOR_SNAPSHOT_MAGIC;
+  snapshot->length = sizeof(system_monitor_snapshot_t) - SNAPSHOT_HEADER_SIZE;
+  snapshot->uptime = current_time;
+  system_monitor_fill_record( &snapshot->records[0], expired, current_time );
+  for( monitor = system_monitors; monitor != NULL; monitor = monitor->next ){
+    if( monitor == expired )
+      continue;
+    if( num < SYSTEM_MONITOR_SNAPSHOT_MONITORS )
+      system_monitor_fill_record( &snapshot->records[num], monitor, current_time );
+    num++;
+  }
+  snapshot->monitor_num = num;
+  MICOSystemMonitorThreadDump( snapshot->threads, SYSTEM_MONITOR_SNAPSHOT_THREADS - 1 );
+  snapshot->crc = system_monitor_snapshot_crc( snapshot );
+
+#ifdef MICO_SYSTEM_MONITOR_SNAPSHOT_PARTITION
+  /* Erased at start by system_monitor_read_snapshot, only program it here */
+  MicoFlashWrite( MICO_SYSTEM_MONITOR_SNAPSHOT_PARTITION, &offset, (uint8_t *)snapshot, sizeof(system_monitor_snapshot_t) );
+#endif
+
+  monitor_log( "Monitor \"%s\" missed its deadline: no checkin for %dms, permitted %dms",
+               snapshot->records[0].name, snapshot->records[0].since_update, snapshot->records[0].permitted );
+
+  while(1);
+}
+
+__weak int MICOSystemMonitorThreadDump( char *buffer, int len )
+{
+#if MICO_SYSTEM_MONITOR_THREAD_DUMP
+  static TaskStatus_t status[MICO_SYSTEM_MONITOR_DUMP_THREADS];
+  const char *state = "XRBSD";  /* Running, ready, blocked, suspended, deleted */
+  UBaseType_t i, num;
+  int n, used = 0;
+
+  num = uxTaskGetSystemState( status, MICO_SYSTEM_MONITOR_DUMP_THREADS, NULL );
+  for( i = 0; i < num; i++ ){
+    n = snprintf( buffer + used, len - used, "%-12s %c %2d %5d\r\n", status[i].pcTaskName,
+                  status[i].eCurrentState <= eDeleted ? state[status[i].eCurrentState] : '?',
+                  (int)status[i].uxCurrentPriority, (int)status[i].usStackHighWaterMark );
+    if( n < 0 || n >= len - used )
+      break;
+    used += n;
+  }
+  buffer[used] = 0;
+  return used;
+#else
+  (void)buffer;
+  (void)len;
+  return 0;
+#endif
+}
+
 OSStatus MICOStartSystemMonitor ( mico_Context_t * const inContext )
 {
   OSStatus err = kNoErr;
   require_noerr(MicoWdgInitialize( DEFAULT_SYSTEM_MONITOR_PERIOD + 1000 ), exit);
-  memset(system_monitors, 0, sizeof(system_monitors));
 
+  if( system_monitor_mutex == NULL ){
+    err = mico_rtos_init_mutex( &system_monitor_mutex );
+    require_noerr(err, exit);
+  }
+  system_monitors = NULL;
+  system_monitor_read_snapshot();
+
+  /* A thread of its own above everything it watches, a busy or stuck thread must
+     not be able to delay the check and the watchdog reload */
   err = mico_rtos_create_thread(NULL, 0, "SYS MONITOR", mico_system_monitor_thread_main, STACK_SIZE_MICO_SYSTEM_MONITOR_THREAD, (void*)inContext );
   require_noerr(err, exit);
 exit:
@@ -59,58 +242,141 @@ exit:
 
 void mico_system_monitor_thread_main( void* arg )
 {
+  mico_system_monitor_t* monitor;
+  uint32_t current_time;
   (void)arg;
   
   while (1)
   {
-    int a;
-    uint32_t current_time = mico_get_time();
+    current_time = mico_get_time();
     
-    for (a = 0; a < MAXIMUM_NUMBER_OF_SYSTEM_MONITORS; ++a)
+    mico_rtos_lock_mutex( &system_monitor_mutex );
+    for (monitor = system_monitors; monitor != NULL; monitor = monitor->next)
     {
-      if (system_monitors[a] != NULL)
+      if ((current_time - monitor->last_update) > monitor->longest_permitted_delay)
       {
-        if ((current_time - system_monitors[a]->last_update) > system_monitors[a]->longest_permitted_delay)
-        {
-          /* A system monitor update period has been missed */
-          while(1);
-        }
+        /* A system monitor update period has been missed */
+        system_monitor_hang(monitor, current_time);
       }
     }
+    mico_rtos_unlock_mutex( &system_monitor_mutex );
     
     MicoWdgReload();
     mico_thread_msleep(DEFAULT_SYSTEM_MONITOR_PERIOD);
   }
 }
 
+OSStatus MICORegisterNamedSystemMonitor(mico_system_monitor_t* system_monitor, const char* name, uint32_t initial_permitted_delay)
+{
+  mico_system_monitor_t* monitor;
+  
+  if (system_monitor_mutex == NULL)
+    return kNotInitializedErr;
+  
+  mico_rtos_lock_mutex( &system_monitor_mutex );
+  system_monitor->last_update = mico_get_time();
+  system_monitor->longest_permitted_delay = initial_permitted_delay;
+  system_monitor->name = name;
+  
+  /* Registering again only restarts the monitor */
+  for (monitor = system_monitors; monitor != NULL; monitor = monitor->next)
+  {
+    if (monitor == system_monitor)
+      break;
+  }
+  if (monitor == NULL)
+  {
+    system_monitor->max_latency = 0;
+    memset(system_monitor->histogram, 0x0, sizeof(system_monitor->histogram));
+    system_monitor->next = system_monitors;
+    system_monitors = system_monitor;
+  }
+  mico_rtos_unlock_mutex( &system_monitor_mutex );
+  
+  return kNoErr;
+}
+
 OSStatus MICORegisterSystemMonitor(mico_system_monitor_t* system_monitor, uint32_t initial_permitted_delay)
 {
-  int a;
+  return MICORegisterNamedSystemMonitor(system_monitor, NULL, initial_permitted_delay);
+}
+
+OSStatus MICOUnregisterSystemMonitor(mico_system_monitor_t* system_monitor)
+{
+  mico_system_monitor_t** pmonitor;
+  OSStatus err = kNotFoundErr;
   
-  /* Find spare entry and add the new system monitor */
-  for ( a = 0; a < MAXIMUM_NUMBER_OF_SYSTEM_MONITORS; ++a )
+  if (system_monitor_mutex == NULL)
+    return kNotInitializedErr;
+  
+  mico_rtos_lock_mutex( &system_monitor_mutex );
+  for (pmonitor = &system_monitors; *pmonitor != NULL; pmonitor = &(*pmonitor)->next)
   {
-    if (system_monitors[a] == NULL)
+    if (*pmonitor == system_monitor)
     {
-      system_monitor->last_update = mico_get_time();
-      system_monitor->longest_permitted_delay = initial_permitted_delay;
-      system_monitors[a] = system_monitor;
-      return kNoErr;
+      *pmonitor = system_monitor->next;
+      system_monitor->next = NULL;
+      err = kNoErr;
+      break;
     }
   }
+  mico_rtos_unlock_mutex( &system_monitor_mutex );
+  
+  return err;
+}
+
+static int system_monitor_histogram_bin(uint32_t latency)
+{
+  int bin = 0;
   
-  return kUnknownErr;
+  for (latency >>= 6; latency != 0 && bin < MICO_SYSTEM_MONITOR_HISTOGRAM_BINS - 1; latency >>= 1)
+    bin++;
+  return bin;
 }
 
 OSStatus MICOUpdateSystemMonitor(mico_system_monitor_t* system_monitor, uint32_t permitted_delay)
 {
   uint32_t current_time = mico_get_time();
+  uint32_t latency = current_time - system_monitor->last_update;
   /* Update the system monitor if it hasn't already passed it's permitted delay */
-  if ((current_time - system_monitor->last_update) <= system_monitor->longest_permitted_delay)
+  if (latency <= system_monitor->longest_permitted_delay)
   {
     system_monitor->last_update             = current_time;
     system_monitor->longest_permitted_delay = permitted_delay;
+    if (latency > system_monitor->max_latency)
+      system_monitor->max_latency = latency;
+    system_monitor->histogram[system_monitor_histogram_bin(latency)]++;
   }
   
   return kNoErr;
 }
+
+void MICOSystemMonitorShowStats( char *pcWriteBuffer, int xWriteBufferLen, bool reset )
+{
+  mico_system_monitor_t* monitor;
+  uint32_t current_time = mico_get_time();
+  int bin;
+  
+  if (last_hang_uptime != 0)
+    cmd_printf("Last reset by \"%s\" at %dms, no checkin for %dms, permitted %dms\r\n",
+               last_hang.name, last_hang_uptime, last_hang.since_update, last_hang.permitted);
+  if (system_monitor_mutex == NULL)
+    return;
+  
+  cmd_printf("monitor          | permitted |  since |    max | <64ms <128 <256 <512  <1s  <2s  <4s >=4s\r\n");
+  mico_rtos_lock_mutex( &system_monitor_mutex );
+  for (monitor = system_monitors; monitor != NULL; monitor = monitor->next)
+  {
+    cmd_printf("%-16s | %9d | %6d | %6d |", monitor->name ? monitor->name : "unnamed",
+               monitor->longest_permitted_delay, current_time - monitor->last_update, monitor->max_latency);
+    for (bin = 0; bin < MICO_SYSTEM_MONITOR_HISTOGRAM_BINS; bin++)
+      cmd_printf(" %4d", monitor->histogram[bin]);
+    cmd_printf("\r\n");
+    if (reset == true)
+    {
+      monitor->max_latency = 0;
+      memset(monitor->histogram, 0x0, sizeof(monitor->histogram));
+    }
+  }
+  mico_rtos_unlock_mutex( &system_monitor_mutex );
+}
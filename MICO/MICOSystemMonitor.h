@@ -36,11 +36,20 @@
 #include "Common.h"
 #include "MICODefine.h"
 
+/* Check-in latency buckets: <64ms, then one per doubling up to >=4s */
+#define MICO_SYSTEM_MONITOR_HISTOGRAM_BINS  (8)
+
+#define MICO_SYSTEM_MONITOR_NAME_LEN        (16)
+
 /** Structure to hold information about a system monitor item */
-typedef struct
+typedef struct _mico_system_monitor
 {
     uint32_t last_update;              /**< Time of the last system monitor update */
     uint32_t longest_permitted_delay;  /**< Longest permitted delay between checkins with the system monitor */
+    const char* name;                  /**< Reported in stats and in the hang snapshot */
+    uint32_t max_latency;              /**< Longest observed delay between checkins */
+    uint32_t histogram[MICO_SYSTEM_MONITOR_HISTOGRAM_BINS]; /**< Checkin delays, log2 buckets */
+    struct _mico_system_monitor* next;
 } mico_system_monitor_t;
 
 
@@ -50,6 +59,18 @@ OSStatus MICOUpdateSystemMonitor( mico_system_monitor_t* system_monitor, uint32_
 
 OSStatus MICORegisterSystemMonitor( mico_system_monitor_t* system_monitor, uint32_t initial_permitted_delay );
 
+/* Monitors are linked into a list, there is no limit on their number */
+OSStatus MICORegisterNamedSystemMonitor( mico_system_monitor_t* system_monitor, const char* name, uint32_t initial_permitted_delay );
+
+OSStatus MICOUnregisterSystemMonitor( mico_system_monitor_t* system_monitor );
+
+/* Print monitors, latency histograms and the hang reported at boot, used by CLI */
+void MICOSystemMonitorShowStats( char *pcWriteBuffer, int xWriteBufferLen, bool reset );
+
+/* Fill buffer with one line per thread for the hang snapshot, returns bytes written.
+   Weak, the default one needs MICO_SYSTEM_MONITOR_THREAD_DUMP */
+int MICOSystemMonitorThreadDump( char *buffer, int len );
+
 
 #endif //__MICO_SYSTEM_MONITOR_H__
 
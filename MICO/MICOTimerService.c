@@ -0,0 +1,365 @@
+/**
+******************************************************************************
+* @file    MICOTimerService.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   This file provide a hierarchical timing wheel shared by MICO
+*          services, all timers are driven by one thread that sleeps until
+*          the next deadline.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#include "MICO.h"
+#include "MICOTimerService.h"
+
+#define timer_service_log(M, ...) custom_log("TimerService", M, ##__VA_ARGS__)
+
+#ifndef STACK_SIZE_MICO_TIMER_SERVICE_THREAD
+#define STACK_SIZE_MICO_TIMER_SERVICE_THREAD    0x500
+#endif
+
+#ifndef MICO_TIMER_SERVICE_PRIORITY
+#define MICO_TIMER_SERVICE_PRIORITY             (MICO_APPLICATION_PRIORITY - 1)
+#endif
+
+/* 4 levels of 64 slots, level n slot covers 64^n ticks */
+#define WHEEL_BITS          (6)
+#define WHEEL_SIZE          (1 << WHEEL_BITS)
+#define WHEEL_MASK          (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS        (4)
+#define WHEEL_MAX_DELTA     ((1UL << (WHEEL_BITS * WHEEL_LEVELS)) - 1)
+
+#define TICK_AFTER_EQ(a, b) ((int32_t)((a) - (b)) >= 0)
+
+static mico_service_timer_t* wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static uint64_t wheel_pending[WHEEL_LEVELS];    /* bit n set when slot n is not empty */
+static uint32_t wheel_jiffies;                  /* next tick to be processed */
+static uint32_t wheel_now_tick, wheel_now_ms;   /* monotonic tick, survives mico_get_time wrap */
+static uint32_t wheel_sleep_until;              /* tick the service thread sleeps until */
+static bool     wheel_sleeping = false;
+static mico_timer_service_stats_t wheel_stats;
+
+static mico_mutex_t     wheel_mutex = NULL;
+static mico_semaphore_t wheel_wakeup = NULL;
+static bool             wheel_running = false;
+
+static uint32_t _service_now( void )
+{
+  uint32_t elapsed = mico_get_time() - wheel_now_ms;
+  wheel_now_tick += elapsed / MICO_TIMER_SERVICE_TICK;
+  wheel_now_ms   += (elapsed / MICO_TIMER_SERVICE_TICK) * MICO_TIMER_SERVICE_TICK;
+  return wheel_now_tick;
+}
+
+/* Index of the first set bit at or after start, rotating, or -1 */
+static int _next_slot( uint64_t pending, int start )
+{
+  uint64_t rotated;
+  int n;
+
+  if ( pending == 0 )
+    return -1;
+  rotated = ( pending >> start ) | ( start ? ( pending << ( WHEEL_SIZE - start ) ) : 0 );
+  for ( n = 0; ( rotated & 0xFF ) == 0; n += 8 )
+    rotated >>= 8;
+  while ( ( rotated & 1 ) == 0 ) {
+    rotated >>= 1;
+    n++;
+  }
+  return n;
+}
+
+static void _wheel_link( mico_service_timer_t* timer )
+{
+  uint32_t delta = timer->expires - wheel_jiffies;
+  uint32_t expires = timer->expires;
+  int level = 0, slot;
+
+  if ( (int32_t)delta < 0 ) {
+    /* Already due, run on the next tick processed */
+    delta = 0;
+    timer->expires = expires = wheel_jiffies;
+  } else if ( delta > WHEEL_MAX_DELTA ) {
+    /* Beyond the wheel: park it in the farthest top level slot, keeping the real
+       expiry. It is linked again from there when that slot is cascaded */
+    delta = WHEEL_MAX_DELTA;
+    expires = wheel_jiffies + WHEEL_MAX_DELTA;
+  }
+
+  while ( level < WHEEL_LEVELS - 1 && delta >= ( 1UL << ( WHEEL_BITS * ( level + 1 ) ) ) )
+    level++;
+  slot = ( expires >> ( WHEEL_BITS * level ) ) & WHEEL_MASK;
+
+  timer->next = wheel[level][slot];
+  if ( timer->next )
+    timer->next->pprev = &timer->next;
+  timer->pprev = &wheel[level][slot];
+  wheel[level][slot] = timer;
+  wheel_pending[level] |= ( 1ULL << slot );
+  wheel_stats.active++;
+}
+
+static void _wheel_unlink( mico_service_timer_t* timer )
+{
+  mico_service_timer_t** head = timer->pprev;
+  int level, slot;
+
+  *head = timer->next;
+  if ( timer->next )
+    timer->next->pprev = head;
+  timer->pprev = NULL;
+  timer->next = NULL;
+  wheel_stats.active--;
+
+  /* Slot emptied: head points into wheel[][], find it to clear the pending bit */
+  if ( *head == NULL && head >= &wheel[0][0] && head < &wheel[0][0] + WHEEL_LEVELS * WHEEL_SIZE ) {
+    level = ( head - &wheel[0][0] ) / WHEEL_SIZE;
+    slot  = ( head - &wheel[0][0] ) % WHEEL_SIZE;
+    wheel_pending[level] &= ~( 1ULL << slot );
+  }
+}
+
+/* Move timers of the current slot at level down to lower levels, returns the slot index */
+static int _wheel_cascade( int level )
+{
+  int slot = ( wheel_jiffies >> ( WHEEL_BITS * level ) ) & WHEEL_MASK;
+  mico_service_timer_t* list = wheel[level][slot];
+  mico_service_timer_t* timer;
+
+  wheel[level][slot] = NULL;
+  wheel_pending[level] &= ~( 1ULL << slot );
+  while ( list ) {
+    timer = list;
+    list = list->next;
+    wheel_stats.active--;
+    _wheel_link( timer );
+  }
+  return slot;
+}
+
+/* Ticks from wheel_jiffies to the earliest expiry, at most WHEEL_MAX_DELTA so
+   the thread wakes up in time to cascade parked timers */
+static uint32_t _wheel_next_event( void )
+{
+  mico_service_timer_t* timer;
+  uint32_t next = WHEEL_MAX_DELTA, delta, cascade;
+  int level, n, index;
+
+  n = _next_slot( wheel_pending[0], wheel_jiffies & WHEEL_MASK );
+  if ( n >= 0 )
+    next = n;
+
+  /* The first busy slot of a higher level holds the earliest timers of that
+     level, look at them directly so the thread does not wake up only to cascade */
+  for ( level = 1; level < WHEEL_LEVELS; level++ ) {
+    /* The current slot was cascaded when this round started */
+    index = ( wheel_jiffies >> ( WHEEL_BITS * level ) ) & WHEEL_MASK;
+    n = _next_slot( wheel_pending[level], ( index + 1 ) & WHEEL_MASK );
+    if ( n < 0 )
+      continue;
+    cascade = ( ( ( wheel_jiffies >> ( WHEEL_BITS * level ) ) + 1 + n ) << ( WHEEL_BITS * level ) ) - wheel_jiffies;
+    for ( timer = wheel[level][( index + 1 + n ) & WHEEL_MASK]; timer; timer = timer->next ) {
+      /* A parked timer is due no earlier than its slot, wake up to cascade it */
+      delta = timer->expires - wheel_jiffies;
+      if ( delta > WHEEL_MAX_DELTA )
+        delta = cascade;
+      if ( delta < next )
+        next = delta;
+    }
+  }
+  return next;
+}
+
+/* Take the first due timer, re-arm periodic ones. Called with wheel_mutex locked */
+static mico_service_timer_t* _wheel_expire_one( uint32_t now )
+{
+  mico_service_timer_t* timer;
+  int level, slot;
+
+  while ( TICK_AFTER_EQ( now, wheel_jiffies ) ) {
+    slot = wheel_jiffies & WHEEL_MASK;
+    timer = wheel[0][slot];
+    if ( timer ) {
+      _wheel_unlink( timer );
+      if ( timer->period ) {
+        timer->expires += timer->period;
+        _wheel_link( timer );
+      }
+      return timer;
+    }
+
+    /* Slot done. With level 0 empty nothing is due before the next cascade */
+    if ( wheel_pending[0] == 0 && ( now - wheel_jiffies ) >= (uint32_t)( WHEEL_MASK - slot ) )
+      wheel_jiffies += WHEEL_SIZE - slot;
+    else if ( wheel_pending[0] == 0 )
+      wheel_jiffies = now + 1;
+    else
+      wheel_jiffies++;
+
+    if ( ( wheel_jiffies & WHEEL_MASK ) == 0 ) {
+      for ( level = 1; level < WHEEL_LEVELS; level++ )
+        if ( _wheel_cascade( level ) != 0 )
+          break;
+    }
+  }
+  return NULL;
+}
+
+static void _timer_service_thread( void* arg )
+{
+  mico_service_timer_t* timer;
+  uint32_t now, next;
+  int32_t sleep_ms;
+  UNUSED_PARAMETER( arg );
+
+  while ( 1 ) {
+    mico_rtos_lock_mutex( &wheel_mutex );
+    wheel_sleeping = false;
+    wheel_stats.wakeups++;
+    now = _service_now();
+    while ( ( timer = _wheel_expire_one( now ) ) != NULL ) {
+      wheel_stats.fired++;
+      if ( timer->reactor ) {
+        if ( mico_rtos_push_to_queue( timer->reactor, &timer, 0 ) != kNoErr )
+          wheel_stats.post_failed++;
+        continue;
+      }
+      /* Handler may start or stop timers, including itself */
+      mico_rtos_unlock_mutex( &wheel_mutex );
+      timer->handler( timer->arg );
+      mico_rtos_lock_mutex( &wheel_mutex );
+      now = _service_now();
+    }
+
+    next = _wheel_next_event();
+    wheel_sleep_until = wheel_jiffies + next;
+    wheel_sleeping = true;
+    /* Handlers or a late wakeup may have run past the deadline already, and a
+       deadline in the past means no sleep rather than a near endless one */
+    now = _service_now();
+    sleep_ms = (int32_t)( wheel_sleep_until - now ) * MICO_TIMER_SERVICE_TICK - (int32_t)( mico_get_time() - wheel_now_ms );
+    if ( sleep_ms < 0 )
+      sleep_ms = 0;
+    mico_rtos_unlock_mutex( &wheel_mutex );
+
+    mico_rtos_get_semaphore( &wheel_wakeup, (uint32_t)sleep_ms );
+  }
+}
+
+OSStatus MICOStartTimerService( void )
+{
+  OSStatus err = kNoErr;
+
+  if ( wheel_running == true )
+    return kNoErr;
+
+  memset( wheel, 0x0, sizeof(wheel) );
+  memset( wheel_pending, 0x0, sizeof(wheel_pending) );
+  memset( &wheel_stats, 0x0, sizeof(wheel_stats) );
+  wheel_now_ms = mico_get_time();
+  wheel_now_tick = 0;
+  wheel_jiffies = 0;
+
+  err = mico_rtos_init_mutex( &wheel_mutex );
+  require_noerr( err, exit );
+  err = mico_rtos_init_semaphore( &wheel_wakeup, 1 );
+  require_noerr( err, exit );
+  err = mico_rtos_create_thread( NULL, MICO_TIMER_SERVICE_PRIORITY, "Timer Service", _timer_service_thread, STACK_SIZE_MICO_TIMER_SERVICE_THREAD, NULL );
+  require_noerr( err, exit );
+  wheel_running = true;
+
+exit:
+  if ( err != kNoErr )
+    timer_service_log( "ERROR: Unable to start timer service, err = %d", err );
+  return err;
+}
+
+void MICOInitServiceTimer( mico_service_timer_t* timer, mico_service_timer_handler_t handler, void* arg )
+{
+  memset( timer, 0x0, sizeof(mico_service_timer_t) );
+  timer->handler = handler;
+  timer->arg = arg;
+}
+
+void MICOPostServiceTimer( mico_service_timer_t* timer, mico_queue_t* reactor )
+{
+  timer->reactor = reactor;
+}
+
+OSStatus MICOStartServiceTimer( mico_service_timer_t* timer, uint32_t delay_ms, uint32_t period_ms )
+{
+  bool wakeup;
+
+  if ( wheel_running == false )
+    return kNotInitializedErr;
+
+  mico_rtos_lock_mutex( &wheel_mutex );
+  if ( timer->pprev )
+    _wheel_unlink( timer );
+  /* Round up from the current time, not from the start of the current tick */
+  timer->expires = _service_now();
+  timer->expires += ( delay_ms + ( mico_get_time() - wheel_now_ms ) + MICO_TIMER_SERVICE_TICK - 1 ) / MICO_TIMER_SERVICE_TICK;
+  timer->period = ( period_ms + MICO_TIMER_SERVICE_TICK - 1 ) / MICO_TIMER_SERVICE_TICK;
+  if ( period_ms && timer->period == 0 )
+    timer->period = 1;
+  _wheel_link( timer );
+  /* Only disturb the service thread if it would sleep past the new deadline */
+  wakeup = ( wheel_sleeping == true ) && !TICK_AFTER_EQ( timer->expires, wheel_sleep_until );
+  if ( wakeup )
+    wheel_sleeping = false;
+  mico_rtos_unlock_mutex( &wheel_mutex );
+
+  if ( wakeup )
+    mico_rtos_set_semaphore( &wheel_wakeup );
+  return kNoErr;
+}
+
+OSStatus MICOStopServiceTimer( mico_service_timer_t* timer )
+{
+  if ( wheel_running == false )
+    return kNotInitializedErr;
+
+  mico_rtos_lock_mutex( &wheel_mutex );
+  if ( timer->pprev )
+    _wheel_unlink( timer );
+  timer->period = 0;
+  mico_rtos_unlock_mutex( &wheel_mutex );
+  return kNoErr;
+}
+
+bool MICOServiceTimerIsActive( mico_service_timer_t* timer )
+{
+  return ( timer->pprev != NULL ) ? true : false;
+}
+
+void MICORunServiceTimer( mico_service_timer_t* timer )
+{
+  if ( timer && timer->handler )
+    timer->handler( timer->arg );
+}
+
+void MICOGetTimerServiceStats( mico_timer_service_stats_t* stats )
+{
+  memcpy( stats, &wheel_stats, sizeof(mico_timer_service_stats_t) );
+}
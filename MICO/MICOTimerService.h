@@ -0,0 +1,84 @@
+/**
+******************************************************************************
+* @file    MICOTimerService.h 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Shared timer service: a hierarchical timing wheel driven by one 
+*          thread, used instead of per-feature polling threads.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#ifndef __MICOTIMERSERVICE_H__
+#define __MICOTIMERSERVICE_H__
+
+#include "Common.h"
+#include "MICORTOS.h"
+
+/* Timer resolution, delays are rounded up to a multiple of this */
+#ifndef MICO_TIMER_SERVICE_TICK
+#define MICO_TIMER_SERVICE_TICK         (10)
+#endif
+
+typedef void (*mico_service_timer_handler_t)( void* arg );
+
+/** Timer owned by the caller, add and cancel do not allocate */
+typedef struct _mico_service_timer
+{
+    struct _mico_service_timer*  next;
+    struct _mico_service_timer** pprev;     /**< NULL when the timer is not armed */
+    uint32_t                     expires;   /**< Service tick of the next expiry */
+    uint32_t                     period;    /**< Ticks between expiries, 0 for one-shot */
+    mico_service_timer_handler_t handler;
+    void*                        arg;
+    mico_queue_t*                reactor;   /**< If set, the timer is posted here instead of run */
+} mico_service_timer_t;
+
+typedef struct
+{
+    uint32_t wakeups;                       /**< Times the service thread woke up */
+    uint32_t fired;                         /**< Handlers run or posted */
+    uint32_t post_failed;                   /**< Reactor queue full */
+    uint32_t active;                        /**< Timers armed now */
+} mico_timer_service_stats_t;
+
+OSStatus MICOStartTimerService( void );
+
+void MICOInitServiceTimer( mico_service_timer_t* timer, mico_service_timer_handler_t handler, void* arg );
+
+/* Expired timer is pushed as a (mico_service_timer_t *) message to reactor, which
+   calls MICORunServiceTimer from its own loop. NULL runs it on the service thread */
+void MICOPostServiceTimer( mico_service_timer_t* timer, mico_queue_t* reactor );
+
+/* Arm or re-arm a timer, period_ms 0 makes it one-shot */
+OSStatus MICOStartServiceTimer( mico_service_timer_t* timer, uint32_t delay_ms, uint32_t period_ms );
+
+OSStatus MICOStopServiceTimer( mico_service_timer_t* timer );
+
+bool MICOServiceTimerIsActive( mico_service_timer_t* timer );
+
+void MICORunServiceTimer( mico_service_timer_t* timer );
+
+void MICOGetTimerServiceStats( mico_timer_service_stats_t* stats );
+
+#endif //__MICOTIMERSERVICE_H__
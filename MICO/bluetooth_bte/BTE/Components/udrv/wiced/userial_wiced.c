@@ -694,149 +694,214 @@ UDRV_API BOOLEAN USERIAL_Feature( tUSERIAL_FEATURE feature )
     return FALSE;
 }
 
-int bt_hci_transport_driver_bus_read_handler( BT_HDR* packet )
+/*******************************************************************************
+ **
+ ** H4 framer
+ **
+ ** Bytes are pulled from the UART ring in as few MicoUartRecv calls as
+ ** possible: whatever is already buffered is read in one go, and the thread
+ ** only blocks for the bytes still missing from the current packet. Complete
+ ** packets are framed in place in the staging buffer and copied once into a
+ ** buffer of the HCI ACL pool, which the stack expects to reuse and extend in
+ ** place. Packets larger than the staging buffer get their remaining payload
+ ** received straight into the GKI buffer.
+ **
+ *******************************************************************************/
+#ifndef USERIAL_RX_STAGE_SIZE
+#define USERIAL_RX_STAGE_SIZE       (512)
+#endif
+
+#define H4_EVENT_HDR_SIZE           (3)     /* packet_type + event_code + content_length */
+#define H4_ACL_HDR_SIZE             (1 + HCI_DATA_PREAMBLE_SIZE)
+#define H4_LOOPBACK_HDR_SIZE        (2)     /* packet_type + content_length */
+
+typedef struct
 {
-    hci_packet_type_t packet_type = HCI_UNINITIALIZED;
-    UINT8 *current_packet;
+    uint32_t packets;
+    uint32_t bytes;
+    uint32_t uart_reads;
+    uint32_t batches;
+    uint32_t dropped_bytes;
+} userial_rx_stats_t;
+
+static uint8_t  userial_rx_stage[USERIAL_RX_STAGE_SIZE];
+static uint32_t userial_rx_stage_len = 0;
+userial_rx_stats_t userial_rx_stats;
+
+/* Returns the full H4 length of the packet at p, 0 if more bytes are needed to
+ * know it, -1 if the packet type or length is invalid */
+static int h4_packet_length( const uint8_t *p, uint32_t avail )
+{
+    uint32_t len;
 
-    if ( packet == NULL )
+    switch ( p[0] )
     {
-        return kGeneralErr;
+        case HCI_EVENT_PACKET:
+            if ( avail < H4_EVENT_HDR_SIZE )
+                return 0;
+            return H4_EVENT_HDR_SIZE + p[2];
+
+        case HCI_ACL_DATA_PACKET:
+            if ( avail < H4_ACL_HDR_SIZE )
+                return 0;
+            len = p[3] | ( p[4] << 8 );
+            if ( len > (uint32_t) ( HCI_ACL_POOL_BUF_SIZE - BT_HDR_SIZE - H4_ACL_HDR_SIZE ) )
+            {
+                DRV_TRACE_ERROR1("bt_bus error invalid acl len %i", len);
+                return -1;
+            }
+            return H4_ACL_HDR_SIZE + len;
+
+        case HCI_LOOPBACK_MODE:
+            if ( avail < H4_LOOPBACK_HDR_SIZE )
+                return 0;
+            return H4_LOOPBACK_HDR_SIZE + p[1];
+
+        case HCI_COMMAND_PACKET: /* Fall-through */
+        default:
+            return -1;
     }
+}
+
+/* Fill the staging buffer with at least min_bytes more, plus anything already buffered */
+static int h4_stage_fill( uint32_t min_bytes )
+{
+    uint32_t space = USERIAL_RX_STAGE_SIZE - userial_rx_stage_len;
+    uint32_t size = MicoUartGetLengthInBuffer( BT_UART );
 
-    packet->offset = 0;
-    packet->layer_specific = 0;
-    current_packet = (UINT8 *) ( packet + 1 );
+    if ( size < min_bytes )
+        size = min_bytes;
+    if ( size > space )
+        size = space;
 
-    // Read 1 byte:
-    //    packet_type
-    // Use a timeout here so we can shutdown the thread
-    if ( bt_bus_receive( (uint8_t*) &packet_type, 1, MICO_NEVER_TIMEOUT ) != kNoErr)
+    userial_rx_stats.uart_reads++;
+    if ( bt_bus_receive( &userial_rx_stage[userial_rx_stage_len], size, MICO_NEVER_TIMEOUT ) != kNoErr )
     {
-        DRV_TRACE_ERROR0("bt_bus error reading pkt_type");
+        DRV_TRACE_ERROR0("bt_bus error reading h4 stream");
         return kGeneralErr;
     }
+    userial_rx_stage_len += size;
+    return kNoErr;
+}
 
-//    DRV_TRACE_DEBUG1("bt_hci_transport_driver_bus_read_handler packet_type=0x%x", packet_type);
+/* Hand one framed packet to the stack. staged bytes are at p, the rest is read from the bus */
+static int h4_deliver_packet( const uint8_t *p, uint32_t staged, uint32_t pkt_len )
+{
+    BT_HDR *p_buf;
+    UINT8 *data;
 
-    switch ( packet_type )
+    p_buf = (BT_HDR *) GKI_getpoolbuf( HCI_ACL_POOL_ID );
+    if ( p_buf == NULL )
     {
-        case HCI_LOOPBACK_MODE:
-            *current_packet++ = packet_type;
+        return kNoMemoryErr;
+    }
 
-            // Read 1 byte:
-            //    content_length
-            if ( bt_bus_receive( current_packet, 1, MICO_NEVER_TIMEOUT ) != kNoErr )
-            {
-                return kGeneralErr;
-            }
+    p_buf->offset = 0;
+    p_buf->layer_specific = 0;
+    p_buf->len = (UINT16) pkt_len;
+    data = (UINT8 *) ( p_buf + 1 );
+    memcpy( data, p, staged );
 
-            packet->len = *current_packet++;
-            DRV_TRACE_DEBUG1("HCI_LOOPBACK_MODE packet->len=0x%x", packet->len)
-            ;
+    if ( staged < pkt_len )
+    {
+        userial_rx_stats.uart_reads++;
+        if ( bt_bus_receive( data + staged, pkt_len - staged, MICO_NEVER_TIMEOUT ) != kNoErr )
+        {
+            GKI_freebuf( p_buf );
+            return kGeneralErr;
+        }
+    }
 
-            // Read payload
-            if ( bt_bus_receive( current_packet, packet->len, MICO_NEVER_TIMEOUT ) != kNoErr )
-            {
-                DRV_TRACE_DEBUG0("bt_bus_receive FAIL in bt_hci_transport_driver_bus_read_handler");
-                return kGeneralErr;
-            }
+    GKI_enqueue( &Userial_in_q, p_buf );
+    userial_rx_stats.packets++;
+    userial_rx_stats.bytes += pkt_len;
+    return kNoErr;
+}
 
-            packet->len = packet->len + 2; // +2 for packet type + read length
+/* Frame every complete packet in the staging buffer, returns number of packets queued.
+ * no_memory is set when a packet is left in the stage for lack of a GKI buffer */
+static int h4_frame_packets( bool *no_memory )
+{
+    uint32_t pos = 0, avail;
+    int pkt_len, ret, queued = 0;
 
+    while ( pos < userial_rx_stage_len )
+    {
+        avail = userial_rx_stage_len - pos;
+        pkt_len = h4_packet_length( &userial_rx_stage[pos], avail );
+        if ( pkt_len < 0 )
+        {
+            /* Lost sync, skip the byte and look for the next packet type */
+            userial_rx_stats.dropped_bytes++;
+            pos++;
+            continue;
+        }
+        if ( pkt_len == 0 )
+            break;
+        if ( (uint32_t) pkt_len > avail && pkt_len <= USERIAL_RX_STAGE_SIZE )
             break;
 
-        case HCI_EVENT_PACKET:
+        /* Complete packet, or one that can never fit: pull its tail from the bus */
+        if ( (uint32_t) pkt_len > avail )
         {
-            hci_event_header_t header;
-
-            // Read 2 bytes:
-            //    event_code
-            //    content_length
-            if ( bt_bus_receive( (uint8_t*) &header.event_code, sizeof( header ) - sizeof( packet_type ), MICO_NEVER_TIMEOUT ) != kNoErr )
+            ret = h4_deliver_packet( &userial_rx_stage[pos], avail, pkt_len );
+            if ( ret == kNoMemoryErr )
             {
-                return kGeneralErr;
+                *no_memory = true;
+                break;
             }
-
-            header.packet_type = packet_type;
-            *current_packet++ = packet_type;
-            *current_packet++ = header.event_code;
-            *current_packet++ = header.content_length;
-            packet->len = header.content_length + 3; // +3 to include sizeof: packet_type=1 event_code=1 content_length=1
-
-            // Read payload
-            if ( bt_bus_receive( (uint8_t*) current_packet, (uint32_t) header.content_length, MICO_NEVER_TIMEOUT ) != kNoErr )
+            pos = userial_rx_stage_len;
+            if ( ret != kNoErr )
             {
-                return kGeneralErr;
+                /* Tail lost, the buffer is freed and the stream resyncs on the next type byte */
+                userial_rx_stats.dropped_bytes += avail;
+                continue;
             }
-
-            break;
         }
-
-        case HCI_ACL_DATA_PACKET:
+        else
         {
-            hci_acl_packet_header_t header;
-
-            // Read 4 bytes:
-            //    hci_handle (2 bytes)
-            //    content_length (2 bytes)
-            if ( bt_bus_receive( (uint8_t*) &header.hci_handle, HCI_DATA_PREAMBLE_SIZE, MICO_NEVER_TIMEOUT ) != kNoErr )
-            {
-                DRV_TRACE_ERROR0("bt_bus error acl header");
-                return kGeneralErr;
-            }
-
-            header.packet_type = packet_type;
-            UINT8_TO_STREAM(current_packet, packet_type);
-            UINT16_TO_STREAM(current_packet, header.hci_handle);
-            UINT16_TO_STREAM(current_packet, header.content_length);
-
-            packet->len = header.content_length + 5; // +5 to include sizeof: packet_type=1 hci_handle=2 content_length=2
-
-#ifdef L2CAP_REASSEMBLE
-
-            /* Check for segmented packets. If this is a continuation packet, then   */
-            /* current rcv buffer will be freed, and we will continue appending data */
-            /* to the original rcv buffer.                                           */
-            if ((packet = l2cap_link_chk_pkt_start (packet)) == NULL)
+            if ( h4_deliver_packet( &userial_rx_stage[pos], pkt_len, pkt_len ) == kNoMemoryErr )
             {
-                /* If a NULL is returned, then we have a problem. Ignore remaining data in this packet */
-                p_cb->rcv_len = msg_len;
-                if (msg_len == 0)
-                {
-                    p_cb->rcv_state = HCISU_H4_MSGTYPE_ST;  /* Wait for next message */
-                }
-                else
-                {
-                    HCI_TRACE_ERROR0("HCIS: Ignoring....");
-
-                    p_cb->rcv_state = HCISU_H4_IGNORE_ST;   /* Ignore rest of the packet */
-                }
-
+                *no_memory = true;
                 break;
             }
-#endif
-
-            if (header.content_length > (HCI_ACL_POOL_BUF_SIZE - BT_HDR_SIZE))
-            {
-                DRV_TRACE_ERROR1("bt_bus error invalid acl len %i", header.content_length);
-                return kGeneralErr;
-            }
-            // Read payload
-            if ( bt_bus_receive( (uint8_t*) current_packet, (uint32_t) header.content_length, MICO_NEVER_TIMEOUT ) != kNoErr )
-            {
-                return kGeneralErr;
-            }
-
-            break;
+            pos += pkt_len;
         }
+        queued++;
+    }
 
-        case HCI_COMMAND_PACKET: /* Fall-through */
-        default:
-            return kGeneralErr;
+    /* Keep the partial packet at the front, it is smaller than one packet */
+    if ( pos > 0 )
+    {
+        userial_rx_stage_len -= pos;
+        memmove( userial_rx_stage, &userial_rx_stage[pos], userial_rx_stage_len );
     }
+    return queued;
+}
 
-    return kNoErr;
+/* Bytes that must still arrive before the packet at the head of the stage is complete */
+static uint32_t h4_bytes_missing( void )
+{
+    int pkt_len;
+
+    if ( userial_rx_stage_len == 0 )
+        return 1;
+    pkt_len = h4_packet_length( userial_rx_stage, userial_rx_stage_len );
+    if ( pkt_len <= 0 )
+    {
+        switch ( userial_rx_stage[0] )
+        {
+            case HCI_EVENT_PACKET:
+                return H4_EVENT_HDR_SIZE - userial_rx_stage_len;
+            case HCI_ACL_DATA_PACKET:
+                return H4_ACL_HDR_SIZE - userial_rx_stage_len;
+            default:
+                return H4_LOOPBACK_HDR_SIZE - userial_rx_stage_len;
+        }
+    }
+    if ( (uint32_t) pkt_len <= userial_rx_stage_len )
+        return 0;
+    return (uint32_t) pkt_len - userial_rx_stage_len;
 }
 
 /*******************************************************************************
@@ -852,48 +917,35 @@ int bt_hci_transport_driver_bus_read_handler( BT_HDR* packet )
  *******************************************************************************/
 void userial_read_thread(void* arg)
 {
-    BT_HDR *p_buf;
-    int ret;
+    uint32_t missing;
+    bool no_memory = false;
+
+    userial_rx_stage_len = 0;
 
     while ( g_readThreadAlive )
     {
-        // FIXME:TODO: Decide on the correct buffer size
-//        if ( ( p_buf = (BT_HDR *) GKI_getbuf( GKI_BUF1_SIZE /*200*/) ) != NULL )
-        if ( ( p_buf = (BT_HDR *) GKI_getbuf( HCI_ACL_POOL_BUF_SIZE) ) != NULL )
+        missing = h4_bytes_missing( );
+        if ( missing == 0 || no_memory )
         {
-            ret = bt_hci_transport_driver_bus_read_handler( p_buf );
-            if ( ret == kGeneralErr )
-            {
-                GKI_freebuf( p_buf );
-                continue;
-            }
-
-//            DRV_TRACE_DEBUG1("USERIAL_Read enqueue %08x", p_buf);
-
-#if 0
-            p = (p_buf+1);
-            if (p[0] == HCI_ACL_DATA_PACKET)
-            {
-                /* Skip over packet type */
-                p_buf->offset = 1;
-                p_buf->len -= 1;
-                p_buf->layer_specific = 0;
-                p_buf->event = BT_EVT_TO_BTU_HCI_ACL;
-                GKI_send_msg(BTU_TASK, 0, p_buf);
-                continue;
-            }
-#endif
-            GKI_enqueue( &Userial_in_q, p_buf );
-
+            /* The head packet is waiting for a GKI buffer, complete or not. Reading on
+             * would spin, a packet longer than the stage leaves no room to read into */
+            GKI_delay(2000);
+        }
+        else if ( h4_stage_fill( missing ) != kNoErr )
+        {
+            continue;
+        }
 
-            if (userial_cb.p_cback)
-            {
-                (userial_cb.p_cback)(0, USERIAL_RX_READY_EVT, NULL);
-            }
+        no_memory = false;
+        if ( h4_frame_packets( &no_memory ) == 0 )
+        {
+            continue;
         }
-        else
+
+        userial_rx_stats.batches++;
+        if (userial_cb.p_cback)
         {
-            GKI_delay(2000);
+            (userial_cb.p_cback)(0, USERIAL_RX_READY_EVT, NULL);
         }
     }
 
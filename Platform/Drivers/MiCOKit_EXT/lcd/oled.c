@@ -22,6 +22,7 @@ operation
 
 #include "oled.h"
 #include "stdlib.h"
+#include "string.h"
 #include "oledfont.h"  	 
 //#include "delay.h"
 #include "MICO.h"
@@ -59,6 +60,13 @@ uint8_t spi_tx_buffer = 0;
 //[6]0 1 2 3 ... 127	
 //[7]0 1 2 3 ... 127 			   
 
+/* Frame buffer in the layout above, bit n of OLED_GRAM[page][x] is row page*8+n.
+ * Drawing only changes the buffer, OLED_Refresh_Gram() sends what changed. */
+static u8 OLED_GRAM[8][Max_Column];
+/* Columns [start, end) of each page that differ from the panel, start == end when clean */
+static u8 oled_dirty_start[8];
+static u8 oled_dirty_end[8];
+
 #if OLED_MODE==1
 //SSD1106дһֽڡ
 //dat:Ҫд/
@@ -76,73 +84,186 @@ void OLED_WR_Byte(u8 dat,u8 cmd)
   OLED_CS_Set();	  
   OLED_DC_Set();	 
 } 	    	    
-#else
-//SSD1106дһֽڡ
-//dat:Ҫд/
-//cmd:/־ 0,ʾ;1,ʾ;
-void OLED_WR_Byte(u8 dat,u8 cmd)
-{  
-  platform_spi_config_t config;
-  platform_spi_message_segment_t oled_spi_msg =
-            { &dat,            NULL,       (unsigned long) 1 };
 
-  config.chip_select = &platform_gpio_pins[micokit_spi_oled.chip_select];
-  config.speed       = micokit_spi_oled.speed;
-  config.mode        = micokit_spi_oled.mode;
-  config.bits        = micokit_spi_oled.bits;
+static void oled_bus_open(platform_spi_config_t *config)
+{
+  UNUSED_PARAMETER(config);
+}
+
+static void oled_bus_close(void)
+{
+}
+
+static void oled_bus_write(const platform_spi_config_t *config, const u8 *dat, u16 len, u8 cmd)
+{
+  UNUSED_PARAMETER(config);
+  while(len--)
+    OLED_WR_Byte(*dat++,cmd);
+}
+#else
+/* Take the SPI port (it may be shared with other devices) and set it up for the panel */
+static void oled_bus_open(platform_spi_config_t *config)
+{
+  config->chip_select = &platform_gpio_pins[micokit_spi_oled.chip_select];
+  config->speed       = micokit_spi_oled.speed;
+  config->mode        = micokit_spi_oled.mode;
+  config->bits        = micokit_spi_oled.bits;
   
   if( platform_spi_drivers[micokit_spi_oled.port].spi_mutex == NULL)
     mico_rtos_init_mutex( &platform_spi_drivers[micokit_spi_oled.port].spi_mutex );
 
   mico_rtos_lock_mutex( &platform_spi_drivers[micokit_spi_oled.port].spi_mutex );
 
-  platform_spi_init( &platform_spi_drivers[micokit_spi_oled.port], &platform_spi_peripherals[micokit_spi_oled.port], &config );
+  platform_spi_init( &platform_spi_drivers[micokit_spi_oled.port], &platform_spi_peripherals[micokit_spi_oled.port], config );
   OLED_DC_INIT();   
+}
+
+static void oled_bus_close(void)
+{
+  OLED_DC_Set();   
+
+  mico_rtos_unlock_mutex( &platform_spi_drivers[micokit_spi_oled.port].spi_mutex );
+}
+
+/* Send len bytes of data or commands in one transfer, the bus must be open */
+static void oled_bus_write(const platform_spi_config_t *config, const u8 *dat, u16 len, u8 cmd)
+{
+  platform_spi_message_segment_t oled_spi_msg =
+            { dat,            NULL,       (unsigned long) len };
 
   if(cmd)
     OLED_DC_Set();
   else 
     OLED_DC_Clr();		  
 
-  platform_spi_transfer( &platform_spi_drivers[micokit_spi_oled.port], &config, &oled_spi_msg, 1 );
-  
-  OLED_DC_Set();   
+  platform_spi_transfer( &platform_spi_drivers[micokit_spi_oled.port], config, &oled_spi_msg, 1 );
+}
 
-  mico_rtos_unlock_mutex( &platform_spi_drivers[micokit_spi_oled.port].spi_mutex );
+//SSD1106дһֽڡ
+//dat:Ҫд/
+//cmd:/־ 0,ʾ;1,ʾ;
+void OLED_WR_Byte(u8 dat,u8 cmd)
+{  
+  OLED_WR_Bytes(&dat,1,cmd);
 } 
 #endif
 
+/* Write a command sequence or data in one go */
+void OLED_WR_Bytes(const u8 *dat,u16 len,u8 cmd)
+{
+  platform_spi_config_t config;
+
+  oled_bus_open(&config);
+  oled_bus_write(&config,dat,len,cmd);
+  oled_bus_close();
+}
+
 void OLED_Set_Pos(unsigned char x, unsigned char y) 
 { 
-  OLED_WR_Byte(0xb0+y,OLED_CMD);
-  OLED_WR_Byte(((x&0xf0)>>4)|0x10,OLED_CMD);
-  OLED_WR_Byte((x&0x0f)|0x01,OLED_CMD); 
+  u8 cmd[3];
+
+  cmd[0]=0xb0+y;
+  cmd[1]=((x&0xf0)>>4)|0x10;
+  cmd[2]=(x&0x0f)|0x01;
+  OLED_WR_Bytes(cmd,3,OLED_CMD);
 }   	  
 //OLEDʾ    
 void OLED_Display_On(void)
 {
-  OLED_WR_Byte(0X8D,OLED_CMD);  //SET DCDC
-  OLED_WR_Byte(0X14,OLED_CMD);  //DCDC ON
-  OLED_WR_Byte(0XAF,OLED_CMD);  //DISPLAY ON
+  static const u8 cmd[3]={0X8D,0X14,0XAF};  //SET DCDC, DCDC ON, DISPLAY ON
+  OLED_WR_Bytes(cmd,3,OLED_CMD);
 }
 //رOLEDʾ     
 void OLED_Display_Off(void)
 {
-  OLED_WR_Byte(0X8D,OLED_CMD);  //SET DCDC
-  OLED_WR_Byte(0X10,OLED_CMD);  //DCDC OFF
-  OLED_WR_Byte(0XAE,OLED_CMD);  //DISPLAY OFF
-}		   			 
+  static const u8 cmd[3]={0X8D,0X10,0XAE};  //SET DCDC, DCDC OFF, DISPLAY OFF
+  OLED_WR_Bytes(cmd,3,OLED_CMD);
+}
+
+static void oled_mark_dirty(u8 page,u8 x0,u8 x1)
+{
+  if(oled_dirty_start[page]==oled_dirty_end[page]){
+    oled_dirty_start[page]=x0;
+    oled_dirty_end[page]=x1;
+  }
+  else{
+    if(x0<oled_dirty_start[page]) oled_dirty_start[page]=x0;
+    if(x1>oled_dirty_end[page]) oled_dirty_end[page]=x1;
+  }
+}
+
+/* Put one byte of a page into the frame buffer, columns off the panel are dropped */
+static void oled_gram_write(u8 x,u8 page,u8 dat)
+{
+  if(x>=Max_Column||page>=8||OLED_GRAM[page][x]==dat)
+    return;
+  OLED_GRAM[page][x]=dat;
+  oled_mark_dirty(page,x,x+1);
+}
+
+/* Send the changed columns of the frame buffer: the bus is set up once, then each dirty
+ * page takes one command transfer (page and column address) and one data transfer. */
+void OLED_Refresh_Gram(void)
+{
+  platform_spi_config_t config;
+  u8 page,x0,cmd[3];
+
+  for(page=0;page<8;page++)
+    if(oled_dirty_start[page]!=oled_dirty_end[page]) break;
+  if(page==8)
+    return;
+
+  oled_bus_open(&config);
+  for(;page<8;page++)
+  {
+    if(oled_dirty_start[page]==oled_dirty_end[page])
+      continue;
+    /* Even start column, so buffer column x lands where OLED_Set_Pos(x,page) puts it */
+    x0=oled_dirty_start[page]&~1;
+    cmd[0]=0xb0+page;
+    cmd[1]=((x0&0xf0)>>4)|0x10;
+    cmd[2]=(x0&0x0f)|0x01;
+    oled_bus_write(&config,cmd,3,OLED_CMD);
+    oled_bus_write(&config,&OLED_GRAM[page][x0],oled_dirty_end[page]-x0,OLED_DATA);
+    oled_dirty_start[page]=oled_dirty_end[page]=0;
+  }
+  oled_bus_close();
+}
+
+//, x:0~127, y:0~63, t:1  0,. OLED_Refresh_Gram()ʾ
+void OLED_DrawPoint(u8 x,u8 y,u8 t)
+{
+  u8 page,bit;
+
+  if(x>=Max_Column||y>=Max_Row)
+    return;
+  page=y/8;
+  bit=1<<(y%8);
+  if(t)
+    oled_gram_write(x,page,OLED_GRAM[page][x]|bit);
+  else
+    oled_gram_write(x,page,OLED_GRAM[page][x]&~bit);
+}
+
+//(x1,y1)~(x2,y2), ߽, dot:0,;1,. OLED_Refresh_Gram()ʾ
+void OLED_Fill(u8 x1,u8 y1,u8 x2,u8 y2,u8 dot)
+{
+  u8 x,y;
+
+  for(x=x1;x<=x2&&x<Max_Column;x++)
+    for(y=y1;y<=y2&&y<Max_Row;y++)
+      OLED_DrawPoint(x,y,dot);
+}
+
 //,,ĻǺɫ!ûһ!!!	  
 void OLED_Clear(void)  
 {  
-  u8 i,n;		    
-  for(i=0;i<8;i++)  
-  {  
-    OLED_WR_Byte (0xb0+i,OLED_CMD);    //ҳַ0~7
-    OLED_WR_Byte (0x00,OLED_CMD);      //ʾλáе͵ַ
-    OLED_WR_Byte (0x10,OLED_CMD);      //ʾλáиߵַ   
-    for(n=0;n<128;n++)OLED_WR_Byte(0,OLED_DATA); 
-  } //ʾ
+  u8 i;
+
+  memset(OLED_GRAM,0,sizeof(OLED_GRAM));
+  for(i=0;i<8;i++)
+    oled_mark_dirty(i,0,Max_Column);  //ҳд, δ֪
+  OLED_Refresh_Gram();
 }
 
 
@@ -151,27 +272,31 @@ void OLED_Clear(void)
 //y:0~63
 //mode:0,ʾ;1,ʾ				 
 //size:ѡ 16/12 
-void OLED_ShowChar(u8 x,u8 y,u8 chr)
+static void oled_put_char(u8 x,u8 y,u8 chr)
 {      	
   unsigned char c=0,i=0;	
   c=chr-' ';//õƫƺֵ			
   if(x>Max_Column-1){x=0;y=y+2;}
   if(SIZE ==16)
   {
-    OLED_Set_Pos(x,y);	
     for(i=0;i<8;i++)
-      OLED_WR_Byte(F8X16[c*16+i],OLED_DATA);
-    OLED_Set_Pos(x,y+1);
-    for(i=0;i<8;i++)
-      OLED_WR_Byte(F8X16[c*16+i+8],OLED_DATA);
+    {
+      oled_gram_write(x+i,y,F8X16[c*16+i]);
+      oled_gram_write(x+i,y+1,F8X16[c*16+i+8]);
+    }
   }
   else {	
-    OLED_Set_Pos(x,y+1);
     for(i=0;i<6;i++)
-      OLED_WR_Byte(F6x8[c][i],OLED_DATA);
+      oled_gram_write(x+i,y+1,F6x8[c][i]);
     
   }
 }
+
+void OLED_ShowChar(u8 x,u8 y,u8 chr)
+{
+  oled_put_char(x,y,chr);
+  OLED_Refresh_Gram();
+}
 //m^n
 u32 oled_pow(u8 m,u8 n)
 {
@@ -196,13 +321,14 @@ void OLED_ShowNum(u8 x,u8 y,u32 num,u8 len,u8 size)
     {
       if(temp==0)
       {
-        OLED_ShowChar(x+(size/2)*t,y,' ');
+        oled_put_char(x+(size/2)*t,y,' ');
         continue;
       }else enshow=1; 
       
     }
-    OLED_ShowChar(x+(size/2)*t,y,temp+'0'); 
+    oled_put_char(x+(size/2)*t,y,temp+'0'); 
   }
+  OLED_Refresh_Gram();
 } 
 //ʾһַŴ
 void OLED_ShowString(u8 x,u8 y,u8 *chr)
@@ -215,14 +341,14 @@ void OLED_ShowString(u8 x,u8 y,u8 *chr)
     // add for CR/LF
     if( ('\r' == chr[j]) && ('\n' == chr[j+1]) ){  // CR LF
       while(x_t <= 120){  // fill rest chars in current line
-        OLED_ShowChar(x_t,y_t,' ');
+        oled_put_char(x_t,y_t,' ');
         x_t += 8;
       }
       j += 2;
     }
     else if( ('\r' == chr[j]) || ('\n' == chr[j]) ){   // CR or LF
       while(x_t <= 120){  // fill rest chars in current line
-        OLED_ShowChar(x_t,y_t,' ');
+        oled_put_char(x_t,y_t,' ');
         x_t += 8;
       }
       j += 1;
@@ -235,29 +361,24 @@ void OLED_ShowString(u8 x,u8 y,u8 *chr)
           break;
         }
       }
-      OLED_ShowChar(x_t,y_t,chr[j]);
+      oled_put_char(x_t,y_t,chr[j]);
       x_t += 8;
       j++;
     }
   }
+  OLED_Refresh_Gram();
 }
 
 //ʾ
 void OLED_ShowCHinese(u8 x,u8 y,u8 no)
 {      			    
-  u8 t,adder=0;
-  OLED_Set_Pos(x,y);	
+  u8 t;
   for(t=0;t<16;t++)
   {
-    OLED_WR_Byte(Hzk[2*no][t],OLED_DATA);
-    adder+=1;
-  }	
-  OLED_Set_Pos(x,y+1);	
-  for(t=0;t<16;t++)
-  {	
-    OLED_WR_Byte(Hzk[2*no+1][t],OLED_DATA);
-    adder+=1;
+    oled_gram_write(x+t,y,Hzk[2*no][t]);
+    oled_gram_write(x+t,y+1,Hzk[2*no+1][t]);
   }					
+  OLED_Refresh_Gram();
 }
 /***********ʾʾBMPͼƬ12864ʼ(x,y),xķΧ0127yΪҳķΧ07*****************/
 void OLED_DrawBMP(unsigned char x0, unsigned char y0,unsigned char x1, unsigned char y1,unsigned char BMP[])
@@ -269,15 +390,50 @@ void OLED_DrawBMP(unsigned char x0, unsigned char y0,unsigned char x1, unsigned
   else y=y1/8+1;
   for(y=y0;y<y1;y++)
   {
-    OLED_Set_Pos(x0,y);
     for(x=x0;x<x1;x++)
     {      
-      OLED_WR_Byte(BMP[j++],OLED_DATA);	    	
+      oled_gram_write(x,y,BMP[j++]);	    	
     }
   }
+  OLED_Refresh_Gram();
 } 
 
 
+/* Init sequence of the panel, sent as one command transfer */
+static const u8 oled_init_cmds[]=
+{
+  0xAE,  //--turn off oled panel
+  0x00,  //---set low column address
+  0x10,  //---set high column address
+  0x40,  //--set start line address  Set Mapping RAM Display Start Line (0x00~0x3F)
+  0x81,  //--set contrast control register
+  0xCF,  // Set SEG Output Current Brightness
+  0xA1,  //--Set SEG/Column Mapping     0xa0ҷ 0xa1
+  0xC8,  //Set COM/Row Scan Direction   0xc0· 0xc8
+  0xA6,  //--set normal display
+  0xA8,  //--set multiplex ratio(1 to 64)
+  0x3f,  //--1/64 duty
+  0xD3,  //-set display offset	Shift Mapping RAM Counter (0x00~0x3F)
+  0x00,  //-not offset
+  0xd5,  //--set display clock divide ratio/oscillator frequency
+  0x80,  //--set divide ratio, Set Clock as 100 Frames/Sec
+  0xD9,  //--set pre-charge period
+  0xF1,  //Set Pre-Charge as 15 Clocks & Discharge as 1 Clock
+  0xDA,  //--set com pins hardware configuration
+  0x12,
+  0xDB,  //--set vcomh
+  0x40,  //Set VCOM Deselect Level
+  0x20,  //-Set Page Addressing Mode (0x00/0x01/0x02)
+  0x02,
+  0x8D,  //--set Charge Pump enable/disable
+  0x14,  //--set(0x10) disable
+  0xA4,  // Disable Entire Display On (0xa4/0xa5)
+  0xA6,  // Disable Inverse Display On (0xa6/a7)
+  0xAF,  //--turn on oled panel
+
+  0xAF,  //display ON
+};
+
 //ʼSSD1306					    
 void OLED_Init(void)
 { 	 
@@ -306,36 +462,7 @@ void OLED_Init(void)
 
   mico_rtos_unlock_mutex( &platform_spi_drivers[micokit_spi_oled.port].spi_mutex );
   
-  OLED_WR_Byte(0xAE,OLED_CMD);//--turn off oled panel
-  OLED_WR_Byte(0x00,OLED_CMD);//---set low column address
-  OLED_WR_Byte(0x10,OLED_CMD);//---set high column address
-  OLED_WR_Byte(0x40,OLED_CMD);//--set start line address  Set Mapping RAM Display Start Line (0x00~0x3F)
-  OLED_WR_Byte(0x81,OLED_CMD);//--set contrast control register
-  OLED_WR_Byte(0xCF,OLED_CMD); // Set SEG Output Current Brightness
-  OLED_WR_Byte(0xA1,OLED_CMD);//--Set SEG/Column Mapping     0xa0ҷ 0xa1
-  OLED_WR_Byte(0xC8,OLED_CMD);//Set COM/Row Scan Direction   0xc0· 0xc8
-  OLED_WR_Byte(0xA6,OLED_CMD);//--set normal display
-  OLED_WR_Byte(0xA8,OLED_CMD);//--set multiplex ratio(1 to 64)
-  OLED_WR_Byte(0x3f,OLED_CMD);//--1/64 duty
-  OLED_WR_Byte(0xD3,OLED_CMD);//-set display offset	Shift Mapping RAM Counter (0x00~0x3F)
-  OLED_WR_Byte(0x00,OLED_CMD);//-not offset
-  OLED_WR_Byte(0xd5,OLED_CMD);//--set display clock divide ratio/oscillator frequency
-  OLED_WR_Byte(0x80,OLED_CMD);//--set divide ratio, Set Clock as 100 Frames/Sec
-  OLED_WR_Byte(0xD9,OLED_CMD);//--set pre-charge period
-  OLED_WR_Byte(0xF1,OLED_CMD);//Set Pre-Charge as 15 Clocks & Discharge as 1 Clock
-  OLED_WR_Byte(0xDA,OLED_CMD);//--set com pins hardware configuration
-  OLED_WR_Byte(0x12,OLED_CMD);
-  OLED_WR_Byte(0xDB,OLED_CMD);//--set vcomh
-  OLED_WR_Byte(0x40,OLED_CMD);//Set VCOM Deselect Level
-  OLED_WR_Byte(0x20,OLED_CMD);//-Set Page Addressing Mode (0x00/0x01/0x02)
-  OLED_WR_Byte(0x02,OLED_CMD);//
-  OLED_WR_Byte(0x8D,OLED_CMD);//--set Charge Pump enable/disable
-  OLED_WR_Byte(0x14,OLED_CMD);//--set(0x10) disable
-  OLED_WR_Byte(0xA4,OLED_CMD);// Disable Entire Display On (0xa4/0xa5)
-  OLED_WR_Byte(0xA6,OLED_CMD);// Disable Inverse Display On (0xa6/a7) 
-  OLED_WR_Byte(0xAF,OLED_CMD);//--turn on oled panel
-  
-  OLED_WR_Byte(0xAF,OLED_CMD); /*display ON*/ 
+  OLED_WR_Bytes(oled_init_cmds,sizeof(oled_init_cmds),OLED_CMD);
   OLED_Clear();
   OLED_Set_Pos(0,0); 	
 }  
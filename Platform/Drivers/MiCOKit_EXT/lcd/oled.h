@@ -98,9 +98,13 @@
 
 //OLEDú
 void OLED_WR_Byte(u8 dat,u8 cmd);	    
+void OLED_WR_Bytes(const u8 *dat,u16 len,u8 cmd);
 void OLED_Display_On(void);
 void OLED_Display_Off(void);	  
 
+// Drawing goes to a frame buffer, OLED_Refresh_Gram() sends the changed columns.
+// OLED_DrawPoint and OLED_Fill only draw, the Show/Draw/Clear functions also refresh.
+void OLED_Refresh_Gram(void);
 void OLED_DrawPoint(u8 x,u8 y,u8 t);
 void OLED_Fill(u8 x1,u8 y1,u8 x2,u8 y2,u8 dot);
 void OLED_ShowChar(u8 x,u8 y,u8 chr);
@@ -27,95 +27,57 @@
 #define hsb2rgb_led_log(M, ...) custom_log("HSB2RGB_LED", M, ##__VA_ARGS__)
 #define hsb2rgb_led_log_trace() custom_log_trace("HSB2RGB_LED")
 
-#define H2R_MAX_RGB_val 255.0
-
-static float constrain(float value, float min, float max){
-  if(value >= max)
-    return max;
-  if(value <=min )
-    return min;
-  return value;
-}
+#define H2R_HUE_SECTOR    (120 * H2R_HUE_SCALE)
+#define H2R_Q15           (1UL << 15)
+#define H2R_Q16           (1L << 16)
 
-//float Percent(float value){
-//  return value = (((float)value / 255.0) * 100.0);
-//}
-
-static void H2R_HSBtoRGB(float hue, float sat, float bright, float *color) {
-  // constrain all input variables to expected range
-  hue = constrain(hue, 0, 360);
-  sat = constrain(sat, 0, 100);
-  bright = constrain(bright, 0, 100);
-  // define maximum value for RGB array elements
-  float max_rgb_val = H2R_MAX_RGB_val;
-  // convert saturation and brightness value to decimals and init r, g, b variables
-  float sat_f = (float)sat / 100.0;
-  float bright_f = (float)bright / 100.0;
-  float r, g, b;
-  // If brightness is 0 then color is black (achromatic)
-  // therefore, R, G and B values will all equal to 0
-  if (bright <= 0) {
-    color[0] = 0;
-    color[1] = 0;
-    color[2] = 0;
-  }
-  // If saturation is 0 then color is gray (achromatic)
-  // therefore, R, G and B values will all equal the current brightness
-  if (sat <= 0) {
-    color[0] = bright_f * max_rgb_val;
-    color[1] = bright_f * max_rgb_val;
-    color[2] = bright_f * max_rgb_val;
-  }
-  // if saturation and brightness are greater than 0 then calculate
-  // R, G and B values based on the current hue and brightness
-  else {
-    if (hue >= 0 && hue < 120) {
-      float hue_primary = 1.0 - ((float)hue / 120.0);
-      float hue_secondary = (float)hue / 120.0;
-      float sat_primary = (1.0 - hue_primary) * (1.0 - sat_f);
-      float sat_secondary = (1.0 - hue_secondary) * (1.0 - sat_f);
-      float sat_tertiary = 1.0 - sat_f;
-      r = (bright_f * max_rgb_val) * (hue_primary + sat_primary);
-      g = (bright_f * max_rgb_val) * (hue_secondary + sat_secondary);
-      b = (bright_f * max_rgb_val) * sat_tertiary;
-    }
-    else if (hue >= 120 && hue < 240) {
-      float hue_primary = 1.0 - (((float)hue-120.0) / 120.0);
-      float hue_secondary = ((float)hue-120.0) / 120.0;
-      float sat_primary = (1.0 - hue_primary) * (1.0 - sat_f);
-      float sat_secondary = (1.0 - hue_secondary) * (1.0 - sat_f);
-      float sat_tertiary = 1.0 - sat_f;
-      r = (bright_f * max_rgb_val) * sat_tertiary;
-      g = (bright_f * max_rgb_val) * (hue_primary + sat_primary);
-      b = (bright_f * max_rgb_val) * (hue_secondary + sat_secondary);
-    }
-    else if (hue >= 240 && hue <= 360) {
-      float hue_primary = 1.0 - (((float)hue-240.0) / 120.0);
-      float hue_secondary = ((float)hue-240.0) / 120.0;
-      float sat_primary = (1.0 - hue_primary) * (1.0 - sat_f);
-      float sat_secondary = (1.0 - hue_secondary) * (1.0 - sat_f);
-      float sat_tertiary = 1.0 - sat_f;
-      r = (bright_f * max_rgb_val) * (hue_secondary + sat_secondary);
-      g = (bright_f * max_rgb_val) * sat_tertiary;
-      b = (bright_f * max_rgb_val) * (hue_primary + sat_primary);
-    }
-    color[0] = r;
-    color[1] = g;
-    color[2] = b;
+// out = round(255 * (in / 255) ^ 2.2), perceived brightness grows linearly with the input
+static const uint8_t H2R_gamma[256] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+    1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+    3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+    6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+   12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+   20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+   30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+   42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+   56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+   73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+   91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+  113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+  137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+  163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+  192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+  223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+// Integer version of the former float conversion. With V the brightness, S the saturation
+// and h the position of hue in its 120 degree sector (0 ~ 1), the leading channel of the
+// sector is V*(1-h*S), the next one V*(1-(1-h)*S) and the last one V*(1-S).
+static void H2R_HSBtoRGB(const h2r_hsb_t *hsb, uint8_t *color) {
+  uint32_t hue = Min(hsb->hue, H2R_HUE_MAX);
+  uint32_t v = (uint32_t)Min(hsb->bright, H2R_PERCENT_MAX) * (255 << 8) / H2R_PERCENT_MAX;  // Q8
+  uint32_t s = (uint32_t)Min(hsb->sat, H2R_PERCENT_MAX) * H2R_Q15 / H2R_PERCENT_MAX;       // Q15
+  uint32_t sector = hue / H2R_HUE_SECTOR;
+  uint32_t h;
+  
+  if (sector == 3) {    // 360 degrees ends the last sector
+    sector = 2;
   }
-  //  color[0] = Percent(color[0]);
-  //  color[1] = Percent(color[1]);
-  //  color[2] = Percent(color[2]);
+  h = (hue - sector * H2R_HUE_SECTOR) * H2R_Q15 / H2R_HUE_SECTOR;
+  color[sector] = (uint8_t)((v * (H2R_Q15 - ((h * s) >> 15))) >> 23);
+  color[(sector + 1) % 3] = (uint8_t)((v * (H2R_Q15 - (((H2R_Q15 - h) * s) >> 15))) >> 23);
+  color[(sector + 2) % 3] = (uint8_t)((v * (H2R_Q15 - s)) >> 23);
 }
 
 /*----------------------------------------------------- INTERNAL FUNCTION  ---------------------------------------*/
 
 // call RGB LED driver to control LED
-static void OpenLED_RGB(float *color)
+static void OpenLED_RGB(uint8_t *color)
 {
-  uint8_t blue = (uint8_t)(color[2]);
-  uint8_t green = (uint8_t)(color[1]);
-  uint8_t red = (uint8_t)(color[0]);
+  uint8_t blue = color[2];
+  uint8_t green = color[1];
+  uint8_t red = color[0];
   
   //hsb2rgb_led_log("OpenLED_RGB: red=%d, green=%d, blue=%d.", red, green, blue);
   
@@ -137,14 +99,154 @@ void hsb2rgb_led_init(void)
   rgb_led_init();
 }
 
+// only the inputs are scaled in float, negative values stand for 0
 void hsb2rgb_led_open(float hues, float saturation, float brightness)
 {
-  float color[3] = {0};
-  H2R_HSBtoRGB(hues, saturation, brightness, color);
-  OpenLED_RGB(color);
+  h2r_hsb_t hsb;
+  
+  hsb.hue = (hues > 0) ? (uint16_t)(Min(hues, 360) * H2R_HUE_SCALE + 0.5f) : 0;
+  hsb.sat = (saturation > 0) ? (uint16_t)(Min(saturation, 100) * H2R_PERCENT_SCALE + 0.5f) : 0;
+  hsb.bright = (brightness > 0) ? (uint16_t)(Min(brightness, 100) * H2R_PERCENT_SCALE + 0.5f) : 0;
+  hsb2rgb_led_open_fixed(&hsb, false);
 }
 
 void hsb2rgb_led_close(void)
 {
   CloseLED_RGB();
 }
+
+void hsb2rgb_convert(const h2r_hsb_t *hsb, uint8_t *rgb, bool gamma)
+{
+  H2R_HSBtoRGB(hsb, rgb);
+  if (gamma) {
+    rgb[0] = H2R_gamma[rgb[0]];
+    rgb[1] = H2R_gamma[rgb[1]];
+    rgb[2] = H2R_gamma[rgb[2]];
+  }
+}
+
+void hsb2rgb_led_open_fixed(const h2r_hsb_t *hsb, bool gamma)
+{
+  uint8_t color[3];
+  hsb2rgb_convert(hsb, color, gamma);
+  OpenLED_RGB(color);
+}
+
+/*----------------------------------------------------- ANIMATIONS ---------------------------------------*/
+
+static void H2R_anim_leg(h2r_anim_t *anim, const h2r_hsb_t *from, const h2r_hsb_t *to)
+{
+  int32_t d_hue = (int32_t)to->hue - from->hue;
+  
+  // hue turns the short way round the circle
+  if (d_hue > H2R_HUE_MAX / 2) {
+    d_hue -= H2R_HUE_MAX;
+  }
+  else if (d_hue < -H2R_HUE_MAX / 2) {
+    d_hue += H2R_HUE_MAX;
+  }
+  anim->hue = (int32_t)from->hue * H2R_Q16;
+  anim->sat = (int32_t)from->sat * H2R_Q16;
+  anim->bright = (int32_t)from->bright * H2R_Q16;
+  anim->d_hue = d_hue * H2R_Q16 / anim->frames;
+  anim->d_sat = ((int32_t)to->sat - from->sat) * H2R_Q16 / anim->frames;
+  anim->d_bright = ((int32_t)to->bright - from->bright) * H2R_Q16 / anim->frames;
+  anim->frame = 0;
+}
+
+void hsb2rgb_anim_start(h2r_anim_t *anim, const h2r_hsb_t *from, const h2r_hsb_t *to,
+                        uint16_t frames, h2r_anim_mode_t mode)
+{
+  anim->from = *from;
+  anim->to = *to;
+  anim->frames = Max(frames, 1);
+  anim->mode = mode;
+  anim->reverse = 0;
+  H2R_anim_leg(anim, from, to);
+}
+
+// current colour into hsb, then one frame ahead
+bool hsb2rgb_anim_step(h2r_anim_t *anim, h2r_hsb_t *hsb)
+{
+  int32_t hue = (anim->hue + H2R_Q16 / 2) >> 16;
+  const h2r_hsb_t *end;
+  
+  if (hue < 0) {
+    hue += H2R_HUE_MAX;
+  }
+  else if (hue >= H2R_HUE_MAX) {
+    hue -= H2R_HUE_MAX;
+  }
+  hsb->hue = (uint16_t)hue;
+  hsb->sat = (uint16_t)((anim->sat + H2R_Q16 / 2) >> 16);
+  hsb->bright = (uint16_t)((anim->bright + H2R_Q16 / 2) >> 16);
+  
+  if (anim->frame >= anim->frames) {
+    return false;
+  }
+  anim->frame++;
+  if (anim->frame < anim->frames) {
+    anim->hue += anim->d_hue;
+    anim->sat += anim->d_sat;
+    anim->bright += anim->d_bright;
+    return true;
+  }
+  // land on the end point exactly, the deltas are rounded
+  end = anim->reverse ? &anim->from : &anim->to;
+  anim->hue = (int32_t)end->hue * H2R_Q16;
+  anim->sat = (int32_t)end->sat * H2R_Q16;
+  anim->bright = (int32_t)end->bright * H2R_Q16;
+  if (anim->mode == H2R_ANIM_BREATHE) {
+    anim->reverse = !anim->reverse;
+    if (anim->reverse) {
+      H2R_anim_leg(anim, &anim->to, &anim->from);
+    }
+    else {
+      H2R_anim_leg(anim, &anim->from, &anim->to);
+    }
+  }
+  return true;
+}
+
+/*----------------------------------------------------- LED STRIPS ---------------------------------------*/
+
+void hsb2rgb_strip_frame(h2r_strip_t *strip)
+{
+  h2r_hsb_t hsb;
+  uint16_t i;
+  
+  for (i = 0; i < strip->count; i++) {
+    hsb2rgb_anim_step(&strip->anims[i], &hsb);
+    hsb2rgb_convert(&hsb, &strip->rgb[3 * i], strip->gamma);
+  }
+  if (strip->hook != NULL) {
+    strip->hook(strip->hook_arg, strip->frame, strip->rgb, strip->count);
+  }
+  rgb_led_open_chain(strip->rgb, strip->count);
+  strip->frame++;
+}
+
+static void H2R_strip_timer(void *arg)
+{
+  hsb2rgb_strip_frame((h2r_strip_t *)arg);
+}
+
+OSStatus hsb2rgb_strip_start(h2r_strip_t *strip, uint32_t frame_ms)
+{
+  OSStatus err = kNoErr;
+  
+  rgb_led_init();
+  err = mico_init_timer(&strip->timer, frame_ms, H2R_strip_timer, strip);
+  require_noerr(err, exit);
+  err = mico_start_timer(&strip->timer);
+  require_noerr_action(err, exit, mico_deinit_timer(&strip->timer));
+  
+exit:
+  return err;
+}
+
+OSStatus hsb2rgb_strip_stop(h2r_strip_t *strip)
+{
+  mico_stop_timer(&strip->timer);
+  return mico_deinit_timer(&strip->timer);
+}
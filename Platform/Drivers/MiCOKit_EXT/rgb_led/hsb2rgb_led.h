@@ -23,10 +23,67 @@
 #ifndef __HSB2RGB_LED_H_
 #define __HSB2RGB_LED_H_
 
+#include "Common.h"
+#include "MICORTOS.h"
+
+// fixed point units of the integer interfaces
+#define H2R_HUE_SCALE         16                        // hue in 1/16 degree
+#define H2R_PERCENT_SCALE     16                        // saturation and brightness in 1/16 %
+#define H2R_HUE_MAX           (360 * H2R_HUE_SCALE)
+#define H2R_PERCENT_MAX       (100 * H2R_PERCENT_SCALE)
+
+typedef struct {
+  uint16_t hue;         // 0 ~ H2R_HUE_MAX
+  uint16_t sat;         // 0 ~ H2R_PERCENT_MAX
+  uint16_t bright;      // 0 ~ H2R_PERCENT_MAX
+} h2r_hsb_t;
+
+typedef enum {
+  H2R_ANIM_FADE,        // from -> to once, then hold
+  H2R_ANIM_BREATHE,     // from -> to -> from ... forever
+} h2r_anim_mode_t;
+
+// One colour animation, stepped by adding per frame deltas (Q16 of the units above)
+typedef struct {
+  int32_t hue, sat, bright;
+  int32_t d_hue, d_sat, d_bright;
+  h2r_hsb_t from, to;
+  uint16_t frames;      // frames of one fade
+  uint16_t frame;
+  uint8_t mode;
+  uint8_t reverse;      // breathing back towards from
+} h2r_anim_t;
+
+// Frame hook, called with the converted colours before a frame goes out, may change them
+typedef void (*h2r_frame_hook_t)(void *arg, uint32_t frame, uint8_t *rgb, uint16_t count);
+
+// A chain of P9813 LEDs, every frame steps all animations and writes the chain in one burst
+typedef struct {
+  h2r_anim_t *anims;    // one per LED
+  uint8_t *rgb;         // 3 bytes per LED, red first
+  uint16_t count;
+  bool gamma;           // apply the gamma table to the output
+  h2r_frame_hook_t hook;
+  void *hook_arg;
+  uint32_t frame;
+  mico_timer_t timer;
+} h2r_strip_t;
 
 void hsb2rgb_led_init(void);
 void hsb2rgb_led_open(float hues, float saturation, float brightness);
 void hsb2rgb_led_close(void);
 
+// integer colour engine
+void hsb2rgb_convert(const h2r_hsb_t *hsb, uint8_t *rgb, bool gamma);
+void hsb2rgb_led_open_fixed(const h2r_hsb_t *hsb, bool gamma);
+
+void hsb2rgb_anim_start(h2r_anim_t *anim, const h2r_hsb_t *from, const h2r_hsb_t *to,
+                        uint16_t frames, h2r_anim_mode_t mode);
+bool hsb2rgb_anim_step(h2r_anim_t *anim, h2r_hsb_t *hsb);  // false once a fade shows its end colour
+
+void hsb2rgb_strip_frame(h2r_strip_t *strip);
+OSStatus hsb2rgb_strip_start(h2r_strip_t *strip, uint32_t frame_ms);  // hsb2rgb_strip_frame on a timer
+OSStatus hsb2rgb_strip_stop(h2r_strip_t *strip);
+
 
 #endif   // __HSB2RGB_LED_H_
\ No newline at end of file
@@ -66,7 +66,7 @@ static void P9813_PIN_write_data(uint8_t blue, uint8_t green, uint8_t red)
   check_byte |= (((~red) >> 6) & 0x03);   // R7,R6
   
   // create send data 32bit
-  send_data |= (check_byte << 24) | (blue << 16) | (green << 8) | (red);
+  send_data |= ((uint32_t)check_byte << 24) | ((uint32_t)blue << 16) | ((uint32_t)green << 8) | (red);
   
   //send_data = 0xFC0000FF;
   //rgb_led_log("P9813_PIN_write_data: %X", send_data);
@@ -93,3 +93,15 @@ void rgb_led_close(void)
   rgb_led_init();
   rgb_led_open(0, 0, 0);
 }
+
+// P9813 chips pass on the frames after their own, a chain takes all colours in one burst
+void rgb_led_open_chain(const uint8_t *rgb, uint16_t count)
+{
+  uint16_t i;
+  
+  P9813_PIN_write_start_frame();
+  for(i=0; i<count; i++, rgb += 3){
+    P9813_PIN_write_data(rgb[2], rgb[1], rgb[0]);
+  }
+  P9813_PIN_write_start_frame();  // end frame
+}
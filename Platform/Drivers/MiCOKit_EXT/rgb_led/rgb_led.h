@@ -46,6 +46,7 @@
 void rgb_led_init(void);
 void rgb_led_open(uint8_t red, uint8_t green, uint8_t blue);
 void rgb_led_close(void);
+void rgb_led_open_chain(const uint8_t *rgb, uint16_t count);  // rgb: red, green, blue of each LED
 
 
 #endif  // __RGB_LED_H_
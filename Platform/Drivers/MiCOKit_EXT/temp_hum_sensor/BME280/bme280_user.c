@@ -547,64 +547,78 @@ OSStatus bme280_data_readout(s32 *v_actual_temp_s32, u32 *v_actual_press_u32, u3
         return err;
 }
 
+// temperature, humidity and pressure come from one burst read, humidity and pressure
+// compensation need t_fine of the temperature sampled with them.
 OSStatus bme280_read_temperature(s32 *v_actual_temp_s32)
 {
-	s32 com_rslt = BME280_ERROR;  // result of communication results
-	s32 v_data_uncomp_tem_s32 = BME280_INIT_VALUE;  // uncompensated temperature
-     
-        //-------------------------- NOTE ----------------------------------
-        // this is to avoid i2c pin is re-init by other module because they use the same pin.
-        MicoI2cInitialize(&user_i2c_device);
-        //------------------------------------------------------------------
-        
-        com_rslt = bme280_read_uncomp_temperature(&v_data_uncomp_tem_s32);
-         if(0 != com_rslt){
-          return kReadErr;
-        }
-        
-        *v_actual_temp_s32 = bme280_compensate_temperature_int32(v_data_uncomp_tem_s32);
-        
-        return kNoErr;
+  u32 v_actual_press_u32 = BME280_INIT_VALUE;
+  u32 v_actual_humity_u32 = BME280_INIT_VALUE;
+  
+  return bme280_data_readout(v_actual_temp_s32, &v_actual_press_u32, &v_actual_humity_u32);
 }
 
 OSStatus bme280_read_humidity(u32 *v_actual_humity_u32)
 {
-  	s32 com_rslt = BME280_ERROR;  // result of communication results
-	s32 v_data_uncomp_hum_s32 = BME280_INIT_VALUE;  // uncompensated humidity
-     
-        //-------------------------- NOTE ----------------------------------
-        // this is to avoid i2c pin is re-init by other module because they use the same pin.
-        MicoI2cInitialize(&user_i2c_device);
-        //------------------------------------------------------------------
-        
-        com_rslt = bme280_read_uncomp_humidity(&v_data_uncomp_hum_s32);
-         if(0 != com_rslt){
-          return kReadErr;
-        }
-        
-        *v_actual_humity_u32 = bme280_compensate_humidity_int32(v_data_uncomp_hum_s32);
-        
-        return kNoErr;
+  s32 v_actual_temp_s32 = BME280_INIT_VALUE;
+  u32 v_actual_press_u32 = BME280_INIT_VALUE;
+  
+  return bme280_data_readout(&v_actual_temp_s32, &v_actual_press_u32, v_actual_humity_u32);
 }
 
 OSStatus bme280_data_pressure(u32 *v_actual_press_u32)
 {
-    	s32 com_rslt = BME280_ERROR;  // result of communication results
-	s32 v_data_uncomp_pres_s32 = BME280_INIT_VALUE;  // uncompensated humidity
-     
-        //-------------------------- NOTE ----------------------------------
-        // this is to avoid i2c pin is re-init by other module because they use the same pin.
-        MicoI2cInitialize(&user_i2c_device);
-        //------------------------------------------------------------------
-        
-        com_rslt = bme280_read_uncomp_pressure(&v_data_uncomp_pres_s32);
-         if(0 != com_rslt){
-          return kReadErr;
-        }
-        
-        *v_actual_press_u32 = bme280_compensate_pressure_int32(v_data_uncomp_pres_s32);
-        
-        return kNoErr;
+  s32 v_actual_temp_s32 = BME280_INIT_VALUE;
+  u32 v_actual_humity_u32 = BME280_INIT_VALUE;
+  
+  return bme280_data_readout(&v_actual_temp_s32, v_actual_press_u32, &v_actual_humity_u32);
+}
+
+/* Standby times of normal mode in ms, ascending, with their t_sb codes */
+static const struct {
+  u16 ms;
+  u8  t_sb;
+} bme280_standby_times[] = {
+  { 1,    BME280_STANDBY_TIME_1_MS },      // 0.5 ms
+  { 10,   BME280_STANDBY_TIME_10_MS },
+  { 20,   BME280_STANDBY_TIME_20_MS },
+  { 63,   BME280_STANDBY_TIME_63_MS },     // 62.5 ms
+  { 125,  BME280_STANDBY_TIME_125_MS },
+  { 250,  BME280_STANDBY_TIME_250_MS },
+  { 500,  BME280_STANDBY_TIME_500_MS },
+  { 1000, BME280_STANDBY_TIME_1000_MS },
+};
+
+// Measurement time of 4x temperature, 2x pressure and 1x humidity oversampling (max 18.4 ms)
+#define BME280_MEASURE_TIME_MS        (19)
+
+// bme280_sensor_set_period: let normal mode measure at least once per period_ms
+// so that every read of a sampler with that period gets a fresh measurement,
+// while the chip stays in standby as long as possible. The on-chip IIR filter
+// is turned off, samples are filtered by the caller.
+OSStatus bme280_sensor_set_period(uint32_t period_ms)
+{
+  s32 com_rslt = BME280_ERROR;
+  u8 t_sb = BME280_STANDBY_TIME_1_MS;
+  uint32_t i;
+  
+  for(i = 0; i < sizeof(bme280_standby_times)/sizeof(bme280_standby_times[0]); i++){
+    if((uint32_t)bme280_standby_times[i].ms + BME280_MEASURE_TIME_MS > period_ms){
+      break;
+    }
+    t_sb = bme280_standby_times[i].t_sb;
+  }
+  
+  // config register is written in sleep mode, otherwise each setter soft resets the chip
+  MicoI2cInitialize(&user_i2c_device);
+  com_rslt = bme280_set_power_mode(BME280_SLEEP_MODE);
+  com_rslt += bme280_set_standby_durn(t_sb);
+  com_rslt += bme280_set_filter(BME280_FILTER_COEFF_OFF);
+  com_rslt += bme280_set_power_mode(BME280_NORMAL_MODE);
+  if(0 != com_rslt){
+    bme280_user_log("BME280_ERROR: set period %u ms failed!", (unsigned int)period_ms);
+    return kWriteErr;
+  }
+  return kNoErr;
 }
 
 
@@ -40,6 +40,7 @@ OSStatus bme280_data_readout(s32 *v_actual_temp_s32, u32 *v_actual_press_u32, u3
 OSStatus bme280_read_temperature(s32 *v_actual_temp_s32);
 OSStatus bme280_read_humidity(u32 *v_actual_humity_u32);
 OSStatus bme280_data_pressure(u32 *v_actual_press_u32);
+OSStatus bme280_sensor_set_period(uint32_t period_ms);
 OSStatus bme280_sensor_deinit(void);
 
 #endif  // __BME280_USER_H_
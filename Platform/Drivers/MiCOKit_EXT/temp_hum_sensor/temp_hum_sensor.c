@@ -5,7 +5,8 @@
 * @version V1.0.0
 * @date    1-May-2015
 * @brief   user interfaces for temperature && humidity sensor operation,
-*          use DHT11 if bme280 not found.
+*          use DHT11 if bme280 not found. A sampler thread keeps recent
+*          readings filtered and publishes them to subscribers.
 ******************************************************************************
 * @attention
 *
@@ -20,11 +21,51 @@
 ******************************************************************************
 */ 
 
+#include "MICORTOS.h"
 #include "DHT11\DHT11.h"
 #include "BME280\bme280_user.h"
 #include "temp_hum_sensor.h"
 
+#define temp_hum_sensor_log(M, ...) custom_log("TEMP_HUM_SENSOR", M, ##__VA_ARGS__)
+
+#define TEMP_HUM_SAMPLER_STACK_SIZE   (0x500)
+
+typedef struct {
+  temp_hum_subscriber_t callback;
+  void                  *arg;
+}temp_hum_subscription_t;
+
+typedef struct {
+  temp_hum_sampler_config_t config;
+  mico_mutex_t              mutex;          // guards the samples, filters and subscribers
+  mico_mutex_t              bus_mutex;      // one sensor reading at a time, never taken under mutex
+  bool                      mutex_ready;
+  mico_thread_t             thread;
+  volatile bool             running;
+  volatile bool             ready;          // configured, temp_hum_sensor_read serves filtered samples
+  
+  temp_hum_sample_t         ring[TEMP_HUM_SAMPLER_HISTORY_LEN];  // raw samples
+  uint8_t                   head;           // slot of the next sample
+  uint8_t                   count;
+  
+  int32_t                   sum_temperature;  // moving average of the last average_len samples
+  uint32_t                  sum_humidity;
+  uint32_t                  sum_pressure;
+  int32_t                   iir_temperature;  // iir state, 2^iir_shift times the output
+  uint32_t                  iir_humidity;
+  uint32_t                  iir_pressure;
+  
+  temp_hum_sample_t         filtered;
+  bool                      has_filtered;
+  uint32_t                  last_publish_ms;
+  bool                      published;
+  temp_hum_subscription_t   subscribers[TEMP_HUM_SAMPLER_MAX_SUBSCRIBERS];
+}temp_hum_sampler_t;
+
 static volatile temp_hum_sensor_type_t temp_hum_sensor_type = MICOKIT_TEMP_HUM_SENSOR_BME280;
+static temp_hum_sampler_t sampler;
+
+static OSStatus temp_hum_sampler_first(temp_hum_sample_t *filtered);
 
 /*---------------------------------- function --------------------------------*/
 
@@ -53,22 +94,18 @@ OSStatus temp_hum_sensor_init(void)
   return err;
 }
 
-OSStatus temp_hum_sensor_read(int32_t *temperature,  uint32_t *humidity)
+// one reading: a single burst read of all bme280 data registers, compensated once
+static OSStatus temp_hum_sensor_sample(temp_hum_sample_t *sample)
 {
   OSStatus err = kUnknownErr;
   uint8_t ret = 0;
   uint8_t dht11_temp = 0;
   uint8_t dht11_hum = 0;
-  int32_t bme280_temp = 0;
-  uint32_t bme280_hum = 0;
-  uint32_t bme280_press = 0;
   
   switch(temp_hum_sensor_type){
   case MICOKIT_TEMP_HUM_SENSOR_BME280:
     {
-      err = bme280_data_readout(&bme280_temp, &bme280_press, &bme280_hum);
-      *temperature = bme280_temp/100;
-      *humidity = bme280_hum/1024;
+      err = bme280_data_readout(&sample->temperature, &sample->pressure, &sample->humidity);
       break;
     }
   case MICOKIT_TEMP_HUM_SENSOR_DHT11:
@@ -78,8 +115,9 @@ OSStatus temp_hum_sensor_read(int32_t *temperature,  uint32_t *humidity)
         err = kReadErr;
       }
       else{
-        *temperature = (int32_t)dht11_temp;
-        *humidity = (uint32_t)dht11_hum;
+        sample->temperature = (int32_t)dht11_temp*100;
+        sample->humidity = (uint32_t)dht11_hum*1024;
+        sample->pressure = 0;
         err = kNoErr;
       }
       break;
@@ -88,6 +126,349 @@ OSStatus temp_hum_sensor_read(int32_t *temperature,  uint32_t *humidity)
     err = kUnsupportedErr;
     break;
   }
+  sample->time_ms = mico_get_time();
+  
+  return err;
+}
+
+OSStatus temp_hum_sensor_read(int32_t *temperature,  uint32_t *humidity)
+{
+  OSStatus err = kUnknownErr;
+  temp_hum_sample_t sample;
+  
+  if(sampler.ready){  // no bus access next to the sampler thread
+    err = temp_hum_sampler_latest(&sample);
+    if(kNotPreparedErr == err){  // right after start, the first sample is taken here
+      err = temp_hum_sampler_first(&sample);
+    }
+  }
+  else{
+    err = temp_hum_sensor_sample(&sample);
+  }
+  if(kNoErr == err){
+    *temperature = sample.temperature/100;
+    *humidity = sample.humidity/1024;
+  }
+  
+  return err;
+}
+
+/*---------------------------------- sampler ---------------------------------*/
+
+static void temp_hum_sampler_mutex_init(void)
+{
+  if(!sampler.mutex_ready){
+    mico_rtos_init_mutex(&sampler.mutex);
+    mico_rtos_init_mutex(&sampler.bus_mutex);
+    sampler.mutex_ready = true;
+  }
+}
+
+static void temp_hum_sampler_lock(void)
+{
+  temp_hum_sampler_mutex_init();
+  mico_rtos_lock_mutex(&sampler.mutex);
+}
+
+static void temp_hum_sampler_unlock(void)
+{
+  mico_rtos_unlock_mutex(&sampler.mutex);
+}
+
+static void temp_hum_sampler_lock_bus(void)
+{
+  temp_hum_sampler_mutex_init();
+  mico_rtos_lock_mutex(&sampler.bus_mutex);
+}
+
+static void temp_hum_sampler_unlock_bus(void)
+{
+  mico_rtos_unlock_mutex(&sampler.bus_mutex);
+}
+
+// puts raw in the ring and updates the configured filter, called locked
+static void temp_hum_sampler_filter(const temp_hum_sample_t *raw)
+{
+  const temp_hum_sampler_config_t *config = &sampler.config;
+  const temp_hum_sample_t *old = NULL;
+  temp_hum_sample_t *out = &sampler.filtered;
+  int32_t scale = 1 << config->iir_shift;
+  uint8_t n = 0;
+  
+  if(sampler.count >= config->average_len){  // leaves the average window
+    old = &sampler.ring[(sampler.head + TEMP_HUM_SAMPLER_HISTORY_LEN - config->average_len) % TEMP_HUM_SAMPLER_HISTORY_LEN];
+    sampler.sum_temperature -= old->temperature;
+    sampler.sum_humidity -= old->humidity;
+    sampler.sum_pressure -= old->pressure;
+  }
+  sampler.ring[sampler.head] = *raw;
+  sampler.head = (sampler.head + 1) % TEMP_HUM_SAMPLER_HISTORY_LEN;
+  if(sampler.count < TEMP_HUM_SAMPLER_HISTORY_LEN){
+    sampler.count++;
+  }
+  sampler.sum_temperature += raw->temperature;
+  sampler.sum_humidity += raw->humidity;
+  sampler.sum_pressure += raw->pressure;
+  
+  switch(config->filter){
+  case TEMP_HUM_FILTER_AVERAGE:
+    n = Min(sampler.count, config->average_len);
+    out->temperature = sampler.sum_temperature/n;
+    out->humidity = sampler.sum_humidity/n;
+    out->pressure = sampler.sum_pressure/n;
+    break;
+  case TEMP_HUM_FILTER_IIR:
+    if(!sampler.has_filtered){
+      sampler.iir_temperature = raw->temperature*scale;
+      sampler.iir_humidity = raw->humidity << config->iir_shift;
+      sampler.iir_pressure = raw->pressure << config->iir_shift;
+    }
+    else{
+      sampler.iir_temperature += raw->temperature - sampler.iir_temperature/scale;
+      sampler.iir_humidity += raw->humidity - (sampler.iir_humidity >> config->iir_shift);
+      sampler.iir_pressure += raw->pressure - (sampler.iir_pressure >> config->iir_shift);
+    }
+    out->temperature = sampler.iir_temperature/scale;
+    out->humidity = sampler.iir_humidity >> config->iir_shift;
+    out->pressure = sampler.iir_pressure >> config->iir_shift;
+    break;
+  default:
+    *out = *raw;
+    break;
+  }
+  out->time_ms = raw->time_ms;
+  sampler.has_filtered = true;
+}
+
+OSStatus temp_hum_sampler_init(const temp_hum_sampler_config_t *config)
+{
+  OSStatus err = kNoErr;
+  temp_hum_sampler_config_t checked;
+  
+  require_action(config, exit, err = kParamErr);
+  require_action(!sampler.running, exit, err = kStateErr);
+  require_action(config->sample_period_ms > 0, exit, err = kParamErr);
+  require_action(config->filter != TEMP_HUM_FILTER_AVERAGE ||
+                 (config->average_len >= 1 && config->average_len <= TEMP_HUM_SAMPLER_HISTORY_LEN), exit, err = kParamErr);
+  require_action(config->filter != TEMP_HUM_FILTER_IIR ||
+                 (config->iir_shift >= 1 && config->iir_shift <= 8), exit, err = kParamErr);
+  
+  checked = *config;
+  if(checked.filter != TEMP_HUM_FILTER_AVERAGE){
+    checked.average_len = 1;
+  }
+  if(MICOKIT_TEMP_HUM_SENSOR_DHT11 == temp_hum_sensor_type){
+    checked.sample_period_ms = Max(checked.sample_period_ms, TEMP_HUM_SAMPLER_DHT11_MIN_PERIOD);
+  }
+  else{
+    err = bme280_sensor_set_period(checked.sample_period_ms);
+    require_noerr(err, exit);
+  }
+  
+  temp_hum_sampler_lock();
+  sampler.config = checked;
+  sampler.head = 0;
+  sampler.count = 0;
+  sampler.sum_temperature = 0;
+  sampler.sum_humidity = 0;
+  sampler.sum_pressure = 0;
+  sampler.has_filtered = false;
+  sampler.published = false;
+  sampler.ready = true;
+  temp_hum_sampler_unlock();
+  
+exit:
+  return err;
+}
+
+// takes one sample and publishes the filtered value when publish_period_ms has passed
+OSStatus temp_hum_sampler_process(void)
+{
+  OSStatus err = kNoErr;
+  temp_hum_sample_t raw;
+  temp_hum_sample_t filtered;
+  temp_hum_subscription_t subscribers[TEMP_HUM_SAMPLER_MAX_SUBSCRIBERS];
+  bool publish = false;
+  int i = 0;
+  
+  require_action(sampler.ready, exit, err = kNotInitializedErr);
+  
+  // bus access and compensation outside the lock, readers never wait for the sensor
+  temp_hum_sampler_lock_bus();
+  err = temp_hum_sensor_sample(&raw);
+  temp_hum_sampler_unlock_bus();
+  require_noerr_quiet(err, exit);
+  
+  temp_hum_sampler_lock();
+  temp_hum_sampler_filter(&raw);
+  filtered = sampler.filtered;
+  if(!sampler.published || raw.time_ms - sampler.last_publish_ms >= sampler.config.publish_period_ms){
+    publish = true;
+    sampler.published = true;
+    sampler.last_publish_ms = raw.time_ms;
+    memcpy(subscribers, sampler.subscribers, sizeof(subscribers));
+  }
+  temp_hum_sampler_unlock();
+  
+  if(publish){
+    for(i = 0; i < TEMP_HUM_SAMPLER_MAX_SUBSCRIBERS; i++){
+      if(subscribers[i].callback){
+        subscribers[i].callback(&filtered, &raw, subscribers[i].arg);
+      }
+    }
+  }
+  
+exit:
+  return err;
+}
+
+static void temp_hum_sampler_thread(void *arg)
+{
+  OSStatus err = kNoErr;
+  uint32_t next = mico_get_time();
+  int32_t wait = 0;
+  
+  UNUSED_PARAMETER(arg);
+  
+  while(sampler.running){
+    err = temp_hum_sampler_process();
+    if(kNoErr != err){
+      temp_hum_sensor_log("ERROR: sample failed, err = %d.", err);
+    }
+    next += sampler.config.sample_period_ms;
+    wait = (int32_t)(next - mico_get_time());
+    if(wait > 0){
+      mico_thread_msleep((uint32_t)wait);
+    }
+    else{  // fell behind, keep the period instead of catching up
+      next = mico_get_time();
+    }
+  }
+  mico_rtos_delete_thread(NULL);
+}
+
+OSStatus temp_hum_sampler_start(const temp_hum_sampler_config_t *config)
+{
+  OSStatus err = kNoErr;
+  
+  err = temp_hum_sampler_init(config);
+  require_noerr(err, exit);
+  
+  sampler.running = true;
+  err = mico_rtos_create_thread(&sampler.thread, MICO_APPLICATION_PRIORITY, "temp_hum_sampler",
+                                temp_hum_sampler_thread, TEMP_HUM_SAMPLER_STACK_SIZE, NULL);
+  if(kNoErr != err){
+    sampler.running = false;
+    sampler.ready = false;
+  }
+  
+exit:
+  return err;
+}
+
+OSStatus temp_hum_sampler_stop(void)
+{
+  OSStatus err = kNoErr;
+  
+  require_action_quiet(sampler.running, exit, err = kNotInitializedErr);
+  
+  sampler.running = false;
+  mico_rtos_thread_force_awake(&sampler.thread);
+  err = mico_rtos_thread_join(&sampler.thread);
+  sampler.ready = false;
+  
+exit:
+  return err;
+}
+
+OSStatus temp_hum_sampler_subscribe(temp_hum_subscriber_t callback, void *arg)
+{
+  OSStatus err = kNoSpaceErr;
+  int i = 0;
+  
+  require_action(callback, exit, err = kParamErr);
+  
+  temp_hum_sampler_lock();
+  for(i = 0; i < TEMP_HUM_SAMPLER_MAX_SUBSCRIBERS; i++){
+    if(NULL == sampler.subscribers[i].callback){
+      sampler.subscribers[i].callback = callback;
+      sampler.subscribers[i].arg = arg;
+      err = kNoErr;
+      break;
+    }
+  }
+  temp_hum_sampler_unlock();
+  
+exit:
+  return err;
+}
+
+OSStatus temp_hum_sampler_unsubscribe(temp_hum_subscriber_t callback, void *arg)
+{
+  OSStatus err = kNotFoundErr;
+  int i = 0;
+  
+  temp_hum_sampler_lock();
+  for(i = 0; i < TEMP_HUM_SAMPLER_MAX_SUBSCRIBERS; i++){
+    if(callback == sampler.subscribers[i].callback && arg == sampler.subscribers[i].arg){
+      sampler.subscribers[i].callback = NULL;
+      sampler.subscribers[i].arg = NULL;
+      err = kNoErr;
+      break;
+    }
+  }
+  temp_hum_sampler_unlock();
+  
+  return err;
+}
+
+OSStatus temp_hum_sampler_latest(temp_hum_sample_t *filtered)
+{
+  OSStatus err = kNotPreparedErr;
+  
+  temp_hum_sampler_lock();
+  if(sampler.has_filtered){
+    *filtered = sampler.filtered;
+    err = kNoErr;
+  }
+  temp_hum_sampler_unlock();
+  
+  return err;
+}
+
+// a blocking reading for temp_hum_sensor_read before the sampler has one, it becomes the first sample
+static OSStatus temp_hum_sampler_first(temp_hum_sample_t *filtered)
+{
+  OSStatus err = kNoErr;
+  temp_hum_sample_t raw;
+  
+  temp_hum_sampler_lock_bus();
+  err = temp_hum_sampler_latest(filtered);  // the sampler may have got there first
+  if(kNotPreparedErr == err){
+    err = temp_hum_sensor_sample(&raw);
+    if(kNoErr == err){
+      temp_hum_sampler_lock();
+      if(!sampler.has_filtered){
+        temp_hum_sampler_filter(&raw);
+      }
+      *filtered = sampler.filtered;
+      temp_hum_sampler_unlock();
+    }
+  }
+  temp_hum_sampler_unlock_bus();
   
   return err;
 }
+
+int temp_hum_sampler_history(temp_hum_sample_t *samples, int count)
+{
+  int i = 0;
+  
+  temp_hum_sampler_lock();
+  for(i = 0; i < count && i < sampler.count; i++){
+    samples[i] = sampler.ring[(sampler.head + TEMP_HUM_SAMPLER_HISTORY_LEN - 1 - i) % TEMP_HUM_SAMPLER_HISTORY_LEN];
+  }
+  temp_hum_sampler_unlock();
+  
+  return i;
+}
@@ -30,7 +30,50 @@ typedef enum {
   MICOKIT_TEMP_HUM_SENSOR_DHT11
 }temp_hum_sensor_type_t;
 
+#define TEMP_HUM_SAMPLER_HISTORY_LEN        (16)    // raw samples kept, also the longest moving average
+#define TEMP_HUM_SAMPLER_MAX_SUBSCRIBERS    (4)
+#define TEMP_HUM_SAMPLER_DHT11_MIN_PERIOD   (1000)  // ms, DHT11 must not be read faster
+
+// one reading in the units of the BME280 fixed point compensation
+typedef struct {
+  int32_t  temperature;   // 0.01 DegC
+  uint32_t humidity;      // 1/1024 %RH
+  uint32_t pressure;      // Pa, 0 on DHT11
+  uint32_t time_ms;       // mico_get_time() of the reading
+}temp_hum_sample_t;
+
+typedef enum {
+  TEMP_HUM_FILTER_NONE = 0,
+  TEMP_HUM_FILTER_AVERAGE,    // moving average of the last average_len samples
+  TEMP_HUM_FILTER_IIR         // y += (x - y) / 2^iir_shift
+}temp_hum_filter_t;
+
+typedef struct {
+  uint32_t          sample_period_ms;
+  uint32_t          publish_period_ms;  // 0 publishes every sample
+  temp_hum_filter_t filter;
+  uint8_t           average_len;        // 1..TEMP_HUM_SAMPLER_HISTORY_LEN
+  uint8_t           iir_shift;          // 1..8
+}temp_hum_sampler_config_t;
+
+// called from the sampler thread, must not block for long
+typedef void (*temp_hum_subscriber_t)(const temp_hum_sample_t *filtered, const temp_hum_sample_t *raw, void *arg);
+
 OSStatus temp_hum_sensor_init(void);
+// the latest filtered sample in DegC and %RH while the sampler runs, a blocking reading otherwise
+// and before the sampler has its first sample, which that reading then becomes
 OSStatus temp_hum_sensor_read(int32_t *temperature,  uint32_t *humidity);
 
+// sampler, after temp_hum_sensor_init: temp_hum_sampler_start runs temp_hum_sampler_process in its own thread,
+// applications with their own loop call temp_hum_sampler_init and then process once per period.
+OSStatus temp_hum_sampler_init(const temp_hum_sampler_config_t *config);
+OSStatus temp_hum_sampler_process(void);
+OSStatus temp_hum_sampler_start(const temp_hum_sampler_config_t *config);
+OSStatus temp_hum_sampler_stop(void);
+OSStatus temp_hum_sampler_subscribe(temp_hum_subscriber_t callback, void *arg);
+OSStatus temp_hum_sampler_unsubscribe(temp_hum_subscriber_t callback, void *arg);
+OSStatus temp_hum_sampler_latest(temp_hum_sample_t *filtered);
+// copies up to count raw samples, newest first, returns the number copied
+int temp_hum_sampler_history(temp_hum_sample_t *samples, int count);
+
 #endif  // __TEMP_HUM_SENSOR_H_
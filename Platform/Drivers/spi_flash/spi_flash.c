@@ -35,7 +35,9 @@
 #include "spi_flash_platform_interface.h"
 #include <string.h> /* for NULL */
 
-#define sFLASH_SPI_PAGESIZE       0x100
+#define sFLASH_SPI_PAGESIZE       SFLASH_PAGE_SIZE
+
+static int sflash_send_command( const sflash_handle_t* const handle, sflash_command_t cmd, unsigned long num_initial_parameter_bytes, const void* const parameter_bytes, unsigned long num_data_bytes, const void* const data_MOSI, void* const data_MISO );
 
 int sflash_read_ID( const sflash_handle_t* const handle, void* const data_addr )
 {
@@ -120,10 +122,16 @@ int sflash_read_status_register( const sflash_handle_t* const handle, void* cons
 
 int sflash_read( const sflash_handle_t* const handle, unsigned long device_address, void* const data_addr, unsigned int size )
 {
-    char device_address_array[3] =  { ( ( device_address & 0x00FF0000 ) >> 16 ),
+    char device_address_array[4] =  { ( ( device_address & 0x00FF0000 ) >> 16 ),
                                       ( ( device_address & 0x0000FF00 ) >>  8 ),
-                                      ( ( device_address & 0x000000FF ) >>  0 ) };
+                                      ( ( device_address & 0x000000FF ) >>  0 ),
+                                      SFLASH_DUMMY_BYTE };
 
+    /* FAST_READ clocks a dummy byte after the address, READ is limited to a lower SPI clock */
+    if ( handle->options & SFLASH_OPTION_FAST_READ )
+    {
+        return generic_sflash_command( handle, SFLASH_FAST_READ, 4, device_address_array, size, NULL, data_addr );
+    }
     return generic_sflash_command( handle, SFLASH_READ, 3, device_address_array, size, NULL, data_addr );
 }
 
@@ -164,7 +172,7 @@ int sflash_get_size( const sflash_handle_t* const handle, /*@out@*/ unsigned lon
     {
         *size = (unsigned long) 0x100000; /* 1MByte */
     }
-    else if ( handle->device_id == SFLASH_ID_MX25L1606E )
+    else if ( ( handle->device_id == SFLASH_ID_MX25L1606E ) || ( handle->device_id == SFLASH_ID_MX25L1633E ) )
     {
         *size = (unsigned long) 0x200000; /* 2MByte */
     }
@@ -186,10 +194,107 @@ int sflash_get_size( const sflash_handle_t* const handle, /*@out@*/ unsigned lon
     {
         *size = (unsigned long) 0x100000; /* 1MByte */
     }
+    else if ( handle->device_id == SFLASH_ID_W25Q16DV )
+    {
+        *size = (unsigned long) 0x200000; /* 2MByte */
+    }
 #endif /* ifdef SFLASH_SUPPORT_WINBOND_PARTS */
     return 0;
 }
 
+/* Erase suspend is only used on parts whose datasheet defines it. MX25L8006E, MX25L1606E
+ * and W25X80 have no suspend, on them the opcode does nothing and the erase runs to the end */
+static int sflash_erase_suspend_supported( uint32_t device_id )
+{
+#ifdef SFLASH_SUPPORT_MACRONIX_PARTS
+    if ( device_id == SFLASH_ID_MX25L1633E )
+    {
+        return 1;
+    }
+#endif /* ifdef SFLASH_SUPPORT_MACRONIX_PARTS */
+#ifdef SFLASH_SUPPORT_WINBOND_PARTS
+    if ( device_id == SFLASH_ID_W25Q16DV )
+    {
+        return 1;
+    }
+#endif /* ifdef SFLASH_SUPPORT_WINBOND_PARTS */
+    UNUSED_PARAMETER( device_id );
+    return 0;
+}
+
+
+#ifdef SFLASH_SUPPORT_SST_PARTS
+static int sflash_write_byte( const sflash_handle_t* const handle, unsigned long device_address, const unsigned char* data_addr )
+{
+    int status;
+    unsigned char curr_device_address[3] = { ( ( device_address & 0x00FF0000 ) >> 16 ),
+                                             ( ( device_address & 0x0000FF00 ) >>  8 ),
+                                             ( ( device_address & 0x000000FF ) >>  0 ) };
+
+    if ( 0 != ( status = sflash_write_enable( handle ) ) )
+    {
+        return status;
+    }
+    return generic_sflash_command( handle, SFLASH_WRITE, 3, curr_device_address, 1, data_addr, NULL );
+}
+
+/* SST auto address increment: the address is sent once, then two bytes per command */
+static int sflash_write_aai( const sflash_handle_t* const handle, unsigned long device_address, const unsigned char* data_addr, int size )
+{
+    int status;
+    unsigned char curr_device_address[3];
+
+    /* AAI programs word aligned pairs, odd ends go through byte program */
+    if ( ( size > 0 ) && ( device_address & 1 ) )
+    {
+        if ( 0 != ( status = sflash_write_byte( handle, device_address, data_addr ) ) )
+        {
+            return status;
+        }
+        device_address++;
+        data_addr++;
+        size--;
+    }
+
+    if ( size >= 2 )
+    {
+        curr_device_address[0] = ( ( device_address & 0x00FF0000 ) >> 16 );
+        curr_device_address[1] = ( ( device_address & 0x0000FF00 ) >>  8 );
+        curr_device_address[2] = ( ( device_address & 0x000000FF ) >>  0 );
+
+        if ( 0 != ( status = sflash_write_enable( handle ) ) )
+        {
+            return status;
+        }
+        status = generic_sflash_command( handle, SFLASH_AAI_WORD_PROGRAM, 3, curr_device_address, 2, data_addr, NULL );
+        device_address += 2;
+        data_addr += 2;
+        size -= 2;
+        while ( ( status == 0 ) && ( size >= 2 ) )
+        {
+            status = generic_sflash_command( handle, SFLASH_AAI_WORD_PROGRAM, 0, NULL, 2, data_addr, NULL );
+            device_address += 2;
+            data_addr += 2;
+            size -= 2;
+        }
+        /* WRDI ends the AAI sequence, also after a failed word */
+        if ( 0 != generic_sflash_command( handle, SFLASH_WRITE_DISABLE, 0, NULL, 0, NULL, NULL ) && ( status == 0 ) )
+        {
+            status = -1;
+        }
+        if ( status != 0 )
+        {
+            return status;
+        }
+    }
+
+    if ( size > 0 )
+    {
+        return sflash_write_byte( handle, device_address, data_addr );
+    }
+    return 0;
+}
+#endif /* ifdef SFLASH_SUPPORT_SST_PARTS */
 
 int sflash_write_page( const sflash_handle_t* const handle, unsigned long device_address, const void* const data_addr, int size )
 {
@@ -229,6 +334,10 @@ int sflash_write_page( const sflash_handle_t* const handle, unsigned long device
 #ifdef SFLASH_SUPPORT_SST_PARTS
     if ( SFLASH_MANUFACTURER( handle->device_id ) == SFLASH_MANUFACTURER_SST )
     {
+        if ( handle->options & SFLASH_OPTION_AAI_PROGRAM )
+        {
+            return sflash_write_aai( handle, device_address, data_addr_ptr, size );
+        }
         max_write_size = 1;
         enable_before_every_write = 1;
     }
@@ -236,7 +345,7 @@ int sflash_write_page( const sflash_handle_t* const handle, unsigned long device
 #ifdef SFLASH_SUPPORT_EON_PARTS
     if ( SFLASH_MANUFACTURER( handle->device_id ) == SFLASH_MANUFACTURER_EON )
     {
-        max_write_size = (unsigned int) 1;
+        max_write_size = 256;  /* EN25QH parts program a whole page per command */
         enable_before_every_write = 1;
     }
 #endif /* ifdef SFLASH_SUPPORT_EON_PARTS */
@@ -288,80 +397,35 @@ int sflash_write_page( const sflash_handle_t* const handle, unsigned long device
   */
 int sflash_write( const sflash_handle_t* const handle, unsigned long device_address, const void* const data_addr, unsigned int size )
 {
-  int status;
-  uint8_t NumOfPage = 0, NumOfSingle = 0, Addr = 0, count = 0, temp = 0;
-  unsigned char* data_addr_ptr = (unsigned char*) data_addr;
+  int status = 0;
+  unsigned int write_size;
+  const unsigned char* data_addr_ptr = (const unsigned char*) data_addr;
 
-  Addr = device_address % sFLASH_SPI_PAGESIZE;
-  count = sFLASH_SPI_PAGESIZE - Addr;
-  NumOfPage =  size / sFLASH_SPI_PAGESIZE;
-  NumOfSingle = size % sFLASH_SPI_PAGESIZE;
+#ifdef SFLASH_SUPPORT_SST_PARTS
+  /* SST parts have no program pages, one AAI sequence writes everything */
+  if ( ( handle->write_allowed == SFLASH_WRITE_ALLOWED ) && ( handle->options & SFLASH_OPTION_AAI_PROGRAM ) )
+  {
+    return sflash_write_aai( handle, device_address, data_addr_ptr, (int) size );
+  }
+#endif /* ifdef SFLASH_SUPPORT_SST_PARTS */
 
-  if (Addr == 0) /*!< WriteAddr is sFLASH_PAGESIZE aligned  */
+  /* One program command per page, the first one ends at the page boundary */
+  while ( size > 0 )
   {
-    if (NumOfPage == 0) /*!< NumByteToWrite < sFLASH_PAGESIZE */
+    write_size = sFLASH_SPI_PAGESIZE - ( device_address % sFLASH_SPI_PAGESIZE );
+    if ( write_size > size )
     {
-      status = sflash_write_page( handle, device_address, data_addr_ptr, size );
-      //sFLASH_WritePage(pBuffer, WriteAddr, NumByteToWrite);
+      write_size = size;
     }
-    else /*!< NumByteToWrite > sFLASH_PAGESIZE */
-    {
-      while (NumOfPage--)
-      {
-        status = sflash_write_page( handle, device_address, data_addr_ptr, sFLASH_SPI_PAGESIZE );
-        //sFLASH_WritePage(pBuffer, WriteAddr, sFLASH_SPI_PAGESIZE);
-        device_address +=  sFLASH_SPI_PAGESIZE;
-        data_addr_ptr += sFLASH_SPI_PAGESIZE;
-      }
 
-      status = sflash_write_page( handle, device_address, data_addr_ptr, NumOfSingle);
-    }
-  }
-  else /*!< WriteAddr is not sFLASH_PAGESIZE aligned  */
-  {
-    if (NumOfPage == 0) /*!< NumByteToWrite < sFLASH_PAGESIZE */
-    {
-      if (NumOfSingle > count) /*!< (NumByteToWrite + WriteAddr) > sFLASH_PAGESIZE */
-      {
-        temp = NumOfSingle - count;
-
-        status = sflash_write_page( handle, device_address, data_addr_ptr, count );
-        //sFLASH_WritePage(pBuffer, WriteAddr, count);
-        device_address +=  count;
-        data_addr_ptr += count;
-
-        status = sflash_write_page( handle, device_address, data_addr_ptr, temp);
-      }
-      else
-      {
-        status = sflash_write_page(handle, device_address, data_addr_ptr, size);
-      }
-    }
-    else /*!< NumByteToWrite > sFLASH_PAGESIZE */
-    {
-      size -= count;
-      NumOfPage =  size / sFLASH_SPI_PAGESIZE;
-      NumOfSingle = size % sFLASH_SPI_PAGESIZE;
-
-      status = sflash_write_page( handle, device_address, data_addr_ptr, count );
-      //sFLASH_WritePage(pBuffer, WriteAddr, count);
-      device_address +=  count;
-      data_addr_ptr += count;
-
-      while (NumOfPage--)
-      {
-        status = sflash_write_page( handle, device_address, data_addr_ptr, sFLASH_SPI_PAGESIZE );
-        //sFLASH_WritePage(pBuffer, WriteAddr, sFLASH_SPI_PAGESIZE);
-        device_address +=  sFLASH_SPI_PAGESIZE;
-        data_addr_ptr += sFLASH_SPI_PAGESIZE;
-      }
-
-      if (NumOfSingle != 0)
-      {
-        status = sflash_write_page( handle, device_address, data_addr_ptr, NumOfSingle );
-        //sFLASH_WritePage(pBuffer, WriteAddr, NumOfSingle);
-      }
+    status = sflash_write_page( handle, device_address, data_addr_ptr, (int) write_size );
+    if ( status != 0 )
+    {
+      return status;
     }
+    device_address += write_size;
+    data_addr_ptr += write_size;
+    size -= write_size;
   }
   return status;
 }
@@ -397,6 +461,7 @@ int init_sflash( /*@out@*/ sflash_handle_t* const handle, /*@shared@*/ void* per
 
     handle->write_allowed = write_allowed_in;
     handle->device_id     = 0;
+    handle->options       = 0;
 
     status = sflash_read_ID( handle, &tmp_device_id );
     if ( status != 0 )
@@ -408,6 +473,19 @@ int init_sflash( /*@out@*/ sflash_handle_t* const handle, /*@shared@*/ void* per
                         ( ((uint32_t) tmp_device_id.id[1]) <<  8 ) +
                         ( ((uint32_t) tmp_device_id.id[2]) <<  0 );
 
+    /* Every supported part has FAST_READ, AAI depends on the manufacturer, erase suspend on the part */
+    handle->options = SFLASH_OPTION_FAST_READ;
+#ifdef SFLASH_SUPPORT_SST_PARTS
+    if ( SFLASH_MANUFACTURER( handle->device_id ) == SFLASH_MANUFACTURER_SST )
+    {
+        handle->options |= SFLASH_OPTION_AAI_PROGRAM;
+    }
+#endif /* ifdef SFLASH_SUPPORT_SST_PARTS */
+    if ( sflash_erase_suspend_supported( handle->device_id ) == 1 )
+    {
+        handle->options |= SFLASH_OPTION_ERASE_SUSPEND;
+    }
+
 
     if ( write_allowed_in == SFLASH_WRITE_ALLOWED )
     {
@@ -428,11 +506,61 @@ static inline int is_write_command( sflash_command_t cmd )
              ( cmd == SFLASH_CHIP_ERASE2       ) ||
              ( cmd == SFLASH_SECTOR_ERASE      ) ||
              ( cmd == SFLASH_BLOCK_ERASE_MID   ) ||
-             ( cmd == SFLASH_BLOCK_ERASE_LARGE ) )? 1 : 0;
+             ( cmd == SFLASH_BLOCK_ERASE_LARGE ) ||
+             ( cmd == SFLASH_AAI_WORD_PROGRAM  ) )? 1 : 0;
 }
 
+/* First and longest wait between busy polls. The device is ready at most one wait after it is done,
+ * so the longest wait stays around 1% of the typical duration of the operation or the time it costs
+ * shows up in the throughput. Waits of 1ms and more give up the CPU. */
+static void sflash_busy_backoff( sflash_command_t cmd, unsigned long* first_us, unsigned long* max_us )
+{
+    switch ( cmd )
+    {
+        case SFLASH_AAI_WORD_PROGRAM:   /* ~10us */
+            *first_us = 8;
+            *max_us   = 8;
+            break;
+        case SFLASH_WRITE:              /* ~1ms page, ~10us byte */
+            *first_us = 8;
+            *max_us   = 16;
+            break;
+        case SFLASH_SECTOR_ERASE:       /* 25 to 60ms */
+            *first_us = 1000;
+            *max_us   = 1000;
+            break;
+        default:                        /* Block and chip erase, up to seconds */
+            *first_us = 1000;
+            *max_us   = 4000;
+            break;
+    }
+}
 
-int generic_sflash_command(                                      const sflash_handle_t* const handle,
+static int sflash_wait_ready( const sflash_handle_t* const handle, sflash_command_t cmd )
+{
+    int status;
+    unsigned char status_register;
+    unsigned long wait_us, max_us;
+
+    /* The device cannot be done before its typical time, the first poll comes after it */
+    sflash_busy_backoff( cmd, &wait_us, &max_us );
+    while ( 1 )
+    {
+        sflash_platform_wait( wait_us );
+        if ( 0 != ( status = sflash_read_status_register( handle, &status_register ) ) )
+        {
+            return status;
+        }
+        if ( ( status_register & SFLASH_STATUS_REGISTER_BUSY ) == (unsigned char) 0 )
+        {
+            return 0;
+        }
+        wait_us = ( wait_us * 2 > max_us ) ? max_us : wait_us * 2;
+    }
+}
+
+
+static int sflash_send_command(                                   const sflash_handle_t* const handle,
                                                                  sflash_command_t             cmd,
                                                                  unsigned long                num_initial_parameter_bytes,
                             /*@null@*/ /*@observer@*/            const void* const            parameter_bytes,
@@ -440,8 +568,6 @@ int generic_sflash_command(                                      const sflash_ha
                             /*@null@*/ /*@observer@*/            const void* const            data_MOSI,
                             /*@null@*/ /*@out@*/ /*@dependent@*/ void* const                  data_MISO )
 {
-    int status;
-    
     sflash_platform_message_segment_t segments[3] =
     {
             { &cmd,            NULL,       (unsigned long) 1 },
@@ -451,8 +577,22 @@ int generic_sflash_command(                                      const sflash_ha
             /*@+compdef@*/
     };
 
+    /*@-mustdefine@*/ /* Lint: lint does not realise data_MISO was set by sflash_platform_send_recv */
+    return sflash_platform_send_recv( handle->platform_peripheral, segments, (unsigned int) 3  );
+    /*@+mustdefine@*/
+}
 
-    status = sflash_platform_send_recv( handle->platform_peripheral, segments, (unsigned int) 3  );
+int generic_sflash_command(                                      const sflash_handle_t* const handle,
+                                                                 sflash_command_t             cmd,
+                                                                 unsigned long                num_initial_parameter_bytes,
+                            /*@null@*/ /*@observer@*/            const void* const            parameter_bytes,
+                                                                 unsigned long                num_data_bytes,
+                            /*@null@*/ /*@observer@*/            const void* const            data_MOSI,
+                            /*@null@*/ /*@out@*/ /*@dependent@*/ void* const                  data_MISO )
+{
+    int status;
+
+    status = sflash_send_command( handle, cmd, num_initial_parameter_bytes, parameter_bytes, num_data_bytes, data_MOSI, data_MISO );
 
     if ( status != 0 )
     {
@@ -463,24 +603,337 @@ int generic_sflash_command(                                      const sflash_ha
 
     if ( is_write_command( cmd ) == 1 )
     {
-        unsigned char status_register;
         /* write commands require waiting until chip is finished writing */
+        status = sflash_wait_ready( handle, cmd );
+    }
+
+    /*@-mustdefine@*/ /* Lint: lint does not realise data_MISO was set by sflash_platform_send_recv */
+    return status;
+    /*@+mustdefine@*/
+}
 
-        do
+
+/******************************************************
+ *                 Asynchronous queue
+ ******************************************************/
+
+static int sflash_request_overlaps( const sflash_request_t* a, const sflash_request_t* b )
+{
+    return ( a->device_address < b->device_address + b->size ) && ( b->device_address < a->device_address + a->size );
+}
+
+static sflash_request_t* sflash_queue_oldest_write( sflash_queue_t* queue )
+{
+    sflash_request_t* request;
+
+    for ( request = queue->head; request != NULL; request = request->next )
+    {
+        if ( request->type != SFLASH_REQUEST_READ )
         {
-            status = sflash_read_status_register( handle, &status_register );
-            if ( status != 0 )
+            break;
+        }
+    }
+    return request;
+}
+
+static void sflash_queue_complete( sflash_queue_t* queue, sflash_request_t* request, int status )
+{
+    sflash_request_t** link;
+
+    for ( link = &queue->head; *link != request; link = &( *link )->next )
+    {
+    }
+    *link = request->next;
+    request->next = NULL;
+    request->status = status;
+    if ( request->complete != NULL )
+    {
+        request->complete( request, request->arg );
+    }
+}
+
+/* Reads with no earlier program or erase on the same bytes, the device must not be busy */
+static int sflash_queue_serve_reads( sflash_queue_t* queue )
+{
+    sflash_request_t* request = queue->head;
+    sflash_request_t* next;
+    sflash_request_t* write;
+    int status, served = 0;
+
+    while ( request != NULL )
+    {
+        next = request->next;
+        if ( request->type == SFLASH_REQUEST_READ )
+        {
+            for ( write = queue->head; write != request; write = write->next )
             {
-                /*@-mustdefine@*/ /* Lint: do not need to define data_MISO due to failure */
-                return status;
-                /*@+mustdefine@*/
+                if ( ( write->type != SFLASH_REQUEST_READ ) && sflash_request_overlaps( write, request ) )
+                {
+                    break;
+                }
+            }
+            if ( write == request )
+            {
+                status = sflash_read( queue->handle, request->device_address, request->data, request->size );
+                if ( status == 0 )
+                {
+                    request->done = request->size;
+                }
+                queue->stats.reads++;
+                served++;
+                sflash_queue_complete( queue, request, status );
             }
-        } while( ( status_register & SFLASH_STATUS_REGISTER_BUSY ) != (unsigned char) 0 );
+        }
+        request = next;
+    }
+    return served;
+}
 
+static int sflash_queue_can_serve_read( sflash_queue_t* queue )
+{
+    sflash_request_t* request;
+    sflash_request_t* write;
+
+    for ( request = queue->head; request != NULL; request = request->next )
+    {
+        if ( request->type != SFLASH_REQUEST_READ )
+        {
+            continue;
+        }
+        for ( write = queue->head; write != request; write = write->next )
+        {
+            if ( ( write->type != SFLASH_REQUEST_READ ) && sflash_request_overlaps( write, request ) )
+            {
+                break;
+            }
+        }
+        if ( write == request )
+        {
+            return 1;
+        }
     }
+    return 0;
+}
 
-    /*@-mustdefine@*/ /* Lint: lint does not realise data_MISO was set by sflash_platform_send_recv */
+static int sflash_queue_suspend_erase( sflash_queue_t* queue )
+{
+    const sflash_handle_t* handle = queue->handle;
+    sflash_command_t suspend = SFLASH_MX_ERASE_SUSPEND, resume = SFLASH_MX_ERASE_RESUME;
+    unsigned char status_register;
+    int status, served;
+
+    if ( SFLASH_MANUFACTURER( handle->device_id ) == SFLASH_MANUFACTURER_WINBOND )
+    {
+        suspend = SFLASH_WB_ERASE_SUSPEND;
+        resume  = SFLASH_WB_ERASE_RESUME;
+    }
+
+    if ( 0 != ( status = sflash_send_command( handle, suspend, 0, NULL, 0, NULL, NULL ) ) )
+    {
+        return status;
+    }
+    /* Suspend latency is a few tens of microseconds */
+    do
+    {
+        queue->stats.status_polls++;
+        if ( 0 != ( status = sflash_read_status_register( handle, &status_register ) ) )
+        {
+            return status;
+        }
+        if ( status_register & SFLASH_STATUS_REGISTER_BUSY )
+        {
+            sflash_platform_wait( 10 );
+        }
+    } while ( status_register & SFLASH_STATUS_REGISTER_BUSY );
+
+    served = sflash_queue_serve_reads( queue );
+    queue->stats.reads_in_erase += (uint32_t) served;
+    return sflash_send_command( handle, resume, 0, NULL, 0, NULL, NULL );
+}
+
+/* Page program or sector/block erase of the oldest write, returns without waiting for it */
+static int sflash_queue_start_write( sflash_queue_t* queue, sflash_request_t* request )
+{
+    const sflash_handle_t* handle = queue->handle;
+    unsigned long address = request->device_address + request->done;
+    unsigned int size = request->size - request->done;
+    unsigned char device_address_array[3];
+    sflash_command_t cmd;
+    int status;
+
+    if ( handle->write_allowed != SFLASH_WRITE_ALLOWED )
+    {
+        return -1;
+    }
+
+#ifdef SFLASH_SUPPORT_SST_PARTS
+    /* AAI words take microseconds, the chunk is written in place */
+    if ( ( request->type == SFLASH_REQUEST_WRITE ) && ( handle->options & SFLASH_OPTION_AAI_PROGRAM ) )
+    {
+        size = ( size > SFLASH_PAGE_SIZE ) ? SFLASH_PAGE_SIZE : size;
+        if ( 0 != ( status = sflash_write_aai( handle, address, (const unsigned char*) request->data + request->done, (int) size ) ) )
+        {
+            return status;
+        }
+        queue->stats.programs++;
+        request->done += size;
+        return 0;
+    }
+#endif /* ifdef SFLASH_SUPPORT_SST_PARTS */
+
+    if ( request->type == SFLASH_REQUEST_ERASE )
+    {
+        /* Erase requests are sector aligned since submit, 64KB blocks are erased at once */
+        if ( ( ( address % SFLASH_BLOCK_SIZE ) == 0 ) && ( size >= SFLASH_BLOCK_SIZE ) )
+        {
+            cmd = SFLASH_BLOCK_ERASE_LARGE;
+            size = SFLASH_BLOCK_SIZE;
+        }
+        else
+        {
+            cmd = SFLASH_SECTOR_ERASE;
+            size = SFLASH_SECTOR_SIZE;
+        }
+        queue->stats.erases++;
+    }
+    else
+    {
+        cmd = SFLASH_WRITE;
+        if ( size > SFLASH_PAGE_SIZE - ( address % SFLASH_PAGE_SIZE ) )
+        {
+            size = SFLASH_PAGE_SIZE - ( address % SFLASH_PAGE_SIZE );
+        }
+        queue->stats.programs++;
+    }
+
+    device_address_array[0] = ( ( address & 0x00FF0000 ) >> 16 );
+    device_address_array[1] = ( ( address & 0x0000FF00 ) >>  8 );
+    device_address_array[2] = ( ( address & 0x000000FF ) >>  0 );
+
+    if ( 0 != ( status = sflash_write_enable( handle ) ) )
+    {
+        return status;
+    }
+    if ( cmd == SFLASH_WRITE )
+    {
+        status = sflash_send_command( handle, cmd, 3, device_address_array, size, (const unsigned char*) request->data + request->done, NULL );
+    }
+    else
+    {
+        status = sflash_send_command( handle, cmd, 3, device_address_array, 0, NULL, NULL );
+    }
+    if ( status == 0 )
+    {
+        queue->busy_size = size;
+        queue->busy_command = (uint8_t) cmd;
+    }
+    return status;
+}
+
+int sflash_queue_init( sflash_queue_t* queue, const sflash_handle_t* handle )
+{
+    memset( queue, 0, sizeof( *queue ) );
+    queue->handle = handle;
     return 0;
-    /*@+mustdefine@*/
 }
 
+int sflash_queue_submit( sflash_queue_t* queue, sflash_request_t* request )
+{
+    sflash_request_t** link;
+
+    if ( ( request->size == 0 ) || ( ( request->data == NULL ) && ( request->type != SFLASH_REQUEST_ERASE ) ) )
+    {
+        return -1;
+    }
+    if ( request->type == SFLASH_REQUEST_ERASE )
+    {
+        request->size += (unsigned int) ( request->device_address % SFLASH_SECTOR_SIZE );
+        request->size = ( request->size + SFLASH_SECTOR_SIZE - 1 ) & ~( (unsigned int) SFLASH_SECTOR_SIZE - 1 );
+        request->device_address &= ~( (unsigned long) SFLASH_SECTOR_SIZE - 1 );
+    }
+    request->next = NULL;
+    request->done = 0;
+    request->status = SFLASH_REQUEST_PENDING;
+    for ( link = &queue->head; *link != NULL; link = &( *link )->next )
+    {
+    }
+    *link = request;
+    return 0;
+}
+
+/**
+  * @brief  Advances the queue without waiting for the device.
+  * @retval 0 when the queue is empty, 1 while requests are pending. Failures are
+  *         reported in sflash_request_t.status of the affected request.
+  */
+int sflash_queue_process( sflash_queue_t* queue )
+{
+    sflash_request_t* request = sflash_queue_oldest_write( queue );
+    unsigned char status_register;
+    int status;
+
+    if ( queue->busy_size != 0 )
+    {
+        queue->stats.status_polls++;
+        status = sflash_read_status_register( queue->handle, &status_register );
+        if ( ( status == 0 ) && ( status_register & SFLASH_STATUS_REGISTER_BUSY ) )
+        {
+            if ( ( request->type == SFLASH_REQUEST_ERASE ) && ( queue->handle->options & SFLASH_OPTION_ERASE_SUSPEND ) &&
+                 sflash_queue_can_serve_read( queue ) )
+            {
+                status = sflash_queue_suspend_erase( queue );
+            }
+            if ( status == 0 )
+            {
+                return 1;
+            }
+        }
+        request->done += queue->busy_size;
+        queue->busy_size = 0;
+        queue->wait_us = 0;
+        if ( ( status != 0 ) || ( request->done >= request->size ) )
+        {
+            sflash_queue_complete( queue, request, status );
+        }
+    }
+
+    sflash_queue_serve_reads( queue );
+
+    /* Start the next program or erase. AAI chunks are written in place, one per call so that reads get in between */
+    while ( ( queue->busy_size == 0 ) && ( ( request = sflash_queue_oldest_write( queue ) ) != NULL ) )
+    {
+        status = sflash_queue_start_write( queue, request );
+        if ( status != 0 )
+        {
+            sflash_queue_complete( queue, request, status );
+        }
+        else if ( ( queue->busy_size == 0 ) && ( request->done >= request->size ) )
+        {
+            sflash_queue_complete( queue, request, 0 );
+        }
+        else if ( queue->busy_size == 0 )
+        {
+            break;
+        }
+    }
+
+    return ( queue->head != NULL ) ? 1 : 0;
+}
+
+/* Runs the queue until it is empty, backing off between polls of a busy device */
+int sflash_queue_flush( sflash_queue_t* queue )
+{
+    unsigned long first_us, max_us;
+
+    while ( sflash_queue_process( queue ) != 0 )
+    {
+        if ( queue->busy_size == 0 )
+        {
+            continue;
+        }
+        sflash_busy_backoff( (sflash_command_t) queue->busy_command, &first_us, &max_us );
+        queue->wait_us = ( queue->wait_us == 0 ) ? first_us : ( ( queue->wait_us * 2 > max_us ) ? max_us : queue->wait_us * 2 );
+        sflash_platform_wait( queue->wait_us );
+    }
+    return 0;
+}
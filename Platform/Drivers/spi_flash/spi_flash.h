@@ -44,13 +44,68 @@ typedef enum
 
 } sflash_write_allowed_t;
 
+/* sflash_handle_t.options, chosen by init_sflash() from the JEDEC ID */
+#define SFLASH_OPTION_FAST_READ       ( 1 << 0 )  /* FAST_READ with a dummy byte, valid above the READ clock limit */
+#define SFLASH_OPTION_AAI_PROGRAM     ( 1 << 1 )  /* SST auto address increment, two bytes per program command */
+#define SFLASH_OPTION_ERASE_SUSPEND   ( 1 << 2 )  /* A running erase can be suspended to serve reads */
+
+#define SFLASH_REQUEST_PENDING        ( 1 )       /* sflash_request_t.status until the request completes */
+
 typedef struct
 {
     uint32_t device_id;
     void * platform_peripheral;
     sflash_write_allowed_t write_allowed;
+    uint32_t options;
 } sflash_handle_t;
 
+typedef enum
+{
+    SFLASH_REQUEST_READ,
+    SFLASH_REQUEST_WRITE,
+    SFLASH_REQUEST_ERASE,   /* Rounded out to whole 4KB sectors by sflash_queue_submit() */
+} sflash_request_type_t;
+
+/* Request of the asynchronous queue, owned by the queue from submit until complete is called */
+typedef struct sflash_request
+{
+    struct sflash_request* next;
+    sflash_request_type_t  type;
+    unsigned long          device_address;
+    void*                  data;
+    unsigned int           size;
+    unsigned int           done;      /* Bytes read, programmed or erased so far */
+    int                    status;    /* SFLASH_REQUEST_PENDING, then 0 or the error */
+    void                 (*complete)( struct sflash_request* request, void* arg );
+    void*                  arg;
+} sflash_request_t;
+
+typedef struct
+{
+    uint32_t reads;           /* Read requests served */
+    uint32_t reads_in_erase;  /* ...of them while an erase was suspended */
+    uint32_t programs;        /* Page program commands */
+    uint32_t erases;          /* Sector and block erase commands */
+    uint32_t status_polls;
+} sflash_queue_stats_t;
+
+/*
+ * Requests are kept in submission order. Whenever the device is idle, every read that does not
+ * overlap an earlier program or erase is served, then the next page program or sector erase of
+ * the oldest write is started without waiting for it. Reads arriving during an erase are served
+ * by suspending it on parts with SFLASH_OPTION_ERASE_SUSPEND. Not thread safe: submit and process
+ * from the thread that owns the queue.
+ */
+typedef struct
+{
+    const sflash_handle_t* handle;
+    sflash_request_t*      head;
+    unsigned int           busy_size;   /* Bytes of the oldest write the device is working on, 0 when idle */
+    uint8_t                busy_command;
+    unsigned long          wait_us;     /* Next backoff of sflash_queue_flush() */
+    sflash_queue_stats_t   stats;
+} sflash_queue_t;
+
 int init_sflash         ( /*@out@*/ sflash_handle_t* const handle, /*@shared@*/ void* peripheral_id, sflash_write_allowed_t write_allowed_in );
 int sflash_read         ( const sflash_handle_t* const handle, unsigned long device_address, /*@out@*/  /*@dependent@*/ void* const data_addr, unsigned int size );
 int sflash_write        ( const sflash_handle_t* const handle, unsigned long device_address,  /*@observer@*/ const void* const data_addr, unsigned int size );
@@ -58,6 +113,11 @@ int sflash_chip_erase   ( const sflash_handle_t* const handle );
 int sflash_sector_erase ( const sflash_handle_t* const handle, unsigned long device_address );
 int sflash_get_size     ( const sflash_handle_t* const handle, /*@out@*/ unsigned long* size );
 
+int sflash_queue_init   ( sflash_queue_t* queue, const sflash_handle_t* handle );
+int sflash_queue_submit ( sflash_queue_t* queue, sflash_request_t* request );
+int sflash_queue_process( sflash_queue_t* queue );
+int sflash_queue_flush  ( sflash_queue_t* queue );
+
 
 
 #ifdef __cplusplus
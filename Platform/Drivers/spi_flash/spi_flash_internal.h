@@ -76,12 +76,21 @@ typedef enum
     SFLASH_EXIT_SECURED_OTP             = 0xC1, /* EXSO   - Macronix only */
     SFLASH_DEEP_POWER_DOWN              = 0xB9, /* DP     - Macronix only */
     SFLASH_RELEASE_DEEP_POWER_DOWN      = 0xAB, /* RDP    - Macronix only */
+    SFLASH_AAI_WORD_PROGRAM             = 0xAD, /* AAI    - SST only      */
+    SFLASH_MX_ERASE_SUSPEND             = 0xB0, /* PGM/ERS Suspend - Macronix */
+    SFLASH_MX_ERASE_RESUME              = 0x30, /* PGM/ERS Resume  - Macronix */
+    SFLASH_WB_ERASE_SUSPEND             = 0x75, /* Erase Suspend   - Winbond  */
+    SFLASH_WB_ERASE_RESUME              = 0x7A, /* Erase Resume    - Winbond  */
 
 
 } sflash_command_t;
 
 #define SFLASH_DUMMY_BYTE ( 0xA5 )
 
+#define SFLASH_PAGE_SIZE         ( 0x100 )
+#define SFLASH_SECTOR_SIZE       ( 0x1000 )
+#define SFLASH_BLOCK_SIZE        ( 0x10000 )
+
 #define SFLASH_MANUFACTURER( id ) ( ( (id) & 0x00ff0000 ) >> 16 )
 
 #define SFLASH_MANUFACTURER_SST        ( (uint8_t) 0xBF )
@@ -91,9 +100,11 @@ typedef enum
 
 #define SFLASH_ID_MX25L8006E           ( (uint32_t) 0xC22014 )
 #define SFLASH_ID_MX25L1606E           ( (uint32_t) 0xC22015 )
+#define SFLASH_ID_MX25L1633E           ( (uint32_t) 0xC22415 )
 #define SFLASH_ID_SST25VF080B          ( (uint32_t) 0xBF258E )
 #define SFLASH_ID_EN25QH16             ( (uint32_t) 0x1C3015 )
 #define SFLASH_ID_W25X80AVSIG          ( (uint32_t) 0xEF3014 )
+#define SFLASH_ID_W25Q16DV             ( (uint32_t) 0xEF4015 )
 
 
 typedef struct
@@ -62,6 +62,19 @@ extern int sflash_platform_send_recv ( const void* platform_peripheral, /*@in@*/
 
     return 0;
 }
+
+/* Waits of a millisecond or more give the CPU to other threads */
+void sflash_platform_wait( unsigned long microseconds )
+{
+    if ( microseconds >= 1000 )
+    {
+        mico_thread_msleep( microseconds / 1000 );
+    }
+    else
+    {
+        MicoNanosendDelay( (uint64_t) microseconds * 1000 );
+    }
+}
 #else
 int sflash_platform_init( /*@shared@*/ void* peripheral_id, /*@out@*/ void** platform_peripheral_out )
 {
@@ -77,4 +90,9 @@ extern int sflash_platform_send_recv( const void* platform_peripheral, /*@in@*//
     UNUSED_PARAMETER( num_segments );
     return -1;
 }
+
+void sflash_platform_wait( unsigned long microseconds )
+{
+    UNUSED_PARAMETER( microseconds );
+}
 #endif
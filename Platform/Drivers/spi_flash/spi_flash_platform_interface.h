@@ -49,6 +49,7 @@
 
 extern int sflash_platform_init      ( /*@shared@*/ void* peripheral_id, /*@out@*/ void** platform_peripheral_out );
 extern int sflash_platform_send_recv ( const void* platform_peripheral, /*@in@*/ /*@out@*/ sflash_platform_message_segment_t* segments, unsigned int num_segments  );
+extern void sflash_platform_wait     ( unsigned long microseconds );
 
 
 #ifdef __cplusplus
@@ -0,0 +1,406 @@
+/**
+******************************************************************************
+* @file    ac_msg_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Checks and build+parse rate of AC cloud protocol messages, the
+*          staged copy with a bitwise crc against the in place builder and
+*          the one pass option index.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench provides the AC event handlers the receive path dispatches to:
+ *
+ *    gcc -O2 -ffunction-sections -fdata-sections -Wl,--gc-sections
+ *        -IDemos/COM.MXCHIP.SPP/ZC/inc/zc -IDemos/COM.MXCHIP.SPP/ZC/inc/tropicssl
+ *        -IDemos/COM.MXCHIP.SPP/AC/inc
+ *        Platform/MCU/Host/ac_msg_bench.c Demos/COM.MXCHIP.SPP/AC/src/ac_api.c
+ *        Demos/COM.MXCHIP.SPP/ZC/src/crc/crc.c
+ *
+ *  The staged column is what AC_BuildMessage and AC_ParseOption used to do: options
+ *  built in place, payload copied behind them, then a bit by bit crc over both, and an
+ *  option walk on receive. The builder column writes the status into the frame through
+ *  AC_MsgReserve and indexes the options with AC_IndexMessage.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <zc_common.h>
+#include <zc_protocol_interface.h>
+#include <ac_api.h>
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_FRAME_LEN         256
+#define BENCH_MESSAGES          200000
+#define BENCH_ROUNDS            7
+
+/******************************************************
+ *                   Structures
+ ******************************************************/
+
+typedef struct
+{
+  const char *name;
+  u16 payload_len;
+  u8 session;             /* ZC_OPT_SSESSION present */
+  u8 transport;           /* ZC_OPT_TRANSPORT present */
+} bench_msg_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static void bench_fill_status( u8 *status, u16 len, u32 seq );
+static u16 bench_build_staged( const bench_msg_t *msg, u8 *frame, u32 seq );
+static u16 bench_build_builder( const bench_msg_t *msg, u8 *frame, u32 seq );
+static u32 bench_parse_staged( u8 *frame );
+static u32 bench_parse_index( u8 *frame );
+static double bench_seconds( void );
+
+unsigned int crc_cal_by_bit( const unsigned char* ptr, unsigned int len );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+/* Device status reports as the demo devices send them, and a cloud command */
+static const bench_msg_t bench_msgs[] =
+{
+  { "led status",         4, 0, 0 },
+  { "led status, session",4, 1, 0 },
+  { "sensor status",     24, 1, 0 },
+  { "appliance status",  96, 1, 0 },
+  { "cloud command",     32, 0, 1 },
+};
+
+static ZC_TransportInfo bench_transport;
+static ZC_SsessionInfo bench_session;
+static u8 *bench_dealt_payload;
+static u32 bench_dealt;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+void AC_DealNotifyMessage( ZC_MessageHead *pstruMsg, AC_OptList *pstruOptList, u8 *pu8Playload )
+{
+  (void)pstruMsg;
+  (void)pstruOptList;
+  bench_dealt_payload = pu8Playload;
+  bench_dealt++;
+}
+
+void AC_DealEvent( ZC_MessageHead *pstruMsg, AC_OptList *pstruOptList, u8 *pu8Playload )
+{
+  (void)pstruMsg;
+  (void)pstruOptList;
+  bench_dealt_payload = pu8Playload;
+  bench_dealt++;
+}
+
+static void bench_fill_status( u8 *status, u16 len, u32 seq )
+{
+  u16 i;
+
+  for( i = 0; i < len; i++ )
+    status[i] = (u8)( seq + i * 7 );
+}
+
+static u16 bench_build_staged( const bench_msg_t *msg, u8 *frame, u32 seq )
+{
+  ZC_MessageHead *head = (ZC_MessageHead *)frame;
+  ZC_MessageOptHead *opt;
+  u8 status[BENCH_FRAME_LEN];
+  u16 opt_len = 0, crc;
+
+  bench_fill_status( status, msg->payload_len, seq );
+  head->Version = 0;
+  head->MsgId = (u8)seq;
+  head->MsgCode = 64;
+  head->OptNum = 0;
+  opt = (ZC_MessageOptHead *)( frame + sizeof(ZC_MessageHead) );
+  if( msg->transport ){
+    opt->OptCode = ZC_HTONS( ZC_OPT_TRANSPORT );
+    opt->OptLen = ZC_HTONS( sizeof(ZC_TransportInfo) );
+    memcpy( opt + 1, &bench_transport, sizeof(ZC_TransportInfo) );
+    opt_len = sizeof(ZC_MessageOptHead) + sizeof(ZC_TransportInfo);
+    head->OptNum++;
+  }
+  if( msg->session ){
+    opt->OptCode = ZC_HTONS( ZC_OPT_SSESSION );
+    opt->OptLen = ZC_HTONS( sizeof(ZC_SsessionInfo) );
+    memcpy( opt + 1, &bench_session, sizeof(ZC_SsessionInfo) );
+    opt_len = sizeof(ZC_MessageOptHead) + sizeof(ZC_SsessionInfo);
+    head->OptNum++;
+  }
+  memcpy( frame + sizeof(ZC_MessageHead) + opt_len, status, msg->payload_len );
+  head->Payloadlen = ZC_HTONS( msg->payload_len + opt_len );
+  crc = (u16)crc_cal_by_bit( frame + sizeof(ZC_MessageHead), msg->payload_len + opt_len );
+  head->TotalMsgCrc[0] = ( crc & 0xff00 ) >> 8;
+  head->TotalMsgCrc[1] = ( crc & 0xff );
+
+  return (u16)sizeof(ZC_MessageHead) + msg->payload_len + opt_len;
+}
+
+static u16 bench_build_builder( const bench_msg_t *msg, u8 *frame, u32 seq )
+{
+  AC_MsgBuilder builder;
+  u8 *status;
+
+  AC_MsgInit( &builder, 64, (u8)seq, frame, BENCH_FRAME_LEN );
+  if( msg->transport )
+    AC_MsgAddOption( &builder, ZC_OPT_TRANSPORT, (u8 *)&bench_transport, sizeof(ZC_TransportInfo) );
+  if( msg->session )
+    AC_MsgAddOption( &builder, ZC_OPT_SSESSION, (u8 *)&bench_session, sizeof(ZC_SsessionInfo) );
+  status = AC_MsgReserve( &builder, msg->payload_len );
+  if( status == NULL )
+    return 0;
+  bench_fill_status( status, msg->payload_len, seq );
+
+  return AC_MsgEnd( &builder );
+}
+
+/* Sum of the payload, through the option walk AC_ParseOption used to do */
+static u32 bench_parse_staged( u8 *frame )
+{
+  ZC_MessageHead *head = (ZC_MessageHead *)frame;
+  ZC_MessageOptHead *opt = (ZC_MessageOptHead *)( head + 1 );
+  AC_OptList list;
+  u16 opt_len = 0, payload_len, i;
+  u32 sum = 0;
+  u8 *payload;
+  u8 n;
+
+  list.pstruTransportInfo = NULL;
+  list.pstruSsession = NULL;
+  for( n = 0; n < head->OptNum; n++ ){
+    switch( ZC_HTONS( opt->OptCode ) ){
+      case ZC_OPT_TRANSPORT:
+        list.pstruTransportInfo = (ZC_TransportInfo *)( opt + 1 );
+        break;
+      case ZC_OPT_SSESSION:
+        list.pstruSsession = (ZC_SsessionInfo *)( opt + 1 );
+        break;
+    }
+    opt_len += sizeof(ZC_MessageOptHead) + ZC_HTONS( opt->OptLen );
+    opt = (ZC_MessageOptHead *)( (u8 *)opt + sizeof(ZC_MessageOptHead) + ZC_HTONS( opt->OptLen ) );
+  }
+  payload = frame + sizeof(ZC_MessageHead) + opt_len;
+  payload_len = ZC_HTONS( head->Payloadlen ) - opt_len;
+  for( i = 0; i < payload_len; i++ )
+    sum += payload[i];
+
+  return sum + ( list.pstruSsession != NULL ) + ( list.pstruTransportInfo != NULL );
+}
+
+static u32 bench_parse_index( u8 *frame )
+{
+  AC_OptIndex index;
+  u32 sum = 0;
+  u16 i;
+
+  if( AC_IndexMessage( (ZC_MessageHead *)frame, &index ) != ZC_RET_OK )
+    return 0;
+  for( i = 0; i < index.u16PayloadLen; i++ )
+    sum += index.pu8Payload[i];
+
+  return sum + ( index.pu8Opt[ZC_OPT_SSESSION] != NULL ) + ( index.pu8Opt[ZC_OPT_TRANSPORT] != NULL );
+}
+
+static double bench_seconds( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main( void )
+{
+  static const u16 chunks[] = { 1, 3, 8, 13, 64 };
+  u32 staged_frame[BENCH_FRAME_LEN / 4], builder_frame[BENCH_FRAME_LEN / 4];
+  u8 *staged = (u8 *)staged_frame, *built = (u8 *)builder_frame;
+  u8 data[BENCH_FRAME_LEN], status[BENCH_FRAME_LEN];
+  u32 uart_frame[BENCH_FRAME_LEN / 4];
+  u8 *uart = (u8 *)uart_frame;
+  AC_MsgBuilder builder;
+  AC_OptIndex index;
+  AC_OptList list;
+  ZC_MessageHead *head;
+  double t, staged_rate, builder_rate;
+  u16 len, staged_len, crc, off, step;
+  u32 i, k, m, sink = 0;
+  int failed = 0;
+
+  memset( &bench_transport, 0x3C, sizeof(bench_transport) );
+  bench_session.u32SsessionId = ZC_HTONL( 0x12345678 );
+  for( i = 0; i < sizeof(data); i++ )
+    data[i] = (u8)( i * 31 + 5 );
+
+  /* Table crc, whole and in pieces, against the bitwise one */
+  for( len = 0; len <= sizeof(data); len += 17 ){
+    if( crc16_ccitt( data, len ) != (u16)crc_cal_by_bit( data, len ) ){
+      printf( "%u bytes: crc differs\n", (unsigned)len );
+      failed = 1;
+    }
+    for( k = 0; k < sizeof(chunks) / sizeof(chunks[0]); k++ ){
+      crc = 0;
+      for( off = 0; off < len; off += step ){
+        step = ( len - off < chunks[k] ) ? len - off : chunks[k];
+        crc = crc16_ccitt_copy( crc, status + off, data + off, step );
+      }
+      if( crc != (u16)crc_cal_by_bit( data, len ) || memcmp( status, data, len ) != 0 ){
+        printf( "%u bytes in %u byte pieces: crc differs\n", (unsigned)len, (unsigned)chunks[k] );
+        failed = 1;
+      }
+    }
+  }
+
+  /* Both paths give the same bytes, and the index finds what was built */
+  for( m = 0; m < sizeof(bench_msgs) / sizeof(bench_msgs[0]); m++ ){
+    staged_len = bench_build_staged( &bench_msgs[m], staged, m );
+    len = bench_build_builder( &bench_msgs[m], built, m );
+    if( len != staged_len || memcmp( staged, built, len ) != 0 ){
+      printf( "%s: builder frame differs\n", bench_msgs[m].name );
+      failed = 1;
+    }
+    bench_fill_status( status, bench_msgs[m].payload_len, m );
+    list.pstruTransportInfo = bench_msgs[m].transport ? &bench_transport : NULL;
+    list.pstruSsession = bench_msgs[m].session ? &bench_session : NULL;
+    AC_BuildMessage( 64, (u8)m, status, bench_msgs[m].payload_len, &list, built, &len );
+    if( len != staged_len || memcmp( staged, built, len ) != 0 ){
+      printf( "%s: AC_BuildMessage frame differs\n", bench_msgs[m].name );
+      failed = 1;
+    }
+    if( AC_IndexMessage( (ZC_MessageHead *)built, &index ) != ZC_RET_OK ||
+        index.u16PayloadLen != bench_msgs[m].payload_len ||
+        memcmp( index.pu8Payload, status, index.u16PayloadLen ) != 0 ||
+        ( index.pu8Opt[ZC_OPT_SSESSION] != NULL ) != bench_msgs[m].session ||
+        ( index.pu8Opt[ZC_OPT_TRANSPORT] != NULL ) != bench_msgs[m].transport ||
+        bench_parse_index( built ) != bench_parse_staged( built ) ){
+      printf( "%s: index differs\n", bench_msgs[m].name );
+      failed = 1;
+    }
+    bench_dealt = 0;
+    AC_RecvMessage( (ZC_MessageHead *)built );
+    if( bench_dealt != 1 || bench_dealt_payload != index.pu8Payload ){
+      printf( "%s: not dispatched with its payload\n", bench_msgs[m].name );
+      failed = 1;
+    }
+  }
+
+  /* Both options together, which AC_BuildOption used to write over each other */
+  list.pstruTransportInfo = &bench_transport;
+  list.pstruSsession = &bench_session;
+  AC_BuildMessage( 64, 1, data, 10, &list, built, &len );
+  if( AC_IndexMessage( (ZC_MessageHead *)built, &index ) != ZC_RET_OK ||
+      len != sizeof(ZC_MessageHead) + 2 * sizeof(ZC_MessageOptHead) + sizeof(ZC_TransportInfo) + sizeof(ZC_SsessionInfo) + 10 ||
+      index.u16OptLen[ZC_OPT_TRANSPORT] != sizeof(ZC_TransportInfo) ||
+      memcmp( index.pu8Opt[ZC_OPT_TRANSPORT], &bench_transport, sizeof(ZC_TransportInfo) ) != 0 ||
+      memcmp( index.pu8Opt[ZC_OPT_SSESSION], &bench_session, sizeof(ZC_SsessionInfo) ) != 0 ||
+      (u16)( built[6] << 8 | built[7] ) != crc16_ccitt( built + sizeof(ZC_MessageHead), len - sizeof(ZC_MessageHead) ) ){
+    printf( "Transport and session options: message differs\n" );
+    failed = 1;
+  }
+
+  /* An option running past Payloadlen is refused and not dispatched */
+  head = (ZC_MessageHead *)built;
+  head->Payloadlen = ZC_HTONS( sizeof(ZC_MessageOptHead) + sizeof(ZC_TransportInfo) + 2 );
+  bench_dealt = 0;
+  if( AC_IndexMessage( head, &index ) == ZC_RET_OK ){
+    printf( "Truncated option accepted\n" );
+    failed = 1;
+  }
+  AC_RecvMessage( head );
+  if( bench_dealt != 0 ){
+    printf( "Truncated option dispatched\n" );
+    failed = 1;
+  }
+
+  /* Frame overflow and an option after the payload end the message with 0 */
+  AC_MsgInit( &builder, 64, 0, built, sizeof(ZC_MessageHead) + 4 );
+  AC_MsgAppend( &builder, data, 5 );
+  if( AC_MsgEnd( &builder ) != 0 ){
+    printf( "Overflowing frame accepted\n" );
+    failed = 1;
+  }
+  AC_MsgInit( &builder, 64, 0, built, BENCH_FRAME_LEN );
+  AC_MsgAppend( &builder, data, 5 );
+  AC_MsgAddOption( &builder, ZC_OPT_SSESSION, (u8 *)&bench_session, sizeof(ZC_SsessionInfo) );
+  if( AC_MsgEnd( &builder ) != 0 ){
+    printf( "Option after payload accepted\n" );
+    failed = 1;
+  }
+
+  /* Easy uart frame built over the received message carries a good sum */
+  bench_build_builder( &bench_msgs[3], uart, 9 );
+  AC_IndexMessage( (ZC_MessageHead *)uart, &index );
+  list.pstruTransportInfo = NULL;
+  list.pstruSsession = (ZC_SsessionInfo *)index.pu8Opt[ZC_OPT_SSESSION];
+  bench_fill_status( status, bench_msgs[3].payload_len, 9 );
+  AC_BuildEasyMessage( 64, 9, index.pu8Payload, index.u16PayloadLen, &list, uart, &len );
+  if( len != 12 + bench_msgs[3].payload_len || uart[0] != 0x5a || uart[len - 1] != 0x5b ||
+      AC_CheckSum( uart, len ) != ZC_RET_OK || memcmp( uart + 10, status, bench_msgs[3].payload_len ) != 0 ){
+    printf( "Easy uart frame differs\n" );
+    failed = 1;
+  }
+
+  /* Rounds of both alternate, the best of each is reported */
+  for( m = 0; m < sizeof(bench_msgs) / sizeof(bench_msgs[0]); m++ ){
+    staged_rate = builder_rate = 0;
+    for( k = 0; k < BENCH_ROUNDS; k++ ){
+      t = bench_seconds( );
+      for( i = 0; i < BENCH_MESSAGES; i++ ){
+        bench_build_staged( &bench_msgs[m], staged, i );
+        sink += bench_parse_staged( staged );
+      }
+      t = BENCH_MESSAGES / ( bench_seconds( ) - t );
+      staged_rate = ( t > staged_rate ) ? t : staged_rate;
+
+      t = bench_seconds( );
+      for( i = 0; i < BENCH_MESSAGES; i++ ){
+        bench_build_builder( &bench_msgs[m], built, i );
+        sink -= bench_parse_index( built );
+      }
+      t = BENCH_MESSAGES / ( bench_seconds( ) - t );
+      builder_rate = ( t > builder_rate ) ? t : builder_rate;
+    }
+    printf( "%-20s %3u B: build+parse/s staged %9.0f, builder %9.0f (x%.2f)\n", bench_msgs[m].name,
+            (unsigned)bench_msgs[m].payload_len, staged_rate, builder_rate, builder_rate / staged_rate );
+  }
+  if( sink != 0 ){
+    printf( "Parsed payloads differ\n" );
+    failed = 1;
+  }
+
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
@@ -0,0 +1,277 @@
+/**
+******************************************************************************
+* @file    at_cmd_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Dispatch rate of the AT command service over the wifi and system
+*          command tables, and the handling of pipelined lines.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench is log_service.c itself with the command names of atcmd_wifi.c and atcmd_sys.c,
+ *  pipelining enabled as a board would opt in to it:
+ *
+ *    gcc -O2 -D__weak="__attribute__((weak))" -DCONFIG_WLAN=0 -DCONFIG_LOG_PIPELINE=1
+ *        -DUSE_STM324xG_EVAL -IPlatform/MCU/Host/rtl8711
+ *        -Icomponent/common/api -Icomponent/common/api/platform -Icomponent/common/api/at_cmd
+ *        Platform/MCU/Host/at_cmd_bench.c component/common/api/at_cmd/log_service.c
+ *
+ *  Every action records a copy of its parameter, so the checks see which commands of a line
+ *  ran and with what, and that no action was handed a pointer into log_buf.
+ *  The rates are best of BENCH_ROUNDS in process CPU time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mico.h"
+#include "log_service.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_ROUNDS            7
+#define BENCH_LINES             200000
+#define BENCH_MAX_CALLS         8
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  const char *name;
+  const char *lines[4];
+} bench_mix_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+extern void log_service_init( void );
+extern void* log_handler( char *cmd );
+
+static void bench_action( void *param );
+static double bench_cpu_time( void );
+static int bench_expect( const char *line, int handled, int calls, const char *params[] );
+static double bench_rate( const bench_mix_t *mix );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+char log_buf[LOG_SERVICE_BUFLEN];
+mico_semaphore_t log_rx_interrupt_sema;
+mico_semaphore_t uart_rx_interrupt_sema;
+
+/* Names of at_wifi_items[] and at_sys_items[] */
+static log_item_t bench_wifi_items[] =
+{
+  {"ATW0", bench_action,}, {"ATW1", bench_action,}, {"ATW2", bench_action,}, {"ATW3", bench_action,},
+  {"ATW4", bench_action,}, {"ATW5", bench_action,}, {"ATW6", bench_action,}, {"ATWA", bench_action,},
+  {"ATWB", bench_action,}, {"ATWC", bench_action,}, {"ATWD", bench_action,}, {"ATWP", bench_action,},
+  {"ATWR", bench_action,}, {"ATWS", bench_action,}, {"ATWs", bench_action,}, {"ATWM", bench_action,},
+  {"ATWZ", bench_action,}, {"ATWO", bench_action,}, {"ATWE", bench_action,}, {"ATWQ", bench_action,},
+  {"ATWW", bench_action,}, {"ATWw", bench_action,}, {"ATWG", bench_action,}, {"ATWH", bench_action,},
+  {"ATWJ", bench_action,}, {"ATWK", bench_action,}, {"ATWN", bench_action,}, {"ATWF", bench_action,},
+  {"ATWL", bench_action,}, {"ATWI", bench_action,}, {"ATWT", bench_action,}, {"ATWU", bench_action,},
+  {"ATWX", bench_action,}, {"ATW?", bench_action,}, {"ATXP", bench_action,},
+};
+
+static log_item_t bench_sys_items[] =
+{
+  {"ATSD", bench_action,}, {"ATSE", bench_action,}, {"ATSY", bench_action,}, {"ATSA", bench_action,},
+  {"ATSG", bench_action,}, {"ATSM", bench_action,}, {"ATSC", bench_action,}, {"ATSR", bench_action,},
+  {"ATSP", bench_action,}, {"ATS0", bench_action,}, {"ATS1", bench_action,}, {"ATSL", bench_action,},
+  {"ATSS", bench_action,}, {"ATS@", bench_action,}, {"ATS!", bench_action,}, {"ATS#", bench_action,},
+  {"ATS?", bench_action,},
+};
+
+static const bench_mix_t bench_mixes[] =
+{
+  { "single known",      { "ATWC", "ATS?", "ATW0=home-ap", "ATSR" } },
+  { "single unknown",    { "ATZZ", "help", "ATW9=x", "iwpriv" } },
+  { "pipelined x3",      { "ATW0=ssid;ATW1=password;ATWC", "ATS?;ATSR;ATSY", "ATWD;ATWS;ATWC", "ATW0=a;ATW1=b;ATWC" } },
+};
+
+static char bench_params[BENCH_MAX_CALLS][LOG_SERVICE_BUFLEN];
+static int bench_has_param[BENCH_MAX_CALLS];
+static int bench_shared_params;
+static int bench_calls;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+void at_wifi_init( void )
+{
+  log_service_add_table( bench_wifi_items, sizeof(bench_wifi_items) / sizeof(bench_wifi_items[0]) );
+}
+
+void at_sys_init( void )
+{
+  log_service_add_table( bench_sys_items, sizeof(bench_sys_items) / sizeof(bench_sys_items[0]) );
+}
+
+void at_fs_init( void )
+{
+}
+
+OSStatus mico_rtos_init_semaphore( mico_semaphore_t *semaphore, int count )
+{
+  (void)semaphore;
+  (void)count;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_get_semaphore( mico_semaphore_t *semaphore, uint32_t timeout_ms )
+{
+  (void)semaphore;
+  (void)timeout_ms;
+  return kNoErr;
+}
+
+long xTaskCreate( void (*pvTaskCode)( void * ), const char * const pcName, unsigned short usStackDepth,
+                  void *pvParameters, unsigned long uxPriority, void *pxCreatedTask )
+{
+  (void)pvTaskCode; (void)pcName; (void)usStackDepth; (void)pvParameters; (void)uxPriority; (void)pxCreatedTask;
+  return 0;
+}
+
+void vTaskDelete( void *xTaskToDelete )
+{
+  (void)xTaskToDelete;
+}
+
+size_t xPortGetFreeHeapSize( void )
+{
+  return 0;
+}
+
+static void bench_action( void *param )
+{
+  char *p = param;
+
+  /* a parameter inside log_buf would be overwritten by the next console line */
+  if( p >= log_buf && p < log_buf + sizeof(log_buf) )
+    bench_shared_params++;
+  if( bench_calls < BENCH_MAX_CALLS ){
+    bench_has_param[bench_calls] = ( p != NULL );
+    if( p != NULL )
+      strcpy( bench_params[bench_calls], p );
+  }
+  bench_calls++;
+}
+
+static double bench_cpu_time( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Runs line as log_service does; handled is whether it must stay away from the legacy handlers */
+static int bench_expect( const char *line, int handled, int calls, const char *params[] )
+{
+  void *action;
+  int i, ok = 1;
+
+  strcpy( log_buf, line );
+  bench_calls = 0;
+  bench_shared_params = 0;
+  action = log_handler( log_buf );
+  if( ( action != NULL ) != handled || bench_calls != calls || bench_shared_params != 0 )
+    ok = 0;
+  for( i = 0; ok && i < calls; i++ ){
+    if( ( params[i] == NULL ) != !bench_has_param[i] ||
+        ( params[i] != NULL && strcmp( params[i], bench_params[i] ) != 0 ) )
+      ok = 0;
+  }
+  /* a line left to the legacy handlers is the line as typed */
+  if( !handled && strcmp( log_buf, line ) != 0 )
+    ok = 0;
+  if( !ok )
+    printf( "\n'%s': handled %d, %d calls, expected %d, %d calls\n", line, action != NULL, bench_calls, handled, calls );
+  return ok ? 0 : 1;
+}
+
+static double bench_rate( const bench_mix_t *mix )
+{
+  double t, best = 0;
+  int k, i;
+
+  for( k = 0; k < BENCH_ROUNDS; k++ ){
+    t = bench_cpu_time( );
+    for( i = 0; i < BENCH_LINES; i++ ){
+      strcpy( log_buf, mix->lines[i & 3] );
+      log_handler( log_buf );
+    }
+    t = BENCH_LINES / ( bench_cpu_time( ) - t );
+    best = ( t > best ) ? t : best;
+  }
+  return best;
+}
+
+int main( void )
+{
+  static const char *p_none[] = { NULL };
+  static const char *p_ssid[] = { "my;ssid" };
+  static const char *p_join[] = { "ssid", "pass;word", NULL };
+  static const char *p_partial[] = { "ssid", "pass" };
+  unsigned int i;
+  int failed = 0;
+
+  log_service_init( );
+
+  /* every registered name, and names that only share the packed key */
+  for( i = 0; i < sizeof(bench_wifi_items) / sizeof(bench_wifi_items[0]); i++ )
+    failed += bench_expect( bench_wifi_items[i].log_cmd, 1, 1, p_none );
+  for( i = 0; i < sizeof(bench_sys_items) / sizeof(bench_sys_items[0]); i++ )
+    failed += bench_expect( bench_sys_items[i].log_cmd, 1, 1, p_none );
+  failed += bench_expect( "ATW", 0, 0, p_none );
+  failed += bench_expect( "ATWCX", 0, 0, p_none );
+  failed += bench_expect( "help", 0, 0, p_none );
+
+  /* a delimiter not followed by AT is a parameter character */
+  failed += bench_expect( "ATW0=my;ssid", 1, 1, p_ssid );
+  failed += bench_expect( "ATW0=ssid;ATW1=pass;word;ATWC", 1, 3, p_join );
+  /* once a command ran the rest is reported, not handed to the legacy handlers */
+  failed += bench_expect( "ATW0=ssid;ATW1=pass;ATZZ;ATWC", 1, 2, p_partial );
+  failed += bench_expect( "ATZZ;ATW0=ssid", 0, 0, p_none );
+  printf( "\n" );
+
+  printf( "%d commands registered\n", (int)( sizeof(bench_wifi_items) / sizeof(bench_wifi_items[0]) +
+          sizeof(bench_sys_items) / sizeof(bench_sys_items[0]) ) );
+  for( i = 0; i < sizeof(bench_mixes) / sizeof(bench_mixes[0]); i++ )
+    printf( "%-16s %10.0f lines/s\n", bench_mixes[i].name, bench_rate( &bench_mixes[i] ) );
+
+  if( failed )
+    printf( "Benchmark failed, %d lines\n", failed );
+  return failed;
+}
@@ -0,0 +1,265 @@
+/**
+******************************************************************************
+* @file    chacha20poly1305_bench.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Known answer tests and throughput of the ChaCha20-Poly1305 AEAD,
+*          one-shot and streaming, from 64 bytes to 1 MB.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  No platform code is involved, the bench only needs the crypto sources:
+ *
+ *    gcc -O2 -Iinclude -IExternal/ChaCha20Poly1305
+ *        Platform/MCU/Host/chacha20poly1305_bench.c External/ChaCha20Poly1305/chacha20.c
+ *        External/ChaCha20Poly1305/poly1305.c External/ChaCha20Poly1305/aead_chacha20poly1305.c
+ *
+ *  Add -mavx2 for the 8 lane ChaCha20 kernel, -DCHACHA20_SIMD=0 for the scalar one and
+ *  -DPOLY1305_64BIT=0 for the 26-bit Poly1305 limbs the Cortex-M targets use.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chacha20.h"
+#include "poly1305.h"
+#include "MICOCrypto/crypto_aead_chacha20poly1305.h"
+#include "MICOCrypto/crypto_stream_chacha20.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_MAX_LEN       ( 1024 * 1024 )
+#define BENCH_BYTES         ( 64 * 1024 * 1024 )
+#define BENCH_AD_LEN        13
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static int bench_check( const char *name, const unsigned char *out, const char *hex, size_t len );
+static double bench_seconds( void );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const char *bench_sunscreen = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+static const char *bench_sunscreen_sealed =
+  "541976e65b6e7c9806889f0d144a878117c7774c189db0fc1e36e583080f0bfe56084af8be3816823eee6d55da5d148f"
+  "8b813697322f287c2e945e514954f9a152d1b24221e5ebd415b0adbbc93f8a7e9cbfec479830eb3e63a76946b7667cd4"
+  "0ea5f54995a228c325898af44983a0a4cb3ef4ac85821137f1203b01f093f85d4413";
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+static int bench_check( const char *name, const unsigned char *out, const char *hex, size_t len )
+{
+  char buf[3];
+  size_t i;
+
+  for( i = 0; i < len; i++ ){
+    snprintf( buf, sizeof(buf), "%02x", out[i] );
+    if( memcmp( buf, hex + 2 * i, 2 ) != 0 ){
+      printf( "%s: mismatch at byte %u\n", name, (unsigned)i );
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static double bench_seconds( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main( void )
+{
+  static const size_t sizes[] = { 64, 256, 1024, 4096, 16384, 65536, BENCH_MAX_LEN };
+  static const size_t chunks[] = { 1, 3, 16, 63, 64, 65, 500, 4096 };
+  crypto_aead_chacha20poly1305_state state;
+  poly1305_state poly;
+  unsigned char key[32], nonce[8], ad[16], mac[16], block[64];
+  unsigned char *m, *c, *d;
+  unsigned long long clen, mlen;
+  double t, mbps_once, mbps_stream;
+  size_t i, j, len, off, runs, run;
+  int failed = 0;
+
+  m = malloc( BENCH_MAX_LEN );
+  c = malloc( BENCH_MAX_LEN + crypto_aead_chacha20poly1305_ABYTES );
+  d = malloc( BENCH_MAX_LEN );
+  if( m == NULL || c == NULL || d == NULL ){
+    printf( "Out of memory\n" );
+    return 1;
+  }
+  printf( "ChaCha20 %d lane(s), Poly1305 %s limbs\n", CHACHA20_LANES, POLY1305_64BIT ? "44-bit" : "26-bit" );
+
+  /* RFC 8439 2.3.2: block counter 1, the 96-bit nonce is the high counter word plus our nonce */
+  for( i = 0; i < 32; i++ )
+    key[i] = (unsigned char)i;
+  memcpy( nonce, "\x00\x00\x00\x4a\x00\x00\x00\x00", 8 );
+  memset( block, 0, sizeof(block) );
+  crypto_stream_chacha20_xor_ic( block, block, sizeof(block), nonce, 1 | ( (uint64_t)0x09000000 << 32 ), key );
+  failed |= bench_check( "RFC 8439 ChaCha20 block", block,
+                         "10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4e"
+                         "d2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e", 64 );
+
+  /* RFC 8439 2.5.2 */
+  memcpy( key, "\x85\xd6\xbe\x78\x57\x55\x6d\x33\x7f\x44\x52\xfe\x42\xd5\x06\xa8"
+               "\x01\x03\x80\x8a\xfb\x0d\xb2\xfd\x4a\xbf\xf6\xaf\x41\x49\xf5\x1b", 32 );
+  poly1305_init( &poly, key );
+  poly1305_update( &poly, (const unsigned char *)"Cryptographic Forum Research Group", 34 );
+  poly1305_final( &poly, mac );
+  failed |= bench_check( "RFC 8439 Poly1305", mac, "a8061dc1305136c6c22b8baf0c0127a9", 16 );
+
+  /* AEAD known answers with the 64-bit nonce construction */
+  for( i = 0; i < 32; i++ )
+    key[i] = (unsigned char)( 0x80 + i );
+  memcpy( nonce, "\x07\x00\x00\x00\x40\x41\x42\x43", 8 );
+  memcpy( ad, "\x50\x51\x52\x53\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7", 12 );
+  len = strlen( bench_sunscreen );
+  crypto_aead_chacha20poly1305_encrypt( c, &clen, (const unsigned char *)bench_sunscreen, len, ad, 12, NULL, nonce, key );
+  failed |= bench_check( "AEAD sunscreen", c, bench_sunscreen_sealed, len + 16 );
+  if( clen != len + 16 || crypto_aead_chacha20poly1305_decrypt( d, &mlen, NULL, c, clen, ad, 12, nonce, key ) != 0 ||
+      mlen != len || memcmp( d, bench_sunscreen, len ) != 0 ){
+    printf( "AEAD sunscreen: decrypt failed\n" );
+    failed = 1;
+  }
+
+  for( i = 0; i < BENCH_MAX_LEN; i++ )
+    m[i] = (unsigned char)( i * 7 + 3 );
+  for( i = 0; i < BENCH_AD_LEN; i++ )
+    ad[i] = (unsigned char)i;
+  crypto_aead_chacha20poly1305_encrypt( c, &clen, m, 1024, ad, BENCH_AD_LEN, NULL, nonce, key );
+  failed |= bench_check( "AEAD 1 KB head", c, "1b720397213b71cd53aef61a267a9681", 16 );
+  failed |= bench_check( "AEAD 1 KB tail", c + 1008, "1122ee76a13de7ac67d76ba174dad63c", 16 );
+  failed |= bench_check( "AEAD 1 KB tag", c + 1024, "faaadea2225c048b8c932b0db4f92680", 16 );
+
+  /* Streaming in uneven chunks gives the one-shot result, in both directions */
+  len = 3 * 4096 + 77;
+  crypto_aead_chacha20poly1305_encrypt( c, &clen, m, len, ad, BENCH_AD_LEN, NULL, nonce, key );
+  for( i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++ ){
+    crypto_aead_chacha20poly1305_init( &state, nonce, key );
+    crypto_aead_chacha20poly1305_update_ad( &state, ad, 5 );
+    crypto_aead_chacha20poly1305_update_ad( &state, ad + 5, BENCH_AD_LEN - 5 );
+    for( off = 0; off < len; off += j ){
+      j = ( len - off < chunks[i] ) ? len - off : chunks[i];
+      crypto_aead_chacha20poly1305_encrypt_update( &state, d + off, m + off, j );
+    }
+    crypto_aead_chacha20poly1305_encrypt_final( &state, mac );
+    if( memcmp( d, c, len ) != 0 || memcmp( mac, c + len, 16 ) != 0 ){
+      printf( "Streaming encryption in %u byte chunks differs\n", (unsigned)chunks[i] );
+      failed = 1;
+    }
+
+    crypto_aead_chacha20poly1305_init( &state, nonce, key );
+    crypto_aead_chacha20poly1305_update_ad( &state, ad, BENCH_AD_LEN );
+    for( off = 0; off < len; off += j ){
+      j = ( len - off < chunks[i] ) ? len - off : chunks[i];
+      crypto_aead_chacha20poly1305_decrypt_update( &state, d + off, d + off, j );
+    }
+    if( crypto_aead_chacha20poly1305_decrypt_final( &state, c + len ) != 0 || memcmp( d, m, len ) != 0 ){
+      printf( "Streaming decryption in %u byte chunks failed\n", (unsigned)chunks[i] );
+      failed = 1;
+    }
+  }
+
+  /* A changed bit anywhere fails, and one-shot decryption leaves m alone */
+  for( i = 0; i < len + 16; i += 997 ){
+    c[i] ^= 0x10;
+    memset( d, 0xA5, len );
+    if( crypto_aead_chacha20poly1305_decrypt( d, &mlen, NULL, c, len + 16, ad, BENCH_AD_LEN, nonce, key ) != -1 ||
+        mlen != 0 || d[0] != 0xA5 || d[len - 1] != 0xA5 ){
+      printf( "Forgery at byte %u accepted\n", (unsigned)i );
+      failed = 1;
+    }
+    c[i] ^= 0x10;
+  }
+  crypto_aead_chacha20poly1305_init( &state, nonce, key );
+  crypto_aead_chacha20poly1305_decrypt_update( &state, d, c, len );
+  mac[0] = c[len] ^ 1;
+  memcpy( mac + 1, c + len + 1, 15 );
+  if( crypto_aead_chacha20poly1305_decrypt_final( &state, mac ) != -1 ){
+    printf( "Streaming forgery accepted\n" );
+    failed = 1;
+  }
+  crypto_aead_chacha20poly1305_init( &state, nonce, key );
+  crypto_aead_chacha20poly1305_encrypt_update( &state, d, m, 1 );
+  if( crypto_aead_chacha20poly1305_update_ad( &state, ad, 1 ) != -1 ){
+    printf( "Associated data accepted after the message\n" );
+    failed = 1;
+  }
+  crypto_aead_chacha20poly1305_encrypt_final( &state, mac );
+  if( crypto_aead_chacha20poly1305_encrypt_update( &state, d, m, 1 ) != -1 ){
+    printf( "Message accepted after the final\n" );
+    failed = 1;
+  }
+
+  /* Throughput, streaming in 1500 byte packets for the second column */
+  printf( "%8s %12s %12s\n", "bytes", "MB/s", "stream MB/s" );
+  for( i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++ ){
+    len = sizes[i];
+    runs = BENCH_BYTES / len;
+
+    t = bench_seconds( );
+    for( run = 0; run < runs; run++ )
+      crypto_aead_chacha20poly1305_encrypt( c, &clen, m, len, ad, BENCH_AD_LEN, NULL, nonce, key );
+    mbps_once = (double)len * runs / ( bench_seconds( ) - t ) / 1e6;
+
+    t = bench_seconds( );
+    for( run = 0; run < runs; run++ ){
+      crypto_aead_chacha20poly1305_init( &state, nonce, key );
+      crypto_aead_chacha20poly1305_update_ad( &state, ad, BENCH_AD_LEN );
+      for( off = 0; off < len; off += j ){
+        j = ( len - off < 1500 ) ? len - off : 1500;
+        crypto_aead_chacha20poly1305_encrypt_update( &state, c + off, m + off, j );
+      }
+      crypto_aead_chacha20poly1305_encrypt_final( &state, c + len );
+    }
+    mbps_stream = (double)len * runs / ( bench_seconds( ) - t ) / 1e6;
+
+    if( crypto_aead_chacha20poly1305_decrypt( d, &mlen, NULL, c, len + 16, ad, BENCH_AD_LEN, nonce, key ) != 0 ||
+        memcmp( d, m, len ) != 0 ){
+      printf( "%u bytes: round trip failed\n", (unsigned)len );
+      failed = 1;
+    }
+    printf( "%8u %12.1f %12.1f\n", (unsigned)len, mbps_once, mbps_stream );
+  }
+
+  free( m );
+  free( c );
+  free( d );
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
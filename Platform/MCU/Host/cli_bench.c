@@ -0,0 +1,554 @@
+/**
+******************************************************************************
+* @file    cli_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   CLI command trie: registration churn, init failure, tokenizer and
+*          groups, dispatch and completion with 200 commands.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench builds MICOCli.c itself, the UART build without CONFIG_PLATFORM_8195A that
+ *  has tab completion, with stand-ins for the drivers and the commands of other modules:
+ *
+ *    gcc -O2 -std=c99 -IMICO -Iinclude -Iinclude/MicoDrivers -IPlatform/include
+ *        -IBoard/EMW3081 -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals -ISupport
+ *        -IExternal -IDemos/COM.MXCHIP.SPP Platform/MCU/Host/cli_bench.c
+ *
+ *  Include names follow the Windows tool chains, see flash_sim_bench.c.
+ *
+ *  malloc and free of MICOCli.c are counted, every case must leave no trie node behind.
+ *  MicoCliInit is run with a failing thread creation, then for real. Random register and
+ *  unregister calls on names sharing prefixes check the trie after every 500 calls, names
+ *  are overwritten and freed once unregistered so that a label left pointing into them
+ *  shows, under ASan as well. The timed part compares lookup with the former linear scan
+ *  over the same 200 commands.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "MICO.h"
+
+#define CLI_UART  MICO_UART_1
+#define malloc    bench_malloc
+#define free      bench_free
+
+static void *bench_malloc( size_t size );
+static void bench_free( void *ptr );
+
+void mico_force_ota( void );
+
+#include "MICOCli.c"
+
+#undef malloc
+#undef free
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_COMMANDS          200
+#define BENCH_NAMES             400
+#define BENCH_CHURN             20000
+#define BENCH_OUT_SIZE          ( 64 * 1024 )
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static void bench_command( char *pcWriteBuffer, int xWriteBufferLen, int argc, char **argv );
+static double bench_time( void );
+static int bench_check_trie( struct cli_node *node, int depth, unsigned int *count );
+static int bench_init( void );
+static int bench_duplicates( void );
+static int bench_churn( void );
+static int bench_input( void );
+static int bench_speed( void );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static int bench_live;          /* blocks MICOCli.c allocated and did not free */
+static int bench_thread_err;
+static char bench_out[BENCH_OUT_SIZE];
+static int bench_out_len;
+static unsigned int bench_calls;
+static int bench_argc;
+static char bench_argv[4][32];
+
+static struct cli_command bench_cmds[BENCH_NAMES];
+static char *bench_names[BENCH_NAMES];
+static int bench_registered[BENCH_NAMES];
+static const char *const bench_prefixes[] = { "diag", "dia", "d", "wifi ", "wifi s", "net", "netx", "n", "x", "" };
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+/* Allocations of MICOCli.c */
+
+static void *bench_malloc( size_t size )
+{
+  void *ptr = malloc( size );
+
+  if( ptr )
+    bench_live++;
+  return ptr;
+}
+
+static void bench_free( void *ptr )
+{
+  if( ptr )
+    bench_live--;
+  free( ptr );
+}
+
+/* Drivers and the commands of other modules */
+
+OSStatus MicoUartSend( mico_uart_t uart, const void* data, uint32_t size )
+{
+  (void)uart;
+  if( bench_out_len + size < BENCH_OUT_SIZE ){
+    memcpy( bench_out + bench_out_len, data, size );
+    bench_out_len += size;
+    bench_out[bench_out_len] = 0;
+  }
+  return kNoErr;
+}
+
+OSStatus MicoUartRecv( mico_uart_t uart, void* data, uint32_t size, uint32_t timeout )
+{
+  (void)uart;
+  (void)data;
+  (void)size;
+  (void)timeout;
+  return kTimeoutErr;
+}
+
+OSStatus MicoUartInitialize( mico_uart_t uart, const mico_uart_config_t* config, ring_buffer_t* optional_rx_buffer )
+{
+  (void)uart;
+  (void)config;
+  (void)optional_rx_buffer;
+  return kNoErr;
+}
+
+OSStatus ring_buffer_init( ring_buffer_t* ring_buffer, uint8_t* buffer, uint32_t size )
+{
+  (void)ring_buffer;
+  (void)buffer;
+  (void)size;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_create_thread( mico_thread_t* thread, uint8_t priority, const char* name,
+                                  mico_thread_function_t function, uint32_t stack_size, void* arg )
+{
+  (void)thread;
+  (void)priority;
+  (void)name;
+  (void)function;
+  (void)stack_size;
+  (void)arg;
+  return bench_thread_err;
+}
+
+OSStatus mico_rtos_delete_thread( mico_thread_t* thread )
+{
+  (void)thread;
+  return kNoErr;
+}
+
+#define BENCH_STUB_COMMAND( name )  void name( CLI_ARGS ) { (void)pcWriteBuffer; (void)xWriteBufferLen; (void)argc; (void)argv; }
+
+BENCH_STUB_COMMAND( wifiscan_Command )
+BENCH_STUB_COMMAND( wifistate_Command )
+BENCH_STUB_COMMAND( wifidebug_Command )
+BENCH_STUB_COMMAND( ifconfig_Command )
+BENCH_STUB_COMMAND( arp_Command )
+BENCH_STUB_COMMAND( ping_Command )
+BENCH_STUB_COMMAND( dns_Command )
+BENCH_STUB_COMMAND( socket_show_Command )
+BENCH_STUB_COMMAND( task_Command )
+BENCH_STUB_COMMAND( memory_show_Command )
+BENCH_STUB_COMMAND( memory_dump_Command )
+BENCH_STUB_COMMAND( memory_set_Command )
+BENCH_STUB_COMMAND( memp_dump_Command )
+BENCH_STUB_COMMAND( driver_state_Command )
+
+void MICONotificationShowStats( char *pcWriteBuffer, int xWriteBufferLen, bool reset ) { (void)pcWriteBuffer; (void)xWriteBufferLen; (void)reset; }
+void MICOSystemMonitorShowStats( char *pcWriteBuffer, int xWriteBufferLen, bool reset ) { (void)pcWriteBuffer; (void)xWriteBufferLen; (void)reset; }
+mico_logic_partition_t* MicoFlashGetInfo( mico_partition_t inPartition ) { (void)inPartition; return NULL; }
+void MicoMcuPowerSaveConfig( int enable ) { (void)enable; }
+void MicoSysLed( bool onoff ) { (void)onoff; }
+void MicoSystemReboot( void ) { }
+char *mico_get_bootloader_ver( void ) { return "bench"; }
+void platform_mcu_enter_standby( uint32_t secondsToWakeup ) { (void)secondsToWakeup; }
+int tsend( tftp_file_info_t *fileinfo, uint32_t ipaddr ) { (void)fileinfo; (void)ipaddr; return 0; }
+int tget( tftp_file_info_t *fileinfo, uint32_t ipaddr ) { (void)fileinfo; (void)ipaddr; return 0; }
+char* MicoGetVer( void ) { return "bench"; }
+int MicoGetRfVer( char* outVersion, uint8_t inLength ) { (void)outVersion; (void)inLength; return -1; }
+void micoWlanEnablePowerSave( void ) { }
+void micoWlanDisablePowerSave( void ) { }
+OSStatus micoWlanPowerOff( void ) { return kNoErr; }
+void mico_thread_msleep( uint32_t milliseconds ) { (void)milliseconds; }
+void mico_force_ota( void ) { }
+
+/* Bench */
+
+static void bench_command( char *pcWriteBuffer, int xWriteBufferLen, int argc, char **argv )
+{
+  int i;
+  (void)pcWriteBuffer;
+  (void)xWriteBufferLen;
+
+  bench_calls++;
+  bench_argc = argc;
+  for( i = 0; i < argc && i < 4; i++ ){
+    strncpy( bench_argv[i], argv[i], sizeof(bench_argv[i]) - 1 );
+    bench_argv[i][sizeof(bench_argv[i]) - 1] = 0;
+  }
+}
+
+static double bench_time( void )
+{
+  struct timespec t;
+
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* Children sorted, no empty edge, no node that could be merged, labels inside a name below */
+static int bench_check_trie( struct cli_node *node, int depth, unsigned int *count )
+{
+  struct cli_node *child, *prev = NULL;
+  int errors = 0;
+
+  for( child = node->child; child != NULL; prev = child, child = child->next ){
+    if( child->len == 0 || ( prev && prev->label[0] >= child->label[0] ) )
+      errors++;
+    if( child->command == NULL && ( child->child == NULL || child->child->next == NULL ) )
+      errors++;
+    if( memcmp( cli_trie_any( child )->name + depth, child->label, child->len ) != 0 )
+      errors++;
+    if( child->command ){
+      (*count)++;
+      if( (int)strlen( child->command->name ) != depth + child->len )
+        errors++;
+    }
+    errors += bench_check_trie( child, depth + child->len, count );
+  }
+  return errors;
+}
+
+static int bench_init( void )
+{
+  int errors = 0;
+
+  bench_thread_err = kGeneralErr;
+  if( MicoCliInit( ) != kGeneralErr || pCli != NULL )
+    errors++;
+  /* the UART keeps its ring buffer */
+  bench_free( cli_rx_data );
+  if( bench_live != 0 )
+    errors++;
+  printf( "init, thread fails         %s, %d blocks left\n", errors ? "failed" : "ok", bench_live );
+
+  bench_thread_err = kNoErr;
+  if( MicoCliInit( ) != kNoErr || pCli == NULL || pCli->num_commands != sizeof(built_ins) / sizeof(built_ins[0]) )
+    errors++;
+  printf( "init                       %u built-in commands\n", pCli ? pCli->num_commands : 0 );
+  return errors;
+}
+
+/* A name registered twice keeps its first command, the rest of the table still registers */
+static int bench_duplicates( void )
+{
+  static const struct cli_command table[] = {
+    { "dup1",  "", bench_command },
+    { "help",  "", bench_command },
+    { "dup2",  "", bench_command },
+    { "dup1",  "", bench_command },
+    { "dup3",  "", bench_command },
+  };
+  unsigned int before = pCli->num_commands;
+  int errors = 0;
+
+  if( cli_register_commands( table, 5 ) != 0 || pCli->num_commands != before + 3 )
+    errors++;
+  if( lookup_command( "help", 4 ) != &built_ins[0] || lookup_command( "dup1", 4 ) != &table[0] || lookup_command( "dup3", 4 ) != &table[4] )
+    errors++;
+  if( cli_unregister_command( &table[3] ) == 0 || cli_unregister_commands( table, 1 ) != 0 ||
+      cli_unregister_command( &table[2] ) != 0 || cli_unregister_command( &table[4] ) != 0 )
+    errors++;
+  if( pCli->num_commands != before )
+    errors++;
+  printf( "duplicate names            %s\n", errors ? "failed" : "ok" );
+  return errors;
+}
+
+static int bench_churn( void )
+{
+  const struct cli_command *found;
+  unsigned int count, before = pCli->num_commands;
+  char *old;
+  int errors = 0, i, j, k, r, dup;
+
+  srand( 1 );
+  for( i = 0; i < BENCH_NAMES; i++ ){
+    bench_names[i] = malloc( 24 );
+    snprintf( bench_names[i], 24, "%s%d", bench_prefixes[i % 10], i * 7919 % 1000 );
+    bench_cmds[i].name = bench_names[i];
+    bench_cmds[i].help = "bench";
+    bench_cmds[i].function = bench_command;
+  }
+
+  for( k = 0; k < BENCH_CHURN; k++ ){
+    i = rand( ) % BENCH_NAMES;
+    if( bench_registered[i] ){
+      if( cli_unregister_command( &bench_cmds[i] ) != 0 )
+        errors++;
+      bench_registered[i] = 0;
+      old = bench_names[i];
+      bench_names[i] = malloc( 24 );
+      strcpy( bench_names[i], old );
+      memset( old, '#', strlen( old ) );
+      free( old );
+      bench_cmds[i].name = bench_names[i];
+    }else{
+      for( dup = 0, j = 0; j < BENCH_NAMES; j++ )
+        if( bench_registered[j] && strcmp( bench_names[j], bench_names[i] ) == 0 )
+          dup = 1;
+      r = cli_register_command( &bench_cmds[i] );
+      if( r != 0 )
+        errors++;
+      if( dup == 0 )
+        bench_registered[i] = 1;
+    }
+    if( k % 500 == 0 ){
+      count = 0;
+      errors += bench_check_trie( &pCli->root, 0, &count );
+      if( count != pCli->num_commands )
+        errors++;
+      for( j = 0; j < BENCH_NAMES; j++ ){
+        found = lookup_command( bench_names[j], strlen( bench_names[j] ) );
+        if( bench_registered[j] ? found != &bench_cmds[j] : ( found == &bench_cmds[j] ) )
+          errors++;
+      }
+    }
+  }
+  for( i = 0; i < BENCH_NAMES; i++ ){
+    if( bench_registered[i] && cli_unregister_command( &bench_cmds[i] ) != 0 )
+      errors++;
+    bench_registered[i] = 0;
+  }
+  if( pCli->num_commands != before )
+    errors++;
+  printf( "churn, %d calls         %s\n", BENCH_CHURN, errors ? "failed" : "ok" );
+  return errors;
+}
+
+static int bench_input( void )
+{
+  static const struct cli_command group[] = {
+    { "wifi scan", "", bench_command },
+    { "wifi join", "", bench_command },
+  };
+  struct cli_token t[8];
+  char *next;
+  char line1[] = "  set \"a b\" c\\ d e\\\"f ; ps on;help  ";
+  char bad[] = "x \"open", many[] = "a b c d e";
+  char line2[] = "wifi scan fast;wifi", dot[] = "help.x", unknown[] = "nosuch";
+  char in1[INBUF_SIZE] = "wifi s", in2[INBUF_SIZE] = "wifi";
+  unsigned int bp;
+  int errors = 0;
+
+  /* tokenizer */
+  if( cli_tokenize( line1, t, 8, &next ) != 4 || t[1].len != 3 || memcmp( t[1].start, "a b", 3 ) != 0 ||
+      strcmp( cli_token_str( &t[2] ), "c d" ) != 0 || strcmp( cli_token_str( &t[3] ), "e\"f" ) != 0 )
+    errors++;
+  if( cli_tokenize( next, t, 8, &next ) != 2 || next == NULL || cli_tokenize( next, t, 8, &next ) != 1 || next != NULL )
+    errors++;
+  if( cli_tokenize( bad, t, 8, &next ) != -1 || cli_tokenize( many, t, 4, &next ) != -1 )
+    errors++;
+
+  /* groups, the dot fallback and unknown commands */
+  cli_register_commands( group, 2 );
+  bench_out_len = 0;
+  bench_calls = 0;
+  handle_input( line2 );
+  if( bench_calls != 1 || bench_argc != 2 || strcmp( bench_argv[0], "scan" ) != 0 || strcmp( bench_argv[1], "fast" ) != 0 )
+    errors++;
+  if( strstr( bench_out, "wifi commands" ) == NULL )
+    errors++;
+  bench_out_len = 0;
+  if( handle_input( dot ) != 0 )
+    errors++;
+  bench_out_len = 0;
+  if( handle_input( unknown ) != 1 || strstr( bench_out, "'nosuch' not found" ) == NULL )
+    errors++;
+
+  /* completion */
+  bp = 6;
+  bench_out_len = 0;
+  tab_complete( in1, &bp );
+  if( strcmp( in1, "wifi scan " ) != 0 )
+    errors++;
+  bp = 4;
+  bench_out_len = 0;
+  tab_complete( in2, &bp );
+  if( strstr( bench_out, "wifi scan" ) == NULL || strstr( bench_out, "wifidebug" ) == NULL )
+    errors++;
+  cli_unregister_commands( group, 2 );
+  printf( "tokenizer, groups, tab     %s\n", errors ? "failed" : "ok" );
+  return errors;
+}
+
+/* The former table: a linear strcmp scan */
+static const struct cli_command *bench_linear[BENCH_COMMANDS];
+static int bench_linear_num;
+
+static const struct cli_command *bench_linear_lookup( const char *name )
+{
+  int i;
+
+  for( i = 0; i < bench_linear_num; i++ )
+    if( strcmp( bench_linear[i]->name, name ) == 0 )
+      return bench_linear[i];
+  return NULL;
+}
+
+static int bench_speed( void )
+{
+  const struct cli_command *volatile sink;
+  const struct cli_command *c, *diag = NULL;
+  char buf[INBUF_SIZE], line[INBUF_SIZE];
+  double t0, t1, t2;
+  unsigned int i, n, matches = 0;
+  char *p;
+  int errors = 0;
+
+  bench_linear_num = 0;
+  for( i = 0; i < sizeof(built_ins) / sizeof(built_ins[0]); i++ )
+    bench_linear[bench_linear_num++] = &built_ins[i];
+  for( i = 0; bench_linear_num < BENCH_COMMANDS; i++ ){
+    if( lookup_command( bench_cmds[i].name, strlen( bench_cmds[i].name ) ) != NULL )
+      continue;
+    cli_register_command( &bench_cmds[i] );
+    bench_registered[i] = 1;
+    bench_linear[bench_linear_num++] = &bench_cmds[i];
+    if( diag == NULL && strncmp( bench_cmds[i].name, "diag", 4 ) == 0 )
+      diag = &bench_cmds[i];
+  }
+  snprintf( line, sizeof(line), "%s a b \"c d\";%s x", diag->name, diag->name );
+  printf( "\n%u commands registered\n", pCli->num_commands );
+
+  n = 2000000;
+  t0 = bench_time( );
+  for( i = 0; i < n; i++ )
+    sink = bench_linear_lookup( bench_linear[i % bench_linear_num]->name );
+  t1 = bench_time( );
+  for( i = 0; i < n; i++ ){
+    c = bench_linear[i % bench_linear_num];
+    sink = lookup_command( c->name, strlen( c->name ) );
+    if( sink != c )
+      errors++;
+  }
+  t2 = bench_time( );
+  printf( "lookup                     linear %.0f ns, trie %.0f ns\n", ( t1 - t0 ) / n * 1e9, ( t2 - t1 ) / n * 1e9 );
+
+  n = 500000;
+  bench_calls = 0;
+  t0 = bench_time( );
+  for( i = 0; i < n; i++ ){
+    strcpy( buf, line );
+    bench_out_len = 0;
+    handle_input( buf );
+  }
+  t1 = bench_time( );
+  if( bench_calls != 2 * n )
+    errors++;
+  printf( "dispatch                   %.2f M commands/s\n", 2.0 * n / ( t1 - t0 ) / 1e6 );
+
+  n = 200000;
+  t0 = bench_time( );
+  for( i = 0; i < n; i++ ){
+    unsigned int bp = 2;
+    strcpy( buf, "di" );
+    bench_out_len = 0;
+    tab_complete( buf, &bp );
+  }
+  t1 = bench_time( );
+  for( p = bench_out; ( p = strstr( p, "di" ) ) != NULL; p++ )
+    matches++;
+  printf( "completion \"di\"            %u matches, %.2f us\n", matches, ( t1 - t0 ) / n * 1e6 );
+
+  t0 = bench_time( );
+  for( i = 0; i < n; i++ ){
+    unsigned int bp = strlen( diag->name );
+    strcpy( buf, diag->name );
+    bench_out_len = 0;
+    tab_complete( buf, &bp );
+  }
+  t1 = bench_time( );
+  printf( "completion \"%s\"%*s %.2f us\n", diag->name, (int)( 14 - strlen( diag->name ) ), "", ( t1 - t0 ) / n * 1e6 );
+  return errors;
+}
+
+int main( void )
+{
+  int errors = 0, i;
+
+  errors += bench_init( );
+  errors += bench_duplicates( );
+  errors += bench_churn( );
+  errors += bench_input( );
+  errors += bench_speed( );
+
+  cli_trie_free( pCli->root.child );
+  bench_free( pCli );
+  bench_free( cli_rx_data );
+  pCli = NULL;
+  for( i = 0; i < BENCH_NAMES; i++ )
+    free( bench_names[i] );
+  if( bench_live != 0 ){
+    printf( "%d blocks left\n", bench_live );
+    errors++;
+  }
+
+  if( errors )
+    printf( "Benchmark failed\n" );
+  return errors ? 1 : 0;
+}
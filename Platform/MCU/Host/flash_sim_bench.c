@@ -0,0 +1,339 @@
+/**
+******************************************************************************
+* @file    flash_sim_bench.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Benchmark driver of the host flash simulator: the configuration store
+*          and the bootloader OTA apply over the EMW3081 partition layout.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  Builds on a POSIX host against the simulated flash, MicoFlash* of mico_platform_common.c
+ *  and the OTA apply of Bootloader/Update_for_OTA.c. Unused drivers of mico_platform_common.c
+ *  are dropped by the linker:
+ *
+ *    gcc -O2 -DNO_MICO_RTOS -DBOOTLOADER -ffunction-sections -fdata-sections -Wl,--gc-sections
+ *        -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals -IBoard/EMW3081 -IPlatform/include
+ *        -Iinclude -Iinclude/MicoDrivers -ISupport -IBootloader
+ *        Platform/MCU/Host/flash_sim_bench.c Platform/MCU/Host/platform_init.c
+ *        Platform/MCU/Host/peripherals/platform_flash.c Platform/MCU/mico_platform_common.c
+ *        Bootloader/Update_for_OTA.c Support/CheckSumUtils.c
+ *
+ *  Include names follow the Windows tool chains, a case sensitive file system needs them
+ *  folded (e.g. a directory of links such as Common.h -> include/common.h).
+ *
+ *    flash_sim_bench [image]    run on a RAM image, or on a persistent image file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MICOPlatform.h"
+#include "platform.h"
+#include "platform_config.h"
+#include "platform_peripheral.h"
+#include "CheckSumUtils.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define CONFIG_SAVES            (200)
+#define CONFIG_CONTENT_SIZE     (0xA00)     /* boot table + system and application configuration */
+#define CONFIG_CRC_OFFSET       (0xE00)     /* Same layout as MICOParaStorage.c */
+#define CONFIG_CRC_SIZE         (2)
+#define OTA_IMAGE_SIZE          (400*1024)
+#define OTA_RECV_CHUNK          (1024)      /* OTA receive paths write what one socket read returns */
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+/* Head of MICO_PARTITION_PARAMETER_1, read by update() */
+typedef struct
+{
+  uint32_t start_address;
+  uint32_t length;
+  uint8_t version[8];
+  uint8_t type;
+  uint8_t upgrade_type;
+  uint16_t crc;
+  uint8_t reserved[4];
+} bench_boot_table_t;
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+int mico_debug_enabled = 0;
+
+static char image_path[256];
+
+/* Flash memory devices */
+const platform_flash_t platform_flash_peripherals[] =
+{
+  [MICO_FLASH_SPI] =
+  {
+    .flash_type                   = FLASH_TYPE_SPI,
+    .flash_start_addr             = 0x00000000,
+    .flash_length                 = 0x200000,
+    .flash_readonly_start         = 0x9000,
+    .flash_readonly_len           = 0x2000,
+    .image_path                   = image_path,
+    .profile                      = &platform_flash_profile_spi_nor,
+  },
+};
+
+platform_flash_driver_t platform_flash_drivers[MICO_FLASH_MAX];
+
+/* Logic partition on flash devices, as on EMW3081 */
+const mico_logic_partition_t mico_partitions[] =
+{
+  [MICO_PARTITION_BOOTLOADER] =
+  {
+    .partition_owner           = MICO_FLASH_SPI,
+    .partition_description     = "Bootloader",
+    .partition_start_addr      = 0xB000,
+    .partition_length          = 0x8000,    //32k bytes
+    .partition_options         = PAR_OPT_READ_EN | PAR_OPT_WRITE_DIS,
+  },
+  [MICO_PARTITION_APPLICATION] =
+  {
+    .partition_owner           = MICO_FLASH_SPI,
+    .partition_description     = "Application",
+    .partition_start_addr      = 0x13000,
+    .partition_length          = 0x90000,   //576k bytes
+    .partition_options         = PAR_OPT_READ_EN | PAR_OPT_WRITE_EN,
+  },
+  [MICO_PARTITION_RF_FIRMWARE] =
+  {
+    .partition_owner           = MICO_FLASH_NONE,
+  },
+  [MICO_PARTITION_PARAMETER_1] =
+  {
+    .partition_owner           = MICO_FLASH_SPI,
+    .partition_description     = "PARAMETER1",
+    .partition_start_addr      = 0x000E0000,
+    .partition_length          = 0x4000, // 16k bytes
+    .partition_options         = PAR_OPT_READ_EN | PAR_OPT_WRITE_EN,
+  },
+  [MICO_PARTITION_PARAMETER_2] =
+  {
+    .partition_owner           = MICO_FLASH_SPI,
+    .partition_description     = "PARAMETER2",
+    .partition_start_addr      = 0x000E4000,
+    .partition_length          = 0x4000, //16k bytes
+    .partition_options         = PAR_OPT_READ_EN | PAR_OPT_WRITE_EN,
+  },
+  [MICO_PARTITION_SYSTEM_SNAPSHOT] =
+  {
+    .partition_owner           = MICO_FLASH_SPI,
+    .partition_description     = "SNAPSHOT",
+    .partition_start_addr      = 0x000E8000,
+    .partition_length          = 0x1000, //4k bytes
+    .partition_options         = PAR_OPT_READ_EN | PAR_OPT_WRITE_EN,
+  },
+  [MICO_PARTITION_ATE] =
+  {
+    .partition_owner           = MICO_FLASH_SPI,
+    .partition_description     = "ATE",
+    .partition_start_addr      = 0x00100000,
+    .partition_length          = 0x60000, //384k bytes
+    .partition_options         = PAR_OPT_READ_EN | PAR_OPT_WRITE_EN,
+  },
+  [MICO_PARTITION_OTA_TEMP] =
+  {
+    .partition_owner           = MICO_FLASH_SPI,
+    .partition_description     = "OTA Storage",
+    .partition_start_addr      = 0x00160000,
+    .partition_length          = 0x90000, //576k bytes
+    .partition_options         = PAR_OPT_READ_EN | PAR_OPT_WRITE_EN,
+  },
+};
+
+extern OSStatus update(void);
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+static void bench_report( const char *name, uint32_t runs )
+{
+  platform_flash_sim_stats_t st;
+  const platform_flash_t *flash = &platform_flash_peripherals[MICO_FLASH_SPI];
+
+  platform_flash_sim_get_stats( flash, &st );
+  printf( "%-14s %10.1f ms/run  (erase %.1f, program %.1f, read %.1f)\n", name,
+          st.busy_ns / 1e6 / runs, st.erase_ns / 1e6 / runs, st.program_ns / 1e6 / runs, st.read_ns / 1e6 / runs );
+  printf( "%-14s %10u erases, %u program commands, %u bytes programmed, %u bytes read\n", "",
+          (unsigned)st.sector_erases, (unsigned)st.program_commands, (unsigned)st.bytes_programmed, (unsigned)st.bytes_read );
+  printf( "%-14s %10u max erases of one sector, %u worn sectors, %u program violations\n", "",
+          (unsigned)st.max_sector_erases, (unsigned)st.worn_sectors, (unsigned)st.program_violations );
+  platform_flash_sim_reset_stats( flash );
+}
+
+/* Same sequence of flash operations as internal_update_config() in MICOParaStorage.c */
+static OSStatus bench_config_save( uint8_t *content, uint8_t *readback )
+{
+  OSStatus err;
+  uint32_t offset;
+  CRC16_Context crc_context;
+  uint16_t crc, crc_readback;
+
+  CRC16_Init( &crc_context );
+  CRC16_Update( &crc_context, content + sizeof(bench_boot_table_t), CONFIG_CONTENT_SIZE - sizeof(bench_boot_table_t) );
+  CRC16_Final( &crc_context, &crc );
+
+  err = MicoFlashErase( MICO_PARTITION_PARAMETER_1, 0x0, CONFIG_CRC_OFFSET + CONFIG_CRC_SIZE );
+  require_noerr( err, exit );
+  offset = 0x0;
+  err = MicoFlashWrite( MICO_PARTITION_PARAMETER_1, &offset, content, CONFIG_CONTENT_SIZE );
+  require_noerr( err, exit );
+  offset = 0x0;
+  err = MicoFlashRead( MICO_PARTITION_PARAMETER_1, &offset, readback, CONFIG_CONTENT_SIZE );
+  require_noerr( err, exit );
+  require_action( memcmp( readback, content, CONFIG_CONTENT_SIZE ) == 0, exit, err = kWriteErr );
+  offset = CONFIG_CRC_OFFSET;
+  err = MicoFlashWrite( MICO_PARTITION_PARAMETER_1, &offset, (uint8_t *)&crc, CONFIG_CRC_SIZE );
+  require_noerr( err, exit );
+  offset = CONFIG_CRC_OFFSET;
+  err = MicoFlashRead( MICO_PARTITION_PARAMETER_1, &offset, (uint8_t *)&crc_readback, CONFIG_CRC_SIZE );
+  require_noerr( err, exit );
+  require_action( crc_readback == crc, exit, err = kWriteErr );
+
+  err = MicoFlashErase( MICO_PARTITION_PARAMETER_2, 0x0, CONFIG_CRC_OFFSET + CONFIG_CRC_SIZE );
+  require_noerr( err, exit );
+  offset = 0x0;
+  err = MicoFlashWrite( MICO_PARTITION_PARAMETER_2, &offset, content, CONFIG_CONTENT_SIZE );
+  require_noerr( err, exit );
+  offset = CONFIG_CRC_OFFSET;
+  err = MicoFlashWrite( MICO_PARTITION_PARAMETER_2, &offset, (uint8_t *)&crc, CONFIG_CRC_SIZE );
+  require_noerr( err, exit );
+
+exit:
+  return err;
+}
+
+static OSStatus bench_config_store( void )
+{
+  OSStatus err = kNoErr;
+  uint8_t *content = malloc( CONFIG_CONTENT_SIZE );
+  uint8_t *readback = malloc( CONFIG_CONTENT_SIZE );
+  int i;
+
+  require_action( content && readback, exit, err = kNoMemoryErr );
+  memset( content, 0xFF, sizeof(bench_boot_table_t) );
+  for( i = 0; i < CONFIG_SAVES; i++ ){
+    memset( content + sizeof(bench_boot_table_t), i, CONFIG_CONTENT_SIZE - sizeof(bench_boot_table_t) );
+    err = bench_config_save( content, readback );
+    require_noerr( err, exit );
+  }
+  bench_report( "config save", CONFIG_SAVES );
+
+exit:
+  if( content ) free( content );
+  if( readback ) free( readback );
+  return err;
+}
+
+/* Receive an image into the OTA partition the way the OTA paths do, then let the bootloader apply it */
+static OSStatus bench_ota_apply( void )
+{
+  OSStatus err = kNoErr;
+  uint8_t *image = malloc( OTA_IMAGE_SIZE );
+  uint8_t *check = malloc( OTA_RECV_CHUNK );
+  bench_boot_table_t table;
+  CRC16_Context crc_context;
+  uint32_t offset, i;
+
+  require_action( image && check, exit, err = kNoMemoryErr );
+  for( i = 0; i < OTA_IMAGE_SIZE; i++ )
+    image[i] = (uint8_t)( i * 2654435761u >> 24 );
+
+  err = MicoFlashErase( MICO_PARTITION_OTA_TEMP, 0x0, OTA_IMAGE_SIZE );
+  require_noerr( err, exit );
+  for( offset = 0; offset < OTA_IMAGE_SIZE; ){
+    err = MicoFlashWrite( MICO_PARTITION_OTA_TEMP, &offset, image + offset, OTA_RECV_CHUNK );
+    require_noerr( err, exit );
+  }
+  bench_report( "OTA receive", 1 );
+
+  memset( &table, 0xFF, sizeof(table) );
+  table.start_address = mico_partitions[MICO_PARTITION_OTA_TEMP].partition_start_addr;
+  table.length = OTA_IMAGE_SIZE;
+  table.type = 'A';
+  table.upgrade_type = 'U';
+  CRC16_Init( &crc_context );
+  CRC16_Update( &crc_context, image, OTA_IMAGE_SIZE );
+  CRC16_Final( &crc_context, &table.crc );
+  err = MicoFlashErase( MICO_PARTITION_PARAMETER_1, 0x0, sizeof(table) );
+  require_noerr( err, exit );
+  offset = 0x0;
+  err = MicoFlashWrite( MICO_PARTITION_PARAMETER_1, &offset, (uint8_t *)&table, sizeof(table) );
+  require_noerr( err, exit );
+  platform_flash_sim_reset_stats( &platform_flash_peripherals[MICO_FLASH_SPI] );
+
+  err = update();
+  require_noerr( err, exit );
+  bench_report( "OTA apply", 1 );
+
+  for( offset = 0; offset < OTA_IMAGE_SIZE; offset += OTA_RECV_CHUNK ){
+    i = offset;
+    err = MicoFlashRead( MICO_PARTITION_APPLICATION, &i, check, OTA_RECV_CHUNK );
+    require_noerr( err, exit );
+    require_action( memcmp( check, image + offset, OTA_RECV_CHUNK ) == 0, exit, err = kWriteErr );
+  }
+  platform_flash_sim_reset_stats( &platform_flash_peripherals[MICO_FLASH_SPI] );
+
+exit:
+  if( image ) free( image );
+  if( check ) free( check );
+  return err;
+}
+
+int main( int argc, char *argv[] )
+{
+  OSStatus err;
+  const platform_flash_t *flash = &platform_flash_peripherals[MICO_FLASH_SPI];
+
+  if( argc > 1 )
+    strncpy( image_path, argv[1], sizeof(image_path) - 1 );
+  printf( "%s, %s\n", flash->profile->name, image_path[0] ? image_path : "RAM image" );
+
+  err = bench_config_store();
+  require_noerr( err, exit );
+  err = bench_ota_apply();
+  require_noerr( err, exit );
+  printf( "PARAMETER1 sector erased %u times, APPLICATION first sector %u times\n",
+          (unsigned)platform_flash_sim_erase_count( flash, mico_partitions[MICO_PARTITION_PARAMETER_1].partition_start_addr ),
+          (unsigned)platform_flash_sim_erase_count( flash, mico_partitions[MICO_PARTITION_APPLICATION].partition_start_addr ) );
+
+exit:
+  platform_flash_sim_deinit( flash );
+  if( err != kNoErr )
+    printf( "Benchmark failed, err = %d\n", err );
+  return err == kNoErr ? 0 : 1;
+}
@@ -0,0 +1,530 @@
+/**
+******************************************************************************
+* @file    hci_h4_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Replay of HCI traces through the H4 framer of userial_wiced.c:
+*          packets/s, UART reads per packet and GKI pool use.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench includes userial_wiced.c and runs its read thread against a simulated UART ring
+ *  and GKI pools. The board's BT UART and the STM32 USART of platform_USART_Config are
+ *  stand-ins, platform_USART_Config itself is never called and dropped by the linker:
+ *
+ *    B=MICO/bluetooth_bte/BTE
+ *    gcc -O2 -std=c99 -ffunction-sections -fdata-sections -Wl,--gc-sections
+ *        -DBUILDCFG -DBLUETOOTH_BTE -DWICED_BTE_LIB
+ *        -IMICO/bluetooth_bte -IMICO/bluetooth_bte/include -I$B/Components/gki/common -I$B/Components/gki/wiced
+ *        -I$B/Components/udrv/include -I$B/Components/udrv/wiced -I$B/Projects/bte/main
+ *        -I$B/Components/stack/include -I$B/Components/stack/wiced -IPlatform/MCU/Host
+ *        -IPlatform/MCU/Host/peripherals -IBoard/EMW3081 -IPlatform/include -Iinclude
+ *        -Iinclude/MicoDrivers -ISupport Platform/MCU/Host/hci_h4_bench.c
+ *
+ *  Include names follow the Windows tool chains, see flash_sim_bench.c.
+ *
+ *    hci_h4_bench [trace.h4]    a recorded H4 byte stream (packet type bytes included), or
+ *                               the built in traces
+ *
+ *  The UART ring fills by a DMA chunk of 1 to BENCH_CHUNK_MAX bytes whenever the read thread
+ *  looks at it, so reads see whatever a busy line would have buffered. The stack side drains
+ *  Userial_in_q only every BENCH_DRAIN_BATCHES notifications, and the ACL pool holds
+ *  BENCH_ACL_BUFS buffers, so the framer also runs out of buffers and waits in GKI_delay.
+ *  Each trace is replayed once more with BENCH_STARVED_BUFS ACL buffers, where packets longer
+ *  than the stage fill it while they wait: the thread must sleep, not read 0 bytes in a loop.
+ *  Every byte USERIAL_Read returns is compared with the trace.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "MICO.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+/* The board's Bluetooth UART */
+#define BT_UART                 MICO_UART_1
+
+/* STM32 USART of platform_USART_Config */
+#define USART1                  ( (void *)0 )
+#define DISABLE                 ( 0 )
+#define ENABLE                  ( 1 )
+#define USART_WordLength_8b     ( 0 )
+#define USART_StopBits_1        ( 0 )
+#define USART_Parity_No         ( 0 )
+#define USART_HardwareFlowControl_RTS_CTS ( 0 )
+#define USART_Mode_Rx           ( 1 )
+#define USART_Mode_Tx           ( 2 )
+
+#define BENCH_ROUNDS            7
+#define BENCH_TRACE_MAX         ( 4 * 1024 * 1024 )
+#define BENCH_CHUNK_MAX         64
+#define BENCH_ACL_BUF_SIZE      1024
+#define BENCH_ACL_BUFS          8
+#define BENCH_DRAIN_BATCHES     4
+#define BENCH_TAIL_CHECK        ( 64 * 1024 )
+#define BENCH_STARVED_BUFS      2
+#define BENCH_SPIN_MAX          100000      /* empty reads before the spinning thread is stopped */
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  uint32_t USART_BaudRate;
+  uint32_t USART_WordLength;
+  uint32_t USART_StopBits;
+  uint32_t USART_Parity;
+  uint32_t USART_HardwareFlowControl;
+  uint32_t USART_Mode;
+} USART_InitTypeDef;
+
+void USART_Cmd( void *usart, int state );
+void USART_Init( void *usart, USART_InitTypeDef *init );
+
+/* The driver traces go to printf, keep them out of the table */
+static int bench_trace( const char *format, ... );
+
+#include "bt_target.h"
+#undef DRV_TRACE_ERROR0
+#undef DRV_TRACE_ERROR1
+#undef DRV_TRACE_DEBUG0
+#define DRV_TRACE_ERROR0 bench_trace
+#define DRV_TRACE_ERROR1 bench_trace
+#define DRV_TRACE_DEBUG0 bench_trace
+
+#include "userial_wiced.c"
+
+/* wiced_bt_int.h maps it to UINT32, which is wider on the host */
+#undef uint32_t
+
+typedef struct bench_buf
+{
+  struct bench_buf *next;
+  uint32_t pool;                /* keeps data, the BT_HDR, aligned as GKI buffers are */
+  uint8_t data[];
+} bench_buf_t;
+
+typedef struct
+{
+  const char *name;
+  uint8_t *data;
+  uint32_t len;
+  uint32_t packets;
+} bench_trace_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static uint32_t bench_random( void );
+static uint32_t bench_put_event( uint8_t *p, uint8_t code, uint8_t len );
+static uint32_t bench_put_acl( uint8_t *p, uint16_t len );
+static void bench_build( bench_trace_t *trace, int kind );
+static void bench_rx_ready( tUSERIAL_PORT port, tUSERIAL_EVT evt, tUSERIAL_EVT_DATA *p_data );
+static int bench_replay( bench_trace_t *trace, uint32_t fail_read, double *seconds );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const char *bench_trace_names[] = { "a2dp stream", "le scan", "connection setup" };
+
+static wiced_bt_cfg_buf_pool_t bench_pools[WICED_BT_CFG_NUM_BUF_POOLS] =
+{
+  { 64, 16 }, { 360, 8 }, { BENCH_ACL_BUF_SIZE, BENCH_ACL_BUFS }, { 1024, 0 },
+};
+wiced_bt_cfg_buf_pool_t *p_btm_cfg_buf_pools = bench_pools;
+static uint32_t bench_pool_used[WICED_BT_CFG_NUM_BUF_POOLS];
+static uint32_t bench_pool_exhausted;
+
+static uint32_t bench_seed = 1;
+
+/* the UART ring */
+static const uint8_t *uart_data;
+static uint32_t uart_len;
+static uint32_t uart_arrived;
+static uint32_t uart_read;
+static uint32_t uart_calls;
+static uint32_t uart_fail_at;   /* MicoUartRecv call that loses its bytes, 0 for none */
+static uint32_t uart_empty_reads;
+
+/* the stack side */
+static uint8_t *stack_out;
+static uint32_t stack_out_len;
+static uint32_t stack_notifies;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+static int bench_trace( const char *format, ... )
+{
+  (void)format;
+  return 0;
+}
+
+/* GKI buffers */
+
+void GKI_init_q( BUFFER_Q *p_q )
+{
+  p_q->p_first = p_q->p_last = NULL;
+  p_q->count = 0;
+}
+
+void GKI_enqueue( BUFFER_Q *p_q, void *p_buf )
+{
+  bench_buf_t *b = (bench_buf_t *)( (uint8_t *)p_buf - offsetof( bench_buf_t, data ) );
+
+  b->next = NULL;
+  if( p_q->p_last )
+    ( (bench_buf_t *)( (uint8_t *)p_q->p_last - offsetof( bench_buf_t, data ) ) )->next = b;
+  else
+    p_q->p_first = p_buf;
+  p_q->p_last = p_buf;
+  p_q->count++;
+}
+
+void *GKI_dequeue( BUFFER_Q *p_q )
+{
+  bench_buf_t *b;
+
+  if( p_q->p_first == NULL )
+    return NULL;
+  b = (bench_buf_t *)( (uint8_t *)p_q->p_first - offsetof( bench_buf_t, data ) );
+  p_q->p_first = b->next ? b->next->data : NULL;
+  if( p_q->p_first == NULL )
+    p_q->p_last = NULL;
+  p_q->count--;
+  return b->data;
+}
+
+void *GKI_getpoolbuf( UINT8 pool_id )
+{
+  bench_buf_t *b;
+
+  if( bench_pool_used[pool_id] >= bench_pools[pool_id].buf_count ){
+    bench_pool_exhausted++;
+    return NULL;
+  }
+  b = malloc( sizeof(bench_buf_t) + bench_pools[pool_id].buf_size );
+  b->pool = pool_id;
+  bench_pool_used[pool_id]++;
+  return b->data;
+}
+
+void *GKI_getbuf( UINT16 size )
+{
+  UINT8 i;
+
+  for( i = 0; i < WICED_BT_CFG_NUM_BUF_POOLS; i++ )
+    if( bench_pools[i].buf_size >= size && bench_pools[i].buf_count )
+      return GKI_getpoolbuf( i );
+  return NULL;
+}
+
+void GKI_freebuf( void *p_buf )
+{
+  bench_buf_t *b = (bench_buf_t *)( (uint8_t *)p_buf - offsetof( bench_buf_t, data ) );
+
+  bench_pool_used[b->pool]--;
+  free( b );
+}
+
+/* The read thread sleeps for buffers, the stack runs meanwhile */
+void GKI_delay( UINT32 timeout )
+{
+  (void)timeout;
+  stack_out_len += USERIAL_Read( 0, stack_out + stack_out_len, 0xFFFF );
+}
+
+/* UART ring */
+
+static uint32_t bench_random( void )
+{
+  bench_seed = bench_seed * 1103515245 + 12345;
+  return bench_seed >> 16;
+}
+
+static void bench_uart_arrive( void )
+{
+  uart_arrived += 1 + bench_random( ) % BENCH_CHUNK_MAX;
+  if( uart_arrived > uart_len )
+    uart_arrived = uart_len;
+}
+
+uint32_t MicoUartGetLengthInBuffer( mico_uart_t uart )
+{
+  (void)uart;
+  bench_uart_arrive( );
+  return uart_arrived - uart_read;
+}
+
+OSStatus MicoUartRecv( mico_uart_t uart, void *data, uint32_t size, uint32_t timeout )
+{
+  (void)uart;
+  (void)timeout;
+  uart_calls++;
+  if( size == 0 && ++uart_empty_reads >= BENCH_SPIN_MAX )
+    g_readThreadAlive = 0;
+  if( uart_read + size > uart_len ){
+    /* end of the trace, stop the read thread */
+    g_readThreadAlive = 0;
+    uart_read = uart_len;
+    return kTimeoutErr;
+  }
+  while( uart_arrived < uart_read + size )
+    bench_uart_arrive( );
+  if( uart_calls == uart_fail_at ){
+    /* line error, the bytes are gone */
+    uart_read += size;
+    return kGeneralErr;
+  }
+  memcpy( data, uart_data + uart_read, size );
+  uart_read += size;
+  return kNoErr;
+}
+
+/* Traces */
+
+static uint32_t bench_put_event( uint8_t *p, uint8_t code, uint8_t len )
+{
+  uint32_t i;
+
+  p[0] = HCI_EVENT_PACKET;
+  p[1] = code;
+  p[2] = len;
+  for( i = 0; i < len; i++ )
+    p[3 + i] = (uint8_t)bench_random( );
+  return 3 + len;
+}
+
+static uint32_t bench_put_acl( uint8_t *p, uint16_t len )
+{
+  uint32_t i;
+
+  p[0] = HCI_ACL_DATA_PACKET;
+  p[1] = 0x01;
+  p[2] = 0x20;
+  p[3] = (uint8_t)len;
+  p[4] = (uint8_t)( len >> 8 );
+  for( i = 0; i < len; i++ )
+    p[5 + i] = (uint8_t)bench_random( );
+  return 5 + len;
+}
+
+/* Packet mixes of a sink streaming audio, of a busy LE scan and of a connection being set up */
+static void bench_build( bench_trace_t *trace, int kind )
+{
+  uint8_t *p = malloc( BENCH_TRACE_MAX );
+  uint32_t len = 0, n = 0;
+
+  while( len + 1100 < BENCH_TRACE_MAX ){
+    switch( kind ){
+      case 0:
+        /* 2-DH5 payloads, and now and then the largest ACL packet the pool buffer holds */
+        len += bench_put_acl( p + len, ( n % 5 == 4 ) ? BENCH_ACL_BUF_SIZE - BT_HDR_SIZE - H4_ACL_HDR_SIZE : 672 );
+        if( n % 4 == 3 ){
+          len += bench_put_event( p + len, 0x13, 5 );   /* number of completed packets */
+          n++;
+        }
+        break;
+      case 1:
+        len += bench_put_event( p + len, 0x3E, (uint8_t)( 12 + bench_random( ) % 32 ) );  /* LE advertising report */
+        break;
+      default:
+        switch( n % 6 ){
+          case 0:  len += bench_put_event( p + len, 0x0E, (uint8_t)( 4 + bench_random( ) % 9 ) ); break;
+          case 1:  len += bench_put_event( p + len, 0x0F, 4 ); break;
+          case 2:  len += bench_put_acl( p + len, (uint16_t)( 10 + bench_random( ) % 40 ) ); break;
+          case 3:  len += bench_put_event( p + len, 0x07, 255 ); break;    /* remote name */
+          case 4:  len += bench_put_acl( p + len, 27 ); break;
+          default: len += bench_put_event( p + len, 0x0E, 4 ); break;
+        }
+        break;
+    }
+    n++;
+  }
+  trace->name = bench_trace_names[kind];
+  trace->data = p;
+  trace->len = len;
+  trace->packets = n;
+}
+
+/* USERIAL_RX_READY_EVT, the stack reads every few notifications */
+static void bench_rx_ready( tUSERIAL_PORT port, tUSERIAL_EVT evt, tUSERIAL_EVT_DATA *p_data )
+{
+  (void)port;
+  (void)p_data;
+  if( evt == USERIAL_RX_READY_EVT && ++stack_notifies % BENCH_DRAIN_BATCHES == 0 )
+    stack_out_len += USERIAL_Read( 0, stack_out + stack_out_len, 0xFFFF );
+}
+
+/* Runs the read thread over the whole trace, returns the number of bytes that differ */
+static int bench_replay( bench_trace_t *trace, uint32_t fail_read, double *seconds )
+{
+  struct timespec t0, t1;
+  int i, errors = 0;
+
+  uart_data = trace->data;
+  uart_len = trace->len;
+  uart_arrived = uart_read = uart_calls = uart_empty_reads = 0;
+  uart_fail_at = fail_read;
+  stack_out_len = stack_notifies = 0;
+  bench_pool_exhausted = 0;
+  memset( &userial_rx_stats, 0, sizeof(userial_rx_stats) );
+  USERIAL_Init( NULL );
+  userial_cb.p_cback = bench_rx_ready;
+  bus_initialised = true;
+  g_readThreadAlive = 1;
+
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &t0 );
+  userial_read_thread( NULL );
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &t1 );
+  *seconds = ( t1.tv_sec - t0.tv_sec ) + ( t1.tv_nsec - t0.tv_nsec ) / 1e9;
+
+  /* what the stack has not read yet */
+  stack_out_len += USERIAL_Read( 0, stack_out + stack_out_len, 0xFFFF );
+  stack_out_len += USERIAL_Read( 0, stack_out + stack_out_len, 0xFFFF );
+  if( fail_read == 0 ){
+    if( stack_out_len != trace->len - userial_rx_stage_len )
+      errors++;
+    for( i = 0; i < (int)stack_out_len && i < (int)trace->len; i++ )
+      if( stack_out[i] != trace->data[i] )
+        errors++;
+  }
+  for( i = 0; i < WICED_BT_CFG_NUM_BUF_POOLS; i++ )
+    if( bench_pool_used[i] )
+      errors++;
+  return errors;
+}
+
+/* Packet boundaries of an H4 stream, -1 when it is not one */
+static int bench_count_packets( const uint8_t *p, uint32_t len )
+{
+  uint32_t pos = 0;
+  int n = 0, pkt;
+
+  while( pos < len ){
+    pkt = h4_packet_length( p + pos, len - pos );
+    if( pkt <= 0 || pos + pkt > len )
+      return -1;
+    pos += pkt;
+    n++;
+  }
+  return n;
+}
+
+int main( int argc, char *argv[] )
+{
+  bench_trace_t traces[3], *trace;
+  int kinds = 3, k, r, errors, failed = 0, packets;
+  double t, best;
+  FILE *f;
+
+  stack_out = malloc( BENCH_TRACE_MAX );
+  if( argc > 1 ){
+    f = fopen( argv[1], "rb" );
+    if( f == NULL ){
+      printf( "Cannot open %s\n", argv[1] );
+      return 1;
+    }
+    traces[0].name = argv[1];
+    traces[0].data = malloc( BENCH_TRACE_MAX );
+    traces[0].len = (uint32_t)fread( traces[0].data, 1, BENCH_TRACE_MAX, f );
+    traces[0].packets = (uint32_t)bench_count_packets( traces[0].data, traces[0].len );
+    fclose( f );
+    kinds = 1;
+  }else{
+    for( k = 0; k < kinds; k++ )
+      bench_build( &traces[k], k );
+  }
+
+  printf( "ACL pool %d x %d bytes, stage %d bytes, stack reads every %d notifications\n\n",
+          BENCH_ACL_BUFS, BENCH_ACL_BUF_SIZE, USERIAL_RX_STAGE_SIZE, BENCH_DRAIN_BATCHES );
+  printf( "%-18s %8s %12s %11s %10s %10s %8s\n", "trace", "packets", "packets/s", "reads/pkt",
+          "pkts/batch", "no buffer", "errors" );
+  for( k = 0; k < kinds; k++ ){
+    trace = &traces[k];
+    best = 0;
+    errors = 0;
+    for( r = 0; r < BENCH_ROUNDS; r++ ){
+      errors += bench_replay( trace, 0, &t );
+      t = userial_rx_stats.packets / t;
+      best = ( t > best ) ? t : best;
+    }
+    if( userial_rx_stats.packets != trace->packets || userial_rx_stats.dropped_bytes )
+      errors++;
+    printf( "%-18s %8u %12.0f %11.2f %10.2f %10u %8d\n", trace->name, (unsigned)userial_rx_stats.packets, best,
+            (double)uart_calls / userial_rx_stats.packets,
+            (double)userial_rx_stats.packets / userial_rx_stats.batches, (unsigned)bench_pool_exhausted, errors );
+    if( errors )
+      failed = 1;
+
+    /* few ACL buffers: the head packet waits for one in GKI_delay, however much of it is staged */
+    bench_pools[2].buf_count = BENCH_STARVED_BUFS;
+    errors = bench_replay( trace, 0, &t );
+    bench_pools[2].buf_count = BENCH_ACL_BUFS;
+    if( userial_rx_stats.packets != trace->packets || uart_empty_reads )
+      errors++;
+    printf( "%-18s %u ACL buffers: %u out of buffers, %u empty reads, %d errors\n", "", (unsigned)BENCH_STARVED_BUFS,
+            (unsigned)bench_pool_exhausted, (unsigned)uart_empty_reads, errors );
+    if( errors )
+      failed = 1;
+
+    /* one read failing early in the trace: the buffer goes back to the pool, only framed packets are
+     * counted, and the framer resyncs so the end of the trace is delivered intact. Payload bytes
+     * can pass for packets while it resyncs, those are framed and counted like any other */
+    for( r = 3; r < 40; r += 7 ){
+      errors = bench_replay( trace, r, &t );
+      packets = bench_count_packets( stack_out, stack_out_len );
+      if( packets < 0 || (uint32_t)packets != userial_rx_stats.packets )
+        errors++;
+      if( stack_out_len < BENCH_TAIL_CHECK
+          || memcmp( stack_out + stack_out_len - BENCH_TAIL_CHECK, trace->data + trace->len - BENCH_TAIL_CHECK, BENCH_TAIL_CHECK ) )
+        errors++;
+      if( errors ){
+        printf( "%-18s read %d failing: %d errors, %d packets delivered, %u counted\n", trace->name, r,
+                errors, packets, (unsigned)userial_rx_stats.packets );
+        failed = 1;
+      }
+    }
+    free( trace->data );
+  }
+
+  free( stack_out );
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
@@ -0,0 +1,318 @@
+/**
+******************************************************************************
+* @file    hsb2rgb_bench.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Benchmark and tolerance check of the integer HSB to RGB conversion of the
+*          MiCOKit-EXT RGB LED driver against the float conversion it replaced.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench provides the GPIO of the P9813 pins, counting the edges clocked out:
+ *
+ *    gcc -O2 -DNO_MICO_RTOS -DUSE_MiCOKit_EXT -DArduino_SCL=MICO_GPIO_1 -DArduino_SDA=MICO_GPIO_2
+ *        -ffunction-sections -fdata-sections -Wl,--gc-sections
+ *        -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals -IBoard/EMW3081 -IPlatform/include
+ *        -Iinclude -Iinclude/MicoDrivers -IPlatform/Drivers/MiCOKit_EXT -IPlatform/Drivers/MiCOKit_EXT/rgb_led
+ *        Platform/MCU/Host/hsb2rgb_bench.c Platform/MCU/mico_platform_common.c
+ *        Platform/Drivers/MiCOKit_EXT/rgb_led/hsb2rgb_led.c rgb_led.o -lm
+ *
+ *  where rgb_led.o is Platform/Drivers/MiCOKit_EXT/rgb_led/rgb_led.c built with the same flags plus
+ *  -std=c99, see oled_bench.c. Throughput is host time: the targets have no FPU, so the float
+ *  version runs on software floating point there and the gap is much wider than measured here.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "MICOPlatform.h"
+#include "platform_peripheral.h"
+#include "hsb2rgb_led.h"
+#include "rgb_led.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_CONVERSIONS       (4000000)
+#define BENCH_STRIP_LEDS        (8)
+#define BENCH_BREATHE_FRAMES    (50)          /* One second at 50 frames/s each way */
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+const platform_gpio_t platform_gpio_pins[MICO_GPIO_MAX];
+
+static uint32_t bench_gpio_writes;
+static volatile uint32_t bench_sink;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+OSStatus platform_gpio_init( const platform_gpio_t* gpio, platform_pin_config_t config )
+{
+  UNUSED_PARAMETER( gpio );
+  UNUSED_PARAMETER( config );
+  return kNoErr;
+}
+
+OSStatus platform_gpio_output_high( const platform_gpio_t* gpio )
+{
+  UNUSED_PARAMETER( gpio );
+  bench_gpio_writes++;
+  return kNoErr;
+}
+
+OSStatus platform_gpio_output_low( const platform_gpio_t* gpio )
+{
+  UNUSED_PARAMETER( gpio );
+  bench_gpio_writes++;
+  return kNoErr;
+}
+
+static float constrain( float value, float min, float max )
+{
+  if( value >= max )
+    return max;
+  if( value <= min )
+    return min;
+  return value;
+}
+
+/* The float conversion as the driver had it, the reference of the tolerance check */
+static void bench_hsb_to_rgb_float( float hue, float sat, float bright, float *color )
+{
+  hue = constrain( hue, 0, 360 );
+  sat = constrain( sat, 0, 100 );
+  bright = constrain( bright, 0, 100 );
+  float max_rgb_val = 255.0;
+  float sat_f = (float)sat / 100.0;
+  float bright_f = (float)bright / 100.0;
+  float r = 0, g = 0, b = 0;
+  if( bright <= 0 ){
+    color[0] = 0;
+    color[1] = 0;
+    color[2] = 0;
+  }
+  if( sat <= 0 ){
+    color[0] = bright_f * max_rgb_val;
+    color[1] = bright_f * max_rgb_val;
+    color[2] = bright_f * max_rgb_val;
+  }
+  else{
+    if( hue >= 0 && hue < 120 ){
+      float hue_primary = 1.0 - ( (float)hue / 120.0 );
+      float hue_secondary = (float)hue / 120.0;
+      float sat_primary = ( 1.0 - hue_primary ) * ( 1.0 - sat_f );
+      float sat_secondary = ( 1.0 - hue_secondary ) * ( 1.0 - sat_f );
+      float sat_tertiary = 1.0 - sat_f;
+      r = ( bright_f * max_rgb_val ) * ( hue_primary + sat_primary );
+      g = ( bright_f * max_rgb_val ) * ( hue_secondary + sat_secondary );
+      b = ( bright_f * max_rgb_val ) * sat_tertiary;
+    }
+    else if( hue >= 120 && hue < 240 ){
+      float hue_primary = 1.0 - ( ( (float)hue - 120.0 ) / 120.0 );
+      float hue_secondary = ( (float)hue - 120.0 ) / 120.0;
+      float sat_primary = ( 1.0 - hue_primary ) * ( 1.0 - sat_f );
+      float sat_secondary = ( 1.0 - hue_secondary ) * ( 1.0 - sat_f );
+      float sat_tertiary = 1.0 - sat_f;
+      r = ( bright_f * max_rgb_val ) * sat_tertiary;
+      g = ( bright_f * max_rgb_val ) * ( hue_primary + sat_primary );
+      b = ( bright_f * max_rgb_val ) * ( hue_secondary + sat_secondary );
+    }
+    else if( hue >= 240 && hue <= 360 ){
+      float hue_primary = 1.0 - ( ( (float)hue - 240.0 ) / 120.0 );
+      float hue_secondary = ( (float)hue - 240.0 ) / 120.0;
+      float sat_primary = ( 1.0 - hue_primary ) * ( 1.0 - sat_f );
+      float sat_secondary = ( 1.0 - hue_secondary ) * ( 1.0 - sat_f );
+      float sat_tertiary = 1.0 - sat_f;
+      r = ( bright_f * max_rgb_val ) * ( hue_secondary + sat_secondary );
+      g = ( bright_f * max_rgb_val ) * sat_tertiary;
+      b = ( bright_f * max_rgb_val ) * ( hue_primary + sat_primary );
+    }
+    color[0] = r;
+    color[1] = g;
+    color[2] = b;
+  }
+}
+
+static double bench_now( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Same scaling as hsb2rgb_led_open() */
+static void bench_hsb( float hue, float sat, float bright, h2r_hsb_t *hsb )
+{
+  hsb->hue = (uint16_t)( hue * H2R_HUE_SCALE + 0.5f );
+  hsb->sat = (uint16_t)( sat * H2R_PERCENT_SCALE + 0.5f );
+  hsb->bright = (uint16_t)( bright * H2R_PERCENT_SCALE + 0.5f );
+}
+
+/* Largest channel difference to the float conversion, truncated as OpenLED_RGB did */
+static int bench_compare( float hue, float sat, float bright )
+{
+  float ref[3];
+  uint8_t rgb[3];
+  h2r_hsb_t hsb;
+  int i, diff, worst = 0;
+
+  bench_hsb_to_rgb_float( hue, sat, bright, ref );
+  bench_hsb( hue, sat, bright, &hsb );
+  hsb2rgb_convert( &hsb, rgb, false );
+  for( i = 0; i < 3; i++ ){
+    diff = abs( (int)(uint8_t)ref[i] - rgb[i] );
+    worst = Max( worst, diff );
+  }
+  return worst;
+}
+
+static int bench_tolerance( void )
+{
+  uint32_t checked = 0, off = 0;
+  int worst = 0, diff, h, s, b, i;
+
+  /* Half degree hue steps and whole percents, as applications pass them */
+  for( h = 0; h <= 720; h++ ){
+    for( s = 0; s <= 100; s++ ){
+      for( b = 0; b <= 100; b++ ){
+        diff = bench_compare( h / 2.0f, s, b );
+        worst = Max( worst, diff );
+        off += diff != 0;
+        checked++;
+      }
+    }
+  }
+  /* Arbitrary inputs go through the 1/16 quantization of the inputs as well */
+  srand( 1 );
+  for( i = 0; i < 1000000; i++ ){
+    diff = bench_compare( rand( ) % 36001 / 100.0f, rand( ) % 10001 / 100.0f, rand( ) % 10001 / 100.0f );
+    worst = Max( worst, diff );
+    off += diff != 0;
+    checked++;
+  }
+  printf( "tolerance        %lu colours, %lu differ from float, max difference %d\n",
+          (unsigned long)checked, (unsigned long)off, worst );
+  return worst <= 1 ? kNoErr : kGeneralErr;
+}
+
+static void bench_speed( void )
+{
+  float color[3];
+  uint8_t rgb[3];
+  h2r_hsb_t hsb;
+  double start, float_s, fixed_s;
+  uint32_t i;
+
+  start = bench_now( );
+  for( i = 0; i < BENCH_CONVERSIONS; i++ ){
+    bench_hsb_to_rgb_float( (float)( i % 360 ), (float)( i % 101 ), (float)( i % 97 ), color );
+    bench_sink += (uint8_t)color[0] + (uint8_t)color[1] + (uint8_t)color[2];
+  }
+  float_s = bench_now( ) - start;
+
+  start = bench_now( );
+  for( i = 0; i < BENCH_CONVERSIONS; i++ ){
+    hsb.hue = (uint16_t)( i % 360 * H2R_HUE_SCALE );
+    hsb.sat = (uint16_t)( i % 101 * H2R_PERCENT_SCALE );
+    hsb.bright = (uint16_t)( i % 97 * H2R_PERCENT_SCALE );
+    hsb2rgb_convert( &hsb, rgb, true );
+    bench_sink += rgb[0] + rgb[1] + rgb[2];
+  }
+  fixed_s = bench_now( ) - start;
+
+  printf( "float            %8.1f M conversions/s\n", BENCH_CONVERSIONS / float_s / 1e6 );
+  printf( "fixed + gamma    %8.1f M conversions/s\n", BENCH_CONVERSIONS / fixed_s / 1e6 );
+}
+
+/* Breathing strip: every LED runs its own hue, the chain goes out once per frame */
+static int bench_strip( void )
+{
+  static h2r_anim_t anims[BENCH_STRIP_LEDS];
+  static uint8_t rgb[3 * BENCH_STRIP_LEDS];
+  h2r_strip_t strip = { .anims = anims, .rgb = rgb, .count = BENCH_STRIP_LEDS, .gamma = true };
+  h2r_hsb_t from, to, hsb;
+  uint32_t frames = 4 * BENCH_BREATHE_FRAMES, chain_writes, single_writes, i;
+  int err = kNoErr;
+
+  for( i = 0; i < BENCH_STRIP_LEDS; i++ ){
+    from.hue = to.hue = (uint16_t)( i * H2R_HUE_MAX / BENCH_STRIP_LEDS );
+    from.sat = to.sat = H2R_PERCENT_MAX;
+    from.bright = 5 * H2R_PERCENT_SCALE;
+    to.bright = H2R_PERCENT_MAX;
+    hsb2rgb_anim_start( &anims[i], &from, &to, BENCH_BREATHE_FRAMES, H2R_ANIM_BREATHE );
+  }
+
+  bench_gpio_writes = 0;
+  for( i = 0; i < frames; i++ ){
+    hsb2rgb_strip_frame( &strip );
+    /* Full brightness every other leg end, back to the start colour after two legs */
+    if( i % ( 2 * BENCH_BREATHE_FRAMES ) == BENCH_BREATHE_FRAMES && rgb[0] != 255 )
+      err = kGeneralErr;
+  }
+  chain_writes = bench_gpio_writes;
+
+  bench_gpio_writes = 0;
+  for( i = 0; i < frames * BENCH_STRIP_LEDS; i++ )
+    rgb_led_open( rgb[0], rgb[1], rgb[2] );
+  single_writes = bench_gpio_writes;
+
+  printf( "strip            %lu LEDs: %lu GPIO writes per frame in one chain, %lu with one rgb_led_open per LED\n",
+          (unsigned long)BENCH_STRIP_LEDS, (unsigned long)( chain_writes / frames ), (unsigned long)( single_writes / frames ) );
+
+  /* A fade stops on its end colour, also across the hue wrap */
+  from.hue = 350 * H2R_HUE_SCALE;
+  to.hue = 10 * H2R_HUE_SCALE;
+  from.sat = to.sat = from.bright = to.bright = H2R_PERCENT_MAX;
+  hsb2rgb_anim_start( &anims[0], &from, &to, 7, H2R_ANIM_FADE );
+  for( i = 0; hsb2rgb_anim_step( &anims[0], &hsb ); i++ ){
+    if( hsb.hue > 10 * H2R_HUE_SCALE && hsb.hue < 350 * H2R_HUE_SCALE )
+      err = kGeneralErr;
+  }
+  if( i != 7 || hsb.hue != to.hue )
+    err = kGeneralErr;
+  return err;
+}
+
+int main( void )
+{
+  int err;
+
+  err = bench_tolerance( );
+  bench_speed( );
+  if( err == kNoErr )
+    err = bench_strip( );
+
+  if( err != 0 )
+    printf( "Benchmark failed, err = %d\n", err );
+  return err == 0 ? 0 : 1;
+}
@@ -0,0 +1,523 @@
+/**
+******************************************************************************
+* @file    http_scan_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Compiled scan formats against VSNScanF and the C library, and
+*          HTTP header field parsing on realistic header sets.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench builds HTTPUtils.c with the string and URL helpers it uses:
+ *
+ *    gcc -O2 -std=c99 -IMICO -Iinclude -Iinclude/MicoDrivers -IPlatform/include -IBoard/EMW3081
+ *        -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals -ISupport -IExternal
+ *        -IDemos/COM.MXCHIP.SPP Platform/MCU/Host/http_scan_bench.c
+ *
+ *  Include names follow the Windows tool chains, see flash_sim_bench.c.
+ *
+ *  Random inputs built from numbers, words and separators are scanned with a set of formats
+ *  three ways: VSNScanF, the same format compiled once with ScanFormatCompile, and sscanf as
+ *  the reference. The return value and every stored byte must agree. The pre-built and the
+ *  SCAN_OP_* formats are held to VSNScanF the same way. VSNScanF takes scanset characters
+ *  literally, without ranges, reads %i with a leading 0 as decimal, not octal, and fails a %c
+ *  that runs out of input where sscanf stores what there is. The formats keep to sets without
+ *  ranges, and %i and %c are held to VSNScanF only.
+ *
+ *  HTTPHeaderParse runs on header sets taken from a browser, the config server, a cloud
+ *  service and an OTA download, and must pick up Connection, Transfer-Encoding and
+ *  Content-Length as the former three lookups did. Its field cost is the whole parse less
+ *  the parse of the same start line without fields, each the best of five runs.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "HTTPUtils.c"
+#include "URLUtils.c"
+#include "StringUtils.c"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_RANDOM_CASES      300000
+#define BENCH_TIMED_LOOPS       200000
+
+enum
+{
+  BENCH_ARGS_I,         /* int */
+  BENCH_ARGS_II,        /* int, int */
+  BENCH_ARGS_III,       /* int, int, int */
+  BENCH_ARGS_LL,        /* long long */
+  BENCH_ARGS_S,         /* char[] */
+  BENCH_ARGS_SS,        /* char[], char[] */
+  BENCH_ARGS_SI,        /* char[], int */
+  BENCH_ARGS_CN,        /* char[], int for %n */
+  BENCH_ARGS_IL,        /* int, long long */
+  BENCH_ARGS_H,         /* short */
+};
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  const char *  format;
+  int           args;
+  bool          libc;     /* sscanf is a reference for this format */
+} bench_format_t;
+
+typedef struct
+{
+  int           i[ 3 ];
+  long long     ll;
+  short         h;
+  char          s[ 2 ][ 32 ];
+} bench_result_t;
+
+typedef int (*bench_scan_f)( const void *context, const char *in, const char *format, ... );
+
+typedef struct
+{
+  const char *  name;
+  const char *  header;
+  bool          persistent;
+  bool          chunked;
+  uint64_t      contentLength;
+} bench_header_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static int bench_scan_vsn( const void *context, const char *in, const char *format, ... );
+static int bench_scan_compiled( const void *context, const char *in, const char *format, ... );
+static int bench_scan_libc( const void *context, const char *in, const char *format, ... );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const bench_format_t bench_formats[] =
+{
+  { "%d",               BENCH_ARGS_I,    true  },
+  { "%u",               BENCH_ARGS_I,    true  },
+  { "%x",               BENCH_ARGS_I,    true  },
+  { "%i",               BENCH_ARGS_I,    false },
+  { "%o",               BENCH_ARGS_I,    true  },
+  { "%hd",              BENCH_ARGS_H,    true  },
+  { "%llu",             BENCH_ARGS_LL,   true  },
+  { "%llx",             BENCH_ARGS_LL,   true  },
+  { "%lld",             BENCH_ARGS_LL,   true  },
+  { "%31s",             BENCH_ARGS_S,    true  },
+  { "%5s %31s",         BENCH_ARGS_SS,   true  },
+  { "%d %d",            BENCH_ARGS_II,   true  },
+  { "%*d %d",           BENCH_ARGS_I,    true  },
+  { "%2d%3x",           BENCH_ARGS_II,   true  },
+  { "%d,%d",            BENCH_ARGS_II,   true  },
+  { "HTTP/%d.%d %d",    BENCH_ARGS_III,  true  },
+  { "%31[abcxyz=]%d",   BENCH_ARGS_SI,   true  },
+  { "%31[^,],%31s",     BENCH_ARGS_SS,   true  },
+  { "%3c%n",            BENCH_ARGS_CN,   false },
+  { "%%%d",             BENCH_ARGS_I,    true  },
+  { "x=%d;y=%llx",      BENCH_ARGS_IL,   true  },
+  { "  %d  %n",         BENCH_ARGS_II,   true  },
+};
+
+static const char *const bench_tokens[] =
+{
+  " ", " ", "\t", ",", ";", "-", "+", ".", "%", "x=", ";y=", "HTTP/", "0x", "abc", "Zq", "0",
+};
+
+static const bench_header_t bench_headers[] =
+{
+  { "browser GET",
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: 192.168.1.1\r\n"
+    "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Connection: keep-alive\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "\r\n", true, false, 0 },
+  { "config POST",
+    "POST /config-write HTTP/1.1\r\n"
+    "Host: 10.10.10.1\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 1432\r\n"
+    "Connection: close\r\n"
+    "\r\n", false, false, 1432 },
+  { "cloud response",
+    "HTTP/1.1 200 OK\r\n"
+    "Server: nginx/1.4.6 (Ubuntu)\r\n"
+    "Date: Mon, 19 Oct 2026 08:00:00 GMT\r\n"
+    "Content-Type: application/json; charset=utf-8\r\n"
+    "Content-Length: 256\r\n"
+    "Connection: keep-alive\r\n"
+    "Vary: Accept-Encoding\r\n"
+    "ETag: W/\"100-abcdef\"\r\n"
+    "X-Request-Id: 6f9619ff-8b86-d011-b42d-00cf4fc964ff\r\n"
+    "\r\n", true, false, 256 },
+  { "OTA chunked",
+    "HTTP/1.1 200 OK\r\n"
+    "Server: Apache\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Content-Type: application/octet-stream\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n", true, true, 0 },
+  { "HTTP/1.0 folded",
+    "HTTP/1.0 200 OK\r\n"
+    "content-length:\r\n"
+    " 4294967301\r\n"
+    "Content-Length: 7\r\n"
+    "TRANSFER-ENCODING: Chunked\r\n"
+    "\r\n", false, true, 4294967301ULL },
+};
+
+static uint32_t bench_seed = 777;
+static unsigned int bench_failed;
+
+#define BENCH_CHECK( x )  do{ if( !( x ) ){ printf( "check failed, line %d: %s\n", __LINE__, #x ); bench_failed++; } }while( 0 )
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+static uint32_t bench_random( void )
+{
+  bench_seed = bench_seed * 1103515245 + 12345;
+  return ( bench_seed >> 8 ) & 0xFFFFFF;
+}
+
+static double bench_time( void )
+{
+  struct timespec t;
+
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static int bench_scan_vsn( const void *context, const char *in, const char *format, ... )
+{
+  va_list args;
+  int n;
+
+  (void)context;
+  va_start( args, format );
+  n = VSNScanF( in, kSizeCString, format, args );
+  va_end( args );
+  return n;
+}
+
+static int bench_scan_compiled( const void *context, const char *in, const char *format, ... )
+{
+  va_list args;
+  int n;
+
+  (void)format;
+  va_start( args, format );
+  n = ScanFormatApplyV( (const ScanFormat *)context, in, kSizeCString, args );
+  va_end( args );
+  return n;
+}
+
+/* sscanf returns EOF where nothing was converted because the input ran out, VSNScanF 0 */
+static int bench_scan_libc( const void *context, const char *in, const char *format, ... )
+{
+  va_list args;
+  int n;
+
+  (void)context;
+  va_start( args, format );
+  n = vsscanf( in, format, args );
+  va_end( args );
+  return ( n == EOF ) ? 0 : n;
+}
+
+static int bench_scan( bench_scan_f scan, const void *context, const char *in, const bench_format_t *f, bench_result_t *r )
+{
+  memset( r, 0x5a, sizeof( *r ) );
+  switch( f->args )
+  {
+    case BENCH_ARGS_I:   return scan( context, in, f->format, &r->i[0] );
+    case BENCH_ARGS_II:  return scan( context, in, f->format, &r->i[0], &r->i[1] );
+    case BENCH_ARGS_III: return scan( context, in, f->format, &r->i[0], &r->i[1], &r->i[2] );
+    case BENCH_ARGS_LL:  return scan( context, in, f->format, &r->ll );
+    case BENCH_ARGS_S:   return scan( context, in, f->format, r->s[0] );
+    case BENCH_ARGS_SS:  return scan( context, in, f->format, r->s[0], r->s[1] );
+    case BENCH_ARGS_SI:  return scan( context, in, f->format, r->s[0], &r->i[0] );
+    case BENCH_ARGS_CN:  return scan( context, in, f->format, r->s[0], &r->i[0] );
+    case BENCH_ARGS_IL:  return scan( context, in, f->format, &r->i[0], &r->ll );
+    case BENCH_ARGS_H:   return scan( context, in, f->format, &r->h );
+  }
+  return -1;
+}
+
+/* Numbers are kept in range of what they are stored in, the C library saturates where VSNScanF wraps */
+static void bench_random_input( char *in, size_t size )
+{
+  static const char digits[] = "0123456789abcdefABCDEF";
+  const char *token;
+  size_t len = 0, n;
+  int count, i, k, base;
+
+  count = bench_random( ) % 8;
+  for( i = 0; i < count; i++ )
+  {
+    if( bench_random( ) % 2 )
+    {
+      base = ( bench_random( ) % 2 ) ? 10 : 22;
+      n = 1 + bench_random( ) % 4;
+      if( len + n >= size ) break;
+      for( k = 0; k < (int)n; k++ )
+        in[len++] = digits[ bench_random( ) % base ];
+    }
+    else
+    {
+      token = bench_tokens[ bench_random( ) % ( sizeof( bench_tokens ) / sizeof( bench_tokens[0] ) ) ];
+      n = strlen( token );
+      if( len + n >= size ) break;
+      memcpy( in + len, token, n );
+      len += n;
+    }
+  }
+  in[len] = 0;
+}
+
+static void bench_check_scanner( void )
+{
+  const bench_format_t *f;
+  ScanFormat compiled[ sizeof( bench_formats ) / sizeof( bench_formats[0] ) ];
+  bench_result_t a, b, c;
+  char in[ 32 ];
+  int it, k, ra, rb, rc;
+  unsigned int mismatches = 0;
+
+  for( k = 0; k < (int)( sizeof( bench_formats ) / sizeof( bench_formats[0] ) ); k++ )
+    BENCH_CHECK( ScanFormatCompile( &compiled[k], bench_formats[k].format ) == kNoErr );
+
+  for( it = 0; it < BENCH_RANDOM_CASES; it++ )
+  {
+    k = bench_random( ) % ( sizeof( bench_formats ) / sizeof( bench_formats[0] ) );
+    f = &bench_formats[k];
+    bench_random_input( in, sizeof( in ) );
+    ra = bench_scan( bench_scan_vsn, NULL, in, f, &a );
+    rb = bench_scan( bench_scan_compiled, &compiled[k], in, f, &b );
+    rc = bench_scan( bench_scan_libc, NULL, in, f, &c );
+    if( ra != rb || memcmp( &a, &b, sizeof( a ) ) != 0 || ( f->libc && ( ra != rc || memcmp( &a, &c, sizeof( a ) ) != 0 ) ) )
+    {
+      if( mismatches++ < 10 )
+        printf( "scan mismatch, format \"%s\" input \"%s\": %d %d %d\n", f->format, in, ra, rb, rc );
+    }
+  }
+  BENCH_CHECK( mismatches == 0 );
+
+  BENCH_CHECK( ScanFormatCompile( &compiled[0], "%q" ) == kFormatErr );
+  BENCH_CHECK( ScanFormatCompile( &compiled[0], "%d %d %d %d %d" ) == kSizeErr );
+}
+
+/* The pre-built formats and one put together from SCAN_OP_* read as VSNScanF does */
+static void bench_check_builtin( void )
+{
+  static const ScanFormat status = { "HTTP/%d.%d %d", 6, {
+    SCAN_OP_LITERAL( "HTTP/" ), SCAN_OP_INT( 10, 0, sizeof( int ) ), SCAN_OP_LITERAL( "." ),
+    SCAN_OP_INT( 10, 0, sizeof( int ) ), SCAN_OP_SPACE( ), SCAN_OP_INT( 10, 0, sizeof( int ) ) } };
+  static const char *const inputs[] = { "", "  42", "-17x", "+0", "ffff", "0x1F", "123456789012", "18446744073709551615",
+                                        "HTTP/1.1 200 OK", "HTTP/1.0  404", "HTTP/1.", "word rest", "\t\ttab" };
+  int a[3], b[3], ra, rb, k;
+  long long la, lb;
+  char sa[32], sb[32];
+
+  for( k = 0; k < (int)( sizeof( inputs ) / sizeof( inputs[0] ) ); k++ )
+  {
+    memset( a, 0x5a, sizeof( a ) ); memset( b, 0x5a, sizeof( b ) );
+    ra = bench_scan_vsn( NULL, inputs[k], "HTTP/%d.%d %d", &a[0], &a[1], &a[2] );
+    rb = ScanFormatApply( &status, inputs[k], kSizeCString, &b[0], &b[1], &b[2] );
+    BENCH_CHECK( ra == rb && memcmp( a, b, sizeof( a ) ) == 0 );
+
+    la = lb = 0x5a5a;
+    ra = bench_scan_vsn( NULL, inputs[k], "%llx %n", &la, &a[0] );
+    rb = ScanFormatApply( &kScanFormat_llx, inputs[k], kSizeCString, &lb );
+    BENCH_CHECK( ra == rb && la == lb );
+    la = lb = 0x5a5a;
+    ra = bench_scan_vsn( NULL, inputs[k], "%llu %n", &la, &a[0] );
+    rb = ScanFormatApply( &kScanFormat_llu, inputs[k], kSizeCString, &lb );
+    BENCH_CHECK( ra == rb && la == lb );
+    a[0] = b[0] = 0x5a5a;
+    ra = bench_scan_vsn( NULL, inputs[k], "%d %n", &a[0], &a[1] );
+    rb = ScanFormatApply( &kScanFormat_d, inputs[k], kSizeCString, &b[0] );
+    BENCH_CHECK( ra == rb && a[0] == b[0] );
+    a[0] = b[0] = 0x5a5a;
+    ra = bench_scan_vsn( NULL, inputs[k], "%x %n", &a[0], &a[1] );
+    rb = ScanFormatApply( &kScanFormat_x, inputs[k], kSizeCString, &b[0] );
+    BENCH_CHECK( ra == rb && a[0] == b[0] );
+    memset( sa, 0x5a, sizeof( sa ) ); memset( sb, 0x5a, sizeof( sb ) );
+    ra = bench_scan_vsn( NULL, inputs[k], "%s %n", sa, &a[1] );
+    rb = ScanFormatApply( &kScanFormat_s, inputs[k], kSizeCString, sb );
+    BENCH_CHECK( ra == rb && memcmp( sa, sb, sizeof( sa ) ) == 0 );
+  }
+}
+
+/* The three lookups HTTPHeaderParse did before it read the fields in one pass */
+static void bench_former_fields( const HTTPHeader_t *inHeader, bench_header_t *out )
+{
+  const char *value;
+  size_t valueSize;
+
+  if( HTTPGetHeaderField( inHeader->buf, inHeader->len, "Connection", NULL, NULL, &value, &valueSize, NULL ) )
+    out->persistent = (Boolean)( strnicmpx( inHeader->protocolPtr, inHeader->protocolLen, "HTTP/1.0" ) != 0 );
+  else
+    out->persistent = (Boolean)( strnicmpx( value, valueSize, "close" ) != 0 );
+  if( HTTPGetHeaderField( inHeader->buf, inHeader->len, "Transfer-Encoding", NULL, NULL, &value, &valueSize, NULL ) )
+    out->chunked = false;
+  else
+    out->chunked = (Boolean)( strnicmpx( value, valueSize, kTransferrEncodingType_CHUNKED ) == 0 );
+  out->contentLength = 0;
+  HTTPScanFHeaderValue( inHeader->buf, inHeader->len, "Content-Length", "%llu", &out->contentLength );
+}
+
+static void bench_load( HTTPHeader_t *ioHeader, const char *text )
+{
+  memset( ioHeader, 0, sizeof( *ioHeader ) );
+  ioHeader->len = strlen( text );
+  memcpy( ioHeader->buf, text, ioHeader->len );
+}
+
+static void bench_headers_run( void )
+{
+  static HTTPHeader_t header, start;
+  bench_header_t former;
+  const bench_header_t *h;
+  double t0, t1, t2, t3, fields, parse, line;
+  char *data;
+  uint64_t chunk;
+  int k, j, run;
+
+  printf( "\n%-16s %6s %14s %14s %14s\n", "header set", "bytes", "former fields", "fields now", "whole parse" );
+  for( k = 0; k < (int)( sizeof( bench_headers ) / sizeof( bench_headers[0] ) ); k++ )
+  {
+    h = &bench_headers[k];
+    bench_load( &header, h->header );
+    BENCH_CHECK( HTTPHeaderParse( &header ) == kNoErr );
+    BENCH_CHECK( header.persistent == h->persistent && header.chunkedData == h->chunked && header.contentLength == h->contentLength );
+    bench_former_fields( &header, &former );
+    BENCH_CHECK( former.persistent == h->persistent && former.chunked == h->chunked && former.contentLength == h->contentLength );
+
+    /* the same start line alone, for what the start line and URL cost */
+    bench_load( &start, h->header );
+    start.len = strchr( h->header, '\n' ) + 1 - h->header;
+    memcpy( start.buf + start.len, "\r\n", 2 );
+    start.len += 2;
+
+    fields = parse = line = 1e9;
+    for( run = 0; run < 5; run++ )
+    {
+      t0 = bench_time( );
+      for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+        bench_former_fields( &header, &former );
+      t1 = bench_time( );
+      for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+        HTTPHeaderParse( &header );
+      t2 = bench_time( );
+      for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+        HTTPHeaderParse( &start );
+      t3 = bench_time( );
+      fields = Min( fields, ( t1 - t0 ) / BENCH_TIMED_LOOPS );
+      parse = Min( parse, ( t2 - t1 ) / BENCH_TIMED_LOOPS );
+      line = Min( line, ( t3 - t2 ) / BENCH_TIMED_LOOPS );
+    }
+    printf( "%-16s %6u %11.0f ns %11.0f ns %11.0f ns\n", h->name, (unsigned)header.len, fields, parse - line, parse );
+  }
+
+  /* chunk sizes are hex and all 64 bits of the length are written */
+  chunk = 0x5a5a5a5a5a5a5a5aULL;
+  BENCH_CHECK( findChunkedDataLength( "1ffffffff\r\ndata", 15, &data, "%llu", &chunk ) && chunk == 0x1ffffffffULL && strcmp( data, "data" ) == 0 );
+  chunk = 0x5a5a5a5a5a5a5a5aULL;
+  BENCH_CHECK( findChunkedDataLength( "1a;ext=1\r\n", 10, &data, "%llu", &chunk ) && chunk == 0x1a );
+  chunk = 0x5a5a5a5a5a5a5a5aULL;
+  BENCH_CHECK( findChunkedDataLength( "0\r\n\r\n", 5, &data, "%llu", &chunk ) && chunk == 0 );
+  BENCH_CHECK( !findChunkedDataLength( "1a", 2, &data, "%llu", &chunk ) );
+}
+
+static void bench_speed( void )
+{
+  static const struct { const char *format; const char *in; int args; } cases[] =
+  {
+    { "%d",            "-123456",          BENCH_ARGS_I   },
+    { "%x",            "7fe3a1",           BENCH_ARGS_I   },
+    { "%llu",          "4294967301",       BENCH_ARGS_LL  },
+    { "%31s",          "keep-alive",       BENCH_ARGS_S   },
+    { "HTTP/%d.%d %d", "HTTP/1.1 200 OK",  BENCH_ARGS_III },
+    { "x=%d;y=%llx",   "x=42;y=deadbeef",  BENCH_ARGS_IL  },
+  };
+  bench_format_t f;
+  ScanFormat compiled;
+  bench_result_t r;
+  double t0, t1, t2, t3;
+  int k, j;
+
+  printf( "\n%-16s %10s %10s %10s\n", "format", "VSNScanF", "compiled", "sscanf" );
+  for( k = 0; k < (int)( sizeof( cases ) / sizeof( cases[0] ) ); k++ )
+  {
+    f.format = cases[k].format;
+    f.args = cases[k].args;
+    ScanFormatCompile( &compiled, f.format );
+    t0 = bench_time( );
+    for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+      bench_scan( bench_scan_vsn, NULL, cases[k].in, &f, &r );
+    t1 = bench_time( );
+    for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+      bench_scan( bench_scan_compiled, &compiled, cases[k].in, &f, &r );
+    t2 = bench_time( );
+    for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+      bench_scan( bench_scan_libc, NULL, cases[k].in, &f, &r );
+    t3 = bench_time( );
+    printf( "%-16s %7.0f ns %7.0f ns %7.0f ns\n", f.format, ( t1 - t0 ) / BENCH_TIMED_LOOPS,
+            ( t2 - t1 ) / BENCH_TIMED_LOOPS, ( t3 - t2 ) / BENCH_TIMED_LOOPS );
+  }
+}
+
+int main( void )
+{
+  bench_check_scanner( );
+  bench_check_builtin( );
+  printf( "scanner against VSNScanF and sscanf: %s\n", bench_failed ? "failed" : "ok" );
+
+  bench_headers_run( );
+  bench_speed( );
+
+  if( bench_failed )
+    printf( "Benchmark failed\n" );
+  return bench_failed ? 1 : 0;
+}
@@ -0,0 +1,387 @@
+/**
+******************************************************************************
+* @file    notification_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Ordering, drop accounting and latency of the notification center
+*          with slow subscribers and subscribers coming and going.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench builds MICONotificationCenter.c itself on pthread stand-ins of the MICO RTOS
+ *  API, a thread in the role of the wlan driver posts EasyLink extra data events:
+ *
+ *    gcc -O2 -std=c99 -IMICO -Iinclude -Iinclude/MicoDrivers -IPlatform/include
+ *        -IBoard/EMW3081 -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals
+ *        Platform/MCU/Host/notification_bench.c -lpthread
+ *
+ *  Include names follow the Windows tool chains, see flash_sim_bench.c.
+ *
+ *  Every event carries its sequence number. A subscriber must see them in increasing order,
+ *  never on the posting thread and never from two threads at once, and every event it
+ *  misses must be counted as an overflow. While events flow, a churn thread keeps adding
+ *  and removing a second subscriber and a third one removes itself from inside its call,
+ *  run it under -fsanitize=address to catch a node freed while it is being called.
+ *  The first case runs before MICOInitNotificationCenter, the old synchronous delivery.
+ */
+
+/* MicoSocket.h declares read, write and select itself, keep unistd.h out */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "MICONotificationCenter.c"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_EVENTS            20000
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  const char *name;
+  unsigned int interval_us;     /* between posts, 0 for back to back */
+  unsigned int subscriber_us;   /* work per call */
+  int churn;                    /* subscribers added and removed meanwhile */
+} bench_case_t;
+
+typedef struct
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int count;
+  int max;
+} bench_sem_t;
+
+typedef struct
+{
+  mico_thread_function_t function;
+  void *arg;
+} bench_thread_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static double bench_now( void );
+static void bench_spin( unsigned int us );
+static void bench_sleep( unsigned int us );
+static void bench_subscriber( int datalen, char *data, void *inContext );
+static void bench_churn_subscriber( int datalen, char *data, void *inContext );
+static void bench_self_removing( int datalen, char *data, void *inContext );
+static void *bench_churn( void *arg );
+static int bench_run( const bench_case_t *c );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const bench_case_t bench_cases[] =
+{
+  { "sync, fast",              50,    0, 0 },
+  { "sync, 200us subscriber",  50,  200, 0 },
+  { "burst, fast",              0,    0, 0 },
+  { "burst, churn",             0,    0, 1 },
+  { "20k/s, fast",             50,    0, 0 },
+  { "20k/s, 200us subscriber", 50,  200, 0 },
+  { "2k/s, 200us subscriber", 500,  200, 1 },
+};
+
+static int bench_context;
+static pthread_t bench_poster;
+static volatile int bench_churn_done;
+static unsigned int bench_subscriber_us;
+
+/* what the main subscriber saw, written by one thread at a time */
+static int bench_inside;
+static long bench_last_seq;
+static unsigned int bench_delivered;
+static unsigned int bench_errors;
+static double bench_delay_sum, bench_delay_max;
+static double bench_post_times[BENCH_EVENTS];
+static unsigned int bench_churn_calls, bench_self_calls;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+/* MICO RTOS on pthreads */
+
+OSStatus mico_rtos_init_mutex( mico_mutex_t* mutex )
+{
+  pthread_mutex_t *m = malloc( sizeof(pthread_mutex_t) );
+
+  pthread_mutex_init( m, NULL );
+  *mutex = m;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_lock_mutex( mico_mutex_t* mutex )
+{
+  pthread_mutex_lock( *mutex );
+  return kNoErr;
+}
+
+OSStatus mico_rtos_unlock_mutex( mico_mutex_t* mutex )
+{
+  pthread_mutex_unlock( *mutex );
+  return kNoErr;
+}
+
+OSStatus mico_rtos_init_semaphore( mico_semaphore_t* semaphore, int count )
+{
+  bench_sem_t *s = malloc( sizeof(bench_sem_t) );
+
+  pthread_mutex_init( &s->mutex, NULL );
+  pthread_cond_init( &s->cond, NULL );
+  s->count = 0;
+  s->max = count;
+  *semaphore = s;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_set_semaphore( mico_semaphore_t* semaphore )
+{
+  bench_sem_t *s = *semaphore;
+
+  pthread_mutex_lock( &s->mutex );
+  if( s->count < s->max )
+    s->count++;
+  pthread_cond_signal( &s->cond );
+  pthread_mutex_unlock( &s->mutex );
+  return kNoErr;
+}
+
+OSStatus mico_rtos_get_semaphore( mico_semaphore_t* semaphore, uint32_t timeout_ms )
+{
+  bench_sem_t *s = *semaphore;
+
+  (void)timeout_ms;
+  pthread_mutex_lock( &s->mutex );
+  while( s->count == 0 )
+    pthread_cond_wait( &s->cond, &s->mutex );
+  s->count--;
+  pthread_mutex_unlock( &s->mutex );
+  return kNoErr;
+}
+
+static void *bench_thread( void *arg )
+{
+  bench_thread_t t = *(bench_thread_t *)arg;
+
+  free( arg );
+  t.function( t.arg );
+  return NULL;
+}
+
+OSStatus mico_rtos_create_thread( mico_thread_t* thread, uint8_t priority, const char* name,
+                                  mico_thread_function_t function, uint32_t stack_size, void* arg )
+{
+  bench_thread_t *t = malloc( sizeof(bench_thread_t) );
+  pthread_t id;
+
+  (void)thread;
+  (void)priority;
+  (void)name;
+  (void)stack_size;
+  t->function = function;
+  t->arg = arg;
+  if( pthread_create( &id, NULL, bench_thread, t ) != 0 )
+    return kGeneralErr;
+  pthread_detach( id );
+  return kNoErr;
+}
+
+uint32_t mico_get_time( void )
+{
+  return (uint32_t)( bench_now( ) * 1000 );
+}
+
+/* Bench */
+
+static double bench_now( void )
+{
+  struct timespec t;
+
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void bench_spin( unsigned int us )
+{
+  double end = bench_now( ) + us / 1e6;
+
+  while( us && bench_now( ) < end )
+    ;
+}
+
+static void bench_sleep( unsigned int us )
+{
+  struct timespec t = { us / 1000000, ( us % 1000000 ) * 1000 };
+
+  nanosleep( &t, NULL );
+}
+
+static void bench_subscriber( int datalen, char *data, void *inContext )
+{
+  long seq = strtol( data, NULL, 10 );
+  double delay;
+
+  if( __sync_fetch_and_add( &bench_inside, 1 ) != 0 )
+    bench_errors++;
+  if( pthread_equal( pthread_self( ), bench_poster ) && notify_dispatcher_running )
+    bench_errors++;
+  if( inContext != &bench_context || datalen != (int)strlen( data ) || seq <= bench_last_seq || seq >= BENCH_EVENTS )
+    bench_errors++;
+  else{
+    delay = bench_now( ) - bench_post_times[seq];
+    bench_delay_sum += delay;
+    if( delay > bench_delay_max )
+      bench_delay_max = delay;
+    bench_last_seq = seq;
+  }
+  bench_delivered++;
+  bench_spin( bench_subscriber_us );
+  __sync_fetch_and_sub( &bench_inside, 1 );
+}
+
+static void bench_churn_subscriber( int datalen, char *data, void *inContext )
+{
+  (void)datalen;
+  (void)data;
+  (void)inContext;
+  __sync_fetch_and_add( &bench_churn_calls, 1 );
+}
+
+static void bench_self_removing( int datalen, char *data, void *inContext )
+{
+  (void)datalen;
+  (void)data;
+  (void)inContext;
+  __sync_fetch_and_add( &bench_self_calls, 1 );
+  MICORemoveNotification( mico_notify_EASYLINK_GET_EXTRA_DATA, (void *)bench_self_removing );
+}
+
+static void *bench_churn( void *arg )
+{
+  (void)arg;
+  while( bench_churn_done == 0 ){
+    MICOAddNotificationWithPriority( mico_notify_EASYLINK_GET_EXTRA_DATA, (void *)bench_churn_subscriber, 1 );
+    MICOAddNotification( mico_notify_EASYLINK_GET_EXTRA_DATA, (void *)bench_self_removing );
+    sched_yield( );
+    MICORemoveNotification( mico_notify_EASYLINK_GET_EXTRA_DATA, (void *)bench_churn_subscriber );
+  }
+  MICORemoveNotification( mico_notify_EASYLINK_GET_EXTRA_DATA, (void *)bench_self_removing );
+  return NULL;
+}
+
+static int bench_run( const bench_case_t *c )
+{
+  char data[16];
+  double post, post_max = 0, post_sum = 0, t0;
+  uint32_t overflow = notify_stats.overflow;
+  unsigned int missed, wait;
+  pthread_t churn;
+  int i;
+
+  bench_poster = pthread_self( );
+  bench_subscriber_us = c->subscriber_us;
+  bench_last_seq = -1;
+  bench_delivered = bench_errors = 0;
+  bench_delay_sum = bench_delay_max = 0;
+  bench_churn_calls = bench_self_calls = 0;
+  bench_churn_done = 0;
+  if( c->churn )
+    pthread_create( &churn, NULL, bench_churn, NULL );
+
+  for( i = 0; i < BENCH_EVENTS; i++ ){
+    sprintf( data, "%d", i );
+    t0 = bench_now( );
+    bench_post_times[i] = t0;
+    easylink_user_data_result( strlen( data ), data );
+    post = bench_now( ) - t0;
+    post_sum += post;
+    if( post > post_max )
+      post_max = post;
+    memset( data, 0xEE, sizeof(data) - 1 );    /* the center must have taken a copy */
+    bench_spin( c->interval_us );
+  }
+
+  /* let the dispatcher drain, the queue holds at most MICO_NOTIFY_QUEUE_LEN events */
+  for( wait = 0; wait < 5000 && ( notify_count || bench_inside ); wait++ )
+    bench_sleep( 1000 );
+  bench_sleep( 10000 );
+  bench_churn_done = 1;
+  if( c->churn )
+    pthread_join( churn, NULL );
+
+  missed = BENCH_EVENTS - bench_delivered;
+  if( missed != notify_stats.overflow - overflow )
+    bench_errors++;
+  if( c->churn && ( bench_churn_calls == 0 || bench_self_calls == 0 ) )
+    bench_errors++;
+  printf( "%-24s %8u %8u %11.2f %11.1f %11.1f %11.1f %7u\n", c->name, bench_delivered, missed,
+          post_sum / BENCH_EVENTS * 1e6, post_max * 1e6,
+          bench_delivered ? bench_delay_sum / bench_delivered * 1e6 : 0, bench_delay_max * 1e6, bench_errors );
+  return bench_errors;
+}
+
+int main( void )
+{
+  unsigned int i;
+  int failed = 0;
+
+  MICOAddNotification( mico_notify_EASYLINK_GET_EXTRA_DATA, (void *)bench_subscriber );
+
+  printf( "queue %d events, %d events per case\n\n", MICO_NOTIFY_QUEUE_LEN, BENCH_EVENTS );
+  printf( "%-24s %8s %8s %11s %11s %11s %11s %7s\n", "case", "called", "dropped", "post us", "max post",
+          "delay us", "max delay", "errors" );
+  for( i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++ ){
+    if( strncmp( bench_cases[i].name, "sync", 4 ) != 0 && notify_dispatcher_running == false ){
+      if( MICOInitNotificationCenter( &bench_context ) != kNoErr ){
+        printf( "MICOInitNotificationCenter failed\n" );
+        return 1;
+      }
+    }else if( i == 0 ){
+      _Context = &bench_context;
+    }
+    if( bench_run( &bench_cases[i] ) )
+      failed = 1;
+  }
+
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
@@ -0,0 +1,503 @@
+/**
+******************************************************************************
+* @file    ntp_client_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Simulated network run of the SNTP client: stand-in servers with
+*          delay, jitter, loss and a false ticker, across the clock wrap.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench builds MICONTPClient.c itself and runs its thread function against stand-in
+ *  UDP servers on a simulated network and clock, no time passes but the time the bench
+ *  hands out:
+ *
+ *    gcc -O2 -std=c99 -IMICO -Iinclude -Iinclude/MicoDrivers -IPlatform/include
+ *        -IBoard/EMW3081 -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals -ISupport
+ *        -IExternal -IDemos/COM.MXCHIP.SPP Platform/MCU/Host/ntp_client_bench.c
+ *
+ *  Include names follow the Windows tool chains, see flash_sim_bench.c.
+ *
+ *  The local clock runs off true time by a few ppm and mico_get_time wraps a minute into
+ *  every case. Each server answers from true time plus its own error, after a delay each
+ *  way with jitter, and drops some queries. While the client sleeps the bench reads
+ *  MICOGetUtcTime every 100 ms. After the first sync the time may never go back, only
+ *  the first sync may step, and the error must stay within the path asymmetry plus what
+ *  the local drift gathers over a poll interval.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <setjmp.h>
+
+#define MICO_NTP_SERVERS  "ntp1.bench", "ntp2.bench", "ntp3.bench"
+
+#include "MICONTPClient.c"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_SERVERS           3
+#define BENCH_REPLIES_MAX       16
+#define BENCH_CLOCK_START       ( 0xFFFFFFFFUL - 60000 )      /* mico_get_time wraps after a minute */
+#define BENCH_UTC_START         ( 1792368000ULL * 1000000 )   /* 19-Oct-2026, us */
+#define BENCH_SAMPLE_MS         100
+#define BENCH_PROCESSING_US     300
+
+#define HOUR                    ( 3600ULL * 1000000 )
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  int64_t error_us;             /* server time minus true time */
+  uint32_t up_us;               /* one way delays, plus up to jitter_us each */
+  uint32_t down_us;
+  uint32_t jitter_us;
+  uint32_t loss_percent;        /* 100 for a server that is down */
+} bench_server_t;
+
+typedef struct
+{
+  const char *name;
+  bench_server_t servers[BENCH_SERVERS];
+  int32_t drift_ppm;            /* local clock rate error */
+  uint64_t shift_at;            /* all servers move by shift_us from here */
+  int64_t shift_us;
+  uint64_t duration;
+  int64_t max_error_us;         /* allowed outside the slew of a shift */
+} bench_case_t;
+
+typedef struct
+{
+  uint64_t arrival;             /* true time the answer reaches the client */
+  uint32_t ip;
+  struct NtpPacket packet;
+} bench_reply_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static uint32_t bench_random( void );
+static uint64_t bench_local_us( uint64_t now );
+static void bench_advance( uint64_t local_ms, int sample );
+static void bench_sample( void );
+static int bench_run( const bench_case_t *c );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const bench_case_t bench_cases[] =
+{
+  { "3 servers, jitter",
+    { { 0, 20000, 20000, 40000, 0 }, { 0, 5000, 5000, 10000, 0 }, { 0, 60000, 60000, 80000, 5 } },
+    20, 0, 0, 12 * HOUR, 40000 },
+  { "false ticker 3 s",
+    { { 0, 20000, 20000, 40000, 0 }, { 3000000, 5000, 5000, 10000, 0 }, { 0, 60000, 60000, 80000, 0 } },
+    -20, 0, 0, 12 * HOUR, 40000 },
+  { "asymmetric 10/110 ms",
+    { { 0, 10000, 110000, 5000, 0 }, { 0, 10000, 110000, 5000, 0 }, { 0, 10000, 110000, 5000, 0 } },
+    10, 0, 0, 12 * HOUR, 50000 + 30000 },
+  { "servers shift 200 ms",
+    { { 0, 20000, 20000, 20000, 0 }, { 0, 20000, 20000, 20000, 0 }, { 0, 20000, 20000, 20000, 0 } },
+    5, 2 * HOUR, 200000, 12 * HOUR, 40000 },
+  { "one down, 30% loss",
+    { { 0, 20000, 20000, 40000, 30 }, { 0, 20000, 20000, 40000, 100 }, { 0, 30000, 30000, 40000, 30 } },
+    20, 0, 0, 12 * HOUR, 40000 },
+  { "one down, 50 ppm drift",
+    { { 0, 20000, 20000, 20000, 0 }, { 0, 5000, 5000, 5000, 100 }, { 0, 20000, 20000, 20000, 0 } },
+    50, 0, 0, 12 * HOUR, 80000 },
+};
+
+static const bench_case_t *bench_case;
+static uint64_t bench_now;      /* true us since the case started */
+static uint32_t bench_seed = 1;
+static jmp_buf bench_end;
+static bench_reply_t bench_replies[BENCH_REPLIES_MAX];
+static int bench_reply_num;
+
+static unsigned int bench_queries, bench_answers, bench_resolves, bench_rtc_sets;
+static unsigned int bench_samples, bench_backwards, bench_steps, bench_over;
+static int64_t bench_max_error;
+static uint64_t bench_last_utc, bench_last_sample, bench_synced_at;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+/* MICO RTOS, sockets and drivers on the simulated clock and network */
+
+uint32_t mico_get_time( void )
+{
+  return (uint32_t)( BENCH_CLOCK_START + bench_local_us( bench_now ) / 1000 );
+}
+
+OSStatus mico_rtos_init_mutex( mico_mutex_t* mutex )
+{
+  *mutex = (mico_mutex_t)1;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_lock_mutex( mico_mutex_t* mutex )
+{
+  (void)mutex;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_unlock_mutex( mico_mutex_t* mutex )
+{
+  (void)mutex;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_init_semaphore( mico_semaphore_t* semaphore, int count )
+{
+  (void)count;
+  *semaphore = (mico_semaphore_t)1;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_deinit_semaphore( mico_semaphore_t* semaphore )
+{
+  *semaphore = NULL;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_set_semaphore( mico_semaphore_t* semaphore )
+{
+  (void)semaphore;
+  return kNoErr;
+}
+
+/* The client waits for the next poll, the bench reads the UTC time meanwhile */
+OSStatus mico_rtos_get_semaphore( mico_semaphore_t* semaphore, uint32_t timeout_ms )
+{
+  (void)semaphore;
+  bench_advance( timeout_ms, 1 );
+  return kTimeoutErr;
+}
+
+OSStatus mico_rtos_create_thread( mico_thread_t* thread, uint8_t priority, const char* name,
+                                  mico_thread_function_t function, uint32_t stack_size, void* arg )
+{
+  (void)thread;
+  (void)priority;
+  (void)name;
+  (void)function;
+  (void)stack_size;
+  (void)arg;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_delete_thread( mico_thread_t* thread )
+{
+  (void)thread;
+  longjmp( bench_end, 2 );
+  return kNoErr;
+}
+
+OSStatus MICOAddNotification( mico_notify_types_t notify_type, void *functionAddress )
+{
+  (void)notify_type;
+  (void)functionAddress;
+  return kNoErr;
+}
+
+OSStatus MICORemoveNotification( mico_notify_types_t notify_type, void *functionAddress )
+{
+  (void)notify_type;
+  (void)functionAddress;
+  return kNoErr;
+}
+
+OSStatus MicoRandomNumberRead( void *inBuffer, int inByteCount )
+{
+  uint8_t *p = inBuffer;
+
+  while( inByteCount-- > 0 )
+    *p++ = (uint8_t)bench_random( );
+  return kNoErr;
+}
+
+OSStatus MicoRtcSetTime( mico_rtc_time_t* time )
+{
+  (void)time;
+  bench_rtc_sets++;
+  return kNoErr;
+}
+
+int socket( int domain, int type, int protocol )
+{
+  (void)domain;
+  (void)type;
+  (void)protocol;
+  return 1;
+}
+
+int bind( int sockfd, const struct sockaddr_t *addr, socklen_t addrlen )
+{
+  (void)sockfd;
+  (void)addr;
+  (void)addrlen;
+  return 0;
+}
+
+void SocketClose( int* fd )
+{
+  *fd = -1;
+}
+
+int gethostbyname( const char * name, uint8_t * addr, uint8_t addrLen )
+{
+  int i;
+
+  for( i = 0; i < BENCH_SERVERS; i++ ){
+    if( strcmp( name, _ntp_server_names[i] ) == 0 ){
+      snprintf( (char *)addr, addrLen, "10.0.0.%d", i + 1 );
+      bench_resolves++;
+      return kNoErr;
+    }
+  }
+  return kNotFoundErr;
+}
+
+uint32_t inet_addr( char *s )
+{
+  return 0x0A000000 | (uint32_t)atoi( strrchr( s, '.' ) + 1 );
+}
+
+/* A server stamps the query with its own time and answers after the way back */
+ssize_t sendto( int sockfd, const void *buf, size_t len, int flags, const struct sockaddr_t *dest_addr, socklen_t addrlen )
+{
+  const struct NtpPacket *query = buf;
+  const bench_server_t *server;
+  bench_reply_t *reply;
+  uint64_t t, ntp;
+  int index = (int)( dest_addr->s_ip & 0xFF ) - 1;
+  (void)sockfd;
+  (void)flags;
+  (void)addrlen;
+
+  bench_queries++;
+  if( index < 0 || index >= BENCH_SERVERS || dest_addr->s_port != NTP_Port || len != sizeof(struct NtpPacket) )
+    return len;
+  server = &bench_case->servers[index];
+  if( bench_random( ) % 100 < server->loss_percent || bench_reply_num == BENCH_REPLIES_MAX )
+    return len;
+
+  reply = &bench_replies[bench_reply_num++];
+  memset( reply, 0x0, sizeof(bench_reply_t) );
+  reply->ip = dest_addr->s_ip;
+  reply->packet.flags = 0x24;           /* NTPv4, server */
+  reply->packet.stratum = 2;
+  reply->packet.origin_ts_sec = query->trans_ts_sec;
+  reply->packet.origin_ts_frac = query->trans_ts_frac;
+
+  t = bench_now + server->up_us + bench_random( ) % ( server->jitter_us + 1 );
+  ntp = BENCH_UTC_START + t + server->error_us + ( t >= bench_case->shift_at && bench_case->shift_at ? bench_case->shift_us : 0 );
+  ntp += (uint64_t)UNIX_OFFSET * 1000000;
+  reply->packet.recv_ts_sec = htonl( (uint32_t)( ntp / 1000000 ) );
+  reply->packet.recv_ts_frac = htonl( (uint32_t)( ( ntp % 1000000 << 32 ) / 1000000 ) );
+  ntp += BENCH_PROCESSING_US;
+  reply->packet.trans_ts_sec = htonl( (uint32_t)( ntp / 1000000 ) );
+  reply->packet.trans_ts_frac = htonl( (uint32_t)( ( ntp % 1000000 << 32 ) / 1000000 ) );
+  reply->arrival = t + BENCH_PROCESSING_US + server->down_us + bench_random( ) % ( server->jitter_us + 1 );
+  return len;
+}
+
+static int bench_first_reply( void )
+{
+  int i, first = -1;
+
+  for( i = 0; i < bench_reply_num; i++ )
+    if( first < 0 || bench_replies[i].arrival < bench_replies[first].arrival )
+      first = i;
+  return first;
+}
+
+int select( int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval_t *timeout )
+{
+  uint64_t local = bench_local_us( bench_now ) + (uint64_t)timeout->tv_sec * 1000000 + timeout->tv_usec;
+  int first = bench_first_reply( );
+  (void)nfds;
+  (void)writefds;
+  (void)exceptfds;
+
+  if( first >= 0 && bench_local_us( bench_replies[first].arrival ) <= local ){
+    if( bench_replies[first].arrival > bench_now )
+      bench_now = bench_replies[first].arrival;
+    return 1;
+  }
+  bench_advance( ( local - bench_local_us( bench_now ) ) / 1000, 0 );
+  FD_ZERO( readfds );
+  return 0;
+}
+
+ssize_t recvfrom( int sockfd, void *buf, size_t len, int flags, struct sockaddr_t *src_addr, socklen_t *addrlen )
+{
+  int first = bench_first_reply( );
+  (void)sockfd;
+  (void)flags;
+  (void)addrlen;
+
+  if( first < 0 || bench_replies[first].arrival > bench_now || len < sizeof(struct NtpPacket) )
+    return -1;
+  memcpy( buf, &bench_replies[first].packet, sizeof(struct NtpPacket) );
+  src_addr->s_ip = bench_replies[first].ip;
+  src_addr->s_port = NTP_Port;
+  bench_replies[first] = bench_replies[--bench_reply_num];
+  bench_answers++;
+  return sizeof(struct NtpPacket);
+}
+
+/* Bench */
+
+static uint32_t bench_random( void )
+{
+  bench_seed = bench_seed * 1103515245 + 12345;
+  return ( bench_seed >> 8 ) & 0xFFFFFF;
+}
+
+static uint64_t bench_local_us( uint64_t now )
+{
+  return now + (int64_t)now * bench_case->drift_ppm / 1000000;
+}
+
+/* Let local_ms pass on the local clock, answers that arrive meanwhile stay queued */
+static void bench_advance( uint64_t local_ms, int sample )
+{
+  uint64_t until = bench_local_us( bench_now ) + local_ms * 1000;
+
+  while( bench_local_us( bench_now ) < until ){
+    bench_now += BENCH_SAMPLE_MS * 1000;
+    if( bench_local_us( bench_now ) > until )
+      bench_now -= ( bench_local_us( bench_now ) - until ) * 1000000 / ( 1000000 + bench_case->drift_ppm );
+    if( sample )
+      bench_sample( );
+  }
+  if( bench_now >= bench_case->duration )
+    longjmp( bench_end, 1 );
+}
+
+static void bench_sample( void )
+{
+  uint64_t utc, truth;
+  int64_t error, allowed;
+
+  if( MICOGetUtcTime( &utc ) != kNoErr )
+    return;
+  if( bench_synced_at == 0 )
+    bench_synced_at = bench_now;
+  truth = ( BENCH_UTC_START + bench_now + ( bench_case->shift_at && bench_now >= bench_case->shift_at ? bench_case->shift_us : 0 ) ) / 1000;
+  error = (int64_t)( utc - truth ) * 1000;
+  bench_samples++;
+  if( utc < bench_last_utc )
+    bench_backwards++;
+  /* slewing moves the time by 0.05 ms per 100 ms, anything more is a step */
+  if( bench_last_utc && _ntp_abs( (int64_t)( utc - bench_last_utc ) - (int64_t)( bench_now - bench_last_sample ) / 1000 ) > 5 )
+    bench_steps++;
+  bench_last_utc = utc;
+  bench_last_sample = bench_now;
+
+  /* a shift is slewed at NTP_SLEW_RATE once the next poll, at most NTP_POLL_MAX later, sees it */
+  allowed = bench_case->max_error_us;
+  if( bench_case->shift_at && bench_now >= bench_case->shift_at &&
+      bench_now < bench_case->shift_at + ( NTP_POLL_MAX + (uint64_t)_ntp_abs( bench_case->shift_us ) * 1000 / NTP_SLEW_RATE ) * 1000 )
+    allowed += _ntp_abs( bench_case->shift_us );
+  if( _ntp_abs( error ) > allowed )
+    bench_over++;
+  if( _ntp_abs( error ) > bench_max_error && ( bench_case->shift_at == 0 || bench_now < bench_case->shift_at ) )
+    bench_max_error = _ntp_abs( error );
+}
+
+static int bench_run( const bench_case_t *c )
+{
+  struct timespec t0, t1;
+  unsigned int errors = 0;
+  double cpu;
+  int ended;
+
+  bench_case = c;
+  bench_now = 0;
+  bench_reply_num = 0;
+  bench_queries = bench_answers = bench_resolves = bench_rtc_sets = 0;
+  bench_samples = bench_backwards = bench_steps = bench_over = 0;
+  bench_max_error = 0;
+  bench_last_utc = bench_last_sample = 0;
+  bench_synced_at = 0;
+
+  /* a fresh boot, already connected to the AP */
+  _ntp_valid = false;
+  _mono_last = 0;
+  _mono_high = 0;
+  _slew_start = 0;
+  _slew_from = _slew_to = 0;
+  _wifiConnected = true;
+  MICOStartNTPClient( NULL );
+
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &t0 );
+  ended = setjmp( bench_end );
+  if( ended == 0 )
+    NTPClient_thread( NULL );
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &t1 );
+  cpu = ( t1.tv_sec - t0.tv_sec ) + ( t1.tv_nsec - t0.tv_nsec ) / 1e9;
+
+  if( ended != 1 || bench_synced_at == 0 || bench_synced_at > 10 * 1000000ULL )
+    errors++;
+  if( bench_backwards || bench_steps || bench_over )
+    errors++;
+
+  printf( "%-24s %7u %7u %7u %6u %7.1f %7.1f %8u %5u %5u %5u %8.1f\n", c->name, bench_queries, bench_answers,
+          bench_resolves, bench_rtc_sets, bench_synced_at / 1e6, bench_max_error / 1000.0, bench_samples,
+          bench_backwards, bench_steps, bench_over, bench_rtc_sets ? cpu / bench_rtc_sets * 1e6 : 0 );
+  return errors;
+}
+
+int main( void )
+{
+  unsigned int i;
+  int failed = 0;
+
+  printf( "poll %d..%d s, slew %d ppm, step above %d ms\n\n", NTP_POLL_MIN / 1000, NTP_POLL_MAX / 1000,
+          NTP_SLEW_RATE, NTP_STEP_THRESHOLD / 1000 );
+  printf( "%-24s %7s %7s %7s %6s %7s %7s %8s %5s %5s %5s %8s\n", "case", "queries", "answers", "resolve",
+          "syncs", "sync s", "err ms", "samples", "back", "step", "over", "us/sync" );
+  for( i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++ )
+    if( bench_run( &bench_cases[i] ) )
+      failed = 1;
+
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
@@ -0,0 +1,275 @@
+/**
+******************************************************************************
+* @file    oled_bench.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Benchmark of the MiCOKit-EXT OLED driver on a mock SPI port: transfers,
+*          bytes and port setups per redraw, checked against a SSD1106 RAM model.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench is the board of the OLED driver: pin and SPI tables and GPIO, to follow the D/C
+ *  line. The EMW3081 board has no Arduino
+ *  header, so its pins are given on the command line:
+ *
+ *    gcc -O2 -DNO_MICO_RTOS -DUSE_MiCOKit_EXT -DArduino_SPI=MICO_SPI_1 -DArduino_SCK=MICO_GPIO_1
+ *        -DArduino_SI=MICO_GPIO_2 -DArduino_SO=MICO_GPIO_3 -DArduino_CS=MICO_GPIO_4
+ *        -ffunction-sections -fdata-sections -Wl,--gc-sections
+ *        -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals -IBoard/EMW3081 -IPlatform/include
+ *        -Iinclude -Iinclude/MicoDrivers -IPlatform/Drivers/MiCOKit_EXT -IPlatform/Drivers/MiCOKit_EXT/lcd
+ *        Platform/MCU/Host/oled_bench.c Platform/MCU/Host/platform_init.c
+ *        Platform/MCU/Host/peripherals/platform_spi.c Platform/MCU/Host/peripherals/platform_flash.c
+ *        Platform/MCU/mico_platform_common.c oled.o
+ *
+ *  where oled.o is Platform/Drivers/MiCOKit_EXT/lcd/oled.c built with the same flags plus -std=c99,
+ *  as MICO.h brings in the socket API that clashes with the host fd_set. Include names follow the
+ *  Windows tool chains, see flash_sim_bench.c. All times are virtual.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MICOPlatform.h"
+#include "platform_peripheral.h"
+#include "oled.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_XFER_OVERHEAD_NS  (2000)        /* Chip select and DMA setup of one transfer */
+#define BENCH_PANEL_PAGES       (8)
+#define BENCH_PANEL_COLUMNS     (132)         /* SH1106 RAM, the 128 visible columns start at 2 */
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  uint8_t                   ram[BENCH_PANEL_PAGES][BENCH_PANEL_COLUMNS];
+  uint8_t                   page;
+  uint8_t                   column;
+  uint8_t                   argument;     /* Bytes still owed to the last command */
+  uint8_t                   dc;           /* D/C line, high for data */
+  uint32_t                  commands;
+  uint32_t                  data_bytes;
+  uint32_t                  overruns;     /* Data clocked past the last column */
+} bench_panel_t;
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+static void bench_panel_frame( const uint8_t* frame, uint8_t* response, uint32_t length );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+const platform_gpio_t platform_gpio_pins[MICO_GPIO_MAX];
+
+const platform_spi_t platform_spi_peripherals[MICO_SPI_MAX] =
+{
+  [OLED_SPI_PORT] = { .transfer_overhead_ns = BENCH_XFER_OVERHEAD_NS, .device = bench_panel_frame },
+};
+
+platform_spi_driver_t platform_spi_drivers[MICO_SPI_MAX];
+
+static bench_panel_t bench_panel;
+
+static const char* bench_screen[4] =
+{
+  "MiCOKit-3288    ",
+  "Temp: 25.3 C    ",
+  "Hum:  40 %      ",
+  "Light: 1280 lux ",
+};
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+OSStatus platform_gpio_init( const platform_gpio_t* gpio, platform_pin_config_t config )
+{
+  UNUSED_PARAMETER( gpio );
+  UNUSED_PARAMETER( config );
+  return kNoErr;
+}
+
+OSStatus platform_gpio_output_high( const platform_gpio_t* gpio )
+{
+  if( gpio == &platform_gpio_pins[OLED_SPI_DC] )
+    bench_panel.dc = 1;
+  return kNoErr;
+}
+
+OSStatus platform_gpio_output_low( const platform_gpio_t* gpio )
+{
+  if( gpio == &platform_gpio_pins[OLED_SPI_DC] )
+    bench_panel.dc = 0;
+  return kNoErr;
+}
+
+/* SH1106/SSD1306 in page addressing mode: commands move the RAM pointer, data fills it */
+static void bench_panel_frame( const uint8_t* frame, uint8_t* response, uint32_t length )
+{
+  bench_panel_t *panel = &bench_panel;
+  uint32_t i;
+  uint8_t b;
+
+  memset( response, 0xFF, length );
+  for( i = 0; i < length; i++ ){
+    b = frame[i];
+    if( panel->dc ){
+      if( panel->column < BENCH_PANEL_COLUMNS )
+        panel->ram[panel->page][panel->column++] = b;
+      else
+        panel->overruns++;
+      panel->data_bytes++;
+      continue;
+    }
+    panel->commands++;
+    if( panel->argument ){
+      panel->argument--;
+      continue;
+    }
+    if( b <= 0x0F )
+      panel->column = ( panel->column & 0xF0 ) | b;
+    else if( b <= 0x1F )
+      panel->column = (uint8_t)( ( panel->column & 0x0F ) | ( ( b & 0x0F ) << 4 ) );
+    else if( b >= 0xB0 && b <= 0xB7 )
+      panel->page = b - 0xB0;
+    else if( b == 0x20 || b == 0x81 || b == 0x8D || b == 0xA8 || b == 0xAD || b == 0xD3 ||
+             b == 0xD5 || b == 0xD9 || b == 0xDA || b == 0xDB )
+      panel->argument = 1;
+  }
+}
+
+static uint32_t bench_panel_hash( void )
+{
+  uint32_t hash = 2166136261u;
+  const uint8_t *p = &bench_panel.ram[0][0];
+  uint32_t i;
+
+  for( i = 0; i < sizeof(bench_panel.ram); i++ )
+    hash = ( hash ^ p[i] ) * 16777619u;
+  return hash;
+}
+
+static void bench_begin( void )
+{
+  platform_spi_sim_reset_stats( &platform_spi_peripherals[OLED_SPI_PORT] );
+  bench_panel.commands = bench_panel.data_bytes = 0;
+}
+
+static void bench_report( const char* name )
+{
+  platform_spi_sim_stats_t st;
+
+  memset( &st, 0, sizeof(st) );
+  platform_spi_sim_get_stats( &platform_spi_peripherals[OLED_SPI_PORT], &st );
+  printf( "%-16s %6lu transfers %6lu bytes (%5lu cmd %5lu data) %6lu port setups %8.1f us bus, panel %08lx\n",
+          name, (unsigned long)st.transfers, (unsigned long)st.bytes, (unsigned long)bench_panel.commands,
+          (unsigned long)bench_panel.data_bytes, (unsigned long)st.inits, st.bus_ns / 1000.0,
+          (unsigned long)bench_panel_hash( ) );
+}
+
+static void bench_show_screen( void )
+{
+  int row;
+
+  for( row = 0; row < 4; row++ )
+    OLED_ShowString( OLED_DISPLAY_COLUMN_START, OLED_DISPLAY_ROW_1 + 2 * row, (u8 *)bench_screen[row] );
+}
+
+/* Pixel (x, y) of the driver lands in RAM column x + 1, see OLED_Set_Pos */
+static int bench_pixel( u8 x, u8 y )
+{
+  return ( bench_panel.ram[y / 8][x + 1] >> ( y % 8 ) ) & 1;
+}
+
+int main( void )
+{
+  static u8 bitmap[8 * 128];
+  uint32_t i;
+  u8 x, y;
+  int err = 0;
+
+  for( i = 0; i < sizeof(bitmap); i++ )
+    bitmap[i] = (u8)( i * 2654435761u >> 24 );
+
+  bench_begin( );
+  OLED_Init( );
+  bench_report( "init" );
+
+  bench_begin( );
+  bench_show_screen( );
+  bench_report( "4 text rows" );
+
+  bench_begin( );
+  OLED_ShowString( OLED_DISPLAY_COLUMN_START, OLED_DISPLAY_ROW_2, (u8 *)"Temp: 25.4 C    " );
+  bench_report( "one digit" );
+
+  bench_begin( );
+  OLED_ShowString( OLED_DISPLAY_COLUMN_START, OLED_DISPLAY_ROW_2, (u8 *)"Temp: 25.4 C    " );
+  bench_report( "same text" );
+
+  bench_begin( );
+  OLED_ShowNum( 48, OLED_DISPLAY_ROW_4, 4095, 4, 16 );
+  bench_report( "number" );
+
+  bench_begin( );
+  OLED_DrawBMP( 0, 0, 128, 8, bitmap );
+  bench_report( "bitmap 128x64" );
+
+  bench_begin( );
+  OLED_Clear( );
+  bench_report( "clear" );
+
+  /* Points and fills stay in the frame buffer until refreshed */
+  bench_begin( );
+  OLED_Fill( 10, 20, 29, 43, 1 );
+  OLED_DrawPoint( 10, 20, 0 );
+  OLED_DrawPoint( 100, 63, 1 );
+  OLED_Refresh_Gram( );
+  bench_report( "fill + points" );
+  for( x = 0; x < 128; x++ ){
+    for( y = 0; y < 64; y++ ){
+      int expected = ( x >= 10 && x <= 29 && y >= 20 && y <= 43 && !( x == 10 && y == 20 ) ) || ( x == 100 && y == 63 );
+      if( bench_pixel( x, y ) != expected && err == 0 ){
+        printf( "Pixel %u,%u is %d\n", x, y, bench_pixel( x, y ) );
+        err = kGeneralErr;
+      }
+    }
+  }
+
+  if( bench_panel.overruns )
+    err = kGeneralErr;
+  if( err != 0 )
+    printf( "Benchmark failed, err = %d\n", err );
+  return err == 0 ? 0 : 1;
+}
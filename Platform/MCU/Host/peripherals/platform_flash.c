@@ -0,0 +1,381 @@
+/**
+******************************************************************************
+* @file    platform_flash.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Flash simulator of the host platform: NOR semantics over a file or RAM
+*          image, a latency model from a device profile and erase counters.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#define sleep posix_sleep   /* MicoRtos.h declares its own sleep() */
+#include <unistd.h>
+#undef sleep
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MICOPlatform.h"
+#include "MICORTOS.h"
+
+#include "PlatformLogging.h"
+#include "platform_peripheral.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  const platform_flash_t*     peripheral;
+  uint8_t*                    image;
+  int                         fd;             /* -1 when the image is in RAM */
+  uint32_t*                   erase_count;    /* One counter per sector */
+  uint32_t                    sector_num;
+  platform_flash_sim_stats_t  stats;
+} flash_sim_t;
+
+/* Private define ------------------------------------------------------------*/
+#define FLASH_SIM_MAX_DEVICES   (3)
+
+/* Private macro -------------------------------------------------------------*/
+#define flash_sim_log(M, ...) custom_log("FLASH SIM", M, ##__VA_ARGS__)
+
+/* Private variables ---------------------------------------------------------*/
+static flash_sim_t flash_sims[FLASH_SIM_MAX_DEVICES];
+
+/* MX25L1606E class serial NOR, typical values at 50MHz single SPI */
+const platform_flash_profile_t platform_flash_profile_spi_nor =
+{
+  .name                 = "SPI NOR 4KB sector",
+  .sector_size          = 0x1000,
+  .page_size            = 256,
+  .sector_erase_us      = 60000,
+  .block_erase_us       = 700000,
+  .page_program_us      = 1400,
+  .program_setup_us     = 10,
+  .read_ns_per_byte     = 160,
+  .endurance            = 100000,
+};
+
+/* STM32F4 class internal flash programmed by 32-bit words, 128KB main sectors */
+const platform_flash_profile_t platform_flash_profile_embedded =
+{
+  .name                 = "Embedded 128KB sector",
+  .sector_size          = 0x20000,
+  .page_size            = 4,
+  .sector_erase_us      = 1000000,
+  .block_erase_us       = 0,
+  .page_program_us      = 16,
+  .program_setup_us     = 0,
+  .read_ns_per_byte     = 1,
+  .endurance            = 10000,
+};
+
+/* Private function prototypes -----------------------------------------------*/
+
+static flash_sim_t* flash_sim_find( const platform_flash_t *peripheral )
+{
+  int i;
+
+  for( i = 0; i < FLASH_SIM_MAX_DEVICES; i++ ){
+    if( flash_sims[i].peripheral == peripheral )
+      return &flash_sims[i];
+  }
+  return NULL;
+}
+
+static OSStatus flash_sim_open( flash_sim_t *sim, const platform_flash_t *peripheral )
+{
+  OSStatus err = kNoErr;
+  struct stat st;
+  off_t old_size = 0;
+
+  sim->fd = -1;
+  sim->sector_num = ( peripheral->flash_length + peripheral->profile->sector_size - 1 ) / peripheral->profile->sector_size;
+  sim->erase_count = calloc( sim->sector_num, sizeof(uint32_t) );
+  require_action( sim->erase_count, exit, err = kNoMemoryErr );
+
+  if( peripheral->image_path == NULL || peripheral->image_path[0] == '\0' ){
+    sim->image = malloc( peripheral->flash_length );
+    require_action( sim->image, exit, err = kNoMemoryErr );
+    memset( sim->image, 0xFF, peripheral->flash_length );
+  }
+  else{
+    sim->fd = open( peripheral->image_path, O_RDWR | O_CREAT, 0644 );
+    require_action( sim->fd >= 0, exit, err = kOpenErr );
+    require_action( fstat( sim->fd, &st ) == 0, exit, err = kReadErr );
+    old_size = st.st_size;
+    if( old_size < (off_t)peripheral->flash_length )
+      require_action( ftruncate( sim->fd, peripheral->flash_length ) == 0, exit, err = kWriteErr );
+    sim->image = mmap( NULL, peripheral->flash_length, PROT_READ | PROT_WRITE, MAP_SHARED, sim->fd, 0 );
+    require_action( sim->image != MAP_FAILED, exit, sim->image = NULL; err = kNoResourcesErr );
+    /* A new or grown image starts erased */
+    if( old_size < (off_t)peripheral->flash_length )
+      memset( sim->image + old_size, 0xFF, peripheral->flash_length - old_size );
+  }
+  sim->peripheral = peripheral;
+  flash_sim_log( "%s: %u bytes at 0x%08x, %s", peripheral->profile->name, (unsigned)peripheral->flash_length,
+                 (unsigned)peripheral->flash_start_addr, sim->fd >= 0 ? peripheral->image_path : "RAM image" );
+
+exit:
+  if( err != kNoErr ){
+    if( sim->fd >= 0 ) close( sim->fd );
+    if( sim->erase_count ) free( sim->erase_count );
+    memset( sim, 0, sizeof(flash_sim_t) );
+  }
+  return err;
+}
+
+/* Account the modelled time of one operation, and spend it when the device runs in real time */
+static void flash_sim_busy( flash_sim_t *sim, uint64_t *category, uint64_t ns )
+{
+  *category += ns;
+  sim->stats.busy_ns += ns;
+  if( sim->peripheral->sim_options & FLASH_SIM_OPT_REALTIME )
+    usleep( (useconds_t)( ns / 1000 ) );
+}
+
+static bool flash_sim_readonly( const platform_flash_t *peripheral, uint32_t start, uint32_t end )
+{
+  uint32_t ro_start = peripheral->flash_readonly_start;
+  uint32_t ro_end = peripheral->flash_readonly_start + peripheral->flash_readonly_len;
+
+  return ( peripheral->flash_readonly_len != 0 ) && ( start < ro_end ) && ( end > ro_start );
+}
+
+/* Program one chunk that does not cross a page: bits can only be cleared */
+static OSStatus flash_sim_program( flash_sim_t *sim, uint32_t address, const uint8_t *data, uint32_t length )
+{
+  const platform_flash_t *peripheral = sim->peripheral;
+  const platform_flash_profile_t *profile = peripheral->profile;
+  uint8_t *cell = sim->image + ( address - peripheral->flash_start_addr );
+  uint8_t raised = 0;
+  uint32_t i;
+
+  for( i = 0; i < length; i++ )
+    raised |= data[i] & ~cell[i];
+  if( raised ){
+    sim->stats.program_violations++;
+    if( peripheral->sim_options & FLASH_SIM_OPT_STRICT )
+      return kWriteErr;
+  }
+  for( i = 0; i < length; i++ )
+    cell[i] &= data[i];
+
+  sim->stats.program_commands++;
+  sim->stats.bytes_programmed += length;
+  flash_sim_busy( sim, &sim->stats.program_ns,
+                  (uint64_t)profile->program_setup_us * 1000 +
+                  ( (uint64_t)profile->page_program_us * 1000 * length + profile->page_size - 1 ) / profile->page_size );
+  return kNoErr;
+}
+
+OSStatus platform_flash_init( const platform_flash_t *peripheral )
+{
+  OSStatus err = kNoErr;
+  flash_sim_t *sim;
+
+  require_action_quiet( peripheral != NULL, exit, err = kParamErr);
+  require_action_quiet( peripheral->profile != NULL, exit, err = kParamErr);
+  require_action_quiet( peripheral->profile->sector_size && peripheral->profile->page_size, exit, err = kParamErr);
+
+  if( flash_sim_find( peripheral ) != NULL )
+    goto exit;
+  sim = flash_sim_find( NULL );
+  require_action( sim, exit, err = kNoResourcesErr );
+  err = flash_sim_open( sim, peripheral );
+
+exit:
+  return err;
+}
+
+OSStatus platform_flash_erase( const platform_flash_t *peripheral, uint32_t start_address, uint32_t end_address )
+{
+  OSStatus err = kNoErr;
+  flash_sim_t *sim;
+  uint32_t sector_size, sector, sector_end, addr;
+
+  require_action_quiet( peripheral != NULL, exit, err = kParamErr);
+  require_action_quiet( end_address >= start_address, exit, err = kParamErr);
+  require_action( start_address >= peripheral->flash_start_addr 
+               && end_address   <= peripheral->flash_start_addr + peripheral->flash_length - 1, exit, err = kParamErr);
+  sim = flash_sim_find( peripheral );
+  require_action( sim, exit, err = kNotInitializedErr );
+
+  /* Every sector touched by the range is erased, as the hardware does */
+  sector_size = peripheral->profile->sector_size;
+  sector = ( start_address - peripheral->flash_start_addr ) / sector_size;
+  sector_end = ( end_address - peripheral->flash_start_addr ) / sector_size;
+  for( ; sector <= sector_end; sector++ ){
+    addr = peripheral->flash_start_addr + sector * sector_size;
+    if( flash_sim_readonly( peripheral, addr, addr + sector_size ) ){
+      sim->stats.readonly_skips++;
+      continue;
+    }
+    memset( sim->image + sector * sector_size, 0xFF, Min( sector_size, peripheral->flash_length - sector * sector_size ) );
+    if( ++sim->erase_count[sector] > sim->stats.max_sector_erases )
+      sim->stats.max_sector_erases = sim->erase_count[sector];
+    if( sim->erase_count[sector] == peripheral->profile->endurance + 1 )
+      sim->stats.worn_sectors++;
+    sim->stats.sector_erases++;
+    flash_sim_busy( sim, &sim->stats.erase_ns, (uint64_t)peripheral->profile->sector_erase_us * 1000 );
+  }
+
+exit:
+  return err;
+}
+
+OSStatus platform_flash_write( const platform_flash_t *peripheral, volatile uint32_t* start_address, uint8_t* data ,uint32_t length  )
+{
+  OSStatus err = kNoErr;
+  flash_sim_t *sim;
+  uint32_t addr, end, chunk, page_size;
+
+  require_action_quiet( peripheral != NULL, exit, err = kParamErr);
+  require_action( *start_address >= peripheral->flash_start_addr 
+               && *start_address + length <= peripheral->flash_start_addr + peripheral->flash_length, exit, err = kParamErr);
+  sim = flash_sim_find( peripheral );
+  require_action( sim, exit, err = kNotInitializedErr );
+
+  /* Split at page boundaries, bytes in the read-only range are skipped like on the target */
+  page_size = peripheral->profile->page_size;
+  addr = *start_address;
+  end = addr + length;
+  while( addr < end ){
+    chunk = Min( end - addr, page_size - ( addr - peripheral->flash_start_addr ) % page_size );
+    if( flash_sim_readonly( peripheral, addr, addr + chunk ) )
+      sim->stats.readonly_skips += chunk;
+    else{
+      err = flash_sim_program( sim, addr, data, chunk );
+      require_noerr( err, exit );
+    }
+    addr += chunk;
+    data += chunk;
+  }
+  *start_address += length;
+
+exit:
+  return err;
+}
+
+OSStatus platform_flash_read( const platform_flash_t *peripheral, volatile uint32_t* start_address, uint8_t* data ,uint32_t length  )
+{
+  OSStatus err = kNoErr;
+  flash_sim_t *sim;
+
+  require_action_quiet( peripheral != NULL, exit, err = kParamErr);
+  require_action( (*start_address >= peripheral->flash_start_addr) 
+               && (*start_address + length) <= ( peripheral->flash_start_addr + peripheral->flash_length), exit, err = kParamErr);
+  sim = flash_sim_find( peripheral );
+  require_action( sim, exit, err = kNotInitializedErr );
+
+  memcpy( data, sim->image + ( *start_address - peripheral->flash_start_addr ), length );
+  sim->stats.bytes_read += length;
+  flash_sim_busy( sim, &sim->stats.read_ns, (uint64_t)peripheral->profile->read_ns_per_byte * length );
+  *start_address += length;
+
+exit:
+  return err;
+}
+
+OSStatus platform_flash_enable_protect( const platform_flash_t *peripheral, uint32_t start_address, uint32_t end_address )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( peripheral != NULL, exit, err = kParamErr);
+  require_action( start_address >= peripheral->flash_start_addr 
+               && end_address   <= peripheral->flash_start_addr + peripheral->flash_length - 1, exit, err = kParamErr);
+
+exit:
+  return err;  
+}
+
+OSStatus platform_flash_disable_protect( const platform_flash_t *peripheral, uint32_t start_address, uint32_t end_address )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( peripheral != NULL, exit, err = kParamErr);
+  require_action( start_address >= peripheral->flash_start_addr 
+               && end_address   <= peripheral->flash_start_addr + peripheral->flash_length - 1, exit, err = kParamErr);
+
+exit:
+  return err;  
+}
+
+OSStatus platform_flash_sim_get_stats( const platform_flash_t* peripheral, platform_flash_sim_stats_t* stats )
+{
+  flash_sim_t *sim = flash_sim_find( peripheral );
+
+  if( sim == NULL )
+    return kNotInitializedErr;
+  *stats = sim->stats;
+  return kNoErr;
+}
+
+/* Clears the operation counters, sector erase counts are kept as they describe the image */
+void platform_flash_sim_reset_stats( const platform_flash_t* peripheral )
+{
+  flash_sim_t *sim = flash_sim_find( peripheral );
+  uint32_t max_erases = 0, worn = 0, i;
+
+  if( sim == NULL )
+    return;
+  for( i = 0; i < sim->sector_num; i++ ){
+    max_erases = Max( max_erases, sim->erase_count[i] );
+    if( sim->erase_count[i] > peripheral->profile->endurance )
+      worn++;
+  }
+  memset( &sim->stats, 0, sizeof(platform_flash_sim_stats_t) );
+  sim->stats.max_sector_erases = max_erases;
+  sim->stats.worn_sectors = worn;
+}
+
+uint32_t platform_flash_sim_erase_count( const platform_flash_t* peripheral, uint32_t address )
+{
+  flash_sim_t *sim = flash_sim_find( peripheral );
+
+  if( sim == NULL || address < peripheral->flash_start_addr
+     || address >= peripheral->flash_start_addr + peripheral->flash_length )
+    return 0;
+  return sim->erase_count[ ( address - peripheral->flash_start_addr ) / peripheral->profile->sector_size ];
+}
+
+void platform_flash_sim_deinit( const platform_flash_t* peripheral )
+{
+  flash_sim_t *sim = flash_sim_find( peripheral );
+
+  if( sim == NULL )
+    return;
+  if( sim->fd >= 0 ){
+    msync( sim->image, peripheral->flash_length, MS_SYNC );
+    munmap( sim->image, peripheral->flash_length );
+    close( sim->fd );
+  }
+  else
+    free( sim->image );
+  free( sim->erase_count );
+  memset( sim, 0, sizeof(flash_sim_t) );
+}
@@ -0,0 +1,254 @@
+/**
+******************************************************************************
+* @file    platform_i2c.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   I2C port of the host platform with a register file device behind it,
+*          bus time is charged to the virtual clock.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "MICOPlatform.h"
+#include "MICORTOS.h"
+
+#include "PlatformLogging.h"
+#include "platform_peripheral.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  const platform_i2c_t*       peripheral;
+  uint8_t                     pointer;        /* Register pointer, auto incremented and kept between messages */
+  platform_i2c_sim_stats_t    stats;
+} i2c_sim_t;
+
+/* Private define ------------------------------------------------------------*/
+#define I2C_SIM_MAX_DEVICES     (2)
+#define I2C_BITS_PER_BYTE       (9)           /* Eight data bits and the acknowledge */
+
+/* Private variables ---------------------------------------------------------*/
+static i2c_sim_t i2c_sims[I2C_SIM_MAX_DEVICES];
+
+/* Private function prototypes -----------------------------------------------*/
+
+static i2c_sim_t* i2c_sim_find( const platform_i2c_t *peripheral )
+{
+  int i;
+
+  for( i = 0; i < I2C_SIM_MAX_DEVICES; i++ ){
+    if( i2c_sims[i].peripheral == peripheral )
+      return &i2c_sims[i];
+  }
+  return NULL;
+}
+
+static uint32_t i2c_speed_hz( const platform_i2c_config_t* config )
+{
+  switch( config->speed_mode ){
+    case I2C_LOW_SPEED_MODE:
+      return 10000;
+    case I2C_HIGH_SPEED_MODE:
+      return 400000;
+    default:
+      return 100000;
+  }
+}
+
+/* Start and address byte of every direction, then the data bytes and the stop */
+static void i2c_charge_bus( i2c_sim_t *sim, const platform_i2c_config_t* config, uint32_t starts, uint32_t bytes )
+{
+  uint64_t bits = (uint64_t)starts * ( 1 + I2C_BITS_PER_BYTE ) + (uint64_t)bytes * I2C_BITS_PER_BYTE + 1;
+  uint64_t bus_ns = bits * 1000000000 / i2c_speed_hz( config );
+
+  platform_nanosecond_delay( bus_ns );
+  sim->stats.bus_ns += bus_ns;
+}
+
+static bool i2c_acknowledged( const platform_i2c_t* i2c, const platform_i2c_config_t* config )
+{
+  return i2c->registers != NULL && config->address == i2c->address;
+}
+
+OSStatus platform_i2c_init( const platform_i2c_t* i2c, const platform_i2c_config_t* config )
+{
+  OSStatus err = kNoErr;
+  i2c_sim_t *sim;
+
+  UNUSED_PARAMETER( config );
+  require_action_quiet( i2c != NULL, exit, err = kParamErr);
+
+  sim = i2c_sim_find( i2c );
+  if( sim == NULL ){
+    sim = i2c_sim_find( NULL );
+    require_action( sim, exit, err = kNoResourcesErr );
+    memset( sim, 0, sizeof(i2c_sim_t) );
+    sim->peripheral = i2c;
+  }
+  sim->stats.inits++;
+
+exit:
+  return err;
+}
+
+OSStatus platform_i2c_deinit( const platform_i2c_t* i2c, const platform_i2c_config_t* config )
+{
+  UNUSED_PARAMETER( i2c );
+  UNUSED_PARAMETER( config );
+  return kNoErr;
+}
+
+bool platform_i2c_probe_device( const platform_i2c_t* i2c, const platform_i2c_config_t* config, int retries )
+{
+  i2c_sim_t *sim = i2c_sim_find( i2c );
+
+  UNUSED_PARAMETER( retries );
+  if( sim == NULL )
+    return false;
+  i2c_charge_bus( sim, config, 1, 0 );
+  if( !i2c_acknowledged( i2c, config ) ){
+    sim->stats.nacks++;
+    return false;
+  }
+  return true;
+}
+
+OSStatus platform_i2c_init_tx_message( platform_i2c_message_t* message, const void* tx_buffer, uint16_t tx_buffer_length, uint16_t retries )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( ( message != NULL ) && ( tx_buffer != NULL ) && ( tx_buffer_length != 0 ), exit, err = kParamErr);
+
+  memset(message, 0x00, sizeof(platform_i2c_message_t));
+  message->tx_buffer = tx_buffer;
+  message->retries = retries;
+  message->tx_length = tx_buffer_length;
+
+exit:
+  return err;
+}
+
+OSStatus platform_i2c_init_rx_message( platform_i2c_message_t* message, void* rx_buffer, uint16_t rx_buffer_length, uint16_t retries )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( ( message != NULL ) && ( rx_buffer != NULL ) && ( rx_buffer_length != 0 ), exit, err = kParamErr);
+
+  memset(message, 0x00, sizeof(platform_i2c_message_t));
+  message->rx_buffer = rx_buffer;
+  message->retries = retries;
+  message->rx_length = rx_buffer_length;
+
+exit:
+  return err;
+}
+
+OSStatus platform_i2c_init_combined_message( platform_i2c_message_t* message, const void* tx_buffer, void* rx_buffer, uint16_t tx_buffer_length, uint16_t rx_buffer_length, uint16_t retries )
+{
+  OSStatus err = kNoErr;
+
+  require_action_quiet( ( message != NULL ) && ( tx_buffer != NULL ) && ( tx_buffer_length != 0 ) && ( rx_buffer != NULL ) && ( rx_buffer_length != 0 ), exit, err = kParamErr);
+
+  memset(message, 0x00, sizeof(platform_i2c_message_t));
+  message->rx_buffer = rx_buffer;
+  message->tx_buffer = tx_buffer;
+  message->retries = retries;
+  message->tx_length = tx_buffer_length;
+  message->rx_length = rx_buffer_length;
+
+exit:
+  return err;
+}
+
+/* A message with both buffers is a write of tx, a repeated start and a read of rx */
+OSStatus platform_i2c_transfer( const platform_i2c_t* i2c, const platform_i2c_config_t* config, platform_i2c_message_t* messages, uint16_t number_of_messages )
+{
+  OSStatus err = kNoErr;
+  i2c_sim_t *sim;
+  platform_i2c_message_t *message;
+  const uint8_t *tx;
+  uint8_t *rx;
+  uint16_t i, j;
+
+  require_action_quiet( i2c != NULL && config != NULL && messages != NULL, exit, err = kParamErr);
+  sim = i2c_sim_find( i2c );
+  require_action( sim, exit, err = kNotInitializedErr );
+  sim->stats.transfers++;
+
+  for( i = 0; i < number_of_messages; i++ ){
+    message = &messages[i];
+    tx = message->tx_buffer;
+    rx = message->rx_buffer;
+    sim->stats.messages++;
+    if( !i2c_acknowledged( i2c, config ) ){
+      i2c_charge_bus( sim, config, 1, 0 );
+      sim->stats.nacks++;
+      err = kTimeoutErr;
+      goto exit;
+    }
+    i2c_charge_bus( sim, config, ( tx && rx ) ? 2 : 1, ( tx ? message->tx_length : 0 ) + ( rx ? message->rx_length : 0 ) );
+
+    if( tx != NULL && message->tx_length > 0 ){
+      sim->pointer = tx[0];
+      for( j = 1; j < message->tx_length; j++ )
+        i2c->registers[(uint8_t)( sim->pointer + j - 1 )] = tx[j];
+      sim->stats.bytes_written += message->tx_length;
+      if( message->tx_length > 1 && i2c->after_write )
+        i2c->after_write( sim->pointer, message->tx_length - 1 );
+      sim->pointer += message->tx_length - 1;
+    }
+    if( rx != NULL && message->rx_length > 0 ){
+      if( i2c->before_read )
+        i2c->before_read( sim->pointer, message->rx_length );
+      for( j = 0; j < message->rx_length; j++ )
+        rx[j] = i2c->registers[(uint8_t)( sim->pointer + j )];
+      sim->stats.bytes_read += message->rx_length;
+      sim->pointer += message->rx_length;
+    }
+  }
+
+exit:
+  return err;
+}
+
+OSStatus platform_i2c_sim_get_stats( const platform_i2c_t* peripheral, platform_i2c_sim_stats_t* stats )
+{
+  i2c_sim_t *sim = i2c_sim_find( peripheral );
+
+  if( sim == NULL )
+    return kNotInitializedErr;
+  *stats = sim->stats;
+  return kNoErr;
+}
+
+void platform_i2c_sim_reset_stats( const platform_i2c_t* peripheral )
+{
+  i2c_sim_t *sim = i2c_sim_find( peripheral );
+
+  if( sim != NULL )
+    memset( &sim->stats, 0, sizeof(platform_i2c_sim_stats_t) );
+}
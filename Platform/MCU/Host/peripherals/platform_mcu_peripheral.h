@@ -0,0 +1,263 @@
+/**
+******************************************************************************
+* @file    platform_mcu_peripheral.h 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   This file provide all the headers of functions for the host platform, a
+*          simulated MCU used to run and benchmark MICO code off target.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "MicoRtos.h"
+#include "RingBufferUtils.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************
+ *                      Macros
+ ******************************************************/
+
+/* Interrupt Control and State Register read by mico_platform_common.c, a host is never in an ISR */
+#define SCB                       (&(const host_scb_t){ 0 })
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define NUMBER_OF_GPIO_PORTS      (1)
+#define NUMBER_OF_GPIO_IRQ_LINES  (1)
+#define NUMBER_OF_UART_PORTS      (1)
+#define INVALID_UART_PORT_NUMBER  (0xff)
+#define NUMBER_OF_SPI_PORTS       (1)
+#define NUMBER_OF_I2C_PORTS       (1)
+
+/* platform_flash_t.sim_options */
+#define FLASH_SIM_OPT_STRICT      (1 << 0)   /* Programming a 0 bit back to 1 fails with kWriteErr instead of being ANDed */
+#define FLASH_SIM_OPT_REALTIME    (1 << 1)   /* Sleep for the modelled erase/program/read time */
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+typedef enum
+{
+    FLASH_TYPE_EMBEDDED, 
+    FLASH_TYPE_SPI,
+} platform_flash_type_t;
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+
+typedef struct
+{
+    uint32_t ICSR;
+} host_scb_t;
+
+/* Only flash (and devices behind a SPI or I2C port) is simulated, the other peripherals exist so that platform_peripheral.h builds. */
+
+typedef struct
+{
+    uint32_t            channel;
+    uint32_t            complete_flags;
+    uint32_t            error_flags;
+} platform_dma_config_t;
+
+typedef struct
+{
+    uint8_t             unimplemented;
+} platform_gpio_t;
+
+typedef struct
+{
+    uint8_t             unimplemented;
+} platform_adc_t;
+
+typedef struct
+{
+    uint8_t             unimplemented;
+} platform_pwm_t;
+
+typedef struct
+{
+    uint8_t unimplemented;
+} platform_spi_slave_driver_t;
+
+/* A register file device can sit behind a host I2C port. A write sets the register pointer
+ * from its first byte and stores the rest from there, a read returns registers from the pointer on. */
+typedef struct
+{
+    uint16_t                   address;               /* 7 bit address, other addresses are not acknowledged */
+    uint8_t*                   registers;             /* 256 registers, NULL when nothing is attached */
+    void                       (*before_read)( uint8_t first_register, uint16_t length ); /* Lets a model update the registers about to be read */
+    void                       (*after_write)( uint8_t first_register, uint16_t length );
+} platform_i2c_t;
+
+typedef void (* wakeup_irq_handler_t)(void *arg);
+
+typedef struct
+{
+    uint8_t             unimplemented;
+} platform_uart_t;
+
+typedef struct
+{
+    platform_uart_t*           peripheral;
+    ring_buffer_t*             rx_buffer;
+    volatile bool              rx_complete;
+    volatile bool              tx_complete;
+    volatile uint32_t          tx_size;
+    volatile uint32_t          rx_size;
+    volatile OSStatus          last_receive_result;
+    volatile OSStatus          last_transmit_result;
+} platform_uart_driver_t;
+
+/* Timing and geometry of a flash device, taken from its datasheet (typical values) */
+typedef struct
+{
+    const char*                name;
+    uint32_t                   sector_size;         /* Erase granularity */
+    uint32_t                   page_size;           /* One program command never crosses a page */
+    uint32_t                   sector_erase_us;
+    uint32_t                   block_erase_us;      /* 64KB block erase of serial NOR, 0 when it costs its sectors */
+    uint32_t                   page_program_us;     /* Programming a full page, shorter writes scale down */
+    uint32_t                   program_setup_us;    /* Command, address and status polling of one program */
+    uint32_t                   read_ns_per_byte;
+    uint32_t                   endurance;           /* Erase cycles per sector */
+} platform_flash_profile_t;
+
+typedef struct
+{
+    platform_flash_type_t      flash_type;
+    uint32_t                   flash_start_addr;
+    uint32_t                   flash_length;
+    uint32_t                   flash_readonly_start; // can't erase and write
+    uint32_t                   flash_readonly_len;
+    const char*                image_path;          /* Backing image, mmap'ed. NULL or empty keeps the image in RAM */
+    const platform_flash_profile_t* profile;
+    uint32_t                   sim_options;
+} platform_flash_t;
+
+typedef struct
+{
+    const platform_flash_t*    peripheral;
+    mico_mutex_t               flash_mutex;
+    volatile bool              initialized;
+} platform_flash_driver_t;
+
+typedef struct
+{
+    uint64_t                   busy_ns;             /* Modelled device time of all operations */
+    uint64_t                   erase_ns;
+    uint64_t                   program_ns;
+    uint64_t                   read_ns;
+    uint32_t                   sector_erases;
+    uint32_t                   program_commands;
+    uint32_t                   bytes_programmed;
+    uint32_t                   bytes_read;
+    uint32_t                   program_violations;  /* Programs that tried to turn a 0 bit into 1 */
+    uint32_t                   readonly_skips;      /* Sectors or bytes left alone in the read-only range */
+    uint32_t                   max_sector_erases;
+    uint32_t                   worn_sectors;        /* Sectors erased more than the profile endurance */
+} platform_flash_sim_stats_t;
+
+/* A serial NOR device model can sit behind a host SPI port, its array is a simulated flash.
+ * Other devices are modelled by a function that sees every chip select frame. */
+typedef struct
+{
+    const platform_flash_t*    flash;                 /* NULL when no serial NOR is attached */
+    uint32_t                   jedec_id;              /* Manufacturer, type and capacity returned by RDID */
+    uint32_t                   read_max_hz;           /* Highest clock of READ (03h), FAST_READ runs at any clock */
+    uint8_t                    erase_suspend;         /* Part decodes erase suspend and resume, B0h/30h or 75h/7Ah */
+    uint32_t                   transfer_overhead_ns;  /* Chip select and driver time of one transfer */
+    void                       (*device)( const uint8_t* frame, uint8_t* response, uint32_t length ); /* Used when flash is NULL */
+} platform_spi_t;
+
+typedef struct
+{
+    platform_spi_t*           peripheral;
+    mico_mutex_t              spi_mutex;
+} platform_spi_driver_t;
+
+typedef struct
+{
+    uint64_t                   bus_ns;              /* Clocked bytes plus the per transfer overhead */
+    uint32_t                   inits;               /* platform_spi_init calls, drivers set up the port per access */
+    uint32_t                   transfers;
+    uint32_t                   bytes;               /* Clocked in both directions at once */
+    uint32_t                   status_polls;
+    uint32_t                   read_commands;
+    uint32_t                   bytes_read;
+    uint32_t                   program_commands;
+    uint32_t                   bytes_programmed;
+    uint32_t                   erase_commands;
+    uint32_t                   suspends;
+    uint32_t                   protocol_errors;     /* Ignored or corrupted on a real part: no WREN, access while busy, READ too fast, undefined opcode */
+} platform_spi_sim_stats_t;
+
+typedef struct
+{
+    uint64_t                   bus_ns;              /* Start, address, data and stop bits at the speed of the device */
+    uint32_t                   inits;
+    uint32_t                   transfers;           /* platform_i2c_transfer calls */
+    uint32_t                   messages;
+    uint32_t                   bytes_written;       /* Register pointer and data, address bytes excluded */
+    uint32_t                   bytes_read;
+    uint32_t                   nacks;               /* Messages to an address nothing answers */
+} platform_i2c_sim_stats_t;
+
+/******************************************************
+ *                 Global Variables
+ ******************************************************/
+
+extern const platform_flash_profile_t platform_flash_profile_spi_nor;     /* 4KB sector, 256B page serial NOR */
+extern const platform_flash_profile_t platform_flash_profile_embedded;    /* 128KB sector, word programmed MCU flash */
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+OSStatus platform_flash_sim_get_stats        ( const platform_flash_t* peripheral, platform_flash_sim_stats_t* stats );
+void     platform_flash_sim_reset_stats      ( const platform_flash_t* peripheral );
+uint32_t platform_flash_sim_erase_count      ( const platform_flash_t* peripheral, uint32_t address );
+void     platform_flash_sim_deinit           ( const platform_flash_t* peripheral );
+
+OSStatus platform_spi_sim_get_stats          ( const platform_spi_t* peripheral, platform_spi_sim_stats_t* stats );
+void     platform_spi_sim_reset_stats        ( const platform_spi_t* peripheral );
+
+OSStatus platform_i2c_sim_get_stats          ( const platform_i2c_t* peripheral, platform_i2c_sim_stats_t* stats );
+void     platform_i2c_sim_reset_stats        ( const platform_i2c_t* peripheral );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
@@ -0,0 +1,378 @@
+/**
+******************************************************************************
+* @file    platform_spi.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   SPI port of the host platform with a serial NOR or a caller supplied device
+*          model behind it, bus time and busy time are charged to the virtual clock.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "MICOPlatform.h"
+#include "MICORTOS.h"
+
+#include "PlatformLogging.h"
+#include "platform_peripheral.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* State of one port, the NOR fields are only used when a flash is attached */
+typedef struct
+{
+  const platform_spi_t*       peripheral;
+  uint8_t                     write_enabled;
+  uint8_t                     aai;            /* SST auto address increment in progress */
+  uint8_t                     suspended;
+  uint8_t                     erasing;        /* The busy or parked time belongs to an erase */
+  uint32_t                    aai_address;
+  uint64_t                    busy_until_ns;
+  uint64_t                    suspended_ns;   /* Erase time left when suspended */
+  platform_spi_sim_stats_t    stats;
+} spi_sim_t;
+
+/* Private define ------------------------------------------------------------*/
+#define SPI_SIM_MAX_DEVICES     (3)
+#define SPI_NOR_SUSPEND_NS      (20000)       /* tESL, erase suspend latency */
+
+#define SPI_NOR_SR_BUSY         (0x01)
+#define SPI_NOR_SR_WEL          (0x02)
+#define SPI_NOR_SR_AAI          (0x40)        /* SST only */
+
+#define SPI_NOR_MANUFACTURER( id )  ( ( (id) >> 16 ) & 0xFF )
+#define SPI_NOR_SST             (0xBF)
+
+/* Private variables ---------------------------------------------------------*/
+static spi_sim_t spi_sims[SPI_SIM_MAX_DEVICES];
+
+/* Private function prototypes -----------------------------------------------*/
+
+static spi_sim_t* spi_sim_find( const platform_spi_t *peripheral )
+{
+  int i;
+
+  for( i = 0; i < SPI_SIM_MAX_DEVICES; i++ ){
+    if( spi_sims[i].peripheral == peripheral )
+      return &spi_sims[i];
+  }
+  return NULL;
+}
+
+static bool spi_nor_busy( spi_sim_t *sim )
+{
+  return platform_get_nanosecond_clock_value( ) < sim->busy_until_ns;
+}
+
+static uint32_t spi_nor_address( const uint8_t *frame )
+{
+  return ( (uint32_t)frame[1] << 16 ) | ( (uint32_t)frame[2] << 8 ) | frame[3];
+}
+
+/* Program bytes within one page, wrapping at its end like the hardware */
+static void spi_nor_program( spi_sim_t *sim, uint32_t address, uint8_t *data, uint32_t length )
+{
+  const platform_flash_t *flash = sim->peripheral->flash;
+  uint32_t page_size = flash->profile->page_size;
+  uint32_t page = address - address % page_size;
+  volatile uint32_t addr;
+  uint32_t chunk;
+  platform_flash_sim_stats_t before, after;
+
+  if( SPI_NOR_MANUFACTURER( sim->peripheral->jedec_id ) == SPI_NOR_SST && length > 1 && !sim->aai ){
+    sim->stats.protocol_errors++;     /* SST byte program takes one byte */
+    length = 1;
+  }
+  platform_flash_sim_get_stats( flash, &before );
+  while( length > 0 ){
+    chunk = Min( length, page + page_size - address );
+    addr = flash->flash_start_addr + address;
+    platform_flash_write( flash, &addr, data, chunk );
+    address = page;
+    data += chunk;
+    length -= chunk;
+    sim->stats.bytes_programmed += chunk;
+  }
+  platform_flash_sim_get_stats( flash, &after );
+  sim->stats.program_commands++;
+  sim->erasing = 0;
+  sim->busy_until_ns = platform_get_nanosecond_clock_value( ) + ( after.program_ns - before.program_ns );
+}
+
+static void spi_nor_erase( spi_sim_t *sim, uint32_t address, uint32_t size )
+{
+  const platform_flash_t *flash = sim->peripheral->flash;
+  platform_flash_sim_stats_t before, after;
+  uint64_t busy_ns;
+
+  address -= address % size;
+  platform_flash_sim_get_stats( flash, &before );
+  platform_flash_erase( flash, flash->flash_start_addr + address, flash->flash_start_addr + address + size - 1 );
+  platform_flash_sim_get_stats( flash, &after );
+  busy_ns = after.erase_ns - before.erase_ns;
+  if( size == 0x10000 && flash->profile->block_erase_us )
+    busy_ns = (uint64_t)flash->profile->block_erase_us * 1000;
+  sim->stats.erase_commands++;
+  sim->erasing = 1;
+  sim->busy_until_ns = platform_get_nanosecond_clock_value( ) + busy_ns;
+}
+
+/* Execute one chip select frame: frame holds what was clocked out, replies go to response */
+static void spi_nor_command( spi_sim_t *sim, const platform_spi_config_t* config, uint8_t *frame, uint8_t *response, uint32_t length )
+{
+  const platform_spi_t *peripheral = sim->peripheral;
+  const platform_flash_t *flash = peripheral->flash;
+  uint8_t opcode = frame[0];
+  uint8_t status;
+  volatile uint32_t addr;
+  uint32_t header;
+
+  memset( response, 0xFF, length );
+  if( spi_nor_busy( sim ) && opcode != 0x05 && opcode != 0x04 && !( peripheral->erase_suspend && ( opcode == 0xB0 || opcode == 0x75 ) ) ){
+    sim->stats.protocol_errors++;     /* Only status, suspend and WRDI are accepted while busy */
+    return;
+  }
+
+  switch( opcode ){
+    case 0x9F:  /* RDID */
+      if( length >= 4 ){
+        response[1] = (uint8_t)( peripheral->jedec_id >> 16 );
+        response[2] = (uint8_t)( peripheral->jedec_id >> 8 );
+        response[3] = (uint8_t)peripheral->jedec_id;
+      }
+      break;
+    case 0x05:  /* RDSR */
+      status = ( spi_nor_busy( sim ) ? SPI_NOR_SR_BUSY : 0 ) | ( sim->write_enabled ? SPI_NOR_SR_WEL : 0 ) | ( sim->aai ? SPI_NOR_SR_AAI : 0 );
+      memset( response + 1, status, length - 1 );
+      sim->stats.status_polls++;
+      break;
+    case 0x06:  /* WREN */
+      sim->write_enabled = 1;
+      break;
+    case 0x04:  /* WRDI, also ends AAI */
+      sim->write_enabled = 0;
+      sim->aai = 0;
+      break;
+    case 0x01:  /* WRSR */
+    case 0x50:  /* EWSR */
+      sim->write_enabled = 0;
+      break;
+    case 0x03:  /* READ */
+    case 0x0B:  /* FAST_READ */
+      header = ( opcode == 0x0B ) ? 5 : 4;
+      if( length < header )
+        break;
+      if( opcode == 0x03 && peripheral->read_max_hz && config->speed > peripheral->read_max_hz )
+        sim->stats.protocol_errors++;
+      addr = flash->flash_start_addr + spi_nor_address( frame );
+      if( addr + length - header > flash->flash_start_addr + flash->flash_length )
+        break;
+      platform_flash_read( flash, &addr, response + header, length - header );
+      sim->stats.read_commands++;
+      sim->stats.bytes_read += length - header;
+      break;
+    case 0x02:  /* PP, one byte on SST */
+      if( length < 5 || !sim->write_enabled || sim->aai ){
+        sim->stats.protocol_errors++;
+        break;
+      }
+      sim->write_enabled = 0;
+      spi_nor_program( sim, spi_nor_address( frame ), frame + 4, length - 4 );
+      break;
+    case 0xAD:  /* AAI word program, SST only */
+      if( SPI_NOR_MANUFACTURER( peripheral->jedec_id ) != SPI_NOR_SST ){
+        sim->stats.protocol_errors++;
+        break;
+      }
+      if( !sim->aai ){
+        if( length != 6 || !sim->write_enabled || ( frame[3] & 1 ) ){
+          sim->stats.protocol_errors++;
+          break;
+        }
+        sim->aai = 1;
+        sim->aai_address = spi_nor_address( frame );
+        header = 4;
+      }
+      else{
+        if( length != 3 ){
+          sim->stats.protocol_errors++;
+          break;
+        }
+        header = 1;
+      }
+      spi_nor_program( sim, sim->aai_address, frame + header, 2 );
+      sim->aai_address += 2;
+      break;
+    case 0x20:  /* SE, 4KB */
+    case 0x52:  /* BE, 32KB */
+    case 0xD8:  /* BE, 64KB */
+      if( length != 4 || !sim->write_enabled ){
+        sim->stats.protocol_errors++;
+        break;
+      }
+      sim->write_enabled = 0;
+      spi_nor_erase( sim, spi_nor_address( frame ), opcode == 0x20 ? 0x1000 : ( opcode == 0x52 ? 0x8000 : 0x10000 ) );
+      break;
+    case 0x60:  /* CE */
+    case 0xC7:
+      if( !sim->write_enabled ){
+        sim->stats.protocol_errors++;
+        break;
+      }
+      sim->write_enabled = 0;
+      spi_nor_erase( sim, 0, flash->flash_length );
+      break;
+    case 0xB0:  /* Erase suspend, Macronix */
+    case 0x75:  /* Erase suspend, Winbond */
+      if( !peripheral->erase_suspend ){
+        sim->stats.protocol_errors++;
+        break;
+      }
+      if( !sim->erasing || sim->suspended || !spi_nor_busy( sim ) )
+        break;
+      /* Busy for the suspend latency, then idle with the rest of the erase parked */
+      sim->suspended_ns = sim->busy_until_ns - platform_get_nanosecond_clock_value( );
+      sim->busy_until_ns = platform_get_nanosecond_clock_value( ) + SPI_NOR_SUSPEND_NS;
+      sim->suspended = 1;
+      sim->stats.suspends++;
+      break;
+    case 0x30:  /* Erase resume, Macronix */
+    case 0x7A:  /* Erase resume, Winbond */
+      if( !peripheral->erase_suspend ){
+        sim->stats.protocol_errors++;
+        break;
+      }
+      if( !sim->suspended )
+        break;
+      sim->suspended = 0;
+      sim->busy_until_ns = platform_get_nanosecond_clock_value( ) + sim->suspended_ns;
+      break;
+    default:
+      break;
+  }
+}
+
+OSStatus platform_spi_init( platform_spi_driver_t* driver, const platform_spi_t* peripheral, const platform_spi_config_t* config )
+{
+  OSStatus err = kNoErr;
+  spi_sim_t *sim;
+
+  UNUSED_PARAMETER( config );
+  require_action_quiet( driver != NULL && peripheral != NULL, exit, err = kParamErr);
+
+  driver->peripheral = (platform_spi_t *)peripheral;
+  sim = spi_sim_find( peripheral );
+  if( sim == NULL ){
+    sim = spi_sim_find( NULL );
+    require_action( sim, exit, err = kNoResourcesErr );
+    if( peripheral->flash != NULL ){
+      err = platform_flash_init( peripheral->flash );
+      require_noerr( err, exit );
+    }
+    memset( sim, 0, sizeof(spi_sim_t) );
+    sim->peripheral = peripheral;
+  }
+  sim->stats.inits++;
+
+exit:
+  return err;
+}
+
+OSStatus platform_spi_deinit( platform_spi_driver_t* driver )
+{
+  UNUSED_PARAMETER( driver );
+  return kNoErr;
+}
+
+/* Segments of one call form one chip select frame */
+OSStatus platform_spi_transfer( platform_spi_driver_t* driver, const platform_spi_config_t* config, const platform_spi_message_segment_t* segments, uint16_t number_of_segments )
+{
+  OSStatus err = kNoErr;
+  spi_sim_t *sim;
+  uint8_t *frame = NULL, *response;
+  uint32_t length = 0, pos = 0;
+  uint64_t bus_ns;
+  uint16_t i;
+
+  require_action_quiet( driver != NULL && driver->peripheral != NULL && config != NULL, exit, err = kParamErr);
+  sim = spi_sim_find( driver->peripheral );
+  require_action( sim, exit, err = kNotInitializedErr );
+
+  for( i = 0; i < number_of_segments; i++ )
+    length += segments[i].length;
+  require_action_quiet( length > 0, exit, err = kParamErr );
+  frame = malloc( 2 * length );
+  require_action( frame, exit, err = kNoMemoryErr );
+  response = frame + length;
+
+  for( i = 0; i < number_of_segments; pos += segments[i].length, i++ ){
+    if( segments[i].tx_buffer )
+      memcpy( frame + pos, segments[i].tx_buffer, segments[i].length );
+    else
+      memset( frame + pos, 0xFF, segments[i].length );
+  }
+
+  /* Bus time first, the command sees the clock at the end of its frame */
+  bus_ns = driver->peripheral->transfer_overhead_ns + (uint64_t)length * 8 * 1000000000 / Max( config->speed, 1 );
+  platform_nanosecond_delay( bus_ns );
+  sim->stats.bus_ns += bus_ns;
+  sim->stats.transfers++;
+  sim->stats.bytes += length;
+  if( driver->peripheral->flash != NULL )
+    spi_nor_command( sim, config, frame, response, length );
+  else if( driver->peripheral->device != NULL )
+    driver->peripheral->device( frame, response, length );
+  else
+    memset( response, 0xFF, length );
+
+  for( i = 0, pos = 0; i < number_of_segments; pos += segments[i].length, i++ ){
+    if( segments[i].rx_buffer )
+      memcpy( segments[i].rx_buffer, response + pos, segments[i].length );
+  }
+
+exit:
+  if( frame ) free( frame );
+  return err;
+}
+
+OSStatus platform_spi_sim_get_stats( const platform_spi_t* peripheral, platform_spi_sim_stats_t* stats )
+{
+  spi_sim_t *sim = spi_sim_find( peripheral );
+
+  if( sim == NULL )
+    return kNotInitializedErr;
+  *stats = sim->stats;
+  return kNoErr;
+}
+
+void platform_spi_sim_reset_stats( const platform_spi_t* peripheral )
+{
+  spi_sim_t *sim = spi_sim_find( peripheral );
+
+  if( sim != NULL )
+    memset( &sim->stats, 0, sizeof(platform_spi_sim_stats_t) );
+}
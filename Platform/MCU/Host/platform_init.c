@@ -0,0 +1,82 @@
+/**
+******************************************************************************
+* @file    platform_init.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Virtual time of the host platform: the nanosecond clock, delays and
+*          the no-OS sleep advance one counter instead of the wall clock.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "MICOPlatform.h"
+#include "MICORTOS.h"
+
+#include "platform_peripheral.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint64_t host_time_ns;
+
+/* Private function prototypes -----------------------------------------------*/
+
+uint64_t platform_get_nanosecond_clock_value( void )
+{
+  return host_time_ns;
+}
+
+void platform_deinit_nanosecond_clock( void )
+{
+}
+
+void platform_reset_nanosecond_clock( void )
+{
+  host_time_ns = 0;
+}
+
+void platform_init_nanosecond_clock( void )
+{
+}
+
+/* Device models charge their bus and busy time through here as well */
+void platform_nanosecond_delay( uint64_t delayns )
+{
+  host_time_ns += delayns;
+}
+
+uint32_t mico_get_time_no_os( void )
+{
+  return (uint32_t)( host_time_ns / 1000000 );
+}
+
+uint32_t mico_get_time( void )
+{
+  return mico_get_time_no_os( );
+}
+
+void mico_thread_msleep_no_os( uint32_t milliseconds )
+{
+  host_time_ns += (uint64_t)milliseconds * 1000000;
+}
@@ -0,0 +1,280 @@
+/**
+******************************************************************************
+* @file    promisc_ring_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Producer/consumer stress of the promisc frame ring: a wlan rx thread
+*          sniffing frames at a high rate against the draining promisc thread.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench builds wifi_promisc.c itself with host stand-ins of FreeRTOS and of the wifi API,
+ *  a thread in the role of wlan rx calls the promisc callback while the main thread drains
+ *  the ring the way promisc_drain does:
+ *
+ *    gcc -O2 -DUSE_STM324xG_EVAL -IPlatform/MCU/Host/rtl8711
+ *        -Icomponent/common/api -Icomponent/common/api/wifi
+ *        Platform/MCU/Host/promisc_ring_bench.c -lpthread
+ *
+ *  Every frame carries its sequence number in DA, SA and length, so the consumer sees any
+ *  frame torn by a slot handed over too early, reordered or counted twice. Frames the ring
+ *  had no room for must show up in the dropped counter and nowhere else.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "wifi_promisc.c"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_FRAMES            2000000       /* back to back */
+#define BENCH_PACED_SECONDS     1
+#define BENCH_PRINT_NS          20000         /* promisc_show_frame over the log uart */
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  const char *name;
+  unsigned int interval_ns;     /* between sniffed frames, 0 for back to back */
+  unsigned int consumer_ns;     /* work per retrieved frame */
+} bench_case_t;
+
+typedef struct
+{
+  unsigned int seen;
+  unsigned int torn;
+  unsigned int reordered;
+  double producer_ns;           /* per callback, back to back only */
+  double consumer_ns;           /* per retrieved frame, retrieve_frames only */
+} bench_result_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static double bench_now( void );
+static void bench_spin( unsigned int ns );
+static void *bench_wlan_rx( void *arg );
+static int bench_run( const bench_case_t *c, bench_result_t *r );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const bench_case_t bench_cases[] =
+{
+  { "burst, drain only",       0,      0 },
+  { "20k fps, drain only",  50000,      0 },
+  { "burst, printing",          0, BENCH_PRINT_NS },
+  { "20k fps, printing",    50000, BENCH_PRINT_NS },
+  { "2k fps, printing",    500000, BENCH_PRINT_NS },
+};
+
+static void (*bench_rx_callback)( unsigned char*, unsigned int, void* );
+static volatile int bench_rx_done;
+static unsigned int bench_rx_interval_ns;
+static unsigned int bench_rx_frames;
+static double bench_rx_seconds;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+  return malloc( xWantedSize );
+}
+
+void vPortFree( void *pv )
+{
+  free( pv );
+}
+
+TickType_t xTaskGetTickCount( void )
+{
+  return (TickType_t)( bench_now( ) * configTICK_RATE_HZ );
+}
+
+void vTaskDelay( TickType_t xTicksToDelay )
+{
+  usleep( xTicksToDelay * 1000 / configTICK_RATE_HZ );
+}
+
+int wifi_set_channel( int channel )
+{
+  (void)channel;
+  return 0;
+}
+
+void wifi_enter_promisc_mode( void )
+{
+}
+
+int wifi_set_promisc( rtw_rcr_level_t enabled, void (*callback)(unsigned char*, unsigned int, void*), unsigned char len_used )
+{
+  (void)len_used;
+  bench_rx_callback = ( enabled == RTW_PROMISC_DISABLE ) ? NULL : callback;
+  return 0;
+}
+
+static double bench_now( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_spin( unsigned int ns )
+{
+  double end = bench_now( ) + ns / 1e9;
+
+  while( bench_now( ) < end )
+    ;
+}
+
+/* wlan rx: 802.11 header with the sequence number in addr1, addr2 and the length */
+static void *bench_wlan_rx( void *arg )
+{
+  ieee80211_frame_info_t info;
+  unsigned char buf[24];
+  unsigned int seq;
+  double start, next;
+
+  (void)arg;
+  memset( &info, 0, sizeof(info) );
+  memset( buf, 0, sizeof(buf) );
+  buf[0] = 0x80;
+  start = next = bench_now( );
+  for( seq = 0; seq < bench_rx_frames; seq++ ){
+    if( bench_rx_interval_ns ){
+      next += bench_rx_interval_ns / 1e9;
+      while( bench_now( ) < next )
+        ;
+    }
+    memcpy( buf + 4, &seq, sizeof(seq) );
+    memcpy( buf + 10 + 2, &seq, sizeof(seq) );
+    info.rssi = (signed char)( -20 - seq % 70 );
+    bench_rx_callback( buf, 64 + seq % 1400, &info );
+  }
+  bench_rx_seconds = bench_now( ) - start;
+  bench_rx_done = 1;
+  return NULL;
+}
+
+static int bench_run( const bench_case_t *c, bench_result_t *r )
+{
+  struct eth_frame frames[ETH_DRAIN_BATCH];
+  pthread_t thread;
+  unsigned int seq, last = 0;
+  double t, consumer = 0;
+  int i, num, have_last = 0;
+
+  memset( r, 0, sizeof(*r) );
+  if( eth_buffer_alloc( ) < 0 )
+    return -1;
+  wifi_enter_promisc_mode( );
+  wifi_set_promisc( RTW_PROMISC_ENABLE_2, promisc_callback_all, 0 );
+
+  bench_rx_done = 0;
+  bench_rx_interval_ns = c->interval_ns;
+  bench_rx_frames = c->interval_ns ? BENCH_PACED_SECONDS * 1000000000u / c->interval_ns : BENCH_FRAMES;
+  pthread_create( &thread, NULL, bench_wlan_rx, NULL );
+
+  for( ;; ){
+    int done = bench_rx_done;
+
+    t = bench_now( );
+    num = retrieve_frames( frames, ETH_DRAIN_BATCH );
+    consumer += bench_now( ) - t;
+    if( num == 0 ){
+      if( done )
+        break;
+      sched_yield( );
+      continue;
+    }
+    for( i = 0; i < num; i++ ){
+      memcpy( &seq, frames[i].da, sizeof(seq) );
+      if( memcmp( frames[i].sa + 2, &seq, sizeof(seq) ) != 0 || frames[i].len != 64 + seq % 1400 ||
+          frames[i].type != 0x80 || frames[i].rssi != (signed char)( -20 - seq % 70 ) )
+        r->torn++;
+      if( have_last && seq <= last )
+        r->reordered++;
+      last = seq;
+      have_last = 1;
+      if( c->consumer_ns )
+        bench_spin( c->consumer_ns );
+    }
+    r->seen += num;
+  }
+  pthread_join( thread, NULL );
+
+  wifi_set_promisc( RTW_PROMISC_DISABLE, NULL, 0 );
+  if( eth_buffer->received != bench_rx_frames || r->seen + eth_buffer->dropped != eth_buffer->received )
+    r->torn++;
+  r->producer_ns = c->interval_ns ? 0 : bench_rx_seconds * 1e9 / bench_rx_frames;
+  r->consumer_ns = consumer * 1e9 / ( r->seen ? r->seen : 1 );
+  return 0;
+}
+
+int main( void )
+{
+  bench_result_t r;
+  unsigned int i;
+  int failed = 0;
+
+  printf( "%u slot ring of %u byte frames (%u bytes allocated while promisc is on), batch %d\n",
+          ETH_RING_SIZE, (unsigned)sizeof(struct eth_frame), (unsigned)sizeof(struct eth_buffer), ETH_DRAIN_BATCH );
+  for( i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++ ){
+    if( bench_run( &bench_cases[i], &r ) < 0 )
+      return 1;
+    printf( "%-20s %8u frames  dropped %6.2f%%  ", bench_cases[i].name, eth_buffer->received,
+            100.0 * eth_buffer->dropped / eth_buffer->received );
+    if( r.producer_ns )
+      printf( "callback %5.1f ns  ", r.producer_ns );
+    else
+      printf( "                  " );
+    printf( "retrieve %5.1f ns/frame  torn %u reordered %u\n", r.consumer_ns, r.torn, r.reordered );
+    if( r.torn || r.reordered )
+      failed = 1;
+    eth_buffer_free( );
+  }
+  if( eth_buffer != NULL )
+    failed = 1;
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
@@ -0,0 +1,56 @@
+/**
+******************************************************************************
+* @file    FreeRTOS.h
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Host stand-in for the FreeRTOS kernel header of the Realtek sources.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define configTICK_RATE_HZ      ( 1000 )
+
+#define pdFALSE                 ( 0 )
+#define pdTRUE                  ( 1 )
+#define pdPASS                  ( pdTRUE )
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef unsigned int TickType_t;
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+void *pvPortMalloc( size_t xWantedSize );
+void vPortFree( void *pv );
@@ -0,0 +1,56 @@
+/**
+******************************************************************************
+* @file    mico.h
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Host stand-in for the MICO API as used by the Realtek AT command sources.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define kNoErr                  ( 0 )
+#define MICO_NEVER_TIMEOUT      ( 0xFFFFFFFF )
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef int OSStatus;
+typedef void *mico_semaphore_t;
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+OSStatus mico_rtos_init_semaphore( mico_semaphore_t *semaphore, int count );
+OSStatus mico_rtos_get_semaphore( mico_semaphore_t *semaphore, uint32_t timeout_ms );
@@ -0,0 +1,70 @@
+/**
+******************************************************************************
+* @file    osdep_api.h
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Host stand-in for the Realtek OS dependency header, the basic types
+*          and OS services used by the component/common sources built on the
+*          host. Benches that use the services provide them.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+
+typedef struct host_sema *_Sema;
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+u8 *RtlZmalloc( u32 sz );
+void RtlMfree( u8 *pbuf, u32 sz );
+void RtlMsleepOS( u32 ms );
+
+void RtlInitSema( _Sema *sema, u32 init_val );
+void RtlFreeSema( _Sema *sema );
+void RtlUpSema( _Sema *sema );
+void RtlUpSemaFromISR( _Sema *sema );
+u32 RtlDownSema( _Sema *sema );
+u32 RtlDownSemaWithTimeout( _Sema *sema, u32 ms );
+
+#define rtl_strncmp             strncmp
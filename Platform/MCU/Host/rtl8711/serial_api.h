@@ -0,0 +1,77 @@
+/**
+******************************************************************************
+* @file    serial_api.h
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Host stand-in for the mbed serial API of the RTL8195A HAL, served by
+*          the simulated UART of the bench that uses it.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "PinNames.h"
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+typedef enum
+{
+  ParityNone = 0,
+  ParityOdd = 1,
+  ParityEven = 2,
+} SerialParity;
+
+typedef enum
+{
+  RxIrq,
+  TxIrq,
+} SerialIrq;
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef void (*uart_irq_handler)( uint32_t id, SerialIrq event );
+
+typedef struct serial_s
+{
+  void *host;                   /* the simulated port */
+} serial_t;
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+void serial_init( serial_t *obj, PinName tx, PinName rx );
+void serial_free( serial_t *obj );
+void serial_baud( serial_t *obj, int baudrate );
+void serial_format( serial_t *obj, int data_bits, SerialParity parity, int stop_bits );
+void serial_irq_handler( serial_t *obj, uart_irq_handler handler, uint32_t id );
+void serial_irq_set( serial_t *obj, SerialIrq irq, uint32_t enable );
+int serial_getc( serial_t *obj );
+void serial_putc( serial_t *obj, int c );
+int serial_readable( serial_t *obj );
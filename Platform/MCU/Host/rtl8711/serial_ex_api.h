@@ -0,0 +1,47 @@
+/**
+******************************************************************************
+* @file    serial_ex_api.h
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Host stand-in for the RTL8195A serial extensions, DMA transfers.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "serial_api.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define HAL_OK                  ( 0 )
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+int32_t serial_send_stream_dma( serial_t *obj, char *ptxbuf, uint32_t len );
+void serial_send_comp_handler( serial_t *obj, void *handler, uint32_t id );
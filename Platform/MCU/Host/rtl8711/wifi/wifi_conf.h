@@ -0,0 +1,75 @@
+/**
+******************************************************************************
+* @file    wifi_conf.h
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Host stand-in for the Realtek wifi configuration API, the promisc part.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+#pragma once
+
+#include "osdep_api.h"
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+typedef enum
+{
+  RTW_SUCCESS = 0,
+} rtw_result_t;
+
+typedef enum
+{
+  RTW_PROMISC_DISABLE = 0,
+  RTW_PROMISC_ENABLE = 1,
+  RTW_PROMISC_ENABLE_1 = 2,
+  RTW_PROMISC_ENABLE_2 = 3,
+} rtw_rcr_level_t;
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct ieee80211_frame_info
+{
+  unsigned short i_fc;
+  unsigned short i_dur;
+  unsigned char i_addr1[6];
+  unsigned char i_addr2[6];
+  unsigned char i_addr3[6];
+  unsigned short i_seq;
+  unsigned char bssid[6];
+  unsigned char encrypt;
+  signed char rssi;
+} ieee80211_frame_info_t;
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+
+int wifi_set_channel( int channel );
+void wifi_enter_promisc_mode( void );
+int wifi_set_promisc( rtw_rcr_level_t enabled, void (*callback)(unsigned char*, unsigned int, void*), unsigned char len_used );
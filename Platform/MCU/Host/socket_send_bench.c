@@ -0,0 +1,381 @@
+/**
+******************************************************************************
+* @file    socket_send_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   SocketSendv over loopback TCP against the former SocketSend: calls,
+*          time and throughput for HTTP and SPP messages, nonblocking sends.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  SocketUtils.c is built against the MICO headers next to the bench and runs on the host
+ *  C library, whose select and write take what the MICO BSD-like calls take for the low
+ *  socket numbers a bench uses:
+ *
+ *    gcc -O2 -std=c99 -IMICO -Iinclude -Iinclude/MicoDrivers -IPlatform/include -IBoard/EMW3081
+ *        -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals -ISupport -IExternal
+ *        -IDemos/COM.MXCHIP.SPP Platform/MCU/Host/socket_send_bench.c Support/SocketUtils.c
+ *        -lpthread
+ *
+ *  Include names follow the Windows tool chains, see flash_sim_bench.c.
+ *
+ *  Each message is sent three ways: every segment with the former SocketSend, the segments
+ *  copied into one malloc'd buffer and sent with the former SocketSend as the Create*Message
+ *  users did, and SocketSendv. Calls are select() plus write(), counted around the former
+ *  code and taken from SocketSendStats_t for SocketSendv. A reader thread on the other end
+ *  checks every byte. Last, a 60 KB message goes out nonblocking into a 4 KB send buffer
+ *  while the reader starts late, and must continue where it stalled until all is through.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/* common.h has its own */
+#undef EWOULDBLOCK
+#undef htons
+#undef ntohs
+#undef htonl
+#undef ntohl
+
+#include "SocketUtils.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_MESSAGES          20000
+#define BENCH_PATTERN_LEN       65536
+#define BENCH_CAPTURE_LEN       ( 4 * BENCH_PATTERN_LEN )
+
+enum
+{
+  BENCH_FORMER_SEGMENTS,
+  BENCH_FORMER_COPY,
+  BENCH_SENDV,
+  BENCH_WAYS,
+};
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  int socket;
+  int delay_ms;
+  uint8_t *capture;             /* NULL to check against the expected stream */
+  size_t received;
+  size_t mismatch;              /* first byte that differed, +1 */
+} bench_reader_t;
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const char *const bench_way_names[ BENCH_WAYS ] = { "per segment", "copy + send", "SocketSendv" };
+
+static uint8_t bench_pattern[ BENCH_PATTERN_LEN ];
+static uint8_t *bench_expected;
+static size_t bench_expected_len;
+static uint32_t bench_former_calls;
+static unsigned int bench_failed;
+
+#define BENCH_CHECK( x )  do{ if( !( x ) ){ printf( "check failed, line %d: %s\n", __LINE__, #x ); bench_failed++; } }while( 0 )
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+void mico_delete_event_fd( int fd )
+{
+  close( fd );
+}
+
+/* The former SocketSend: select and write until the buffer is through, 5 s timeout */
+static OSStatus bench_former_send( int fd, const uint8_t *inBuf, size_t inBufLen )
+{
+  fd_set writeSet;
+  struct timeval t;
+  size_t numWritten = 0;
+  ssize_t writeResult;
+
+  if( fd < 0 || !inBuf || !inBufLen )
+    return kParamErr;
+
+  FD_ZERO( &writeSet );
+  FD_SET( fd, &writeSet );
+  t.tv_sec = 5;
+  t.tv_usec = 0;
+  do
+  {
+    bench_former_calls++;
+    if( select( fd + 1, NULL, &writeSet, NULL, &t ) < 1 )
+      return kNotWritableErr;
+    bench_former_calls++;
+    writeResult = write( fd, inBuf + numWritten, inBufLen - numWritten );
+    if( writeResult <= 0 )
+      return kNotWritableErr;
+    numWritten += writeResult;
+  } while( numWritten < inBufLen );
+  return kNoErr;
+}
+
+static double bench_time( void )
+{
+  struct timespec t;
+
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void *bench_reader( void *arg )
+{
+  bench_reader_t *r = arg;
+  uint8_t buf[ 16384 ];
+  ssize_t n, i;
+  struct timespec delay = { 0, 0 };
+
+  delay.tv_nsec = r->delay_ms * 1000000L;
+  nanosleep( &delay, NULL );
+  while( ( n = read( r->socket, buf, sizeof( buf ) ) ) > 0 )
+  {
+    for( i = 0; i < n && !r->mismatch; i++ )
+      if( buf[i] != bench_expected[ ( r->received + i ) % bench_expected_len ] )
+        r->mismatch = r->received + i + 1;
+    r->received += n;
+  }
+  return NULL;
+}
+
+/* A loopback TCP connection without Nagle, as the MICO stack sends small writes at once */
+static int bench_connect( int *outPeer, int sndbuf )
+{
+  struct sockaddr_in a;
+  socklen_t al = sizeof( a );
+  int l, s, one = 1;
+
+  memset( &a, 0, sizeof( a ) );
+  a.sin_family = AF_INET;
+  a.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+  l = socket( AF_INET, SOCK_STREAM, 0 );
+  if( l < 0 || bind( l, (struct sockaddr *)&a, sizeof( a ) ) || listen( l, 1 ) || getsockname( l, (struct sockaddr *)&a, &al ) )
+    return -1;
+  s = socket( AF_INET, SOCK_STREAM, 0 );
+  setsockopt( s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+  if( sndbuf )
+    setsockopt( s, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof( sndbuf ) );
+  if( connect( s, (struct sockaddr *)&a, sizeof( a ) ) )
+    return -1;
+  *outPeer = accept( l, NULL, NULL );
+  if( sndbuf )
+    setsockopt( *outPeer, SOL_SOCKET, SO_RCVBUF, &sndbuf, sizeof( sndbuf ) );
+  close( l );
+  return s;
+}
+
+/* The stream one message makes, repeated by the reader for every message */
+static void bench_expect( const SocketIOVec_t *iov, int count )
+{
+  size_t len = 0;
+  int k;
+
+  for( k = 0; k < count; k++ )
+  {
+    memcpy( bench_expected + len, iov[k].buf, iov[k].len );
+    len += iov[k].len;
+  }
+  bench_expected_len = len;
+}
+
+static void bench_message( const char *name, const SocketIOVec_t *iov, int count )
+{
+  SocketSendStats_t stats;
+  bench_reader_t reader;
+  pthread_t thread;
+  uint64_t calls, writes;
+  double t0, t1;
+  uint8_t *copy;
+  size_t len;
+  int way, fd, i, k;
+
+  bench_expect( iov, count );
+  for( way = 0; way < BENCH_WAYS; way++ )
+  {
+    memset( &reader, 0, sizeof( reader ) );
+    fd = bench_connect( &reader.socket, 0 );
+    BENCH_CHECK( fd >= 0 );
+    pthread_create( &thread, NULL, bench_reader, &reader );
+    bench_former_calls = 0;
+    calls = writes = 0;
+
+    t0 = bench_time( );
+    for( i = 0; i < BENCH_MESSAGES; i++ )
+    {
+      if( way == BENCH_FORMER_SEGMENTS )
+      {
+        for( k = 0; k < count; k++ )
+          BENCH_CHECK( bench_former_send( fd, iov[k].buf, iov[k].len ) == kNoErr );
+      }
+      else if( way == BENCH_FORMER_COPY )
+      {
+        copy = malloc( bench_expected_len );
+        for( k = 0, len = 0; k < count; len += iov[k].len, k++ )
+          memcpy( copy + len, iov[k].buf, iov[k].len );
+        BENCH_CHECK( bench_former_send( fd, copy, len ) == kNoErr );
+        free( copy );
+      }
+      else
+      {
+        BENCH_CHECK( SocketSendv( fd, iov, count, &stats ) == kNoErr && stats.bytes == bench_expected_len );
+        calls += stats.syscalls;
+        writes += stats.writes;
+      }
+    }
+    t1 = bench_time( );
+
+    shutdown( fd, SHUT_WR );
+    pthread_join( thread, NULL );
+    close( fd );
+    close( reader.socket );
+    BENCH_CHECK( reader.received == bench_expected_len * BENCH_MESSAGES && reader.mismatch == 0 );
+
+    if( way != BENCH_SENDV )
+      calls = bench_former_calls;
+    printf( "%-20s %5lu %-12s %6.2f %9.2f %10.1f\n", way ? "" : name, (unsigned long)bench_expected_len, bench_way_names[way],
+            (double)calls / BENCH_MESSAGES, ( t1 - t0 ) / BENCH_MESSAGES / 1e3,
+            bench_expected_len * (double)BENCH_MESSAGES / ( ( t1 - t0 ) / 1e3 ) );
+    if( way == BENCH_SENDV )
+      printf( "%-20s %5s %-12s %6.2f writes\n", "", "", "", (double)writes / BENCH_MESSAGES );
+  }
+}
+
+/* 60 KB into a 4 KB send buffer with the reader starting late: kInProgressErr, then resume */
+static void bench_nonblocking( const char *header )
+{
+  SocketIOVec_t iov[5];
+  SocketSendContext_t ctx;
+  bench_reader_t reader;
+  pthread_t thread;
+  uint8_t stage[ kSocketSendMSS ];
+  fd_set writeSet;
+  OSStatus err;
+  int fd, rounds = 0;
+
+  iov[0].buf = header;          iov[0].len = strlen( header );
+  iov[1].buf = bench_pattern;   iov[1].len = 60000;
+  iov[2].buf = bench_pattern;   iov[2].len = 3;
+  iov[3].buf = bench_pattern + 9; iov[3].len = 1500;
+  iov[4].buf = bench_pattern;   iov[4].len = 0;
+  bench_expect( iov, 5 );
+
+  memset( &reader, 0, sizeof( reader ) );
+  reader.delay_ms = 200;
+  fd = bench_connect( &reader.socket, 4096 );
+  BENCH_CHECK( fd >= 0 );
+  fcntl( fd, F_SETFL, O_NONBLOCK );
+  pthread_create( &thread, NULL, bench_reader, &reader );
+
+  SocketSendInit( &ctx, iov, 5, stage, sizeof( stage ) );
+  while( ( err = SocketSendContinue( fd, &ctx, 0 ) ) == kInProgressErr )
+  {
+    rounds++;
+    FD_ZERO( &writeSet );
+    FD_SET( fd, &writeSet );
+    select( fd + 1, NULL, &writeSet, NULL, NULL );
+  }
+  shutdown( fd, SHUT_WR );
+  pthread_join( thread, NULL );
+  close( fd );
+  close( reader.socket );
+
+  BENCH_CHECK( err == kNoErr && rounds > 0 && ctx.stats.stalls >= (uint32_t)rounds );
+  BENCH_CHECK( ctx.stats.bytes == bench_expected_len && reader.received == bench_expected_len && reader.mismatch == 0 );
+  printf( "\nnonblocking 60 KB: %d continuations, %u writes, %u stalls, %u calls, %lu of %lu bytes\n", rounds,
+          (unsigned)ctx.stats.writes, (unsigned)ctx.stats.stalls, (unsigned)ctx.stats.syscalls,
+          (unsigned long)reader.received, (unsigned long)bench_expected_len );
+}
+
+int main( void )
+{
+  static const char http_json[] = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 312\r\n\r\n";
+  static const char http_body[] = "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: 4000\r\n\r\n";
+  static const char chunk[] = "400\r\n";
+  SocketIOVec_t iov[8];
+  int i, k;
+
+  bench_expected = malloc( BENCH_CAPTURE_LEN );
+  for( i = 0; i < BENCH_PATTERN_LEN; i++ )
+    bench_pattern[i] = (uint8_t)( i * 7 + ( i >> 8 ) );
+
+  printf( "%-20s %5s %-12s %6s %9s %10s\n", "message", "bytes", "sent as", "calls", "us/msg", "MB/s" );
+
+  iov[0].buf = http_json;     iov[0].len = strlen( http_json );
+  iov[1].buf = bench_pattern; iov[1].len = 312;
+  bench_message( "HTTP + JSON", iov, 2 );
+
+  iov[0].buf = http_body;     iov[0].len = strlen( http_body );
+  iov[1].buf = bench_pattern; iov[1].len = 4000;
+  bench_message( "HTTP + 4000 B body", iov, 2 );
+
+  iov[0].buf = chunk;         iov[0].len = strlen( chunk );
+  iov[1].buf = bench_pattern; iov[1].len = 1024;
+  iov[2].buf = "\r\n";        iov[2].len = 2;
+  bench_message( "HTTP 1K chunk", iov, 3 );
+
+  iov[0].buf = bench_pattern;       iov[0].len = 6;
+  iov[1].buf = bench_pattern + 100; iov[1].len = 64;
+  iov[2].buf = bench_pattern + 200; iov[2].len = 2;
+  bench_message( "SPP hdr + 64 + CRC", iov, 3 );
+
+  iov[0].buf = bench_pattern; iov[0].len = 512;
+  bench_message( "SPP UART 512", iov, 1 );
+
+  for( k = 0; k < 8; k++ )
+  {
+    iov[k].buf = bench_pattern + k * 100;
+    iov[k].len = 20 + k;
+  }
+  bench_message( "SPP 8 small", iov, 8 );
+
+  bench_nonblocking( http_body );
+
+  free( bench_expected );
+  if( bench_failed )
+    printf( "Benchmark failed\n" );
+  return bench_failed ? 1 : 0;
+}
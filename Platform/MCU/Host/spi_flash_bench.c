@@ -0,0 +1,355 @@
+/**
+******************************************************************************
+* @file    spi_flash_bench.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Benchmark driver of Platform/Drivers/spi_flash on the host SPI NOR
+*          model: throughput per operation type and the asynchronous queue.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench is the SPI flash porting layer itself (sflash_platform_*), so that the SPI clock
+ *  can follow the read command in use:
+ *
+ *    gcc -O2 -DNO_MICO_RTOS -DSFLASH_SUPPORT_MACRONIX_PARTS -DSFLASH_SUPPORT_SST_PARTS
+ *        -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals -IBoard/EMW3081 -IPlatform/include
+ *        -Iinclude -Iinclude/MicoDrivers -IPlatform/Drivers/spi_flash
+ *        Platform/MCU/Host/spi_flash_bench.c Platform/MCU/Host/platform_init.c
+ *        Platform/MCU/Host/peripherals/platform_spi.c Platform/MCU/Host/peripherals/platform_flash.c
+ *        Platform/Drivers/spi_flash/spi_flash.c
+ *
+ *  Include names follow the Windows tool chains, see flash_sim_bench.c. All times are virtual.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MICOPlatform.h"
+#include "platform_peripheral.h"
+#include "spi_flash.h"
+#include "spi_flash_platform_interface.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_SPI_CLOCK         (80000000)
+#define BENCH_XFER_OVERHEAD_NS  (2000)        /* MicoSpiTransfer, chip select and DMA setup */
+#define BENCH_READ_SIZE         (0x40000)
+#define BENCH_READ_CHUNK        (0x1000)
+#define BENCH_WRITE_SIZE        (0x10000)
+#define BENCH_REGION_A          (0x00000)     /* Erased and programmed */
+#define BENCH_REGION_B          (0x80000)     /* Read by the queue scenario */
+#define BENCH_QUEUE_READS       (64)
+#define BENCH_QUEUE_PERIOD_NS   (5000000)     /* A 4KB read every 5ms, e.g. an audio or OTA stream */
+#define BENCH_QUEUE_TICK_NS     (100000)      /* Period of the thread owning the queue */
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  const char*               name;
+  const platform_spi_t*     spi;
+} bench_device_t;
+
+typedef struct
+{
+  sflash_request_t          request;
+  uint64_t                  submitted_ns;
+  uint8_t                   data[BENCH_READ_CHUNK];
+} bench_read_t;
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+/* SST25VF080B: no program page, 10us byte and AAI word program, 25ms sector and block erase */
+static const platform_flash_profile_t bench_profile_sst =
+{
+  .name                 = "SST25VF 4KB sector",
+  .sector_size          = 0x1000,
+  .page_size            = 2,
+  .sector_erase_us      = 25000,
+  .block_erase_us       = 25000,
+  .page_program_us      = 4,
+  .program_setup_us     = 6,
+  .read_ns_per_byte     = 0,
+  .endurance            = 100000,
+};
+
+static const platform_flash_t bench_arrays[] =
+{
+  { .flash_type = FLASH_TYPE_SPI, .flash_length = 0x200000, .profile = &platform_flash_profile_spi_nor },
+  { .flash_type = FLASH_TYPE_SPI, .flash_length = 0x100000, .profile = &bench_profile_sst },
+  { .flash_type = FLASH_TYPE_SPI, .flash_length = 0x200000, .profile = &platform_flash_profile_spi_nor },
+};
+
+static const platform_spi_t bench_spi[] =
+{
+  { .flash = &bench_arrays[0], .jedec_id = 0xC22015, .read_max_hz = 33000000, .transfer_overhead_ns = BENCH_XFER_OVERHEAD_NS },
+  { .flash = &bench_arrays[1], .jedec_id = 0xBF258E, .read_max_hz = 25000000, .transfer_overhead_ns = BENCH_XFER_OVERHEAD_NS },
+  { .flash = &bench_arrays[2], .jedec_id = 0xC22415, .read_max_hz = 33000000, .erase_suspend = 1, .transfer_overhead_ns = BENCH_XFER_OVERHEAD_NS },
+};
+
+static const bench_device_t bench_devices[] =
+{
+  { "MX25L1606E",  &bench_spi[0] },
+  { "SST25VF080B", &bench_spi[1] },
+  { "MX25L1633E",  &bench_spi[2] },
+};
+
+static platform_spi_config_t bench_spi_config = { .speed = BENCH_SPI_CLOCK, .mode = SPI_CLOCK_RISING_EDGE | SPI_CLOCK_IDLE_HIGH | SPI_MSB_FIRST, .bits = 8 };
+static int bench_spin;                  /* Poll busy back to back, as the driver used to */
+static uint8_t bench_pattern[BENCH_WRITE_SIZE];
+static uint8_t bench_buffer[BENCH_READ_SIZE];
+static uint64_t bench_latency_sum, bench_latency_max;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+int sflash_platform_init( void* peripheral_id, void** platform_peripheral_out )
+{
+  platform_spi_driver_t driver;
+
+  if( platform_spi_init( &driver, peripheral_id, &bench_spi_config ) != kNoErr )
+    return -1;
+  *platform_peripheral_out = peripheral_id;
+  return 0;
+}
+
+/* sflash segments carry unsigned long lengths, platform segments uint32_t */
+int sflash_platform_send_recv( const void* platform_peripheral, sflash_platform_message_segment_t* segments, unsigned int num_segments )
+{
+  platform_spi_driver_t driver = { .peripheral = (platform_spi_t *)platform_peripheral };
+  platform_spi_message_segment_t message[4];
+  unsigned int i;
+
+  if( num_segments > 4 )
+    return -1;
+  for( i = 0; i < num_segments; i++ ){
+    message[i].tx_buffer = segments[i].tx_buffer;
+    message[i].rx_buffer = segments[i].rx_buffer;
+    message[i].length    = (uint32_t)segments[i].length;
+  }
+  return platform_spi_transfer( &driver, &bench_spi_config, message, (uint16_t)num_segments ) == kNoErr ? 0 : -1;
+}
+
+void sflash_platform_wait( unsigned long microseconds )
+{
+  if( bench_spin )
+    return;
+  if( microseconds >= 1000 )
+    mico_thread_msleep( microseconds / 1000 );
+  else
+    MicoNanosendDelay( (uint64_t)microseconds * 1000 );
+}
+
+void MicoNanosendDelay( uint64_t delayns )
+{
+  platform_nanosecond_delay( delayns );
+}
+
+static double bench_kbps( uint32_t bytes, uint64_t ns )
+{
+  return ns ? bytes / 1024.0 / ( ns / 1e9 ) : 0;
+}
+
+/* Erase, program and read back one region through the blocking API */
+static int bench_blocking( const bench_device_t* device, const sflash_handle_t* handle, const char* mode )
+{
+  platform_spi_sim_stats_t st;
+  uint64_t start, erase_ns, write_ns, read_ns;
+  uint32_t erase_polls, write_polls, addr;
+  int err = 0;
+
+  platform_spi_sim_reset_stats( device->spi );
+  start = platform_get_nanosecond_clock_value( );
+  for( addr = 0; addr < BENCH_WRITE_SIZE && err == 0; addr += 0x1000 )
+    err = sflash_sector_erase( handle, BENCH_REGION_A + addr );
+  erase_ns = platform_get_nanosecond_clock_value( ) - start;
+  platform_spi_sim_get_stats( device->spi, &st );
+  erase_polls = st.status_polls;
+  require_noerr( err, exit );
+
+  platform_spi_sim_reset_stats( device->spi );
+  start = platform_get_nanosecond_clock_value( );
+  err = sflash_write( handle, BENCH_REGION_A, bench_pattern, BENCH_WRITE_SIZE );
+  write_ns = platform_get_nanosecond_clock_value( ) - start;
+  platform_spi_sim_get_stats( device->spi, &st );
+  write_polls = st.status_polls;
+  require_noerr( err, exit );
+
+  platform_spi_sim_reset_stats( device->spi );
+  start = platform_get_nanosecond_clock_value( );
+  for( addr = 0; addr < BENCH_READ_SIZE && err == 0; addr += BENCH_READ_CHUNK )
+    err = sflash_read( handle, BENCH_REGION_A + addr, bench_buffer + addr, BENCH_READ_CHUNK );
+  read_ns = platform_get_nanosecond_clock_value( ) - start;
+  platform_spi_sim_get_stats( device->spi, &st );
+  require_noerr( err, exit );
+  require_action( memcmp( bench_buffer, bench_pattern, BENCH_WRITE_SIZE ) == 0, exit, err = -1 );
+
+  printf( "%-12s %-22s erase %7.1f KB/s %6u polls | program %7.1f KB/s %6u polls | read %7.1f KB/s, %u protocol errors\n",
+          device->name, mode, bench_kbps( BENCH_WRITE_SIZE, erase_ns ), (unsigned)erase_polls,
+          bench_kbps( BENCH_WRITE_SIZE, write_ns ), (unsigned)write_polls,
+          bench_kbps( BENCH_READ_SIZE, read_ns ), (unsigned)st.protocol_errors );
+
+exit:
+  return err;
+}
+
+static void bench_read_complete( sflash_request_t* request, void* arg )
+{
+  bench_read_t* read = arg;
+  uint64_t latency = platform_get_nanosecond_clock_value( ) - read->submitted_ns;
+
+  UNUSED_PARAMETER( request );
+  bench_latency_sum += latency;
+  if( latency > bench_latency_max )
+    bench_latency_max = latency;
+}
+
+/* Stream reads of region B while region A is erased and programmed through the queue */
+static int bench_queue( const bench_device_t* device, const sflash_handle_t* handle, const char* mode )
+{
+  platform_spi_sim_stats_t st;
+  sflash_queue_t queue;
+  sflash_request_t erase, write;
+  bench_read_t* reads = calloc( BENCH_QUEUE_READS, sizeof(bench_read_t) );
+  uint64_t start, next_read, total_ns;
+  int err = 0, submitted = 0, i;
+
+  require_action( reads, exit, err = -1 );
+  bench_latency_sum = bench_latency_max = 0;
+  platform_spi_sim_reset_stats( device->spi );
+  sflash_queue_init( &queue, handle );
+  memset( &erase, 0, sizeof(erase) );
+  erase.type = SFLASH_REQUEST_ERASE;
+  erase.device_address = BENCH_REGION_A;
+  erase.size = BENCH_WRITE_SIZE;
+  memset( &write, 0, sizeof(write) );
+  write.type = SFLASH_REQUEST_WRITE;
+  write.device_address = BENCH_REGION_A;
+  write.data = bench_pattern;
+  write.size = BENCH_WRITE_SIZE;
+
+  start = next_read = platform_get_nanosecond_clock_value( );
+  require_noerr( err = sflash_queue_submit( &queue, &erase ), exit );
+  require_noerr( err = sflash_queue_submit( &queue, &write ), exit );
+  while( 1 ){
+    if( submitted < BENCH_QUEUE_READS && platform_get_nanosecond_clock_value( ) >= next_read ){
+      reads[submitted].request.type = SFLASH_REQUEST_READ;
+      reads[submitted].request.device_address = BENCH_REGION_B + submitted * BENCH_READ_CHUNK;
+      reads[submitted].request.data = reads[submitted].data;
+      reads[submitted].request.size = BENCH_READ_CHUNK;
+      reads[submitted].request.complete = bench_read_complete;
+      reads[submitted].request.arg = &reads[submitted];
+      reads[submitted].submitted_ns = platform_get_nanosecond_clock_value( );
+      require_noerr( err = sflash_queue_submit( &queue, &reads[submitted].request ), exit );
+      submitted++;
+      next_read += BENCH_QUEUE_PERIOD_NS;
+    }
+    if( sflash_queue_process( &queue ) == 0 && submitted == BENCH_QUEUE_READS )
+      break;
+    platform_nanosecond_delay( BENCH_QUEUE_TICK_NS );
+  }
+  total_ns = platform_get_nanosecond_clock_value( ) - start;
+
+  require_action( erase.status == 0 && write.status == 0, exit, err = -1 );
+  for( i = 0; i < BENCH_QUEUE_READS; i++ )
+    require_action( reads[i].request.status == 0 &&
+                    memcmp( reads[i].data, bench_pattern + ( i * BENCH_READ_CHUNK ) % BENCH_WRITE_SIZE, BENCH_READ_CHUNK ) == 0, exit, err = -1 );
+  platform_spi_sim_get_stats( device->spi, &st );
+  printf( "%-12s %-22s erase+program %7.1f ms | %d reads: latency avg %6.2f ms max %6.2f ms, %u during erase | %u polls, %u protocol errors\n",
+          device->name, mode, total_ns / 1e6, BENCH_QUEUE_READS, bench_latency_sum / 1e6 / BENCH_QUEUE_READS,
+          bench_latency_max / 1e6, (unsigned)queue.stats.reads_in_erase, (unsigned)queue.stats.status_polls,
+          (unsigned)st.protocol_errors );
+  /* Suspend on a part without it is an undefined opcode, the model must refuse it */
+  if( ( handle->options & SFLASH_OPTION_ERASE_SUSPEND ) && !device->spi->erase_suspend )
+    require_action( st.protocol_errors > 0, exit, err = -1 );
+  else
+    require_action( st.protocol_errors == 0, exit, err = -1 );
+
+exit:
+  if( reads ) free( reads );
+  return err;
+}
+
+int main( void )
+{
+  sflash_handle_t handle;
+  uint32_t options, i, d;
+  int err = 0;
+
+  for( i = 0; i < BENCH_WRITE_SIZE; i++ )
+    bench_pattern[i] = (uint8_t)( i * 2654435761u >> 24 );
+
+  for( d = 0; d < sizeof(bench_devices) / sizeof(bench_devices[0]); d++ ){
+    const bench_device_t* device = &bench_devices[d];
+
+    bench_spi_config.speed = BENCH_SPI_CLOCK;
+    err = init_sflash( &handle, (void *)device->spi, SFLASH_WRITE_ALLOWED );
+    require_noerr( err, exit );
+    options = handle.options;
+
+    /* As before: READ at its clock limit, byte programming on SST, busy polled back to back */
+    handle.options = 0;
+    bench_spin = 1;
+    bench_spi_config.speed = device->spi->read_max_hz;
+    require_noerr( err = bench_blocking( device, &handle, "READ, spin" ), exit );
+
+    handle.options = options;
+    bench_spin = 0;
+    bench_spi_config.speed = BENCH_SPI_CLOCK;
+    require_noerr( err = bench_blocking( device, &handle, "FAST_READ/AAI, backoff" ), exit );
+
+    /* The region read by the queue holds a known pattern */
+    for( i = 0; i < BENCH_QUEUE_READS * BENCH_READ_CHUNK; i += 0x1000 )
+      require_noerr( err = sflash_sector_erase( &handle, BENCH_REGION_B + i ), exit );
+    for( i = 0; i < BENCH_QUEUE_READS * BENCH_READ_CHUNK; i += BENCH_WRITE_SIZE )
+      require_noerr( err = sflash_write( &handle, BENCH_REGION_B + i, bench_pattern, BENCH_WRITE_SIZE ), exit );
+
+    /* Erase suspend only comes from the JEDEC ID of a part that has it */
+    require_action( !( options & SFLASH_OPTION_ERASE_SUSPEND ) == !device->spi->erase_suspend, exit, err = -1 );
+    if( options & SFLASH_OPTION_ERASE_SUSPEND ){
+      handle.options = options & ~SFLASH_OPTION_ERASE_SUSPEND;
+      require_noerr( err = bench_queue( device, &handle, "queue, no suspend" ), exit );
+      handle.options = options;
+    }else{
+      handle.options = options | SFLASH_OPTION_ERASE_SUSPEND;
+      require_noerr( err = bench_queue( device, &handle, "queue, forced suspend" ), exit );
+      handle.options = options;
+    }
+    require_noerr( err = bench_queue( device, &handle, "queue" ), exit );
+  }
+
+exit:
+  if( err != 0 )
+    printf( "Benchmark failed, err = %d\n", err );
+  return err == 0 ? 0 : 1;
+}
@@ -0,0 +1,441 @@
+/**
+******************************************************************************
+* @file    string_utils_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   StringUtils text kernels against the former byte loops: memmem,
+*          hex and base64 codecs, case-insensitive compares.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench builds StringUtils.c itself:
+ *
+ *    gcc -O2 -std=c99 -Iinclude -Iinclude/MicoDrivers -IPlatform/include -IBoard/EMW3081
+ *        -IPlatform/MCU/Host -ISupport Platform/MCU/Host/string_utils_bench.c
+ *
+ *  Include names follow the Windows tool chains, see flash_sim_bench.c. Run it built with
+ *  -fsanitize=address as well: every string handed to a kernel sits in a heap block of
+ *  exactly its size, at any alignment, so a read past a terminator or a buffer shows.
+ *
+ *  memmem is checked against a brute-force search, the compares and DataToHexString*
+ *  against the byte loops they replaced, the codecs by round trips and RFC 4648 vectors.
+ *  The timed part runs each kernel next to the former code where there is one. The former
+ *  memmem restarts after the bytes it already matched and so misses "ab" in "aab"; its a^29b
+ *  figure is the cost of that wrong answer.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "StringUtils.c"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_RANDOM_CASES      300000
+#define BENCH_CODEC_CASES       20000
+#define BENCH_HAYSTACK          65536
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static uint32_t bench_random( void );
+static double bench_time( void );
+static char *bench_dup( const char *s, size_t len );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static uint32_t bench_seed = 12345;
+static unsigned int bench_failed;
+static const char bench_chars[] = "aAbBzZ@[`{0\x80\xe9";
+
+#define BENCH_CHECK( x )  do{ if( !( x ) ){ printf( "check failed, line %d: %s\n", __LINE__, #x ); bench_failed++; } }while( 0 )
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+/* The former code */
+
+static void *old_memmem( void *start, unsigned int s_len, void *find, unsigned int f_len )
+{
+  char *p, *q;
+  unsigned int len;
+
+  p = start;
+  q = find;
+  len = 0;
+  while( ( p - (char *)start + f_len ) <= s_len ){
+    while( *p++ == *q++ ){
+      len++;
+      if( len == f_len )
+        return( p - f_len );
+    }
+    q = find;
+    len = 0;
+  }
+  return NULL;
+}
+
+static int old_strnicmp( const char *inS1, const char *inS2, size_t inMax )
+{
+  const char *end = inS1 + inMax;
+  int c1, c2;
+
+  while( inS1 < end ){
+    c1 = tolower( *( (const unsigned char *)inS1 ) );
+    c2 = tolower( *( (const unsigned char *)inS2 ) );
+    if( c1 < c2 ) return( -1 );
+    if( c1 > c2 ) return( 1 );
+    if( c1 == '\0' ) break;
+    ++inS1;
+    ++inS2;
+  }
+  return( 0 );
+}
+
+static int old_strnicmpx( const void *inS1, size_t inN, const char *inS2 )
+{
+  const unsigned char *s1 = inS1, *s2 = (const unsigned char *)inS2;
+  int c1, c2;
+
+  while( inN-- > 0 ){
+    c1 = tolower( *s1 );
+    c2 = tolower( *s2 );
+    if( c1 < c2 ) return( -1 );
+    if( c1 > c2 ) return( 1 );
+    if( c2 == 0 ) return( 0 );
+    ++s1;
+    ++s2;
+  }
+  if( *s2 != 0 ) return( -1 );
+  return( 0 );
+}
+
+/* DataToHexString*, one sprintf per byte */
+static char *old_hex( const uint8_t *in, size_t n, const char *sep, int last )
+{
+  char *buf = malloc( 3 * n + 1 ), *p = buf;
+  size_t i;
+
+  for( i = 0; i < n; i++ )
+    p += sprintf( p, ( i == n - 1 && !last ) ? "%02X" : sep, in[i] );
+  *p = 0;
+  return buf;
+}
+
+static void *ref_memmem( const void *h, size_t hl, const void *n, size_t nl )
+{
+  size_t i;
+
+  if( nl == 0 )
+    return (void *)h;
+  for( i = 0; i + nl <= hl; i++ )
+    if( memcmp( (const char *)h + i, n, nl ) == 0 )
+      return (char *)h + i;
+  return NULL;
+}
+
+/* Bench */
+
+static uint32_t bench_random( void )
+{
+  bench_seed = bench_seed * 1103515245 + 12345;
+  return ( bench_seed >> 8 ) & 0xFFFFFF;
+}
+
+static double bench_time( void )
+{
+  struct timespec t;
+
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/* A heap block of exactly len bytes, the terminator included when the string has one */
+static char *bench_dup( const char *s, size_t len )
+{
+  char *p = malloc( len ? len : 1 );
+
+  memcpy( p, s, len );
+  return p;
+}
+
+static void bench_check_memmem( void )
+{
+  unsigned char h[200], n[40];
+  unsigned char *hp, *np;
+  int i, it, hl, nl, al, s;
+  char aab[] = "aab";
+
+  /* small alphabets stress periodic needles */
+  for( it = 0; it < BENCH_RANDOM_CASES; it++ ){
+    hl = bench_random( ) % 200;
+    nl = bench_random( ) % 40;
+    al = 1 + bench_random( ) % 4;
+    for( i = 0; i < hl; i++ )
+      h[i] = 'a' + bench_random( ) % al;
+    if( bench_random( ) % 2 && hl ){
+      s = bench_random( ) % hl;
+      nl = Min( nl, hl - s );
+      memcpy( n, h + s, nl );
+    }else
+      for( i = 0; i < nl; i++ )
+        n[i] = 'a' + bench_random( ) % al;
+    hp = (unsigned char *)bench_dup( (char *)h, hl );
+    np = (unsigned char *)bench_dup( (char *)n, nl );
+    BENCH_CHECK( memmem( hp, hl, np, nl ) == ( ref_memmem( hp, hl, np, nl ) ) );
+    free( hp );
+    free( np );
+  }
+  BENCH_CHECK( old_memmem( aab, 3, "ab", 2 ) == NULL );
+  BENCH_CHECK( memmem( aab, 3, "ab", 2 ) == aab + 1 );
+}
+
+/* Strings in blocks of their exact size, shorter or longer than the compare limit */
+static void bench_check_compare( void )
+{
+  char a[72], b[72];
+  char *pa, *pb;
+  size_t m, n;
+  int i, it, l, c, lb;
+
+  for( it = 0; it < BENCH_RANDOM_CASES; it++ ){
+    l = bench_random( ) % 64;
+    m = bench_random( ) % 72;
+    for( i = 0; i < l; i++ ){
+      c = bench_chars[bench_random( ) % 13];
+      a[i] = c;
+      if( bench_random( ) % 8 == 0 )
+        b[i] = bench_chars[bench_random( ) % 13];
+      else
+        b[i] = bench_random( ) % 2 ? toupper( (unsigned char)c ) : c;
+    }
+    a[l] = 0;
+    lb = l;
+    if( bench_random( ) % 4 == 0 )
+      b[lb++] = 'x';
+    b[lb] = 0;
+    pa = bench_dup( a, l + 1 );
+    pb = bench_dup( b, lb + 1 );
+    BENCH_CHECK( strnicmp( pa, pb, m ) == old_strnicmp( pa, pb, m ) );
+    BENCH_CHECK( strnicmp( pb, pa, m ) == old_strnicmp( pb, pa, m ) );
+
+    /* strnicmpx: inS1 is a buffer of inN bytes without terminator */
+    n = Min( m, (size_t)l );
+    free( pa );
+    pa = bench_dup( a, n );
+    BENCH_CHECK( strnicmpx( pa, n, pb ) == old_strnicmpx( pa, n, pb ) );
+    free( pa );
+    free( pb );
+  }
+  pa = bench_dup( "index.HTML", 11 );
+  BENCH_CHECK( strnicmp_suffix( pa, 32, ".html" ) == 0 );
+  BENCH_CHECK( strnicmp_suffix( pa, 32, ".htm" ) != 0 );
+  free( pa );
+}
+
+static void bench_check_codecs( void )
+{
+  static const char *const vectors[][2] = {
+    { "", "" }, { "f", "Zg==" }, { "fo", "Zm8=" }, { "foo", "Zm9v" },
+    { "foob", "Zm9vYg==" }, { "fooba", "Zm9vYmE=" }, { "foobar", "Zm9vYmFy" },
+  };
+  uint8_t d[100], back[100], o[16];
+  char t[200], *x, *y, *q;
+  size_t n, got, tl;
+  int i, it;
+
+  for( it = 0; it < BENCH_CODEC_CASES; it++ ){
+    n = 1 + bench_random( ) % 99;
+    for( i = 0; i < (int)n; i++ )
+      d[i] = bench_random( );
+    x = DataToHexString( d, n );
+    y = old_hex( d, n, "%02X", 1 );
+    BENCH_CHECK( strcmp( x, y ) == 0 );
+    free( x );
+    free( y );
+    x = DataToHexStringWithSpaces( d, n );
+    y = old_hex( d, n, "%02X ", 1 );
+    BENCH_CHECK( strcmp( x, y ) == 0 );
+    BENCH_CHECK( HexDecode( x, kSizeCString, back, n, &got ) == kNoErr && got == n && memcmp( back, d, n ) == 0 );
+    free( x );
+    free( y );
+    x = DataToHexStringWithColons( d, n );
+    y = old_hex( d, n, "%02X:", 0 );
+    BENCH_CHECK( strcmp( x, y ) == 0 );
+    for( q = x; *q; q++ )
+      *q = tolower( (unsigned char)*q );
+    BENCH_CHECK( HexDecode( x, strlen( x ), back, n, &got ) == kNoErr && got == n && memcmp( back, d, n ) == 0 );
+    BENCH_CHECK( HexDecode( x, strlen( x ), back, n - 1, &got ) == kNoSpaceErr && got == n - 1 );
+    free( x );
+    free( y );
+  }
+  BENCH_CHECK( HexDecode( "abc", 3, o, 4, &got ) == kMalformedErr );
+  BENCH_CHECK( HexDecode( "a:g0", 4, o, 4, &got ) == kMalformedErr );
+  BENCH_CHECK( HexDecode( ":00", 3, o, 4, &got ) == kMalformedErr );
+
+  for( i = 0; i < 7; i++ ){
+    BENCH_CHECK( Base64Encode( vectors[i][0], strlen( vectors[i][0] ), t ) == strlen( vectors[i][1] ) && strcmp( t, vectors[i][1] ) == 0 );
+    BENCH_CHECK( Base64Decode( vectors[i][1], strlen( vectors[i][1] ), o, 16, &got ) == kNoErr &&
+                 got == strlen( vectors[i][0] ) && memcmp( o, vectors[i][0], got ) == 0 );
+  }
+  BENCH_CHECK( Base64Decode( "Zm9v\r\nYmE", kSizeCString, o, 16, &got ) == kNoErr && got == 5 && memcmp( o, "fooba", 5 ) == 0 );
+  BENCH_CHECK( Base64Decode( "Zm9vY", 5, o, 16, &got ) == kMalformedErr );
+  BENCH_CHECK( Base64Decode( "Zg===", 5, o, 16, &got ) == kMalformedErr );
+  BENCH_CHECK( Base64Decode( "Z===", 4, o, 16, &got ) == kMalformedErr );
+  BENCH_CHECK( Base64Decode( "Zg==Zg==", 8, o, 16, &got ) == kMalformedErr );
+  BENCH_CHECK( Base64Decode( "Zm9v!", 5, o, 16, &got ) == kMalformedErr );
+  BENCH_CHECK( Base64Decode( "Zm9vYmFy", 8, o, 5, &got ) == kNoSpaceErr );
+  for( it = 0; it < BENCH_CODEC_CASES; it++ ){
+    n = bench_random( ) % 100;
+    for( i = 0; i < (int)n; i++ )
+      d[i] = bench_random( );
+    tl = Base64Encode( d, n, t );
+    BENCH_CHECK( tl == kBase64EncodedSize( n ) );
+    x = bench_dup( t, tl );
+    BENCH_CHECK( Base64Decode( x, tl, back, 100, &got ) == kNoErr && got == n && memcmp( back, d, n ) == 0 );
+    free( x );
+  }
+}
+
+static void bench_speed( void )
+{
+  static const char *const needles[] = { "Content-Length", "\r\n\r\n", "zzzzq", "qx" };
+  static const char *const labels[] = { "Content-Length", "CRLFCRLF", "zzzzq", "qx" };
+  static char h[BENCH_HAYSTACK];
+  void *volatile found;
+  volatile int r;
+  uint8_t d[1024], o[1024];
+  char t[4096], a[256], b[256], *x;
+  double t0, t1, t2;
+  size_t nl, got;
+  int i, j, k;
+
+  printf( "\n%-32s %10s %10s\n", "kernel", "former", "now" );
+  for( i = 0; i < BENCH_HAYSTACK - 1; i++ )
+    h[i] = 'a' + bench_random( ) % 26;
+  h[BENCH_HAYSTACK - 1] = 0;
+  for( k = 0; k < 4; k++ ){
+    nl = strlen( needles[k] );
+    t0 = bench_time( );
+    for( j = 0; j < 200; j++ )
+      found = old_memmem( h, BENCH_HAYSTACK, (void *)needles[k], nl );
+    t1 = bench_time( );
+    for( j = 0; j < 200; j++ )
+      found = memmem( h, BENCH_HAYSTACK, (void *)needles[k], nl );
+    t2 = bench_time( );
+    printf( "memmem %-17s 64K, us %10.1f %10.1f\n", labels[k], ( t1 - t0 ) / 200 / 1e3, ( t2 - t1 ) / 200 / 1e3 );
+  }
+  memset( h, 'a', BENCH_HAYSTACK - 1 );
+  t0 = bench_time( );
+  found = old_memmem( h, BENCH_HAYSTACK - 1, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaab", 30 );
+  t1 = bench_time( );
+  found = memmem( h, BENCH_HAYSTACK - 1, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaab", 30 );
+  t2 = bench_time( );
+  printf( "memmem a^29b in a^n 64K, us      %10.1f %10.1f\n", ( t1 - t0 ) / 1e3, ( t2 - t1 ) / 1e3 );
+  (void)found;
+
+  for( i = 0; i < 1024; i++ )
+    d[i] = bench_random( );
+  t0 = bench_time( );
+  for( j = 0; j < 2000; j++ )
+    free( old_hex( d, 1024, "%02X", 1 ) );
+  t1 = bench_time( );
+  for( j = 0; j < 2000; j++ )
+    free( DataToHexString( d, 1024 ) );
+  t2 = bench_time( );
+  printf( "hex encode 1K, us                %10.2f %10.2f\n", ( t1 - t0 ) / 2000 / 1e3, ( t2 - t1 ) / 2000 / 1e3 );
+  HexEncode( d, 1024, 0, t );
+  t0 = bench_time( );
+  for( j = 0; j < 2000; j++ )
+    HexDecode( t, 2048, o, 1024, &got );
+  t1 = bench_time( );
+  printf( "hex decode 1K, us                %10s %10.2f\n", "-", ( t1 - t0 ) / 2000 / 1e3 );
+  t0 = bench_time( );
+  for( j = 0; j < 2000; j++ )
+    Base64Encode( d, 1024, t );
+  t1 = bench_time( );
+  for( j = 0; j < 2000; j++ )
+    Base64Decode( t, kBase64EncodedSize( 1024 ), o, 1024, &got );
+  t2 = bench_time( );
+  printf( "base64 encode 1K, us             %10s %10.2f\n", "-", ( t1 - t0 ) / 2000 / 1e3 );
+  printf( "base64 decode 1K, us             %10s %10.2f\n", "-", ( t2 - t1 ) / 2000 / 1e3 );
+
+  for( i = 0; i < 255; i++ ){
+    a[i] = 'a' + i % 26;
+    b[i] = toupper( (unsigned char)a[i] );
+  }
+  a[255] = b[255] = 0;
+  for( k = 0; k < 2; k++ ){
+    nl = k ? 255 : 14;
+    x = bench_dup( b, 256 );
+    t0 = bench_time( );
+    for( j = 0; j < 100000; j++ )
+      r = old_strnicmp( a, x, nl );
+    t1 = bench_time( );
+    for( j = 0; j < 100000; j++ )
+      r = strnicmp( a, x, nl );
+    t2 = bench_time( );
+    printf( "strnicmp %3d chars, ns           %10.1f %10.1f\n", (int)nl, ( t1 - t0 ) / 1e5, ( t2 - t1 ) / 1e5 );
+    t0 = bench_time( );
+    for( j = 0; j < 100000; j++ )
+      r = old_strnicmpx( a, nl, x + 255 - nl );
+    t1 = bench_time( );
+    for( j = 0; j < 100000; j++ )
+      r = strnicmpx( a, nl, x + 255 - nl );
+    t2 = bench_time( );
+    printf( "strnicmpx %3d chars, ns          %10.1f %10.1f\n", (int)nl, ( t1 - t0 ) / 1e5, ( t2 - t1 ) / 1e5 );
+    free( x );
+  }
+  (void)r;
+}
+
+int main( void )
+{
+  bench_check_memmem( );
+  bench_check_compare( );
+  bench_check_codecs( );
+  printf( "memmem, compares, codecs: %s\n", bench_failed ? "failed" : "ok" );
+
+  bench_speed( );
+
+  if( bench_failed )
+    printf( "Benchmark failed\n" );
+  return bench_failed ? 1 : 0;
+}
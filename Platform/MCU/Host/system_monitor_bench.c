@@ -0,0 +1,374 @@
+/**
+******************************************************************************
+* @file    system_monitor_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Simulated clock run of the system monitor: named monitors, latency
+*          histograms, and the hang snapshot across the watchdog reset.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench builds MICOSystemMonitor.c itself and runs its thread function on a simulated
+ *  clock, over a simulated 4k NOR sector as the snapshot partition:
+ *
+ *    gcc -O2 -std=c99 -DDEBUG=0 -IMICO -Iinclude -Iinclude/MicoDrivers -IPlatform/include
+ *        -IBoard/EMW3081 -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals -ISupport
+ *        -IExternal -IDemos/COM.MXCHIP.SPP
+ *        Platform/MCU/Host/system_monitor_bench.c Support/CheckSumUtils.c
+ *
+ *  Include names follow the Windows tool chains, see flash_sim_bench.c.
+ *
+ *  Every case boots the monitor over the sector left by the case before, so a snapshot is
+ *  reported by the boot after the hang. Application threads check in with jitter around
+ *  their period, one of them stops in the hang cases. Programming the sector only clears
+ *  bits, like NOR flash, a write over bytes that are not erased counts as corrupt. The
+ *  snapshot write stands for the watchdog reset that follows it. The monitor thread may not
+ *  erase anything once it runs, must reload the watchdog in time and must catch a hang
+ *  within the permitted delay plus one monitor period.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <setjmp.h>
+
+#define __weak  __attribute__((weak))
+
+#include "MICOSystemMonitor.c"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_MONITORS_MAX      200
+#define BENCH_SECTOR_SIZE       0x1000
+#define BENCH_WDG_TIMEOUT       ( DEFAULT_SYSTEM_MONITOR_PERIOD + 1000 )
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef enum
+{
+  BENCH_FLASH_KEEP,             /* whatever the case before left */
+  BENCH_FLASH_GARBAGE,          /* a torn write or old content */
+} bench_flash_t;
+
+typedef struct
+{
+  const char *name;
+  unsigned int monitors;
+  unsigned int unregister;      /* monitors removed after a minute, they stop checking in */
+  int hang;                     /* monitor 0 stops checking in after a minute */
+  bench_flash_t flash;
+  uint32_t duration_ms;
+  int expect_report;            /* boot reports the snapshot of the case before */
+} bench_case_t;
+
+typedef struct
+{
+  mico_system_monitor_t monitor;
+  char name[16];
+  uint32_t period;
+  uint32_t next;
+  uint32_t checkins;
+  int stopped;
+} bench_monitor_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static uint32_t bench_random( void );
+static void bench_app( void );
+static int bench_run( const bench_case_t *c );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const bench_case_t bench_cases[] =
+{
+  { "blank boot, 10 monitors",    10,   0, 0, BENCH_FLASH_KEEP,    10 * 60 * 1000, 0 },
+  { "200 monitors, unregister",  200, 100, 0, BENCH_FLASH_KEEP,    10 * 60 * 1000, 0 },
+  { "hang",                       10,   0, 1, BENCH_FLASH_KEEP,    10 * 60 * 1000, 0 },
+  { "boot after hang",            10,   0, 0, BENCH_FLASH_KEEP,     5 * 60 * 1000, 1 },
+  { "hang, 200 monitors",        200,   0, 1, BENCH_FLASH_KEEP,    10 * 60 * 1000, 0 },
+  { "boot after hang",            10,   0, 1, BENCH_FLASH_KEEP,    10 * 60 * 1000, 1 },
+  { "garbage sector, hang",       10,   0, 1, BENCH_FLASH_GARBAGE, 10 * 60 * 1000, 0 },
+  { "boot after hang",            10,   0, 0, BENCH_FLASH_KEEP,     5 * 60 * 1000, 1 },
+};
+
+static bench_monitor_t bench_monitors[BENCH_MONITORS_MAX];
+static const bench_case_t *bench_case;
+static uint32_t bench_now;
+static uint32_t bench_seed = 1;
+static jmp_buf bench_end;
+
+static uint8_t bench_sector[BENCH_SECTOR_SIZE];
+static int bench_booted;        /* MICOStartSystemMonitor returned */
+static unsigned int bench_boot_erases, bench_run_erases, bench_writes, bench_corrupt;
+static uint32_t bench_last_reload, bench_max_reload_gap, bench_snapshot_time;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+/* MICO RTOS and drivers on the simulated clock */
+
+uint32_t mico_get_time( void )
+{
+  return bench_now;
+}
+
+OSStatus mico_rtos_init_mutex( mico_mutex_t* mutex )
+{
+  *mutex = (mico_mutex_t)1;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_lock_mutex( mico_mutex_t* mutex )
+{
+  (void)mutex;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_unlock_mutex( mico_mutex_t* mutex )
+{
+  (void)mutex;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_create_thread( mico_thread_t* thread, uint8_t priority, const char* name,
+                                  mico_thread_function_t function, uint32_t stack_size, void* arg )
+{
+  (void)thread;
+  (void)priority;
+  (void)name;
+  (void)function;
+  (void)stack_size;
+  (void)arg;
+  return kNoErr;
+}
+
+/* The monitor sleeps, the application threads run meanwhile */
+void msleep( uint32_t milliseconds )
+{
+  uint32_t wake = bench_now + milliseconds;
+
+  while( (int32_t)( wake - bench_now ) > 0 ){
+    bench_now++;
+    bench_app( );
+  }
+  if( bench_now >= bench_case->duration_ms )
+    longjmp( bench_end, 1 );
+}
+
+OSStatus MicoWdgInitialize( uint32_t timeout )
+{
+  (void)timeout;
+  bench_last_reload = bench_now;
+  return kNoErr;
+}
+
+void MicoWdgReload( void )
+{
+  if( bench_now - bench_last_reload > bench_max_reload_gap )
+    bench_max_reload_gap = bench_now - bench_last_reload;
+  bench_last_reload = bench_now;
+}
+
+OSStatus MicoFlashErase( mico_partition_t inPartition, uint32_t off_set, uint32_t size )
+{
+  if( inPartition != MICO_SYSTEM_MONITOR_SNAPSHOT_PARTITION || off_set + size > BENCH_SECTOR_SIZE )
+    return kParamErr;
+  memset( bench_sector, 0xFF, BENCH_SECTOR_SIZE );
+  if( bench_booted )
+    bench_run_erases++;
+  else
+    bench_boot_erases++;
+  return kNoErr;
+}
+
+/* Programming only clears bits, and the watchdog resets the system right after the snapshot */
+OSStatus MicoFlashWrite( mico_partition_t inPartition, volatile uint32_t* off_set, uint8_t* inBuffer, uint32_t inBufferLength )
+{
+  uint32_t i;
+
+  if( inPartition != MICO_SYSTEM_MONITOR_SNAPSHOT_PARTITION || *off_set + inBufferLength > BENCH_SECTOR_SIZE )
+    return kParamErr;
+  for( i = 0; i < inBufferLength; i++ ){
+    if( bench_sector[*off_set + i] != 0xFF )
+      bench_corrupt++;
+    bench_sector[*off_set + i] &= inBuffer[i];
+  }
+  *off_set += inBufferLength;
+  bench_writes++;
+  bench_snapshot_time = bench_now;
+  longjmp( bench_end, 2 );
+  return kNoErr;
+}
+
+OSStatus MicoFlashRead( mico_partition_t inPartition, volatile uint32_t* off_set, uint8_t* outBuffer, uint32_t inBufferLength )
+{
+  if( inPartition != MICO_SYSTEM_MONITOR_SNAPSHOT_PARTITION || *off_set + inBufferLength > BENCH_SECTOR_SIZE )
+    return kParamErr;
+  memcpy( outBuffer, &bench_sector[*off_set], inBufferLength );
+  *off_set += inBufferLength;
+  return kNoErr;
+}
+
+/* Bench */
+
+static uint32_t bench_random( void )
+{
+  bench_seed = bench_seed * 1103515245 + 12345;
+  return ( bench_seed >> 8 ) & 0xFFFFFF;
+}
+
+/* Application threads check in each ms they are due, up to a quarter period late */
+static void bench_app( void )
+{
+  bench_monitor_t *m;
+  unsigned int i;
+
+  for( i = 0; i < bench_case->monitors; i++ ){
+    m = &bench_monitors[i];
+    if( m->stopped || bench_now != m->next )
+      continue;
+    if( bench_now >= 60000 && ( ( bench_case->hang && i == 0 ) || i < bench_case->unregister ) ){
+      if( i < bench_case->unregister )
+        MICOUnregisterSystemMonitor( &m->monitor );
+      m->stopped = 1;
+      continue;
+    }
+    MICOUpdateSystemMonitor( &m->monitor, m->period * 2 );
+    m->checkins++;
+    m->next = bench_now + m->period * 3 / 4 + bench_random( ) % ( m->period / 2 + 1 );
+  }
+}
+
+static int bench_run( const bench_case_t *c )
+{
+  struct timespec t0, t1;
+  unsigned int i, bin, checkins = 0, counted = 0, errors = 0;
+  uint32_t detect = 0, reported;
+  double cpu;
+  int ended;
+
+  bench_case = c;
+  bench_now = 0;
+  bench_booted = 0;
+  bench_boot_erases = bench_run_erases = bench_writes = bench_corrupt = 0;
+  bench_max_reload_gap = 0;
+  bench_snapshot_time = 0;
+  if( c->flash == BENCH_FLASH_GARBAGE )
+    for( i = 0; i < BENCH_SECTOR_SIZE; i++ )
+      bench_sector[i] = (uint8_t)bench_random( );
+
+  /* a fresh boot */
+  last_hang_uptime = 0;
+  memset( &last_hang, 0x0, sizeof(last_hang) );
+  if( MICOStartSystemMonitor( NULL ) != kNoErr ){
+    printf( "%-26s start failed\n", c->name );
+    return 1;
+  }
+  bench_booted = 1;
+  reported = last_hang_uptime;
+
+  for( i = 0; i < c->monitors; i++ ){
+    bench_monitor_t *m = &bench_monitors[i];
+    memset( m, 0x0, sizeof(bench_monitor_t) );
+    snprintf( m->name, sizeof(m->name), i == 0 && c->hang ? "stuck" : "app %u", i );
+    m->period = 50 + bench_random( ) % 1000;
+    m->next = 1 + bench_random( ) % m->period;
+    MICORegisterNamedSystemMonitor( &m->monitor, m->name, m->period * 2 );
+  }
+
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &t0 );
+  ended = setjmp( bench_end );
+  if( ended == 0 )
+    mico_system_monitor_thread_main( NULL );
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &t1 );
+  cpu = ( t1.tv_sec - t0.tv_sec ) + ( t1.tv_nsec - t0.tv_nsec ) / 1e9;
+
+  for( i = 0; i < c->monitors; i++ ){
+    checkins += bench_monitors[i].checkins;
+    if( i < c->unregister )
+      continue;
+    for( bin = 0; bin < MICO_SYSTEM_MONITOR_HISTOGRAM_BINS; bin++ )
+      counted += bench_monitors[i].monitor.histogram[bin];
+    if( counted > checkins )
+      errors++;
+  }
+  if( c->unregister == 0 && counted != checkins )
+    errors++;
+
+  if( c->hang ){
+    /* monitor 0 last checked in before 60 s, at most its permitted delay and a period before */
+    detect = bench_snapshot_time - bench_monitors[0].monitor.last_update;
+    if( ended != 2 || detect > bench_monitors[0].monitor.longest_permitted_delay + DEFAULT_SYSTEM_MONITOR_PERIOD )
+      errors++;
+  }else if( ended != 1 )
+    errors++;
+  if( bench_max_reload_gap >= BENCH_WDG_TIMEOUT )
+    errors++;
+  if( bench_run_erases || bench_corrupt )
+    errors++;
+  if( c->expect_report != ( reported != 0 ) )
+    errors++;
+  if( c->expect_report && strcmp( last_hang.name, "stuck" ) != 0 )
+    errors++;
+
+  printf( "%-26s %8u %8u %8u %6u %5u %5u %7u %8u %9u %8.0f\n", c->name, c->monitors, checkins, counted,
+          bench_boot_erases, bench_run_erases, bench_writes, bench_corrupt, bench_max_reload_gap,
+          c->hang ? detect : 0, checkins ? cpu / checkins * 1e9 : 0 );
+  if( c->expect_report )
+    printf( "  reported \"%s\" at %ums, no checkin for %ums, permitted %ums\n", last_hang.name,
+            last_hang_uptime, last_hang.since_update, last_hang.permitted );
+  return errors;
+}
+
+int main( void )
+{
+  unsigned int i;
+  int failed = 0;
+
+  memset( bench_sector, 0xFF, BENCH_SECTOR_SIZE );
+  printf( "snapshot %u bytes, monitor period %d ms, watchdog %d ms\n\n", (unsigned int)sizeof(system_monitor_snapshot_t),
+          DEFAULT_SYSTEM_MONITOR_PERIOD, BENCH_WDG_TIMEOUT );
+  printf( "%-26s %8s %8s %8s %6s %5s %5s %7s %8s %9s %8s\n", "case", "monitors", "checkins", "counted",
+          "boot e", "run e", "write", "corrupt", "wdg gap", "detect ms", "ns/chk" );
+  for( i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++ )
+    if( bench_run( &bench_cases[i] ) )
+      failed = 1;
+
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
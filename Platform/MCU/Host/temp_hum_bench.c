@@ -0,0 +1,406 @@
+/**
+******************************************************************************
+* @file    temp_hum_bench.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Test of the MiCOKit-EXT temperature && humidity sampler on a mock I2C bus
+*          replaying BME280 register dumps: compensation, filters, publish rate and
+*          bus transactions per sample.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench is the board of the sampler: the I2C port table with a BME280 register file and DHT11
+ *  stubs, the DHT11 is never asked for as the BME280 answers. Built like oled_bench.c:
+ *
+ *    gcc -O2 -DNO_MICO_RTOS -DUSE_MiCOKit_EXT -DArduino_I2C=MICO_I2C_1 -DArduino_D8=MICO_GPIO_1
+ *        -ffunction-sections -fdata-sections -Wl,--gc-sections
+ *        -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals -IBoard/EMW3081 -IPlatform/include
+ *        -Iinclude -Iinclude/MicoDrivers -IPlatform/Drivers/MiCOKit_EXT
+ *        -IPlatform/Drivers/MiCOKit_EXT/temp_hum_sensor -IPlatform/Drivers/MiCOKit_EXT/temp_hum_sensor/BME280
+ *        Platform/MCU/Host/temp_hum_bench.c Platform/MCU/Host/platform_init.c
+ *        Platform/MCU/Host/peripherals/platform_i2c.c Platform/MCU/mico_platform_common.c
+ *        Platform/Drivers/MiCOKit_EXT/temp_hum_sensor/BME280/bme280.c temp_hum_sensor.o bme280_user.o -lm
+ *
+ *  where temp_hum_sensor.o and bme280_user.o are built with the same flags plus -std=c99. The
+ *  sampler thread is not started, the bench calls temp_hum_sampler_process once per period on
+ *  the virtual clock like the thread does.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "MICOPlatform.h"
+#include "platform_peripheral.h"
+#include "temp_hum_sensor.h"
+#include "bme280.h"
+#include "bme280_user.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_BME280_ADDRESS    (0x76)
+#define BENCH_DATA_REG          (0xF7)      /* press_msb, the first of the 8 data registers */
+#define BENCH_DUMPS             (16)
+#define BENCH_PERIOD_MS         (100)
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+/* Data registers 0xF7-0xFE of a BME280 in normal mode, captured once per 100 ms */
+static const uint8_t bench_dumps[BENCH_DUMPS][8] =
+{
+  { 0x65, 0x51, 0xA0, 0x7E, 0xEA, 0xA0, 0x75, 0x32 },
+  { 0x65, 0x4B, 0x10, 0x7E, 0xF2, 0x60, 0x74, 0x99 },
+  { 0x65, 0x6A, 0x40, 0x7E, 0xF7, 0xA0, 0x74, 0xB0 },
+  { 0x65, 0x6D, 0x40, 0x7E, 0xF2, 0xD0, 0x74, 0xA9 },
+  { 0x65, 0x68, 0x70, 0x7E, 0xFE, 0x00, 0x75, 0x05 },
+  { 0x65, 0x4D, 0x80, 0x7E, 0xF2, 0x90, 0x75, 0x82 },
+  { 0x65, 0x4C, 0x70, 0x7E, 0xFB, 0x30, 0x75, 0x2B },
+  { 0x65, 0x6B, 0x40, 0x7E, 0xF8, 0x70, 0x75, 0x95 },
+  { 0x65, 0x6C, 0x30, 0x7E, 0xFA, 0x70, 0x75, 0x07 },
+  { 0x65, 0x6D, 0x40, 0x7E, 0xFF, 0x90, 0x74, 0xF3 },
+  { 0x65, 0x6D, 0x70, 0x7F, 0x07, 0xB0, 0x75, 0xAB },
+  { 0x65, 0x56, 0x20, 0x7F, 0x01, 0xC0, 0x75, 0x03 },
+  { 0x65, 0x50, 0x80, 0x7F, 0x0C, 0x60, 0x75, 0x8C },
+  { 0x65, 0x51, 0x30, 0x7F, 0x0C, 0xB0, 0x76, 0x18 },
+  { 0x65, 0x6C, 0x80, 0x7F, 0x0A, 0x60, 0x75, 0xAD },
+  { 0x65, 0x53, 0x90, 0x7F, 0x13, 0xF0, 0x75, 0x50 },
+};
+
+/* Trimming registers 0x88-0xA1 and 0xE1-0xE7, the example values of the BMP280 datasheet
+ * for temperature and pressure */
+static const uint8_t bench_calib_88[26] =
+{
+  0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,                   /* dig_T1..T3 = 27504, 26435, -1000 */
+  0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27, 0x0B,       /* dig_P1..P4 = 36477, -10685, 3024, 2855 */
+  0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6,       /* dig_P5..P8 = 140, -7, 15500, -14600 */
+  0x70, 0x17, 0x00, 0x4B,                               /* dig_P9 = 6000, reserved, dig_H1 = 75 */
+};
+static const uint8_t bench_calib_e1[7] = { 0x6A, 0x01, 0x00, 0x14, 0x04, 0x00, 0x1E };  /* dig_H2..H6 = 362, 0, 324, 0, 30 */
+
+static uint8_t bench_registers[256];
+static uint32_t bench_replayed;
+
+static void bench_before_read( uint8_t first_register, uint16_t length );
+static void bench_after_write( uint8_t first_register, uint16_t length );
+
+const platform_i2c_t platform_i2c_peripherals[MICO_I2C_MAX] =
+{
+  [MICO_I2C_1] =
+  {
+    .address        = BENCH_BME280_ADDRESS,
+    .registers      = bench_registers,
+    .before_read    = bench_before_read,
+    .after_write    = bench_after_write,
+  },
+};
+
+static temp_hum_sample_t bench_published[2];
+static uint32_t bench_publishes;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+uint8_t DHT11_Init( void )
+{
+  return 1;
+}
+
+uint8_t DHT11_Read_Data( uint8_t *temperature, uint8_t *humidity )
+{
+  UNUSED_PARAMETER( temperature );
+  UNUSED_PARAMETER( humidity );
+  return 1;
+}
+
+static void bench_reset_device( void )
+{
+  memset( bench_registers, 0, sizeof(bench_registers) );
+  bench_registers[BME280_CHIP_ID_REG] = 0x60;
+  memcpy( &bench_registers[0x88], bench_calib_88, sizeof(bench_calib_88) );
+  memcpy( &bench_registers[0xE1], bench_calib_e1, sizeof(bench_calib_e1) );
+  memcpy( &bench_registers[BENCH_DATA_REG], bench_dumps[0], 8 );
+}
+
+/* Every read of the data registers gets the next dump, like a new measurement in normal mode */
+static void bench_before_read( uint8_t first_register, uint16_t length )
+{
+  if( first_register <= BENCH_DATA_REG && first_register + length > BENCH_DATA_REG ){
+    memcpy( &bench_registers[BENCH_DATA_REG], bench_dumps[bench_replayed % BENCH_DUMPS], 8 );
+    bench_replayed++;
+  }
+}
+
+/* Soft reset clears the control registers */
+static void bench_after_write( uint8_t first_register, uint16_t length )
+{
+  UNUSED_PARAMETER( length );
+  if( first_register == BME280_RST_REG && bench_registers[BME280_RST_REG] == 0xB6 ){
+    bench_registers[BME280_RST_REG] = 0;
+    bench_registers[BME280_CTRL_HUMIDITY_REG] = 0;
+    bench_registers[BME280_CTRL_MEAS_REG] = 0;
+    bench_registers[BME280_CONFIG_REG] = 0;
+  }
+}
+
+static void bench_uncomp( int dump, int32_t *adc_t, int32_t *adc_p, int32_t *adc_h )
+{
+  const uint8_t *d = bench_dumps[dump % BENCH_DUMPS];
+
+  *adc_p = ( (int32_t)d[0] << 12 ) | ( (int32_t)d[1] << 4 ) | ( d[2] >> 4 );
+  *adc_t = ( (int32_t)d[3] << 12 ) | ( (int32_t)d[4] << 4 ) | ( d[5] >> 4 );
+  *adc_h = ( (int32_t)d[6] << 8 ) | d[7];
+}
+
+/* Floating point compensation of the datasheet, the reference of the fixed point one */
+static void bench_compensate_double( int dump, double *t, double *p, double *h )
+{
+  const double T1 = 27504, T2 = 26435, T3 = -1000;
+  const double P1 = 36477, P2 = -10685, P3 = 3024, P4 = 2855, P5 = 140, P6 = -7, P7 = 15500, P8 = -14600, P9 = 6000;
+  const double H1 = 75, H2 = 362, H3 = 0, H4 = 324, H5 = 0, H6 = 30;
+  int32_t adc_t, adc_p, adc_h;
+  double var1, var2, t_fine;
+
+  bench_uncomp( dump, &adc_t, &adc_p, &adc_h );
+  var1 = ( adc_t / 16384.0 - T1 / 1024.0 ) * T2;
+  var2 = ( adc_t / 131072.0 - T1 / 8192.0 ) * ( adc_t / 131072.0 - T1 / 8192.0 ) * T3;
+  t_fine = var1 + var2;
+  *t = t_fine / 5120.0;
+
+  var1 = t_fine / 2.0 - 64000.0;
+  var2 = var1 * var1 * P6 / 32768.0;
+  var2 = var2 + var1 * P5 * 2.0;
+  var2 = var2 / 4.0 + P4 * 65536.0;
+  var1 = ( P3 * var1 * var1 / 524288.0 + P2 * var1 ) / 524288.0;
+  var1 = ( 1.0 + var1 / 32768.0 ) * P1;
+  *p = 1048576.0 - adc_p;
+  *p = ( *p - var2 / 4096.0 ) * 6250.0 / var1;
+  var1 = P9 * *p * *p / 2147483648.0;
+  var2 = *p * P8 / 32768.0;
+  *p = *p + ( var1 + var2 + P7 ) / 16.0;
+
+  var1 = t_fine - 76800.0;
+  var1 = ( adc_h - ( H4 * 64.0 + H5 / 16384.0 * var1 ) ) * ( H2 / 65536.0 * ( 1.0 + H6 / 67108864.0 * var1 * ( 1.0 + H3 / 67108864.0 * var1 ) ) );
+  var1 = var1 * ( 1.0 - H1 * var1 / 524288.0 );
+  *h = var1 > 100.0 ? 100.0 : ( var1 < 0.0 ? 0.0 : var1 );
+}
+
+static void bench_subscriber( const temp_hum_sample_t *filtered, const temp_hum_sample_t *raw, void *arg )
+{
+  UNUSED_PARAMETER( arg );
+  bench_published[0] = *filtered;
+  bench_published[1] = *raw;
+  bench_publishes++;
+}
+
+static void bench_stats( platform_i2c_sim_stats_t *stats )
+{
+  platform_i2c_sim_get_stats( &platform_i2c_peripherals[MICO_I2C_1], stats );
+  platform_i2c_sim_reset_stats( &platform_i2c_peripherals[MICO_I2C_1] );
+}
+
+static void bench_report( const char *name, uint32_t samples )
+{
+  platform_i2c_sim_stats_t stats;
+
+  bench_stats( &stats );
+  printf( "%-28s %4u transfers %5u bytes read %7.1f us bus per sample\n", name,
+          (unsigned)stats.transfers, (unsigned)stats.bytes_read, (double)stats.bus_ns / 1000 / samples );
+}
+
+static OSStatus bench_sample( uint32_t count )
+{
+  OSStatus err = kNoErr;
+  uint32_t i;
+
+  for( i = 0; i < count && err == kNoErr; i++ ){
+    err = temp_hum_sampler_process( );
+    mico_thread_msleep( BENCH_PERIOD_MS );
+  }
+  return err;
+}
+
+static OSStatus bench_configure( temp_hum_filter_t filter, uint8_t average_len, uint8_t iir_shift, uint32_t publish_period_ms )
+{
+  temp_hum_sampler_config_t config;
+
+  config.sample_period_ms = BENCH_PERIOD_MS;
+  config.publish_period_ms = publish_period_ms;
+  config.filter = filter;
+  config.average_len = average_len;
+  config.iir_shift = iir_shift;
+  bench_replayed = 0;
+  bench_publishes = 0;
+  return temp_hum_sampler_init( &config );
+}
+
+int main( void )
+{
+  static const struct { uint32_t period_ms; uint8_t t_sb; } periods[] =
+  {
+    { 10, BME280_STANDBY_TIME_1_MS }, { 100, BME280_STANDBY_TIME_63_MS }, { 1000, BME280_STANDBY_TIME_500_MS }, { 60000, BME280_STANDBY_TIME_1000_MS },
+  };
+  temp_hum_sample_t history[TEMP_HUM_SAMPLER_HISTORY_LEN];
+  platform_i2c_sim_stats_t stats;
+  double t, p, h, max_t = 0, max_p = 0, max_h = 0;
+  int32_t adc_t, adc_p, adc_h, iir_t = 0, temperature;
+  uint32_t i, n, humidity;
+  int64_t sum;
+  int err = 0, failed = 0;
+
+  bench_reset_device( );
+  err = temp_hum_sensor_init( );
+  bench_report( "init", 1 );
+  require_noerr( err, exit );
+
+  /* Standby time follows the sampling period, the on-chip filter stays off */
+  for( i = 0; i < sizeof(periods) / sizeof(periods[0]); i++ ){
+    err = bme280_sensor_set_period( periods[i].period_ms );
+    require_noerr( err, exit );
+    if( ( bench_registers[BME280_CONFIG_REG] >> 5 ) != periods[i].t_sb || ( bench_registers[BME280_CONFIG_REG] & 0x1C ) != 0 ||
+        ( bench_registers[BME280_CTRL_MEAS_REG] & 0x03 ) != BME280_NORMAL_MODE ){
+      printf( "Period %u ms: config 0x%02X ctrl_meas 0x%02X\n", (unsigned)periods[i].period_ms,
+              bench_registers[BME280_CONFIG_REG], bench_registers[BME280_CTRL_MEAS_REG] );
+      failed = 1;
+    }
+  }
+  bench_stats( &stats );
+
+  /* One data register read per sample as the driver had it */
+  for( i = 0; i < BENCH_DUMPS; i++ ){
+    bme280_read_uncomp_temperature( &adc_t );
+    bme280_read_uncomp_pressure( &adc_p );
+    bme280_read_uncomp_humidity( &adc_h );
+    bme280_compensate_temperature_int32( adc_t );
+    bme280_compensate_pressure_int32( adc_p );
+    bme280_compensate_humidity_int32( adc_h );
+  }
+  bench_report( "per register reads", BENCH_DUMPS );
+
+  /* Raw samples against the floating point compensation */
+  err = bench_configure( TEMP_HUM_FILTER_NONE, 0, 0, 0 );
+  require_noerr( err, exit );
+  err = temp_hum_sampler_subscribe( bench_subscriber, NULL );
+  require_noerr( err, exit );
+  bench_stats( &stats );
+  for( i = 0; i < BENCH_DUMPS; i++ ){
+    err = bench_sample( 1 );
+    require_noerr( err, exit );
+    bench_compensate_double( i, &t, &p, &h );
+    max_t = fmax( max_t, fabs( bench_published[1].temperature - t * 100 ) );
+    max_p = fmax( max_p, fabs( bench_published[1].pressure - p ) );
+    max_h = fmax( max_h, fabs( bench_published[1].humidity / 1024.0 - h ) );
+  }
+  bench_report( "sampler burst", BENCH_DUMPS );
+  bench_compensate_double( BENCH_DUMPS - 1, &t, &p, &h );
+  printf( "Last sample %.2f C %.2f %%RH %u Pa, reference %.2f C %.2f %%RH %.0f Pa\n",
+          bench_published[1].temperature / 100.0, bench_published[1].humidity / 1024.0, (unsigned)bench_published[1].pressure, t, h, p );
+  printf( "Fixed point error: %.2f x 0.01 C, %.2f Pa, %.3f %%RH\n", max_t, max_p, max_h );
+  if( bench_publishes != BENCH_DUMPS || max_t > 1 || max_p > 8 || max_h > 0.01 )
+    failed = 1;
+
+  /* Readers get the latest sample without touching the bus */
+  err = temp_hum_sensor_read( &temperature, &humidity );
+  require_noerr( err, exit );
+  bench_stats( &stats );
+  if( stats.transfers != 0 || temperature != bench_published[0].temperature / 100 || humidity != bench_published[0].humidity / 1024 )
+    failed = 1;
+  n = temp_hum_sampler_history( history, TEMP_HUM_SAMPLER_HISTORY_LEN );
+  for( i = 0; i < n; i++ ){
+    bench_compensate_double( BENCH_DUMPS - 1 - i, &t, &p, &h );
+    if( fabs( history[i].temperature - t * 100 ) > 1 )
+      failed = 1;
+  }
+  if( n != TEMP_HUM_SAMPLER_HISTORY_LEN )
+    failed = 1;
+
+  /* Moving average of 4 is the mean of the 4 newest raw samples */
+  err = bench_configure( TEMP_HUM_FILTER_AVERAGE, 4, 0, 0 );
+  require_noerr( err, exit );
+  for( i = 0; i < 2 * BENCH_DUMPS; i++ ){
+    err = bench_sample( 1 );
+    require_noerr( err, exit );
+    n = temp_hum_sampler_history( history, 4 );
+    for( sum = 0, adc_t = 0; adc_t < (int32_t)n; adc_t++ )
+      sum += history[adc_t].pressure;
+    if( bench_published[0].pressure != (uint32_t)( sum / n ) ){
+      printf( "Average of %u samples: %u, expected %u\n", (unsigned)n, (unsigned)bench_published[0].pressure, (unsigned)( sum / n ) );
+      failed = 1;
+    }
+  }
+
+  /* IIR with shift 2 against the same recursion on the raw samples */
+  err = bench_configure( TEMP_HUM_FILTER_IIR, 0, 2, 0 );
+  require_noerr( err, exit );
+  for( i = 0; i < 2 * BENCH_DUMPS; i++ ){
+    err = bench_sample( 1 );
+    require_noerr( err, exit );
+    iir_t = ( i == 0 ) ? bench_published[1].temperature * 4 : iir_t + bench_published[1].temperature - iir_t / 4;
+    if( bench_published[0].temperature != iir_t / 4 )
+      failed = 1;
+  }
+  printf( "IIR 1/4: last raw %.2f C, filtered %.2f C\n", bench_published[1].temperature / 100.0, bench_published[0].temperature / 100.0 );
+
+  /* 10 samples per second published once a second */
+  err = bench_configure( TEMP_HUM_FILTER_AVERAGE, 10, 0, 1000 );
+  require_noerr( err, exit );
+  err = bench_sample( 50 );
+  require_noerr( err, exit );
+  printf( "50 samples at %u ms, published every 1000 ms: %u callbacks\n", BENCH_PERIOD_MS, (unsigned)bench_publishes );
+  if( bench_publishes != 5 )
+    failed = 1;
+
+  err = temp_hum_sampler_unsubscribe( bench_subscriber, NULL );
+  require_noerr( err, exit );
+  err = bench_sample( 20 );
+  if( bench_publishes != 5 )
+    failed = 1;
+
+  /* A read right after the sampler is set up takes its first sample, as the driver read did */
+  err = bench_configure( TEMP_HUM_FILTER_AVERAGE, 4, 0, 0 );
+  require_noerr( err, exit );
+  bench_stats( &stats );
+  err = temp_hum_sensor_read( &temperature, &humidity );
+  require_noerr( err, exit );
+  bench_stats( &stats );
+  n = temp_hum_sampler_history( history, TEMP_HUM_SAMPLER_HISTORY_LEN );
+  if( stats.transfers != 1 || n != 1 || temperature != history[0].temperature / 100 )
+    failed = 1;
+  err = temp_hum_sensor_read( &temperature, &humidity );
+  require_noerr( err, exit );
+  bench_stats( &stats );
+  if( stats.transfers != 0 || temp_hum_sampler_history( history, TEMP_HUM_SAMPLER_HISTORY_LEN ) != 1 )
+    failed = 1;
+
+exit:
+  if( err != 0 || failed )
+    printf( "Benchmark failed, err = %d\n", err );
+  return ( err == 0 && !failed ) ? 0 : 1;
+}
@@ -0,0 +1,373 @@
+/**
+******************************************************************************
+* @file    timer_service_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Simulated clock run of the timer service: 10k timers across the
+*          tick and mico_get_time wrap, handler jitter, idle wakeups.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench builds MICOTimerService.c itself and runs its thread function on a simulated
+ *  clock, no time passes but the time the bench hands out:
+ *
+ *    gcc -O2 -std=c99 -IMICO -Iinclude -Iinclude/MicoDrivers -IPlatform/include
+ *        -IBoard/EMW3081 -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals
+ *        Platform/MCU/Host/timer_service_bench.c
+ *
+ *  Include names follow the Windows tool chains, see flash_sim_bench.c.
+ *
+ *  The service sleeps in mico_rtos_get_semaphore, which advances the clock. Meanwhile the
+ *  application starts, restarts and stops timers at random, and a timer started with a
+ *  deadline before the service's wakes it early the way a higher priority thread would.
+ *  Some handlers arm their timer again, like the ZC timers do. With jitter, handlers take
+ *  up to a few ms, every wakeup comes up to 5 ms late, and now and then the service thread
+ *  is preempted for hundreds of ms, at any point it reads the clock. A timer may never fire
+ *  before its deadline, and never later than one tick, or than the jitter it was held up
+ *  by. Every timer still armed at the end must have its deadline after the end.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <setjmp.h>
+
+#include "MICOTimerService.c"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_TIMERS_MAX        10000
+#define BENCH_CLOCK_START       ( 0xFFFFFFFFUL - 60000 )   /* mico_get_time wraps after a minute */
+#define BENCH_JIFFIES_START     ( 0xFFFFFFFFUL - 3000 )    /* and the service tick after 30 s */
+#define BENCH_STALL_MS          300
+#define BENCH_WAKEUP_LATE_MS    5
+#define BENCH_HANDLER_MS        2
+
+#define HOUR                    ( 3600ULL * 1000 )
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  const char *name;
+  unsigned int timers;
+  unsigned int periodic_percent;
+  unsigned int action_ms;       /* mean time between application starts and stops, 0 for none */
+  unsigned int rearm_percent;   /* one-shot handlers arming their timer again */
+  uint64_t max_delay_ms;
+  uint64_t duration_ms;
+  int jitter;
+  int wrap;                     /* start just before the tick and clock wrap */
+} bench_case_t;
+
+typedef struct
+{
+  mico_service_timer_t timer;
+  uint64_t due;                 /* simulated ms of the next deadline */
+  uint32_t period;
+  int armed;
+} bench_timer_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static uint32_t bench_random( void );
+static uint64_t bench_delay( uint64_t max );
+static void bench_start( bench_timer_t *t, uint64_t delay, uint32_t period );
+static void bench_handler( void *arg );
+static void bench_action( void );
+static int bench_run( const bench_case_t *c );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const bench_case_t bench_cases[] =
+{
+  { "10k timers, wrap",     10000, 20,      5,   0, 10 * 60 * 1000ULL, 20 * 60 * 1000ULL, 0, 1 },
+  { "10k timers, jitter",   10000,  0,      5,  25, 10 * 60 * 1000ULL, 20 * 60 * 1000ULL, 1, 1 },
+  { "1k timers, 2 days",     1000, 10,   1000,   0, 60 * HOUR,         70 * HOUR,         0, 0 },
+  { "100 timers, 60 h",       100,  0, 600000, 100, 60 * HOUR,         150 * HOUR,        0, 1 },
+  { "2 s + 1 h timer, idle",    2, 50,      0,   0, HOUR,              10 * 60 * 1000ULL, 0, 0 },
+};
+
+static bench_timer_t bench_timers[BENCH_TIMERS_MAX];
+static const bench_case_t *bench_case;
+static uint64_t bench_now;      /* simulated ms since the case started */
+static uint64_t bench_next_action;
+static uint64_t bench_stalled;  /* the service was held up until here */
+static uint32_t bench_seed = 1;
+static int bench_woken;
+static int bench_in_service;    /* the service thread runs its own code */
+static jmp_buf bench_end;
+
+static unsigned int bench_fired, bench_early, bench_late;
+static uint64_t bench_max_late;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+/* MICO RTOS on the simulated clock */
+
+uint32_t mico_get_time( void )
+{
+  /* preempted right before or after reading the clock */
+  if( bench_case->jitter && bench_in_service && bench_random( ) % 2000 == 0 ){
+    bench_now += bench_random( ) % BENCH_STALL_MS;
+    bench_stalled = bench_now;
+  }
+  return (uint32_t)( BENCH_CLOCK_START + bench_now );
+}
+
+OSStatus mico_rtos_init_mutex( mico_mutex_t* mutex )
+{
+  *mutex = (mico_mutex_t)1;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_lock_mutex( mico_mutex_t* mutex )
+{
+  (void)mutex;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_unlock_mutex( mico_mutex_t* mutex )
+{
+  (void)mutex;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_init_semaphore( mico_semaphore_t* semaphore, int count )
+{
+  (void)count;
+  *semaphore = (mico_semaphore_t)1;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_set_semaphore( mico_semaphore_t* semaphore )
+{
+  (void)semaphore;
+  bench_woken = 1;
+  return kNoErr;
+}
+
+/* The service sleeps, the application runs until the timeout or until it wakes the service */
+OSStatus mico_rtos_get_semaphore( mico_semaphore_t* semaphore, uint32_t timeout_ms )
+{
+  uint64_t wake = bench_now + timeout_ms;
+  (void)semaphore;
+
+  bench_in_service = 0;
+
+  if( bench_case->jitter )
+    wake += bench_random( ) % ( BENCH_WAKEUP_LATE_MS + 1 );
+  while( bench_woken == 0 && bench_next_action <= wake && bench_next_action < bench_case->duration_ms ){
+    /* actions held up by a stall of the service run late, time never goes back */
+    if( bench_next_action > bench_now )
+      bench_now = bench_next_action;
+    bench_action( );
+  }
+  if( bench_woken == 0 && wake > bench_now )
+    bench_now = wake;
+  bench_woken = 0;
+  if( bench_now >= bench_case->duration_ms )
+    longjmp( bench_end, 1 );
+  bench_in_service = 1;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_create_thread( mico_thread_t* thread, uint8_t priority, const char* name,
+                                  mico_thread_function_t function, uint32_t stack_size, void* arg )
+{
+  (void)thread;
+  (void)priority;
+  (void)name;
+  (void)function;
+  (void)stack_size;
+  (void)arg;
+  return kNoErr;
+}
+
+OSStatus mico_rtos_push_to_queue( mico_queue_t* queue, void* message, uint32_t timeout_ms )
+{
+  (void)queue;
+  (void)message;
+  (void)timeout_ms;
+  return kNoErr;
+}
+
+/* Bench */
+
+static uint32_t bench_random( void )
+{
+  bench_seed = bench_seed * 1103515245 + 12345;
+  return ( bench_seed >> 8 ) & 0xFFFFFF;
+}
+
+/* 10 ms to max, evenly spread over the orders of magnitude */
+static uint64_t bench_delay( uint64_t max )
+{
+  uint64_t d = 10;
+
+  while( d * 10 < max && bench_random( ) % 2 )
+    d *= 10;
+  return d + (uint64_t)bench_random( ) * bench_random( ) % ( d * 9 < max ? d * 9 : max - d );
+}
+
+static void bench_start( bench_timer_t *t, uint64_t delay, uint32_t period )
+{
+  t->due = bench_now + delay;
+  t->period = period;
+  t->armed = 1;
+  MICOStartServiceTimer( &t->timer, (uint32_t)delay, period );
+}
+
+static void bench_handler( void *arg )
+{
+  bench_timer_t *t = arg;
+  uint64_t late, held;
+
+  if( t->armed == 0 || ( t->period == 0 && MICOServiceTimerIsActive( &t->timer ) ) ){
+    bench_early++;    /* stopped, or a one-shot still in the wheel */
+    return;
+  }
+  bench_in_service = 0;
+  bench_fired++;
+  if( bench_now < t->due )
+    bench_early++;
+  else{
+    late = bench_now - t->due;
+    held = ( bench_stalled > t->due ) ? bench_stalled - t->due : 0;
+    if( late > bench_max_late )
+      bench_max_late = late;
+    if( late >= MICO_TIMER_SERVICE_TICK + held + ( bench_case->jitter ? BENCH_WAKEUP_LATE_MS : 0 ) )
+      bench_late++;
+  }
+
+  if( t->period )
+    t->due += t->period;
+  else
+    t->armed = 0;
+
+  if( bench_case->jitter ){
+    /* the handler itself, and now and then a stall of the whole service */
+    bench_now += bench_random( ) % ( BENCH_HANDLER_MS + 1 );
+    if( bench_random( ) % 2000 == 0 )
+      bench_now += BENCH_STALL_MS;
+    bench_stalled = bench_now;
+  }
+  if( t->period == 0 && bench_random( ) % 100 < bench_case->rearm_percent )
+    bench_start( t, bench_delay( bench_case->jitter ? 1000 : bench_case->max_delay_ms ), 0 );
+  bench_in_service = 1;
+}
+
+static void bench_action( void )
+{
+  bench_timer_t *t = &bench_timers[bench_random( ) % bench_case->timers];
+
+  if( t->armed && bench_random( ) % 3 == 0 ){
+    MICOStopServiceTimer( &t->timer );
+    t->armed = 0;
+  }else{
+    bench_start( t, bench_delay( bench_case->max_delay_ms ), 0 );
+  }
+  bench_next_action += 1 + (uint64_t)bench_random( ) % ( 2 * bench_case->action_ms );
+}
+
+static int bench_run( const bench_case_t *c )
+{
+  struct timespec t0, t1;
+  unsigned int i, missed = 0, errors;
+  double cpu;
+
+  bench_case = c;
+  bench_now = 0;
+  bench_stalled = 0;
+  bench_woken = 0;
+  bench_fired = bench_early = bench_late = 0;
+  bench_max_late = 0;
+  bench_next_action = c->action_ms ? 1 : (uint64_t)-1;
+
+  wheel_running = false;
+  MICOStartTimerService( );
+  if( c->wrap )
+    wheel_now_tick = wheel_jiffies = BENCH_JIFFIES_START;
+
+  for( i = 0; i < c->timers; i++ ){
+    MICOInitServiceTimer( &bench_timers[i].timer, bench_handler, &bench_timers[i] );
+    bench_timers[i].armed = 0;
+    if( c->action_ms == 0 )
+      bench_start( &bench_timers[i], i ? HOUR : 2000, i ? 0 : 2000 );
+    else if( bench_random( ) % 100 < c->periodic_percent ){
+      /* periodic ones in whole ticks, so their deadlines do not drift from the tick */
+      bench_start( &bench_timers[i], bench_delay( c->max_delay_ms ), MICO_TIMER_SERVICE_TICK * ( 1 + bench_random( ) % 1000 ) );
+    }else
+      bench_start( &bench_timers[i], bench_delay( c->max_delay_ms ), 0 );
+  }
+
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &t0 );
+  bench_in_service = 1;
+  if( setjmp( bench_end ) == 0 )
+    _timer_service_thread( NULL );
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &t1 );
+  cpu = ( t1.tv_sec - t0.tv_sec ) + ( t1.tv_nsec - t0.tv_nsec ) / 1e9;
+
+  /* whatever is still armed must not be due yet, allowing for the last tick and wakeup */
+  for( i = 0; i < c->timers; i++ )
+    if( bench_timers[i].armed && bench_timers[i].due + MICO_TIMER_SERVICE_TICK + BENCH_WAKEUP_LATE_MS + BENCH_STALL_MS < bench_now )
+      missed++;
+
+  errors = bench_early + bench_late + missed;
+  printf( "%-24s %8u %10u %9.2f %7u %6u %6u %9llu %9.0f %6u\n", c->name, c->timers, bench_fired,
+          wheel_stats.wakeups / ( bench_now / 1000.0 ), bench_early, bench_late, missed,
+          (unsigned long long)bench_max_late, bench_fired ? cpu / bench_fired * 1e9 : 0, wheel_stats.active );
+  return errors;
+}
+
+int main( void )
+{
+  unsigned int i;
+  int failed = 0;
+
+  printf( "tick %d ms, wheel %d levels of %d slots\n\n", MICO_TIMER_SERVICE_TICK, WHEEL_LEVELS, WHEEL_SIZE );
+  printf( "%-24s %8s %10s %9s %7s %6s %6s %9s %9s %6s\n", "case", "timers", "fired", "wakeup/s",
+          "early", "late", "missed", "max late", "ns/fire", "armed" );
+  for( i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++ )
+    if( bench_run( &bench_cases[i] ) )
+      failed = 1;
+
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
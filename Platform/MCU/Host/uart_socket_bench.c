@@ -0,0 +1,661 @@
+/**
+******************************************************************************
+* @file    uart_socket_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Simulation of the UART socket IRQ and DMA model: line rate throughput,
+*          wakeups per KB and rx notify latency from 115200 baud to 3 Mbaud.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench runs uart_socket.c itself on a simulated RTOS: the uart action task and the
+ *  application are coroutines switched by a scheduler in virtual time, the UART has a 16 byte
+ *  rx FIFO with the rx interrupt at 8 bytes or after 4 idle characters, and tx DMA completes
+ *  after the bytes have left the line:
+ *
+ *    gcc -O2 -no-pie -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast
+ *        -IPlatform/MCU/Host/rtl8711 -Icomponent/common/utilities
+ *        Platform/MCU/Host/uart_socket_bench.c component/common/utilities/uart_socket.c
+ *
+ *  uart_socket.c passes the socket through 32 bit interrupt ids, so the bench allocates from
+ *  a static arena and is linked without PIE to keep that arena below 2 GB.
+ *
+ *  The application echoes everything it reads back through uart_write. Each read costs it
+ *  BENCH_READ_COST_NS plus BENCH_BYTE_COST_NS a byte, so waking it too often eats into the
+ *  time left to keep up with the line. Two traffic patterns are run: a continuous stream, and
+ *  64 byte messages every 10 ms where the latency from the last byte on the line to the read
+ *  that returned it is reported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ucontext.h>
+
+#include "osdep_api.h"
+#include "uart_socket.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define SIM_NEVER               UINT64_MAX
+#define SIM_MAX_TASKS           4
+#define SIM_STACK_SIZE          ( 64 * 1024 )
+#define SIM_ARENA_SIZE          ( 64 * 1024 )
+#define SIM_RX_FIFO             16
+#define SIM_RX_TRIGGER          8
+#define SIM_RX_TIMEOUT_CHARS    4
+
+#define BENCH_FD                3
+#define BENCH_SECONDS           1
+#define BENCH_READ_BUF          512
+#define BENCH_READ_COST_NS      30000
+#define BENCH_BYTE_COST_NS      20
+#define BENCH_MSG_LEN           64
+#define BENCH_MSG_PERIOD_NS     10000000ull
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+typedef enum
+{
+  SIM_READY,
+  SIM_BLOCKED,
+  SIM_DEAD,
+} sim_state_t;
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+struct host_sema
+{
+  u32 count;
+};
+
+typedef struct
+{
+  ucontext_t ctx;
+  sim_state_t state;
+  struct host_sema *wait;       /* NULL while sleeping */
+  uint64_t wake_ns;
+  char *stack;
+  u32 switches;
+} sim_task_t;
+
+typedef struct
+{
+  uint64_t byte_ns;
+  /* rx side of the line */
+  u8 fifo[SIM_RX_FIFO];
+  int fifo_num;
+  int fifo_read;
+  uint64_t rx_timeout_ns;       /* character timeout interrupt */
+  uart_irq_handler irq;
+  uint32_t irq_id;
+  int irq_enabled;
+  u32 irqs;
+  u32 fifo_overrun;
+  /* tx dma */
+  void (*dma_done)( uint32_t id );
+  uint32_t dma_done_id;
+  uint64_t dma_end_ns;
+  char *dma_buf;
+  u32 dma_len;
+} sim_uart_t;
+
+typedef struct
+{
+  const char *name;
+  int stream;                   /* continuous, or BENCH_MSG_LEN messages */
+} bench_traffic_t;
+
+typedef struct
+{
+  const char *name;
+  uart_buf_set_str buf;         /* zeros for uart_open() */
+} bench_config_t;
+
+typedef struct
+{
+  double kb_per_s;              /* read by the application */
+  double irqs_per_kb;
+  double select_per_kb;
+  double switches_per_kb;
+  double dma_per_kb;
+  double latency_avg_ms;
+  double latency_max_ms;
+  u32 lost;
+  u32 errors;
+} bench_result_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static void sim_block( struct host_sema *sema, uint64_t wake_ns );
+static void sim_wake( struct host_sema *sema );
+static void sim_run( void );
+static void sim_rx_byte( void );
+static void bench_application( void *param );
+static int bench_run( int baud, const bench_traffic_t *traffic, const bench_config_t *config, bench_result_t *r );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const int bench_bauds[] = { 115200, 921600, 3000000 };
+
+static const bench_traffic_t bench_traffics[] =
+{
+  { "stream", 1 },
+  { "64B/10ms", 0 },
+};
+
+static const bench_config_t bench_configs[] =
+{
+  { "default", { 0, 0, 0, 0 } },
+  { "4K/2K n1024 i2", { 4096, 2048, 1024, 2 } },
+};
+
+static uint64_t sim_now;
+static sim_task_t sim_tasks[SIM_MAX_TASKS];
+static int sim_task_num;
+static sim_task_t *sim_current;
+static ucontext_t sim_main;
+static sim_uart_t sim_uart;
+
+static u8 sim_arena[SIM_ARENA_SIZE] __attribute__((aligned(8)));
+static u32 sim_arena_used;
+
+/* socket state of the uart fd */
+static int sim_rcvevent;
+static struct host_sema sim_select = { 0 };
+
+/* the far end of the line */
+static uint64_t line_next_ns;   /* next rx byte, SIM_NEVER when all sent */
+static u32 line_sent;
+static u32 line_total;
+static uint64_t *line_end_ns;   /* per byte, when it was completely received */
+static int line_stream;
+
+/* what the application saw */
+static u32 app_read;
+static u32 app_echoed;
+static u32 app_errors;
+static uint64_t app_last_read_ns;
+static double app_latency_sum;
+static uint64_t app_latency_max;
+static u32 app_messages;
+static int app_done;
+static uart_socket_t *app_socket;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+/* RTOS services */
+
+u8 *RtlZmalloc( u32 sz )
+{
+  u8 *p;
+
+  sz = ( sz + 7 ) & ~7u;
+  if( sim_arena_used + sz > SIM_ARENA_SIZE )
+    return NULL;
+  p = sim_arena + sim_arena_used;
+  sim_arena_used += sz;
+  if( (uintptr_t)p + sz > 0x7FFFFFFF ){
+    printf( "Arena above 2 GB, link with -no-pie\n" );
+    exit( 1 );
+  }
+  memset( p, 0, sz );
+  return p;
+}
+
+void RtlMfree( u8 *pbuf, u32 sz )
+{
+  (void)pbuf;
+  (void)sz;
+}
+
+void RtlInitSema( _Sema *sema, u32 init_val )
+{
+  *sema = (struct host_sema *)RtlZmalloc( sizeof(struct host_sema) );
+  (*sema)->count = init_val;
+}
+
+void RtlFreeSema( _Sema *sema )
+{
+  *sema = NULL;
+}
+
+void RtlUpSema( _Sema *sema )
+{
+  if( *sema == NULL )
+    return;
+  (*sema)->count++;
+  sim_wake( *sema );
+}
+
+void RtlUpSemaFromISR( _Sema *sema )
+{
+  RtlUpSema( sema );
+}
+
+u32 RtlDownSemaWithTimeout( _Sema *sema, u32 ms )
+{
+  struct host_sema *s = *sema;
+  uint64_t deadline = ( ms == 0xFFFFFFFF ) ? SIM_NEVER : sim_now + ms * 1000000ull;
+
+  while( s->count == 0 ){
+    if( sim_now >= deadline )
+      return pdFALSE;
+    sim_block( s, deadline );
+  }
+  s->count--;
+  return pdTRUE;
+}
+
+u32 RtlDownSema( _Sema *sema )
+{
+  return RtlDownSemaWithTimeout( sema, 0xFFFFFFFF );
+}
+
+void RtlMsleepOS( u32 ms )
+{
+  sim_block( NULL, sim_now + ms * 1000000ull );
+}
+
+TickType_t xTaskGetTickCount( void )
+{
+  return (TickType_t)( sim_now / 1000000 );
+}
+
+TickType_t xTaskGetTickCountFromISR( void )
+{
+  return xTaskGetTickCount( );
+}
+
+long xTaskCreate( void (*pvTaskCode)( void * ), const char * const pcName, unsigned short usStackDepth,
+                  void *pvParameters, unsigned long uxPriority, void *pxCreatedTask )
+{
+  sim_task_t *t = &sim_tasks[sim_task_num++];
+
+  (void)pcName; (void)usStackDepth; (void)uxPriority; (void)pxCreatedTask;
+  memset( t, 0, sizeof(*t) );
+  t->stack = malloc( SIM_STACK_SIZE );
+  getcontext( &t->ctx );
+  t->ctx.uc_stack.ss_sp = t->stack;
+  t->ctx.uc_stack.ss_size = SIM_STACK_SIZE;
+  t->ctx.uc_link = &sim_main;
+  makecontext( &t->ctx, (void (*)( void ))pvTaskCode, 1, pvParameters );
+  t->state = SIM_READY;
+  return pdPASS;
+}
+
+void vTaskDelete( void *xTaskToDelete )
+{
+  (void)xTaskToDelete;
+  sim_current->state = SIM_DEAD;
+  swapcontext( &sim_current->ctx, &sim_main );
+}
+
+/* lwip socket layer of the uart fd */
+
+int lwip_allocsocketsd( void )
+{
+  return BENCH_FD;
+}
+
+int lwip_close( int s )
+{
+  (void)s;
+  return 0;
+}
+
+void lwip_setsockrcvevent( int fd, int rcvevent )
+{
+  (void)fd;
+  sim_rcvevent = rcvevent;
+}
+
+void lwip_selectevindicate( int fd )
+{
+  (void)fd;
+  sim_select.count = 1;
+  sim_wake( &sim_select );
+}
+
+/* UART */
+
+void serial_init( serial_t *obj, PinName tx, PinName rx )
+{
+  (void)tx;
+  (void)rx;
+  obj->host = &sim_uart;
+}
+
+void serial_free( serial_t *obj )
+{
+  obj->host = NULL;
+}
+
+void serial_baud( serial_t *obj, int baudrate )
+{
+  ( (sim_uart_t *)obj->host )->byte_ns = 10000000000ull / baudrate;
+}
+
+void serial_format( serial_t *obj, int data_bits, SerialParity parity, int stop_bits )
+{
+  (void)obj; (void)data_bits; (void)parity; (void)stop_bits;
+}
+
+void serial_irq_handler( serial_t *obj, uart_irq_handler handler, uint32_t id )
+{
+  ( (sim_uart_t *)obj->host )->irq = handler;
+  ( (sim_uart_t *)obj->host )->irq_id = id;
+}
+
+void serial_irq_set( serial_t *obj, SerialIrq irq, uint32_t enable )
+{
+  if( irq == RxIrq )
+    ( (sim_uart_t *)obj->host )->irq_enabled = enable;
+}
+
+int serial_readable( serial_t *obj )
+{
+  return ( (sim_uart_t *)obj->host )->fifo_num > 0;
+}
+
+int serial_getc( serial_t *obj )
+{
+  sim_uart_t *uart = obj->host;
+  int c = uart->fifo[uart->fifo_read];
+
+  uart->fifo_read = ( uart->fifo_read + 1 ) % SIM_RX_FIFO;
+  uart->fifo_num--;
+  return c;
+}
+
+void serial_putc( serial_t *obj, int c )
+{
+  (void)obj;
+  (void)c;
+}
+
+int32_t serial_send_stream_dma( serial_t *obj, char *ptxbuf, uint32_t len )
+{
+  sim_uart_t *uart = obj->host;
+
+  uart->dma_buf = ptxbuf;
+  uart->dma_len = len;
+  uart->dma_end_ns = sim_now + len * uart->byte_ns;
+  return HAL_OK;
+}
+
+void serial_send_comp_handler( serial_t *obj, void *handler, uint32_t id )
+{
+  ( (sim_uart_t *)obj->host )->dma_done = (void (*)( uint32_t ))handler;
+  ( (sim_uart_t *)obj->host )->dma_done_id = id;
+}
+
+/* Scheduler */
+
+static void sim_block( struct host_sema *sema, uint64_t wake_ns )
+{
+  sim_current->wait = sema;
+  sim_current->wake_ns = wake_ns;
+  sim_current->state = SIM_BLOCKED;
+  swapcontext( &sim_current->ctx, &sim_main );
+}
+
+static void sim_wake( struct host_sema *sema )
+{
+  int i;
+
+  for( i = 0; i < sim_task_num; i++ )
+    if( sim_tasks[i].state == SIM_BLOCKED && sim_tasks[i].wait == sema && sema != NULL )
+      sim_tasks[i].state = SIM_READY;
+}
+
+/* Byte of the far end completes on the line */
+static void sim_rx_byte( void )
+{
+  sim_uart_t *uart = &sim_uart;
+  u8 c = (u8)( line_sent * 7 );
+
+  line_end_ns[line_sent] = sim_now;
+  if( uart->fifo_num == SIM_RX_FIFO ){
+    uart->fifo_overrun++;
+  }else{
+    uart->fifo[( uart->fifo_read + uart->fifo_num ) % SIM_RX_FIFO] = c;
+    uart->fifo_num++;
+  }
+  line_sent++;
+  if( line_sent == line_total )
+    line_next_ns = SIM_NEVER;
+  else if( line_stream || line_sent % BENCH_MSG_LEN )
+    line_next_ns = sim_now + uart->byte_ns;
+  else
+    line_next_ns = ( line_sent / BENCH_MSG_LEN ) * BENCH_MSG_PERIOD_NS + uart->byte_ns;
+
+  if( uart->fifo_num >= SIM_RX_TRIGGER && uart->irq_enabled ){
+    uart->irqs++;
+    uart->rx_timeout_ns = SIM_NEVER;
+    uart->irq( uart->irq_id, RxIrq );
+  }else{
+    uart->rx_timeout_ns = sim_now + SIM_RX_TIMEOUT_CHARS * uart->byte_ns;
+  }
+}
+
+static void sim_run( void )
+{
+  sim_uart_t *uart = &sim_uart;
+  uint64_t next;
+  int i, ran;
+
+  for( ;; ){
+    ran = 0;
+    for( i = 0; i < sim_task_num; i++ ){
+      if( sim_tasks[i].state == SIM_READY ){
+        sim_current = &sim_tasks[i];
+        sim_current->switches++;
+        swapcontext( &sim_main, &sim_current->ctx );
+        ran = 1;
+      }
+    }
+    if( ran )
+      continue;
+
+    next = line_next_ns;
+    if( uart->rx_timeout_ns < next )
+      next = uart->rx_timeout_ns;
+    if( uart->dma_len && uart->dma_end_ns < next )
+      next = uart->dma_end_ns;
+    for( i = 0; i < sim_task_num; i++ )
+      if( sim_tasks[i].state == SIM_BLOCKED && sim_tasks[i].wake_ns < next )
+        next = sim_tasks[i].wake_ns;
+    if( next == SIM_NEVER )
+      return;
+    sim_now = next;
+
+    if( line_next_ns == sim_now )
+      sim_rx_byte( );
+    if( uart->rx_timeout_ns <= sim_now ){
+      uart->rx_timeout_ns = SIM_NEVER;
+      if( uart->fifo_num && uart->irq_enabled ){
+        uart->irqs++;
+        uart->irq( uart->irq_id, RxIrq );
+      }
+    }
+    if( uart->dma_len && uart->dma_end_ns <= sim_now ){
+      /* the far end checks the echo */
+      for( i = 0; i < (int)uart->dma_len; i++ )
+        if( (u8)uart->dma_buf[i] != (u8)( ( app_echoed + i ) * 7 ) )
+          app_errors++;
+      app_echoed += uart->dma_len;
+      uart->dma_len = 0;
+      uart->dma_done( uart->dma_done_id );
+    }
+    for( i = 0; i < sim_task_num; i++ )
+      if( sim_tasks[i].state == SIM_BLOCKED && sim_tasks[i].wake_ns <= sim_now )
+        sim_tasks[i].state = SIM_READY;
+  }
+}
+
+/* The select() loop of uart_socket_example, echoing what it reads */
+static void bench_application( void *param )
+{
+  static u8 buf[BENCH_READ_BUF];
+  uart_socket_t *u = param;
+  struct host_sema *select = &sim_select;
+  uint64_t latency;
+  int i, n;
+
+  while( app_read < line_total ){
+    while( !sim_rcvevent ){
+      sim_select.count = 0;
+      sim_block( select, SIM_NEVER );
+    }
+    n = uart_read( u, buf, sizeof(buf) );
+    if( n <= 0 )
+      continue;
+    for( i = 0; i < n; i++ ){
+      if( buf[i] != (u8)( ( app_read + i ) * 7 ) )
+        app_errors++;
+      if( !line_stream && ( app_read + i + 1 ) % BENCH_MSG_LEN == 0 ){
+        latency = sim_now - line_end_ns[app_read + i];
+        app_latency_sum += latency;
+        app_latency_max = ( latency > app_latency_max ) ? latency : app_latency_max;
+        app_messages++;
+      }
+    }
+    app_read += n;
+    app_last_read_ns = sim_now;
+    if( uart_write( u, buf, n ) != n )
+      app_errors++;
+    sim_block( NULL, sim_now + BENCH_READ_COST_NS + n * BENCH_BYTE_COST_NS );
+  }
+  /* let the echo drain before closing */
+  while( u->ptxwrite != u->ptxread )
+    RtlMsleepOS( 1 );
+  uart_close( u );
+  app_done = 1;
+  vTaskDelete( NULL );
+}
+
+static int bench_run( int baud, const bench_traffic_t *traffic, const bench_config_t *config, bench_result_t *r )
+{
+  uart_set_str set;
+  double kb;
+  int i;
+
+  memset( &sim_uart, 0, sizeof(sim_uart) );
+  sim_uart.rx_timeout_ns = SIM_NEVER;
+  sim_now = 0;
+  sim_task_num = 0;
+  sim_arena_used = 0;
+  sim_rcvevent = 0;
+  sim_select.count = 0;
+  app_read = app_echoed = app_errors = app_messages = 0;
+  app_latency_sum = 0;
+  app_latency_max = 0;
+  app_done = 0;
+
+  line_stream = traffic->stream;
+  line_total = traffic->stream ? baud / 10 * BENCH_SECONDS :
+               (u32)( BENCH_SECONDS * 1000000000ull / BENCH_MSG_PERIOD_NS * BENCH_MSG_LEN );
+  line_end_ns = malloc( line_total * sizeof(line_end_ns[0]) );
+  line_sent = 0;
+  line_next_ns = 10000000000ull / baud;
+
+  memset( &set, 0, sizeof(set) );
+  set.BaudRate = baud;
+  set.number = 8;
+  strcpy( set.UartName, "uart0" );
+  app_socket = config->buf.rx_buf_len ? uart_open_ex( &set, (uart_buf_set_str *)&config->buf ) : uart_open( &set );
+  if( app_socket == NULL )
+    return -1;
+  xTaskCreate( bench_application, "app", 512, app_socket, 1, NULL );
+
+  sim_run( );
+
+  memset( r, 0, sizeof(*r) );
+  kb = app_read / 1024.0;
+  r->kb_per_s = kb / ( app_last_read_ns / 1e9 );
+  r->irqs_per_kb = sim_uart.irqs / kb;
+  r->select_per_kb = app_socket->rx_wakeups / kb;
+  for( i = 0; i < sim_task_num; i++ )
+    r->switches_per_kb += sim_tasks[i].switches / kb;
+  r->dma_per_kb = app_socket->tx_transfers / kb;
+  r->latency_avg_ms = app_messages ? app_latency_sum / app_messages / 1e6 : 0;
+  r->latency_max_ms = app_latency_max / 1e6;
+  r->lost = sim_uart.fifo_overrun + app_socket->rx_overflow;
+  r->errors = app_errors + ( app_done ? 0 : 1 ) + ( app_echoed == app_read ? 0 : 1 );
+
+  for( i = 0; i < sim_task_num; i++ )
+    free( sim_tasks[i].stack );
+  free( line_end_ns );
+  return 0;
+}
+
+int main( void )
+{
+  bench_result_t r;
+  unsigned int b, t, c;
+  int failed = 0;
+
+  printf( "Defaults: rx ring %d, tx ring %d, notify %d bytes or %d idle ticks\n\n",
+          UART_RECV_BUFFER_LEN, UART_SEND_BUFFER_LEN, UART_RX_NOTIFY_BYTES, UART_MAX_DELAY_TIME );
+  printf( "%-8s %-9s %-15s %7s %8s %8s %8s %8s %14s %6s\n", "baud", "traffic", "buffers", "KB/s",
+          "irq/KB", "sel/KB", "ctx/KB", "dma/KB", "latency ms", "lost" );
+  for( b = 0; b < sizeof(bench_bauds) / sizeof(bench_bauds[0]); b++ ){
+    for( t = 0; t < sizeof(bench_traffics) / sizeof(bench_traffics[0]); t++ ){
+      for( c = 0; c < sizeof(bench_configs) / sizeof(bench_configs[0]); c++ ){
+        if( bench_run( bench_bauds[b], &bench_traffics[t], &bench_configs[c], &r ) < 0 ){
+          printf( "uart_open failed\n" );
+          return 1;
+        }
+        printf( "%-8d %-9s %-15s %7.1f %8.1f %8.2f %8.2f %8.2f ", bench_bauds[b], bench_traffics[t].name,
+                bench_configs[c].name, r.kb_per_s, r.irqs_per_kb, r.select_per_kb,
+                r.switches_per_kb, r.dma_per_kb );
+        if( bench_traffics[t].stream )
+          printf( "%14s", "-" );
+        else
+          printf( "%6.2f/%7.2f", r.latency_avg_ms, r.latency_max_ms );
+        printf( " %6u%s\n", (unsigned)r.lost, r.errors ? "  ERRORS" : "" );
+        if( r.errors )
+          failed = 1;
+      }
+    }
+  }
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
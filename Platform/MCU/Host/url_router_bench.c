@@ -0,0 +1,516 @@
+/**
+******************************************************************************
+* @file    url_router_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Single-pass URL parser against the former one, query index, and
+*          URLRouter dispatch on 50 routes and the config server routes.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench builds HTTPUtils.c with the string and URL helpers it uses:
+ *
+ *    gcc -O2 -std=c99 -IMICO -Iinclude -Iinclude/MicoDrivers -IPlatform/include -IBoard/EMW3081
+ *        -IPlatform/MCU/Host -IPlatform/MCU/Host/peripherals -ISupport -IExternal
+ *        -IDemos/COM.MXCHIP.SPP Platform/MCU/Host/url_router_bench.c
+ *
+ *  Include names follow the Windows tool chains, see flash_sim_bench.c.
+ *
+ *  Random URLs made of delimiters are parsed by the former URLParseComponents and by the
+ *  single pass, which must agree on every component, and the query index must agree with a
+ *  plain split on '&' and '='. The router is held to a linear longest-match search over 50
+ *  routes, upper case, paths continuing below a route and broken paths included, and the
+ *  config server table must dispatch its four URLs as MICOConfigServer.c expects. Timings
+ *  put the single pass, the query index and the router next to what callers did before.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "HTTPUtils.c"
+#include "URLUtils.c"
+#include "StringUtils.c"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_RANDOM_CASES      300000
+#define BENCH_ROUTES            50
+#define BENCH_TIMED_LOOPS       200000
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const char *const bench_segments[] = { "config", "ota", "dev", "status", "wifi", "ap", "scan", "log", "time", "gpio" };
+
+/* The table of MICOConfigServer.c */
+static const URLRoute bench_config_routes[] =
+{
+  { "/config-read",       0, NULL },
+  { "/config-write",      0, NULL },
+  { "/config-write-uap",  0, NULL },
+  { "/OTA",               0, NULL },
+};
+
+static char bench_paths[ BENCH_ROUTES ][ 40 ];
+static URLRoute bench_routes[ BENCH_ROUTES ];
+static uint32_t bench_seed = 1;
+static unsigned int bench_failed;
+
+#define BENCH_CHECK( x )  do{ if( !( x ) ){ printf( "check failed, line %d: %s\n", __LINE__, #x ); bench_failed++; } }while( 0 )
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+/* The former URLParseComponents, one scan per component */
+static void bench_former_parse( const char *inSrc, const char *inEnd, URLComponents *out, const char **outSrc )
+{
+  const char *ptr, *schemePtr = NULL, *schemeEnd = NULL, *userPtr = NULL, *userEnd = NULL;
+  const char *passwordPtr = NULL, *passwordEnd = NULL, *hostPtr = NULL, *hostEnd = NULL;
+  const char *pathPtr, *pathEnd, *queryPtr = NULL, *queryEnd = NULL, *fragmentPtr = NULL, *fragmentEnd = NULL;
+  const char *authorityPtr, *authorityEnd, *userInfoEnd;
+  char c;
+
+  if( inEnd == NULL ) inEnd = inSrc + strlen( inSrc );
+
+  c = '\0';
+  ptr = inSrc;
+  while( ( ptr < inEnd ) && ( ( c = *ptr ) != ':' ) && ( c != '/' ) && ( c != '?' ) && ( c != '#' ) ) ++ptr;
+  if( c == ':' )
+  {
+    schemePtr = inSrc;
+    schemeEnd = ptr;
+    inSrc = ptr + 1;
+  }
+
+  if( ( ( inEnd - inSrc ) >= 2 ) && ( inSrc[0] == '/' ) && ( inSrc[1] == '/' ) )
+  {
+    inSrc += 2;
+    authorityPtr = inSrc;
+    while( ( inSrc < inEnd ) && ( ( c = *inSrc ) != '/' ) && ( c != '?' ) && ( c != '#' ) ) ++inSrc;
+    authorityEnd = inSrc;
+    userInfoEnd = authorityPtr;
+    while( ( userInfoEnd < authorityEnd ) && ( *userInfoEnd != '@' ) ) ++userInfoEnd;
+    if( userInfoEnd < authorityEnd )
+    {
+      userPtr = authorityPtr;
+      userEnd = userPtr;
+      while( ( userEnd < userInfoEnd ) && ( *userEnd != ':' ) ) ++userEnd;
+      if( userEnd < userInfoEnd )
+      {
+        passwordPtr = userEnd + 1;
+        passwordEnd = userInfoEnd;
+      }
+      hostPtr = userInfoEnd + 1;
+      hostEnd = authorityEnd;
+    }
+    else
+    {
+      hostPtr = authorityPtr;
+      hostEnd = authorityEnd;
+    }
+  }
+
+  c = '\0';
+  pathPtr = inSrc;
+  while( ( inSrc < inEnd ) && ( ( c = *inSrc ) != '?' ) && ( c != '#' ) ) ++inSrc;
+  pathEnd = inSrc;
+  if( c == '?' )
+  {
+    queryPtr = ++inSrc;
+    while( ( inSrc < inEnd ) && ( ( c = *inSrc ) != '#' ) ) ++inSrc;
+    queryEnd = inSrc;
+  }
+  if( c == '#' )
+  {
+    fragmentPtr = ++inSrc;
+    fragmentEnd = inEnd;
+    inSrc = inEnd;
+  }
+
+  out->schemePtr   = schemePtr;   out->schemeLen   = (size_t)( schemeEnd - schemePtr );
+  out->userPtr     = userPtr;     out->userLen     = (size_t)( userEnd - userPtr );
+  out->passwordPtr = passwordPtr; out->passwordLen = (size_t)( passwordEnd - passwordPtr );
+  out->hostPtr     = hostPtr;     out->hostLen     = (size_t)( hostEnd - hostPtr );
+  out->pathPtr     = pathPtr;     out->pathLen     = (size_t)( pathEnd - pathPtr );
+  out->queryPtr    = queryPtr;    out->queryLen    = (size_t)( queryEnd - queryPtr );
+  out->fragmentPtr = fragmentPtr; out->fragmentLen = (size_t)( fragmentEnd - fragmentPtr );
+  out->segmentPtr  = ( ( pathPtr < pathEnd ) && ( *pathPtr == '/' ) ) ? ( pathPtr + 1 ) : pathPtr;
+  out->segmentEnd  = ( ( pathPtr < pathEnd ) && ( pathEnd[-1] == '/' ) ) ? ( pathEnd - 1 ) : pathEnd;
+  if( outSrc ) *outSrc = inSrc;
+}
+
+static uint32_t bench_random( void )
+{
+  bench_seed = bench_seed * 1103515245 + 12345;
+  return ( bench_seed >> 8 ) & 0xFFFFFF;
+}
+
+static double bench_time( void )
+{
+  struct timespec t;
+
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static bool bench_same_url( const URLComponents *a, const URLComponents *b )
+{
+  return a->schemePtr == b->schemePtr && a->schemeLen == b->schemeLen && a->userPtr == b->userPtr && a->userLen == b->userLen &&
+         a->passwordPtr == b->passwordPtr && a->passwordLen == b->passwordLen && a->hostPtr == b->hostPtr &&
+         a->hostLen == b->hostLen && a->pathPtr == b->pathPtr && a->pathLen == b->pathLen && a->queryPtr == b->queryPtr &&
+         a->queryLen == b->queryLen && a->fragmentPtr == b->fragmentPtr && a->fragmentLen == b->fragmentLen &&
+         a->segmentPtr == b->segmentPtr && a->segmentEnd == b->segmentEnd;
+}
+
+static bool bench_same_query( const URLQueryIndex *a, const URLQueryIndex *b )
+{
+  const URLQueryParam *x, *y;
+  int i;
+
+  if( a->count != b->count || a->truncated != b->truncated )
+    return false;
+  for( i = 0; i < a->count; i++ )
+  {
+    x = &a->params[i];
+    y = &b->params[i];
+    if( x->keyPtr != y->keyPtr || x->keyLen != y->keyLen || x->valuePtr != y->valuePtr || x->valueLen != y->valueLen ||
+        x->escaped != y->escaped )
+      return false;
+  }
+  return true;
+}
+
+/* Split on '&' then '=', empty parameters dropped */
+static void bench_reference_query( const char *q, size_t n, URLQueryIndex *x )
+{
+  const char *end = q + n, *p = q, *amp, *eq, *c;
+  URLQueryParam *param;
+
+  x->count = 0;
+  x->truncated = false;
+  if( !q )
+    return;
+  while( p <= end )
+  {
+    amp = memchr( p, '&', end - p );
+    if( !amp )
+      amp = end;
+    if( amp > p )
+    {
+      if( x->count == kURLQueryMaxParams )
+        x->truncated = true;
+      else
+      {
+        param = &x->params[ x->count++ ];
+        eq = memchr( p, '=', amp - p );
+        param->keyPtr = p;
+        param->keyLen = ( eq ? eq : amp ) - p;
+        param->valuePtr = eq ? eq + 1 : NULL;
+        param->valueLen = eq ? (size_t)( amp - eq - 1 ) : 0;
+        param->escaped = false;
+        for( c = p; c < amp; c++ )
+          if( *c == '%' || *c == '+' )
+            param->escaped = true;
+      }
+    }
+    p = amp + 1;
+  }
+}
+
+static void bench_check_parser( void )
+{
+  static const char alphabet[] = "ab:/?#@&=%+2F:/";
+  URLComponents a, b, c;
+  URLQueryIndex q, q2, r;
+  const char *ea, *eb;
+  char *url;
+  int it, i, len;
+
+  for( it = 0; it < BENCH_RANDOM_CASES; it++ )
+  {
+    len = bench_random( ) % 24;
+    url = malloc( len + 1 );
+    for( i = 0; i < len; i++ )
+      url[i] = alphabet[ bench_random( ) % ( sizeof( alphabet ) - 1 ) ];
+    url[len] = 0;
+    memset( &a, 0x55, sizeof( a ) );
+    memset( &b, 0x55, sizeof( b ) );
+    bench_former_parse( url, url + len, &a, &ea );
+    URLParseComponentsWithQuery( url, url + len, &b, &q, &eb );
+    URLParseComponents( url, NULL, &c, NULL );
+    BENCH_CHECK( bench_same_url( &a, &b ) && ea == eb && bench_same_url( &a, &c ) );
+    bench_reference_query( a.queryPtr, a.queryLen, &r );
+    URLQueryIndexParse( a.queryPtr, a.queryLen, &q2 );
+    BENCH_CHECK( bench_same_query( &q, &r ) && bench_same_query( &q2, &r ) );
+    free( url );
+  }
+}
+
+static void bench_check_query( void )
+{
+  const char *u = "http://tom:pw@host:80/a/b?name=J%C3%B6rg+X&flag&%6Bey=v%2&empty=&x=1#frag";
+  URLComponents c;
+  URLQueryIndex q;
+  char v[32];
+  size_t vl;
+
+  BENCH_CHECK( URLParseComponentsWithQuery( u, NULL, &c, &q, NULL ) == kNoErr && q.count == 5 && !q.truncated );
+  BENCH_CHECK( c.hostLen == 7 && strncmp( c.hostPtr, "host:80", 7 ) == 0 && c.fragmentLen == 4 );
+  BENCH_CHECK( URLQueryCopyValue( &q, "name", v, sizeof( v ), &vl ) == kNoErr && strcmp( v, "J\xC3\xB6rg X" ) == 0 && vl == 7 );
+  BENCH_CHECK( URLQueryCopyValue( &q, "key", v, sizeof( v ), &vl ) == kNoErr && strcmp( v, "v%2" ) == 0 );
+  BENCH_CHECK( URLQueryFind( &q, "flag" ) != NULL && URLQueryFind( &q, "flag" )->valuePtr == NULL );
+  BENCH_CHECK( URLQueryCopyValue( &q, "empty", v, sizeof( v ), &vl ) == kNoErr && v[0] == 0 && vl == 0 );
+  BENCH_CHECK( URLQueryCopyValue( &q, "nope", v, sizeof( v ), &vl ) == kNotFoundErr );
+  BENCH_CHECK( URLQueryCopyValue( &q, "name", v, 4, &vl ) == kSizeErr );
+}
+
+static void bench_build_routes( void )
+{
+  int i;
+
+  for( i = 0; i < BENCH_ROUTES; i++ )
+  {
+    snprintf( bench_paths[i], sizeof( bench_paths[i] ), "/%s-%s%s", bench_segments[ i % 10 ],
+              bench_segments[ ( i / 10 + 3 ) % 10 ], ( i % 7 == 0 ) ? "/" : "" );
+    bench_routes[i].path = bench_paths[i];
+    bench_routes[i].flags = ( i % 5 == 0 ) ? kURLRouteFlagPrefix : 0;
+    bench_routes[i].handler = NULL;
+  }
+}
+
+/* Longest route that is the path, or with kURLRouteFlagPrefix a '/' boundary below it */
+static const URLRoute *bench_reference_route( const char *path, size_t len, size_t *outLen )
+{
+  const URLRoute *best = NULL;
+  size_t pl, bl = 0;
+  int i;
+
+  for( i = 0; i < BENCH_ROUTES; i++ )
+  {
+    pl = strlen( bench_routes[i].path );
+    if( pl > len || strnicmp( bench_routes[i].path, path, pl ) != 0 )
+      continue;
+    if( pl == len || ( ( bench_routes[i].flags & kURLRouteFlagPrefix ) && ( path[pl] == '/' || bench_routes[i].path[pl - 1] == '/' ) ) )
+    {
+      if( pl >= bl )
+      {
+        best = &bench_routes[i];
+        bl = pl;
+      }
+    }
+  }
+  *outLen = bl;
+  return best;
+}
+
+static void bench_check_router( const URLRouter *router )
+{
+  static const URLRoute duplicates[] = { { "/a", 0, NULL }, { "/A", 0, NULL } };
+  const URLRoute *got, *want;
+  const char *rest;
+  size_t len, restLen, wantLen;
+  URLRouter dup;
+  char path[64];
+  char *p;
+  int it, k, mode;
+
+  for( it = 0; it < BENCH_RANDOM_CASES; it++ )
+  {
+    k = bench_random( ) % BENCH_ROUTES;
+    mode = bench_random( ) % 4;
+    strcpy( path, bench_paths[k] );
+    if( mode == 1 )
+      for( p = path; *p; p++ )
+        *p = toupper( (unsigned char)*p );
+    if( mode == 2 )
+      strcat( path, "/sub/x" );
+    if( mode == 3 )
+      path[ bench_random( ) % strlen( path ) ] = 'Z';
+    len = strlen( path );
+    p = malloc( len );
+    memcpy( p, path, len );
+    want = bench_reference_route( p, len, &wantLen );
+    got = URLRouterMatch( router, p, len, &rest, &restLen );
+    BENCH_CHECK( got == want && ( !got || ( rest == p + wantLen && restLen == len - wantLen ) ) );
+    free( p );
+  }
+  BENCH_CHECK( URLRouterInit( &dup, duplicates, 2 ) == kDuplicateErr && dup.nodes == NULL );
+}
+
+/* Requests as the config server gets them, routed as in _LocalConfigRespondInComingMessage */
+static void bench_check_config_server( void )
+{
+  static const struct { const char *request; int route; } cases[] =
+  {
+    { "GET /config-read HTTP/1.1\r\n\r\n",                 0 },
+    { "POST /config-write HTTP/1.1\r\n\r\n",               1 },
+    { "POST /config-write-uap HTTP/1.1\r\n\r\n",           2 },
+    { "POST /OTA HTTP/1.1\r\n\r\n",                        3 },
+    { "GET /CONFIG-READ?pretty=1 HTTP/1.1\r\n\r\n",        0 },
+    { "GET http://10.10.10.1:8000/ota HTTP/1.1\r\n\r\n",   3 },
+    { "POST /config-writes HTTP/1.1\r\n\r\n",             -1 },
+    { "POST /config-write/ HTTP/1.1\r\n\r\n",             -1 },
+    { "GET /x/config-read HTTP/1.1\r\n\r\n",              -1 },
+    { "GET / HTTP/1.1\r\n\r\n",                           -1 },
+  };
+  static HTTPHeader_t header;
+  const URLRoute *route;
+  URLRouter router;
+  int k;
+
+  BENCH_CHECK( URLRouterInit( &router, bench_config_routes, 4 ) == kNoErr );
+  for( k = 0; k < (int)( sizeof( cases ) / sizeof( cases[0] ) ); k++ )
+  {
+    memset( &header, 0, sizeof( header ) );
+    header.len = strlen( cases[k].request );
+    memcpy( header.buf, cases[k].request, header.len );
+    BENCH_CHECK( HTTPHeaderParse( &header ) == kNoErr );
+    route = HTTPHeaderRouteURL( &header, &router, NULL, NULL );
+    BENCH_CHECK( route == ( cases[k].route < 0 ? NULL : &bench_config_routes[ cases[k].route ] ) );
+  }
+  URLRouterFree( &router );
+}
+
+static void bench_speed( const URLRouter *router )
+{
+  static const char *const keys[] = { "ssid", "key", "dhcp", "ip", "mask" };
+  static const char *const searches[] = { "ssid=", "key=", "dhcp=", "ip=", "mask=" };
+  static const char query[] = "ssid=My+AP&key=pa%24%24&dhcp=1&ip=10.0.0.2&mask=255.255.255.0";
+  static char urls[ BENCH_ROUTES ][ 96 ];
+  static HTTPHeader_t header;
+  volatile size_t sink = 0;
+  const URLQueryParam *param;
+  const URLRoute *route;
+  URLComponents c;
+  URLQueryIndex q;
+  double t0, t1, t2, t3;
+  char *found;
+  int i, j, k, hit;
+
+  for( i = 0; i < BENCH_ROUTES; i++ )
+  {
+    if( i % 3 == 0 )
+      snprintf( urls[i], sizeof( urls[i] ), "%.39s?ssid=My+AP&key=pa%%24%%24&dhcp=1", bench_paths[i] );
+    else if( i % 3 == 1 )
+      snprintf( urls[i], sizeof( urls[i] ), "http://10.0.0.%d:8000%.39s#top", i, bench_paths[i] );
+    else
+      snprintf( urls[i], sizeof( urls[i] ), "%.39s", bench_paths[i] );
+  }
+
+  t0 = bench_time( );
+  for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+  {
+    bench_former_parse( urls[ j % BENCH_ROUTES ], NULL, &c, NULL );
+    sink += c.pathLen;
+  }
+  t1 = bench_time( );
+  for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+  {
+    URLParseComponents( urls[ j % BENCH_ROUTES ], NULL, &c, NULL );
+    sink += c.pathLen;
+  }
+  t2 = bench_time( );
+  for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+  {
+    URLParseComponentsWithQuery( urls[ j % BENCH_ROUTES ], NULL, &c, &q, NULL );
+    sink += q.count;
+  }
+  t3 = bench_time( );
+  printf( "\nparse 50 URLs: former %.0f ns, one pass %.0f ns, with query index %.0f ns\n", ( t1 - t0 ) / BENCH_TIMED_LOOPS,
+          ( t2 - t1 ) / BENCH_TIMED_LOOPS, ( t3 - t2 ) / BENCH_TIMED_LOOPS );
+
+  t0 = bench_time( );
+  for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+    for( k = 0; k < 5; k++ )
+    {
+      found = strnstr_suffix( query, sizeof( query ) - 1, searches[k] );
+      sink += found ? (size_t)( found - query ) : 0;
+    }
+  t1 = bench_time( );
+  for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+  {
+    URLQueryIndexParse( query, sizeof( query ) - 1, &q );
+    for( k = 0; k < 5; k++ )
+    {
+      param = URLQueryFind( &q, keys[k] );
+      sink += param ? param->valueLen : 0;
+    }
+  }
+  t2 = bench_time( );
+  printf( "5 query parameters: a search each %.0f ns, index and find %.0f ns\n", ( t1 - t0 ) / BENCH_TIMED_LOOPS,
+          ( t2 - t1 ) / BENCH_TIMED_LOOPS );
+
+  /* dispatch of a parsed request: HTTPHeaderMatchURL route by route against one router lookup */
+  t0 = bench_time( );
+  for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+  {
+    header.url.pathPtr = bench_paths[ ( j * 7 ) % BENCH_ROUTES ];
+    header.url.pathLen = strlen( header.url.pathPtr );
+    for( hit = 0; hit < BENCH_ROUTES && HTTPHeaderMatchURL( &header, bench_routes[hit].path ) != kNoErr; hit++ ) {}
+    sink += hit;
+  }
+  t1 = bench_time( );
+  for( j = 0; j < BENCH_TIMED_LOOPS; j++ )
+  {
+    header.url.pathPtr = bench_paths[ ( j * 7 ) % BENCH_ROUTES ];
+    header.url.pathLen = strlen( header.url.pathPtr );
+    route = HTTPHeaderRouteURL( &header, router, NULL, NULL );
+    sink += route ? (size_t)( route - bench_routes ) : 0;
+  }
+  t2 = bench_time( );
+  printf( "dispatch on 50 routes: HTTPHeaderMatchURL each %.0f ns, HTTPHeaderRouteURL %.0f ns\n",
+          ( t1 - t0 ) / BENCH_TIMED_LOOPS, ( t2 - t1 ) / BENCH_TIMED_LOOPS );
+  (void)sink;
+}
+
+int main( void )
+{
+  URLRouter router;
+
+  bench_build_routes( );
+  BENCH_CHECK( URLRouterInit( &router, bench_routes, BENCH_ROUTES ) == kNoErr );
+
+  bench_check_parser( );
+  bench_check_query( );
+  bench_check_router( &router );
+  bench_check_config_server( );
+  printf( "parser, query index, router: %s (%d nodes for %d routes)\n", bench_failed ? "failed" : "ok", router.nodeCount, BENCH_ROUTES );
+
+  bench_speed( &router );
+  URLRouterFree( &router );
+
+  if( bench_failed )
+    printf( "Benchmark failed\n" );
+  return bench_failed ? 1 : 0;
+}
@@ -0,0 +1,652 @@
+/**
+******************************************************************************
+* @file    uvc_rtp_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Loopback harness of the UVC MJPEG RTP sender: recorded or synthetic
+*          JPEG frames over UDP unicast, RTSP interleaved TCP and multicast.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The sender is the one of example_uvc.c with UVC_RTP_ZERO_COPY: every frame goes through
+ *  mjpeg_packetizer and each fragment is joined in front of its data inside the frame, or
+ *  copied when there is no room. A receiver thread on the other end of the loopback checks
+ *  the RTP sequence, the fragment offsets and the marker bit of every frame.
+ *
+ *    gcc -O2 -DUSE_STM324xG_EVAL -IPlatform/MCU/Host/rtl8711 -Icomponent/common/api
+ *        -Icomponent/common/media/codec/mjpeg
+ *        Platform/MCU/Host/uvc_rtp_bench.c component/common/media/codec/mjpeg/mjpeg_packetizer.c
+ *        -lpthread
+ *
+ *    uvc_rtp_bench [file.mjpeg]    frames of a recorded stream (JPEGs back to back), or
+ *                                  synthetic 640x480 and 1280x720 4:2:0 frames when no
+ *                                  file is given
+ *
+ *  Before streaming, the packetizer is checked on its own: a restart interval appearing or
+ *  going away must force a new header parse, a frame wider or higher than the 8 bit block
+ *  counts of RFC 2435 can carry must be refused, a payload size too small for the headers must
+ *  still give packets that fit it and carry data, and a copied fragment must be byte for byte
+ *  the packet a join builds, with the frame left untouched after the unjoin.
+ *
+ *  The packetizer CPU time of a frame is then taken without sockets, best of BENCH_CPU_ROUNDS
+ *  in process CPU time, joining and copying the fragments, along with the fragment copies and
+ *  scan bytes per frame the join leaves out.
+ *
+ *  Every mode runs twice, once joining the headers in front of the frame data and once copying
+ *  every fragment as example_uvc.c does when a frame has no headroom. Send latency is the wall
+ *  time spent in the send calls of one frame; fps and bytes/s are what the loopback sustains,
+ *  not what the target radio would.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "mjpeg_packetizer.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_FRAMES            600
+#define BENCH_MAX_FRAMES        64            /* distinct frames kept in memory */
+#define BENCH_FRAME_MAX         (256 * 1024)
+#define BENCH_CPU_ROUNDS        5
+#define BENCH_PORT              45540
+#define BENCH_GROUP             "239.255.0.1" /* UVC_RTP_MULTICAST_GROUP */
+#define BENCH_CHANNEL           2             /* interleaved= of a SETUP */
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+typedef enum
+{
+  BENCH_UDP,
+  BENCH_TCP,
+  BENCH_MULTICAST,
+  BENCH_MODES,
+} bench_mode_t;
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  int width;
+  int height;
+  int scan;                     /* entropy coded bytes of the largest synthetic frame */
+} bench_size_t;
+
+typedef struct
+{
+  u8 *data;
+  int len;
+} bench_frame_t;
+
+typedef struct
+{
+  int socket;
+  int stream;                   /* interleaved frames on a TCP stream */
+  volatile int stop;
+  u32 packets;
+  u32 frames;                   /* marker bits seen */
+  u32 bytes;
+  u32 seq_errors;
+  u32 offset_errors;
+  u32 frame_bytes;              /* scan bytes of the frame being received */
+  int have_seq;
+  u16 seq;
+} bench_receiver_t;
+
+typedef struct
+{
+  u32 frames;
+  u32 packets;
+  u32 bytes;
+  u32 copied;
+  double seconds;
+  double latency_sum;
+  double latency_max;
+} bench_result_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static double bench_now( void );
+static double bench_cpu_time( void );
+static int bench_load( const char *path );
+static void bench_synthesize( const bench_size_t *size );
+static void *bench_receive( void *arg );
+static int bench_open( bench_mode_t mode, bench_receiver_t *rx, int *tx, struct sockaddr_in *to );
+static int bench_check_packetizer( void );
+static int bench_packetize( int copy, double *us, double *copies, double *copied );
+static int bench_send_frame( int socket, struct sockaddr_in *to, int channel, bench_frame_t *frame, bench_result_t *result );
+static int bench_run( bench_mode_t mode, bench_result_t *result, bench_receiver_t *rx );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+static const char *bench_mode_names[BENCH_MODES] = { "udp", "tcp", "multicast" };
+
+static const char *bench_path_names[2] = { "join", "copy" };
+
+static const bench_size_t bench_sizes[] = { { 640, 480, 40 * 1024 }, { 1280, 720, 100 * 1024 } };
+
+static bench_frame_t bench_frames[BENCH_MAX_FRAMES];
+static int bench_frame_num;
+static u32 bench_bytes_total;   /* JPEG bytes of the BENCH_FRAMES sent */
+static int bench_force_copy;
+
+static struct mjpeg_packetizer bench_packetizer;
+static u8 bench_join_save[MJPEG_PKT_HDR_MAX];
+static u8 bench_copy_buf[MJPEG_PKT_BUF_SIZE(MJPEG_RTP_DEFAULT_PAYLOAD)];
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+static double bench_now( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double bench_cpu_time( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* A recorded stream: frames from each SOI up to the next one */
+static int bench_load( const char *path )
+{
+  static u8 file[BENCH_MAX_FRAMES * BENCH_FRAME_MAX / 4];
+  FILE *f = fopen( path, "rb" );
+  int len, i, start = -1;
+
+  if( f == NULL )
+    return -1;
+  len = (int)fread( file, 1, sizeof(file), f );
+  fclose( f );
+  for( i = 0; i + 1 < len && bench_frame_num < BENCH_MAX_FRAMES; i++ ){
+    if( file[i] != 0xFF || file[i + 1] != 0xD8 )
+      continue;
+    if( start >= 0 && i - start <= BENCH_FRAME_MAX ){
+      bench_frames[bench_frame_num].data = malloc( i - start );
+      memcpy( bench_frames[bench_frame_num].data, file + start, i - start );
+      bench_frames[bench_frame_num++].len = i - start;
+    }
+    start = i;
+  }
+  if( start >= 0 && len - start <= BENCH_FRAME_MAX && bench_frame_num < BENCH_MAX_FRAMES ){
+    bench_frames[bench_frame_num].data = malloc( len - start );
+    memcpy( bench_frames[bench_frame_num].data, file + start, len - start );
+    bench_frames[bench_frame_num++].len = len - start;
+  }
+  return bench_frame_num > 0 ? 0 : -1;
+}
+
+/* 4:2:0 frames as a camera sends them: DQT, SOF0, DHT stand-in, SOS, scan, EOI */
+static void bench_synthesize( const bench_size_t *size )
+{
+  u8 *f;
+  int p, i, n;
+
+  for( n = 0; n < 8; n++ ){
+    f = malloc( size->scan + 1024 );
+    p = 0;
+    f[p++] = 0xFF; f[p++] = 0xD8;
+    f[p++] = 0xFF; f[p++] = 0xDB; f[p++] = 0; f[p++] = 2 + 2 * 65;
+    for( i = 0; i < 2 * 65; i++ )
+      f[p++] = ( i == 0 ) ? 0 : ( i == 65 ) ? 1 : (u8)( 2 + i % 60 );
+    f[p++] = 0xFF; f[p++] = 0xC0; f[p++] = 0; f[p++] = 17; f[p++] = 8;
+    f[p++] = (u8)( size->height >> 8 ); f[p++] = (u8)size->height;
+    f[p++] = (u8)( size->width >> 8 ); f[p++] = (u8)size->width; f[p++] = 3;
+    f[p++] = 1; f[p++] = 0x22; f[p++] = 0;
+    f[p++] = 2; f[p++] = 0x11; f[p++] = 1;
+    f[p++] = 3; f[p++] = 0x11; f[p++] = 1;
+    f[p++] = 0xFF; f[p++] = 0xC4; f[p++] = 1; f[p++] = 0xA2;
+    for( i = 0; i < 0x1A0; i++ )
+      f[p++] = (u8)i;
+    f[p++] = 0xFF; f[p++] = 0xDA; f[p++] = 0; f[p++] = 12;
+    for( i = 0; i < 10; i++ )
+      f[p++] = 0;
+    i = size->scan - n * 1500;
+    while( i-- > 0 ){
+      f[p] = (u8)( ( p * 131 + n ) | 1 );
+      p++;
+    }
+    f[p++] = 0xFF; f[p++] = 0xD9;
+    bench_frames[n].data = f;
+    bench_frames[n].len = p;
+  }
+  bench_frame_num = n;
+}
+
+static int bench_read_full( int socket, u8 *buf, int len )
+{
+  int got, done = 0;
+
+  while( done < len ){
+    got = (int)recv( socket, buf + done, len - done, 0 );
+    if( got <= 0 )
+      return -1;
+    done += got;
+  }
+  return done;
+}
+
+/* The client: RTP sequence, RFC 2435 fragment offsets and frame boundaries */
+static void *bench_receive( void *arg )
+{
+  bench_receiver_t *rx = arg;
+  static u8 pkt[65536];
+  int len, hdr, offset;
+  u16 seq;
+
+  while( !rx->stop ){
+    if( rx->stream ){
+      if( bench_read_full( rx->socket, pkt, MJPEG_INTERLEAVE_SIZE ) < 0 )
+        break;
+      len = ( pkt[2] << 8 ) | pkt[3];
+      if( pkt[0] != '$' || pkt[1] != BENCH_CHANNEL || bench_read_full( rx->socket, pkt, len ) < 0 )
+        break;
+    }else{
+      len = (int)recv( rx->socket, pkt, sizeof(pkt), 0 );
+      if( len <= 0 )
+        continue;
+    }
+    if( len < MJPEG_RTP_HDR_SIZE + MJPEG_JPEG_HDR_SIZE || ( pkt[1] & 0x7F ) != MJPEG_RTP_PT )
+      continue;
+
+    seq = (u16)( ( pkt[2] << 8 ) | pkt[3] );
+    if( rx->have_seq && seq != (u16)( rx->seq + 1 ) )
+      rx->seq_errors++;
+    rx->have_seq = 1;
+    rx->seq = seq;
+
+    hdr = MJPEG_RTP_HDR_SIZE + MJPEG_JPEG_HDR_SIZE;
+    offset = ( pkt[13] << 16 ) | ( pkt[14] << 8 ) | pkt[15];
+    if( pkt[16] >= 64 )
+      hdr += MJPEG_RST_HDR_SIZE;
+    if( offset == 0 )
+      hdr += MJPEG_QT_HDR_SIZE + ( ( pkt[hdr + 2] << 8 ) | pkt[hdr + 3] );
+    if( (u32)offset != rx->frame_bytes )
+      rx->offset_errors++;
+    rx->frame_bytes = offset + ( len - hdr );
+    rx->packets++;
+    rx->bytes += len;
+    if( pkt[1] & 0x80 ){
+      rx->frames++;
+      rx->frame_bytes = 0;
+    }
+  }
+  return NULL;
+}
+
+static int bench_open( bench_mode_t mode, bench_receiver_t *rx, int *tx, struct sockaddr_in *to )
+{
+  struct sockaddr_in addr;
+  struct ip_mreq mreq;
+  struct timeval tv = { 0, 200000 };
+  int one = 1, size = 8 * 1024 * 1024, listener;
+  socklen_t addr_len = sizeof(addr);
+  u8 loop = 1;
+
+  memset( &addr, 0, sizeof(addr) );
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+  addr.sin_port = htons( BENCH_PORT + mode );
+  *to = addr;
+
+  if( mode == BENCH_TCP ){
+    /* the rtsp session socket, rtp is framed on it */
+    listener = socket( AF_INET, SOCK_STREAM, 0 );
+    setsockopt( listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one) );
+    if( bind( listener, (struct sockaddr *)&addr, sizeof(addr) ) < 0 || listen( listener, 1 ) < 0 )
+      return -1;
+    *tx = socket( AF_INET, SOCK_STREAM, 0 );
+    if( connect( *tx, (struct sockaddr *)&addr, sizeof(addr) ) < 0 )
+      return -1;
+    rx->socket = accept( listener, (struct sockaddr *)&addr, &addr_len );
+    close( listener );
+    rx->stream = 1;
+    return rx->socket < 0 ? -1 : 0;
+  }
+
+  rx->socket = socket( AF_INET, SOCK_DGRAM, 0 );
+  setsockopt( rx->socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one) );
+  setsockopt( rx->socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size) );
+  setsockopt( rx->socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv) );
+  *tx = socket( AF_INET, SOCK_DGRAM, 0 );
+  if( mode == BENCH_MULTICAST ){
+    addr.sin_addr.s_addr = htonl( INADDR_ANY );
+    to->sin_addr.s_addr = inet_addr( BENCH_GROUP );
+    mreq.imr_multiaddr.s_addr = inet_addr( BENCH_GROUP );
+    mreq.imr_interface.s_addr = htonl( INADDR_LOOPBACK );
+    if( setsockopt( rx->socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq) ) < 0 )
+      return -1;
+    setsockopt( *tx, IPPROTO_IP, IP_MULTICAST_IF, &mreq.imr_interface, sizeof(mreq.imr_interface) );
+    setsockopt( *tx, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop) );
+  }
+  return bind( rx->socket, (struct sockaddr *)&addr, sizeof(addr) );
+}
+
+/* The first synthetic or recorded frame, once as is and once with a DRI segment before SOS */
+static int bench_check_packetizer( void )
+{
+  static u8 joined[MJPEG_PKT_BUF_SIZE(MJPEG_RTP_DEFAULT_PAYLOAD)];
+  static const u8 dri[6] = { 0xFF, 0xDD, 0x00, 0x04, 0x00, 0x10 };
+  struct mjpeg_rtp_frag frag;
+  bench_frame_t *plain = &bench_frames[0];
+  static const int widths[3] = { 2040, 2041, 4096 };
+  static struct mjpeg_packetizer small;
+  u8 *restart, *pristine, *sized, *pkt;
+  int sos, sof, i, len, copy_len, errors = 0;
+  u32 parses;
+
+  for( sos = 2; sos + 1 < plain->len; sos++ )
+    if( plain->data[sos] == 0xFF && plain->data[sos + 1] == 0xDA )
+      break;
+  for( sof = 2; sof + 1 < plain->len; sof++ )
+    if( plain->data[sof] == 0xFF && plain->data[sof + 1] == 0xC0 )
+      break;
+  if( sos + 1 >= plain->len || sof >= sos )
+    return -1;
+  restart = malloc( plain->len + sizeof(dri) );
+  pristine = malloc( plain->len + sizeof(dri) );
+  memcpy( restart, plain->data, sos );
+  memcpy( restart + sos, dri, sizeof(dri) );
+  memcpy( restart + sos + sizeof(dri), plain->data + sos, plain->len - sos );
+  memcpy( pristine, restart, plain->len + sizeof(dri) );
+
+  mjpeg_packetizer_init( &bench_packetizer, 0x1234, MJPEG_RTP_DEFAULT_PAYLOAD );
+  for( i = 0; i < 4; i++ ){
+    parses = bench_packetizer.stats.header_parses;
+    if( ( i & 1 ) == 0 ){
+      if( mjpeg_packetizer_load_frame( &bench_packetizer, plain->data, plain->len, i ) < 0 )
+        errors++;
+    }else{
+      if( mjpeg_packetizer_load_frame( &bench_packetizer, restart, plain->len + sizeof(dri), i ) < 0 )
+        errors++;
+    }
+    while( mjpeg_packetizer_next( &bench_packetizer, &frag ) )
+      ;
+    if( bench_packetizer.stats.header_parses != parses + 1 || bench_packetizer.info.dri != ( ( i & 1 ) ? 16 : 0 ) )
+      errors++;
+  }
+
+  /* the width goes out as a count of 8 pixel blocks in one byte */
+  sized = malloc( plain->len );
+  memcpy( sized, plain->data, plain->len );
+  for( i = 0; i < 3; i++ ){
+    sized[sof + 7] = (u8)( widths[i] >> 8 );
+    sized[sof + 8] = (u8)widths[i];
+    len = mjpeg_packetizer_load_frame( &bench_packetizer, sized, plain->len, 0 );
+    if( ( len == 0 ) != ( widths[i] <= MJPEG_RTP_MAX_DIMENSION ) || ( len == 0 && bench_packetizer.info.width != 255 ) )
+      errors++;
+    mjpeg_packetizer_reset( &bench_packetizer );
+  }
+  free( sized );
+
+  /* a payload size below the headers is raised to what one byte of data needs */
+  mjpeg_packetizer_init( &small, 0x1234, 64 );
+  if( small.max_payload != MJPEG_RTP_MIN_PAYLOAD || mjpeg_packetizer_load_frame( &small, plain->data, plain->len, 0 ) < 0 )
+    errors++;
+  len = 0;
+  for( i = 0; i < plain->len && mjpeg_packetizer_next( &small, &frag ); i++ ){
+    if( frag.data_len <= 0 || frag.hdr_len + frag.data_len > small.max_payload )
+      errors++;
+    len += frag.data_len;
+  }
+  if( len != plain->len - small.info.scan_offset - 2 )
+    errors++;
+
+  mjpeg_packetizer_load_frame( &bench_packetizer, restart, plain->len + sizeof(dri), 0 );
+  while( mjpeg_packetizer_next( &bench_packetizer, &frag ) ){
+    pkt = mjpeg_frag_join( &frag, BENCH_CHANNEL, bench_join_save, &len );
+    if( pkt == NULL ){
+      errors++;
+      continue;
+    }
+    memcpy( joined, pkt, len );
+    mjpeg_frag_unjoin( &frag, bench_join_save, len );
+    pkt = mjpeg_frag_copy( &frag, BENCH_CHANNEL, bench_copy_buf, sizeof(bench_copy_buf), &copy_len );
+    if( pkt == NULL || copy_len != len || memcmp( pkt, joined, len ) != 0 )
+      errors++;
+  }
+  if( memcmp( restart, pristine, plain->len + sizeof(dri) ) != 0 )
+    errors++;
+
+  free( restart );
+  free( pristine );
+  printf( "packetizer  %u header parses, %u packets, %d errors\n", (unsigned)bench_packetizer.stats.header_parses,
+          (unsigned)bench_packetizer.stats.packets, errors );
+  return errors ? -1 : 0;
+}
+
+/* uvc_rtp_send_frame of example_uvc.c without the sends: CPU per frame and scan data copied */
+static int bench_packetize( int copy, double *us, double *copies, double *copied )
+{
+  struct mjpeg_rtp_frag frag;
+  double t, best = 0;
+  u32 frag_copies = 0, bytes = 0;
+  u8 *pkt;
+  int k, i, len;
+
+  for( k = 0; k < BENCH_CPU_ROUNDS; k++ ){
+    mjpeg_packetizer_init( &bench_packetizer, 0x1234, MJPEG_RTP_DEFAULT_PAYLOAD );
+    frag_copies = bytes = 0;
+    t = bench_cpu_time( );
+    for( i = 0; i < BENCH_FRAMES; i++ ){
+      if( mjpeg_packetizer_load_frame( &bench_packetizer, bench_frames[i % bench_frame_num].data,
+                                       bench_frames[i % bench_frame_num].len, i * 3000 ) < 0 )
+        return -1;
+      while( mjpeg_packetizer_next( &bench_packetizer, &frag ) ){
+        pkt = copy ? NULL : mjpeg_frag_join( &frag, -1, bench_join_save, &len );
+        if( pkt != NULL ){
+          mjpeg_frag_unjoin( &frag, bench_join_save, len );
+          continue;
+        }
+        if( mjpeg_frag_copy( &frag, -1, bench_copy_buf, sizeof(bench_copy_buf), &len ) == NULL )
+          return -1;
+        frag_copies++;
+        bytes += frag.data_len;
+      }
+    }
+    t = bench_cpu_time( ) - t;
+    if( k == 0 || t < best )
+      best = t;
+  }
+  *us = best / BENCH_FRAMES * 1e6;
+  *copies = (double)frag_copies / BENCH_FRAMES;
+  *copied = (double)bytes / BENCH_FRAMES;
+  return 0;
+}
+
+/* uvc_rtp_send_frame of example_uvc.c */
+static int bench_send_frame( int socket, struct sockaddr_in *to, int channel, bench_frame_t *frame, bench_result_t *result )
+{
+  struct mjpeg_rtp_frag frag;
+  u8 *pkt;
+  int len, joined, ret = 0;
+
+  if( mjpeg_packetizer_load_frame( &bench_packetizer, frame->data, frame->len, result->frames * 3000 ) < 0 )
+    return -1;
+  while( mjpeg_packetizer_next( &bench_packetizer, &frag ) ){
+    pkt = bench_force_copy ? NULL : mjpeg_frag_join( &frag, channel, bench_join_save, &len );
+    joined = ( pkt != NULL );
+    if( !joined ){
+      pkt = mjpeg_frag_copy( &frag, channel, bench_copy_buf, sizeof(bench_copy_buf), &len );
+      if( pkt == NULL )
+        return -1;
+      result->copied += frag.data_len;
+    }
+    if( channel < 0 ){
+      /* a full loopback queue is the radio being busy, wait for it like lwip does */
+      while( ( ret = (int)sendto( socket, pkt, len, 0, (struct sockaddr *)to, sizeof(*to) ) ) < 0 && errno == ENOBUFS )
+        usleep( 100 );
+    }else{
+      ret = (int)send( socket, pkt, len, 0 );
+    }
+    if( joined )
+      mjpeg_frag_unjoin( &frag, bench_join_save, len );
+    if( ret < 0 )
+      return -1;
+    result->packets++;
+    result->bytes += len;
+  }
+  return 0;
+}
+
+static int bench_run( bench_mode_t mode, bench_result_t *result, bench_receiver_t *rx )
+{
+  struct sockaddr_in to;
+  pthread_t thread;
+  double t, start;
+  int tx = -1, i, failed = 0;
+
+  memset( result, 0, sizeof(*result) );
+  memset( rx, 0, sizeof(*rx) );
+  if( bench_open( mode, rx, &tx, &to ) < 0 ){
+    if( rx->socket > 0 )
+      close( rx->socket );
+    if( tx >= 0 )
+      close( tx );
+    return -1;
+  }
+  pthread_create( &thread, NULL, bench_receive, rx );
+
+  mjpeg_packetizer_init( &bench_packetizer, 0x1234, MJPEG_RTP_DEFAULT_PAYLOAD );
+  start = bench_now( );
+  for( i = 0; i < BENCH_FRAMES; i++ ){
+    t = bench_now( );
+    if( bench_send_frame( tx, &to, mode == BENCH_TCP ? BENCH_CHANNEL : -1, &bench_frames[i % bench_frame_num], result ) < 0 ){
+      failed = 1;
+      break;
+    }
+    t = bench_now( ) - t;
+    result->latency_sum += t;
+    result->latency_max = ( t > result->latency_max ) ? t : result->latency_max;
+    result->frames++;
+  }
+  result->seconds = bench_now( ) - start;
+
+  /* let the receiver drain, then unblock it */
+  for( i = 0; i < 100 && rx->frames < result->frames; i++ )
+    usleep( 10000 );
+  rx->stop = 1;
+  shutdown( tx, SHUT_RDWR );
+  shutdown( rx->socket, SHUT_RDWR );
+  pthread_join( thread, NULL );
+  close( tx );
+  close( rx->socket );
+  return failed;
+}
+
+int main( int argc, char *argv[] )
+{
+  bench_result_t result;
+  bench_receiver_t rx;
+  double us[2], copies[2], copied[2];
+  int size, sizes, mode, path, i, failed = 0;
+
+  sizes = ( argc > 1 ) ? 1 : (int)( sizeof(bench_sizes) / sizeof(bench_sizes[0]) );
+  for( size = 0; size < sizes; size++ ){
+    if( argc > 1 ){
+      if( bench_load( argv[1] ) < 0 ){
+        printf( "No JPEG frames in %s\n", argv[1] );
+        return 1;
+      }
+    }else{
+      bench_synthesize( &bench_sizes[size] );
+    }
+    bench_bytes_total = 0;
+    for( i = 0; i < BENCH_FRAMES; i++ )
+      bench_bytes_total += bench_frames[i % bench_frame_num].len;
+    mjpeg_packetizer_init( &bench_packetizer, 0x1234, MJPEG_RTP_DEFAULT_PAYLOAD );
+    mjpeg_packetizer_load_frame( &bench_packetizer, bench_frames[0].data, bench_frames[0].len, 0 );
+    printf( "%dx%d  %d frames of %d distinct, %u kB, %d byte packets\n", bench_packetizer.info.width * 8,
+            bench_packetizer.info.height * 8, BENCH_FRAMES, bench_frame_num, (unsigned)( bench_bytes_total / 1024 ),
+            MJPEG_RTP_DEFAULT_PAYLOAD );
+
+    if( bench_check_packetizer( ) < 0 )
+      failed = 1;
+
+    for( path = 0; path < 2; path++ ){
+      if( bench_packetize( path, &us[path], &copies[path], &copied[path] ) < 0 )
+        failed = 1;
+    }
+    printf( "packetize   join %6.2f us/frame, copy %6.2f us/frame, join saves %5.1f copies %7.0f B per frame\n",
+            us[0], us[1], copies[1] - copies[0], copied[1] - copied[0] );
+
+    for( i = 0; i < BENCH_MODES * 2; i++ ){
+      mode = i / 2;
+      path = i % 2;
+      bench_force_copy = path;
+      if( bench_run( (bench_mode_t)mode, &result, &rx ) < 0 ){
+        printf( "%-9s %s  not available on this host\n", bench_mode_names[mode], bench_path_names[path] );
+        continue;
+      }
+      printf( "%-9s %s  %6.0f fps %7.1f MB/s  send avg %6.1f us max %7.1f us  %5.1f packets/frame  copied %u B\n",
+              bench_mode_names[mode], bench_path_names[path], result.frames / result.seconds, result.bytes / result.seconds / 1e6,
+              result.latency_sum / result.frames * 1e6, result.latency_max * 1e6,
+              (double)result.packets / result.frames, (unsigned)result.copied );
+      printf( "                received %u/%u frames %u/%u packets, sequence errors %u, offset errors %u\n",
+              (unsigned)rx.frames, (unsigned)result.frames, (unsigned)rx.packets, (unsigned)result.packets,
+              (unsigned)rx.seq_errors, (unsigned)rx.offset_errors );
+      /* udp may lose datagrams under load, a stream may not */
+      if( result.frames != BENCH_FRAMES || rx.offset_errors > ( mode == BENCH_TCP ? 0 : rx.seq_errors ) ||
+          ( mode == BENCH_TCP && ( rx.frames != result.frames || rx.seq_errors != 0 ) ) )
+        failed = 1;
+      if( bench_packetizer.stats.bad_frames != 0 )
+        failed = 1;
+    }
+
+    for( i = 0; i < bench_frame_num; i++ )
+      free( bench_frames[i].data );
+    bench_frame_num = 0;
+  }
+
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
@@ -0,0 +1,620 @@
+/**
+******************************************************************************
+* @file    zc_msg_queue_bench.c
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Stress test of the ZC cloud message queue: mixed size cloud traffic,
+*          coalesced and split over TCP reads, against a slower consumer.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench provides the protocol controller globals and a plain text SEC_Decrypt:
+ *
+ *    gcc -O2 -ffunction-sections -fdata-sections -Wl,--gc-sections
+ *        -IDemos/COM.MXCHIP.SPP/ZC/inc/zc -IDemos/COM.MXCHIP.SPP/ZC/inc/tropicssl
+ *        Platform/MCU/Host/zc_msg_queue_bench.c Demos/COM.MXCHIP.SPP/ZC/src/zc/zc_message_queue.c -lpthread
+ *
+ *  Time runs in 1 ms ticks. Each tick the socket hands over at most one TCP read of
+ *  whatever the cloud has sent so far, and every few ticks the protocol controller
+ *  handles one message. The same stream and reads are replayed against the legacy
+ *  receive path: one 600 byte buffer, one message per read, no room while it is full.
+ *  A message counts as delivered when it reaches the handler intact and in order
+ *  within its lane; delay is from the message being complete to the handler taking it.
+ *
+ *  The two thread case runs the module side against the cloud side on the real clock:
+ *  one thread allocates and pushes to the send lanes as PCT_SendMsgToCloud does, the
+ *  other pops and frees them as MSG_SendDataToCloud does and allocates on its own as
+ *  MSG_RecvDataFromCloud does. The pool and the lanes are locked through a pthread mutex.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <zc_protocol_controller.h>
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_MESSAGES          20000
+#define BENCH_TCP_MSS           1460
+#define BENCH_ROUNDS            7
+#define BENCH_THREAD_MESSAGES   200000
+#define BENCH_KINDS             ( sizeof(bench_kinds) / sizeof(bench_kinds[0]) )
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+typedef enum
+{
+  BENCH_LEGACY,
+  BENCH_POOL,
+} bench_model_t;
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+typedef struct
+{
+  u8 code;
+  u8 lane;
+  u16 min_payload;              /* payload bytes, the first 4 carry the sequence number */
+  u16 max_payload;
+  u8 weight;
+} bench_kind_t;
+
+typedef struct
+{
+  const char *name;
+  u32 burst_gap;                /* ms between bursts from the cloud */
+  u32 burst_max;                /* messages per burst, 1 to burst_max */
+  u32 service;                  /* ms the handler takes per message */
+} bench_scenario_t;
+
+typedef struct
+{
+  u32 sent[MSG_LANE_NUM];
+  u32 delivered[MSG_LANE_NUM];
+  u32 corrupt;
+  u32 delay_sum[MSG_LANE_NUM];
+  u32 delay_max[MSG_LANE_NUM];
+} bench_result_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static void bench_printf( const char *format, ... );
+static u32 bench_get_time( void );
+static void bench_send_tcp( u32 fd, u8 *data, u16 len, ZC_SendParam *param );
+static u32 bench_random( void );
+static void bench_build_stream( const bench_scenario_t *scenario );
+static int bench_check( u8 *msg, u32 len, bench_result_t *result, u32 *last_seq );
+static int bench_replay( const bench_scenario_t *scenario, bench_model_t model, bench_result_t *result );
+static int bench_send_lanes( void );
+static void bench_lock( void );
+static void bench_unlock( void );
+static void bench_fill( MSG_PoolBuf *buf, u32 seq );
+static int bench_intact( MSG_PoolBuf *buf, u32 *seq );
+static void *bench_module_thread( void *arg );
+static int bench_threads( void );
+static double bench_seconds( void );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+PTC_ProtocolCon g_struProtocolController;
+MSG_LaneQueue g_struRecvQueue;
+MSG_LaneQueue g_struSendQueue;
+MSG_Buffer g_struClientBuffer;
+static PTC_ModuleAdapter bench_adapter;
+
+static const bench_kind_t bench_kinds[] =
+{
+  { ZC_CODE_HEARTBEAT,      MSG_LANE_CONTROL,    4,    4, 20 },
+  { ZC_CODE_ACK,            MSG_LANE_CONTROL,    4,   32, 15 },
+  { ZC_CODE_TOKEN_SET,      MSG_LANE_CONTROL,   20,   40,  3 },
+  { ZC_CODE_OTA_FILE_CHUNK, MSG_LANE_DATA,     512,  512, 25 },
+  { 64,                     MSG_LANE_DATA,      16,  400, 32 },
+  { 65,                     MSG_LANE_DATA,     600, 1200,  5 },
+};
+
+static const bench_scenario_t bench_scenarios[] =
+{
+  { "steady",  4,  1, 1 },
+  { "bursty", 40, 12, 3 },
+};
+
+static u8 *bench_stream;
+static u32 bench_stream_len;
+static u32 *bench_msg_end;      /* stream offset past each message */
+static u32 *bench_msg_time;     /* ms the cloud sends each message */
+static u32 bench_msg_lane_sent[MSG_LANE_NUM];
+static u32 bench_now;
+static u32 bench_seed;
+static u8 bench_sent_code[8];
+static u32 bench_sent_num;
+static pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int bench_module_done;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+static void bench_printf( const char *format, ... )
+{
+  (void)format;
+}
+
+static u32 bench_get_time( void )
+{
+  return bench_now;
+}
+
+static void bench_send_tcp( u32 fd, u8 *data, u16 len, ZC_SendParam *param )
+{
+  (void)fd;
+  (void)param;
+  if( len >= sizeof(ZC_SecHead) + sizeof(ZC_MessageHead) && bench_sent_num < sizeof(bench_sent_code) )
+    bench_sent_code[bench_sent_num++] = ( (ZC_MessageHead *)( data + sizeof(ZC_SecHead) ) )->MsgCode;
+}
+
+u32 SEC_Decrypt( ZC_SecHead *pstruSecHead, u8 *pu8CiperBuf, u8 *pu8PlainBuf, u16 *pu16PlainLen )
+{
+  memcpy( pu8PlainBuf, pu8CiperBuf, ZC_HTONS( pstruSecHead->u16TotalMsg ) );
+  *pu16PlainLen = ZC_HTONS( pstruSecHead->u16TotalMsg );
+  return ZC_RET_OK;
+}
+
+static u32 bench_random( void )
+{
+  bench_seed = bench_seed * 1103515245 + 12345;
+  return bench_seed >> 8;
+}
+
+/* The cloud side: bursts of messages of random kinds, each behind its security head */
+static void bench_build_stream( const bench_scenario_t *scenario )
+{
+  const bench_kind_t *kind;
+  ZC_MessageHead head;
+  ZC_SecHead sec;
+  u32 msg, burst, time, pick, payload, i;
+  u8 *p;
+
+  bench_seed = 0x5EED;
+  bench_stream_len = 0;
+  memset( bench_msg_lane_sent, 0, sizeof(bench_msg_lane_sent) );
+  time = 0;
+  burst = 0;
+  for( msg = 0; msg < BENCH_MESSAGES; msg++ ){
+    if( burst == 0 ){
+      time += scenario->burst_gap;
+      burst = 1 + bench_random( ) % scenario->burst_max;
+    }
+    burst--;
+
+    pick = bench_random( ) % 100;
+    for( i = 0; pick >= bench_kinds[i].weight; i++ )
+      pick -= bench_kinds[i].weight;
+    kind = &bench_kinds[i];
+    payload = kind->min_payload + bench_random( ) % ( kind->max_payload - kind->min_payload + 1 );
+
+    /* messages follow each other at any byte offset */
+    p = bench_stream + bench_stream_len;
+    sec.u16TotalMsg = ZC_HTONS( sizeof(ZC_MessageHead) + payload );
+    sec.u8SecType = ZC_SEC_ALG_NONE;
+    sec.u8Resver = 0;
+    memset( &head, 0, sizeof(head) );
+    head.MsgId = (u8)msg;
+    head.MsgCode = kind->code;
+    head.Payloadlen = ZC_HTONS( payload );
+    memcpy( p, &sec, sizeof(sec) );
+    memcpy( p + sizeof(sec), &head, sizeof(head) );
+    p += sizeof(ZC_SecHead) + sizeof(ZC_MessageHead);
+    memcpy( p, &msg, 4 );
+    for( i = 4; i < payload; i++ )
+      p[i] = (u8)( msg + i * 31 );
+
+    bench_stream_len += sizeof(ZC_SecHead) + sizeof(ZC_MessageHead) + payload;
+    bench_msg_end[msg] = bench_stream_len;
+    bench_msg_time[msg] = time;
+    bench_msg_lane_sent[kind->lane]++;
+  }
+}
+
+/* A message the handler took: intact, of a known kind and after the last one of its lane */
+static int bench_check( u8 *msg, u32 len, bench_result_t *result, u32 *last_seq )
+{
+  ZC_MessageHead *head = (ZC_MessageHead *)msg;
+  u32 seq, payload, i, k;
+  u8 *p;
+
+  if( len < sizeof(ZC_MessageHead) + 4 )
+    return -1;
+  payload = ZC_HTONS( head->Payloadlen );
+  if( payload + sizeof(ZC_MessageHead) != len )
+    return -1;
+  for( k = 0; k < BENCH_KINDS && bench_kinds[k].code != head->MsgCode; k++ )
+    ;
+  if( k == BENCH_KINDS )
+    return -1;
+
+  p = msg + sizeof(ZC_MessageHead);
+  memcpy( &seq, p, 4 );
+  if( seq >= BENCH_MESSAGES || head->MsgId != (u8)seq )
+    return -1;
+  for( i = 4; i < payload; i++ )
+    if( p[i] != (u8)( seq + i * 31 ) )
+      return -1;
+  if( last_seq[bench_kinds[k].lane] != (u32)-1 && seq <= last_seq[bench_kinds[k].lane] )
+    return -1;
+
+  last_seq[bench_kinds[k].lane] = seq;
+  result->delivered[bench_kinds[k].lane]++;
+  return bench_kinds[k].lane;
+}
+
+static int bench_replay( const bench_scenario_t *scenario, bench_model_t model, bench_result_t *result )
+{
+  static MSG_Buffer legacy;
+  static u32 socket_buffer[BENCH_TCP_MSS / sizeof(u32) + 1];
+  u32 last_seq[MSG_LANE_NUM] = { (u32)-1, (u32)-1 };
+  u32 legacy_full_time = 0;
+  u32 read_pos = 0, sent = 0, next_service = 0;
+  u32 len, delay;
+  MSG_PoolBuf *buf;
+  int lane, failed = 0;
+
+  memset( result, 0, sizeof(*result) );
+  memcpy( result->sent, bench_msg_lane_sent, sizeof(result->sent) );
+  memset( &g_struRecvQueue, 0, sizeof(g_struRecvQueue) );
+  memset( &legacy, 0, sizeof(legacy) );
+  MSG_Init( );
+  bench_seed = 0xC0FFEE;
+
+  for( bench_now = 0; ; bench_now++ ){
+    /* One TCP read: a full segment, or a short one now and then */
+    while( sent < BENCH_MESSAGES && bench_msg_time[sent] <= bench_now )
+      sent++;
+    len = ( sent > 0 ? bench_msg_end[sent - 1] : 0 ) - read_pos;
+    if( len > 0 ){
+      if( bench_random( ) % 4 == 0 )
+        len = 1 + bench_random( ) % len;
+      len = ( len > BENCH_TCP_MSS ) ? BENCH_TCP_MSS : len;
+      memcpy( socket_buffer, bench_stream + read_pos, len );
+      if( model == BENCH_POOL ){
+        MSG_RecvDataFromCloud( (u8 *)socket_buffer, len );
+      }else if( MSG_RecvData( &legacy, (u8 *)socket_buffer, len ) == ZC_RET_OK && legacy.u8Status == MSG_BUFFER_FULL ){
+        legacy_full_time = bench_now;
+      }
+      read_pos += len;
+    }
+
+    if( bench_now >= next_service ){
+      if( model == BENCH_POOL ){
+        buf = MSG_PopLane( &g_struRecvQueue );
+        if( buf != NULL ){
+          lane = bench_check( buf->pu8MsgBuffer, buf->u32Len, result, last_seq );
+          if( lane < 0 )
+            result->corrupt++;
+          else if( lane != buf->u8Lane )
+            failed = 1;
+          MSG_FreeBuffer( buf );
+          next_service = bench_now + scenario->service;
+        }
+      }else if( legacy.u8Status == MSG_BUFFER_FULL ){
+        lane = bench_check( legacy.u8MsgBuffer + sizeof(ZC_SecHead), legacy.u32Len - sizeof(ZC_SecHead), result, last_seq );
+        if( lane < 0 ){
+          result->corrupt++;
+        }else{
+          delay = bench_now - legacy_full_time;
+          result->delay_sum[lane] += delay;
+          result->delay_max[lane] = ( delay > result->delay_max[lane] ) ? delay : result->delay_max[lane];
+        }
+        legacy.u8Status = MSG_BUFFER_IDLE;
+        legacy.u32Len = 0;
+        next_service = bench_now + scenario->service;
+      }
+    }
+
+    if( read_pos == bench_stream_len && bench_now >= next_service &&
+        ( model == BENCH_POOL ? ( g_struRecvQueue.u16Depth[0] + g_struRecvQueue.u16Depth[1] == 0 ) : legacy.u8Status != MSG_BUFFER_FULL ) )
+      break;
+  }
+
+  if( model == BENCH_POOL ){
+    len = result->corrupt;
+    for( lane = 0; lane < MSG_LANE_NUM; lane++ ){
+      result->delay_sum[lane] = g_struRecvQueue.struStats[lane].u32DelaySum;
+      result->delay_max[lane] = g_struRecvQueue.struStats[lane].u32DelayMax;
+      len += result->delivered[lane] - g_struRecvQueue.struStats[lane].u32Popped;
+    }
+    if( len != 0 )
+      failed = 1;
+    /* the stream ends on a message boundary, so nothing is held back */
+    if( MSG_PoolFreeBlocks( ) != MSG_POOL_BLOCK_NUM )
+      failed = 1;
+  }
+  return failed;
+}
+
+/* Control messages go out ahead of queued data, a full lane refuses more */
+static int bench_send_lanes( void )
+{
+  static const u8 codes[] = { 64, ZC_CODE_OTA_FILE_CHUNK, 64, ZC_CODE_HEARTBEAT };
+  PTC_Connection connection;
+  MSG_PoolBuf *buf;
+  ZC_MessageHead *head;
+  u32 i, pushed = 0;
+  int failed = 0;
+
+  memset( &g_struSendQueue, 0, sizeof(g_struSendQueue) );
+  memset( &connection, 0, sizeof(connection) );
+  MSG_Init( );
+  for( i = 0; i < sizeof(codes); i++ ){
+    buf = MSG_AllocBuffer( sizeof(ZC_SecHead) + sizeof(ZC_MessageHead) );
+    if( buf == NULL )
+      return 1;
+    head = (ZC_MessageHead *)( buf->pu8MsgBuffer + sizeof(ZC_SecHead) );
+    memset( buf->pu8MsgBuffer, 0, buf->u32Len );
+    head->MsgCode = codes[i];
+    MSG_PushLane( &g_struSendQueue, buf, MSG_GetLane( (u8 *)head, sizeof(ZC_MessageHead) ) );
+  }
+  bench_sent_num = 0;
+  for( i = 0; i < sizeof(codes); i++ )
+    MSG_SendDataToCloud( (u8 *)&connection );
+  if( bench_sent_num != sizeof(codes) || bench_sent_code[0] != ZC_CODE_HEARTBEAT ||
+      bench_sent_code[1] != 64 || bench_sent_code[2] != ZC_CODE_OTA_FILE_CHUNK )
+    failed = 1;
+
+  for( i = 0; i < MSG_LANE_DATA_MAXLEN + 2; i++ ){
+    buf = MSG_AllocBuffer( 16 );
+    if( buf != NULL && MSG_PushLane( &g_struSendQueue, buf, MSG_LANE_DATA ) == ZC_RET_OK )
+      pushed++;
+  }
+  if( pushed != MSG_LANE_DATA_MAXLEN || g_struSendQueue.struStats[MSG_LANE_DATA].u32Dropped != 2 )
+    failed = 1;
+  MSG_Init( );
+  if( MSG_PoolFreeBlocks( ) != MSG_POOL_BLOCK_NUM )
+    failed = 1;
+
+  printf( "Send lanes: control first, data lane holds %u: %s\n", (unsigned)MSG_LANE_DATA_MAXLEN, failed ? "FAILED" : "ok" );
+  return failed;
+}
+
+static void bench_lock( void )
+{
+  pthread_mutex_lock( &bench_mutex );
+}
+
+static void bench_unlock( void )
+{
+  pthread_mutex_unlock( &bench_mutex );
+}
+
+/* Sequence number, then a pattern over the whole message */
+static void bench_fill( MSG_PoolBuf *buf, u32 seq )
+{
+  u32 i;
+
+  memcpy( buf->pu8MsgBuffer, &seq, 4 );
+  for( i = 4; i < buf->u32Len; i++ )
+    buf->pu8MsgBuffer[i] = (u8)( seq + i * 7 );
+}
+
+static int bench_intact( MSG_PoolBuf *buf, u32 *seq )
+{
+  u32 i;
+
+  if( buf->u32Len < 4 )
+    return 0;
+  memcpy( seq, buf->pu8MsgBuffer, 4 );
+  for( i = 4; i < buf->u32Len; i++ )
+    if( buf->pu8MsgBuffer[i] != (u8)( *seq + i * 7 ) )
+      return 0;
+  return 1;
+}
+
+/* The module uart thread: one message in five is control, the rest data */
+static void *bench_module_thread( void *arg )
+{
+  MSG_PoolBuf *buf;
+  u32 seed = 0xACE1, seq;
+
+  (void)arg;
+  for( seq = 0; seq < BENCH_THREAD_MESSAGES; ){
+    seed = seed * 1103515245 + 12345;
+    buf = MSG_AllocBuffer( 8 + ( seed >> 8 ) % 300 );
+    if( buf == NULL ){
+      sched_yield( );
+      continue;
+    }
+    bench_fill( buf, seq );
+    MSG_PushLane( &g_struSendQueue, buf, ( seq % 5 == 0 ) ? MSG_LANE_CONTROL : MSG_LANE_DATA );
+    seq++;
+  }
+
+  bench_lock( );
+  bench_module_done = 1;
+  bench_unlock( );
+  return NULL;
+}
+
+/* Module and cloud thread on the shared pool: nothing lost, corrupt or out of order */
+static int bench_threads( void )
+{
+  u32 last_seq[MSG_LANE_NUM] = { (u32)-1, (u32)-1 };
+  u32 popped = 0, corrupt = 0, own = 0, seq;
+  MSG_PoolBuf *buf, *mine;
+  pthread_t module;
+  double t;
+  int done, failed = 0;
+
+  memset( &g_struSendQueue, 0, sizeof(g_struSendQueue) );
+  bench_module_done = 0;
+  bench_adapter.pfunLock = bench_lock;
+  bench_adapter.pfunUnlock = bench_unlock;
+  MSG_Init( );
+
+  t = bench_seconds( );
+  if( pthread_create( &module, NULL, bench_module_thread, NULL ) != 0 )
+    return 1;
+  for( ; ; ){
+    bench_lock( );
+    done = bench_module_done;
+    bench_unlock( );
+
+    /* a cloud message of its own while the module thread allocates */
+    mine = MSG_AllocBuffer( 8 + own % 200 );
+    if( mine != NULL ){
+      bench_fill( mine, own );
+      sched_yield( );
+      if( !bench_intact( mine, &seq ) || seq != own )
+        corrupt++;
+      MSG_FreeBuffer( mine );
+      own++;
+    }
+
+    buf = MSG_PopLane( &g_struSendQueue );
+    if( buf == NULL ){
+      if( done )
+        break;
+      continue;
+    }
+    if( !bench_intact( buf, &seq ) || ( seq % 5 == 0 ) != ( buf->u8Lane == MSG_LANE_CONTROL ) ||
+        ( last_seq[buf->u8Lane] != (u32)-1 && seq <= last_seq[buf->u8Lane] ) )
+      corrupt++;
+    else
+      last_seq[buf->u8Lane] = seq;
+    MSG_FreeBuffer( buf );
+    popped++;
+  }
+  pthread_join( module, NULL );
+  t = bench_seconds( ) - t;
+
+  if( corrupt != 0 || MSG_PoolFreeBlocks( ) != MSG_POOL_BLOCK_NUM ||
+      popped + g_struSendQueue.struStats[MSG_LANE_CONTROL].u32Dropped + g_struSendQueue.struStats[MSG_LANE_DATA].u32Dropped != BENCH_THREAD_MESSAGES ||
+      popped != g_struSendQueue.struStats[MSG_LANE_CONTROL].u32Popped + g_struSendQueue.struStats[MSG_LANE_DATA].u32Popped )
+    failed = 1;
+  bench_adapter.pfunLock = NULL;
+  bench_adapter.pfunUnlock = NULL;
+
+  printf( "Two threads: %u pushed, %u popped, %u lane full, %u own buffers, %u corrupt, %.2f s CPU: %s\n",
+          (unsigned)BENCH_THREAD_MESSAGES, (unsigned)popped,
+          (unsigned)( g_struSendQueue.struStats[MSG_LANE_CONTROL].u32Dropped + g_struSendQueue.struStats[MSG_LANE_DATA].u32Dropped ),
+          (unsigned)own, (unsigned)corrupt, t, failed ? "FAILED" : "ok" );
+  return failed;
+}
+
+static double bench_seconds( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main( void )
+{
+  static const char *models[] = { "legacy", "pool" };
+  static const char *lanes[] = { "control", "data" };
+  const bench_scenario_t *scenario;
+  bench_result_t result;
+  double t, best[2];
+  u32 s, m, lane, k;
+  int failed = 0;
+
+  bench_adapter.pfunPrintf = bench_printf;
+  bench_adapter.pfunSendTcpData = bench_send_tcp;
+  bench_adapter.pfunGetTime = bench_get_time;
+  g_struProtocolController.pstruMoudleFun = &bench_adapter;
+
+  bench_stream = malloc( BENCH_MESSAGES * ( sizeof(ZC_SecHead) + sizeof(ZC_MessageHead) + 1200 ) );
+  bench_msg_end = malloc( BENCH_MESSAGES * sizeof(u32) );
+  bench_msg_time = malloc( BENCH_MESSAGES * sizeof(u32) );
+  if( bench_stream == NULL || bench_msg_end == NULL || bench_msg_time == NULL )
+    return 1;
+
+  printf( "Pool %u x %u bytes, lanes control %u / data %u\n", (unsigned)MSG_POOL_BLOCK_NUM, (unsigned)MSG_POOL_BLOCK_LEN,
+          (unsigned)MSG_LANE_CONTROL_MAXLEN, (unsigned)MSG_LANE_DATA_MAXLEN );
+  failed |= bench_send_lanes( );
+  failed |= bench_threads( );
+
+  for( s = 0; s < sizeof(bench_scenarios) / sizeof(bench_scenarios[0]); s++ ){
+    scenario = &bench_scenarios[s];
+    bench_build_stream( scenario );
+    printf( "\n%s: %u messages, %u bytes, bursts of up to %u every %u ms, %u ms per message\n", scenario->name,
+            (unsigned)BENCH_MESSAGES, (unsigned)bench_stream_len, (unsigned)scenario->burst_max,
+            (unsigned)scenario->burst_gap, (unsigned)scenario->service );
+
+    for( m = BENCH_LEGACY; m <= BENCH_POOL; m++ ){
+      failed |= bench_replay( scenario, (bench_model_t)m, &result );
+      for( lane = 0; lane < MSG_LANE_NUM; lane++ ){
+        printf( "  %-6s %-7s sent %5u delivered %5u loss %5.1f%%  delay avg %6.1f ms max %5u ms\n",
+                models[m], lanes[lane], (unsigned)result.sent[lane], (unsigned)result.delivered[lane],
+                100.0 * ( result.sent[lane] - result.delivered[lane] ) / result.sent[lane],
+                result.delivered[lane] ? (double)result.delay_sum[lane] / result.delivered[lane] : 0.0,
+                (unsigned)result.delay_max[lane] );
+      }
+      if( m == BENCH_POOL ){
+        printf( "  %-6s no buffer %u, bad %u, corrupt %u, lane full %u/%u\n", models[m],
+                (unsigned)g_struRecvQueue.u32NoBuffer, (unsigned)g_struRecvQueue.u32BadMsg, (unsigned)result.corrupt,
+                (unsigned)g_struRecvQueue.struStats[MSG_LANE_CONTROL].u32Dropped,
+                (unsigned)g_struRecvQueue.struStats[MSG_LANE_DATA].u32Dropped );
+        if( result.corrupt != 0 )
+          failed = 1;
+      }else{
+        printf( "  %-6s corrupt %u\n", models[m], (unsigned)result.corrupt );
+      }
+    }
+  }
+
+  /* Replay cost of the steady stream, the best of each model is reported */
+  bench_build_stream( &bench_scenarios[0] );
+  best[0] = best[1] = 0;
+  for( k = 0; k < BENCH_ROUNDS; k++ ){
+    for( m = BENCH_LEGACY; m <= BENCH_POOL; m++ ){
+      t = bench_seconds( );
+      bench_replay( &bench_scenarios[0], (bench_model_t)m, &result );
+      t = bench_stream_len / ( bench_seconds( ) - t ) / 1e6;
+      best[m] = ( t > best[m] ) ? t : best[m];
+    }
+  }
+  printf( "\nReplay MB/s: legacy %.1f, pool %.1f\n", best[0], best[1] );
+
+  free( bench_stream );
+  free( bench_msg_end );
+  free( bench_msg_time );
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
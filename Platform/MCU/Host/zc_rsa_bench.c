@@ -0,0 +1,272 @@
+/**
+******************************************************************************
+* @file    zc_rsa_bench.c 
+* @version V1.0.0
+* @date    19-Oct-2026
+* @brief   Known answer tests and handshake rate of the ZC security engine RSA,
+*          a context parsed per session against the cached per-key context.
+******************************************************************************
+*
+*  The MIT License
+*  Copyright (c) 2014 MXCHIP Inc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy 
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights 
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is furnished
+*  to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in
+*  all copies or substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+*  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR 
+*  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+******************************************************************************
+*/
+
+/*
+ *  The bench provides the ZC module functions and key store the security engine calls:
+ *
+ *    gcc -O2 -ffunction-sections -fdata-sections -Wl,--gc-sections
+ *        -IDemos/COM.MXCHIP.SPP/ZC/inc/zc -IDemos/COM.MXCHIP.SPP/ZC/inc/tropicssl
+ *        Platform/MCU/Host/zc_rsa_bench.c Demos/COM.MXCHIP.SPP/ZC/src/zc/zc_sec_engine.c
+ *        Demos/COM.MXCHIP.SPP/ZC/src/tropicssl/rsa.c Demos/COM.MXCHIP.SPP/ZC/src/tropicssl/bignum.c
+ *
+ *  A handshake is what the module does per cloud session: one public key encryption with
+ *  the cloud key and one private key decryption with the device key. The per session column
+ *  builds the rsa_context for each operation as the engine used to.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <zc_sec_engine.h>
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BENCH_KEY_BYTES         ( ZC_SEC_RSA_KEY_LEN >> 3 )
+#define BENCH_HANDSHAKES        4000
+#define BENCH_ROUNDS            7
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static void bench_printf( const char *format, ... );
+static void *bench_malloc( u32 size );
+static void bench_use_key( const u8 *private_key );
+static u32 bench_handshake_per_session( void );
+static u32 bench_handshake_cached( void );
+static double bench_seconds( void );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+PTC_ProtocolCon g_struProtocolController;
+static PTC_ModuleAdapter bench_adapter;
+
+/* 256-bit keys: N, P, Q, DP, DQ, QP big endian, e = 65537 */
+static const u8 bench_private_keys[2][ZC_SEC_RSA_PRIVATE_KEY_LEN] =
+{
+  {
+    0xC2, 0x41, 0x79, 0x7A, 0xBA, 0xF2, 0xA3, 0xDD, 0xB1, 0xA4, 0x6F, 0x14, 0x48, 0xAA, 0x5D, 0xF7,
+    0xB4, 0x02, 0x4E, 0xC3, 0x18, 0x96, 0x0A, 0x15, 0x0E, 0x94, 0x29, 0xB5, 0xBA, 0x05, 0xC8, 0xFF,
+    0xE9, 0x9F, 0xE1, 0x91, 0xD6, 0xA6, 0xC1, 0x0B, 0x13, 0xFB, 0x21, 0x3E, 0xFE, 0xB9, 0xCA, 0x31,
+    0xD4, 0xDC, 0x54, 0xAE, 0xF0, 0x2A, 0xC2, 0x6E, 0xCE, 0x1B, 0x2E, 0xAF, 0x5B, 0x8F, 0xCA, 0x2F,
+    0x3F, 0x0B, 0x02, 0xDE, 0xCC, 0xF2, 0xC0, 0xC3, 0x11, 0x88, 0x42, 0x07, 0x72, 0xCB, 0x85, 0xF1,
+    0x4D, 0xC1, 0x7E, 0x9D, 0xB8, 0xD5, 0xA5, 0xD8, 0xDC, 0x29, 0x49, 0xD0, 0x7C, 0xDD, 0xF5, 0xB9,
+    0xD8, 0x24, 0x99, 0x94, 0x90, 0xD5, 0x7E, 0x8C, 0x2F, 0x25, 0x6B, 0xCC, 0xDD, 0x98, 0x05, 0x66,
+  },
+  {
+    0xBE, 0xEC, 0xEF, 0xFF, 0xD8, 0x98, 0x05, 0x1D, 0xFD, 0xFF, 0xB7, 0xE6, 0x30, 0x45, 0x0D, 0x85,
+    0x6A, 0x26, 0x9B, 0xD2, 0xF5, 0x01, 0xFB, 0x5F, 0x5F, 0xDA, 0x67, 0x7A, 0xC8, 0x6D, 0xB3, 0x3D,
+    0xE8, 0x45, 0x06, 0x3A, 0x03, 0xD6, 0x1C, 0xBF, 0x95, 0x1B, 0xCB, 0x26, 0xA2, 0x16, 0xED, 0x03,
+    0xD2, 0x6E, 0x90, 0xA3, 0xF3, 0xA7, 0x1B, 0x00, 0x35, 0xB2, 0x24, 0x27, 0x02, 0xF0, 0x4A, 0xBF,
+    0x49, 0x92, 0x6B, 0x99, 0x7E, 0xD3, 0x98, 0x81, 0x9A, 0xE2, 0x95, 0xE3, 0xE3, 0xDD, 0xED, 0x2F,
+    0x14, 0x2E, 0x30, 0x46, 0xD8, 0xDE, 0x04, 0xB3, 0xDF, 0x72, 0x67, 0x0F, 0x2A, 0xB3, 0xFA, 0xA7,
+    0xD2, 0x0B, 0x7D, 0x5E, 0x38, 0xC8, 0xC9, 0xA6, 0x1C, 0x7B, 0xE7, 0x07, 0xAE, 0x30, 0x1E, 0x69,
+  },
+};
+
+/* Key 0: (01 02 .. 20)^e mod N and (40 41 .. 5F)^d mod N */
+static const u8 bench_public_kat[BENCH_KEY_BYTES] =
+{
+  0xA6, 0x36, 0x9A, 0x93, 0xC0, 0xA6, 0xB9, 0x52, 0x0C, 0x2F, 0x74, 0xB0, 0x4C, 0xD7, 0x5D, 0x56,
+  0xA4, 0x92, 0x28, 0x00, 0x5C, 0x07, 0x8A, 0x22, 0x1C, 0x65, 0x2E, 0x70, 0x8D, 0xCA, 0xD5, 0xED,
+};
+static const u8 bench_private_kat[BENCH_KEY_BYTES] =
+{
+  0x11, 0xBC, 0x9B, 0xB1, 0xBD, 0xB0, 0x6F, 0xB6, 0x79, 0x31, 0xB6, 0x4C, 0x62, 0x66, 0x89, 0x78,
+  0x5E, 0x23, 0x35, 0x1B, 0x16, 0xA5, 0x0C, 0x5A, 0xAA, 0x90, 0x48, 0xC0, 0xC3, 0xA9, 0x31, 0x20,
+};
+
+static u8 bench_cloud_key[ZC_SEC_RSA_PUBLIC_KEY_LEN];
+static u8 bench_device_key[ZC_SEC_RSA_PRIVATE_KEY_LEN];
+static u32 bench_mallocs;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+static void bench_printf( const char *format, ... )
+{
+  (void)format;
+}
+
+static void *bench_malloc( u32 size )
+{
+  bench_mallocs++;
+  return malloc( size );
+}
+
+void ZC_GetStoreInfor( u8 u8Type, u8 **pu8Data )
+{
+  *pu8Data = ( u8Type == ZC_GET_TYPE_PRIVATEKEY ) ? bench_device_key : bench_cloud_key;
+}
+
+/* The cloud and the device share the key pair so that a handshake round trips */
+static void bench_use_key( const u8 *private_key )
+{
+  memcpy( bench_device_key, private_key, ZC_SEC_RSA_PRIVATE_KEY_LEN );
+  memcpy( bench_cloud_key, private_key, BENCH_KEY_BYTES );
+  memcpy( bench_cloud_key + BENCH_KEY_BYTES, "\x01\x00\x01", 3 );
+}
+
+static u32 bench_handshake_per_session( void )
+{
+  u8 token[16], cipher[BENCH_KEY_BYTES], plain[BENCH_KEY_BYTES];
+  rsa_context *rsa;
+  int len = 0;
+  s32 ret;
+
+  memset( token, 0x5A, sizeof(token) );
+  rsa = (rsa_context *)ZC_malloc( sizeof(rsa_context) );
+  SEC_InitRsaContextWithPublicKey( rsa, bench_cloud_key );
+  ret = rsa_pkcs1_encrypt( rsa, RSA_PUBLIC, sizeof(token), token, cipher );
+  rsa_free( rsa );
+  ZC_free( rsa );
+
+  rsa = (rsa_context *)ZC_malloc( sizeof(rsa_context) );
+  SEC_InitRsaContextWithPrivateKey( rsa, bench_device_key );
+  if( ret == 0 )
+    ret = rsa_pkcs1_decrypt( rsa, RSA_PRIVATE, &len, cipher, plain, sizeof(plain) );
+  rsa_free( rsa );
+  ZC_free( rsa );
+
+  return ( ret == 0 && len == sizeof(token) && memcmp( plain, token, sizeof(token) ) == 0 ) ? ZC_RET_OK : ZC_RET_ERROR;
+}
+
+static u32 bench_handshake_cached( void )
+{
+  u8 token[16], cipher[BENCH_KEY_BYTES], plain[BENCH_KEY_BYTES];
+  u16 cipher_len, plain_len;
+  u32 ret;
+
+  memset( token, 0x5A, sizeof(token) );
+  ret = SEC_EncryptTextByRsa( cipher, token, sizeof(token), &cipher_len );
+  if( ret == ZC_RET_OK )
+    ret = SEC_DecryptTextByRsa( cipher, plain, cipher_len, &plain_len );
+
+  return ( ret == ZC_RET_OK && plain_len == sizeof(token) && memcmp( plain, token, sizeof(token) ) == 0 ) ? ZC_RET_OK : ZC_RET_ERROR;
+}
+
+static double bench_seconds( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main( void )
+{
+  static const u16 lengths[] = { 1, 16, 21, 22, 42, 43, 100 };
+  u8 input[BENCH_KEY_BYTES], output[BENCH_KEY_BYTES];
+  u8 plain[128], cipher[256], decrypted[256];
+  u16 cipher_len, plain_len;
+  rsa_context rsa;
+  double t, per_session, cached;
+  u32 i, k, mallocs;
+  int failed = 0;
+
+  bench_adapter.pfunPrintf = bench_printf;
+  bench_adapter.pfunMalloc = bench_malloc;
+  bench_adapter.pfunFree = free;
+  g_struProtocolController.pstruMoudleFun = &bench_adapter;
+  bench_use_key( bench_private_keys[0] );
+
+  /* Raw public and CRT private operations against the known answers */
+  for( i = 0; i < BENCH_KEY_BYTES; i++ )
+    input[i] = (u8)( i + 1 );
+  SEC_InitRsaContextWithPublicKey( &rsa, bench_cloud_key );
+  if( rsa_public( &rsa, input, output ) != 0 || memcmp( output, bench_public_kat, BENCH_KEY_BYTES ) != 0 ){
+    printf( "Public key operation differs\n" );
+    failed = 1;
+  }
+  rsa_free( &rsa );
+  for( i = 0; i < BENCH_KEY_BYTES; i++ )
+    input[i] = (u8)( i + 0x40 );
+  SEC_InitRsaContextWithPrivateKey( &rsa, bench_device_key );
+  if( rsa_private( &rsa, input, output ) != 0 || memcmp( output, bench_private_kat, BENCH_KEY_BYTES ) != 0 ){
+    printf( "Private key operation differs\n" );
+    failed = 1;
+  }
+  rsa_free( &rsa );
+
+  /* Round trips of one and several blocks, with each key in turn */
+  for( i = 0; i < sizeof(plain); i++ )
+    plain[i] = (u8)( i * 13 + 1 );
+  for( k = 0; k < 4; k++ ){
+    bench_use_key( bench_private_keys[k & 1] );
+    for( i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++ ){
+      memset( decrypted, 0, sizeof(decrypted) );
+      if( SEC_EncryptTextByRsa( cipher, plain, lengths[i], &cipher_len ) != ZC_RET_OK ||
+          cipher_len != ( lengths[i] + 20 ) / 21 * BENCH_KEY_BYTES ||
+          SEC_DecryptTextByRsa( cipher, decrypted, cipher_len, &plain_len ) != ZC_RET_OK ||
+          plain_len != lengths[i] || memcmp( decrypted, plain, lengths[i] ) != 0 ){
+        printf( "Key %u, %u bytes: round trip failed\n", (unsigned)( k & 1 ), (unsigned)lengths[i] );
+        failed = 1;
+      }
+    }
+  }
+
+  /* A session with the same keys builds nothing */
+  bench_use_key( bench_private_keys[0] );
+  bench_handshake_cached( );
+  mallocs = bench_mallocs;
+  if( bench_handshake_cached( ) != ZC_RET_OK )
+    failed = 1;
+  printf( "Cached handshake: %u allocations\n", (unsigned)( bench_mallocs - mallocs ) );
+
+  /* Rounds of both alternate, the best of each is reported */
+  per_session = cached = 0;
+  for( k = 0; k < BENCH_ROUNDS; k++ ){
+    t = bench_seconds( );
+    for( i = 0; i < BENCH_HANDSHAKES; i++ )
+      failed |= bench_handshake_per_session( );
+    t = BENCH_HANDSHAKES / ( bench_seconds( ) - t );
+    per_session = ( t > per_session ) ? t : per_session;
+
+    t = bench_seconds( );
+    for( i = 0; i < BENCH_HANDSHAKES; i++ )
+      failed |= bench_handshake_cached( );
+    t = BENCH_HANDSHAKES / ( bench_seconds( ) - t );
+    cached = ( t > cached ) ? t : cached;
+  }
+
+  printf( "Handshakes/s: per session context %.0f, cached context %.0f (x%.2f)\n", per_session, cached, cached / per_session );
+
+  if( failed )
+    printf( "Benchmark failed\n" );
+  return failed;
+}
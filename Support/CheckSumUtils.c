@@ -23,8 +23,10 @@
 
 #if defined ( __ICCARM__ ) /* IAR*/
 #define MOVE_TO_TEXT_SECTION @ ".text"
-#else
+#elif defined ( __arm__ )
 #define MOVE_TO_TEXT_SECTION __attribute__ ((section(".text")))
+#else /* Host builds, e.g. the flash simulator */
+#define MOVE_TO_TEXT_SECTION
 #endif
 
 const unsigned char mico_CRC8Table[]={
@@ -377,9 +377,12 @@ OSStatus HTTPHeaderParse( HTTPHeader_t *ioHeader )
   const char *        end;
   const char *        ptr;
   char                c;
+  const char *        name;
+  size_t              nameSize;
   const char *        value;
   size_t              valueSize;
   int                 x;
+  int                 found;
   
   require_action( ioHeader->len < sizeof( ioHeader->buf ), exit, err = kParamErr );
   
@@ -482,17 +485,31 @@ OSStatus HTTPHeaderParse( HTTPHeader_t *ioHeader )
   // There should at least be a blank line after the start line so make sure there's more data.
   require_action( ptr < end, exit, err = kMalformedErr );
   
-  // Determine persistence. Note: HTTP 1.0 defaults to non-persistent if a Connection header field is not present.
-  err = HTTPGetHeaderField( ioHeader->buf, ioHeader->len, "Connection", NULL, NULL, &value, &valueSize, NULL );
-  if( err )   ioHeader->persistent = (Boolean)( strnicmpx( ioHeader->protocolPtr, ioHeader->protocolLen, "HTTP/1.0" ) != 0 );
-  else        ioHeader->persistent = (Boolean)( strnicmpx( value, valueSize, "close" ) != 0 );
-
-  err = HTTPGetHeaderField( ioHeader->buf, ioHeader->len, "Transfer-Encoding", NULL, NULL, &value, &valueSize, NULL );
-  if( err )   ioHeader->chunkedData = false;
-  else        ioHeader->chunkedData = (Boolean)( strnicmpx( value, valueSize, kTransferrEncodingType_CHUNKED ) == 0 );
-  
-  // Content-Length is such a common field that we get it here during general parsing.
-  HTTPScanFHeaderValue( ioHeader->buf, ioHeader->len, "Content-Length", "%llu", &ioHeader->contentLength );
+  // Connection, Transfer-Encoding and Content-Length are needed for every message, so pick them up in a single pass
+  // over the header fields. The first occurrence of each one counts.
+  // Note: HTTP 1.0 defaults to non-persistent if a Connection header field is not present.
+  ioHeader->persistent  = (Boolean)( strnicmpx( ioHeader->protocolPtr, ioHeader->protocolLen, "HTTP/1.0" ) != 0 );
+  ioHeader->chunkedData = false;
+  found = 0;
+  while( ( found != 0x7 ) &&
+         ( HTTPGetHeaderField( ptr, (size_t)( end - ptr ), NULL, &name, &nameSize, &value, &valueSize, &ptr ) == kNoErr ) )
+  {
+    if( !( found & 0x1 ) && ( strnicmpx( name, nameSize, "Connection" ) == 0 ) )
+    {
+      found |= 0x1;
+      ioHeader->persistent = (Boolean)( strnicmpx( value, valueSize, "close" ) != 0 );
+    }
+    else if( !( found & 0x2 ) && ( strnicmpx( name, nameSize, "Transfer-Encoding" ) == 0 ) )
+    {
+      found |= 0x2;
+      ioHeader->chunkedData = (Boolean)( strnicmpx( value, valueSize, kTransferrEncodingType_CHUNKED ) == 0 );
+    }
+    else if( !( found & 0x4 ) && ( strnicmpx( name, nameSize, "Content-Length" ) == 0 ) )
+    {
+      found |= 0x4;
+      ScanFormatApply( &kScanFormat_llu, value, valueSize, &ioHeader->contentLength );
+    }
+  }
 
   err = kNoErr;
   
@@ -546,17 +563,18 @@ int findChunkedDataLength( const char *inChunkPtr , size_t inChunkLen, char **
 
     if( ( len >= 2 ) && ( src[ 1 ] == '\n' ) ) // CRLF
     {
+      // The chunk size is always hex, and stored in the 64-bit length passed after inFormat.
       if(*inChunkPtr == 0x30){ //last chunk
         *chunkedDataPtr = src + 2;
         va_start( args, inFormat );
-        VSNScanF( "0", 1, "%llu", args);
+        ScanFormatApplyV( &kScanFormat_llu, "0", 1, args);
         va_end( args );
         return true;
       }
 
       *chunkedDataPtr = src + 2;
       va_start( args, inFormat );
-      VSNScanF( inChunkPtr, src - inChunkPtr, "%x", args);
+      ScanFormatApplyV( &kScanFormat_llx, inChunkPtr, src - inChunkPtr, args);
       va_end( args );
       return true;
     }
@@ -683,6 +701,11 @@ char* HTTPHeaderMatchPartialURL( HTTPHeader_t *inHeader, const char *url )
   return strnstr_suffix( inHeader->url.pathPtr, inHeader->url.pathLen, url);
 }
 
+const URLRoute * HTTPHeaderRouteURL( HTTPHeader_t *inHeader, const URLRouter *inRouter, const char **outRestPtr, size_t *outRestLen )
+{
+  return URLRouterMatch( inRouter, inHeader->url.pathPtr, inHeader->url.pathLen, outRestPtr, outRestLen );
+}
+
 HTTPHeader_t * HTTPHeaderCreate( void )
 {
   HTTPHeader_t *httpHeader;
@@ -887,7 +910,7 @@ OSStatus CreateHTTPMessage( const char *methold, const char *url, const char *co
   OSStatus err = kParamErr;
     
   err = kNoMemoryErr;
-  *outMessage = malloc( inDataLen + 500 );
+  *outMessage = malloc( ( inData ? inDataLen : 0 ) + 500 );
   require( *outMessage, exit );
   
   // Create HTTP Response
@@ -902,11 +925,14 @@ OSStatus CreateHTTPMessage( const char *methold, const char *url, const char *co
             "%s %s\? %s %s",
             methold, url, "HTTP/1.1", kCRLFLineEnding );
   
-  // outMessageSize will be the length of the HTTP Header plus the data length
-  *outMessageSize = strlen( (char*)*outMessage ) + inDataLen;
-  
-  endOfHTTPHeader = *outMessage + strlen( (char*)*outMessage );
-  memcpy( endOfHTTPHeader, inData, inDataLen ); 
+  // outMessageSize will be the length of the HTTP Header plus the data length,
+  // a NULL inData only builds the header so that the body can be sent from where it is
+  *outMessageSize = strlen( (char*)*outMessage );
+  if( inData ) {
+    endOfHTTPHeader = *outMessage + *outMessageSize;
+    memcpy( endOfHTTPHeader, inData, inDataLen );
+    *outMessageSize += inDataLen;
+  }
   err = kNoErr;
   
 exit:
@@ -923,7 +949,7 @@ OSStatus CreateHTTPMessageWithHost( const char *methold, const char *url,
   OSStatus err = kParamErr;
     
   err = kNoMemoryErr;
-  *outMessage = malloc( inDataLen + 500 );
+  *outMessage = malloc( ( inData ? inDataLen : 0 ) + 500 );
   require( *outMessage, exit );
   
   // Create HTTP Response
@@ -940,11 +966,14 @@ OSStatus CreateHTTPMessageWithHost( const char *methold, const char *url,
             methold, url, "HTTP/1.1", kCRLFNewLine,
            "Host:", host, port, kCRLFLineEnding);
   
-  // outMessageSize will be the length of the HTTP Header plus the data length
-  *outMessageSize = strlen( (char*)*outMessage ) + inDataLen;
-  
-  endOfHTTPHeader = *outMessage + strlen( (char*)*outMessage );
-  memcpy( endOfHTTPHeader, inData, inDataLen ); 
+  // outMessageSize will be the length of the HTTP Header plus the data length,
+  // a NULL inData only builds the header so that the body can be sent from where it is
+  *outMessageSize = strlen( (char*)*outMessage );
+  if( inData ) {
+    endOfHTTPHeader = *outMessage + *outMessageSize;
+    memcpy( endOfHTTPHeader, inData, inDataLen );
+    *outMessageSize += inDataLen;
+  }
   err = kNoErr;
   
 exit:
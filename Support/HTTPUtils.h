@@ -151,6 +151,9 @@ int HTTPHeaderMatchURL( HTTPHeader_t *inHeader, const char *url );
 
 char* HTTPHeaderMatchPartialURL( HTTPHeader_t *inHeader, const char *url );
 
+// Looks the request path up in a router built with URLRouterInit, instead of trying HTTPHeaderMatchURL route by route.
+const URLRoute * HTTPHeaderRouteURL( HTTPHeader_t *inHeader, const URLRouter *inRouter, const char **outRestPtr, size_t *outRestLen );
+
 
 int HTTPGetHeaderField( const char *inHeaderPtr, 
                              size_t     inHeaderLen, 
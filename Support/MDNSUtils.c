@@ -21,6 +21,7 @@
 */ 
 
 #include "MDNSUtils.h"
+#include "MICOTimerService.h"
 
 static int mDNS_fd = -1;
 
@@ -89,6 +90,13 @@ static mico_mutex_t bonjour_mutex = NULL;
 static mico_thread_t mfi_bonjour_thread_handler;
 static void _bonjour_thread(void *arg);
 
+/* Announcements are paced by the timer service and posted back to the bonjour
+   thread, which otherwise sleeps in select() until a query arrives */
+#define BONJOUR_ANNOUNCE_INTERVAL   (1000)
+static mico_service_timer_t _bonjour_announce_timer;
+static mico_queue_t _bonjour_timer_queue = NULL;
+static void _bonjour_kick_announce(void);
+
 static char *__strdup(char *src)
 {
   int len;
@@ -529,6 +537,7 @@ void bonjour_update_txt_record(char *txt_record)
   available_services->txt_att = (char*)__strdup(txt_record);
 
   _bonjour_announce = 1;
+  _bonjour_kick_announce();
   mico_rtos_unlock_mutex( &bonjour_mutex );
 
 }
@@ -611,8 +620,34 @@ void mfi_bonjour_remove_record(int fd)
   }
 }
 
+/* Runs on the bonjour thread, posted by the timer service */
+static void _bonjour_announce_handler(void *arg)
+{
+  (void)arg;
+  mico_rtos_lock_mutex( &bonjour_mutex );
+  /*Send bonjour info when wifi is connected */
+  if(_bonjour_announce){
+    mfi_bonjour_send(mDNS_fd);
+    _bonjour_announce_time ++;
+  }
+  if(_bonjour_announce == 0 || _bonjour_announce_time > 3){
+    _bonjour_announce_time = 0;
+    _bonjour_announce = 0;
+    MICOStopServiceTimer(&_bonjour_announce_timer);
+  }
+  mico_rtos_unlock_mutex( &bonjour_mutex );
+}
+
+static void _bonjour_kick_announce(void)
+{
+  if(_bonjour_timer_queue == NULL || MICOServiceTimerIsActive(&_bonjour_announce_timer))
+    return;
+  MICOStartServiceTimer(&_bonjour_announce_timer, 0, BONJOUR_ANNOUNCE_INTERVAL);
+}
+
 int start_bonjour_service(void)
 {
+  MICOStartTimerService();
   return mico_rtos_create_thread(&mfi_bonjour_thread_handler, MICO_APPLICATION_PRIORITY, "Bonjour", _bonjour_thread, 0x500, NULL );
 }
 
@@ -622,12 +657,14 @@ void suspend_bonjour_service(bool state)
   if(state == true){
     _bonjour_suspended = true;
     _bonjour_announce = 0;
+    MICOStopServiceTimer(&_bonjour_announce_timer);
     mfi_bonjour_remove_record(mDNS_fd);
   }
   else{
     _bonjour_suspended = false;
     _bonjour_announce = 1;
     _bonjour_announce_time = 0;
+    _bonjour_kick_announce();
   }
   mico_rtos_unlock_mutex( &bonjour_mutex );
 }
@@ -636,19 +673,17 @@ void _bonjour_thread(void *arg)
 {
   uint8_t *buf = NULL;
   int con = -1;
+  int timer_fd = -1;
   fd_set readfds;
-  struct timeval_t t;
   struct sockaddr_t addr;
   socklen_t addrLen;
   uint32_t opt;
+  mico_service_timer_t *timer;
   (void)arg;
   OSStatus err;
   
   buf = malloc(1500);
   
-  t.tv_sec = 1;
-  t.tv_usec = 0;
-  
   mDNS_fd = socket(AF_INET, SOCK_DGRM, IPPROTO_UDP);
   require_action(IsValidSocket( mDNS_fd ), exit, err = kNoResourcesErr );
   opt = 0xE00000FB; //"224.0.0.251"
@@ -658,26 +693,29 @@ void _bonjour_thread(void *arg)
   err = bind(mDNS_fd, &addr, sizeof(addr));
   require_noerr(err, exit);
 
+  err = mico_rtos_init_queue(&_bonjour_timer_queue, "Bonjour timer", sizeof(mico_service_timer_t *), 2);
+  require_noerr(err, exit);
+  timer_fd = mico_create_event_fd(_bonjour_timer_queue);
+  require_action(timer_fd >= 0, exit, err = kNoResourcesErr);
+  MICOInitServiceTimer(&_bonjour_announce_timer, _bonjour_announce_handler, NULL);
+  MICOPostServiceTimer(&_bonjour_announce_timer, &_bonjour_timer_queue);
+
+  mico_rtos_lock_mutex( &bonjour_mutex );
   _bonjour_announce = 1;
+  _bonjour_kick_announce();
+  mico_rtos_unlock_mutex( &bonjour_mutex );
   
   while(1) {
-    /*Send bonjour info when wifi is connected */
-    if(_bonjour_announce){
-      mico_rtos_lock_mutex( &bonjour_mutex );
-      mfi_bonjour_send(mDNS_fd);
-     
-      _bonjour_announce_time ++;
-      if(_bonjour_announce_time > 3){
-        _bonjour_announce_time = 0;
-        _bonjour_announce = 0;
-      }
-      mico_rtos_unlock_mutex( &bonjour_mutex );
-    }
-
-    /*Check status on erery sockets on bonjour query */
+    /*Check status on erery sockets on bonjour query, no timeout: announcements wake us up */
     FD_ZERO(&readfds);
     FD_SET(mDNS_fd, &readfds);
-    select(mDNS_fd+1, &readfds, NULL, NULL, &t);
+    FD_SET(timer_fd, &readfds);
+    select(Max(mDNS_fd, timer_fd)+1, &readfds, NULL, NULL, NULL);
+
+    if (FD_ISSET(timer_fd, &readfds)) {
+      while(mico_rtos_pop_from_queue(&_bonjour_timer_queue, &timer, 0) == kNoErr)
+        MICORunServiceTimer(timer);
+    }
     
     /*Read data from udp and send data back */ 
     if (FD_ISSET(mDNS_fd, &readfds)) {
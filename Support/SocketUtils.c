@@ -30,42 +30,147 @@ OSStatus SocketSend( int fd, const uint8_t *inBuf, size_t inBufLen )
 {
     socket_utils_log_trace();
     OSStatus err = kParamErr;
-    ssize_t writeResult;
-    int selectResult;
-    size_t numWritten;
-    fd_set writeSet;
-    struct timeval_t t;
+    SocketIOVec_t iov;
 
-    require( fd>=0, exit );
     require( inBuf, exit );
     require( inBufLen, exit );
 
-    err = kNotWritableErr;
+    iov.buf = inBuf;
+    iov.len = inBufLen;
+    err = SocketSendv( fd, &iov, 1, NULL );
+
+exit:
+    return err;
+}
+
+OSStatus SocketSendv( int fd, const SocketIOVec_t *inIOV, int inCount, SocketSendStats_t *outStats )
+{
+    OSStatus err = kParamErr;
+    SocketSendContext_t ctx;
+    uint8_t *stage = NULL;
+    size_t total = 0;
+    int i;
+
+    require( fd>=0, exit );
+    require( inIOV, exit );
+    require( inCount > 0, exit );
+
+    // The stage never holds more than the whole message, and is not needed for a single segment.
+    for( i = 0; i < inCount; i++ ) total += inIOV[i].len;
+    if( inCount > 1 ) stage = malloc( Min( total, kSocketSendMSS ) );
+
+    SocketSendInit( &ctx, inIOV, inCount, stage, stage ? Min( total, kSocketSendMSS ) : 0 );
+    err = SocketSendContinue( fd, &ctx, kSocketSendTimeout );
+    if( outStats ) *outStats = ctx.stats;
+    require_noerr_action( err, exit,
+                          socket_utils_log("ERROR: Did not write all the bytes in the buffer. BufLen: %lu, Bytes Written: %u", (unsigned long)total, (unsigned)ctx.stats.bytes ) );
+
+exit:
+    if( stage ) free( stage );
+    return err;
+}
+
+void SocketSendInit( SocketSendContext_t *ctx, const SocketIOVec_t *inIOV, int inCount, uint8_t *inStage, size_t inStageSize )
+{
+    memset( ctx, 0, sizeof( SocketSendContext_t ) );
+    ctx->iov = inIOV;
+    ctx->iovCount = inCount;
+    ctx->stage = inStage;
+    ctx->stageSize = Min( inStageSize, kSocketSendMSS );
+}
+
+/* Poll first so that a socket that is not writable right away is counted as a stall, then wait for it. */
+static int _SocketWaitWritable( int fd, uint32_t timeout_ms, SocketSendStats_t *stats )
+{
+    fd_set writeSet;
+    struct timeval_t t;
+    int selectResult;
 
     FD_ZERO( &writeSet );
     FD_SET( fd, &writeSet );
-
-    t.tv_sec = 5;
+    t.tv_sec = 0;
     t.tv_usec = 0;
-    numWritten = 0;
-    do
+    stats->syscalls++;
+    selectResult = select( fd + 1, NULL, &writeSet, NULL, &t );
+    if( selectResult != 0 ) return selectResult;
+
+    stats->stalls++;
+    if( timeout_ms == 0 ) return 0;
+
+    FD_ZERO( &writeSet );
+    FD_SET( fd, &writeSet );
+    t.tv_sec = timeout_ms / 1000;
+    t.tv_usec = ( timeout_ms % 1000 ) * 1000;
+    stats->syscalls++;
+    return select( fd + 1, NULL, &writeSet, NULL, &t );
+}
+
+static void _SocketSendStage( SocketSendContext_t *ctx )
+{
+    const SocketIOVec_t *v;
+    size_t n;
+
+    while( ( ctx->index < ctx->iovCount ) && ( ctx->stageLen < ctx->stageSize ) )
     {
-        selectResult = select( fd + 1, NULL, &writeSet, NULL,  &t );
-        require( selectResult >= 1, exit );
+        v = &ctx->iov[ ctx->index ];
+        n = Min( v->len - ctx->offset, ctx->stageSize - ctx->stageLen );
+        memcpy( ctx->stage + ctx->stageLen, (const uint8_t *)v->buf + ctx->offset, n );
+        ctx->stageLen += n;
+        ctx->offset += n;
+        if( ctx->offset >= v->len ) {
+            ctx->index++;
+            ctx->offset = 0;
+        }
+    }
+}
 
-        writeResult = write( fd, (void *)( inBuf + numWritten ), ( inBufLen - numWritten ) );
-        require( writeResult > 0, exit );
+OSStatus SocketSendContinue( int fd, SocketSendContext_t *ctx, uint32_t timeout_ms )
+{
+    OSStatus err = kNotWritableErr;
+    const uint8_t *ptr;
+    size_t len;
+    ssize_t writeResult;
+    int selectResult;
 
-        numWritten += writeResult;
+    for( ;; )
+    {
+        if( ctx->stageSent == ctx->stageLen ) {
+            ctx->stageLen = 0;
+            ctx->stageSent = 0;
+        }
+        while( ( ctx->index < ctx->iovCount ) && ( ctx->offset >= ctx->iov[ ctx->index ].len ) ) {
+            ctx->index++;
+            ctx->offset = 0;
+        }
 
-        //socket_utils_log("Wrote %zu / %zu bytes", numWritten, inBufLen);
+        if( ctx->stageLen == 0 ) {
+            if( ctx->index >= ctx->iovCount ) break;
+            len = ctx->iov[ ctx->index ].len - ctx->offset;
+            if( ctx->stage && ( len < kSocketSendMSS ) && ( ctx->index + 1 < ctx->iovCount ) )
+                _SocketSendStage( ctx );
+        }
+
+        if( ctx->stageLen ) {
+            ptr = ctx->stage + ctx->stageSent;
+            len = ctx->stageLen - ctx->stageSent;
+        } else {
+            ptr = (const uint8_t *)ctx->iov[ ctx->index ].buf + ctx->offset;
+            len = ctx->iov[ ctx->index ].len - ctx->offset;
+        }
 
-    } while( numWritten < inBufLen );
+        selectResult = _SocketWaitWritable( fd, timeout_ms, &ctx->stats );
+        require_action_quiet( selectResult != 0 || timeout_ms != 0, exit, err = kInProgressErr );
+        require( selectResult >= 1, exit );
 
-    require_action( numWritten == inBufLen,
-                    exit,
-                    socket_utils_log("ERROR: Did not write all the bytes in the buffer. BufLen: %zu, Bytes Written: %zu", inBufLen, numWritten ); err = kUnderrunErr );
+        ctx->stats.syscalls++;
+        ctx->stats.writes++;
+        writeResult = write( fd, (void *)ptr, len );
+        require( writeResult > 0, exit );
 
+        ctx->stats.bytes += writeResult;
+        if( ctx->stageLen ) ctx->stageSent += writeResult;
+        else ctx->offset += writeResult;
+    }
     err = kNoErr;
 
 exit:
@@ -24,8 +24,56 @@
 
 #include "Common.h"
 
+#define kSocketSendMSS          1460    //! Largest write built from coalesced segments, one TCP segment.
+#define kSocketSendTimeout      5000    //! Milliseconds SocketSend and SocketSendv wait for the socket to become writable.
+
+typedef struct
+{
+    const void *        buf;
+    size_t              len;
+} SocketIOVec_t;
+
+typedef struct
+{
+    uint32_t            bytes;          //! Bytes written.
+    uint32_t            syscalls;       //! select() and write() calls.
+    uint32_t            writes;         //! write() calls.
+    uint32_t            stalls;         //! Times the socket was not writable right away.
+} SocketSendStats_t;
+
+/* State of a scatter-gather send, so that a nonblocking sender can continue where it stopped.
+*  Segments shorter than kSocketSendMSS are copied into the stage buffer together with the following
+*  segments and go out in one write; a segment with at least kSocketSendMSS bytes left is written
+*  straight from the caller's memory.
+*/
+typedef struct
+{
+    const SocketIOVec_t *iov;
+    int                 iovCount;
+    int                 index;          //! Segment being sent.
+    size_t              offset;         //! Bytes of iov[index] already written or staged.
+    uint8_t *           stage;          //! Coalescing buffer, NULL to write every segment on its own.
+    size_t              stageSize;
+    size_t              stageLen;       //! Bytes staged.
+    size_t              stageSent;      //! Staged bytes already written.
+    SocketSendStats_t   stats;
+} SocketSendContext_t;
+
 OSStatus SocketSend( int fd, const uint8_t *inBuf, size_t inBufLen );
 
+/* Sends all segments in order and waits up to kSocketSendTimeout each time the socket is not writable.
+*  A coalescing buffer is allocated for the call when there is more than one segment. outStats may be NULL.
+*/
+OSStatus SocketSendv( int fd, const SocketIOVec_t *inIOV, int inCount, SocketSendStats_t *outStats );
+
+void SocketSendInit( SocketSendContext_t *ctx, const SocketIOVec_t *inIOV, int inCount, uint8_t *inStage, size_t inStageSize );
+
+/* Writes as much as possible. Returns kNoErr once everything is sent. If the socket is not writable within
+*  timeout_ms it returns kInProgressErr when timeout_ms is 0 (call again once select() reports the socket
+*  writable), and kNotWritableErr otherwise.
+*/
+OSStatus SocketSendContinue( int fd, SocketSendContext_t *ctx, uint32_t timeout_ms );
+
 void SocketClose(int* fd);
 
 void SocketCloseForOSEvent(int* fd);
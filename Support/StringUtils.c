@@ -32,6 +32,54 @@
 #define CONVERTHEX_alpha(c)  (IS_AF(c) ? (c - 'A'+10) : (c - 'a'+10))
 #define CONVERTHEX(c)   (IS_09(c) ? (c - '0') : CONVERTHEX_alpha(c))
 
+// Word-at-a-time helpers, a word holds 4 characters.
+#define kWordOnes           0x01010101UL
+#define kWordHighBits       0x80808080UL
+#define WORD_HAS_ZERO(w)    ( ( (w) - kWordOnes ) & ~(w) & kWordHighBits )
+
+static const char kHexDigits[] = "0123456789ABCDEF";
+
+// Nibble value of a hex digit, 0xFF for any other 7-bit character.
+static const uint8_t kHexDecodeTable[ 128 ] =
+{
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+static const char kBase64EncodeTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Sextet value of a base64 character, 0xFE for white space, 0xFD for '=' and 0xFF for any other 7-bit character.
+#define kBase64Space        0xFE
+#define kBase64Pad          0xFD
+static const uint8_t kBase64DecodeTable[ 128 ] =
+{
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0xFE, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFD, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+//===========================================================================================================================
+//  _LowerWord
+//
+//  tolower() on the 4 characters of a word in one go, every byte must be 7-bit. A byte gets its top bit set by adding
+//  0x3F once it is >= 'A', and by adding 0x25 once it is > 'Z', so the two sums only differ on 'A'..'Z'.
+//===========================================================================================================================
+static inline uint32_t _LowerWord( uint32_t w )
+{
+    return( w | ( ( ( ( w + 0x3F3F3F3FUL ) ^ ( w + 0x25252525UL ) ) & kWordHighBits ) >> 2 ) );
+}
+
 //===========================================================================================================================
 //  formatMACAddr
 //
@@ -295,66 +343,48 @@ exit:
 char* DataToHexString( const uint8_t *inBuf, size_t inBufLen )
 {
     char* buf_str = NULL;
-    char* buf_ptr;
     require_quiet(inBuf, error);
     require_quiet(inBufLen > 0, error);
 
     buf_str = (char*) malloc (2*inBufLen + 1);
     require(buf_str, error);
-    buf_ptr = buf_str;
-    uint32_t i;
-    for (i = 0; i < inBufLen; i++) buf_ptr += sprintf(buf_ptr, "%02X", inBuf[i]);
-    *buf_ptr = '\0';
+    HexEncode( inBuf, inBufLen, 0, buf_str );
     return buf_str;
 
 error:
-    if ( buf_str ) free( buf_str );
     return NULL;
 }
 
 char* DataToHexStringWithSpaces( const uint8_t *inBuf, size_t inBufLen )
 {
     char* buf_str = NULL;
-    char* buf_ptr = NULL;
+    size_t len;
     require_quiet(inBuf, error);
     require_quiet(inBufLen > 0, error);
 
     buf_str = (char*) malloc (3*inBufLen + 1);
     require(buf_str, error);
-    buf_ptr = buf_str;
-    uint32_t i;
-    for (i = 0; i < inBufLen; i++) buf_ptr += sprintf(buf_ptr, "%02X ", inBuf[i]);
-    *buf_ptr = '\0';
+    len = HexEncode( inBuf, inBufLen, ' ', buf_str );
+    buf_str[len++] = ' ';
+    buf_str[len] = '\0';
     return buf_str;
 
 error:
-    if ( buf_str ) free( buf_str );
     return NULL;
 }
 
 char* DataToHexStringWithColons( const uint8_t *inBuf, size_t inBufLen )
 {
     char* buf_str = NULL;
-    char* buf_ptr = NULL;
     require_quiet(inBuf, error);
     require_quiet(inBufLen > 0, error);
 
-    buf_str = (char*) malloc (3*inBufLen + 1);
+    buf_str = (char*) malloc (3*inBufLen);
     require(buf_str, error);
-    buf_ptr = buf_str;
-    uint32_t i;
-    for (i = 0; i < inBufLen; i++)
-    {
-        if ( i == inBufLen - 1 )
-            buf_ptr += sprintf(buf_ptr, "%02X", inBuf[i]);
-        else
-            buf_ptr += sprintf(buf_ptr, "%02X:", inBuf[i]);
-    }
-    *buf_ptr = '\0';
+    HexEncode( inBuf, inBufLen, ':', buf_str );
     return buf_str;
 
 error:
-    if ( buf_str ) free( buf_str );
     return NULL;
 }
 
@@ -375,6 +405,196 @@ error:
     return NULL;
 }
 
+//===========================================================================================================================
+//  HexEncode / HexDecode
+//===========================================================================================================================
+
+size_t HexEncode( const void *inData, size_t inLen, char inSeparator, char *outText )
+{
+    const uint8_t *     src;
+    char *              dst;
+    size_t              i;
+
+    src = (const uint8_t *) inData;
+    dst = outText;
+    for( i = 0; i < inLen; i++ )
+    {
+        if( inSeparator && ( i > 0 ) ) *dst++ = inSeparator;
+        *dst++ = kHexDigits[ src[ i ] >> 4 ];
+        *dst++ = kHexDigits[ src[ i ] & 0x0F ];
+    }
+    *dst = '\0';
+    return( (size_t)( dst - outText ) );
+}
+
+OSStatus HexDecode( const char *inText, size_t inTextLen, void *outData, size_t inMaxLen, size_t *outLen )
+{
+    OSStatus                    err;
+    const unsigned char *       src;
+    const unsigned char *       end;
+    uint8_t *                   dst;
+    size_t                      n;
+    uint8_t                     hi;
+    uint8_t                     lo;
+
+    if( inTextLen == kSizeCString ) inTextLen = strlen( inText );
+    src = (const unsigned char *) inText;
+    end = src + inTextLen;
+    dst = (uint8_t *) outData;
+    n   = 0;
+
+    while( src < end )
+    {
+        if( ( n > 0 ) && ( ( *src == ':' ) || ( *src == '-' ) || ( *src == ' ' ) ) )
+        {
+            if( ++src >= end ) break;   // Trailing separator, as from DataToHexStringWithSpaces.
+        }
+        require_action_quiet( ( end - src ) >= 2, exit, err = kMalformedErr );
+        require_action_quiet( ( ( src[ 0 ] | src[ 1 ] ) & 0x80 ) == 0, exit, err = kMalformedErr );
+        hi = kHexDecodeTable[ src[ 0 ] ];
+        lo = kHexDecodeTable[ src[ 1 ] ];
+        require_action_quiet( ( hi | lo ) < 0x10, exit, err = kMalformedErr );
+        require_action_quiet( n < inMaxLen, exit, err = kNoSpaceErr );
+        dst[ n++ ] = (uint8_t)( ( hi << 4 ) | lo );
+        src += 2;
+    }
+    err = kNoErr;
+
+exit:
+    if( outLen ) *outLen = n;
+    return err;
+}
+
+//===========================================================================================================================
+//  Base64Encode / Base64Decode
+//
+//  Standard alphabet with '=' padding. The decoder takes 4 characters per step while the input is clean, and falls
+//  back to one character at a time around white space (line breaks of MIME/PEM text) and the padded tail.
+//===========================================================================================================================
+
+size_t Base64Encode( const void *inData, size_t inLen, char *outText )
+{
+    const uint8_t *     src;
+    char *              dst;
+    uint32_t            v;
+
+    src = (const uint8_t *) inData;
+    dst = outText;
+    while( inLen >= 3 )
+    {
+        v = ( (uint32_t) src[ 0 ] << 16 ) | ( (uint32_t) src[ 1 ] << 8 ) | src[ 2 ];
+        dst[ 0 ] = kBase64EncodeTable[ v >> 18 ];
+        dst[ 1 ] = kBase64EncodeTable[ ( v >> 12 ) & 0x3F ];
+        dst[ 2 ] = kBase64EncodeTable[ ( v >>  6 ) & 0x3F ];
+        dst[ 3 ] = kBase64EncodeTable[ v & 0x3F ];
+        src   += 3;
+        dst   += 4;
+        inLen -= 3;
+    }
+    if( inLen > 0 )
+    {
+        v = (uint32_t) src[ 0 ] << 16;
+        if( inLen == 2 ) v |= (uint32_t) src[ 1 ] << 8;
+        dst[ 0 ] = kBase64EncodeTable[ v >> 18 ];
+        dst[ 1 ] = kBase64EncodeTable[ ( v >> 12 ) & 0x3F ];
+        dst[ 2 ] = ( inLen == 2 ) ? kBase64EncodeTable[ ( v >> 6 ) & 0x3F ] : '=';
+        dst[ 3 ] = '=';
+        dst += 4;
+    }
+    *dst = '\0';
+    return( (size_t)( dst - outText ) );
+}
+
+OSStatus Base64Decode( const char *inText, size_t inTextLen, void *outData, size_t inMaxLen, size_t *outLen )
+{
+    OSStatus                    err;
+    const unsigned char *       src;
+    const unsigned char *       end;
+    uint8_t *                   dst;
+    size_t                      n;
+    uint32_t                    quad;
+    int                         count;
+    int                         pad;
+    uint8_t                     a, b, c, d;
+
+    if( inTextLen == kSizeCString ) inTextLen = strlen( inText );
+    src   = (const unsigned char *) inText;
+    end   = src + inTextLen;
+    dst   = (uint8_t *) outData;
+    n     = 0;
+    quad  = 0;
+    count = 0;
+    pad   = 0;
+
+    while( src < end )
+    {
+        // Fast path: a whole group of 4 valid characters.
+        if( ( count == 0 ) && ( ( end - src ) >= 4 ) && ( ( ( src[ 0 ] | src[ 1 ] | src[ 2 ] | src[ 3 ] ) & 0x80 ) == 0 ) )
+        {
+            a = kBase64DecodeTable[ src[ 0 ] ];
+            b = kBase64DecodeTable[ src[ 1 ] ];
+            c = kBase64DecodeTable[ src[ 2 ] ];
+            d = kBase64DecodeTable[ src[ 3 ] ];
+            if( ( a | b | c | d ) < 0x40 )
+            {
+                require_action_quiet( ( inMaxLen - n ) >= 3, exit, err = kNoSpaceErr );
+                quad = ( (uint32_t) a << 18 ) | ( (uint32_t) b << 12 ) | ( (uint32_t) c << 6 ) | d;
+                dst[ n++ ] = (uint8_t)( quad >> 16 );
+                dst[ n++ ] = (uint8_t)( quad >>  8 );
+                dst[ n++ ] = (uint8_t)  quad;
+                src += 4;
+                continue;
+            }
+        }
+
+        // Slow path: one character, skipping white space.
+        require_action_quiet( ( *src & 0x80 ) == 0, exit, err = kMalformedErr );
+        a = kBase64DecodeTable[ *src++ ];
+        if( a == kBase64Space ) continue;
+        if( a == kBase64Pad )
+        {
+            // Only '=' and white space may follow, and never more padding than the group is missing.
+            require_action_quiet( count >= 2, exit, err = kMalformedErr );
+            ++pad;
+            while( src < end )
+            {
+                require_action_quiet( ( *src & 0x80 ) == 0, exit, err = kMalformedErr );
+                a = kBase64DecodeTable[ *src++ ];
+                if( a == kBase64Pad ) ++pad;
+                else require_action_quiet( a == kBase64Space, exit, err = kMalformedErr );
+            }
+            require_action_quiet( ( count + pad ) <= 4, exit, err = kMalformedErr );
+            break;
+        }
+        require_action_quiet( a < 0x40, exit, err = kMalformedErr );
+        quad = ( quad << 6 ) | a;
+        if( ++count == 4 )
+        {
+            require_action_quiet( ( inMaxLen - n ) >= 3, exit, err = kNoSpaceErr );
+            dst[ n++ ] = (uint8_t)( quad >> 16 );
+            dst[ n++ ] = (uint8_t)( quad >>  8 );
+            dst[ n++ ] = (uint8_t)  quad;
+            quad  = 0;
+            count = 0;
+        }
+    }
+
+    // A trailing group of 2 or 3 characters carries 1 or 2 bytes, padded or not.
+    require_action_quiet( count != 1, exit, err = kMalformedErr );
+    if( count > 1 )
+    {
+        require_action_quiet( ( inMaxLen - n ) >= (size_t)( count - 1 ), exit, err = kNoSpaceErr );
+        quad <<= 6 * ( 4 - count );
+        dst[ n++ ] = (uint8_t)( quad >> 16 );
+        if( count == 3 ) dst[ n++ ] = (uint8_t)( quad >> 8 );
+    }
+    err = kNoErr;
+
+exit:
+    if( outLen ) *outLen = n;
+    return err;
+}
+
 //===========================================================================================================================
 //  strnicmp
 //
@@ -384,12 +604,30 @@ error:
 int strnicmp( const char *inS1, const char *inS2, size_t inMax )
 {
     const char *        end;
+    const char *        wordEnd;
     int                 c1;
     int                 c2;
+    uint32_t            w1;
+    uint32_t            w2;
 
-    end = inS1 + inMax;
+    // Words are only read within the bytes both strings are known to hold before a terminator, never past one.
+    end     = inS1 + inMax;
+    wordEnd = inS1 + strnlen( inS2, strnlen( inS1, inMax ) );
     while( inS1 < end )
     {
+        // Compare a word at a time while both are 7-bit.
+        if( ( wordEnd - inS1 ) >= 4 )
+        {
+            memcpy( &w1, inS1, 4 );
+            memcpy( &w2, inS2, 4 );
+            if( ( ( ( w1 | w2 ) & kWordHighBits ) == 0 ) && ( _LowerWord( w1 ) == _LowerWord( w2 ) ) )
+            {
+                inS1 += 4;
+                inS2 += 4;
+                continue;
+            }
+        }
+
         c1 = tolower( *( (const unsigned char *) inS1 ) );
         c2 = tolower( *( (const unsigned char *) inS2 ) );
         if( c1 < c2 )    return( -1 );
@@ -412,13 +650,33 @@ int strnicmpx( const void *inS1, size_t inN, const char *inS2 )
 {
     const unsigned char *       s1;
     const unsigned char *       s2;
+    size_t                      wordN;
     int                         c1;
     int                         c2;
-
-    s1 = (const unsigned char *) inS1;
-    s2 = (const unsigned char *) inS2;
-    while( inN-- > 0 )
+    uint32_t                    w1;
+    uint32_t                    w2;
+
+    // inS1 holds inN readable bytes, inS2 is only read a word at a time before its terminator. Short compares stay on
+    // the byte loop, where measuring inS2 first would cost more than the words save.
+    s1    = (const unsigned char *) inS1;
+    s2    = (const unsigned char *) inS2;
+    wordN = ( inN >= 16 ) ? strnlen( inS2, inN ) : 0;
+    while( inN > 0 )
     {
+        if( wordN >= 4 )
+        {
+            memcpy( &w1, s1, 4 );
+            memcpy( &w2, s2, 4 );
+            if( ( ( ( w1 | w2 ) & kWordHighBits ) == 0 ) && ( _LowerWord( w1 ) == _LowerWord( w2 ) ) )
+            {
+                s1    += 4;
+                s2    += 4;
+                inN   -= 4;
+                wordN -= 4;
+                continue;
+            }
+        }
+
         c1 = tolower( *s1 );
         c2 = tolower( *s2 );
         if( c1 < c2 ) return( -1 );
@@ -427,183 +685,331 @@ int strnicmpx( const void *inS1, size_t inN, const char *inS2 )
 
         ++s1;
         ++s2;
+        --inN;
+        if( wordN > 0 ) --wordN;
     }
     if( *s2 != 0 ) return( -1 );
     return( 0 );
 }
 
 //===========================================================================================================================
-//  VSNScanF - va_list version of SNScanF.
+//  Format scanner
+//
+//  A scanf format is split into ScanOp entries which are then run against the input. VSNScanF parses and runs one op
+//  at a time; ScanFormatCompile keeps the ops so that a format used over and over is only parsed once.
 //===========================================================================================================================
 
-int VSNScanF( const void *inString, size_t inSize, const char *inFormat, va_list inArgs )
+// isspace() of the C locale, without the library call per character.
+#define IS_SPACE( c )   ( ( (c) == ' ' ) || ( (unsigned char)( (c) - '\t' ) <= ( '\r' - '\t' ) ) )
+
+const ScanFormat kScanFormat_d   = { "%d",   1, { SCAN_OP_INT( 10, 0,   sizeof( int ) ) } };
+const ScanFormat kScanFormat_u   = { "%u",   1, { SCAN_OP_INT( 10, 0,   sizeof( int ) ) } };
+const ScanFormat kScanFormat_x   = { "%x",   1, { SCAN_OP_INT( 16, 0,   sizeof( int ) ) } };
+const ScanFormat kScanFormat_llu = { "%llu", 1, { SCAN_OP_INT( 10, 'L', sizeof( int64_t ) ) } };
+const ScanFormat kScanFormat_llx = { "%llx", 1, { SCAN_OP_INT( 16, 'L', sizeof( int64_t ) ) } };
+const ScanFormat kScanFormat_s   = { "%s",   1, { SCAN_OP_STRING() } };
+
+// Formats with a pre-built op list, so VSNScanF does not parse them at all.
+static const ScanFormat * _ScanFindBuiltin( const char *inFormat )
+{
+    if( inFormat[ 0 ] != '%' ) return( NULL );
+    switch( inFormat[ 1 ] )
+    {
+        case 'd': return( ( inFormat[ 2 ] == '\0' ) ? &kScanFormat_d : NULL );
+        case 'u': return( ( inFormat[ 2 ] == '\0' ) ? &kScanFormat_u : NULL );
+        case 'x': return( ( inFormat[ 2 ] == '\0' ) ? &kScanFormat_x : NULL );
+        case 's': return( ( inFormat[ 2 ] == '\0' ) ? &kScanFormat_s : NULL );
+        case 'l':
+            if( ( inFormat[ 2 ] != 'l' ) || ( inFormat[ 3 ] == '\0' ) || ( inFormat[ 4 ] != '\0' ) ) break;
+            if( inFormat[ 3 ] == 'u' ) return( &kScanFormat_llu );
+            if( inFormat[ 3 ] == 'x' ) return( &kScanFormat_llx );
+            break;
+        default:
+            break;
+    }
+    return( NULL );
+}
+
+//===========================================================================================================================
+//  _ScanParseOp
+//
+//  Parses the next op of a format. Returns 1 with the op filled in, 0 at the end of the format and -1 if the format is
+//  not valid.
+//===========================================================================================================================
+
+static int _ScanParseOp( const unsigned char **ioFmt, ScanOp *outOp )
 {
-    int                         matched;
-    const unsigned char *       src;
-    const unsigned char *       end;
     const unsigned char *       fmt;
-    const unsigned char *       old;
-    const unsigned char *       setStart;
-    const unsigned char *       setEnd;
-    const unsigned char *       set;
-    int                         notSet;
-    int                         suppress;
-    int                         alt;
-    int                         storePtr;
-    int                         fieldWidth;
-    int                         sizeModifier;
-    unsigned char *             s;
-    int *                       i;
-    int                         base;
-    int                         negative;
     unsigned char               c;
-    int64_t                     x;
-    int                         v;
-    void *                      p;
-    const unsigned char **      ptrArg;
-    size_t *                    sizeArg;
-    size_t                      len;
+    int                         size;
+    int                         width;
 
-    if( inSize == kSizeCString ) inSize = strlen( (const char *) inString );
-    src = (const unsigned char *) inString;
-    end = src + inSize;
-    fmt = (const unsigned char *) inFormat;
+    fmt = *ioFmt;
+    memset( outOp, 0, sizeof( *outOp ) );
 
-    matched = 0;
-    for( ;; )
+    // 1 or more whitespace in the format matches 0 or more whitepsace in the string.
+
+    if( IS_SPACE( *fmt ) )
     {
-        // Skip whitespace. 1 or more whitespace in the format matches 0 or more whitepsace in the string.
+        while( IS_SPACE( *fmt ) ) ++fmt;
+        outOp->type = kScanOp_Space;
+        goto done;
+    }
+    if( *fmt == '\0' ) return( 0 );
 
-        if( isspace( *fmt ) )
-        {
-            ++fmt;
-            while( isspace( *fmt ) )                  ++fmt;
-            while( ( src < end ) && isspace( *src ) ) ++src;
-        }
-        if( *fmt == '\0' ) break;
+    // If it's not a conversion, the whole run up to the next space or conversion must match exactly.
 
-        // If it's not a conversion, it must match exactly. Otherwise, move onto conversion handling.
+    if( *fmt != '%' )
+    {
+        outOp->type = kScanOp_Literal;
+        outOp->str  = (const char *) fmt;
+        while( ( *fmt != '\0' ) && ( *fmt != '%' ) && !IS_SPACE( *fmt ) ) ++fmt;
+        outOp->len  = (uint16_t)( fmt - (const unsigned char *) outOp->str );
+        goto done;
+    }
+    ++fmt;
 
-        if( *fmt != '%' )
-        {
-            if( src >= end )        break;
-            if( *fmt++ != *src++ )  break;
-            continue;
-        }
+    // Flags
+
+    for( ;; )
+    {
+        c = *fmt;
+        if(      c == '*' ) outOp->flags |= kScanFlagSuppress;
+        else if( c == '#' ) outOp->flags |= kScanFlagAlt;
+        else if( c == '&' ) outOp->flags |= kScanFlagStorePtr;
+        else break;
         ++fmt;
+    }
 
-        // Flags
+    // Field width. If none, use INT_MAX to simplify no-width vs width cases. '.' takes the width from the arguments.
 
-        suppress = 0;
-        alt      = 0;
-        storePtr = 0;
-        for( ;; )
+    if( isdigit( *fmt ) )
+    {
+        width = 0;
+        do
         {
-            c = *fmt;
-            if(      c == '*' ) suppress = 1;
-            else if( c == '#' ) alt     += 1;
-            else if( c == '&' ) storePtr = 1;
-            else break;
-            ++fmt;
-        }
+            width = ( width * 10 ) + ( *fmt++ - '0' );
 
-        // Field width. If none, use INT_MAX to simplify no-width vs width cases.
+        }   while( isdigit( *fmt ) );
+    }
+    else if( *fmt == '.' )
+    {
+        ++fmt;
+        outOp->flags |= kScanFlagArgWidth;
+        width = 0;
+    }
+    else
+    {
+        width = INT_MAX;
+    }
+    outOp->width = width;
 
-        if( isdigit( *fmt ) )
-        {
-            fieldWidth = 0;
-            do
-            {
-                fieldWidth = ( fieldWidth * 10 ) + ( *fmt++ - '0' );
+    // Size modifier. Note: converts double-char (e.g. hh) into unique char (e.g. H) for easier processing.
 
-            }   while( isdigit( *fmt ) );
-        }
-        else if( *fmt == '.' )
-        {
+    c = *fmt;
+    switch( c )
+    {
+        case 'h':
+            if( *( ++fmt ) == 'h' ) { size = 'H'; ++fmt; }  // hh for char * / unsigned char *
+            else                      size = 'h';           // h  for short * / unsigned short *
+            break;
+
+        case 'l':
+            if( *( ++fmt ) == 'l' ) { size = 'L'; ++fmt; }  // ll for long long * / unsigned long long *
+            else                      size = 'l';           // l  for long * / unsigned long *
+            break;
+
+        case 'j':   // j for intmax_t * / uintmax_t *
+        case 'z':   // z for size_t *
+        case 't':   // t for ptrdiff_t *
+            size = c;
             ++fmt;
-            fieldWidth = va_arg( inArgs, int );
-            if( fieldWidth < 0 ) goto exit;
-        }
-        else
-        {
-            fieldWidth = INT_MAX;
-        }
+            break;
 
-        // Size modifier. Note: converts double-char (e.g. hh) into unique char (e.g. H) for easier processing.
-
-        c = *fmt;
-        switch( c )
-        {
-            case 'h':
-                if( *( ++fmt ) == 'h' ) { sizeModifier = 'H'; ++fmt; }  // hh for char * / unsigned char *
-                else                      sizeModifier = 'h';           // h  for short * / unsigned short *
-                break;
+        default:
+            size = 0;
+            break;
+    }
+    if( *fmt == '\0' ) return( 0 );
 
-            case 'l':
-                if( *( ++fmt ) == 'l' ) { sizeModifier = 'L'; ++fmt; }  // ll for long long * / unsigned long long *
-                else                      sizeModifier = 'l';           // l  for long * / unsigned long *
-                break;
+    // Conversions
 
-            case 'j':   // j for intmax_t * / uintmax_t *
-            case 'z':   // z for size_t *
-            case 't':   // t for ptrdiff_t *
-                sizeModifier = c;
+    outOp->type = kScanOp_Int;
+    switch( *fmt++ )
+    {
+        case 'd':   // %d: Signed decimal integer.
+        case 'u':   // %u: Unsigned decimal integer.
+            outOp->base = 10;
+            break;
+
+        case 'p':   // %x/%X/%p: Hexidecimal integer.
+            if( size == 0 ) size = 'p';
+        case 'x':
+        case 'X':
+            outOp->base = 16;
+            break;
+
+        case 'o':   // %o: Octal integer.
+            outOp->base = 8;
+            break;
+
+        case 'i':   // %i: Integer using an optional prefix to determine the base (e.g. 10, 0xA, 012, 0b1010 for decimal 10).
+            outOp->base = 0;
+            break;
+
+        case 'b':   // %b: Binary integer.
+            outOp->base = 2;
+            break;
+
+        case 'c':   // %c: 1 or more characters.
+            if( size != 0 ) return( -1 );
+            outOp->type = kScanOp_Chars;
+            goto done;
+
+        case 's':   // %s: string of non-whitespace characters with a null terminator.
+            if( size != 0 ) return( -1 );
+            outOp->type = kScanOp_String;
+            goto done;
+
+        case '[':   // %[: Match a scanset (set between brackets or the compliment set if it starts with ^).
+            if( size != 0 ) return( -1 );
+            outOp->type = kScanOp_Set;
+            if( *fmt == '^' )           // A scanlist starting with ^ matches all characters not in the scanlist.
+            {
+                outOp->flags |= kScanFlagNotSet;
                 ++fmt;
-                break;
+            }
+            outOp->str = (const char *) fmt;
+            if( *fmt == ']' ) ++fmt;    // A scanlist (after a potential ^) starting with ] includes ] in the set.
+            while( ( *fmt != '\0' ) && ( *fmt != ']' ) ) ++fmt;
+            if( *fmt == '\0' ) return( -1 );
+            outOp->len = (uint16_t)( fmt - (const unsigned char *) outOp->str );
+            ++fmt;
+            goto done;
 
-            default:
-                sizeModifier = 0;
-                break;
-        }
-        if( *fmt == '\0' ) break;
+        case '%':   // %%: Match a literal % character.
+        case 'n':   // %n: Return the number of characters read so far.
+            if( ( size != 0 ) || ( width != INT_MAX ) || ( outOp->flags & kScanFlagSuppress ) ) return( -1 );
+            outOp->type = ( fmt[ -1 ] == '%' ) ? kScanOp_Percent : kScanOp_Count;
+            goto done;
 
-        // Conversions
+        default:    // Unknown conversion.
+            return( -1 );
+    }
 
-        switch( *fmt++ )
-        {
-            case 'd':   // %d: Signed decimal integer.
-                base = 10;
-                break;
+    // Number conversion: record how many bytes the result is stored in.
 
-            case 'u':   // %u: Unsigned decimal integer.
-                base = 10;
-                break;
+    switch( size )
+    {
+        case   0: outOp->store = sizeof( int );       break;
+        case 'l': outOp->store = sizeof( long );      break;
+        case 'H': outOp->store = sizeof( char );      break;
+        case 'h': outOp->store = sizeof( short );     break;
+        case 'L': outOp->store = sizeof( int64_t );   break;
+        case 'j': outOp->store = sizeof( intmax_t );  break;
+        case 'z': outOp->store = sizeof( size_t );    break;
+        case 't': outOp->store = sizeof( ptrdiff_t ); break;
+        case 'p': outOp->store = sizeof( void * );    break;
+        default:  return( -1 );
+    }
+    outOp->size = (uint8_t) size;
 
-            case 'p':   // %x/%X/%p: Hexidecimal integer.
-                if( sizeModifier == 0 ) sizeModifier = 'p';
-            case 'x':
-            case 'X':
-                base = 16;
-                break;
+done:
+    *ioFmt = fmt;
+    return( 1 );
+}
 
-            case 'o':   // %o: Octal integer.
-                base = 8;
-                break;
+//===========================================================================================================================
+//  _ScanRun
+//
+//  Runs a compiled op list against the input, or parses inFormat and runs each op as soon as it is parsed when inOps
+//  is NULL. Returns the number of stored conversions.
+//===========================================================================================================================
 
-            case 'i':   // %i: Integer using an optional prefix to determine the base (e.g. 10, 0xA, 012, 0b1010 for decimal 10).
-                base = 0;
-                break;
+static int _ScanRun( const ScanOp *inOps, int inCount, const char *inFormat, const void *inString, size_t inSize,
+                     va_list inArgs )
+{
+    const ScanOp *              op;
+    ScanOp                      parsed;
+    const unsigned char *       fmt;
+    const unsigned char *       start;
+    const unsigned char *       srcEnd;
+    const unsigned char *       end;
+    const unsigned char *       src;
+    const unsigned char *       old;
+    const unsigned char *       set;
+    const unsigned char *       setEnd;
+    const unsigned char **      ptrArg;
+    size_t *                    sizeArg;
+    unsigned char *             s;
+    int *                       i;
+    int                         fieldWidth;
+    int                         suppress;
+    int                         negative;
+    int                         base;
+    unsigned char               c;
+    unsigned int                v;
+    uint32_t                    x32;
+    uint64_t                    x64;
+    void *                      p;
+    size_t                      len;
+    va_list                     args;
+    int                         matched;
 
-            case 'b':   // %b: Binary integer.
-                base = 2;
+    if( inSize == kSizeCString ) inSize = strlen( (const char *) inString );
+    start = (const unsigned char *) inString;
+    srcEnd = start + inSize;
+    src   = start;
+    fmt   = (const unsigned char *) inFormat;
+
+    va_copy( args, inArgs );
+    matched = 0;
+    for( op = inOps; ; ++op )
+    {
+        if( !inOps )
+        {
+            if( _ScanParseOp( &fmt, &parsed ) <= 0 ) break;
+            op = &parsed;
+        }
+        else if( op >= ( inOps + inCount ) )
+        {
+            break;
+        }
+        end        = srcEnd;
+        fieldWidth = op->width;
+        suppress   = ( op->flags & kScanFlagSuppress ) != 0;
+        if( op->flags & kScanFlagArgWidth )
+        {
+            fieldWidth = va_arg( args, int );
+            if( fieldWidth < 0 ) goto stop;
+        }
+
+        switch( op->type )
+        {
+            case kScanOp_Space:
+                while( ( src < end ) && IS_SPACE( *src ) ) ++src;
                 break;
 
-            case 'c':   // %c: 1 or more characters.
+            case kScanOp_Literal:
+                if( (size_t)( end - src ) < op->len ) goto stop;
+                if( memcmp( src, op->str, op->len ) != 0 ) goto stop;
+                src += op->len;
+                break;
 
-                if( sizeModifier != 0 ) goto exit;
-                if( storePtr )
+            case kScanOp_Chars:
+                if( op->flags & kScanFlagStorePtr )
                 {
                     len = (size_t)( end - src );
                     if( len > (size_t) fieldWidth )
                     {
                         len = (size_t) fieldWidth;
                     }
-                    if( suppress ) { src += len; continue; }
+                    if( suppress ) { src += len; break; }
 
-                    ptrArg = va_arg( inArgs, const unsigned char ** );
+                    ptrArg = va_arg( args, const unsigned char ** );
                     if( ptrArg ) *ptrArg = src;
 
-                    sizeArg = va_arg( inArgs, size_t * );
+                    sizeArg = va_arg( args, size_t * );
                     if( sizeArg ) *sizeArg = len;
 
                     src += len;
@@ -611,253 +1017,283 @@ int VSNScanF( const void *inString, size_t inSize, const char *inFormat, va_list
                 else
                 {
                     if( fieldWidth == INT_MAX )         fieldWidth = 1;
-                    if( ( end - src ) < fieldWidth )    goto exit;
-                    if( suppress )                      { src += fieldWidth; continue; }
+                    if( ( end - src ) < fieldWidth )    goto stop;
+                    if( suppress )                      { src += fieldWidth; break; }
 
-                    s = va_arg( inArgs, unsigned char * );
-                    if( !s ) goto exit;
+                    s = va_arg( args, unsigned char * );
+                    if( !s ) goto stop;
 
-                    while( fieldWidth-- > 0 ) *s++ = *src++;
+                    memcpy( s, src, (size_t) fieldWidth );
+                    src += fieldWidth;
                 }
                 ++matched;
-                continue;
-
-            case 's':   // %s: string of non-whitespace characters with a null terminator.
+                break;
 
-                if( sizeModifier != 0 ) goto exit;
+            case kScanOp_String:
 
                 // Skip leading white space first since fieldWidth does not include leading whitespace.
 
-                while( ( src < end ) && isspace( *src ) ) ++src;
-                if( !alt && ( ( src >= end ) || ( *src == '\0' ) ) ) goto exit;
+                while( ( src < end ) && IS_SPACE( *src ) ) ++src;
+                if( !( op->flags & kScanFlagAlt ) && ( ( src >= end ) || ( *src == '\0' ) ) ) goto stop;
+
+                // Find the end of the string: a null terminator, whitespace, or the max fieldWidth.
 
-                // Copy the string until a null terminator, whitespace, or the max fieldWidth is hit.
+                old = src;
+                if( (size_t)( end - src ) > (size_t) fieldWidth ) end = src + fieldWidth;
+                while( ( src < end ) && ( *src != '\0' ) && !IS_SPACE( *src ) ) ++src;
+                if( suppress ) break;
 
-                if( suppress )
+                if( op->flags & kScanFlagStorePtr )
                 {
-                    while( ( src < end ) && ( *src != '\0' ) && !isspace( *src ) && ( fieldWidth-- > 0 ) ) ++src;
+                    ptrArg = va_arg( args, const unsigned char ** );
+                    if( ptrArg ) *ptrArg = old;
+
+                    sizeArg = va_arg( args, size_t * );
+                    if( sizeArg ) *sizeArg = (size_t)( src - old );
                 }
-                else if( storePtr )
+                else
                 {
-                    old = src;
-                    while( ( src < end ) && ( *src != '\0' ) && !isspace( *src ) && ( fieldWidth-- > 0 ) ) ++src;
+                    s = va_arg( args, unsigned char * );
+                    if( !s ) goto stop;
+
+                    memcpy( s, old, (size_t)( src - old ) );
+                    s[ src - old ] = '\0';
+                }
+                ++matched;
+                break;
+
+            case kScanOp_Set:
 
-                    ptrArg = va_arg( inArgs, const unsigned char ** );
+                // Parse until a mismatch, null terminator, or the max fieldWidth is hit.
+
+                setEnd = (const unsigned char *) op->str + op->len;
+                old = src;
+                while( ( src < end ) && ( *src != '\0' ) && ( fieldWidth-- > 0 ) )
+                {
+                    c = *src;
+                    for( set = (const unsigned char *) op->str; ( set < setEnd ) && ( *set != c ); ++set ) {}
+                    if( ( set < setEnd ) == ( ( op->flags & kScanFlagNotSet ) != 0 ) ) break;
+                    ++src;
+                }
+                if( ( old == src ) && !( op->flags & kScanFlagAlt ) ) goto stop;
+                if( suppress ) break;
+
+                if( op->flags & kScanFlagStorePtr )
+                {
+                    ptrArg = va_arg( args, const unsigned char ** );
                     if( ptrArg ) *ptrArg = old;
 
-                    sizeArg = va_arg( inArgs, size_t * );
+                    sizeArg = va_arg( args, size_t * );
                     if( sizeArg ) *sizeArg = (size_t)( src - old );
-
-                    ++matched;
                 }
                 else
                 {
-                    s = va_arg( inArgs, unsigned char * );
-                    if( !s ) goto exit;
+                    s = va_arg( args, unsigned char * );
+                    if( !s ) goto stop;
 
-                    while( ( src < end ) && ( *src != '\0' ) && !isspace( *src ) && ( fieldWidth-- > 0 ) ) *s++ = *src++;
-                    *s = '\0';
-
-                    ++matched;
+                    memcpy( s, old, (size_t)( src - old ) );
+                    s[ src - old ] = '\0';
                 }
-                continue;
+                ++matched;
+                break;
+
+            case kScanOp_Percent:
+                if( src >= end )     goto stop;
+                if( *src++ != '%' )  goto stop;
+                break;
 
-            case '[':   // %[: Match a scanset (set between brackets or the compliment set if it starts with ^).
+            case kScanOp_Count:
+                i = va_arg( args, int * );
+                if( !i ) goto stop;
 
-                if( sizeModifier != 0 ) goto exit;
+                *i = (int)( src - start );
+                break;
 
-                notSet = ( *fmt == '^' );   // A scanlist starting with ^ matches all characters not in the scanlist.
-                if( notSet ) ++fmt;
-                setStart = fmt;
-                if( *fmt == ']' ) ++fmt;    // A scanlist (after a potential ^) starting with ] includes ] in the set.
+            case kScanOp_Int:
 
-                // Find the end of the scanlist.
+                // Number conversion. Skip leading white space since number conversions ignore leading white space.
 
-                while( ( *fmt != '\0' ) && ( *fmt != ']' ) ) ++fmt;
-                if( *fmt == '\0' ) goto exit;
-                setEnd = fmt++;
+                while( ( src < end ) && IS_SPACE( *src ) ) ++src;
 
-                // Parse until a mismatch, null terminator, or the max fieldWidth is hit.
+                // Handle +/- prefix for negative/positive (even for unsigned numbers).
 
-                old = src;
-                if( notSet )
+                negative = 0;
+                if( ( ( end - src ) > 1 ) && ( fieldWidth > 0 ) )
                 {
-                    while( ( src < end ) && ( *src != '\0' ) && ( fieldWidth-- > 0 ) )
+                    if( src[ 0 ] == '-' )
                     {
-                        c = *src;
-                        for( set = setStart; ( set < setEnd ) && ( *set != c ); ++set ) {}
-                        if( set < setEnd ) break;
+                        negative = 1;
                         ++src;
+                        --fieldWidth;
                     }
-                }
-                else
-                {
-                    while( ( src < end ) && ( *src != '\0' ) && ( fieldWidth-- > 0 ) )
+                    else if( src[ 0 ] == '+' )
                     {
-                        c = *src;
-                        for( set = setStart; ( set < setEnd ) && ( *set != c ); ++set ) {}
-                        if( set >= setEnd ) break;
                         ++src;
+                        --fieldWidth;
                     }
                 }
-                if( ( old == src ) && !alt ) goto exit;
-                if( !suppress )
+
+                // Detect the base for base 0 and skip valid prefixes.
+
+                old  = src;
+                base = op->base;
+                if( base == 0 )
                 {
-                    if( storePtr )
+                    if( ( ( end - src ) > 2 ) && ( fieldWidth >= 2 ) &&
+                        ( src[ 0 ] == '0' ) && ( tolower( src[ 1 ] ) == 'x' ) && isxdigit( src[ 2 ] ) )
                     {
-                        ptrArg = va_arg( inArgs, const unsigned char ** );
-                        if( ptrArg ) *ptrArg = old;
-
-                        sizeArg = va_arg( inArgs, size_t * );
-                        if( sizeArg ) *sizeArg = (size_t)( src - old );
+                        base         = 16;
+                        src         +=  2;
+                        fieldWidth  -=  2;
+                    }
+                    else if( ( ( end - src ) > 2 ) && ( fieldWidth >= 2 ) &&
+                             ( src[ 0 ] == '0' ) && ( tolower( src[ 1 ] ) == 'b' ) &&
+                             ( ( src[ 2 ] == '0' ) || ( src[ 2 ] == '1' ) ) )
+                    {
+                        base         = 2;
+                        src         += 2;
+                        fieldWidth  -= 2;
+                    }
+                    else if( ( ( end - src ) > 1 ) && ( fieldWidth >= 1 ) &&
+                             ( src[ 0 ] == '0' ) && ( src[ 1 ] >= '0' ) && ( src[ 1 ] <= '7' ) )
+                    {
+                        base         = 8;
+                        src         += 1;
+                        fieldWidth  -= 1;
                     }
                     else
                     {
-                        s = va_arg( inArgs, unsigned char * );
-                        if( !s ) goto exit;
-
-                        while( old < src ) *s++ = *old++;
-                        *s = '\0';
+                        base = 10;
                     }
-                    ++matched;
                 }
-                continue;
+                else if( ( base == 16 ) && ( ( end - src ) >= 2 ) && ( fieldWidth >= 2 ) &&
+                         ( src[ 0 ] == '0' ) && ( tolower( src[ 1 ] ) == 'x' ) )
+                {
+                    src         += 2;
+                    fieldWidth  -= 2;
+                }
+                else if( ( base == 2 ) && ( ( end - src ) >= 2 ) && ( fieldWidth >= 2 ) &&
+                         ( src[ 0 ] == '0' ) && ( tolower( src[ 1 ] ) == 'b' ) )
+                {
+                    src         += 2;
+                    fieldWidth  -= 2;
+                }
 
-            case '%':   // %%: Match a literal % character.
+                // Convert the string to a number. Results stored in 32 bits or less are accumulated in 32 bits, which
+                // gives the same low bits without 64-bit multiplies on the MCU.
 
-                if( sizeModifier != 0 )     goto exit;
-                if( fieldWidth != INT_MAX ) goto exit;
-                if( suppress )              goto exit;
-                if( src >= end )            goto exit;
-                if( *src++ != '%' )         goto exit;
-                continue;
+                if( (size_t)( end - src ) > (size_t) fieldWidth ) end = src + fieldWidth;
+                x32 = 0;
+                x64 = 0;
+                while( src < end )
+                {
+                    c = *src;
+                    v = (unsigned int)( c - '0' );
+                    if( v > 9 )
+                    {
+                        v = (unsigned int)( ( c | 0x20 ) - 'a' );
+                        if( v > 5 ) break;
+                        v += 10;
+                    }
+                    if( v >= (unsigned int) base ) break;
 
-            case 'n':   // %n: Return the number of characters read so far.
+                    if( op->store > 4 ) x64 = ( x64 * base ) + v;
+                    else                  x32 = ( x32 * base ) + v;
+                    ++src;
+                }
+                if( src == old ) goto stop;
+                if( suppress )   break;
+                if( op->store <= 4 ) x64 = x32;
+                if( negative )   x64 = (uint64_t) -(int64_t) x64;
 
-                if( sizeModifier != 0 )     goto exit;
-                if( fieldWidth != INT_MAX ) goto exit;
-                if( suppress )              goto exit;
+                // Store the result.
 
-                i = va_arg( inArgs, int * );
-                if( !i ) goto exit;
+                p = va_arg( args, void * );
+                if( !p ) goto stop;
 
-                *i = (int)( src - ( (const unsigned char *) inString ) );
-                continue;
+                switch( op->size )
+                {
+                    case   0: *( (int       *) p ) = (int)                  x64; break;
+                    case 'l': *( (long      *) p ) = (long)                 x64; break;
+                    case 'H': *( (char      *) p ) = (char)                 x64; break;
+                    case 'h': *( (short     *) p ) = (short)                x64; break;
+                    case 'L': *( (int64_t   *) p ) = (int64_t)              x64; break;
+                    case 'j': *( (intmax_t  *) p ) = (intmax_t)             x64; break;
+                    case 'z': *( (size_t    *) p ) = (size_t)               x64; break;
+                    case 't': *( (ptrdiff_t *) p ) = (ptrdiff_t)            x64; break;
+                    case 'p': *( (void     **) p ) = (void *)( (uintptr_t)  x64 ); break;
+                    default:  goto stop;
+                }
+                ++matched;
+                break;
 
-            default:    // Unknown conversion.
-                goto exit;
+            default:
+                goto stop;
         }
+    }
 
-        // Number conversion. Skip leading white space since number conversions ignore leading white space.
+stop:
+    va_end( args );
+    return( matched );
+}
 
-        while( ( src < end ) && isspace( *src ) ) ++src;
+//===========================================================================================================================
+//  ScanFormatCompile
+//===========================================================================================================================
 
-        // Handle +/- prefix for negative/positive (even for unsigned numbers).
+OSStatus ScanFormatCompile( ScanFormat *outFormat, const char *inFormat )
+{
+    OSStatus                    err;
+    const unsigned char *       fmt;
+    ScanOp                      op;
+    int                         r;
 
-        negative = 0;
-        if( ( ( end - src ) > 1 ) && ( fieldWidth > 0 ) )
-        {
-            if( src[ 0 ] == '-' )
-            {
-                negative = 1;
-                ++src;
-                --fieldWidth;
-            }
-            else if( src[ 0 ] == '+' )
-            {
-                ++src;
-                --fieldWidth;
-            }
-        }
+    outFormat->format = inFormat;
+    outFormat->count  = 0;
+    fmt = (const unsigned char *) inFormat;
+    while( ( r = _ScanParseOp( &fmt, &op ) ) > 0 )
+    {
+        require_action( outFormat->count < kScanFormatMaxOps, exit, err = kSizeErr );
+        outFormat->ops[ outFormat->count++ ] = op;
+    }
+    require_action( r == 0, exit, err = kFormatErr );
+    err = kNoErr;
 
-        // Detect the base for base 0 and skip valid prefixes.
+exit:
+    return err;
+}
 
-        old = src;
-        if( base == 0 )
-        {
-            if( ( ( end - src ) > 2 ) && ( fieldWidth >= 2 ) &&
-                ( src[ 0 ] == '0' ) && ( tolower( src[ 1 ] ) == 'x' ) && isxdigit( src[ 2 ] ) )
-            {
-                base         = 16;
-                src         +=  2;
-                fieldWidth  -=  2;
-            }
-            else if( ( ( end - src ) > 2 ) && ( fieldWidth >= 2 ) &&
-                     ( src[ 0 ] == '0' ) && ( tolower( src[ 1 ] ) == 'b' ) &&
-                     ( ( src[ 2 ] == '0' ) || ( src[ 2 ] == '1' ) ) )
-            {
-                base         = 2;
-                src         += 2;
-                fieldWidth  -= 2;
-            }
-            else if( ( ( end - src ) > 1 ) && ( fieldWidth >= 1 ) &&
-                     ( src[ 0 ] == '0' ) && ( src[ 1 ] >= '0' ) && ( src[ 1 ] <= '7' ) )
-            {
-                base         = 8;
-                src         += 1;
-                fieldWidth  -= 1;
-            }
-            else
-            {
-                base = 10;
-            }
-        }
-        else if( ( base == 16 ) && ( ( end - src ) >= 2 ) && ( fieldWidth >= 2 ) &&
-                 ( src[ 0 ] == '0' ) && ( tolower( src[ 1 ] ) == 'x' ) )
-        {
-            src         += 2;
-            fieldWidth  -= 2;
-        }
-        else if( ( base == 2 ) && ( ( end - src ) >= 2 ) && ( fieldWidth >= 2 ) &&
-                 ( src[ 0 ] == '0' ) && ( tolower( src[ 1 ] ) == 'b' ) )
-        {
-            src         += 2;
-            fieldWidth  -= 2;
-        }
+//===========================================================================================================================
+//  ScanFormatApply
+//===========================================================================================================================
 
-        // Convert the string to a number.
+int ScanFormatApplyV( const ScanFormat *inFormat, const void *inString, size_t inSize, va_list inArgs )
+{
+    return( _ScanRun( inFormat->ops, inFormat->count, NULL, inString, inSize, inArgs ) );
+}
 
-        x = 0;
-        while( ( src < end ) && ( fieldWidth-- > 0 ) )
-        {
-            c = *src;
-            if(      isdigit(  c ) ) v = c - '0';
-            else if( isxdigit( c ) ) v = 10 + ( tolower( c ) - 'a' );
-            else break;
-            if( v >= base ) break;
-
-            x = ( x * base ) + v;
-            ++src;
-        }
-        if( src == old ) goto exit;
-        if( suppress )   continue;
-        if( negative )   x = -x;
+int ScanFormatApply( const ScanFormat *inFormat, const void *inString, size_t inSize, ... )
+{
+    int             n;
+    va_list         args;
 
-        // Store the result.
+    va_start( args, inSize );
+    n = ScanFormatApplyV( inFormat, inString, inSize, args );
+    va_end( args );
+    return( n );
+}
 
-        p = va_arg( inArgs, void * );
-        if( !p ) goto exit;
+//===========================================================================================================================
+//  VSNScanF - va_list version of SNScanF.
+//===========================================================================================================================
 
-        switch( sizeModifier )
-        {
-            case   0: *( (int       *) p ) = (int)                  x; break;
-            case 'l': *( (long      *) p ) = (long)                 x; break;
-            case 'H': *( (char      *) p ) = (char)                 x; break;
-            case 'h': *( (short     *) p ) = (short)                x; break;
-            case 'L': *( (int64_t   *) p ) =                        x; break;
-            case 'j': *( (intmax_t  *) p ) = (intmax_t)             x; break;
-            case 'z': *( (size_t    *) p ) = (size_t)               x; break;
-            case 't': *( (ptrdiff_t *) p ) = (ptrdiff_t)            x; break;
-            case 'p': *( (void     **) p ) = (void *)( (uintptr_t)  x ); break;
-
-            default:    // Unknown size modifier.
-                goto exit;
-        }
-        ++matched;
-    }
+int VSNScanF( const void *inString, size_t inSize, const char *inFormat, va_list inArgs )
+{
+    const ScanFormat *          builtin;
 
-exit:
-    return( matched );
+    builtin = _ScanFindBuiltin( inFormat );
+    if( builtin ) return( _ScanRun( builtin->ops, builtin->count, NULL, inString, inSize, inArgs ) );
+    return( _ScanRun( NULL, 0, inFormat, inString, inSize, inArgs ) );
 }
 
 //===========================================================================================================================
@@ -886,62 +1322,154 @@ int strnicmp_suffix( const void *inStr, size_t inMaxLen, const char *inSuffix )
 //===========================================================================================================================
 //  strnstr_suffix
 //
-//  Like the ANSI C strstr routine, but performs a case-insensitive compare.
+//  Like the ANSI C strstr routine, but performs a case-insensitive compare. Candidates are found by their first
+//  character and compared in place, nothing is copied.
 //===========================================================================================================================
 
 char * strnstr_suffix( const char *inStr, size_t inMaxLen, const char *inSuffix)
 {
     size_t              stringLen;
     size_t              suffixLen;
-    char *              instr_tmp;
-    char *              inSuffix_tmp;
     size_t              i;
-    char *              ret;
+    int                 first;
 
     suffixLen = strlen( inSuffix );
     stringLen = strnlen( inStr, inMaxLen );
-    instr_tmp = calloc(stringLen+1, 1);
-    inSuffix_tmp = calloc(suffixLen+1, 1);
+    if( suffixLen > stringLen ) return( NULL );
+    if( suffixLen == 0 ) return( (char *) inStr );
 
-    for(i=0; i<stringLen; i++)
-        instr_tmp[i] = tolower(inStr[i]);
-    for(i=0; i<suffixLen; i++)
-        inSuffix_tmp[i] = tolower(inSuffix[i]);
+    first = tolower_safe( inSuffix[ 0 ] );
+    for( i = 0; i <= stringLen - suffixLen; i++ )
+    {
+        if( ( tolower_safe( inStr[ i ] ) == first ) && ( strnicmp( inStr + i + 1, inSuffix + 1, suffixLen - 1 ) == 0 ) )
+            return( (char *)( inStr + i ) );
+    }
+    return( NULL );
+}
+
+//===========================================================================================================================
+//  memmem
+//
+//  Finds the first occurrence of find in start. memchr() first jumps to the first candidate byte. Needles of up to 4
+//  bytes are then matched against a rolling word of the haystack, longer ones with the Two-Way algorithm (linear time,
+//  constant space) which also skips a whole window when its last byte does not occur in the needle.
+//===========================================================================================================================
+
+#define BYTESET_TEST( SET, B )  ( (SET)[ (B) >> 5 ] &  ( 1UL << ( (B) & 31 ) ) )
+#define BYTESET_ADD( SET, B )   ( (SET)[ (B) >> 5 ] |= ( 1UL << ( (B) & 31 ) ) )
+
+static void *_memmem_short( const uint8_t *h, size_t k, const uint8_t *n, size_t l )
+{
+    uint32_t            mask;
+    uint32_t            nw;
+    uint32_t            hw;
+    size_t              i;
+
+    mask = ( l == 4 ) ? 0xFFFFFFFFUL : ( ( 1UL << ( 8 * l ) ) - 1 );
+    nw = hw = 0;
+    for( i = 0; i < l; i++ )
+    {
+        nw = ( nw << 8 ) | n[ i ];
+        hw = ( hw << 8 ) | h[ i ];
+    }
+    for( ;; )
+    {
+        if( ( hw & mask ) == nw ) return( (void *)( h + i - l ) );
+        if( i >= k ) return( NULL );
+        hw = ( hw << 8 ) | h[ i++ ];
+    }
+}
+
+static void *_memmem_twoway( const uint8_t *h, const uint8_t *z, const uint8_t *n, size_t l )
+{
+    uint32_t            byteset[ 256 / 32 ];
+    size_t              i, ip, jp, k, p, p0, ms, mem, mem0;
+
+    memset( byteset, 0, sizeof( byteset ) );
+    for( i = 0; i < l; i++ ) BYTESET_ADD( byteset, n[ i ] );
+
+    // Critical factorization: the larger of the maximal suffixes under both byte orders.
+    ip = (size_t) -1; jp = 0; k = p = 1;
+    while( jp + k < l )
+    {
+        if( n[ ip + k ] == n[ jp + k ] )
+        {
+            if( k == p ) { jp += p; k = 1; }
+            else ++k;
+        }
+        else if( n[ ip + k ] > n[ jp + k ] ) { jp += k; k = 1; p = jp - ip; }
+        else { ip = jp++; k = p = 1; }
+    }
+    ms = ip;
+    p0 = p;
+
+    ip = (size_t) -1; jp = 0; k = p = 1;
+    while( jp + k < l )
+    {
+        if( n[ ip + k ] == n[ jp + k ] )
+        {
+            if( k == p ) { jp += p; k = 1; }
+            else ++k;
+        }
+        else if( n[ ip + k ] < n[ jp + k ] ) { jp += k; k = 1; p = jp - ip; }
+        else { ip = jp++; k = p = 1; }
+    }
+    if( ip + 1 > ms + 1 ) ms = ip;
+    else                  p = p0;
 
-    if( suffixLen <= stringLen ){
-        ret = strstr( instr_tmp, inSuffix_tmp );
-        if(ret != NULL)
-            ret = (char *)(inStr+(ret-instr_tmp));
+    // A needle without period p shifts by the larger half and never remembers a matched prefix.
+    if( memcmp( n, n + p, ms + 1 ) != 0 )
+    {
+        mem0 = 0;
+        p = Max( ms, l - ms - 1 ) + 1;
     }
     else
-        ret = NULL;
+    {
+        mem0 = l - p;
+    }
+    mem = 0;
 
-    free(instr_tmp);
-    free(inSuffix_tmp);
+    for( ;; )
+    {
+        if( (size_t)( z - h ) < l ) return( NULL );
 
-    return ret;
-}
+        if( !BYTESET_TEST( byteset, h[ l - 1 ] ) )
+        {
+            h  += l;
+            mem = 0;
+            continue;
+        }
 
+        // Right half, then left half of the factorization.
+        for( k = Max( ms + 1, mem ); ( k < l ) && ( n[ k ] == h[ k ] ); k++ ) {}
+        if( k < l )
+        {
+            h  += k - ms;
+            mem = 0;
+            continue;
+        }
+        for( k = ms + 1; ( k > mem ) && ( n[ k - 1 ] == h[ k - 1 ] ); k-- ) {}
+        if( k <= mem ) return( (void *) h );
+        h  += p;
+        mem = mem0;
+    }
+}
 
 void *memmem(void *start, unsigned int s_len, void *find, unsigned int f_len)
 {
-    char                *p, *q;
-    unsigned int        len;
-
-    p = start, q = find;
-    len = 0;
-    while((p - (char *)start + f_len) <= s_len){
-        while(*p++ == *q++){
-            len++;
-            if(len == f_len)
-                return(p - f_len);
-        };
-        q = find;
-        len = 0;
-    };
-
-    return(NULL);
-}
+    const uint8_t *     h;
+    const uint8_t *     n;
 
+    h = (const uint8_t *) start;
+    n = (const uint8_t *) find;
+    if( f_len == 0 )     return( start );
+    if( s_len < f_len )  return( NULL );
 
+    h = (const uint8_t *) memchr( h, n[ 0 ], s_len );
+    if( !h || ( f_len == 1 ) ) return( (void *) h );
+    s_len -= (unsigned int)( h - (const uint8_t *) start );
+    if( s_len < f_len )  return( NULL );
 
+    if( f_len <= 4 ) return( _memmem_short( h, s_len, n, f_len ) );
+    return( _memmem_twoway( h, h + s_len, n, f_len ) );
+}
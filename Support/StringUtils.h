@@ -88,6 +88,25 @@ char* DataToHexStringWithSpaces( const uint8_t *inBuf, size_t inBufLen );
 
 char* DataToHexStringWithColons( const uint8_t *inBuf, size_t inBufLen );
 
+/* Table driven codecs that write into a caller buffer, nothing is allocated.
+*  HexEncode writes 2 digits per byte, inSeparator between bytes when it is not 0, and a null terminator:
+*  2*inLen+1 bytes without a separator, 3*inLen with one. HexDecode takes either case and an optional ':', '-'
+*  or ' ' between bytes. Base64Encode writes kBase64EncodedSize(inLen)+1 bytes including the null terminator,
+*  Base64Decode skips white space and accepts input with or without '=' padding.
+*  The encoders return the text length, the decoders kMalformedErr on bad input and kNoSpaceErr when inMaxLen
+*  is too small; outLen gets the number of bytes decoded either way.
+*/
+#define kBase64EncodedSize( LEN )     ( ( ( ( LEN ) + 2 ) / 3 ) * 4 )
+#define kBase64DecodedMaxSize( LEN )  ( ( ( LEN ) / 4 ) * 3 + 2 )
+
+size_t HexEncode( const void *inData, size_t inLen, char inSeparator, char *outText );
+
+OSStatus HexDecode( const char *inText, size_t inTextLen, void *outData, size_t inMaxLen, size_t *outLen );
+
+size_t Base64Encode( const void *inData, size_t inLen, char *outText );
+
+OSStatus Base64Decode( const char *inText, size_t inTextLen, void *outData, size_t inMaxLen, size_t *outLen );
+
 // ==== STRING COMPARE UTILS ====
 int strnicmp_suffix( const void *inStr, size_t inMaxLen, const char *inSuffix );
 
@@ -97,6 +116,69 @@ int strnicmpx( const void *inS1, size_t inN, const char *inS2 );
 
 char * strnstr_suffix( const char *inStr, size_t inMaxLen, const char *inSuffix);
 
+// ==== FORMAT SCANNER ====
+/* VSNScanF parses its format on every call. A format used over and over can be parsed once into a ScanFormat with
+*  ScanFormatCompile, or built at compile time from the SCAN_OP_* initializers, and applied with ScanFormatApply,
+*  which returns the same as SNScanF with that format. "%d", "%u", "%x", "%llu", "%llx" and "%s" come pre-built and
+*  VSNScanF uses them directly for these formats.
+*/
+enum
+{
+    kScanOp_Space,      //! 1 or more white space, matches 0 or more.
+    kScanOp_Literal,    //! Characters that must match exactly.
+    kScanOp_Int,        //! %d %u %x %X %o %i %b %p
+    kScanOp_Chars,      //! %c
+    kScanOp_String,     //! %s
+    kScanOp_Set,        //! %[
+    kScanOp_Percent,    //! %%
+    kScanOp_Count       //! %n
+};
+
+#define kScanFlagSuppress   0x01    //! '*': match but do not store.
+#define kScanFlagAlt        0x02    //! '#': allow an empty match.
+#define kScanFlagStorePtr   0x04    //! '&': store a pointer and a length instead of a copy.
+#define kScanFlagArgWidth   0x08    //! '.': field width is taken from the arguments.
+#define kScanFlagNotSet     0x10    //! '[^': the scanset is complemented.
+
+typedef struct
+{
+    uint8_t             type;       //! kScanOp_*.
+    uint8_t             flags;      //! kScanFlag*.
+    uint8_t             size;       //! Size modifier of a number: 0, 'H', 'h', 'l', 'L', 'j', 'z', 't' or 'p'.
+    uint8_t             store;      //! Number of bytes a number is stored in.
+    uint8_t             base;       //! Number base, 0 to detect it from a prefix.
+    int                 width;      //! Field width, INT_MAX for none.
+    const char *        str;        //! Literal or scanset characters, inside the format string.
+    uint16_t            len;        //! Number of literal or scanset characters.
+} ScanOp;
+
+#define kScanFormatMaxOps   8
+
+typedef struct
+{
+    const char *        format;     //! Source format, it must outlive the compiled form.
+    uint8_t             count;      //! Number of ops.
+    ScanOp              ops[ kScanFormatMaxOps ];
+} ScanFormat;
+
+#define SCAN_OP_SPACE()                     { kScanOp_Space,   0, 0, 0, 0, INT_MAX, NULL, 0 }
+#define SCAN_OP_LITERAL( STR )              { kScanOp_Literal, 0, 0, 0, 0, INT_MAX, ( STR ), sizeof_string( STR ) }
+#define SCAN_OP_INT( BASE, SIZE, STORE )    { kScanOp_Int,     0, ( SIZE ), ( STORE ), ( BASE ), INT_MAX, NULL, 0 }
+#define SCAN_OP_STRING()                    { kScanOp_String,  0, 0, 0, 0, INT_MAX, NULL, 0 }
+
+extern const ScanFormat kScanFormat_d;
+extern const ScanFormat kScanFormat_u;
+extern const ScanFormat kScanFormat_x;
+extern const ScanFormat kScanFormat_llu;
+extern const ScanFormat kScanFormat_llx;
+extern const ScanFormat kScanFormat_s;
+
+OSStatus ScanFormatCompile( ScanFormat *outFormat, const char *inFormat );
+
+int ScanFormatApply( const ScanFormat *inFormat, const void *inString, size_t inSize, ... );
+
+int ScanFormatApplyV( const ScanFormat *inFormat, const void *inString, size_t inSize, va_list inArgs );
+
 int VSNScanF( const void *inString, size_t inSize, const char *inFormat, va_list inArgs );
 
 void *memmem(void *start, unsigned int s_len, void *find, unsigned int f_len);
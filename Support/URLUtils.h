@@ -52,8 +52,95 @@ typedef struct
 } URLComponents;
 
 
+#define kURLQueryMaxParams      8
+
+typedef struct
+{
+    const char *    keyPtr;
+    size_t          keyLen;
+    const char *    valuePtr;   // NULL when the parameter has no '='.
+    size_t          valueLen;
+    bool            escaped;    // Key or value holds '%' or '+' and has to be decoded.
+    
+} URLQueryParam;
+
+typedef struct
+{
+    int             count;
+    bool            truncated;  // The query had more than kURLQueryMaxParams parameters.
+    URLQueryParam   params[ kURLQueryMaxParams ];
+    
+} URLQueryIndex;
+
+
 int URLParseComponents( const char *inSrc, const char *inEnd, URLComponents *outComponents, const char **outSrc );
 
+//---------------------------------------------------------------------------------------------------------------------------
+/*! @function   URLParseComponentsWithQuery
+    @abstract   Same as URLParseComponents, and indexes the key/value spans of the query in the same pass when outQuery
+                is not NULL. Spans point into inSrc and are not decoded.
+*/
+int URLParseComponentsWithQuery( const char *inSrc, const char *inEnd, URLComponents *outComponents, 
+                                 URLQueryIndex *outQuery, const char **outSrc );
+
+int URLQueryIndexParse( const char *inQueryPtr, size_t inQueryLen, URLQueryIndex *outQuery );
+
+//---------------------------------------------------------------------------------------------------------------------------
+/*! @function   URLQueryFind
+    @abstract   Returns the first parameter whose decoded key equals inKey, or NULL.
+*/
+const URLQueryParam * URLQueryFind( const URLQueryIndex *inQuery, const char *inKey );
+
+//---------------------------------------------------------------------------------------------------------------------------
+/*! @function   URLQueryCopyValue
+    @abstract   Decodes the value of inKey into inBuf and null terminates it. Returns kNotFoundErr if the key is not in the
+                query and kSizeErr if inBuf is too small.
+*/
+int URLQueryCopyValue( const URLQueryIndex *inQuery, const char *inKey, char *inBuf, size_t inBufSize, size_t *outLen );
+
+//---------------------------------------------------------------------------------------------------------------------------
+/*! @function   URLDecode
+    @abstract   Percent-decodes inSrc into inBuf and null terminates it, '+' becomes a space if inPlusIsSpace. A '%' that
+                is not followed by two hex digits is copied as is. Returns kSizeErr if inBuf is too small.
+*/
+int URLDecode( const char *inSrc, size_t inLen, bool inPlusIsSpace, char *inBuf, size_t inBufSize, size_t *outLen );
+
+//---------------------------------------------------------------------------------------------------------------------------
+/*! @group      URLRouter
+    @abstract   Dispatches request paths to routes through a radix tree built once from a route table.
+    @discussion Paths are compared case-insensitively from their first character. A route matches a path equal to its
+                own, and with kURLRouteFlagPrefix also any path continuing below it after a '/'. The longest matching
+                route wins. Node labels point into the route paths, so the table must stay valid while the router is used.
+*/
+
+#define kURLRouteFlagPrefix     ( 1 << 0 )
+
+typedef struct
+{
+    const char *    path;
+    uint32_t        flags;
+    void *          handler;    // Not used by the router, returned with the route.
+    
+} URLRoute;
+
+typedef struct URLRouteNode URLRouteNode;
+
+typedef struct
+{
+    const URLRoute *    routes;
+    int                 count;
+    URLRouteNode *      nodes;
+    int                 nodeCount;
+    
+} URLRouter;
+
+int URLRouterInit( URLRouter *inRouter, const URLRoute *inRoutes, int inCount );
+
+void URLRouterFree( URLRouter *inRouter );
+
+const URLRoute * URLRouterMatch( const URLRouter *inRouter, const char *inPath, size_t inPathLen, 
+                                 const char **outRestPtr, size_t *outRestLen );
+
 void PrintURL( URLComponents *inURL );
 
 #endif // __URLUtils_h__
@@ -15,7 +15,10 @@
 
 #if SUPPORT_LOG_SERVICE
 //======================================================
-struct list_head log_hash[ATC_INDEX_NUM];
+/* Registered commands sorted by log_cmd_key(), looked up by binary search */
+static log_item_t *log_table[ATC_TABLE_SIZE];
+static unsigned int log_keys[ATC_TABLE_SIZE];
+static int log_table_num = 0;
 
 extern void at_wifi_init(void);
 extern void at_fs_init(void);
@@ -54,29 +57,48 @@ extern unsigned int __log_init_begin__;
 extern unsigned int __log_init_end__;
 #endif
 
-#if defined(__GNUC__)
-#define USE_STRSEP
-#endif
-
 //======================================================
-int hash_index(char *str)
+/* First 4 characters packed big-endian, so key order is strcmp order */
+static unsigned int log_cmd_key(const char *cmd, int len)
 {
-    unsigned int seed = 131; // 31 131 1313 13131 131313 etc..
-    unsigned int hash = 0;
-
-    while (*str)
-    {
-        hash = hash * seed + (*str++);
-    }
+	unsigned int key = 0;
+	int i;
 
-    return (hash & 0x7FFFFFFF);	
+	for(i = 0; i < 4; i++)
+		key = (key << 8) | ((i < len) ? (unsigned char)cmd[i] : 0);
+	return key;
 }
 
 void log_add_new_command(log_item_t *new)
 {
-	int index = hash_index(new->log_cmd)%ATC_INDEX_NUM;
-	
-	list_add(&new->node, &log_hash[index]);
+	unsigned int key = log_cmd_key(new->log_cmd, strlen(new->log_cmd));
+	int i, ret;
+
+	/* insertion sort, only runs while modules register their tables at init */
+	for(i = log_table_num; i > 0; i--) {
+		if(log_keys[i-1] != key)
+			ret = (log_keys[i-1] < key) ? -1 : 1;
+		else
+			ret = strcmp(log_table[i-1]->log_cmd, new->log_cmd);
+		if(ret == 0) {
+			//later registration overrides, as the former hash list did
+			log_table[i-1] = new;
+			return;
+		}
+		if(ret < 0)
+			break;
+	}
+
+	if(log_table_num >= ATC_TABLE_SIZE) {
+		printf("\n\r%s: table full, %s dropped", __FUNCTION__, new->log_cmd);
+		return;
+	}
+
+	memmove(&log_table[i+1], &log_table[i], (log_table_num - i) * sizeof(log_table[0]));
+	memmove(&log_keys[i+1], &log_keys[i], (log_table_num - i) * sizeof(log_keys[0]));
+	log_table[i] = new;
+	log_keys[i] = key;
+	log_table_num++;
 }
 void start_log_service(void);
 __weak void log_service_init(void)
@@ -96,8 +118,7 @@ __weak void log_service_init(void)
 #endif
 		
 	
-	for(i=0;i<ATC_INDEX_NUM;i++)
-		INIT_LIST_HEAD(&log_hash[i]);
+	log_table_num = 0;
 	
 	for(i=0;i<(__log_init_end__-__log_init_begin__)/sizeof(log_init_t); i++)
 		log_init_table[i]();
@@ -115,63 +136,118 @@ void log_service_add_table(log_item_t *tbl, int len)
 		log_add_new_command(&tbl[i]);	
 }
 
+/* Look up the command named by the span cmd[0..len), no copy or terminator needed */
+void* log_action_span(const char *cmd, int len)
+{
+	unsigned int key = log_cmd_key(cmd, len);
+	int lo = 0, hi = log_table_num - 1, mid, ret;
+
+	while(lo <= hi) {
+		mid = (lo + hi) >> 1;
+		if(log_keys[mid] < key)
+			lo = mid + 1;
+		else if(log_keys[mid] > key)
+			hi = mid - 1;
+		else {
+			ret = strncmp(log_table[mid]->log_cmd, cmd, len);
+			if(ret == 0 && log_table[mid]->log_cmd[len] != '\0')
+				ret = 1;
+			if(ret == 0)
+				return (void*)log_table[mid]->at_act;
+			if(ret < 0)
+				lo = mid + 1;
+			else
+				hi = mid - 1;
+		}
+	}
+	return NULL;
+}
+
 void* log_action(char *cmd)
 {
-	int search_cnt=0;
-	int index = hash_index(cmd)%ATC_INDEX_NUM;
-	struct list_head *head = &log_hash[index];
-	struct list_head *iterator;
-	log_item_t *item;
-	void *act = NULL;
-	
-	list_for_each(iterator, head) {
-		item = list_entry(iterator, log_item_t, node);
-		search_cnt++;
-		if( strcmp(item->log_cmd, cmd) == 0){
-			//printf("%s match %s, search cnt %d\n\r", cmd, item->log_cmd, search_cnt);
-			act = (void*)item->at_act;
-			break;
+	return log_action_span(cmd, strlen(cmd));
+}
+
+/* Split off the next command of a pipelined line, commands are separated by
+ * LOG_PIPELINE_DELIMITER followed by "AT" so that parameters may still contain it.
+ * Returns the start of the next command, or NULL if cmd is the last one.
+ */
+static char* log_next_command(char *cmd)
+{
+#if CONFIG_LOG_PIPELINE
+	char *p = cmd;
+
+	while((p = strchr(p, LOG_PIPELINE_DELIMITER)) != NULL) {
+		if(p[1] == 'A' && p[2] == 'T') {
+			*p = '\0';
+			return p + 1;
 		}
+		p++;
 	}
-	
-	return act;
+#endif
+	return NULL;
 }
 
-void* log_handler(char *cmd)
+static void* log_handle_one(char *cmd)
 {
-	log_act_t action=NULL;
-	char buf[100] = {0};
-	char *copy=buf;
-	char *token = NULL;
+	log_act_t action = NULL;
 	char *param = NULL;
-	char tok[5] = {0};//'\0'
-#if CONFIG_LOG_HISTORY
-	strcpy(log_history[((log_history_count++)%LOG_HISTORY_LEN)], log_buf);
-#endif
-	strcpy(copy, cmd);
+	char buf[LOG_SERVICE_BUFLEN];
+	int len;
 
-#if defined(USE_STRSEP)
-	token = _strsep(&copy, "=");
-	param = copy;
-#else
-	token = strtok(copy, "=");
-	param = strtok(NULL, NULL);
-#endif
-	if(token && (strlen(token) <= 4))
-		strcpy(tok, token);
-	else{
-		//printf("\n\rAT Cmd format error!\n");
+	/* command is the span before '=' */
+	for(len = 0; cmd[len] != '\0' && cmd[len] != '='; len++) {
+		if(len == 4) {
+			//printf("\n\rAT Cmd format error!\n");
+			return NULL;
+		}
+	}
+	if(len == 0)
 		return NULL;
-	};
-	//printf(" Command %s \n\r ", tok);
-	//printf(" Param %s \n\r", param);
-	action = (log_act_t)log_action(tok);
-        
-	if(action){	
+	action = (log_act_t)log_action_span(cmd, len);
+	if(action){
+		/* actions get a private copy of the parameters, the console reads
+		 * the next line into log_buf while they may still be running */
+		if(cmd[len] == '=') {
+			strncpy(buf, &cmd[len+1], sizeof(buf) - 1);
+			buf[sizeof(buf) - 1] = '\0';
+			param = buf;
+		}
 		action(param);
 	} 
 	return (void*)action;
+}
+
+void* log_handler(char *cmd)
+{
+	void *action = NULL, *done = NULL;
+	char *next;
+	int num = 0;
+#if CONFIG_LOG_HISTORY
+	strcpy(log_history[((log_history_count++)%LOG_HISTORY_LEN)], log_buf);
+#endif
+
+	/* a pipelined line is handled command by command and stops at the first
+	 * unknown one. Only a line of which nothing ran is left to the caller to try
+	 * as a legacy command, otherwise the rest of it is reported here */
+	do {
+		next = log_next_command(cmd);
+		action = log_handle_one(cmd);
+		if(action == NULL) {
+			if(next)
+				next[-1] = LOG_PIPELINE_DELIMITER;
+			break;
+		}
+		done = action;
+		num++;
+		cmd = next;
+	} while(cmd);
 
+	if((action == NULL) && num) {
+		printf("\n\r%d command(s) done, stopped at unknown command '%s'", num, cmd);
+		return done;
+	}
+	return action;
 }
 
 int parse_param(char *buf, char **argv)
@@ -25,7 +25,10 @@ static void* log_##fn __attribute__((section(".data.log_init")))  = (void*)fn;
 #error "not implement"
 #endif
 		
-#define ATC_INDEX_NUM 32
+//maximum number of AT commands that can be registered
+#ifndef ATC_TABLE_SIZE
+#define ATC_TABLE_SIZE 128
+#endif
 
 #ifndef SUPPORT_LOG_SERVICE
 #define SUPPORT_LOG_SERVICE	1
@@ -46,6 +49,17 @@ static void* log_##fn __attribute__((section(".data.log_init")))  = (void*)fn;
 #endif
 #endif //#ifndef CONFIG_LOG_HISTORY
 
+//CONFIG_LOG_PIPELINE: several commands may be sent in one line, separated by
+//                     LOG_PIPELINE_DELIMITER, e.g. "ATW0=ssid;ATW1=password;ATWC".
+//                     Off by default, parameters such as an SSID or password would
+//                     be split wherever they contain the delimiter followed by "AT".
+#ifndef CONFIG_LOG_PIPELINE
+#define CONFIG_LOG_PIPELINE	0
+#endif
+#ifndef LOG_PIPELINE_DELIMITER
+#define LOG_PIPELINE_DELIMITER	';'
+#endif
+
 #ifndef MAX_ARGC
 #define MAX_ARGC 6
 #endif
@@ -92,6 +106,7 @@ typedef struct _at_command_item_{
 }log_item_t;
 
 void log_service_add_table(log_item_t *tbl, int len);
+void* log_action_span(const char *cmd, int len);
 int parse_param(char *buf, char **argv);
 
 #endif
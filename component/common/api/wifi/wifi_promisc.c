@@ -12,8 +12,6 @@
 #include <platform/platform_stdlib.h>
 
 struct eth_frame {
-	struct eth_frame *prev;
-	struct eth_frame *next;
 	unsigned char da[6];
 	unsigned char sa[6];
 	unsigned int len;
@@ -41,12 +39,47 @@ static int inic_frame_cnt = 0;
 extern void inic_c2h_msg(const char *atcmd, char status, char *msg, u16 msg_len);
 #endif
 
+/* Frames sniffed in wlan rx path are stored in a fixed ring instead of being
+ * malloc'ed one by one. wlan rx is the only producer and the promisc thread the
+ * only consumer, so head/tail are each written by one side and need no lock, only
+ * a barrier between the slot accesses and the index store that hands the slot over.
+ * The ring is allocated while promisc mode is on.
+ */
+#if defined(__ICCARM__)
+#include <intrinsics.h>
+#define ETH_RING_BARRIER()	__DMB()
+#elif defined(__GNUC__) && defined(__arm__)
+#define ETH_RING_BARRIER()	__asm volatile ("dmb" ::: "memory")
+#else
+#define ETH_RING_BARRIER()	__sync_synchronize()
+#endif
+
+#define ETH_RING_SIZE		256	//must be power of 2
+#define ETH_RING_MASK		(ETH_RING_SIZE - 1)
+#define ETH_DRAIN_BATCH		16
+#define MAX_SA_STATS_NUM	32	//source addresses tracked per channel in stats mode
+
 struct eth_buffer {
-	struct eth_frame *head;
-	struct eth_frame *tail;
+	struct eth_frame frame[ETH_RING_SIZE];
+	volatile unsigned int head;	//next slot written by rx callback
+	volatile unsigned int tail;	//next slot read by retrieve_frames
+	unsigned int received;
+	unsigned int dropped;		//frames lost because ring was full
 };
 
-static struct eth_buffer eth_buffer;
+struct sa_stats {
+	unsigned char sa[6];
+	unsigned int count;
+	unsigned int bytes;
+	int rssi_sum;
+	signed char rssi_min;
+	signed char rssi_max;
+};
+
+static struct eth_buffer *eth_buffer = NULL;
+static struct sa_stats sa_stats[MAX_SA_STATS_NUM];
+static int sa_stats_num = 0;
+static unsigned int sa_stats_overflow = 0;
 
 #ifdef CONFIG_PROMISC
 #define MAX_PACKET_FILTER_INFO 5
@@ -159,110 +192,212 @@ int promisc_remove_packet_filter(u8 filter_id)
 }
 #endif
 
+static int eth_buffer_alloc(void)
+{
+	eth_buffer = (struct eth_buffer *) pvPortMalloc(sizeof(struct eth_buffer));
+	if(eth_buffer == NULL) {
+		printf("\n\rpromisc: no memory for %d frames", ETH_RING_SIZE);
+		return -1;
+	}
+	eth_buffer->head = 0;
+	eth_buffer->tail = 0;
+	eth_buffer->received = 0;
+	eth_buffer->dropped = 0;
+	return 0;
+}
+
+/* Only after the rx callback is unregistered */
+static void eth_buffer_free(void)
+{
+	if(eth_buffer) {
+		vPortFree(eth_buffer);
+		eth_buffer = NULL;
+	}
+}
+
+/* Reserve the next ring slot, NULL when the consumer is too slow */
+static __inline struct eth_frame* eth_buffer_reserve(void)
+{
+	unsigned int head = eth_buffer->head;
+
+	eth_buffer->received ++;
+	if((head - eth_buffer->tail) >= ETH_RING_SIZE) {
+		eth_buffer->dropped ++;
+		return NULL;
+	}
+	/* the consumer is done with the slot once tail is past it */
+	ETH_RING_BARRIER();
+	return &eth_buffer->frame[head & ETH_RING_MASK];
+}
+
+/* Publish the slot only after it is completely filled */
+static __inline void eth_buffer_commit(void)
+{
+	ETH_RING_BARRIER();
+	eth_buffer->head ++;
+}
+
 /*	Make callback simple to prevent latency to wlan rx when promiscuous mode */
 static void promisc_callback(unsigned char *buf, unsigned int len, void* userdata)
 {
-	struct eth_frame *frame = (struct eth_frame *) pvPortMalloc(sizeof(struct eth_frame));
+	struct eth_frame *frame = eth_buffer_reserve();
 	
 	if(frame) {
-		frame->prev = NULL;
-		frame->next = NULL;
 		memcpy(frame->da, buf, 6);
 		memcpy(frame->sa, buf+6, 6);
 		frame->len = len;
+		frame->type = 0;
 		frame->rssi = ((ieee80211_frame_info_t *)userdata)->rssi;
-		taskENTER_CRITICAL();
-
-		if(eth_buffer.tail) {
-			eth_buffer.tail->next = frame;
-			frame->prev = eth_buffer.tail;
-			eth_buffer.tail = frame;
-		}
-		else {
-			eth_buffer.head = frame;
-			eth_buffer.tail = frame;
-		}
-
-		taskEXIT_CRITICAL();
+		eth_buffer_commit();
 	}
 }
 
-struct eth_frame* retrieve_frame(void)
+/* Copy up to num frames out of the ring, return the number retrieved */
+int retrieve_frames(struct eth_frame *frames, int num)
 {
-	struct eth_frame *frame = NULL;
+	unsigned int tail = eth_buffer->tail;
+	int avail = (int) (eth_buffer->head - tail);
+	int i;
+
+	if(avail > num)
+		avail = num;
+	if(avail == 0)
+		return 0;
+	ETH_RING_BARRIER();	//slots up to head are filled
+	for(i = 0; i < avail; i ++)
+		frames[i] = eth_buffer->frame[(tail + i) & ETH_RING_MASK];
+	ETH_RING_BARRIER();	//copies done before the slots are handed back
+	eth_buffer->tail = tail + avail;
+
+	return avail;
+}
 
-	taskENTER_CRITICAL();
+static void sa_stats_reset(void)
+{
+	sa_stats_num = 0;
+	sa_stats_overflow = 0;
+}
 
-	if(eth_buffer.head) {
-		frame = eth_buffer.head;
+static void sa_stats_update(struct eth_frame *frame)
+{
+	int i;
 
-		if(eth_buffer.head->next) {
-			eth_buffer.head = eth_buffer.head->next;
-			eth_buffer.head->prev = NULL;
-		}
-		else {
-			eth_buffer.head = NULL;
-			eth_buffer.tail = NULL;
+	for(i = 0; i < sa_stats_num; i ++) {
+		if(memcmp(sa_stats[i].sa, frame->sa, 6) == 0)
+			break;
+	}
+	if(i == sa_stats_num) {
+		if(sa_stats_num == MAX_SA_STATS_NUM) {
+			sa_stats_overflow ++;
+			return;
 		}
+		memcpy(sa_stats[i].sa, frame->sa, 6);
+		sa_stats[i].count = 0;
+		sa_stats[i].bytes = 0;
+		sa_stats[i].rssi_sum = 0;
+		sa_stats[i].rssi_min = frame->rssi;
+		sa_stats[i].rssi_max = frame->rssi;
+		sa_stats_num ++;
 	}
-
-	taskEXIT_CRITICAL();
-
-	return frame;
+	sa_stats[i].count ++;
+	sa_stats[i].bytes += frame->len;
+	sa_stats[i].rssi_sum += frame->rssi;
+	if(frame->rssi < sa_stats[i].rssi_min)
+		sa_stats[i].rssi_min = frame->rssi;
+	if(frame->rssi > sa_stats[i].rssi_max)
+		sa_stats[i].rssi_max = frame->rssi;
 }
 
-static void promisc_test(int duration, unsigned char len_used)
+static void sa_stats_show(void)
 {
-	int ch;
-	unsigned int start_time;
-	struct eth_frame *frame;
-	eth_buffer.head = NULL;
-	eth_buffer.tail = NULL;
+	int i, j;
+
+	for(i = 0; i < sa_stats_num; i ++) {
+		printf("\n\rSA:");
+		for(j = 0; j < 6; j ++)
+			printf(" %02x", sa_stats[i].sa[j]);
+		printf(", count=%d, bytes=%d, RSSI avg/min/max=%d/%d/%d", sa_stats[i].count, sa_stats[i].bytes,
+			sa_stats[i].rssi_sum / (int) sa_stats[i].count, sa_stats[i].rssi_min, sa_stats[i].rssi_max);
+	}
+	if(sa_stats_overflow)
+		printf("\n\r%d frames from untracked SA", sa_stats_overflow);
+}
 
-	wifi_enter_promisc_mode();
-	wifi_set_promisc(RTW_PROMISC_ENABLE, promisc_callback, len_used);
+static void eth_buffer_show(unsigned int received, unsigned int dropped)
+{
+	printf("\n\rreceived=%d, dropped=%d", eth_buffer->received - received, eth_buffer->dropped - dropped);
+}
 
-	for(ch = 1; ch <= 13; ch ++) {
-		if(wifi_set_channel(ch) == 0)
-			printf("\n\n\rSwitch to channel(%d)", ch);
+static void promisc_show_frame(struct eth_frame *frame, int show_type)
+{
+	int i;
+
+	printf("\n\r");
+	if(show_type)
+		printf("TYPE: 0x%x, ", frame->type);
+	printf("DA:");
+	for(i = 0; i < 6; i ++)
+		printf(" %02x", frame->da[i]);
+	printf(", SA:");
+	for(i = 0; i < 6; i ++)
+		printf(" %02x", frame->sa[i]);
+	printf(", len=%d", frame->len);
+	printf(", RSSI=%d", frame->rssi);
+}
 
-		start_time = xTaskGetTickCount();
+/* Drain the ring on current channel for duration seconds */
+static void promisc_drain(int duration, int show_type, int stats)
+{
+	struct eth_frame frames[ETH_DRAIN_BATCH];
+	unsigned int start_time = xTaskGetTickCount();
+	int i, num;
 
-		while(1) {
-			unsigned int current_time = xTaskGetTickCount();
+	while((xTaskGetTickCount() - start_time) < (duration * configTICK_RATE_HZ)) {
+		num = retrieve_frames(frames, ETH_DRAIN_BATCH);
 
-			if((current_time - start_time) < (duration * configTICK_RATE_HZ)) {
-				frame = retrieve_frame();
+		if(num == 0) {
+			vTaskDelay(1);	//delay 1 tick
+			continue;
+		}
 
-				if(frame) {
-					int i;
-					printf("\n\rDA:");
-					for(i = 0; i < 6; i ++)
-						printf(" %02x", frame->da[i]);
-					printf(", SA:");
-					for(i = 0; i < 6; i ++)
-						printf(" %02x", frame->sa[i]);
-					printf(", len=%d", frame->len);
-					printf(", RSSI=%d", frame->rssi);
+		for(i = 0; i < num; i ++) {
+			if(stats)
+				sa_stats_update(&frames[i]);
+			else
+				promisc_show_frame(&frames[i], show_type);
 #if CONFIG_INIC_CMD_RSP
-					if(inic_frame_tail){
-						if(inic_frame_cnt < MAX_INIC_FRAME_NUM){
-							memcpy(inic_frame_tail->da, frame->da, 6);
-							memcpy(inic_frame_tail->sa, frame->sa, 6);
-							inic_frame_tail->len = frame->len;
-							inic_frame_tail++;
-							inic_frame_cnt++;
-						}
-					}
-#endif	
-					vPortFree((void *) frame);
+			if(inic_frame_tail){
+				if(inic_frame_cnt < MAX_INIC_FRAME_NUM){
+					memcpy(inic_frame_tail->da, frames[i].da, 6);
+					memcpy(inic_frame_tail->sa, frames[i].sa, 6);
+					inic_frame_tail->len = frames[i].len;
+					inic_frame_tail->type = frames[i].type;
+					inic_frame_tail++;
+					inic_frame_cnt++;
 				}
-				else
-					vTaskDelay(1);	//delay 1 tick
 			}
-			else
-				break;	
+#endif
 		}
+	}
+}
+
+static void promisc_test_channels(int duration, int show_type, int stats)
+{
+	unsigned int received, dropped;
+	int ch;
+
+	for(ch = 1; ch <= 13; ch ++) {
+		if(wifi_set_channel(ch) == 0)
+			printf("\n\n\rSwitch to channel(%d)", ch);
+
+		/* counters belong to rx side while promisc is on, only take snapshots here */
+		received = eth_buffer->received;
+		dropped = eth_buffer->dropped;
+		sa_stats_reset();
+		promisc_drain(duration, show_type, stats);
+		if(stats)
+			sa_stats_show();
+		eth_buffer_show(received, dropped);
 #if CONFIG_INIC_CMD_RSP
 		if(inic_frame){
 			inic_c2h_msg("ATWM", RTW_SUCCESS, (char *)inic_frame, sizeof(struct inic_eth_frame)*inic_frame_cnt);
@@ -273,115 +408,53 @@ static void promisc_test(int duration, unsigned char len_used)
 		}
 #endif
 	}
+}
 
-	wifi_set_promisc(RTW_PROMISC_DISABLE, NULL, 0);
+static void promisc_test(int duration, unsigned char len_used, int stats)
+{
+	if(eth_buffer_alloc() < 0)
+		return;
+
+	wifi_enter_promisc_mode();
+	wifi_set_promisc(RTW_PROMISC_ENABLE, promisc_callback, len_used);
+
+	promisc_test_channels(duration, 0, stats);
 
-	while((frame = retrieve_frame()) != NULL)
-		vPortFree((void *) frame);
+	wifi_set_promisc(RTW_PROMISC_DISABLE, NULL, 0);
+	eth_buffer_free();
 }
 
 static void promisc_callback_all(unsigned char *buf, unsigned int len, void* userdata)
 {
-	struct eth_frame *frame = (struct eth_frame *) pvPortMalloc(sizeof(struct eth_frame));
+	struct eth_frame *frame = eth_buffer_reserve();
 	
 	if(frame) {
-		frame->prev = NULL;
-		frame->next = NULL;
 		memcpy(frame->da, buf+4, 6);
 		memcpy(frame->sa, buf+10, 6);
 		frame->len = len;
 		frame->type = *buf;
 		frame->rssi = ((ieee80211_frame_info_t *)userdata)->rssi;
-
-		taskENTER_CRITICAL();
-
-		if(eth_buffer.tail) {
-			eth_buffer.tail->next = frame;
-			frame->prev = eth_buffer.tail;
-			eth_buffer.tail = frame;
-		}
-		else {
-			eth_buffer.head = frame;
-			eth_buffer.tail = frame;
-		}
-
-		taskEXIT_CRITICAL();
+		eth_buffer_commit();
 	}
 }
-static void promisc_test_all(int duration, unsigned char len_used)
+
+static void promisc_test_all(int duration, unsigned char len_used, int stats)
 {
-	int ch;
-	unsigned int start_time;
-	struct eth_frame *frame;
-	eth_buffer.head = NULL;
-	eth_buffer.tail = NULL;
+	if(eth_buffer_alloc() < 0)
+		return;
 
 	wifi_enter_promisc_mode();
 	wifi_set_promisc(RTW_PROMISC_ENABLE_2, promisc_callback_all, len_used);
 
-	for(ch = 1; ch <= 13; ch ++) {
-		if(wifi_set_channel(ch) == 0)
-			printf("\n\n\rSwitch to channel(%d)", ch);
-
-		start_time = xTaskGetTickCount();
-
-		while(1) {
-			unsigned int current_time = xTaskGetTickCount();
-
-			if((current_time - start_time) < (duration * configTICK_RATE_HZ)) {
-				frame = retrieve_frame();
-
-				if(frame) {
-					int i;
-					printf("\n\rTYPE: 0x%x, ", frame->type);
-					printf("DA:");
-					for(i = 0; i < 6; i ++)
-						printf(" %02x", frame->da[i]);
-					printf(", SA:");
-					for(i = 0; i < 6; i ++)
-						printf(" %02x", frame->sa[i]);
-					printf(", len=%d", frame->len);
-					printf(", RSSI=%d", frame->rssi);
-#if CONFIG_INIC_CMD_RSP
-					if(inic_frame_tail){
-						if(inic_frame_cnt < MAX_INIC_FRAME_NUM){
-							memcpy(inic_frame_tail->da, frame->da, 6);
-							memcpy(inic_frame_tail->sa, frame->sa, 6);
-							inic_frame_tail->len = frame->len;
-							inic_frame_tail->type = frame->type;
-							inic_frame_tail++;
-							inic_frame_cnt++;
-						}
-					}
-#endif	
-					vPortFree((void *) frame);
-				}
-				else
-					vTaskDelay(1);	//delay 1 tick
-			}
-			else
-				break;	
-		}
-#if CONFIG_INIC_CMD_RSP
-		if(inic_frame){
-			inic_c2h_msg("ATWM", RTW_SUCCESS, (char *)inic_frame, sizeof(struct inic_eth_frame)*inic_frame_cnt);
-			memset(inic_frame, '\0', sizeof(struct inic_eth_frame)*MAX_INIC_FRAME_NUM);
-				inic_frame_tail = inic_frame;
-				inic_frame_cnt = 0;
-			rtw_msleep_os(10);
-		}
-#endif
-	}
+	promisc_test_channels(duration, 1, stats);
 
 	wifi_set_promisc(RTW_PROMISC_DISABLE, NULL, 0);
-
-	while((frame = retrieve_frame()) != NULL)
-		vPortFree((void *) frame);
+	eth_buffer_free();
 }
 
 void cmd_promisc(int argc, char **argv)
 {
-	int duration;
+	int duration, stats;
 #if CONFIG_INIC_CMD_RSP
 	inic_frame_tail = inic_frame = pvPortMalloc(sizeof(struct inic_eth_frame)*MAX_INIC_FRAME_NUM);
 	if(inic_frame == NULL){
@@ -392,13 +465,16 @@ void cmd_promisc(int argc, char **argv)
 	#ifdef CONFIG_PROMISC
 	wifi_init_packet_filter();
 	#endif
+	stats = ((argc >= 3) && (strcmp(argv[argc - 1], "stats") == 0));
+	if(stats)
+		argc --;
 	if((argc == 2) && ((duration = atoi(argv[1])) > 0))
-		//promisc_test(duration, 0);
-		promisc_test_all(duration, 0);
+		//promisc_test(duration, 0, stats);
+		promisc_test_all(duration, 0, stats);
 	else if((argc == 3) && ((duration = atoi(argv[1])) > 0) && (strcmp(argv[2], "with_len") == 0))
-		promisc_test(duration, 1);
+		promisc_test(duration, 1, stats);
 	else
-		printf("\n\rUsage: %s DURATION_SECONDS [with_len]", argv[0]);
+		printf("\n\rUsage: %s DURATION_SECONDS [with_len] [stats]", argv[0]);
 #if CONFIG_INIC_CMD_RSP
 	if(inic_frame)
 		vPortFree(inic_frame);
@@ -10,14 +10,23 @@
 #include "uvcvideo.h"
 #include "v4l2_driver.h"
 #include "mjpeg/mjpeg.h"
+#include "mjpeg/mjpeg_packetizer.h"
 #include "rtsp/rtsp_api.h"
 #include "sockets.h"
 #include "lwip/netif.h"
+extern struct netif xnetif[];
 
 #include "uvc_intf.h"
 
 #include "section_config.h"
 SDRAM_DATA_SECTION struct rtp_object rtp_payload[VIDEO_MAX_FRAME];
+#if UVC_RTP_ZERO_COPY
+/*uvc buffer behind each rtp_payload, rtp_payload[].data stays owned by rtp_init_payload*/
+static struct uvc_buf_context uvc_frame[VIDEO_MAX_FRAME];
+#define UVC_RTP_FRAME_LEN(payload)      (uvc_frame[(payload)->index].len)
+#else
+#define UVC_RTP_FRAME_LEN(payload)      ((payload)->len)
+#endif
 
 struct rtp_payload_queue payload_queue;
 
@@ -74,8 +83,13 @@ void uvc_entry_handle(void *param)
 			goto exit;
                 }
                 rtp_payload[buf.index].index = buf.index;
+#if UVC_RTP_ZERO_COPY
+                /*rtp task packetizes the frame in place, only hand over the uvc buffer*/
+                uvc_frame[buf.index] = buf;
+#else
                 if(rtp_fill_payload(stream_ctx, &rtp_payload[buf.index], buf.data, buf.len) < 0)
                         goto exit;
+#endif
 
                 /*add rtp_payload into payload queue*/
                 RtlDownMutex(&payload_queue.wait_mutex);
@@ -101,9 +115,13 @@ void uvc_entry_handle(void *param)
                         list_del_init(&payload->rtp_list);
                         RtlUpMutex(&payload_queue.done_mutex);                       
                                                                 
+#if UVC_RTP_ZERO_COPY
+                        buf = uvc_frame[payload->index];
+#else
                         buf.index = payload->index;
                         buf.data = payload->data;
                         buf.len = payload->len;
+#endif
                         
                         ret = uvc_qbuf(stream_ctx, &buf);                   
                         if (ret < 0){
@@ -138,6 +156,65 @@ exit:
     
         
 int uvc_rtp_init(struct rtsp_context *rtsp_ctx);
+
+/*
+ * socket of the rtsp session currently served, rtp packets are interleaved on it in
+ * UNICAST_TCP_MODE. rtsp_tcp_mutex guards the socket number and is never held across a
+ * write. rtsp responses and rtp packets share the socket, each one is written whole under
+ * rtsp_tcp_write_mutex so that one message is not cut by another, and the socket is only
+ * closed under it.
+ */
+static int rtsp_client_socket = -1;
+static _Mutex rtsp_tcp_mutex;
+static _Mutex rtsp_tcp_write_mutex;
+/*rtp channel the client asked for in the Transport header of SETUP*/
+static int rtsp_interleaved_channel = UVC_RTP_INTERLEAVED_CHANNEL;
+
+/*"interleaved=n-m" of a SETUP request, -1 if the request has none*/
+static int uvc_rtsp_interleaved_channel(u8 *request, int len)
+{
+        static const char key[] = "interleaved=";
+        int i, channel;
+
+        for(i = 0; i + (int)sizeof(key) - 1 < len; i++)
+        {
+                if(strncmp((char *)&request[i], key, sizeof(key) - 1) != 0)
+                        continue;
+                i += sizeof(key) - 1;
+                for(channel = 0; i < len && request[i] >= '0' && request[i] <= '9'; i++)
+                        channel = channel * 10 + (request[i] - '0');
+                return (channel <= 255) ? channel : -1;
+        }
+        return -1;
+}
+
+static int uvc_rtsp_session_socket(void)
+{
+        int socket;
+
+        RtlDownMutex(&rtsp_tcp_mutex);
+        socket = rtsp_client_socket;
+        RtlUpMutex(&rtsp_tcp_mutex);
+        return socket;
+}
+
+/*one whole message on the rtsp session socket, fails once socket is not the session's anymore*/
+static int uvc_rtsp_write(int socket, const void *buf, int len)
+{
+        int ret = -1;
+
+        RtlDownMutex(&rtsp_tcp_write_mutex);
+        if(socket >= 0 && socket == uvc_rtsp_session_socket())
+                ret = write(socket, buf, len);
+        RtlUpMutex(&rtsp_tcp_write_mutex);
+        return ret;
+}
+
+static int uvc_rtsp_send_response(int client_socket, struct rtsp_context *rtsp_ctx)
+{
+        return uvc_rtsp_write(client_socket, rtsp_ctx->response, strlen(rtsp_ctx->response));
+}
+
 void uvc_rtsp_handle(void *param)
 {        
 	struct stream_context *stream_ctx = (struct stream_context *)param;
@@ -149,7 +226,9 @@ void uvc_rtsp_handle(void *param)
         
         fd_set read_fds;
 	struct timeval timeout;
-        int ok;
+        int ok, req_len, channel;
+        RtlMutexInit(&rtsp_tcp_mutex);
+        RtlMutexInit(&rtsp_tcp_write_mutex);
         rtsp_ctx = malloc(sizeof(struct rtsp_context));
         if(rtsp_ctx == NULL)
         {
@@ -201,6 +280,8 @@ void uvc_rtsp_handle(void *param)
 			close(client_socket);
 			continue;
 		}
+                rtsp_client_socket = client_socket;
+                rtsp_interleaved_channel = UVC_RTP_INTERLEAVED_CHANNEL;
                 *(rtsp_ctx->connect_ctx.remote_ip + 3) = (unsigned char) (client_addr.sin_addr.s_addr >> 24);
                 *(rtsp_ctx->connect_ctx.remote_ip + 2) = (unsigned char) (client_addr.sin_addr.s_addr >> 16);
                 *(rtsp_ctx->connect_ctx.remote_ip + 1) = (unsigned char) (client_addr.sin_addr.s_addr >> 8);
@@ -210,7 +291,8 @@ void uvc_rtsp_handle(void *param)
 		{
 
 
-                    read(client_socket, request_header, 512);
+                    req_len = read(client_socket, request_header, 512);
+                    channel = uvc_rtsp_interleaved_channel(request_header, req_len);
                     rtsp_readheader(request_header);
                     if(*request_header == 0)
                     {
@@ -230,7 +312,7 @@ void uvc_rtsp_handle(void *param)
                                            break;
 
                                     rtsp_cmd_options(rtsp_ctx);
-                                    ok = write(client_socket, rtsp_ctx->response, strlen(rtsp_ctx->response));
+                                    ok = uvc_rtsp_send_response(client_socket, rtsp_ctx);
                                     if (ok <= 0)
                                     {
 
@@ -248,7 +330,7 @@ void uvc_rtsp_handle(void *param)
                                            break;
 
                                     rtsp_cmd_describe(rtsp_ctx);
-                                    ok = write(client_socket, rtsp_ctx->response, strlen(rtsp_ctx->response));
+                                    ok = uvc_rtsp_send_response(client_socket, rtsp_ctx);
                                     if (ok <= 0)
                                     {
 
@@ -266,8 +348,10 @@ void uvc_rtsp_handle(void *param)
                                            break;
 
                                     //fill transport parameter
+                                    if(channel >= 0)
+                                            rtsp_interleaved_channel = channel;
                                     rtsp_cmd_setup(rtsp_ctx);
-                                    ok = write(client_socket, rtsp_ctx->response, strlen(rtsp_ctx->response));
+                                    ok = uvc_rtsp_send_response(client_socket, rtsp_ctx);
                                     if (ok <= 0)
                                     {
 
@@ -290,7 +374,7 @@ void uvc_rtsp_handle(void *param)
                                     RTSP_PRINTF("\n\rReceive teardown command!");
                                     rtsp_ctx->state = RTSP_INIT;
                                     rtsp_cmd_teardown(rtsp_ctx);
-                                    ok = write(client_socket, rtsp_ctx->response, strlen(rtsp_ctx->response));
+                                    ok = uvc_rtsp_send_response(client_socket, rtsp_ctx);
                                     if (ok <= 0)
                                     {
 
@@ -315,7 +399,7 @@ void uvc_rtsp_handle(void *param)
                                            break;
 
                                     rtsp_cmd_play(rtsp_ctx);
-                                    ok = write(client_socket, rtsp_ctx->response, strlen(rtsp_ctx->response));
+                                    ok = uvc_rtsp_send_response(client_socket, rtsp_ctx);
                                     if (ok <= 0)
                                     {
 
@@ -341,7 +425,7 @@ void uvc_rtsp_handle(void *param)
                             case(CMD_PAUSE):
                                     RTSP_PRINTF("\n\rReceive pause command!");
                                     rtsp_cmd_pause(rtsp_ctx);
-                                    ok = write(client_socket, rtsp_ctx->response, strlen(rtsp_ctx->response));
+                                    ok = uvc_rtsp_send_response(client_socket, rtsp_ctx);
                                     if (ok <= 0)
                                     {
 
@@ -364,7 +448,7 @@ void uvc_rtsp_handle(void *param)
 
                                     RTSP_ERROR("\n\rReceive unrecognized command!");
                                     rtsp_cmd_error(rtsp_ctx);
-                                    ok = write(client_socket, rtsp_ctx->response, strlen(rtsp_ctx->response));
+                                    ok = uvc_rtsp_send_response(client_socket, rtsp_ctx);
                                     if (ok <= 0)
                                     {
 
@@ -386,7 +470,13 @@ void uvc_rtsp_handle(void *param)
 		}
 out:
                 rtsp_ctx->state = RTSP_INIT;
+                RtlDownMutex(&rtsp_tcp_mutex);
+                rtsp_client_socket = -1;
+                RtlUpMutex(&rtsp_tcp_mutex);
+                /*a message still being written on it goes out first*/
+                RtlDownMutex(&rtsp_tcp_write_mutex);
                 close(client_socket);                               
+                RtlUpMutex(&rtsp_tcp_write_mutex);
             }
 
 	}               
@@ -404,6 +494,9 @@ exit:
         {
                 vTaskDelay(100);
         }
+        rtsp_client_socket = -1;
+        RtlMutexFree(&rtsp_tcp_mutex);
+        RtlMutexFree(&rtsp_tcp_write_mutex);
         rtsp_context_free(rtsp_ctx);
         if(rtsp_ctx != NULL)
                 free(rtsp_ctx);
@@ -415,20 +508,140 @@ exit:
 }
 
 
+#if UVC_RTP_ZERO_COPY
+static struct mjpeg_packetizer rtp_packetizer;
+static u8 rtp_join_save[MJPEG_PKT_HDR_MAX];
+/*packets that could not be joined inside the frame are copied here, allocated on first use*/
+static u8 *rtp_copy_buf;
+static unsigned int rtp_copy_bytes;
+
+/*
+ * packetize one frame from its uvc buffer and send it, as datagrams to "to" when
+ * channel < 0, or interleaved on the rtsp session socket otherwise.
+ */
+static int uvc_rtp_send_frame(int socket, struct sockaddr_in *to, int channel, struct rtp_object *payload)
+{
+        struct uvc_buf_context *frame = &uvc_frame[payload->index];
+        struct mjpeg_rtp_frag frag;
+        u8 *pkt;
+        int len, joined, ret = 0;
+
+        if(mjpeg_packetizer_load_frame(&rtp_packetizer, frame->data, frame->len,
+                                       xTaskGetTickCount() * (MJPEG_RTP_CLOCK / configTICK_RATE_HZ)) < 0)
+                return -1;
+        while(mjpeg_packetizer_next(&rtp_packetizer, &frag))
+        {
+                pkt = mjpeg_frag_join(&frag, channel, rtp_join_save, &len);
+                joined = (pkt != NULL);
+                if(!joined)
+                {
+                        if(rtp_copy_buf == NULL)
+                                rtp_copy_buf = malloc(MJPEG_PKT_BUF_SIZE(rtp_packetizer.max_payload));
+                        if(rtp_copy_buf != NULL)
+                                pkt = mjpeg_frag_copy(&frag, channel, rtp_copy_buf,
+                                                      MJPEG_PKT_BUF_SIZE(rtp_packetizer.max_payload), &len);
+                        if(pkt == NULL)
+                        {
+                                mjpeg_packetizer_reset(&rtp_packetizer);
+                                return -1;
+                        }
+                        rtp_copy_bytes += frag.data_len;
+                }
+                if(channel < 0)
+                        ret = sendto(socket, pkt, len, 0, (struct sockaddr *)to, sizeof(struct sockaddr_in));
+                else
+                        ret = uvc_rtsp_write(socket, pkt, len);
+                if(joined)
+                        mjpeg_frag_unjoin(&frag, rtp_join_save, len);
+                if(ret < 0)
+                        break;
+        }
+        return ret;
+}
+#endif
+
+static void uvc_rtp_stats_reset(struct rtp_send_stats *stats)
+{
+        memset(stats, 0, sizeof(struct rtp_send_stats));
+        stats->start = xTaskGetTickCount();
+}
+
+static void uvc_rtp_stats_update(struct rtp_send_stats *stats, unsigned int bytes, unsigned int send_time)
+{
+        unsigned int period;
+
+        stats->cnt ++;
+        stats->bytes += bytes;
+        stats->send_time += send_time;
+        if(send_time > stats->max_send_time)
+                stats->max_send_time = send_time;
+        if(stats->cnt < UVC_RTP_STATS_PERIOD)
+                return;
+
+        period = xTaskGetTickCount() - stats->start;
+        if(period == 0)
+                period = 1;
+        /*        print statistics info      */
+        /*1.frame rate(fps) 2.throughput(kB/s) 3.average/max frame sending time(ms)*/
+        printf("\n\r%dfps %dkB/s T:%d/%d", (stats->cnt * configTICK_RATE_HZ / period),
+               (stats->bytes / 1024) * configTICK_RATE_HZ / period,
+               (stats->send_time * portTICK_RATE_MS / stats->cnt), (stats->max_send_time * portTICK_RATE_MS));
+#if UVC_RTP_ZERO_COPY
+        /*4.payload sent without copy(kB) 5.payload copied for lack of headroom(kB) 6.jpeg header parses 7.rejected frames*/
+        printf(" zc:%dkB cp:%dkB P:%d E:%d", (rtp_packetizer.stats.payload_bytes - rtp_copy_bytes) / 1024,
+               rtp_copy_bytes / 1024, rtp_packetizer.stats.header_parses, rtp_packetizer.stats.bad_frames);
+        rtp_packetizer.stats.payload_bytes = 0;
+        rtp_copy_bytes = 0;
+#endif
+        uvc_rtp_stats_reset(stats);
+}
+
+/*
+ * move every rtp payload waiting in wait_queue to batch with a single lock, so that the
+ * sender drains frames queued while it was blocked in one go.
+ */
+static int uvc_rtp_fetch_batch(struct list_head *batch)
+{
+        if(RtlDownSemaWithTimeout(&payload_queue.wait_sema, 5)==0)
+                return 0;
+        RtlDownMutex(&payload_queue.wait_mutex);
+        list_splice_init(&payload_queue.wait_queue, batch);
+        RtlUpMutex(&payload_queue.wait_mutex);
+        return !list_empty(batch);
+}
+
+/*give the whole batch back to uvc_entry_handle for re-queueing to uvc driver*/
+static void uvc_rtp_release_batch(struct list_head *batch)
+{
+        struct rtp_object *payload;
+        int cnt = 0;
+
+        list_for_each_entry(payload, batch, rtp_list, struct rtp_object)
+                cnt ++;
+        RtlDownMutex(&payload_queue.done_mutex);
+        list_splice_init(batch, payload_queue.done_queue.prev);
+        RtlUpMutex(&payload_queue.done_mutex);
+        while(cnt--)
+                RtlUpSema(&payload_queue.done_sema);
+}
+
 void uvc_rtp_udp_init(struct stream_context *stream_ctx)
 {
 
 	struct rtsp_context *rtsp_ctx = (struct rtsp_context *)stream_ctx->protoCtx;
-        struct uvc_buf_context buf;
         struct rtp_object *payload;
+        struct list_head batch;
 	struct sockaddr_in rtp_addr;                
 	int rtp_socket;                
-        int i, ret;        
+        int ret;        
+#if UVC_RTP_ZERO_COPY
+        struct sockaddr_in client_addr;
+#endif
         socklen_t addrlen = sizeof(struct sockaddr_in);
         int rtp_port; 
         /* varibles for recording statistic use*/
-        unsigned int cnt, total, total_time, time1, time2, time3;
-        cnt = total = total_time = time1 = time2 = time3 = 0;
+        struct rtp_send_stats stats;
+        unsigned int time1;
         /*init rtp socket*/
 	rtp_socket = socket(AF_INET, SOCK_DGRAM, 0);
 	rtp_port = rtsp_ctx->transport.serverport_min;
@@ -441,59 +654,41 @@ void uvc_rtp_udp_init(struct stream_context *stream_ctx)
                 goto exit;
 	}
 
-        
+#if UVC_RTP_ZERO_COPY
+        mjpeg_packetizer_init(&rtp_packetizer, xTaskGetTickCount(), MJPEG_RTP_DEFAULT_PAYLOAD);
+        memset(&client_addr, 0, addrlen);
+        client_addr.sin_family = AF_INET;
+        client_addr.sin_addr.s_addr = *(uint32_t *)(rtsp_ctx->connect_ctx.remote_ip);
+        client_addr.sin_port = htons((u16)rtsp_ctx->transport.clientport_min);
+#endif
+        INIT_LIST_HEAD(&batch);
 restart:
+        uvc_rtp_stats_reset(&stats);
 	while((stream_ctx->isProcess)&&(rtsp_ctx->state == RTSP_PLAYING))
 	{
-                if(RtlDownSemaWithTimeout(&payload_queue.wait_sema, 5)==0)
+                if(!uvc_rtp_fetch_batch(&batch))
                     continue;
-                time1 = time3;
-                time2 = xTaskGetTickCount();
                 /*send rtp payload*/
-                if(!list_empty(&payload_queue.wait_queue))
+                list_for_each_entry(payload, &batch, rtp_list, struct rtp_object)
                 {
-                    RtlDownMutex(&payload_queue.wait_mutex);
-                    payload = list_first_entry(&payload_queue.wait_queue, struct rtp_object, rtp_list);
-                    if(payload == NULL)
-                    {
-                            RtlUpMutex(&payload_queue.wait_mutex);
-                            continue;
-                    }
-                    list_del_init(&payload->rtp_list);
-                    RtlUpMutex(&payload_queue.wait_mutex);
-                                           
-                    if(rtsp_ctx->state == RTSP_PLAYING)
-                    {
-
-                        payload->connect_ctx.socket_id = rtp_socket;
-                        payload->connect_ctx.port = (u16)rtsp_ctx->transport.clientport_min;
-                        payload->connect_ctx.server_ip = rtsp_ctx->connect_ctx.server_ip;
-                        payload->connect_ctx.remote_ip = rtsp_ctx->connect_ctx.remote_ip;
-                    
-                        ret = rtp_udp_send(stream_ctx, payload);                           
-                    }
-                    
-                    //dequeue the this buffer from payload_queue 
-                    RtlDownMutex(&payload_queue.done_mutex);
-                    list_add_tail(&payload->rtp_list, &payload_queue.done_queue);
-                    RtlUpMutex(&payload_queue.done_mutex);                        
-                    RtlUpSema(&payload_queue.done_sema);
-                    
-                    time3 = xTaskGetTickCount();
-                    cnt ++;
-                    total += payload->len;
-                    total_time += (time3-time1);
-                    if(cnt == 100)
-                    {
-                      /*        print statistics info      */
-                      /*1.average frame size(kB) T:2.time waited for next frame sending start(ms)-3.udp sending time(ms) 4.frame rate(fps)*/
-                      printf("\n\r%dkB T:%d-%d %dfps", (total/102400), (time2 - time1), (time3 - time2), (100000/total_time));
-                      cnt = 0;
-                      total = 0;
-                      total_time = 0;
-                    }
+                    if(rtsp_ctx->state != RTSP_PLAYING)
+                        break;
+                    time1 = xTaskGetTickCount();
+                    payload->connect_ctx.socket_id = rtp_socket;
+                    payload->connect_ctx.port = (u16)rtsp_ctx->transport.clientport_min;
+                    payload->connect_ctx.server_ip = rtsp_ctx->connect_ctx.server_ip;
+                    payload->connect_ctx.remote_ip = rtsp_ctx->connect_ctx.remote_ip;
+                
+#if UVC_RTP_ZERO_COPY
+                    ret = uvc_rtp_send_frame(rtp_socket, &client_addr, -1, payload);
+#else
+                    ret = rtp_udp_send(stream_ctx, payload);                           
+#endif
+                    if(ret >= 0)
+                        uvc_rtp_stats_update(&stats, UVC_RTP_FRAME_LEN(payload), xTaskGetTickCount() - time1);
                 }
-
+                //dequeue the batch from payload_queue 
+                uvc_rtp_release_batch(&batch);
 	}
         mdelay(1000);
         if(rtsp_ctx->state == RTSP_READY)
@@ -505,12 +700,174 @@ exit:
 	close(rtp_socket);
 }
 
+/*
+ * rtp over rtsp (interleaved, RFC 2326 10.12): rtp packets are framed on the rtsp session
+ * socket itself. A batch of pending frames is set up for the session socket under
+ * rtsp_tcp_mutex and then sent back to back outside it, so a slow client only holds up its
+ * own stream, and rtsp responses go out between two packets. Nagle stays enabled so the
+ * small interleave/rtp/jpeg headers coalesce with the payload.
+ */
 void uvc_rtp_tcp_init(struct stream_context *stream_ctx)
 {
+	struct rtsp_context *rtsp_ctx = (struct rtsp_context *)stream_ctx->protoCtx;
+        struct rtp_object *payload;
+        struct list_head batch;
+        struct rtp_send_stats stats;
+        unsigned int time1;
+        int socket, channel;
+        int ret;
+
+        if(rtsp_client_socket < 0)
+        {
+                RTSP_ERROR("\n\rno rtsp session for interleaved rtp");
+                return;
+        }
+#if UVC_RTP_ZERO_COPY
+        mjpeg_packetizer_init(&rtp_packetizer, xTaskGetTickCount(), MJPEG_RTP_DEFAULT_PAYLOAD);
+#endif
+
+        INIT_LIST_HEAD(&batch);
+restart:
+        uvc_rtp_stats_reset(&stats);
+	while((stream_ctx->isProcess)&&(rtsp_ctx->state == RTSP_PLAYING))
+	{
+                if(!uvc_rtp_fetch_batch(&batch))
+                    continue;
+
+                /*the batch is built under the lock, the writes happen outside it*/
+                RtlDownMutex(&rtsp_tcp_mutex);
+                socket = rtsp_client_socket;
+                channel = rtsp_interleaved_channel;
+                list_for_each_entry(payload, &batch, rtp_list, struct rtp_object)
+                {
+                    payload->connect_ctx.socket_id = socket;
+                    payload->connect_ctx.port = (u16)rtsp_ctx->transport.clientport_min;
+                    payload->connect_ctx.server_ip = rtsp_ctx->connect_ctx.server_ip;
+                    payload->connect_ctx.remote_ip = rtsp_ctx->connect_ctx.remote_ip;
+                }
+                RtlUpMutex(&rtsp_tcp_mutex);
+
+                list_for_each_entry(payload, &batch, rtp_list, struct rtp_object)
+                {
+                    if((rtsp_ctx->state != RTSP_PLAYING)||(socket < 0))
+                        break;
+                    time1 = xTaskGetTickCount();
+#if UVC_RTP_ZERO_COPY
+                    ret = uvc_rtp_send_frame(socket, NULL, channel, payload);
+#else
+                    /*writes the whole frame, the session may have ended since the batch was built*/
+                    RtlDownMutex(&rtsp_tcp_write_mutex);
+                    ret = (socket == uvc_rtsp_session_socket()) ?
+                          rtp_jpeg_tcp_send(payload, (u8 *)jpeg_luma_quantizer, (u8 *)jpeg_chroma_quantizer) : -1;
+                    RtlUpMutex(&rtsp_tcp_write_mutex);
+#endif
+                    if(ret < 0)
+                    {
+                        RTSP_ERROR("\n\rinterleaved rtp send failed");
+                        break;
+                    }
+                    uvc_rtp_stats_update(&stats, UVC_RTP_FRAME_LEN(payload), xTaskGetTickCount() - time1);
+                }
+
+                uvc_rtp_release_batch(&batch);
+	}
+        mdelay(1000);
+        if(rtsp_ctx->state == RTSP_READY)
+        {
+            goto restart;
+        }
 }
 
+/*
+ * every viewer joins the same group, so each frame is packetized and sent exactly once
+ * no matter how many clients are watching.
+ */
 void uvc_rtp_multi_init(struct stream_context *stream_ctx)
 {
+#if LWIP_IGMP
+	struct rtsp_context *rtsp_ctx = (struct rtsp_context *)stream_ctx->protoCtx;
+        struct rtp_object *payload;
+        struct list_head batch;
+	struct sockaddr_in rtp_addr;
+        struct in_addr intf_addr;
+        struct rtp_send_stats stats;
+        uint32_t group_addr;
+        unsigned char ttl = UVC_RTP_MULTICAST_TTL;
+        socklen_t addrlen = sizeof(struct sockaddr_in);
+        unsigned int time1;
+	int rtp_socket;
+        int ret;
+
+        xnetif[0].flags |= NETIF_FLAG_IGMP;
+        group_addr = inet_addr(UVC_RTP_MULTICAST_GROUP);
+
+	rtp_socket = socket(AF_INET, SOCK_DGRAM, 0);
+        if(rtp_socket < 0)
+        {
+                RTSP_ERROR("\n\rcreate multicast socket failed");
+                return;
+        }
+	memset(&rtp_addr, 0, addrlen);
+	rtp_addr.sin_family = AF_INET;
+	rtp_addr.sin_addr.s_addr = *(uint32_t *)(rtsp_ctx->connect_ctx.server_ip);
+	rtp_addr.sin_port = htons((u16)rtsp_ctx->transport.serverport_min);
+	if (bind(rtp_socket,(struct sockaddr *)&rtp_addr, addrlen)<0) {
+                RTSP_ERROR("bind failed\r\n");
+                goto exit;
+	}
+        intf_addr.s_addr = *(uint32_t *)(rtsp_ctx->connect_ctx.server_ip);
+        if(setsockopt(rtp_socket, IPPROTO_IP, IP_MULTICAST_IF, &intf_addr, sizeof(struct in_addr)) < 0)
+        {
+                RTSP_ERROR("\n\rsetsockopt - IP_MULTICAST_IF");
+                goto exit;
+        }
+        setsockopt(rtp_socket, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+#if UVC_RTP_ZERO_COPY
+        mjpeg_packetizer_init(&rtp_packetizer, xTaskGetTickCount(), MJPEG_RTP_DEFAULT_PAYLOAD);
+        memset(&rtp_addr, 0, addrlen);
+        rtp_addr.sin_family = AF_INET;
+        rtp_addr.sin_addr.s_addr = group_addr;
+        rtp_addr.sin_port = htons((u16)rtsp_ctx->transport.clientport_min);
+#endif
+
+        INIT_LIST_HEAD(&batch);
+restart:
+        uvc_rtp_stats_reset(&stats);
+	while((stream_ctx->isProcess)&&(rtsp_ctx->state == RTSP_PLAYING))
+	{
+                if(!uvc_rtp_fetch_batch(&batch))
+                    continue;
+                list_for_each_entry(payload, &batch, rtp_list, struct rtp_object)
+                {
+                    if(rtsp_ctx->state != RTSP_PLAYING)
+                        break;
+                    time1 = xTaskGetTickCount();
+                    payload->connect_ctx.socket_id = rtp_socket;
+                    payload->connect_ctx.port = (u16)rtsp_ctx->transport.clientport_min;
+                    payload->connect_ctx.server_ip = rtsp_ctx->connect_ctx.server_ip;
+                    payload->connect_ctx.remote_ip = (u8 *)&group_addr;
+
+#if UVC_RTP_ZERO_COPY
+                    ret = uvc_rtp_send_frame(rtp_socket, &rtp_addr, -1, payload);
+#else
+                    ret = rtp_udp_send(stream_ctx, payload);
+#endif
+                    if(ret >= 0)
+                        uvc_rtp_stats_update(&stats, UVC_RTP_FRAME_LEN(payload), xTaskGetTickCount() - time1);
+                }
+                uvc_rtp_release_batch(&batch);
+	}
+        mdelay(1000);
+        if(rtsp_ctx->state == RTSP_READY)
+        {
+            goto restart;
+        }
+
+exit:
+	close(rtp_socket);
+#else
+        RTSP_ERROR("\n\rSHOULD ENABLE LWIP_IGMP for multicast streaming");
+#endif
 }
 
 void uvc_rtp_handle(void *param)
@@ -532,10 +889,10 @@ void uvc_rtp_handle(void *param)
                             uvc_rtp_udp_init(stream_ctx);
                             break;
                         case(MULTICAST_MODE):
-                            uvc_rtp_tcp_init(stream_ctx);
+                            uvc_rtp_multi_init(stream_ctx);
                             break;
                         case(UNICAST_TCP_MODE):
-                            uvc_rtp_multi_init(stream_ctx);
+                            uvc_rtp_tcp_init(stream_ctx);
                             break;
                         default:
                             RTSP_ERROR("\r\n unknown streaming mode! Go back to RTSP_INIT state\n");
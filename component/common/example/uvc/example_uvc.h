@@ -8,6 +8,16 @@
 
 #define UVC_RTSP_EN     1
 
+/*multicast group & ttl used when client requests MULTICAST_MODE*/
+#define UVC_RTP_MULTICAST_GROUP         "239.255.0.1"
+#define UVC_RTP_MULTICAST_TTL           1
+/*packetize frames straight from uvc buffers with mjpeg_packetizer instead of rtp_fill_payload*/
+#define UVC_RTP_ZERO_COPY               1
+/*rtp channel of rtsp interleaved mode when SETUP gives no interleaved= (rtcp uses channel + 1)*/
+#define UVC_RTP_INTERLEAVED_CHANNEL     0
+/*number of frames between two statistics print*/
+#define UVC_RTP_STATS_PERIOD            100
+
 //example structure to handle rtp_object operation in queue
 struct rtp_payload_queue
 {
@@ -20,6 +30,16 @@ struct rtp_payload_queue
     int flush_err;
 };
 
+//statistics of rtp sending, shared by udp/tcp/multicast mode
+struct rtp_send_stats
+{
+    unsigned int cnt;           //frames sent in current period
+    unsigned int bytes;         //bytes sent in current period
+    unsigned int send_time;     //ticks spent inside send calls
+    unsigned int max_send_time; //worst single frame send time
+    unsigned int start;         //tick count when current period started
+};
+
 void example_uvc(void);
 
 #endif /* EXAMPLE_UVC_H */
\ No newline at end of file
@@ -0,0 +1,333 @@
+
+/*
+* RFC 2435 (RTP payload format for JPEG) packetizer without frame copy
+*/
+
+#include <platform/platform_stdlib.h>
+#include "mjpeg_packetizer.h"
+
+#define MJPEG_PKT_DEBUG 0
+
+#if MJPEG_PKT_DEBUG
+#define MJPEG_PKT_ERROR(fmt, args...)     printf("\n\r%s: " fmt, __FUNCTION__, ## args)
+#else
+#define MJPEG_PKT_ERROR(fmt, args...)
+#endif
+
+#define JPEG_SOI        0xD8
+#define JPEG_EOI        0xD9
+#define JPEG_SOF0       0xC0
+#define JPEG_DHT        0xC4
+#define JPEG_SOS        0xDA
+#define JPEG_DQT        0xDB
+#define JPEG_DRI        0xDD
+
+#define RD16(p)         (((u16)(p)[0] << 8) | (p)[1])
+
+static u8 *put16(u8 *p, u16 v)
+{
+        *p++ = (u8)(v >> 8);
+        *p++ = (u8)v;
+        return p;
+}
+
+static u8 *put32(u8 *p, u32 v)
+{
+        *p++ = (u8)(v >> 24);
+        *p++ = (u8)(v >> 16);
+        *p++ = (u8)(v >> 8);
+        *p++ = (u8)v;
+        return p;
+}
+
+/*full walk over the markers of frame, only run when the cached layout does not match*/
+static int mjpeg_parse_header(struct mjpeg_stream_info *info, u8 *frame, int len)
+{
+        int pos = 2, seg_len, end, tq, width, height;
+        u8 marker, hv;
+
+        memset(info, 0, sizeof(struct mjpeg_stream_info));
+        info->qt_offset[0] = info->qt_offset[1] = -1;
+        if(len < 4 || frame[0] != 0xFF || frame[1] != JPEG_SOI)
+                return -1;
+
+        while(pos + 4 <= len)
+        {
+                if(frame[pos] != 0xFF)
+                        return -1;
+                marker = frame[pos + 1];
+                if(marker == 0xFF){     //fill byte
+                        pos ++;
+                        continue;
+                }
+                seg_len = RD16(&frame[pos + 2]);
+                end = pos + 2 + seg_len;
+                if(seg_len < 2 || end > len)
+                        return -1;
+
+                switch(marker)
+                {
+                        case JPEG_DQT:
+                                pos += 4;
+                                while(pos < end)
+                                {
+                                        tq = frame[pos] & 0x0F;
+                                        /*only 8-bit tables can be carried with precision 0*/
+                                        if((frame[pos] >> 4) != 0 || tq > 1 || pos + 65 > end)
+                                                return -1;
+                                        info->qt_offset[tq] = pos + 1;
+                                        memcpy(info->qt[tq], &frame[pos + 1], 64);
+                                        pos += 65;
+                                }
+                                break;
+                        case JPEG_SOF0:
+                                if(seg_len != 17 || frame[pos + 9] != 3)
+                                        return -1;
+                                hv = frame[pos + 11];   //sampling factors of Y
+                                if(hv == 0x21)
+                                        info->type = 0; //4:2:2
+                                else if(hv == 0x22)
+                                        info->type = 1; //4:2:0
+                                else
+                                        return -1;
+                                height = RD16(&frame[pos + 5]);
+                                width = RD16(&frame[pos + 7]);
+                                if(width == 0 || height == 0 || width > MJPEG_RTP_MAX_DIMENSION || height > MJPEG_RTP_MAX_DIMENSION)
+                                        return -1;
+                                info->height = (u8)((height + 7) >> 3);
+                                info->width = (u8)((width + 7) >> 3);
+                                info->sof_offset = pos;
+                                memcpy(info->sof, &frame[pos], sizeof(info->sof));
+                                break;
+                        case JPEG_DRI:
+                                info->dri = RD16(&frame[pos + 4]);
+                                break;
+                        case JPEG_SOS:
+                                if(seg_len != 12 || info->sof_offset == 0 || info->qt_offset[0] < 0 || info->qt_offset[1] < 0)
+                                        return -1;
+                                if(info->dri)
+                                        info->type += 64;
+                                info->scan_offset = end;
+                                info->valid = 1;
+                                return 0;
+                        default:        //DHT, APPn, COM... are not carried by RFC 2435
+                                break;
+                }
+                pos = end;
+        }
+        return -1;
+}
+
+/*
+ * cheap check that frame was produced with the same configuration as the cached one:
+ * only the segment lengths are followed up to SOS, so a restart interval that appears,
+ * goes away or changes is noticed even when the scan starts at the same offset.
+ */
+static int mjpeg_header_cached(struct mjpeg_stream_info *info, u8 *frame, int len)
+{
+        int pos = 2, end = 0;
+        u16 dri = 0;
+        u8 marker;
+
+        if(!info->valid || len <= info->scan_offset)
+                return 0;
+        while(pos + 4 <= info->scan_offset)
+        {
+                if(frame[pos] != 0xFF)
+                        return 0;
+                marker = frame[pos + 1];
+                if(marker == 0xFF){     //fill byte
+                        pos ++;
+                        continue;
+                }
+                end = pos + 2 + RD16(&frame[pos + 2]);
+                if(end > info->scan_offset)
+                        return 0;
+                if(marker == JPEG_DRI)
+                        dri = (end >= pos + 6) ? RD16(&frame[pos + 4]) : 0;
+                if(marker == JPEG_SOS)
+                        break;
+                pos = end;
+        }
+        if(pos + 4 > info->scan_offset || frame[pos + 1] != JPEG_SOS || end != info->scan_offset || dri != info->dri)
+                return 0;
+        if(memcmp(&frame[info->sof_offset], info->sof, sizeof(info->sof)))
+                return 0;
+        if(memcmp(&frame[info->qt_offset[0]], info->qt[0], 64) || memcmp(&frame[info->qt_offset[1]], info->qt[1], 64))
+                return 0;
+        return 1;
+}
+
+void mjpeg_packetizer_init(struct mjpeg_packetizer *pkt, u32 ssrc, int max_payload)
+{
+        memset(pkt, 0, sizeof(struct mjpeg_packetizer));
+        pkt->ssrc = ssrc;
+        pkt->seq = (u16)ssrc;
+        pkt->max_payload = (max_payload > 0) ? max_payload : MJPEG_RTP_DEFAULT_PAYLOAD;
+        /*every packet has to fit its headers and carry some data*/
+        if(pkt->max_payload < MJPEG_RTP_MIN_PAYLOAD)
+                pkt->max_payload = MJPEG_RTP_MIN_PAYLOAD;
+}
+
+void mjpeg_packetizer_reset(struct mjpeg_packetizer *pkt)
+{
+        pkt->info.valid = 0;
+        pkt->scan = NULL;
+        pkt->scan_len = pkt->offset = 0;
+}
+
+int mjpeg_packetizer_load_frame(struct mjpeg_packetizer *pkt, u8 *frame, int len, u32 timestamp)
+{
+        struct mjpeg_stream_info *info = &pkt->info;
+        int scan_len, tail;
+
+        if(!mjpeg_header_cached(info, frame, len))
+        {
+                pkt->stats.header_parses ++;
+                if(mjpeg_parse_header(info, frame, len) < 0)
+                {
+                        MJPEG_PKT_ERROR("unsupported jpeg frame");
+                        pkt->stats.bad_frames ++;
+                        return -1;
+                }
+        }
+
+        /*uvc payload may carry padding after EOI, look for it in the frame tail only*/
+        scan_len = len - info->scan_offset;
+        for(tail = len; (tail >= info->scan_offset + 2) && (len - tail < 64); tail --)
+        {
+                if(frame[tail - 2] == 0xFF && frame[tail - 1] == JPEG_EOI)
+                {
+                        scan_len = tail - 2 - info->scan_offset;
+                        break;
+                }
+        }
+        if(scan_len <= 0)
+        {
+                pkt->stats.bad_frames ++;
+                return -1;
+        }
+
+        pkt->scan = frame + info->scan_offset;
+        pkt->scan_len = scan_len;
+        pkt->offset = 0;
+        pkt->timestamp = timestamp;
+        pkt->stats.frames ++;
+        return 0;
+}
+
+int mjpeg_packetizer_next(struct mjpeg_packetizer *pkt, struct mjpeg_rtp_frag *frag)
+{
+        struct mjpeg_stream_info *info = &pkt->info;
+        u8 *hdr = pkt->hdr_buf + MJPEG_INTERLEAVE_SIZE;
+        u8 *p = hdr;
+        int room;
+
+        if(pkt->scan == NULL || pkt->offset >= pkt->scan_len)
+                return 0;
+
+        p += MJPEG_RTP_HDR_SIZE;        //filled once data length is known
+        /*main jpeg header*/
+        *p++ = 0;
+        *p++ = (u8)(pkt->offset >> 16);
+        *p++ = (u8)(pkt->offset >> 8);
+        *p++ = (u8)pkt->offset;
+        *p++ = info->type;
+        *p++ = 255;                     //tables carried in-band
+        *p++ = info->width;
+        *p++ = info->height;
+        if(info->dri)
+        {
+                p = put16(p, info->dri);
+                *p++ = 0xFF;            //F = L = 1, count = 0x3FFF
+                *p++ = 0xFF;
+        }
+        if(pkt->offset == 0)
+        {
+                *p++ = 0;               //mbz
+                *p++ = 0;               //precision, 8-bit tables
+                p = put16(p, 128);
+                memcpy(p, info->qt[0], 64);
+                memcpy(p + 64, info->qt[1], 64);
+                p += 128;
+        }
+
+        room = pkt->max_payload - (p - hdr);
+        frag->data = pkt->scan + pkt->offset;
+        frag->data_len = (pkt->scan_len - pkt->offset > room) ? room : (pkt->scan_len - pkt->offset);
+        frag->headroom = info->scan_offset + pkt->offset;
+        pkt->offset += frag->data_len;
+        frag->last = (pkt->offset >= pkt->scan_len);
+
+        /*rtp header*/
+        hdr[0] = 0x80;
+        hdr[1] = MJPEG_RTP_PT | (frag->last ? 0x80 : 0);
+        put16(&hdr[2], pkt->seq++);
+        put32(&hdr[4], pkt->timestamp);
+        put32(&hdr[8], pkt->ssrc);
+
+        frag->hdr = hdr;
+        frag->hdr_len = p - hdr;
+        pkt->stats.packets ++;
+        pkt->stats.payload_bytes += frag->data_len;
+        if(frag->last)
+                pkt->scan = NULL;
+        return 1;
+}
+
+/*
+ * make the fragment contiguous by writing its headers (and the rtsp interleave prefix
+ * when channel >= 0) right in front of the fragment data inside the frame.
+ */
+u8 *mjpeg_frag_join(struct mjpeg_rtp_frag *frag, int channel, u8 *save, int *len)
+{
+        int hdr_len = frag->hdr_len;
+        u8 *start;
+
+        if(channel >= 0)
+        {
+                hdr_len += MJPEG_INTERLEAVE_SIZE;
+                frag->hdr[-4] = '$';
+                frag->hdr[-3] = (u8)channel;
+                put16(&frag->hdr[-2], (u16)(frag->hdr_len + frag->data_len));
+        }
+        if(hdr_len > frag->headroom)
+                return NULL;
+
+        start = frag->data - hdr_len;
+        memcpy(save, start, hdr_len);
+        memcpy(start, frag->hdr + frag->hdr_len - hdr_len, hdr_len);
+        *len = hdr_len + frag->data_len;
+        return start;
+}
+
+void mjpeg_frag_unjoin(struct mjpeg_rtp_frag *frag, u8 *save, int len)
+{
+        int hdr_len = len - frag->data_len;
+        memcpy(frag->data - hdr_len, save, hdr_len);
+}
+
+/*
+ * fallback of mjpeg_frag_join when the frame has no room in front of the fragment:
+ * the whole packet is copied into buf, which holds MJPEG_PKT_BUF_SIZE(max_payload) bytes.
+ */
+u8 *mjpeg_frag_copy(struct mjpeg_rtp_frag *frag, int channel, u8 *buf, int size, int *len)
+{
+        int hdr_len = frag->hdr_len;
+        u8 *p = buf;
+
+        if(channel >= 0)
+                hdr_len += MJPEG_INTERLEAVE_SIZE;
+        if(hdr_len + frag->data_len > size)
+                return NULL;
+        if(channel >= 0)
+        {
+                *p++ = '$';
+                *p++ = (u8)channel;
+                p = put16(p, (u16)(frag->hdr_len + frag->data_len));
+        }
+        memcpy(p, frag->hdr, frag->hdr_len);
+        memcpy(p + frag->hdr_len, frag->data, frag->data_len);
+        *len = hdr_len + frag->data_len;
+        return buf;
+}
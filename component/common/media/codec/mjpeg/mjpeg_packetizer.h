@@ -0,0 +1,93 @@
+
+#ifndef _MJPEG_PACKETIZER_H
+#define _MJPEG_PACKETIZER_H
+
+#include "osdep_api.h"
+
+/*
+ * RFC 2435 packetizer working on the captured frame itself.
+ *
+ * Markers of a frame are parsed only when the stream configuration changes (size,
+ * sampling, quantization tables or restart interval); following frames only verify
+ * the cached layout. Every fragment is returned as a small header built in the
+ * packetizer plus a pointer into the scan data of the frame, so no frame copy is made.
+ *
+ * Sockets without scatter-gather send can use mjpeg_frag_join(): the header is written
+ * in front of the fragment inside the frame (bytes already sent or jpeg markers), the
+ * overwritten bytes are kept in a caller buffer of MJPEG_PKT_HDR_MAX bytes and put back
+ * by mjpeg_frag_unjoin() once the packet is sent. Where the frame has no such room,
+ * mjpeg_frag_copy() builds the packet in a buffer of MJPEG_PKT_BUF_SIZE bytes instead.
+ */
+
+#define MJPEG_RTP_PT                    26
+#define MJPEG_RTP_CLOCK                 90000
+#define MJPEG_RTP_DEFAULT_PAYLOAD       1400    //rtp packet size including rtp header
+#define MJPEG_RTP_MAX_DIMENSION         2040    //width and height are sent in 8 pixel blocks of one byte
+
+#define MJPEG_RTP_HDR_SIZE              12
+#define MJPEG_JPEG_HDR_SIZE             8
+#define MJPEG_RST_HDR_SIZE              4
+#define MJPEG_QT_HDR_SIZE               4
+#define MJPEG_INTERLEAVE_SIZE           4       //'$' + channel + length of rtsp interleaved frame
+#define MJPEG_PKT_HDR_MAX               (MJPEG_INTERLEAVE_SIZE + MJPEG_RTP_HDR_SIZE + MJPEG_JPEG_HDR_SIZE + \
+                                         MJPEG_RST_HDR_SIZE + MJPEG_QT_HDR_SIZE + 128)
+#define MJPEG_PKT_BUF_SIZE(max_payload) (MJPEG_INTERLEAVE_SIZE + (max_payload))
+#define MJPEG_RTP_MIN_PAYLOAD           (MJPEG_PKT_HDR_MAX - MJPEG_INTERLEAVE_SIZE + 1) //largest headers and a byte of data
+
+struct mjpeg_stream_info
+{
+        int valid;
+        u8 type;                //RFC 2435 type, +64 when restart markers are used
+        u8 width;               //frame width in 8 pixel blocks
+        u8 height;              //frame height in 8 pixel blocks
+        u16 dri;                //restart interval
+        u8 qt[2][64];           //luma & chroma quantization tables
+        int qt_offset[2];       //position of the tables inside the frame
+        int sof_offset;         //position of SOF0 segment inside the frame
+        u8 sof[19];             //SOF0 segment of 3 components
+        int scan_offset;        //first byte of entropy coded data
+};
+
+struct mjpeg_rtp_frag
+{
+        u8 *hdr;                //rtp + jpeg headers of this packet
+        int hdr_len;
+        u8 *data;               //points into the scan data of the frame
+        int data_len;
+        int headroom;           //frame bytes in front of data that may be borrowed by join
+        int last;               //marker bit set, end of frame
+};
+
+struct mjpeg_packetizer_stats
+{
+        u32 frames;
+        u32 packets;
+        u32 header_parses;      //full marker parse, i.e. stream configuration changes
+        u32 payload_bytes;      //bytes sent straight from the frame instead of copied
+        u32 bad_frames;
+};
+
+struct mjpeg_packetizer
+{
+        struct mjpeg_stream_info info;
+        u32 ssrc;
+        u16 seq;
+        int max_payload;
+        /*frame being packetized*/
+        u8 *scan;
+        int scan_len;
+        int offset;
+        u32 timestamp;
+        u8 hdr_buf[MJPEG_PKT_HDR_MAX];
+        struct mjpeg_packetizer_stats stats;
+};
+
+void mjpeg_packetizer_init(struct mjpeg_packetizer *pkt, u32 ssrc, int max_payload);
+void mjpeg_packetizer_reset(struct mjpeg_packetizer *pkt);
+int mjpeg_packetizer_load_frame(struct mjpeg_packetizer *pkt, u8 *frame, int len, u32 timestamp);
+int mjpeg_packetizer_next(struct mjpeg_packetizer *pkt, struct mjpeg_rtp_frag *frag);
+u8 *mjpeg_frag_join(struct mjpeg_rtp_frag *frag, int channel, u8 *save, int *len);
+void mjpeg_frag_unjoin(struct mjpeg_rtp_frag *frag, u8 *save, int len);
+u8 *mjpeg_frag_copy(struct mjpeg_rtp_frag *frag, int channel, u8 *buf, int size, int *len);
+
+#endif /*_MJPEG_PACKETIZER_H*/
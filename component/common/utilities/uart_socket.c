@@ -30,21 +30,30 @@ extern int lwip_allocsocketsd();
 static void uart_irq(uint32_t id, SerialIrq event)
 {
 	uart_socket_t *u = (uart_socket_t *)id;
+	u32 pwrite;
 
 	if(event == RxIrq) {
+		pwrite = u->prxwrite;
+		/* drain the whole rx fifo in one interrupt */
+		while(serial_readable(&u->sobj)){
+			if((pwrite - u->prxread) < u->rx_size){
+				u->recv_buf[pwrite & (u->rx_size - 1)] = serial_getc(&u->sobj);
+				pwrite++;
+			} else {
+				serial_getc(&u->sobj);
+				u->rx_overflow++;	//reader too slow, drop newest bytes
+			}
+		}
+		u->rx_total += pwrite - u->prxwrite;
+		u->prxwrite = pwrite;
+		u->last_update =  xTaskGetTickCountFromISR();	// update tick everytime recved data
+
 		if( u->rx_start == 0 ){
-			RtlUpSemaFromISR(&u->action_sema);	//up action semaphore 
 			u->rx_start = 1; // set this flag in uart_irq to indicate data recved
+			RtlUpSemaFromISR(&u->action_sema);	//up action semaphore 
+		} else if((pwrite - u->rx_notified) >= u->rx_notify_bytes){
+			RtlUpSemaFromISR(&u->rx_sema);	//enough data, do not wait for idle line
 		}
-		u->recv_buf[u->prxwrite++] = serial_getc(&u->sobj);
-		if(u->prxwrite > (UART_RECV_BUFFER_LEN -1)){	//restart from  head if  reach tail
-			u->prxwrite = 0;
-			u->rxoverlap = 1;							//set overlap indicated that overlaped 
-		}
-		if(u->rxoverlap && (u->prxwrite + 1) > u->prxread ){
-			u->prxread = u->prxwrite;		//if pwrite overhead pread ,pread is always flow rwrite 
-		}
-		u->last_update =  xTaskGetTickCountFromISR();	// update tick everytime recved data
 	}
 
 	if(event == TxIrq){
@@ -55,10 +64,16 @@ static void uart_send_stream_done(uint32_t id)
 {
 	uart_socket_t *u = (uart_socket_t *)id;
 	
-	u->tx_start = 0;
-	memset(u->send_buf,0, UART_SEND_BUFFER_LEN);	//zero set uart_send_buf
+	u->ptxread += u->tx_bytes;	//release the space of this transfer
+	u->tx_bytes = 0;
 	RtlUpSemaFromISR(&u->tx_sema);
 	RtlUpSemaFromISR(&u->dma_tx_sema);
+	if(u->ptxwrite != u->ptxread){
+		u->tx_start = 1;	//more data queued meanwhile
+		RtlUpSemaFromISR(&u->action_sema);
+		if(u->rx_start)
+			RtlUpSemaFromISR(&u->rx_sema);	//action task may be waiting for an rx batch
+	}
 }
 
 static int uart_send_stream(uart_socket_t *u, char* pbuf, int len)
@@ -72,8 +87,11 @@ static int uart_send_stream(uart_socket_t *u, char* pbuf, int len)
 
 #if UART_SOCKET_USE_DMA_TX
 	while(RtlDownSema(&u->dma_tx_sema) == pdTRUE){			
+		u->tx_bytes = len;
+		u->tx_transfers++;
 	    	ret = serial_send_stream_dma(&u->sobj, pbuf, len);
 	    	if(ret != HAL_OK){
+			u->tx_bytes = 0;
 			RtlUpSema(&u->dma_tx_sema);
 			return -1;
 		}else{
@@ -91,13 +109,45 @@ static int uart_send_stream(uart_socket_t *u, char* pbuf, int len)
 	return 0;
 }
 
+/* Start sending the contiguous part of tx ring, called from uart_action only */
+static void uart_tx_kick(uart_socket_t *u)
+{
+	u32 pread = u->ptxread;
+	u32 pending = u->ptxwrite - pread;
+	u32 offset = pread & (u->tx_size - 1);
+
+	if(!pending || u->tx_bytes)
+		return;
+	if(pending > (u->tx_size - offset))
+		pending = u->tx_size - offset;	//wrap part goes with next transfer
+
+	if(uart_send_stream(u, (char*)(u->send_buf + offset), pending) == -1){
+		uart_printf("uart send data error!");
+		return;
+	}
+#if (UART_SOCKET_USE_DMA_TX == 0)
+	u->ptxread = pread + pending;
+	RtlUpSema(&u->tx_sema);
+	if(u->ptxwrite != u->ptxread)
+		u->tx_start = 1;
+#endif
+}
+
+/* Wait until rx_notify_bytes are pending or the line has been idle long enough,
+ * tx transfers are still chained meanwhile */
 static s32 uart_wait_rx_complete(uart_socket_t *u)
 {
-	s32 tick_current = xTaskGetTickCount();
+	s32 idle;
 
-	while((tick_current -u->last_update) < UART_MAX_DELAY_TIME ){
-		vTaskDelay(5);
-		tick_current = xTaskGetTickCount();
+	while((u->prxwrite - u->rx_notified) < u->rx_notify_bytes){
+		if(u->tx_start){
+			u->tx_start = 0;
+			uart_tx_kick(u);
+		}
+		idle = xTaskGetTickCount() - u->last_update;
+		if(idle >= (s32)u->rx_idle_time)
+			break;
+		RtlDownSemaWithTimeout(&u->rx_sema, u->rx_idle_time - idle);
 	}	
 	return 0;
 }
@@ -112,34 +162,44 @@ static void uart_action_handler(void* param)
 		if(u->fd == -1)
 			goto Exit;
 		if(u->rx_start){
-			/* Blocked here to wait uart rx data completed */
+			/* Blocked here until a batch of rx data is ready */
 			uart_wait_rx_complete(u);
 
+			/* bytes arriving from now on start a new batch */
+			u->rx_start = 0;
+			u->rx_notified = u->prxwrite;
+			u->rx_wakeups++;
+
 			/* As we did not register netconn callback function.,so call lwip_selectevindicate unblocking select */
 			lwip_setsockrcvevent(u->fd, 1);
 			lwip_selectevindicate(u->fd);	//unblocking select()
-			u->rx_start = 0;
 		}
-		if(u->tx_start){
-			uart_print_data("TX:", u->send_buf, u->tx_bytes);
-			//if(serial_send_stream_dma(&u->sobj, (char*)u->send_buf, u->tx_bytes) == -1){
-			if(uart_send_stream(u, (char*)u->send_buf, u->tx_bytes) == -1){
-				uart_printf("uart send data error!");
-			} else {
-#if (UART_SOCKET_USE_DMA_TX == 0)
-				u->tx_start = 0;
-				memset(u->send_buf,0, UART_SEND_BUFFER_LEN);	//zero set uart_send_buf
-				RtlUpSema(&u->tx_sema);
-#endif				
-			}
+		while(u->tx_start){
+			u->tx_start = 0;
+			uart_tx_kick(u);
 		}
 	}
 Exit:	
 	vTaskDelete(NULL);
 }
 
+static u32 uart_ring_size(u32 size, u32 def)
+{
+	u32 ring = 64;
+
+	if(size == 0)
+		return def;
+	while(ring < size)
+		ring <<= 1;
+	return ring;
+}
 
 uart_socket_t* uart_open(uart_set_str *puartpara)
+{
+	return uart_open_ex(puartpara, NULL);
+}
+
+uart_socket_t* uart_open_ex(uart_set_str *puartpara, uart_buf_set_str *pbufpara)
 {
 	PinName uart_tx = PA_7;//PA_4; //PA_7
 	PinName uart_rx = PA_6;//PA_0; //PA_6
@@ -150,12 +210,31 @@ uart_socket_t* uart_open(uart_set_str *puartpara)
 		uart_printf("%s(): Alloc memory for uart_socket failed!\n", __func__);
 		return NULL;
 	}
+
+	u->rx_size = uart_ring_size(pbufpara ? pbufpara->rx_buf_len : 0, UART_RECV_BUFFER_LEN);
+	u->tx_size = uart_ring_size(pbufpara ? pbufpara->tx_buf_len : 0, UART_SEND_BUFFER_LEN);
+	u->rx_notify_bytes = (pbufpara && pbufpara->rx_notify_bytes) ? pbufpara->rx_notify_bytes : UART_RX_NOTIFY_BYTES;
+	u->rx_idle_time = (pbufpara && pbufpara->rx_idle_time) ? pbufpara->rx_idle_time : UART_MAX_DELAY_TIME;
+	if(u->rx_notify_bytes > u->rx_size)
+		u->rx_notify_bytes = u->rx_size;
+	u->recv_buf = (u8 *)RtlZmalloc(u->rx_size);
+	u->send_buf = (u8 *)RtlZmalloc(u->tx_size);
+	if(!u->recv_buf || !u->send_buf){
+		uart_printf("%s(): Alloc memory for uart ring failed!\n", __func__);
+		goto Exit3;
+	}
 	
 	/*initial uart */
 	serial_init(&u->sobj, uart_tx,uart_rx);
 	serial_baud(&u->sobj,puartpara->BaudRate);
 	serial_format(&u->sobj, puartpara->number, (SerialParity)puartpara->parity, puartpara->StopBits);
 
+	/*init uart related semaphore*/
+	RtlInitSema(&u->action_sema, 0);
+	RtlInitSema(&u->rx_sema, 0);
+	RtlInitSema(&u->tx_sema, 0);
+	RtlInitSema(&u->dma_tx_sema, 1);
+
 	/*uart irq handle*/
 	serial_irq_handler(&u->sobj, uart_irq, (int)u);
 	serial_irq_set(&u->sobj, RxIrq, 1);
@@ -171,10 +250,6 @@ uart_socket_t* uart_open(uart_set_str *puartpara)
 		uart_printf("Failed to alloc uart socket!\n");
 		goto Exit2;
 	}
-	/*init uart related semaphore*/
-	RtlInitSema(&u->action_sema, 0);
-	RtlInitSema(&u->tx_sema, 1);
-	RtlInitSema(&u->dma_tx_sema, 1);
 	
 	/*create uart_thread to handle send&recv data*/
 	{
@@ -187,11 +262,19 @@ uart_socket_t* uart_open(uart_set_str *puartpara)
 	}
 	return u;
 Exit1:
+	lwip_close(u->fd);
+Exit2:
+	serial_free(&u->sobj);
 	/* Free uart related semaphore */
 	RtlFreeSema(&u->action_sema);
+	RtlFreeSema(&u->rx_sema);
 	RtlFreeSema(&u->tx_sema);	
 	RtlFreeSema(&u->dma_tx_sema);		
-Exit2:
+Exit3:
+	if(u->recv_buf)
+		RtlMfree(u->recv_buf, u->rx_size);
+	if(u->send_buf)
+		RtlMfree(u->send_buf, u->tx_size);
 	RtlMfree((u8*)u, sizeof(uart_socket_t));
 	return NULL;
 }
@@ -208,17 +291,21 @@ int uart_close(uart_socket_t *u)
 	}
 	/* Delete uart_action task */
 	u->fd = -1;
+	RtlUpSema(&u->rx_sema);
 	RtlUpSema(&u->action_sema);
 	RtlMsleepOS(20);
 
+	/* Free serial */
+	serial_free(&u->sobj);
+
 	/* Free uart related semaphore */
 	RtlFreeSema(&u->action_sema);
+	RtlFreeSema(&u->rx_sema);
 	RtlFreeSema(&u->tx_sema);
 	RtlFreeSema(&u->dma_tx_sema);
 	
-	/* Free serial */
-	serial_free(&u->sobj);
-	
+	RtlMfree(u->recv_buf, u->rx_size);
+	RtlMfree(u->send_buf, u->tx_size);
 	RtlMfree((u8 *)u, sizeof(uart_socket_t));
 
 	return 0;
@@ -227,66 +314,75 @@ int uart_close(uart_socket_t *u)
 int uart_read(uart_socket_t *u, void *read_buf, size_t size)
 {
 	/*the same as socket*/
-	int read_bytes = 0;
-	int pread_local,pwrite_local;
+	u32 read_bytes, first;
+	u32 pread_local, offset;
 	char *ptr = (char *)read_buf;
 
-	uart_printf("==>uart_read()\n");
 	if(!size || !read_buf || !u){
 		uart_printf("uart_read(): input error,size should not be null\r\n");
 		return -1;
 	}
 	
 	pread_local = u->prxread;
-	pwrite_local = u->prxwrite;
 	/*calculate how much data not read */
-	if(!u->rxoverlap){
-		read_bytes = pwrite_local - pread_local;
-	} else {
-		read_bytes = (UART_RECV_BUFFER_LEN - pread_local) + pwrite_local;
-	}
+	read_bytes = u->prxwrite - pread_local;
 	/*decide how much data shoule copy to application*/
 	if(size < read_bytes)
 		read_bytes = size;
-	
-	if(!u->rxoverlap){
-		memcpy(ptr, (u->recv_buf+ pread_local), read_bytes );
-	} else {
-		uart_printf("uart recv buf is write through!!\n");
-		if((pread_local + read_bytes) > UART_RECV_BUFFER_LEN){
-			memcpy(ptr,(u->recv_buf+ pread_local), (UART_RECV_BUFFER_LEN-pread_local));
-			memcpy(ptr+(UART_RECV_BUFFER_LEN-pread_local), u->recv_buf, read_bytes-(UART_RECV_BUFFER_LEN- pread_local));
-		} else
-			memcpy(ptr,(u->recv_buf+ pread_local), read_bytes);
-	}
-	lwip_setsockrcvevent(u->fd, 0);
-	
-	if((pread_local + read_bytes) >= UART_RECV_BUFFER_LEN){		//update pread
-		u->prxread = (pread_local + read_bytes) - UART_RECV_BUFFER_LEN;
-		u->rxoverlap = 0;		//clean overlap flags
-	} else
-		u->prxread = pread_local + read_bytes;
+
+	offset = pread_local & (u->rx_size - 1);
+	first = u->rx_size - offset;
+	if(first > read_bytes)
+		first = read_bytes;
+	memcpy(ptr, u->recv_buf + offset, first);
+	memcpy(ptr + first, u->recv_buf, read_bytes - first);
+	u->prxread = pread_local + read_bytes;
+
+	/* keep select() readable while data is left in ring */
+	if(u->prxwrite == u->prxread)
+		lwip_setsockrcvevent(u->fd, 0);
 	
 	return read_bytes;
 
 }
 
-
+/* Queue data in tx ring and return, DMA drains it in background.
+ * Only blocks while the ring is full. */
 int uart_write(uart_socket_t *u, void *pbuf, size_t size)
 {
+	u8 *ptr = (u8 *)pbuf;
+	u32 space, offset, chunk, left = size;
+
 	if(!size || !pbuf || !u){
 		uart_printf("input error,please check!");
 		return -1;
 	}
-	if(RtlDownSema(&u->tx_sema)){
-		//uart_printf("[%d]:uart_write %d!\n", xTaskGetTickCount(), size);
-		memcpy(u->send_buf, pbuf, size);
-		u->tx_bytes = size;
+
+	while(left){
+		space = u->tx_size - (u->ptxwrite - u->ptxread);
+		if(space == 0){
+			if(RtlDownSema(&u->tx_sema) != pdTRUE){
+				uart_printf("uart write buf error!");
+				return size - left;
+			}
+			continue;
+		}
+		offset = u->ptxwrite & (u->tx_size - 1);
+		chunk = u->tx_size - offset;
+		if(chunk > space)
+			chunk = space;
+		if(chunk > left)
+			chunk = left;
+		memcpy(u->send_buf + offset, ptr, chunk);
+		u->ptxwrite += chunk;
+		ptr += chunk;
+		left -= chunk;
+		u->tx_total += chunk;
+
 		u->tx_start = 1;	//set uart tx start 
 		RtlUpSema(&u->action_sema);	// let uart_handle_run through
-	} else {
-		uart_printf("uart write buf error!");
-		return -1;
+		if(u->rx_start)
+			RtlUpSema(&u->rx_sema);	//or break its wait for an rx batch
 	}
 
 	return size;
@@ -304,6 +400,7 @@ void uart_socket_example(void *param)
 	int uart_fd;
 	uart_socket_t *uart_socket = NULL;
 
+	memset(&uartset, 0, sizeof(uartset));
 	uartset.BaudRate = 9600;
 	uartset.number = 8;
 	uartset.StopBits = 0;
@@ -5,9 +5,23 @@
 #include "serial_api.h"
 #include "serial_ex_api.h"
 
+/* default ring sizes, must be power of 2. The defaults keep the RAM of the former
+ * fixed buffers, boards streaming at high baud rates may raise them here or per
+ * socket through uart_open_ex() */
+#ifndef UART_SEND_BUFFER_LEN
 #define UART_SEND_BUFFER_LEN	256
+#endif
+#ifndef UART_RECV_BUFFER_LEN
 #define UART_RECV_BUFFER_LEN	1024
+#endif
+/* rx notification: select() is woken when UART_RX_NOTIFY_BYTES are pending
+ * or the line has been idle for UART_MAX_DELAY_TIME ticks, whichever first */
+#ifndef UART_RX_NOTIFY_BYTES
+#define UART_RX_NOTIFY_BYTES	256
+#endif
+#ifndef UART_MAX_DELAY_TIME
 #define UART_MAX_DELAY_TIME   20
+#endif
 
 typedef struct _uart_set_str 
 { 
@@ -19,30 +33,54 @@ typedef struct _uart_set_str
     char FlowControl;    //support flow control is 1 
 }uart_set_str;
 
+/* optional buffering parameters of uart_open_ex(), 0 selects the default */
+typedef struct _uart_buf_set_str
+{
+    u32 rx_buf_len;      //rx ring size, power of 2
+    u32 tx_buf_len;      //tx ring size, power of 2
+    u32 rx_notify_bytes; //pending bytes that wake select() at once
+    u32 rx_idle_time;    //idle ticks after which pending bytes are notified
+}uart_buf_set_str;
+
 typedef struct _uart_socket_t
 {
 	serial_t sobj;
 	int fd;
 
-	/* Used for UART RX */
+	/* Used for UART RX, indexes are free running and masked on access */
 	u32 rx_start;
-	//u32 rx_bytes;
-	u32 prxread;
-	u32 prxwrite;
-	u32 rxoverlap;
+	u32 rx_size;
+	volatile u32 prxread;		//only moved by uart_read
+	volatile u32 prxwrite;		//only moved by uart_irq
+	u32 rx_notified;		//prxwrite when select() was last woken
+	u32 rx_notify_bytes;
+	u32 rx_idle_time;
 	u32 last_update;  //tick count when rx byte
-	u8 recv_buf[UART_RECV_BUFFER_LEN];
+	u8 *recv_buf;
+	_Sema rx_sema;
 
+	/* Used for UART TX, ring drained by DMA in contiguous chunks */
 	u32 tx_start;
-	u32 tx_bytes;
-	u8 send_buf[UART_SEND_BUFFER_LEN];
-	_Sema tx_sema;
+	u32 tx_size;
+	volatile u32 ptxread;		//only moved when a transfer completes
+	volatile u32 ptxwrite;		//only moved by uart_write
+	volatile u32 tx_bytes;		//bytes of the transfer in flight
+	u8 *send_buf;
+	_Sema tx_sema;			//up when tx ring space is released
 	_Sema dma_tx_sema;	
 
 	_Sema action_sema;
+
+	/* statistics */
+	u32 rx_total;
+	u32 rx_overflow;		//bytes dropped because rx ring was full
+	u32 rx_wakeups;			//times select() was woken
+	u32 tx_total;
+	u32 tx_transfers;		//dma transfers started
 }uart_socket_t;
 
 uart_socket_t* uart_open(uart_set_str *puartpara);
+uart_socket_t* uart_open_ex(uart_set_str *puartpara, uart_buf_set_str *pbufpara);
 int uart_close(uart_socket_t *u);
 int uart_read(uart_socket_t *u, void *read_buf, size_t size);
 int uart_write(uart_socket_t *u, void *pbuf, size_t size);
@@ -48,6 +48,63 @@ int crypto_aead_chacha20poly1305_decrypt(unsigned char *m,
                                          unsigned long long adlen,
                                          const unsigned char *npub,
                                          const unsigned char *k);
+
+/*
+ * Incremental interface, same construction and output as the functions above:
+ *
+ *   crypto_aead_chacha20poly1305_init(&st, npub, k);
+ *   crypto_aead_chacha20poly1305_update_ad(&st, ad, adlen);       (0 or more)
+ *   crypto_aead_chacha20poly1305_encrypt_update(&st, c, m, mlen); (0 or more)
+ *   crypto_aead_chacha20poly1305_encrypt_final(&st, mac);
+ *
+ * gives c || mac == crypto_aead_chacha20poly1305_encrypt(m, ad), for any split
+ * of m and ad. All associated data has to come before the message, update_ad
+ * after a message update returns -1.
+ *
+ * decrypt_update hands out plaintext before the MAC is checked: nothing of it
+ * may be used before crypto_aead_chacha20poly1305_decrypt_final returned 0.
+ */
+
+typedef struct crypto_aead_chacha20poly1305_state {
+    unsigned char opaque[384];
+} crypto_aead_chacha20poly1305_state
+#if defined(__GNUC__)
+  __attribute__ ((aligned(16)))
+#endif
+  ;
+
+SODIUM_EXPORT
+size_t crypto_aead_chacha20poly1305_statebytes(void);
+
+SODIUM_EXPORT
+int crypto_aead_chacha20poly1305_init(crypto_aead_chacha20poly1305_state *state,
+                                      const unsigned char *npub,
+                                      const unsigned char *k);
+
+SODIUM_EXPORT
+int crypto_aead_chacha20poly1305_update_ad(crypto_aead_chacha20poly1305_state *state,
+                                           const unsigned char *ad,
+                                           unsigned long long adlen);
+
+SODIUM_EXPORT
+int crypto_aead_chacha20poly1305_encrypt_update(crypto_aead_chacha20poly1305_state *state,
+                                                unsigned char *c,
+                                                const unsigned char *m,
+                                                unsigned long long mlen);
+
+SODIUM_EXPORT
+int crypto_aead_chacha20poly1305_encrypt_final(crypto_aead_chacha20poly1305_state *state,
+                                               unsigned char *mac);
+
+SODIUM_EXPORT
+int crypto_aead_chacha20poly1305_decrypt_update(crypto_aead_chacha20poly1305_state *state,
+                                                unsigned char *m,
+                                                const unsigned char *c,
+                                                unsigned long long clen);
+
+SODIUM_EXPORT
+int crypto_aead_chacha20poly1305_decrypt_final(crypto_aead_chacha20poly1305_state *state,
+                                               const unsigned char *mac);
 #ifdef __cplusplus
 }
 #endif
@@ -75,6 +75,9 @@ typedef enum
     MICO_PARTITION_PARAMETER_2,
 #ifdef MICO_USE_BT_PARTITION
     MICO_PARTITION_BT_FIRMWARE,
+#endif
+#ifdef MICO_USE_SYSTEM_SNAPSHOT_PARTITION
+    MICO_PARTITION_SYSTEM_SNAPSHOT,
 #endif
     MICO_PARTITION_MAX,
     MICO_PARTITION_NONE,